@@ -0,0 +1,206 @@
+# Performance conformance of a driver: the same workloads, bulk ingest,
+# binding a stream of batches, a wide scan and get_objects/3, run against
+# any of the drivers this library downloads, so that two builds of a driver
+# can be compared when upgrading it.
+#
+#     export ADBC_BENCH_DRIVER=duckdb
+#     mix run bench/conformance.exs > baseline.jsonl
+#     ADBC_BENCH_BASELINE=baseline.jsonl mix run bench/conformance.exs
+#
+# `ADBC_BENCH_DRIVER` defaults to `sqlite`, and `ADBC_BENCH_URI` gives the
+# URI of the database when the driver needs one. What differs from a driver
+# to another, as the quirks of the validation suite of ADBC, is in
+# `quirks/1`.
+#
+# Every workload prints a line of JSON with the driver, its name, the rows
+# it handles per run, its median rows per second and the peak resident
+# memory of the VM while running it, in bytes, on Linux, where the peak is
+# reset before each workload, or the memory of the VM after it elsewhere.
+# With `ADBC_BENCH_BASELINE`, a file of such lines, the workloads whose
+# rows per second fell by more than `ADBC_BENCH_TOLERANCE`, defaulting to
+# `0.1`, or whose peak memory rose by more than it, are reported and the
+# script exits with status 1.
+defmodule Adbc.Bench.Conformance do
+  @runs 5
+  @rows 100_000
+  @batches 10
+  @wide_columns 32
+  @wide_rows 20_000
+
+  def run do
+    driver = String.to_atom(System.get_env("ADBC_BENCH_DRIVER", "sqlite"))
+    quirks = quirks(driver)
+    Adbc.download_driver!(driver)
+
+    options =
+      case System.fetch_env("ADBC_BENCH_URI") do
+        {:ok, uri} -> [driver: driver, uri: uri]
+        :error -> [driver: driver] ++ quirks.options
+      end
+
+    {:ok, db} = Adbc.Database.start_link(options)
+    {:ok, conn} = Adbc.Connection.start_link(database: db)
+
+    results = [
+      bulk_ingest(driver, conn),
+      bind_stream(driver, conn),
+      wide_scan(driver, conn),
+      get_objects(driver, conn)
+    ]
+
+    GenServer.stop(conn)
+    GenServer.stop(db)
+
+    case System.fetch_env("ADBC_BENCH_BASELINE") do
+      {:ok, path} -> compare(results, path)
+      :error -> :ok
+    end
+  end
+
+  defp quirks(:sqlite), do: %{options: [uri: ":memory:"], objects_depth: 0}
+  defp quirks(:duckdb), do: %{options: [], objects_depth: 0}
+  defp quirks(:postgresql), do: %{options: [], objects_depth: 3}
+  defp quirks(:flightsql), do: %{options: [], objects_depth: 3}
+
+  defp quirks(driver) do
+    raise ArgumentError, "no quirks for driver #{inspect(driver)}"
+  end
+
+  defp bulk_ingest(driver, conn) do
+    batch = batch(1, @rows)
+
+    measure(driver, "bulk_ingest", @rows, fn ->
+      {:ok, _} = Adbc.Connection.ingest(conn, "adbc_bench_ingest", [batch], mode: :replace)
+    end)
+  end
+
+  # the batches are converted while the driver reads the previous ones
+  # through the stream bound to its statement
+  defp bind_stream(driver, conn) do
+    size = div(@rows, @batches)
+
+    measure(driver, "bind_stream", @rows, fn ->
+      batches = Stream.map(0..(@batches - 1), &batch(&1 * size + 1, size))
+      {:ok, _} = Adbc.Connection.ingest(conn, "adbc_bench_ingest", batches, mode: :replace)
+    end)
+  end
+
+  defp wide_scan(driver, conn) do
+    columns =
+      for i <- 1..@wide_columns do
+        name = "c#{i}"
+
+        case rem(i, 3) do
+          0 -> Adbc.Column.i64(Enum.to_list(1..@wide_rows), name: name)
+          1 -> Adbc.Column.f64(Enum.map(1..@wide_rows, &(&1 / 3)), name: name)
+          2 -> Adbc.Column.string(Enum.map(1..@wide_rows, &"row #{&1}"), name: name)
+        end
+      end
+
+    {:ok, _} = Adbc.Connection.ingest(conn, "adbc_bench_wide", [columns], mode: :replace)
+
+    measure(driver, "wide_scan", @wide_rows, fn ->
+      {:ok, _} = Adbc.Connection.query(conn, "SELECT * FROM adbc_bench_wide")
+    end)
+  end
+
+  # servers whose catalogs are large only list their tables
+  defp get_objects(driver, conn) do
+    %{objects_depth: depth} = quirks(driver)
+
+    measure(driver, "get_objects", 1, fn ->
+      {:ok, _} = Adbc.Connection.get_objects(conn, depth)
+    end)
+  end
+
+  defp batch(first, size) do
+    ids = Enum.to_list(first..(first + size - 1))
+
+    [
+      Adbc.Column.i64(ids, name: "id"),
+      Adbc.Column.f64(Enum.map(ids, &(&1 / 3)), name: "value"),
+      Adbc.Column.string(Enum.map(ids, &"row #{&1}"), name: "name")
+    ]
+  end
+
+  defp measure(driver, name, rows, fun) do
+    reset_peak_memory()
+    times = for _ <- 1..@runs, do: elem(:timer.tc(fun), 0)
+    peak = peak_memory()
+    time = Enum.at(Enum.sort(times), div(@runs, 2))
+    rows_per_second = if time > 0, do: round(rows * 1_000_000 / time), else: 0
+
+    IO.puts(
+      ~s({"driver":"#{driver}","name":"#{name}","rows":#{rows},"runs":#{@runs},) <>
+        ~s("rows_per_second":#{rows_per_second},"peak_memory_bytes":#{peak}})
+    )
+
+    %{driver: "#{driver}", name: name, rows_per_second: rows_per_second, peak: peak}
+  end
+
+  # the peak resident memory of the VM is only reset by Linux, which
+  # resets it when "5" is written to clear_refs
+  defp reset_peak_memory do
+    File.write("/proc/self/clear_refs", "5")
+  end
+
+  defp peak_memory do
+    with {:ok, status} <- File.read("/proc/self/status"),
+         [_, kilobytes] <- Regex.run(~r/^VmHWM:\s+(\d+) kB$/m, status) do
+      String.to_integer(kilobytes) * 1024
+    else
+      _ -> :erlang.memory(:total)
+    end
+  end
+
+  defp compare(results, path) do
+    tolerance = String.to_float(System.get_env("ADBC_BENCH_TOLERANCE", "0.1"))
+
+    baseline =
+      path
+      |> File.stream!()
+      |> Enum.map(&fields/1)
+      |> Map.new(&{{&1["driver"], &1["name"]}, &1})
+
+    regressions =
+      Enum.flat_map(results, fn %{driver: driver, name: name} = result ->
+        with %{} = base <- baseline[{driver, name}],
+             message when is_binary(message) <- regression(result, base, tolerance) do
+          ["#{driver} #{name}: #{message}"]
+        else
+          _ -> []
+        end
+      end)
+
+    if regressions != [] do
+      Enum.each(regressions, &IO.puts(:stderr, &1))
+      System.halt(1)
+    end
+  end
+
+  defp regression(result, base, tolerance) do
+    base_rate = String.to_integer(base["rows_per_second"])
+    base_peak = String.to_integer(base["peak_memory_bytes"])
+
+    cond do
+      result.rows_per_second < base_rate * (1 - tolerance) ->
+        "#{result.rows_per_second} rows/s, baseline #{base_rate} rows/s"
+
+      result.peak > base_peak * (1 + tolerance) ->
+        "peak memory of #{result.peak} bytes, baseline #{base_peak} bytes"
+
+      true ->
+        nil
+    end
+  end
+
+  # the lines printed by `measure/4` are flat objects of strings and
+  # integers, which do not need a JSON parser
+  defp fields(line) do
+    for [_, key, value] <- Regex.scan(~r/"(\w+)":"?([^",}]*)"?/, line), into: %{} do
+      {key, value}
+    end
+  end
+end
+
+Adbc.Bench.Conformance.run()
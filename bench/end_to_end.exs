@@ -0,0 +1,173 @@
+# End-to-end benchmarks of the public API against SQLite, DuckDB and,
+# when ADBC_POSTGRESQL_URI is set, PostgreSQL: queries, prepared queries,
+# bound inserts, ingest, get_objects/3 and query_pointer/5.
+#
+#     mix run bench/end_to_end.exs
+#     ADBC_POSTGRESQL_URI=postgresql://postgres@localhost mix run bench/end_to_end.exs
+#
+# Every benchmark prints a line of JSON with the driver, its name, the
+# rows it handles per run, and the medians of its run times in
+# microseconds, of the reductions and of the memory in bytes allocated by
+# the process running it, so results of two releases can be compared with
+# standard tools. Each run happens in a new process, so the reductions and
+# memory are those of the caller only, not of the connection process.
+defmodule Adbc.Bench.EndToEnd do
+  @runs 5
+  @rows 100_000
+  @bound_rows 2_000
+
+  def run do
+    bench(:sqlite, [driver: :sqlite, uri: ":memory:"], "?")
+    bench(:duckdb, [driver: :duckdb], "?")
+
+    case System.fetch_env("ADBC_POSTGRESQL_URI") do
+      {:ok, uri} -> bench(:postgresql, [driver: :postgresql, uri: uri], "$")
+      :error -> IO.puts(:stderr, "set ADBC_POSTGRESQL_URI to also benchmark PostgreSQL")
+    end
+  end
+
+  defp bench(driver, options, placeholder) do
+    Adbc.download_driver!(driver)
+    {:ok, db} = Adbc.Database.start_link(options)
+    {:ok, conn} = Adbc.Connection.start_link(database: db)
+
+    query(driver, conn, placeholder)
+    bind(driver, conn, placeholder)
+    ingest(driver, conn)
+    get_objects(driver, conn)
+
+    GenServer.stop(conn)
+    GenServer.stop(db)
+  end
+
+  defp query(driver, conn, placeholder) do
+    select = "SELECT x AS id, x * 0.5 AS value, 'row ' || x AS name FROM series"
+    series = "WITH RECURSIVE series(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM series"
+    query = "#{series} WHERE x < #{@rows}) #{select}"
+
+    measure(driver, "query", @rows, fn ->
+      {:ok, _} = Adbc.Connection.query(conn, query)
+    end)
+
+    measure(driver, "query_pointer", @rows, fn ->
+      {:ok, _} = Adbc.Connection.query_pointer(conn, query, fn _pointer, _rows -> :ok end)
+    end)
+
+    bounded = "#{series} WHERE x < #{param(placeholder, 1)}) #{select}"
+    {:ok, prepared} = Adbc.Connection.prepare(conn, bounded)
+
+    measure(driver, "query_prepared", @rows, fn ->
+      {:ok, _} = Adbc.Connection.query(conn, prepared, [@rows])
+    end)
+  end
+
+  defp bind(driver, conn, placeholder) do
+    Adbc.Connection.query!(conn, "CREATE TABLE adbc_bench_bind (id bigint, name text)")
+    rows = Enum.map(1..@bound_rows, &[&1, "row #{&1}"])
+    values = "#{param(placeholder, 1)}, #{param(placeholder, 2)}"
+    insert = "INSERT INTO adbc_bench_bind VALUES (#{values})"
+
+    measure(driver, "bind_execute_many", @bound_rows, fn ->
+      {:ok, _} = Adbc.Connection.execute_many(conn, insert, rows)
+    end)
+
+    measure(driver, "bind_query", @bound_rows, fn ->
+      {:ok, _} = Adbc.Connection.query(conn, insert, rows)
+    end)
+
+    Adbc.Connection.query!(conn, "DROP TABLE adbc_bench_bind")
+  end
+
+  defp ingest(driver, conn) do
+    batch = [
+      Adbc.Column.i64(Enum.to_list(1..@rows), name: "id"),
+      Adbc.Column.f64(Enum.map(1..@rows, &(&1 / 3)), name: "value"),
+      Adbc.Column.string(Enum.map(1..@rows, &"row #{&1}"), name: "name")
+    ]
+
+    measure(driver, "ingest", @rows, fn ->
+      {:ok, _} = Adbc.Connection.ingest(conn, "adbc_bench_ingest", [batch], mode: :replace)
+    end)
+
+    Adbc.Connection.query!(conn, "DROP TABLE adbc_bench_ingest")
+  end
+
+  defp get_objects(driver, conn) do
+    measure(driver, "get_objects", 1, fn ->
+      {:ok, _} = Adbc.Connection.get_objects(conn, 0)
+    end)
+  end
+
+  defp param("?", _index), do: "?"
+  defp param("$", index), do: "$#{index}"
+
+  defp measure(driver, name, rows, fun) do
+    runs = for _ <- 1..@runs, do: run_once(fun)
+    time = median(for {time, _, _} <- runs, do: time)
+    reductions = median(for {_, reductions, _} <- runs, do: reductions)
+    memory = median(for {_, _, memory} <- runs, do: memory)
+
+    IO.puts(
+      ~s({"driver":"#{driver}","name":"#{name}","rows":#{rows},"runs":#{@runs},) <>
+        ~s("median_us":#{time},"median_reductions":#{reductions},) <>
+        ~s("median_memory_bytes":#{memory}})
+    )
+  end
+
+  # Runs `fun` in a new process, so that its reductions and the memory it
+  # allocates, counted by tracing its garbage collections, are its own.
+  defp run_once(fun) do
+    parent = self()
+
+    {pid, monitor} =
+      spawn_monitor(fn ->
+        receive do
+          :go -> :ok
+        end
+
+        {:reductions, reductions_before} = Process.info(self(), :reductions)
+        {time, _} = :timer.tc(fun)
+        {:reductions, reductions_after} = Process.info(self(), :reductions)
+        {:memory, memory} = Process.info(self(), :memory)
+        send(parent, {self(), {time, reductions_after - reductions_before, memory}})
+      end)
+
+    :erlang.trace(pid, true, [:garbage_collection, tracer: self()])
+    send(pid, :go)
+    collect(pid, monitor, 0)
+  end
+
+  defp collect(pid, monitor, collected) do
+    receive do
+      {:trace, ^pid, :gc_minor_start, info} -> collect(pid, monitor, collected - heap(info))
+      {:trace, ^pid, :gc_major_start, info} -> collect(pid, monitor, collected - heap(info))
+      {:trace, ^pid, :gc_minor_end, info} -> collect(pid, monitor, collected + heap(info))
+      {:trace, ^pid, :gc_major_end, info} -> collect(pid, monitor, collected + heap(info))
+      {^pid, result} -> finish(pid, monitor, result, collected)
+    end
+  end
+
+  defp finish(pid, monitor, {time, reductions, memory}, collected) do
+    receive do
+      {:DOWN, ^monitor, :process, ^pid, _} -> flush_traces(pid)
+    end
+
+    # what the garbage collections freed, plus what the process still holds
+    word_size = :erlang.system_info(:wordsize)
+    {time, reductions, max(0, -collected) * word_size + memory}
+  end
+
+  defp flush_traces(pid) do
+    receive do
+      {:trace, ^pid, _, _} -> flush_traces(pid)
+    after
+      0 -> :ok
+    end
+  end
+
+  defp heap(info), do: Keyword.fetch!(info, :heap_size) + Keyword.fetch!(info, :old_heap_size)
+
+  defp median(values), do: values |> Enum.sort() |> Enum.at(div(length(values), 2))
+end
+
+Adbc.Bench.EndToEnd.run()
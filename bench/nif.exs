@@ -0,0 +1,62 @@
+# Micro-benchmarks of the conversions of the NIF between Arrow arrays and
+# terms, over synthetic batches built natively for each column type,
+# batch size and density of nulls. Build the benchmark NIF first:
+#
+#     make bench_nif
+#     mix run bench/nif.exs
+#
+# Every benchmark prints a line of JSON with its name, the rows and the
+# bytes of the Arrow buffers of its batch, and the rows and bytes
+# converted per second, so results of two releases can be compared with
+# standard tools.
+defmodule Adbc.NifBench do
+  @on_load :load_nif
+
+  def load_nif do
+    path = :filename.join(:code.priv_dir(:adbc), ~c"adbc_nif_bench")
+    :erlang.load_nif(path, 0)
+  end
+
+  def arrow_to_term(_kind, _rows, _null_density, _iterations),
+    do: :erlang.nif_error(:not_loaded)
+
+  def term_to_arrow(_kind, _rows, _null_density, _iterations),
+    do: :erlang.nif_error(:not_loaded)
+end
+
+defmodule Adbc.Bench.Nif do
+  @kinds [:i64, :f64, :string, :timestamp, :list, :struct, :map, :dense_union]
+  @rows [1_024, 65_536]
+  @null_densities [0.0, 0.5]
+  @converted_rows 1_000_000
+
+  def run do
+    for kind <- @kinds, rows <- @rows, null_density <- @null_densities do
+      iterations = max(div(@converted_rows, rows), 1)
+      args = [kind, rows, null_density, iterations]
+      name = "#{kind}_#{rows}_nulls_#{trunc(null_density * 100)}"
+
+      for conversion <- [:arrow_to_term, :term_to_arrow] do
+        result = apply(Adbc.NifBench, conversion, args)
+        report("#{conversion}_#{name}", rows, iterations, result)
+      end
+    end
+  end
+
+  defp report(name, rows, iterations, {:ok, nanoseconds, bytes}) do
+    seconds = max(nanoseconds, 1) / 1_000_000_000
+    rows_per_second = round(rows * iterations / seconds)
+    bytes_per_second = round(bytes * iterations / seconds)
+
+    IO.puts(
+      ~s({"name":"#{name}","rows":#{rows},"bytes":#{bytes},) <>
+        ~s("rows_per_s":#{rows_per_second},"bytes_per_s":#{bytes_per_second}})
+    )
+  end
+
+  defp report(name, _rows, _iterations, {:error, reason}) do
+    IO.puts(:stderr, "#{name} failed: #{inspect(reason)}")
+  end
+end
+
+Adbc.Bench.Nif.run()
@@ -0,0 +1,111 @@
+# Benchmarks of the PostgreSQL paths of this library: ingest of each
+# column type, bound inserts, decoding of numeric, timestamp and text
+# results, and get_objects/3 on a catalog of many tables.
+#
+#     ADBC_POSTGRESQL_URI=postgresql://postgres@localhost mix run bench/postgresql.exs
+#
+# Every benchmark prints a line of JSON with its name, the rows it handles
+# per run and the median of its run times in microseconds, so results of
+# two releases can be compared with standard tools.
+defmodule Adbc.Bench.PostgreSQL do
+  @runs 5
+  @rows 100_000
+  @bound_rows 2_000
+  @tables 2_000
+
+  def run(uri) do
+    Adbc.download_driver!(:postgresql)
+    {:ok, db} = Adbc.Database.start_link(driver: :postgresql, uri: uri)
+    {:ok, conn} = Adbc.Connection.start_link(database: db)
+
+    ingest(conn)
+    bind(conn)
+    decode(conn)
+    get_objects(conn)
+  end
+
+  defp ingest(conn) do
+    columns = [
+      i64: Adbc.Column.i64(Enum.to_list(1..@rows), name: "value"),
+      f64: Adbc.Column.f64(Enum.map(1..@rows, &(&1 / 3)), name: "value"),
+      boolean: Adbc.Column.boolean(Enum.map(1..@rows, &(rem(&1, 2) == 0)), name: "value"),
+      string: Adbc.Column.string(Enum.map(1..@rows, &"row #{&1}"), name: "value")
+    ]
+
+    for {type, column} <- columns do
+      measure("ingest_#{type}", @rows, fn ->
+        {:ok, _} = Adbc.Connection.ingest(conn, "adbc_bench_ingest", [[column]], mode: :replace)
+      end)
+    end
+
+    Adbc.Connection.query!(conn, "DROP TABLE adbc_bench_ingest")
+  end
+
+  defp bind(conn) do
+    Adbc.Connection.query!(conn, "CREATE TEMPORARY TABLE adbc_bench_bind (id bigint, name text)")
+    rows = Enum.map(1..@bound_rows, &[&1, "row #{&1}"])
+    insert = "INSERT INTO adbc_bench_bind VALUES ($1, $2)"
+
+    measure("bind_execute_many", @bound_rows, fn ->
+      {:ok, _} = Adbc.Connection.execute_many(conn, insert, rows)
+    end)
+
+    batch = [
+      Adbc.Column.i64(Enum.to_list(1..@bound_rows), name: "id"),
+      Adbc.Column.string(Enum.map(1..@bound_rows, &"row #{&1}"), name: "name")
+    ]
+
+    measure("bind_ingest", @bound_rows, fn ->
+      {:ok, _} = Adbc.Connection.ingest(conn, "adbc_bench_bind", [batch], mode: :append)
+    end)
+
+    Adbc.Connection.query!(conn, "DROP TABLE adbc_bench_bind")
+  end
+
+  defp decode(conn) do
+    queries = [
+      numeric: "SELECT (n * 1.25)::numeric(18, 2) AS value",
+      timestamp: "SELECT timestamp '2024-01-01' + n * interval '1 second' AS value",
+      text: "SELECT repeat('x', (n % 64)::int) AS value"
+    ]
+
+    for {type, select} <- queries do
+      query = "#{select} FROM generate_series(1, #{@rows}) AS n"
+
+      measure("decode_#{type}", @rows, fn ->
+        {:ok, _} = Adbc.Connection.query(conn, query)
+      end)
+    end
+
+    query = "SELECT (n * 1.25)::numeric(18, 2) AS value FROM generate_series(1, #{@rows}) AS n"
+
+    measure("decode_numeric_columns", @rows, fn ->
+      {:ok, _} = Adbc.Connection.query(conn, query, [], numeric_columns: true)
+    end)
+  end
+
+  defp get_objects(conn) do
+    Adbc.Connection.query!(conn, "CREATE SCHEMA adbc_bench_catalog")
+
+    for i <- 1..@tables do
+      Adbc.Connection.query!(conn, "CREATE TABLE adbc_bench_catalog.t#{i} (id bigint, name text)")
+    end
+
+    measure("get_objects_all", @tables, fn ->
+      {:ok, _} = Adbc.Connection.get_objects(conn, 0, db_schema: "adbc_bench_catalog")
+    end)
+
+    Adbc.Connection.query!(conn, "DROP SCHEMA adbc_bench_catalog CASCADE")
+  end
+
+  defp measure(name, rows, fun) do
+    times = for _ <- 1..@runs, do: fun |> :timer.tc() |> elem(0)
+    median = times |> Enum.sort() |> Enum.at(div(@runs, 2))
+    IO.puts(~s({"name":"#{name}","rows":#{rows},"runs":#{@runs},"median_us":#{median}}))
+  end
+end
+
+case System.fetch_env("ADBC_POSTGRESQL_URI") do
+  {:ok, uri} -> Adbc.Bench.PostgreSQL.run(uri)
+  :error -> IO.puts(:stderr, "set ADBC_POSTGRESQL_URI to the PostgreSQL database to benchmark")
+end
@@ -0,0 +1,106 @@
+#ifndef ADBC_ARENA_HPP
+#define ADBC_ARENA_HPP
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <erl_nif.h>
+
+/// A bump allocator for the scratch memory of a single NIF call.
+///
+/// Memory is carved out of chunks allocated with `enif_alloc`, never freed
+/// piecemeal, and released at once when the arena goes out of scope, so
+/// early returns need no cleanup. Nothing handed to a driver, which may
+/// keep it after the call returns, may be allocated here.
+class ScratchArena {
+public:
+  explicit ScratchArena(size_t chunk_size = 4096) : chunk_size_(chunk_size) {}
+
+  ScratchArena(const ScratchArena&) = delete;
+  ScratchArena& operator=(const ScratchArena&) = delete;
+
+  ~ScratchArena() {
+    while (chunk_ != nullptr) {
+      Chunk * previous = chunk_->previous;
+      enif_free(chunk_);
+      chunk_ = previous;
+    }
+  }
+
+  /// Returns `size` bytes aligned to `align`, or `nullptr` when out of
+  /// memory.
+  void * allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+    if (chunk_ != nullptr) {
+      uintptr_t base = reinterpret_cast<uintptr_t>(chunk_->data());
+      size_t start = ((base + chunk_->used + align - 1) & ~(uintptr_t)(align - 1)) - base;
+      if (start + size <= chunk_->capacity) {
+        chunk_->used = start + size;
+        return chunk_->data() + start;
+      }
+    }
+
+    size_t capacity = size + align > chunk_size_ ? size + align : chunk_size_;
+    auto chunk = (Chunk *)enif_alloc(sizeof(Chunk) + capacity);
+    if (chunk == nullptr) return nullptr;
+    chunk->previous = chunk_;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    chunk_ = chunk;
+    return allocate(size, align);
+  }
+
+  /// Copies `size` bytes of `data` as a null-terminated string.
+  char * copy_string(const void * data, size_t size) {
+    auto out = (char *)allocate(size + 1, 1);
+    if (out == nullptr) return nullptr;
+    memcpy(out, data, size);
+    out[size] = '\0';
+    return out;
+  }
+
+private:
+  struct Chunk {
+    Chunk * previous;
+    size_t capacity;
+    size_t used;
+
+    unsigned char * data() {
+      return reinterpret_cast<unsigned char *>(this + 1);
+    }
+  };
+
+  size_t chunk_size_;
+  Chunk * chunk_ = nullptr;
+};
+
+/// Allocator for standard containers whose memory comes from a
+/// `ScratchArena`, so that they can be grown without a free per growth.
+template <typename T>
+struct ScratchAllocator {
+  using value_type = T;
+
+  ScratchArena * arena;
+
+  explicit ScratchAllocator(ScratchArena &arena) : arena(&arena) {}
+
+  template <typename U>
+  ScratchAllocator(const ScratchAllocator<U> &other) : arena(other.arena) {}
+
+  T * allocate(size_t n) {
+    void * p = arena->allocate(n * sizeof(T), alignof(T));
+    if (p == nullptr) throw std::bad_alloc();
+    return static_cast<T *>(p);
+  }
+
+  void deallocate(T *, size_t) {}
+
+  template <typename U>
+  bool operator==(const ScratchAllocator<U> &other) const { return arena == other.arena; }
+
+  template <typename U>
+  bool operator!=(const ScratchAllocator<U> &other) const { return arena != other.arena; }
+};
+
+#endif  // ADBC_ARENA_HPP
@@ -3,13 +3,37 @@
 
 #include <stdio.h>
 #include <cstdbool>
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
 #include <vector>
 #include <adbc.h>
 #include <erl_nif.h>
+#include "adbc_bitmap.hpp"
+#include "adbc_datetime.hpp"
+#include "adbc_decimal.hpp"
+#include "adbc_string_intern.hpp"
+#include "adbc_timezone.hpp"
+#include "adbc_type_registry.hpp"
+
+// What is already known about a column when converting it.
+struct ArrowColumnContext {
+    // the name and metadata terms of its schema
+    ERL_NIF_TERM name;
+    ERL_NIF_TERM metadata;
+    // if set, a resource keeping the buffers of the column alive, string
+    // and binary values are then returned as sub-binaries of its buffers
+    // instead of being copied
+    void * buffer_owner;
+    // if set, the zone of a timestamp column with a time zone, whose values
+    // are then returned as `DateTime` instead of `NaiveDateTime`
+    const AdbcTimeZone * timezone = nullptr;
+};
 
 static int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, uint64_t level, std::vector<ERL_NIF_TERM> &out_terms, ERL_NIF_TERM &value_type, ERL_NIF_TERM &metadata, ERL_NIF_TERM &error, bool *end_of_series = nullptr);
-static int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, int64_t offset, int64_t count, int64_t level, std::vector<ERL_NIF_TERM> &out_terms, ERL_NIF_TERM &value_type, ERL_NIF_TERM &metadata, ERL_NIF_TERM &error, bool *end_of_series = nullptr);
+static int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, int64_t offset, int64_t count, int64_t level, std::vector<ERL_NIF_TERM> &out_terms, ERL_NIF_TERM &value_type, ERL_NIF_TERM &metadata, ERL_NIF_TERM &error, bool *end_of_series = nullptr, const ArrowColumnContext * context = nullptr);
 static int get_arrow_array_children_as_list(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, uint64_t level, std::vector<ERL_NIF_TERM> &children, ERL_NIF_TERM &error);
 static int get_arrow_array_children_as_list(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, int64_t offset, int64_t count, uint64_t level, std::vector<ERL_NIF_TERM> &children, ERL_NIF_TERM &error);
 static ERL_NIF_TERM get_arrow_array_map_children(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, uint64_t level);
@@ -21,25 +45,60 @@ static ERL_NIF_TERM get_arrow_array_dense_union_children(ErlNifEnv *env, struct
 static ERL_NIF_TERM get_arrow_array_sparse_union_children(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, uint64_t level);
 static ERL_NIF_TERM get_arrow_array_sparse_union_children(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, int64_t offset, int64_t count, uint64_t level);
 
+// The validity bitmap of `values`, or nullptr when it has no nulls, so
+// that decoders skip the validity checks of columns without nulls.
+static const uint8_t * arrow_array_validity(const struct ArrowArray * values) {
+    return values->null_count == 0 ? nullptr : (const uint8_t *)values->buffers[0];
+}
+
+// Leaf decoders build their lists in place, from the last cell to the
+// first, rather than filling an array of terms first and copying it into
+// a list.
 template <typename T, typename M> static ERL_NIF_TERM values_from_buffer(ErlNifEnv *env, int64_t offset, int64_t count, const uint8_t * validity_bitmap, const T * value_buffer, const M& value_to_nif) {
-    std::vector<ERL_NIF_TERM> values(count);
+    ERL_NIF_TERM list = enif_make_list(env, 0);
     if (validity_bitmap == nullptr) {
-        for (int64_t i = offset; i < offset + count; i++) {
-            values[i - offset] = value_to_nif(env, value_buffer[i]);
+        for (int64_t i = offset + count - 1; i >= offset; i--) {
+            list = enif_make_list_cell(env, value_to_nif(env, value_buffer[i]), list);
         }
     } else {
-        for (int64_t i = offset; i < offset + count; i++) {
-            uint8_t vbyte = validity_bitmap[i/8];
-            if (vbyte & (1 << (i % 8))) {
-                values[i - offset] = value_to_nif(env, value_buffer[i]);
+        arrow_bitmap_visit_backwards(validity_bitmap, offset, count, [&](int64_t i, bool valid) {
+            list = enif_make_list_cell(env, valid ? value_to_nif(env, value_buffer[offset + i]) : kAtomNil, list);
+        });
+    }
+    return list;
+}
+
+// Booleans are bit-packed, as validity bitmaps are.
+static ERL_NIF_TERM booleans_from_buffer(ErlNifEnv *env, int64_t offset, int64_t count, const uint8_t * validity_bitmap, const uint8_t * value_bitmap) {
+    ERL_NIF_TERM list = enif_make_list(env, 0);
+    arrow_bitmap_visit_backwards(value_bitmap, offset, count, [&](int64_t i, bool value) {
+        ERL_NIF_TERM term = value ? kAtomTrue : kAtomFalse;
+        if (validity_bitmap != nullptr && !arrow_bitmap_get(validity_bitmap, offset + i)) {
+            term = kAtomNil;
+        }
+        list = enif_make_list_cell(env, term, list);
+    });
+    return list;
+}
+
+// The decoder of a primitive type of `AdbcPrimitiveTypes`, see
+// `kPrimitiveDecoders`.
+template <typename Primitive> struct PrimitiveDecoder {
+    static ERL_NIF_TERM call(ErlNifEnv *env, int64_t offset, int64_t count, const uint8_t * validity_bitmap, const void * value_buffer) {
+        using value_type = typename Primitive::value_type;
+        return values_from_buffer(env, offset, count, validity_bitmap, (const value_type *)value_buffer, [](ErlNifEnv *env, value_type val) -> ERL_NIF_TERM {
+            if constexpr (std::is_floating_point<value_type>::value) {
+                return enif_make_double(env, val);
+            } else if constexpr (std::is_signed<value_type>::value) {
+                return enif_make_int64(env, val);
             } else {
-                values[i - offset] = kAtomNil;
+                return enif_make_uint64(env, val);
             }
-        }
+        });
     }
+};
 
-    return enif_make_list_from_array(env, values.data(), (unsigned)values.size());
-}
+static constexpr auto kPrimitiveDecoders = adbc_primitive_table<PrimitiveDecoder>();
 
 template <typename T, typename M> static ERL_NIF_TERM values_from_buffer(ErlNifEnv *env, int64_t length, const uint8_t * validity_bitmap, const T * value_buffer, const M& value_to_nif) {
     return values_from_buffer(env, 0, length, validity_bitmap, value_buffer, value_to_nif);
@@ -53,34 +112,21 @@ template <typename M, typename OffsetT> static ERL_NIF_TERM strings_from_buffer(
     const OffsetT * offsets_buffer,
     const uint8_t* value_buffer,
     const M& value_to_nif) {
-    OffsetT offset = offsets_buffer[element_offset];
-    std::vector<ERL_NIF_TERM> values(element_count);
+    ERL_NIF_TERM list = enif_make_list(env, 0);
+    auto value_at = [&](int64_t i, bool valid) {
+        OffsetT offset = offsets_buffer[element_offset + i];
+        size_t nbytes = offsets_buffer[element_offset + i + 1] - offset;
+        ERL_NIF_TERM term = nbytes > 0 && valid ? value_to_nif(env, value_buffer, offset, nbytes) : kAtomNil;
+        list = enif_make_list_cell(env, term, list);
+    };
     if (validity_bitmap == nullptr) {
-        for (int64_t i = element_offset; i < element_offset + element_count; i++) {
-            OffsetT end_index = offsets_buffer[i + 1];
-            size_t nbytes = end_index - offset;
-            if (nbytes == 0) {
-                values[i - element_offset] = kAtomNil;
-            } else {
-                values[i - element_offset] = value_to_nif(env, value_buffer, offset, nbytes);
-            }
-            offset = end_index;
+        for (int64_t i = element_count - 1; i >= 0; i--) {
+            value_at(i, true);
         }
     } else {
-        for (int64_t i = element_offset; i < element_offset + element_count; i++) {
-            uint8_t vbyte = validity_bitmap[i / 8];
-            OffsetT end_index = offsets_buffer[i + 1];
-            size_t nbytes = end_index - offset;
-            if (nbytes > 0 && vbyte & (1 << (i % 8))) {
-                values[i - element_offset] = value_to_nif(env, value_buffer, offset, nbytes);
-            } else {
-                values[i - element_offset] = kAtomNil;
-            }
-            offset = end_index;
-        }
+        arrow_bitmap_visit_backwards(validity_bitmap, element_offset, element_count, value_at);
     }
-
-    return enif_make_list_from_array(env, values.data(), (unsigned)values.size());
+    return list;
 }
 
 template <typename M, typename OffsetT> static ERL_NIF_TERM strings_from_buffer(
@@ -93,6 +139,661 @@ template <typename M, typename OffsetT> static ERL_NIF_TERM strings_from_buffer(
     return strings_from_buffer(env, 0, length, validity_bitmap, offsets_buffer, value_buffer, value_to_nif);
 }
 
+// Converts the values of a string or binary array, either copying them or,
+// when `context` has a buffer owner, as sub-binaries of its data buffer.
+template <typename OffsetT> static ERL_NIF_TERM strings_to_nif_term(
+    ErlNifEnv *env,
+    struct ArrowArray * values,
+    int64_t offset,
+    int64_t count,
+    int64_t bitmap_buffer_index,
+    int64_t offset_buffer_index,
+    int64_t data_buffer_index,
+    const ArrowColumnContext * context) {
+    auto validity_bitmap = values->null_count == 0 ? nullptr : (const uint8_t *)values->buffers[bitmap_buffer_index];
+    auto offsets_buffer = (const OffsetT *)values->buffers[offset_buffer_index];
+    auto data_buffer = (const uint8_t *)values->buffers[data_buffer_index];
+
+    if (context && context->buffer_owner && values->length > 0) {
+        ERL_NIF_TERM data_binary = enif_make_resource_binary(env, context->buffer_owner, data_buffer, (size_t)offsets_buffer[values->length]);
+        return strings_from_buffer(
+            env,
+            offset,
+            count,
+            validity_bitmap,
+            offsets_buffer,
+            data_buffer,
+            [data_binary](ErlNifEnv *env, const uint8_t *, OffsetT offset, size_t nbytes) -> ERL_NIF_TERM {
+                return enif_make_sub_binary(env, data_binary, (size_t)offset, nbytes);
+            }
+        );
+    }
+
+    return strings_from_buffer(
+        env,
+        offset,
+        count,
+        validity_bitmap,
+        offsets_buffer,
+        data_buffer,
+        [](ErlNifEnv *env, const uint8_t * string_buffers, OffsetT offset, size_t nbytes) -> ERL_NIF_TERM {
+            return erlang::nif::make_binary(env, (const char *)(string_buffers + offset), nbytes);
+        }
+    );
+}
+
+static bool is_ascii(const uint8_t * bytes, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (bytes[i] >= 0x80) return false;
+    }
+    return true;
+}
+
+// Converts the values of a string or binary array as `strings_to_nif_term`
+// does, returning repeated values as the same term. With `atoms`, ASCII
+// values naming existing atoms are returned as those atoms instead.
+// `interned` is set to false once the array has too many distinct values,
+// its remaining values are then converted as usual.
+template <typename OffsetT> static ERL_NIF_TERM interned_strings_to_nif_term(ErlNifEnv *env, struct ArrowArray * values, bool atoms, const ArrowColumnContext * context, bool &interned) {
+    auto validity_bitmap = arrow_array_validity(values);
+    auto offsets_buffer = (const OffsetT *)values->buffers[1];
+    auto data_buffer = (const uint8_t *)values->buffers[2];
+    bool zero_copy = context && context->buffer_owner && values->length > 0;
+    ERL_NIF_TERM data_binary{};
+    if (zero_copy) {
+        data_binary = enif_make_resource_binary(env, context->buffer_owner, data_buffer, (size_t)offsets_buffer[values->length]);
+    }
+
+    AdbcStringInterner interner;
+    interned = true;
+    return strings_from_buffer(
+        env,
+        0,
+        values->length,
+        validity_bitmap,
+        offsets_buffer,
+        data_buffer,
+        [&](ErlNifEnv *env, const uint8_t * string_buffers, OffsetT offset, size_t nbytes) -> ERL_NIF_TERM {
+            const uint8_t * bytes = string_buffers + offset;
+            ERL_NIF_TERM term;
+            if (interned && interner.find(bytes, nbytes, term)) {
+                return term;
+            }
+            bool atom = atoms && nbytes <= 255 && is_ascii(bytes, nbytes) && enif_make_existing_atom_len(env, (const char *)bytes, nbytes, &term, ERL_NIF_LATIN1);
+            if (!atom) {
+                term = zero_copy ? enif_make_sub_binary(env, data_binary, (size_t)offset, nbytes) : erlang::nif::make_binary(env, (const char *)bytes, nbytes);
+            }
+            if (interned) {
+                interned = interner.add(bytes, nbytes, term);
+            }
+            return term;
+        }
+    );
+}
+
+// Converts the values of a string or binary view array, whose buffers are
+// the validity bitmap, the 16-byte views, the data buffers and the sizes of
+// the data buffers. Values of up to 12 bytes are inlined in their view and
+// always copied, longer ones are sub-binaries of their data buffer when
+// `context` has a buffer owner.
+static int string_views_to_nif_term(ErlNifEnv *env, struct ArrowArray * values, int64_t offset, int64_t count, const ArrowColumnContext * context, ERL_NIF_TERM &out, ERL_NIF_TERM &error) {
+    if (values->n_buffers < 3) {
+        error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=vu or format=vz), values->n_buffers < 3");
+        return 1;
+    }
+    auto validity_bitmap = (const uint8_t *)values->buffers[0];
+    auto views = (const uint8_t *)values->buffers[1];
+    int64_t n_data_buffers = values->n_buffers - 3;
+    auto data_buffer_sizes = (const int64_t *)values->buffers[values->n_buffers - 1];
+
+    bool zero_copy = context && context->buffer_owner;
+    std::vector<ERL_NIF_TERM> data_binaries((size_t)n_data_buffers);
+    std::vector<bool> made_binaries((size_t)n_data_buffers, false);
+    out = enif_make_list(env, 0);
+    for (int64_t i = count - 1; i >= 0; i--) {
+        int64_t row = values->offset + offset + i;
+        if (validity_bitmap != nullptr && !ArrowBitGet(validity_bitmap, row)) {
+            out = enif_make_list_cell(env, kAtomNil, out);
+            continue;
+        }
+
+        const uint8_t * view = views + row * 16;
+        int32_t length = 0;
+        memcpy(&length, view, sizeof(length));
+        if (length >= 0 && length <= 12) {
+            out = enif_make_list_cell(env, erlang::nif::make_binary(env, (const char *)(view + 4), (size_t)length), out);
+            continue;
+        }
+
+        int32_t buffer_index = 0, buffer_offset = 0;
+        memcpy(&buffer_index, view + 8, sizeof(buffer_index));
+        memcpy(&buffer_offset, view + 12, sizeof(buffer_offset));
+        if (length < 0 || buffer_index < 0 || buffer_index >= n_data_buffers || buffer_offset < 0 ||
+            (int64_t)buffer_offset + length > data_buffer_sizes[buffer_index]) {
+            error = erlang::nif::error(env, "invalid ArrowArray, view out of the range of its data buffer");
+            return 1;
+        }
+
+        auto data = (const uint8_t *)values->buffers[2 + buffer_index];
+        if (zero_copy) {
+            if (!made_binaries[buffer_index]) {
+                data_binaries[buffer_index] = enif_make_resource_binary(env, context->buffer_owner, data, (size_t)data_buffer_sizes[buffer_index]);
+                made_binaries[buffer_index] = true;
+            }
+            out = enif_make_list_cell(env, enif_make_sub_binary(env, data_binaries[buffer_index], (size_t)buffer_offset, (size_t)length), out);
+        } else {
+            out = enif_make_list_cell(env, erlang::nif::make_binary(env, (const char *)(data + buffer_offset), (size_t)length), out);
+        }
+    }
+    return 0;
+}
+
+template <typename T> static bool run_ends_from_buffer(const struct ArrowArray * run_ends, std::vector<int64_t> &out) {
+    auto buffer = (const T *)run_ends->buffers[1];
+    out.resize((size_t)run_ends->length);
+    for (int64_t i = 0; i < run_ends->length; i++) {
+        out[i] = (int64_t)buffer[run_ends->offset + i];
+        if (out[i] <= (i == 0 ? 0 : out[i - 1])) return false;
+    }
+    return true;
+}
+
+// Converts a run-end encoded array, whose children are the run ends and
+// the values of the runs, to the list of its values. The values of the
+// runs that are read are converted once and every row of a run shares the
+// term of its value.
+static int arrow_run_end_encoded_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, int64_t offset, int64_t count, int64_t level, ERL_NIF_TERM &out, ERL_NIF_TERM &term_type, ERL_NIF_TERM &error, const ArrowColumnContext * context) {
+    if (schema->n_children != 2 || values->n_children != 2) {
+        error = erlang::nif::error(env, "invalid ArrowArray (format=+r), run-end encoded arrays must have 2 children");
+        return 1;
+    }
+    struct ArrowArray * run_ends_values = values->children[0];
+    const char * run_ends_format = schema->children[0]->format ? schema->children[0]->format : "";
+    if (count == -1) count = values->length;
+    if (run_ends_values->n_buffers != 2) {
+        error = erlang::nif::error(env, "invalid n_buffers value for the run ends of ArrowArray (format=+r), values->n_buffers != 2");
+        return 1;
+    }
+
+    std::vector<int64_t> run_ends;
+    bool valid_run_ends = false;
+    switch (strlen(run_ends_format) == 1 ? run_ends_format[0] : '\0') {
+        case 's': valid_run_ends = run_ends_from_buffer<int16_t>(run_ends_values, run_ends); break;
+        case 'i': valid_run_ends = run_ends_from_buffer<int32_t>(run_ends_values, run_ends); break;
+        case 'l': valid_run_ends = run_ends_from_buffer<int64_t>(run_ends_values, run_ends); break;
+        default:
+            error = erlang::nif::error(env, "invalid run ends type of run-end encoded ArrowArray");
+            return 1;
+    }
+    int64_t start = values->offset + offset;
+    if (!valid_run_ends || (count > 0 && (run_ends.empty() || start + count > run_ends.back()))) {
+        error = erlang::nif::error(env, "invalid ArrowArray, invalid run ends of run-end encoded array");
+        return 1;
+    }
+
+    // only the runs of the rows read are converted
+    int64_t first_run = std::upper_bound(run_ends.begin(), run_ends.end(), start) - run_ends.begin();
+    int64_t last_run = count > 0 ? std::upper_bound(run_ends.begin(), run_ends.end(), start + count - 1) - run_ends.begin() : first_run - 1;
+    ArrowColumnContext values_context{kAtomNil, kAtomNil, context ? context->buffer_owner : nullptr};
+    std::vector<ERL_NIF_TERM> out_terms;
+    ERL_NIF_TERM values_metadata;
+    if (arrow_array_to_nif_term(env, schema->children[1], values->children[1], first_run, last_run - first_run + 1, level + 1, out_terms, term_type, values_metadata, error, nullptr, &values_context) == 1) {
+        return 1;
+    }
+    if (out_terms.size() != 2 || schema->children[1]->n_children != 0) {
+        error = erlang::nif::error(env, "run-end encoded arrays of nested types are not supported");
+        return 1;
+    }
+
+    std::vector<ERL_NIF_TERM> run_values;
+    ERL_NIF_TERM head, tail = out_terms[1];
+    while (enif_get_list_cell(env, tail, &head, &tail)) {
+        run_values.push_back(head);
+    }
+    if ((int64_t)run_values.size() != last_run - first_run + 1) {
+        error = erlang::nif::error(env, "invalid ArrowArray, run-end encoded array has fewer values than runs");
+        return 1;
+    }
+
+    out = enif_make_list(env, 0);
+    int64_t run = last_run;
+    for (int64_t i = count - 1; i >= 0; i--) {
+        while (run > first_run && run_ends[run - 1] > start + i) run--;
+        out = enif_make_list_cell(env, run_values[run - first_run], out);
+    }
+    return 0;
+}
+
+// Returns the metadata of `schema` as a map, or nil if it has none.
+static ERL_NIF_TERM arrow_schema_metadata_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema) {
+    ERL_NIF_TERM arrow_metadata = kAtomNil;
+    std::vector<ERL_NIF_TERM> metadata_keys, metadata_values;
+    if (schema->metadata) {
+        struct ArrowMetadataReader metadata_reader{};
+        struct ArrowStringView key;
+        struct ArrowStringView value;
+        if (ArrowMetadataReaderInit(&metadata_reader, schema->metadata) == NANOARROW_OK) {
+            while (ArrowMetadataReaderRead(&metadata_reader, &key, &value) == NANOARROW_OK) {
+                metadata_keys.push_back(erlang::nif::make_binary(env, key.data, (size_t)key.size_bytes));
+                metadata_values.push_back(erlang::nif::make_binary(env, value.data, (size_t)value.size_bytes));
+            }
+            if (metadata_keys.size() > 0) {
+                enif_make_map_from_arrays(env, metadata_keys.data(), metadata_values.data(), (unsigned)metadata_keys.size(), &arrow_metadata);
+            }
+        }
+    }
+    return arrow_metadata;
+}
+
+// Returns true if `offset` and `count` given to `arrow_array_to_nif_term`
+// refer to rows of `schema`, so its values can be converted in chunks.
+// For nested types they refer to children instead.
+// Dictionary-encoded arrays are converted whole, so their dictionary is
+// only converted once per batch.
+static bool arrow_array_is_row_sliceable(struct ArrowSchema * schema) {
+    const char* format = schema->format ? schema->format : "";
+    return schema->n_children == 0 && schema->dictionary == nullptr && format[0] != '+' && strncmp("w:", format, 2) != 0;
+}
+
+// Returns the byte width of the values of `schema` if it is a fixed-width
+// primitive type that can be returned as a raw buffer, setting `type` to
+// its column type. Returns 0 otherwise.
+static size_t arrow_schema_raw_width(ErlNifEnv *env, struct ArrowSchema * schema, ERL_NIF_TERM &type) {
+    const char* format = schema->format ? schema->format : "";
+    if (schema->n_children != 0 || schema->dictionary != nullptr) {
+        return 0;
+    }
+
+    if (int primitive = adbc_primitive_index_of_format(format); primitive >= 0) {
+        type = *kAdbcPrimitiveColumnTypes[primitive];
+        return kAdbcPrimitiveWidths[primitive];
+    }
+
+    if (strcmp(format, "tdD") == 0) {
+        type = kAdbcColumnTypeDate32;
+        return 4;
+    } else if (strcmp(format, "tdm") == 0) {
+        type = kAdbcColumnTypeDate64;
+        return 8;
+    } else if (strncmp(format, "ts", 2) == 0 && strlen(format) >= 4 && format[3] == ':') {
+        ERL_NIF_TERM unit;
+        switch (format[2]) {
+            case 's': unit = kAtomSeconds; break;
+            case 'm': unit = kAtomMilliseconds; break;
+            case 'u': unit = kAtomMicroseconds; break;
+            case 'n': unit = kAtomNanoseconds; break;
+            default: return 0;
+        }
+        ERL_NIF_TERM timezone = strlen(format) > 4 ? erlang::nif::make_binary(env, &format[4]) : kAtomNil;
+        type = enif_make_tuple3(env, kAtomTimestamp, unit, timezone);
+        return 8;
+    }
+    return 0;
+}
+
+// Returns the values of a fixed-width `values` array of `width` bytes as
+// `{:raw, values, validity}`, where `values` is a native-endian binary and
+// `validity` a bitmap of the valid values (least significant bit first, as
+// in Arrow), or nil when there are no nulls.
+static int arrow_array_to_raw_nif_term(ErlNifEnv *env, struct ArrowArray * values, size_t width, ERL_NIF_TERM &out, ERL_NIF_TERM &error) {
+    if (values->n_buffers != 2) {
+        error = erlang::nif::error(env, "invalid n_buffers value for a fixed-width ArrowArray, values->n_buffers != 2");
+        return 1;
+    }
+
+    size_t length = (size_t)values->length;
+    ERL_NIF_TERM data;
+    uint8_t * data_ptr = enif_make_new_binary(env, length * width, &data);
+    if (length > 0) {
+        auto buffer = (const uint8_t *)values->buffers[1];
+        if (buffer == nullptr) {
+            error = erlang::nif::error(env, "invalid ArrowArray, data buffer is NULL");
+            return 1;
+        }
+        memcpy(data_ptr, buffer + values->offset * width, length * width);
+    }
+
+    ERL_NIF_TERM validity = kAtomNil;
+    auto bitmap = (const uint8_t *)values->buffers[0];
+    if (bitmap != nullptr && values->null_count != 0) {
+        size_t bitmap_bytes = (length + 7) / 8;
+        uint8_t * validity_ptr = enif_make_new_binary(env, bitmap_bytes, &validity);
+        if (values->offset % 8 == 0) {
+            memcpy(validity_ptr, bitmap + values->offset / 8, bitmap_bytes);
+            // clear the bits past the end, which belong to other values
+            if (length % 8 != 0) {
+                validity_ptr[bitmap_bytes - 1] &= (uint8_t)((1 << (length % 8)) - 1);
+            }
+        } else {
+            memset(validity_ptr, 0, bitmap_bytes);
+            for (size_t i = 0; i < length; i++) {
+                if (ArrowBitGet(bitmap, values->offset + i)) {
+                    validity_ptr[i / 8] |= (uint8_t)(1 << (i % 8));
+                }
+            }
+        }
+    }
+
+    out = enif_make_tuple3(env, kAtomRaw, data, validity);
+    return 0;
+}
+
+// Returns the rows of `values`, a fixed-size list of `size` items of a
+// fixed-width type of `width` bytes, as a list with a binary of the items
+// of each row, or nil for null rows. The binaries are sub-binaries of a
+// single binary over the items, which references their buffer when
+// `buffer_owner` is set and is a copy of it otherwise.
+//
+// Returns 0 on success. On failure, returns 1 and `error` is set.
+static int arrow_fixed_size_list_to_binaries_nif_term(ErlNifEnv *env, struct ArrowArray * values, int64_t size, size_t width, void * buffer_owner, ERL_NIF_TERM &out, ERL_NIF_TERM &error) {
+    if (values->n_children != 1 || values->children[0]->n_buffers != 2) {
+        error = erlang::nif::error(env, "invalid ArrowArray for a fixed-size list of fixed-width values");
+        return 1;
+    }
+
+    struct ArrowArray * items = values->children[0];
+    int64_t first = items->offset + values->offset * size;
+    int64_t count = values->length * size;
+    if (values->offset * size + count > items->length) {
+        error = erlang::nif::error(env, "invalid ArrowArray, the fixed-size list has fewer items than its rows");
+        return 1;
+    }
+    auto item_validity = (const uint8_t *)items->buffers[0];
+    if (item_validity != nullptr && items->null_count != 0 && count > 0 &&
+        ArrowBitCountSet(item_validity, first, count) != count) {
+        error = erlang::nif::error(env, "fixed-size lists with null items cannot be returned as binaries");
+        return 1;
+    }
+
+    out = enif_make_list(env, 0);
+    if (values->length == 0) {
+        return 0;
+    }
+    auto buffer = (const uint8_t *)items->buffers[1];
+    if (buffer == nullptr) {
+        error = erlang::nif::error(env, "invalid ArrowArray, data buffer is NULL");
+        return 1;
+    }
+    size_t row_bytes = (size_t)size * width;
+    size_t bytes = (size_t)count * width;
+    ERL_NIF_TERM data;
+    if (buffer_owner != nullptr) {
+        data = enif_make_resource_binary(env, buffer_owner, buffer + first * width, bytes);
+    } else {
+        memcpy(enif_make_new_binary(env, bytes, &data), buffer + first * width, bytes);
+    }
+
+    auto validity = (const uint8_t *)values->buffers[0];
+    bool has_nulls = validity != nullptr && values->null_count != 0;
+    for (int64_t i = values->length - 1; i >= 0; i--) {
+        ERL_NIF_TERM row = kAtomNil;
+        if (!has_nulls || ArrowBitGet(validity, values->offset + i)) {
+            row = enif_make_sub_binary(env, data, (size_t)i * row_bytes, row_bytes);
+        }
+        out = enif_make_list_cell(env, row, out);
+    }
+    return 0;
+}
+
+// Decimals are returned as `{coefficient, exponent}`, where the exponent is
+// the opposite of the scale of the column.
+static ERL_NIF_TERM decimals_from_buffer(ErlNifEnv *env, const struct ArrowArray * values, int64_t offset, int64_t count, const struct ArrowSchemaView &schema_view) {
+    auto validity_bitmap = (const uint8_t *)values->buffers[0];
+    auto value_buffer = (const uint8_t *)values->buffers[1];
+    int64_t width = schema_view.decimal_bitwidth / 8;
+    ERL_NIF_TERM exponent = enif_make_int(env, -schema_view.decimal_scale);
+
+    struct ArrowDecimal decimal;
+    ArrowDecimalInit(&decimal, schema_view.decimal_bitwidth, schema_view.decimal_precision, schema_view.decimal_scale);
+    ERL_NIF_TERM list = enif_make_list(env, 0);
+    for (int64_t i = count - 1; i >= 0; i--) {
+        int64_t row = values->offset + offset + i;
+        ERL_NIF_TERM term = kAtomNil;
+        if (validity_bitmap == nullptr || ArrowBitGet(validity_bitmap, row)) {
+            ArrowDecimalSetBytes(&decimal, value_buffer + row * width);
+            term = enif_make_tuple2(env, arrow_decimal_to_nif_term(env, &decimal), exponent);
+        }
+        list = enif_make_list_cell(env, term, list);
+    }
+    return list;
+}
+
+// Timestamps of a column with a time zone are returned as `DateTime`s in
+// that zone. Consecutive values mostly fall in the same span of the zone,
+// which is only searched again once a value falls out of the last one.
+static ERL_NIF_TERM zoned_timestamps_from_buffer(ErlNifEnv *env, int64_t offset, int64_t count, const uint8_t * validity_bitmap, const int64_t * value_buffer, char unit, uint8_t us_precision, const AdbcTimeZone &timezone) {
+    ERL_NIF_TERM keys[] = {
+        kAtomStructKey,
+        kAtomCalendarKey,
+        kAtomYearKey,
+        kAtomMonthKey,
+        kAtomDayKey,
+        kAtomHourKey,
+        kAtomMinuteKey,
+        kAtomSecondKey,
+        kAtomMicrosecondKey,
+        kAtomTimeZoneKey,
+        kAtomZoneAbbrKey,
+        kAtomUtcOffsetKey,
+        kAtomStdOffsetKey,
+    };
+    ERL_NIF_TERM time_zone = erlang::nif::make_binary(env, timezone.name());
+    std::vector<ERL_NIF_TERM> abbreviations;
+    for (const std::string &abbreviation : timezone.abbreviations()) {
+        abbreviations.push_back(erlang::nif::make_binary(env, abbreviation));
+    }
+
+    AdbcZoneSpan span;
+    return values_from_buffer(env, offset, count, validity_bitmap, value_buffer, [&](ErlNifEnv *env, int64_t val) -> ERL_NIF_TERM {
+        int64_t us = to_microseconds(val, unit);
+        int64_t seconds = floor_div(us, kMicrosecondsPerSecond);
+        if (!span.contains(seconds)) {
+            span = timezone.span_at(seconds);
+        }
+        const AdbcZonePeriod &period = timezone.period(span.period);
+        int64_t local = us + (int64_t)(period.utc_offset + period.std_offset) * kMicrosecondsPerSecond;
+        CivilDate date = civil_from_days(floor_div(local, kMicrosecondsPerDay));
+        CivilTime time = civil_time_from_microseconds(local);
+
+        ERL_NIF_TERM ex_dt;
+        ERL_NIF_TERM values[] = {
+            kAtomDateTimeModule,
+            kAtomCalendarISO,
+            enif_make_int64(env, date.year),
+            enif_make_uint(env, date.month),
+            enif_make_uint(env, date.day),
+            enif_make_uint(env, time.hour),
+            enif_make_uint(env, time.minute),
+            enif_make_uint(env, time.second),
+            enif_make_tuple2(env, enif_make_uint(env, time.microsecond), enif_make_int(env, us_precision)),
+            time_zone,
+            abbreviations[period.abbreviation],
+            enif_make_int(env, period.utc_offset),
+            enif_make_int(env, period.std_offset),
+        };
+        enif_make_map_from_arrays(env, keys, values, 13, &ex_dt);
+        return ex_dt;
+    });
+}
+
+// The most digits of the coefficient of a 128-bit decimal.
+constexpr int32_t kDecimal128MaxPrecision = 38;
+
+// Returns the largest scale, up to 38, of the decimals of a string column
+// such as the `numeric` columns of PostgreSQL, which have no scale of
+// their own in Arrow.
+template <typename OffsetType> static int32_t numeric_strings_scale(const struct ArrowArray * values) {
+    auto validity_bitmap = (const uint8_t *)values->buffers[0];
+    auto offsets = (const OffsetType *)values->buffers[1];
+    auto data = (const char *)values->buffers[2];
+
+    int32_t scale = 0;
+    DecimalDigits parsed;
+    for (int64_t i = 0; i < values->length; i++) {
+        int64_t row = values->offset + i;
+        if (validity_bitmap != nullptr && !ArrowBitGet(validity_bitmap, row)) continue;
+        if (parse_decimal_digits(data + offsets[row], (int64_t)(offsets[row + 1] - offsets[row]), parsed)) {
+            scale = std::max(scale, std::min(parsed.scale, kDecimal128MaxPrecision));
+        }
+    }
+    return scale;
+}
+
+// Converts a string column of decimals to `{coefficient, exponent}`, with
+// the exponent the opposite of `scale` unless the coefficient would then
+// not fit 128 bits, or the value has more fractional digits. Values that
+// are not finite decimals or do not fit 128 bits are kept as strings.
+template <typename OffsetType> static ERL_NIF_TERM numeric_strings_to_decimals(ErlNifEnv *env, const struct ArrowArray * values, int32_t scale) {
+    auto validity_bitmap = (const uint8_t *)values->buffers[0];
+    auto offsets = (const OffsetType *)values->buffers[1];
+    auto data = (const char *)values->buffers[2];
+
+    struct ArrowDecimal decimal;
+    ArrowDecimalInit(&decimal, 128, kDecimal128MaxPrecision, scale);
+    DecimalDigits parsed;
+    ERL_NIF_TERM list = enif_make_list(env, 0);
+    for (int64_t i = values->length - 1; i >= 0; i--) {
+        int64_t row = values->offset + i;
+        if (validity_bitmap != nullptr && !ArrowBitGet(validity_bitmap, row)) {
+            list = enif_make_list_cell(env, kAtomNil, list);
+            continue;
+        }
+        const char * value = data + offsets[row];
+        size_t size = (size_t)(offsets[row + 1] - offsets[row]);
+        if (!parse_decimal_digits(value, (int64_t)size, parsed) || parsed.digits.size() > (size_t)kDecimal128MaxPrecision) {
+            list = enif_make_list_cell(env, erlang::nif::make_binary(env, value, size), list);
+            continue;
+        }
+
+        int32_t exponent = -parsed.scale;
+        if (parsed.scale < scale && parsed.digits.size() + (size_t)(scale - parsed.scale) <= (size_t)kDecimal128MaxPrecision) {
+            if (!parsed.digits.empty()) parsed.digits.append((size_t)(scale - parsed.scale), '0');
+            exponent = -scale;
+        }
+        ArrowDecimalSetDigits(&decimal, ArrowStringView{parsed.digits.data(), (int64_t)parsed.digits.size()});
+        if (parsed.negative) ArrowDecimalNegate(&decimal);
+        list = enif_make_list_cell(env, enif_make_tuple2(env, arrow_decimal_to_nif_term(env, &decimal), enif_make_int(env, exponent)), list);
+    }
+    return list;
+}
+
+// Returns false if a valid index is negative.
+template <typename T> static bool dictionary_indices_from_buffer(const struct ArrowArray * values, int64_t offset, int64_t count, std::vector<int64_t> &indices) {
+    auto validity_bitmap = (const uint8_t *)values->buffers[0];
+    auto index_buffer = (const T *)values->buffers[1];
+    indices.resize((size_t)count);
+    for (int64_t i = 0; i < count; i++) {
+        int64_t row = values->offset + offset + i;
+        if (validity_bitmap != nullptr && !ArrowBitGet(validity_bitmap, row)) {
+            indices[i] = -1;
+        } else {
+            indices[i] = (int64_t)index_buffer[row];
+            if (indices[i] < 0) return false;
+        }
+    }
+    return true;
+}
+
+// Reads `count` indices of a dictionary-encoded array starting at `offset`
+// and converts its dictionary, once, into `dictionary`. Null indices are -1.
+static int arrow_dictionary_to_nif_terms(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, int64_t offset, int64_t count, int64_t level, std::vector<int64_t> &indices, std::vector<ERL_NIF_TERM> &dictionary, ERL_NIF_TERM &term_type, ERL_NIF_TERM &error, const ArrowColumnContext * context) {
+    if (values->dictionary == nullptr) {
+        error = erlang::nif::error(env, "invalid ArrowArray, dictionary-encoded array has no dictionary");
+        return 1;
+    }
+    if (values->n_buffers != 2) {
+        error = erlang::nif::error(env, "invalid n_buffers value for dictionary-encoded ArrowArray, values->n_buffers != 2");
+        return 1;
+    }
+    if (count == -1) count = values->length;
+
+    const char* format = schema->format ? schema->format : "";
+    bool valid_indices = false;
+    switch (strlen(format) == 1 ? format[0] : '\0') {
+        case 'c': valid_indices = dictionary_indices_from_buffer<int8_t>(values, offset, count, indices); break;
+        case 's': valid_indices = dictionary_indices_from_buffer<int16_t>(values, offset, count, indices); break;
+        case 'i': valid_indices = dictionary_indices_from_buffer<int32_t>(values, offset, count, indices); break;
+        case 'l': valid_indices = dictionary_indices_from_buffer<int64_t>(values, offset, count, indices); break;
+        case 'C': valid_indices = dictionary_indices_from_buffer<uint8_t>(values, offset, count, indices); break;
+        case 'S': valid_indices = dictionary_indices_from_buffer<uint16_t>(values, offset, count, indices); break;
+        case 'I': valid_indices = dictionary_indices_from_buffer<uint32_t>(values, offset, count, indices); break;
+        case 'L': valid_indices = dictionary_indices_from_buffer<uint64_t>(values, offset, count, indices); break;
+        default:
+            error = erlang::nif::error(env, "invalid index type of dictionary-encoded ArrowArray");
+            return 1;
+    }
+    if (!valid_indices) {
+        error = erlang::nif::error(env, "invalid ArrowArray, dictionary index out of range");
+        return 1;
+    }
+
+    // the values of the dictionary are converted as a column of their own,
+    // still referencing the batch when binaries are not copied
+    ArrowColumnContext dictionary_context{kAtomNil, kAtomNil, context ? context->buffer_owner : nullptr};
+    std::vector<ERL_NIF_TERM> out_terms;
+    ERL_NIF_TERM dictionary_metadata;
+    if (arrow_array_to_nif_term(env, schema->dictionary, values->dictionary, 0, -1, level + 1, out_terms, term_type, dictionary_metadata, error, nullptr, &dictionary_context) == 1) {
+        return 1;
+    }
+    if (out_terms.size() != 2 || schema->dictionary->n_children != 0) {
+        error = erlang::nif::error(env, "dictionary-encoded arrays of nested types are not supported");
+        return 1;
+    }
+
+    dictionary.clear();
+    ERL_NIF_TERM head, tail = out_terms[1];
+    while (enif_get_list_cell(env, tail, &head, &tail)) {
+        dictionary.push_back(head);
+    }
+    for (int64_t index : indices) {
+        if (index >= (int64_t)dictionary.size()) {
+            error = erlang::nif::error(env, "invalid ArrowArray, dictionary index out of range");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Converts a dictionary-encoded array to the list of its values, where each
+// index becomes the term of its value in the dictionary. Rows with the same
+// value therefore share a single term, for example a single binary.
+static int arrow_dictionary_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, int64_t offset, int64_t count, int64_t level, ERL_NIF_TERM &out, ERL_NIF_TERM &term_type, ERL_NIF_TERM &error, const ArrowColumnContext * context) {
+    std::vector<int64_t> indices;
+    std::vector<ERL_NIF_TERM> dictionary;
+    if (arrow_dictionary_to_nif_terms(env, schema, values, offset, count, level, indices, dictionary, term_type, error, context) == 1) {
+        return 1;
+    }
+
+    out = enif_make_list(env, 0);
+    for (size_t i = indices.size(); i > 0; i--) {
+        int64_t index = indices[i - 1];
+        out = enif_make_list_cell(env, index == -1 ? kAtomNil : dictionary[(size_t)index], out);
+    }
+    return 0;
+}
+
+// Converts a dictionary-encoded array to `{:dictionary, indices, values}`,
+// where `indices` is a list of integers or nil and `values` the list of
+// the values of the dictionary.
+static int arrow_dictionary_to_native_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, ERL_NIF_TERM &out, ERL_NIF_TERM &term_type, ERL_NIF_TERM &error, const ArrowColumnContext * context) {
+    std::vector<int64_t> indices;
+    std::vector<ERL_NIF_TERM> dictionary;
+    if (arrow_dictionary_to_nif_terms(env, schema, values, 0, -1, 1, indices, dictionary, term_type, error, context) == 1) {
+        return 1;
+    }
+
+    std::vector<ERL_NIF_TERM> index_terms(indices.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+        index_terms[i] = indices[i] == -1 ? kAtomNil : enif_make_int64(env, indices[i]);
+    }
+    out = enif_make_tuple3(env,
+        kAtomDictionary,
+        enif_make_list_from_array(env, index_terms.data(), (unsigned)index_terms.size()),
+        enif_make_list_from_array(env, dictionary.data(), (unsigned)dictionary.size())
+    );
+    return 0;
+}
+
 int get_arrow_array_children_as_list(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, int64_t offset, int64_t count, uint64_t level, std::vector<ERL_NIF_TERM> &children, ERL_NIF_TERM &error) {
     if (schema->n_children > 0 && schema->children == nullptr) {
         error = erlang::nif::error(env, "invalid ArrowSchema, schema->children == nullptr, however, schema->n_children > 0");
@@ -118,6 +819,8 @@ int get_arrow_array_children_as_list(ErlNifEnv *env, struct ArrowSchema * schema
     constexpr int64_t bitmap_buffer_index = 0;
     const uint8_t * bitmap_buffer = (const uint8_t *)values->buffers[bitmap_buffer_index];
     children.resize(count);
+    // reused by every child, `arrow_array_to_nif_term` clears it
+    std::vector<ERL_NIF_TERM> childrens;
     for (int64_t child_i = offset; child_i < offset + count; child_i++) {
         if (bitmap_buffer && ((schema->flags & ARROW_FLAG_NULLABLE) || (values->null_count > 0))) {
             uint8_t vbyte = bitmap_buffer[child_i / 8];
@@ -128,7 +831,6 @@ int get_arrow_array_children_as_list(ErlNifEnv *env, struct ArrowSchema * schema
         }
         struct ArrowSchema * child_schema = schema->children[child_i];
         struct ArrowArray * child_values = values->children[child_i];
-        std::vector<ERL_NIF_TERM> childrens;
         ERL_NIF_TERM child_type;
         ERL_NIF_TERM child_metadata;
         if (arrow_array_to_nif_term(env, child_schema, child_values, level + 1, childrens, child_type, child_metadata, error) == 1) {
@@ -218,6 +920,35 @@ ERL_NIF_TERM get_arrow_array_map_children(ErlNifEnv *env, struct ArrowSchema * s
     return get_arrow_array_map_children(env, schema, values, 0, -1, level);
 }
 
+// Converts the `count` rows from `offset` of `field_array`, a member of a
+// union, in a single call, each wrapped as the one-element list of the
+// value of a union element.
+//
+// Returns whether the rows were converted into `rows`. Nested members, and
+// members whose rows do not convert in bulk, are left to be converted row
+// by row.
+static bool arrow_union_field_to_nif_terms(ErlNifEnv *env, struct ArrowSchema * field_schema, struct ArrowArray * field_array, int64_t offset, int64_t count, uint64_t level, std::vector<ERL_NIF_TERM> &rows) {
+    rows.clear();
+    if (field_schema->n_children != 0 || count <= 0) return false;
+
+    std::vector<ERL_NIF_TERM> field_values;
+    ERL_NIF_TERM field_type, field_metadata, error;
+    if (arrow_array_to_nif_term(env, field_schema, field_array, offset, count, level + 1, field_values, field_type, field_metadata, error) == 1 || field_values.size() != 2) {
+        return false;
+    }
+
+    rows.reserve((size_t)count);
+    ERL_NIF_TERM head, tail = field_values[1];
+    while (enif_get_list_cell(env, tail, &head, &tail)) {
+        rows.push_back(enif_make_list1(env, head));
+    }
+    if ((int64_t)rows.size() != count) {
+        rows.clear();
+        return false;
+    }
+    return true;
+}
+
 ERL_NIF_TERM get_arrow_array_dense_union_children(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, int64_t offset, int64_t count, uint64_t level) {
     ERL_NIF_TERM error{};
     if (schema->n_children > 0 && schema->children == nullptr) {
@@ -242,36 +973,64 @@ ERL_NIF_TERM get_arrow_array_dense_union_children(ErlNifEnv *env, struct ArrowSc
     const uint8_t * types_buffer = (const uint8_t *)values->buffers[types_buffer_index];
     const int32_t * offsets_buffer = (const int32_t *)values->buffers[offset_buffer_index];
 
-    std::vector<ERL_NIF_TERM> elements(count);
+    // each member is converted once, over the range of its rows referenced
+    // by the union, and its values are then gathered row by row
+    std::vector<int64_t> first_offsets(values->n_children, -1);
+    std::vector<int64_t> last_offsets(values->n_children, -1);
     for (int64_t child_i = offset; child_i < offset + count; child_i++) {
         uint8_t child_type = types_buffer[child_i];
         int32_t child_offset = offsets_buffer[child_i];
         if (child_type >= schema->n_children || child_type >= values->n_children) {
             return erlang::nif::error(env, "invalid child type when parsing ArrowArray (dense union), child_type >= schema->n_children || child_type >= values->n_children");
         }
+        if (child_offset < 0 || child_offset >= values->children[child_type]->length) {
+            return erlang::nif::error(env, "invalid child offset when parsing ArrowArray (dense union), child_offset < 0 || child_offset >= child->length");
+        }
+        if (first_offsets[child_type] == -1 || child_offset < first_offsets[child_type]) first_offsets[child_type] = child_offset;
+        if (child_offset > last_offsets[child_type]) last_offsets[child_type] = child_offset;
+    }
+
+    std::vector<ERL_NIF_TERM> names(values->n_children);
+    std::vector<std::vector<ERL_NIF_TERM>> field_rows(values->n_children);
+    std::vector<bool> bulk(values->n_children, false);
+    for (int64_t child_type = 0; child_type < values->n_children; child_type++) {
+        if (first_offsets[child_type] == -1) continue;
+        names[child_type] = erlang::nif::make_binary(env, schema->children[child_type]->name);
+        int64_t field_count = last_offsets[child_type] - first_offsets[child_type] + 1;
+        bulk[child_type] = arrow_union_field_to_nif_terms(env, schema->children[child_type], values->children[child_type], first_offsets[child_type], field_count, level, field_rows[child_type]);
+    }
+
+    std::vector<ERL_NIF_TERM> elements(count);
+    std::vector<ERL_NIF_TERM> field_values;
+    for (int64_t child_i = offset; child_i < offset + count; child_i++) {
+        uint8_t child_type = types_buffer[child_i];
+        int32_t child_offset = offsets_buffer[child_i];
         struct ArrowSchema * field_schema = schema->children[child_type];
         struct ArrowArray * field_array = values->children[child_type];
 
-        std::vector<ERL_NIF_TERM> union_element_name(1), union_element_value(1);
-        std::vector<ERL_NIF_TERM> field_values;
-        union_element_name[0] = erlang::nif::make_binary(env, field_schema->name);
+        ERL_NIF_TERM union_element_name = names[child_type];
+        ERL_NIF_TERM union_element_value{};
 
-        ERL_NIF_TERM field_type;
-        ERL_NIF_TERM field_metadata;
-        if (arrow_array_to_nif_term(env, field_schema, field_array, child_offset, 1, level + 1, field_values, field_type, field_metadata, error) == 1) {
-            return error;
-        }
-
-        if (field_values.size() == 1) {
-            union_element_value[0] = field_values[0];
-        } else if (field_values.size() == 2) {
-            union_element_value[0] = field_values[1];
+        if (bulk[child_type]) {
+            union_element_value = field_rows[child_type][child_offset - first_offsets[child_type]];
         } else {
-            return erlang::nif::error(env, "invalid dense union field value");
+            ERL_NIF_TERM field_type;
+            ERL_NIF_TERM field_metadata;
+            if (arrow_array_to_nif_term(env, field_schema, field_array, child_offset, 1, level + 1, field_values, field_type, field_metadata, error) == 1) {
+                return error;
+            }
+
+            if (field_values.size() == 1) {
+                union_element_value = field_values[0];
+            } else if (field_values.size() == 2) {
+                union_element_value = field_values[1];
+            } else {
+                return erlang::nif::error(env, "invalid dense union field value");
+            }
         }
 
         ERL_NIF_TERM element{};
-        if (!enif_make_map_from_arrays(env, union_element_name.data(), union_element_value.data(), 1, &element)) {
+        if (!enif_make_map_from_arrays(env, &union_element_name, &union_element_value, 1, &element)) {
             return erlang::nif::error(env, "failed to enif_make_map_from_arrays when parsing ArrowSchema (dense union)");
         }
         elements[child_i - offset] = element;
@@ -306,36 +1065,58 @@ ERL_NIF_TERM get_arrow_array_sparse_union_children(ErlNifEnv *env, struct ArrowS
     constexpr int64_t types_buffer_index = 0;
     const uint8_t * types_buffer = (const uint8_t *)values->buffers[types_buffer_index];
 
-    std::vector<ERL_NIF_TERM> elements(count);
+    // each member present in the rows is converted once, over all of them
+    // since members are as long as the union, and its values are then
+    // gathered row by row
+    std::vector<bool> present(values->n_children, false);
     for (int64_t child_i = offset; child_i < offset + count; child_i++) {
         uint8_t child_type = types_buffer[child_i];
         if (child_type >= schema->n_children || child_type >= values->n_children) {
             return erlang::nif::error(env, "invalid child type when parsing ArrowArray (sparse union), child_type >= schema->n_children || child_type >= values->n_children");
         }
+        present[child_type] = true;
+    }
+
+    std::vector<ERL_NIF_TERM> names(values->n_children);
+    std::vector<std::vector<ERL_NIF_TERM>> field_rows(values->n_children);
+    std::vector<bool> bulk(values->n_children, false);
+    for (int64_t child_type = 0; child_type < values->n_children; child_type++) {
+        if (!present[child_type]) continue;
+        names[child_type] = erlang::nif::make_binary(env, schema->children[child_type]->name);
+        bulk[child_type] = arrow_union_field_to_nif_terms(env, schema->children[child_type], values->children[child_type], offset, count, level, field_rows[child_type]);
+    }
+
+    std::vector<ERL_NIF_TERM> elements(count);
+    std::vector<ERL_NIF_TERM> field_values;
+    for (int64_t child_i = offset; child_i < offset + count; child_i++) {
+        uint8_t child_type = types_buffer[child_i];
         struct ArrowSchema * field_schema = schema->children[child_type];
         struct ArrowArray * field_array = values->children[child_type];
 
-        std::vector<ERL_NIF_TERM> union_element_name(1), union_element_value(1);
-        std::vector<ERL_NIF_TERM> field_values;
-        union_element_name[0] = erlang::nif::make_binary(env, field_schema->name);
-
-        ERL_NIF_TERM field_type;
-        // todo: use field_metadata
-        ERL_NIF_TERM field_metadata;
-        if (arrow_array_to_nif_term(env, field_schema, field_array, child_i, 1, level + 1, field_values, field_type, field_metadata, error) == 1) {
-            return error;
-        }
+        ERL_NIF_TERM union_element_name = names[child_type];
+        ERL_NIF_TERM union_element_value{};
 
-        if (field_values.size() == 1) {
-            union_element_value[0] = field_values[0];
-        } else if (field_values.size() == 2) {
-            union_element_value[0] = field_values[1];
+        if (bulk[child_type]) {
+            union_element_value = field_rows[child_type][child_i - offset];
         } else {
-            return erlang::nif::error(env, "invalid sparse union field value");
+            ERL_NIF_TERM field_type;
+            // todo: use field_metadata
+            ERL_NIF_TERM field_metadata;
+            if (arrow_array_to_nif_term(env, field_schema, field_array, child_i, 1, level + 1, field_values, field_type, field_metadata, error) == 1) {
+                return error;
+            }
+
+            if (field_values.size() == 1) {
+                union_element_value = field_values[0];
+            } else if (field_values.size() == 2) {
+                union_element_value = field_values[1];
+            } else {
+                return erlang::nif::error(env, "invalid sparse union field value");
+            }
         }
 
         ERL_NIF_TERM element{};
-        if (!enif_make_map_from_arrays(env, union_element_name.data(), union_element_value.data(), 1, &element)) {
+        if (!enif_make_map_from_arrays(env, &union_element_name, &union_element_value, 1, &element)) {
             return erlang::nif::error(env, "failed to enif_make_map_from_arrays when parsing ArrowSchema (sparse union)");
         }
         elements[child_i - offset] = element;
@@ -348,6 +1129,53 @@ ERL_NIF_TERM get_arrow_array_sparse_union_children(ErlNifEnv *env, struct ArrowS
     return get_arrow_array_sparse_union_children(env, schema, values, 0, -1, level);
 }
 
+// Returns true if `schema` is a list, large list or fixed size list.
+static bool arrow_schema_is_list(struct ArrowSchema * schema) {
+    const char* format = schema->format ? schema->format : "";
+    return strcmp("+l", format) == 0 || strcmp("+L", format) == 0 || strncmp("+w:", format, 3) == 0;
+}
+
+template <typename OffsetT> static bool list_items_range(const struct ArrowArray * values, int64_t offset, int64_t rows, int64_t &items_offset, int64_t &items_count) {
+    constexpr int64_t offset_buffer_index = 1;
+    const OffsetT * offsets = (const OffsetT *)values->buffers[offset_buffer_index];
+    if (offsets == nullptr) {
+        return rows == 0;
+    }
+    items_offset = (int64_t)offsets[offset];
+    items_count = (int64_t)offsets[offset + rows] - items_offset;
+    return items_count >= 0;
+}
+
+// Maps the rows `offset` to `offset + count` of the list `values` to the
+// range of its items holding their elements, using its offsets buffer, so
+// that the items are converted once over exactly the rows asked for.
+// `count` may be -1 for all rows until the end.
+static bool arrow_list_items_range(struct ArrowSchema * schema, const struct ArrowArray * values, const struct ArrowArray * items_values, int64_t offset, int64_t count, int64_t &items_offset, int64_t &items_count) {
+    const char* format = schema->format ? schema->format : "";
+    int64_t rows = count == -1 ? values->length - offset : count;
+    if (offset < 0 || rows < 0 || offset + rows > values->length) {
+        return false;
+    }
+
+    items_offset = 0;
+    items_count = 0;
+    bool valid = true;
+    if (rows == 0) {
+        // offsets may be missing for empty lists
+    } else if (strncmp("+w:", format, 3) == 0) {
+        int64_t list_size = strtoll(format + 3, nullptr, 10);
+        items_offset = offset * list_size;
+        items_count = rows * list_size;
+    } else if (values->n_buffers != 2) {
+        valid = false;
+    } else if (format[1] == 'L') {
+        valid = list_items_range<int64_t>(values, offset, rows, items_offset, items_count);
+    } else {
+        valid = list_items_range<int32_t>(values, offset, rows, items_offset, items_count);
+    }
+    return valid && items_offset >= 0 && items_offset + items_count <= items_values->length;
+}
+
 ERL_NIF_TERM get_arrow_array_list_children(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, int64_t offset, int64_t count, uint64_t level) {
     ERL_NIF_TERM error{};
     if (schema->children == nullptr) {
@@ -371,40 +1199,44 @@ ERL_NIF_TERM get_arrow_array_list_children(ErlNifEnv *env, struct ArrowSchema *
         return erlang::nif::error(env, "invalid ArrowSchema (list), its single child is not named item");
     }
 
+    // the elements of all rows are converted at once, as a single column
+    int64_t items_offset, items_count;
+    if (!arrow_list_items_range(schema, values, items_values, offset, count, items_offset, items_count)) {
+        return erlang::nif::error(env, "invalid offset or count for ArrowArray (list), its rows are out of the range of its items");
+    }
+    if (items_offset == 0 && items_count == items_values->length) {
+        items_count = -1;
+    }
+
     std::vector<ERL_NIF_TERM> children;
     if (items_values->n_children > 0) {
-        if (offset < 0 || offset >= items_values->n_children) {
-            return erlang::nif::error(env, "invalid offset for ArrowArray (list), offset < 0 || offset >= items_values->n_children");
-        }
-        if (count == -1) count = items_values->n_children;
-        if ((offset + count) > items_values->n_children) {
-            return erlang::nif::error(env, "invalid offset for ArrowArray (list), (offset + count) > items_values->n_children");
-        }
-        children.resize(count);
+        children.resize(items_values->n_children);
         bool items_nullable = (items_schema->flags & ARROW_FLAG_NULLABLE) || (items_values->null_count > 0);
-        for (int64_t child_i = offset; child_i < offset + count; child_i++) {
+        std::vector<ERL_NIF_TERM> childrens;
+        for (int64_t child_i = 0; child_i < items_values->n_children; child_i++) {
             if (bitmap_buffer && items_nullable) {
                 uint8_t vbyte = bitmap_buffer[child_i / 8];
                 if (!(vbyte & (1 << (child_i % 8)))) {
-                    children[child_i - offset] = kAtomNil;
+                    children[child_i] = kAtomNil;
                     continue;
                 }
             }
             struct ArrowSchema * item_schema = items_schema->children[child_i];
             struct ArrowArray * item_values = items_values->children[child_i];
 
-            std::vector<ERL_NIF_TERM> childrens;
+            // the offset and count of other nested types refer to children
+            bool ranged = items_count != -1 && (arrow_array_is_row_sliceable(item_schema) || arrow_schema_is_list(item_schema));
             ERL_NIF_TERM item_type;
             ERL_NIF_TERM item_metadata;
-            if (arrow_array_to_nif_term(env, item_schema, item_values, level + 1, childrens, item_type, item_metadata, error) == 1) {
+            if (arrow_array_to_nif_term(env, item_schema, item_values, ranged ? items_offset : 0, ranged ? items_count : -1, level + 1, childrens, item_type, item_metadata, error) == 1) {
                 return error;
             }
 
             if (childrens.size() == 1) {
-                children[child_i - offset] = childrens[0];
+                children[child_i] = childrens[0];
             } else {
                 bool children_nullable = (item_schema->flags & ARROW_FLAG_NULLABLE) || (item_values->null_count > 0);
-                children[child_i - offset] = make_adbc_column(env, childrens[0], item_type, children_nullable, item_metadata, childrens[1]);
+                children[child_i] = make_adbc_column(env, childrens[0], item_type, children_nullable, item_metadata, childrens[1]);
             }
         }
         return enif_make_list_from_array(env, children.data(), (unsigned)children.size());
@@ -413,7 +1245,7 @@ ERL_NIF_TERM get_arrow_array_list_children(ErlNifEnv *env, struct ArrowSchema *
         std::vector<ERL_NIF_TERM> childrens;
         ERL_NIF_TERM children_type;
         ERL_NIF_TERM children_metadata;
-        if (arrow_array_to_nif_term(env, items_schema, items_values, offset, count, level + 1, childrens, children_type, children_metadata, error) == 1) {
+        if (arrow_array_to_nif_term(env, items_schema, items_values, items_count == -1 ? 0 : items_offset, items_count, level + 1, childrens, children_type, children_metadata, error) == 1) {
             return error;
         }
 
@@ -433,7 +1265,7 @@ ERL_NIF_TERM get_arrow_array_list_children(ErlNifEnv *env, struct ArrowSchema *
     return get_arrow_array_list_children(env, schema, values, 0, -1, level);
 }
 
-int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, int64_t offset, int64_t count, int64_t level, std::vector<ERL_NIF_TERM> &out_terms, ERL_NIF_TERM &term_type, ERL_NIF_TERM &arrow_metadata, ERL_NIF_TERM &error, bool *end_of_series) {
+int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * values, int64_t offset, int64_t count, int64_t level, std::vector<ERL_NIF_TERM> &out_terms, ERL_NIF_TERM &term_type, ERL_NIF_TERM &arrow_metadata, ERL_NIF_TERM &error, bool *end_of_series, const ArrowColumnContext * context) {
     if (schema == nullptr) {
         error = erlang::nif::error(env, "invalid ArrowSchema (nullptr) when invoking next");
         return 1;
@@ -455,218 +1287,53 @@ int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct
     int64_t data_buffer_index = 1;
     int64_t offset_buffer_index = 2;
 
-    std::vector<ERL_NIF_TERM> metadata_keys, metadata_values;
-    if (schema->metadata) {
-        struct ArrowMetadataReader metadata_reader{};
-        struct ArrowStringView key;
-        struct ArrowStringView value;
-        if (ArrowMetadataReaderInit(&metadata_reader, schema->metadata) == NANOARROW_OK) {
-            while (ArrowMetadataReaderRead(&metadata_reader, &key, &value) == NANOARROW_OK) {
-                // printf("key: %.*s, value: %.*s\n", (int)key.size_bytes, key.data, (int)value.size_bytes, value.data);
-                metadata_keys.push_back(erlang::nif::make_binary(env, key.data, (size_t)key.size_bytes));
-                metadata_values.push_back(erlang::nif::make_binary(env, value.data, (size_t)key.size_bytes));
-            }
-            if (metadata_keys.size() > 0) {
-                enif_make_map_from_arrays(env, metadata_keys.data(), metadata_values.data(), (unsigned)metadata_keys.size(), &arrow_metadata);
-            }
-        }
+    if (context) {
+        arrow_metadata = context->metadata;
+    } else {
+        arrow_metadata = arrow_schema_metadata_to_nif_term(env, schema);
     }
 
     bool is_struct = false;
     size_t format_len = strlen(format);
     bool format_processed = true;
-    if (format_len == 1) {
-        if (format[0] == 'l') {
-            // NANOARROW_TYPE_INT64
-            using value_type = int64_t;
-            term_type = kAdbcColumnTypeI64;
-            if (count == -1) count = values->length;
-            if (values->n_buffers != 2) {
-                error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=l), values->n_buffers != 2");
-                return 1;
-            }
-            current_term = values_from_buffer(
-                env,
-                offset,
-                count,
-                (const uint8_t *)values->buffers[bitmap_buffer_index],
-                (const value_type *)values->buffers[data_buffer_index],
-                enif_make_int64
-            );
-        } else if (format[0] == 'c') {
-            // NANOARROW_TYPE_INT8
-            using value_type = int8_t;
-            term_type = kAdbcColumnTypeI8;
-            if (count == -1) count = values->length;
-            if (values->n_buffers != 2) {
-                error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=c), values->n_buffers != 2");
-                return 1;
-            }
-            current_term = values_from_buffer(
-                env,
-                offset,
-                count,
-                (const uint8_t *)values->buffers[bitmap_buffer_index],
-                (const value_type *)values->buffers[data_buffer_index],
-                enif_make_int64
-            );
-        } else if (format[0] == 's') {
-            // NANOARROW_TYPE_INT16
-            using value_type = int16_t;
-            term_type = kAdbcColumnTypeI16;
-            if (count == -1) count = values->length;
-            if (values->n_buffers != 2) {
-                error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=s), values->n_buffers != 2");
-                return 1;
-            }
-            current_term = values_from_buffer(
-                env,
-                offset,
-                count,
-                (const uint8_t *)values->buffers[bitmap_buffer_index],
-                (const value_type *)values->buffers[data_buffer_index],
-                enif_make_int64
-            );
-        } else if (format[0] == 'i') {
-            // NANOARROW_TYPE_INT32
-            using value_type = int32_t;
-            term_type = kAdbcColumnTypeI32;
-            if (count == -1) count = values->length;
-            if (values->n_buffers != 2) {
-                error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=i), values->n_buffers != 2");
-                return 1;
-            }
-            current_term = values_from_buffer(
-                env,
-                offset,
-                count,
-                (const uint8_t *)values->buffers[bitmap_buffer_index],
-                (const value_type *)values->buffers[data_buffer_index],
-                enif_make_int64
-            );
-        } else if (format[0] == 'L') {
-            // NANOARROW_TYPE_UINT64
-            using value_type = uint64_t;
-            term_type = kAdbcColumnTypeU64;
-            if (count == -1) count = values->length;
-            if (values->n_buffers != 2) {
-                error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=L), values->n_buffers != 2");
-                return 1;
-            }
-            current_term = values_from_buffer(
-                env,
-                offset,
-                count,
-                (const uint8_t *)values->buffers[bitmap_buffer_index],
-                (const value_type *)values->buffers[data_buffer_index],
-                enif_make_uint64
-            );
-        } else if (format[0] == 'C') {
-            // NANOARROW_TYPE_UINT8
-            using value_type = uint8_t;
-            term_type = kAdbcColumnTypeU8;
-            if (count == -1) count = values->length;
-            if (values->n_buffers != 2) {
-                error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=C), values->n_buffers != 2");
-                return 1;
-            }
-            current_term = values_from_buffer(
-                env,
-                offset,
-                count,
-                (const uint8_t *)values->buffers[bitmap_buffer_index],
-                (const value_type *)values->buffers[data_buffer_index],
-                enif_make_uint64
-            );
-        } else if (format[0] == 'S') {
-            // NANOARROW_TYPE_UINT16
-            using value_type = uint16_t;
-            term_type = kAdbcColumnTypeU16;
-            if (count == -1) count = values->length;
-            if (values->n_buffers != 2) {
-                error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=S), values->n_buffers != 2");
-                return 1;
-            }
-            current_term = values_from_buffer(
-                env,
-                offset,
-                count,
-                (const uint8_t *)values->buffers[bitmap_buffer_index],
-                (const value_type *)values->buffers[data_buffer_index],
-                enif_make_uint64
-            );
-        } else if (format[0] == 'I') {
-            // NANOARROW_TYPE_UINT32
-            using value_type = uint32_t;
-            term_type = kAdbcColumnTypeU32;
-            if (count == -1) count = values->length;
-            if (values->n_buffers != 2) {
-                error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=I), values->n_buffers != 2");
-                return 1;
-            }
-            current_term = values_from_buffer(
-                env,
-                offset,
-                count,
-                (const uint8_t *)values->buffers[bitmap_buffer_index],
-                (const value_type *)values->buffers[data_buffer_index],
-                enif_make_uint64
-            );
-        } else if (format[0] == 'f') {
-            // NANOARROW_TYPE_FLOAT
-            using value_type = float;
-            term_type = kAdbcColumnTypeF32;
-            if (count == -1) count = values->length;
-            if (values->n_buffers != 2) {
-                error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=f), values->n_buffers != 2");
-                return 1;
-            }
-            current_term = values_from_buffer(
-                env,
-                offset,
-                count,
-                (const uint8_t *)values->buffers[bitmap_buffer_index],
-                (const value_type *)values->buffers[data_buffer_index],
-                enif_make_double
-            );
-        } else if (format[0] == 'g') {
-            // NANOARROW_TYPE_DOUBLE
-            using value_type = double;
-            term_type = kAdbcColumnTypeF64;
-            if (count == -1) count = values->length;
-            if (values->n_buffers != 2) {
-                error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=g), values->n_buffers != 2");
-                return 1;
-            }
-            current_term = values_from_buffer(
-                env,
-                offset,
-                count,
-                (const uint8_t *)values->buffers[bitmap_buffer_index],
-                (const value_type *)values->buffers[data_buffer_index],
-                enif_make_double
-            );
-        } else if (format[0] == 'b') {
+    if (schema->dictionary != nullptr) {
+        // the format is the one of the indices
+        if (arrow_dictionary_to_nif_term(env, schema, values, offset, count, level, current_term, term_type, error, context) == 1) {
+            return 1;
+        }
+    } else if (int primitive = adbc_primitive_index_of_format(format); primitive >= 0) {
+        // NANOARROW_TYPE_INT8 to NANOARROW_TYPE_INT64
+        // NANOARROW_TYPE_UINT8 to NANOARROW_TYPE_UINT64
+        // NANOARROW_TYPE_FLOAT
+        // NANOARROW_TYPE_DOUBLE
+        term_type = *kAdbcPrimitiveColumnTypes[primitive];
+        if (count == -1) count = values->length;
+        if (values->n_buffers != 2) {
+            error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray of a fixed-width type, values->n_buffers != 2");
+            return 1;
+        }
+        current_term = kPrimitiveDecoders[primitive](
+            env,
+            offset,
+            count,
+            arrow_array_validity(values),
+            values->buffers[data_buffer_index]
+        );
+    } else if (format_len == 1) {
+        if (format[0] == 'b') {
             // NANOARROW_TYPE_BOOL
-            using value_type = bool;
             term_type = kAdbcColumnTypeBool;
             if (count == -1) count = values->length;
             if (values->n_buffers != 2) {
                 error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=b), values->n_buffers != 2");
                 return 1;
             }
-            current_term = values_from_buffer(
+            current_term = booleans_from_buffer(
                 env,
                 offset,
                 count,
-                (const uint8_t *)values->buffers[bitmap_buffer_index],
-                (const value_type *)values->buffers[data_buffer_index],
-                [](ErlNifEnv *env, bool val) -> ERL_NIF_TERM {
-                    if (val) {
-                        return kAtomTrue;
-                    }
-                    return kAtomFalse;
-                }
+                arrow_array_validity(values),
+                (const uint8_t *)values->buffers[data_buffer_index]
             );
         } else if (format[0] == 'u' || format[0] == 'z') {
             // NANOARROW_TYPE_BINARY
@@ -683,17 +1350,7 @@ int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct
                 error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=u or format=z), values->n_buffers != 3");
                 return 1;
             }
-            current_term = strings_from_buffer(
-                env,
-                offset,
-                count,
-                (const uint8_t *)values->buffers[bitmap_buffer_index],
-                (const int32_t *)values->buffers[offset_buffer_index],
-                (const uint8_t *)values->buffers[data_buffer_index],
-                [](ErlNifEnv *env, const uint8_t * string_buffers, int32_t offset, size_t nbytes) -> ERL_NIF_TERM {
-                    return erlang::nif::make_binary(env, (const char *)(string_buffers + offset), nbytes);
-                }
-            );
+            current_term = strings_to_nif_term<int32_t>(env, values, offset, count, bitmap_buffer_index, offset_buffer_index, data_buffer_index, context);
         } else if (format[0] == 'U' || format[0] == 'Z') {
             // NANOARROW_TYPE_LARGE_STRING
             // NANOARROW_TYPE_LARGE_BINARY
@@ -709,17 +1366,7 @@ int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct
                 error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=U or format=Z), values->n_buffers != 3");
                 return 1;
             }
-            current_term = strings_from_buffer(
-                env,
-                offset,
-                count,
-                (const uint8_t *)values->buffers[bitmap_buffer_index],
-                (const int64_t *)values->buffers[offset_buffer_index],
-                (const uint8_t *)values->buffers[data_buffer_index],
-                [](ErlNifEnv *env, const uint8_t * string_buffers, int64_t offset, size_t nbytes) -> ERL_NIF_TERM {
-                    return erlang::nif::make_binary(env, (const char *)(string_buffers + offset), nbytes);
-                }
-            );
+            current_term = strings_to_nif_term<int64_t>(env, values, offset, count, bitmap_buffer_index, offset_buffer_index, data_buffer_index, context);
         } else {
             format_processed = false;
         }
@@ -742,6 +1389,22 @@ int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct
                 }
                 children_term = kAtomEndOfSeries;
             }
+        } else if (strncmp("vu", format, 2) == 0 || strncmp("vz", format, 2) == 0) {
+            // NANOARROW_TYPE_STRING_VIEW
+            // NANOARROW_TYPE_BINARY_VIEW
+            // views hold the same values as the classic layouts, so they
+            // are returned with the same types
+            term_type = format[1] == 'u' ? kAdbcColumnTypeString : kAdbcColumnTypeBinary;
+            if (count == -1) count = values->length;
+            if (string_views_to_nif_term(env, values, offset, count, context, current_term, error) == 1) {
+                return 1;
+            }
+        } else if (strncmp("+r", format, 2) == 0) {
+            // NANOARROW_TYPE_RUN_END_ENCODED
+            // the type is the one of the values
+            if (arrow_run_end_encoded_to_nif_term(env, schema, values, offset, count, level, children_term, term_type, error, context) == 1) {
+                return 1;
+            }
         } else if (strncmp("+m", format, 2) == 0) {
             // NANOARROW_TYPE_MAP
             term_type = kAdbcColumnTypeMap;
@@ -777,6 +1440,27 @@ int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct
             // NANOARROW_TYPE_SPARSE_UNION
             term_type = kAdbcColumnTypeSparseUnion;
             children_term = get_arrow_array_sparse_union_children(env, schema, values, offset, count, level);
+        } else if (strncmp("d:", format, 2) == 0) {
+            // NANOARROW_TYPE_DECIMAL128
+            // NANOARROW_TYPE_DECIMAL256
+            struct ArrowSchemaView schema_view{};
+            struct ArrowError na_error{};
+            if (ArrowSchemaViewInit(&schema_view, schema, &na_error) != NANOARROW_OK) {
+                error = erlang::nif::error(env, na_error.message);
+                return 1;
+            }
+            if (values->n_buffers != 2) {
+                error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=d), values->n_buffers != 2");
+                return 1;
+            }
+            if (count == -1) count = values->length;
+            term_type = enif_make_tuple4(env,
+                kAtomDecimal,
+                enif_make_int(env, schema_view.decimal_bitwidth),
+                enif_make_int(env, schema_view.decimal_precision),
+                enif_make_int(env, schema_view.decimal_scale)
+            );
+            current_term = decimals_from_buffer(env, values, offset, count, schema_view);
         } else if (strncmp("td", format, 2) == 0) {
             char unit = format[2];
 
@@ -793,28 +1477,22 @@ int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct
                     kAtomDayKey,
                 };
 
-                auto convert = [unit, date_module, calendar_iso, &keys](ErlNifEnv *env, uint64_t val) -> ERL_NIF_TERM {
-                    uint64_t seconds;
-                    if (unit == 'D') {
-                        seconds = val * 24 * 60 * 60; // days
-                    } else {
-                        seconds = val / 1000; // milliseconds
-                    }
-                    time_t t = (time_t)seconds;
-                    tm* time = gmtime(&t);
+                auto convert = [unit, date_module, calendar_iso, &keys](ErlNifEnv *env, int64_t val) -> ERL_NIF_TERM {
+                    // days or milliseconds since the epoch
+                    CivilDate date = civil_from_days(unit == 'D' ? val : floor_div(val, kMillisecondsPerDay));
                     ERL_NIF_TERM ex_date;
                     ERL_NIF_TERM values[] = {
                         date_module,
                         calendar_iso,
-                        enif_make_int(env, time->tm_year + 1900),
-                        enif_make_int(env, time->tm_mon + 1),
-                        enif_make_int(env, time->tm_mday)
+                        enif_make_int64(env, date.year),
+                        enif_make_uint(env, date.month),
+                        enif_make_uint(env, date.day)
                     };
                     enif_make_map_from_arrays(env, keys, values, 5, &ex_date);
                     return ex_date;
                 };
                 if (unit == 'D') {
-                    using value_type = uint32_t;
+                    using value_type = int32_t;
                     term_type = kAdbcColumnTypeDate32;
                     if (count == -1) count = values->length;
                     if (values->n_buffers != 2) {
@@ -825,12 +1503,12 @@ int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct
                         env,
                         offset,
                         count,
-                        (const uint8_t *)values->buffers[bitmap_buffer_index],
+                        arrow_array_validity(values),
                         (const value_type *)values->buffers[data_buffer_index],
                         convert
                     );
                 } else {
-                    using value_type = uint64_t;
+                    using value_type = int64_t;
                     term_type = kAdbcColumnTypeDate64;
                     if (count == -1) count = values->length;
                     if (values->n_buffers != 2) {
@@ -841,7 +1519,7 @@ int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct
                         env,
                         offset,
                         count,
-                        (const uint8_t *)values->buffers[bitmap_buffer_index],
+                        arrow_array_validity(values),
                         (const value_type *)values->buffers[data_buffer_index],
                         convert
                     );
@@ -851,30 +1529,26 @@ int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct
             }
         // time
         } else if (strncmp("tt", format, 2) == 0) {
-            uint64_t unit;
+            char unit = format[2];
             uint8_t us_precision;
-            switch (format[2]) {
+            switch (unit) {
                 case 's': // seconds
                     // NANOARROW_TYPE_TIME32
-                    unit = 1000000000;
                     us_precision = 0;
                     term_type = kAdbcColumnTypeTime32Seconds;
                     break;
                 case 'm': // milliseconds
                     // NANOARROW_TYPE_TIME32
-                    unit = 1000000;
                     us_precision = 3;
                     term_type = kAdbcColumnTypeTime32Milliseconds;
                     break;
                 case 'u': // microseconds
                     // NANOARROW_TYPE_TIME64
-                    unit = 1000;
                     us_precision = 6;
                     term_type = kAdbcColumnTypeTime64Microseconds;
                     break;
                 case 'n': // nanoseconds
                     // NANOARROW_TYPE_TIME64
-                    unit = 1;
                     us_precision = 6;
                     term_type = kAdbcColumnTypeTime64Nanoseconds;
                     break;
@@ -883,7 +1557,6 @@ int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct
             }
 
             if (format_processed) {
-                using value_type = uint64_t;
                 if (count == -1) count = values->length;
                 if (values->n_buffers != 2) {
                     error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=tt), values->n_buffers != 2");
@@ -902,58 +1575,64 @@ int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct
                 ERL_NIF_TERM time_module = kAtomTimeModule;
                 ERL_NIF_TERM calendar_iso = kAtomCalendarISO;
 
-                current_term = values_from_buffer(
-                    env,
-                    offset,
-                    count,
-                    (const uint8_t *)values->buffers[bitmap_buffer_index],
-                    (const value_type *)values->buffers[data_buffer_index],
-                    [unit, us_precision, time_module, calendar_iso, &keys](ErlNifEnv *env, uint64_t val) -> ERL_NIF_TERM {
-                        // Elixir only supports microsecond precision
-                        uint64_t us = val * unit / 1000;
-                        time_t s = (time_t)(us / 1000000);
-                        tm* time = gmtime(&s);
-                        us = us % 1000000;
-
-                        ERL_NIF_TERM ex_time;
-                        ERL_NIF_TERM values[] = {
-                            time_module,
-                            calendar_iso,
-                            enif_make_int(env, time->tm_hour),
-                            enif_make_int(env, time->tm_min),
-                            enif_make_int(env, time->tm_sec),
-                            enif_make_tuple2(env, enif_make_int(env, us), enif_make_int(env, us_precision))
-                        };
-                        enif_make_map_from_arrays(env, keys, values, 6, &ex_time);
-                        return ex_time;
-                    }
-              );
+                auto convert = [unit, us_precision, time_module, calendar_iso, &keys](ErlNifEnv *env, int64_t val) -> ERL_NIF_TERM {
+                    CivilTime time = civil_time_from_microseconds(to_microseconds(val, unit));
+
+                    ERL_NIF_TERM ex_time;
+                    ERL_NIF_TERM values[] = {
+                        time_module,
+                        calendar_iso,
+                        enif_make_uint(env, time.hour),
+                        enif_make_uint(env, time.minute),
+                        enif_make_uint(env, time.second),
+                        enif_make_tuple2(env, enif_make_uint(env, time.microsecond), enif_make_int(env, us_precision))
+                    };
+                    enif_make_map_from_arrays(env, keys, values, 6, &ex_time);
+                    return ex_time;
+                };
+
+                // time32 values are 32-bit wide, time64 values 64-bit wide
+                if (unit == 's' || unit == 'm') {
+                    current_term = values_from_buffer(
+                        env,
+                        offset,
+                        count,
+                        arrow_array_validity(values),
+                        (const int32_t *)values->buffers[data_buffer_index],
+                        convert
+                    );
+                } else {
+                    current_term = values_from_buffer(
+                        env,
+                        offset,
+                        count,
+                        arrow_array_validity(values),
+                        (const int64_t *)values->buffers[data_buffer_index],
+                        convert
+                    );
+                }
             }
         // timestamp
         } else if (strncmp("ts", format, 2) == 0) {
             // NANOARROW_TYPE_TIMESTAMP
-            uint64_t unit;
+            char unit = format[2];
             uint8_t us_precision;
             ERL_NIF_TERM term_unit;
             ERL_NIF_TERM term_timezone = kAtomNil;
-            switch (format[2]) {
+            switch (unit) {
                 case 's': // seconds
-                    unit = 1000000000;
                     us_precision = 0;
                     term_unit = kAtomSeconds;
                     break;
                 case 'm': // milliseconds
-                    unit = 1000000;
                     us_precision = 3;
                     term_unit = kAtomMilliseconds;
                     break;
                 case 'u': // microseconds
-                    unit = 1000;
                     us_precision = 6;
                     term_unit = kAtomMicroseconds;
                     break;
                 case 'n': // nanoseconds
-                    unit = 1;
                     us_precision = 6;
                     term_unit = kAtomNanoseconds;
                     break;
@@ -967,59 +1646,70 @@ int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct
                     term_timezone = erlang::nif::make_binary(env, timezone);
                 }
                 term_type = enif_make_tuple3(env, kAtomTimestamp, term_unit, term_timezone);
-                
-                using value_type = uint64_t;
+
+                using value_type = int64_t;
                 if (count == -1) count = values->length;
                 if (values->n_buffers != 2) {
                     error = erlang::nif::error(env, "invalid n_buffers value for ArrowArray (format=ts), values->n_buffers != 2");
                     return 1;
                 }
 
-                ERL_NIF_TERM naive_dt_module = kAtomNaiveDateTimeModule;
-                ERL_NIF_TERM calendar_iso = kAtomCalendarISO;
-
-                ERL_NIF_TERM keys[] = {
-                    kAtomStructKey,
-                    kAtomCalendarKey,
-                    kAtomYearKey,
-                    kAtomMonthKey,
-                    kAtomDayKey,
-                    kAtomHourKey,
-                    kAtomMinuteKey,
-                    kAtomSecondKey,
-                    kAtomMicrosecondKey,
-                };
+                if (context && context->timezone && format_len > 4) {
+                    current_term = zoned_timestamps_from_buffer(
+                        env,
+                        offset,
+                        count,
+                        arrow_array_validity(values),
+                        (const value_type *)values->buffers[data_buffer_index],
+                        unit,
+                        us_precision,
+                        *context->timezone
+                    );
+                } else {
+                    ERL_NIF_TERM naive_dt_module = kAtomNaiveDateTimeModule;
+                    ERL_NIF_TERM calendar_iso = kAtomCalendarISO;
+
+                    ERL_NIF_TERM keys[] = {
+                        kAtomStructKey,
+                        kAtomCalendarKey,
+                        kAtomYearKey,
+                        kAtomMonthKey,
+                        kAtomDayKey,
+                        kAtomHourKey,
+                        kAtomMinuteKey,
+                        kAtomSecondKey,
+                        kAtomMicrosecondKey,
+                    };
 
-                current_term = values_from_buffer(
-                    env,
-                    offset,
-                    count,
-                    (const uint8_t *)values->buffers[bitmap_buffer_index],
-                    (const value_type *)values->buffers[data_buffer_index],
-                    [unit, us_precision, naive_dt_module, calendar_iso, &keys](ErlNifEnv *env, uint64_t val) -> ERL_NIF_TERM {
-                        // Elixir only supports microsecond precision
-                        uint64_t us = val * unit / 1000;
-                        time_t t = (time_t)(us / 1000000);
-                        tm* time = gmtime(&t);
-                        us = us % 1000000;
-
-                        ERL_NIF_TERM ex_dt;
-                        ERL_NIF_TERM values[] = {
-                            naive_dt_module,
-                            calendar_iso,
-                            enif_make_int(env, time->tm_year + 1900),
-                            enif_make_int(env, time->tm_mon + 1),
-                            enif_make_int(env, time->tm_mday),
-                            enif_make_int(env, time->tm_hour),
-                            enif_make_int(env, time->tm_min),
-                            enif_make_int(env, time->tm_sec),
-                            enif_make_tuple2(env, enif_make_int(env, us), enif_make_int(env, us_precision))
-                        };
-
-                        enif_make_map_from_arrays(env, keys, values, 9, &ex_dt);
-                        return ex_dt;
-                    }
-                );
+                    current_term = values_from_buffer(
+                        env,
+                        offset,
+                        count,
+                        arrow_array_validity(values),
+                        (const value_type *)values->buffers[data_buffer_index],
+                        [unit, us_precision, naive_dt_module, calendar_iso, &keys](ErlNifEnv *env, int64_t val) -> ERL_NIF_TERM {
+                            int64_t us = to_microseconds(val, unit);
+                            CivilDate date = civil_from_days(floor_div(us, kMicrosecondsPerDay));
+                            CivilTime time = civil_time_from_microseconds(us);
+
+                            ERL_NIF_TERM ex_dt;
+                            ERL_NIF_TERM values[] = {
+                                naive_dt_module,
+                                calendar_iso,
+                                enif_make_int64(env, date.year),
+                                enif_make_uint(env, date.month),
+                                enif_make_uint(env, date.day),
+                                enif_make_uint(env, time.hour),
+                                enif_make_uint(env, time.minute),
+                                enif_make_uint(env, time.second),
+                                enif_make_tuple2(env, enif_make_uint(env, time.microsecond), enif_make_int(env, us_precision))
+                            };
+
+                            enif_make_map_from_arrays(env, keys, values, 9, &ex_dt);
+                            return ex_dt;
+                        }
+                    );
+                }
             }
         } else {
             format_processed = false;
@@ -1047,11 +1737,12 @@ int arrow_array_to_nif_term(ErlNifEnv *env, struct ArrowSchema * schema, struct
     if (is_struct) {
         out_terms.emplace_back(children_term);
     } else {
+        ERL_NIF_TERM name_term = context ? context->name : erlang::nif::make_binary(env, name);
         if (schema->children) {
-            out_terms.emplace_back(erlang::nif::make_binary(env, name));
+            out_terms.emplace_back(name_term);
             out_terms.emplace_back(children_term);
         } else {
-            out_terms.emplace_back(erlang::nif::make_binary(env, name));
+            out_terms.emplace_back(name_term);
             out_terms.emplace_back(current_term);
         }
     }
@@ -0,0 +1,240 @@
+#ifndef ADBC_ARROW_CONCAT_HPP
+#define ADBC_ARROW_CONCAT_HPP
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include <nanoarrow/nanoarrow.h>
+
+// Appends `length` bits of `bits` starting at bit `offset` to `buffer`,
+// which already holds `size_bits` bits. A null `bits` appends set bits.
+static ArrowErrorCode arrow_buffer_append_bits(struct ArrowBuffer * buffer, int64_t &size_bits, const uint8_t * bits, int64_t offset, int64_t length) {
+    int64_t new_size_bits = size_bits + length;
+    int64_t new_size_bytes = (new_size_bits + 7) / 8;
+    NANOARROW_RETURN_NOT_OK(ArrowBufferAppendFill(buffer, 0, new_size_bytes - buffer->size_bytes));
+
+    if (bits == nullptr) {
+        ArrowBitsSetTo(buffer->data, size_bits, length, 1);
+    } else if (size_bits % 8 == 0 && offset % 8 == 0) {
+        memcpy(buffer->data + size_bits / 8, bits + offset / 8, (size_t)((length + 7) / 8));
+        // clear the bits past the end, which belong to other values
+        if (new_size_bits % 8 != 0) {
+            buffer->data[new_size_bytes - 1] &= (uint8_t)((1 << (new_size_bits % 8)) - 1);
+        }
+    } else {
+        for (int64_t i = 0; i < length; i++) {
+            if (ArrowBitGet(bits, offset + i)) {
+                ArrowBitSet(buffer->data, size_bits + i);
+            }
+        }
+    }
+
+    size_bits = new_size_bits;
+    return NANOARROW_OK;
+}
+
+template <typename OffsetT>
+static ArrowErrorCode arrow_array_concat_offsets(struct ArrowBuffer * offsets_out, struct ArrowBuffer * data_out, const struct ArrowArray * values, std::string &error) {
+    auto offsets = (const OffsetT *)values->buffers[1] + values->offset;
+    auto data = (const uint8_t *)values->buffers[2];
+    OffsetT base = *((OffsetT *)(offsets_out->data + offsets_out->size_bytes) - 1);
+    OffsetT size = offsets[values->length] - offsets[0];
+    if (size > std::numeric_limits<OffsetT>::max() - base) {
+        error = "the concatenated values do not fit the offsets of the type";
+        return EOVERFLOW;
+    }
+
+    NANOARROW_RETURN_NOT_OK(ArrowBufferReserve(offsets_out, values->length * sizeof(OffsetT)));
+    for (int64_t i = 1; i <= values->length; i++) {
+        OffsetT offset = base + offsets[i] - offsets[0];
+        ArrowBufferAppendUnsafe(offsets_out, &offset, sizeof(OffsetT));
+    }
+    if (size > 0) {
+        NANOARROW_RETURN_NOT_OK(ArrowBufferAppend(data_out, data + offsets[0], size));
+    }
+    return NANOARROW_OK;
+}
+
+/// Whether arrays of `schema` can be concatenated by `arrow_array_concat`.
+static bool arrow_array_concat_supported(struct ArrowSchema * schema) {
+    struct ArrowSchemaView schema_view{};
+    if (schema->n_children != 0 || schema->dictionary != nullptr ||
+        ArrowSchemaViewInit(&schema_view, schema, nullptr) != NANOARROW_OK) {
+        return false;
+    }
+    const struct ArrowLayout &layout = schema_view.layout;
+    bool fixed_width = layout.buffer_type[1] == NANOARROW_BUFFER_TYPE_DATA && layout.buffer_type[2] == NANOARROW_BUFFER_TYPE_NONE;
+    bool variable_width = layout.buffer_type[1] == NANOARROW_BUFFER_TYPE_DATA_OFFSET && layout.buffer_type[2] == NANOARROW_BUFFER_TYPE_DATA;
+    return layout.buffer_type[0] == NANOARROW_BUFFER_TYPE_VALIDITY && (fixed_width || variable_width);
+}
+
+/// Concatenates `arrays` of `schema` into `out`, copying their buffers.
+///
+/// Only arrays without children are supported, that is primitive, string
+/// and binary types, which covers the top-level columns of most results.
+///
+/// Returns 0 on success. On failure, returns 1, `out` is left released and
+/// `error` is set.
+static int arrow_array_concat(struct ArrowSchema * schema, const std::vector<const struct ArrowArray *> &arrays, struct ArrowArray * out, std::string &error) {
+    out->release = nullptr;
+
+    struct ArrowError na_error{};
+    struct ArrowSchemaView schema_view{};
+    if (ArrowSchemaViewInit(&schema_view, schema, &na_error) != NANOARROW_OK) {
+        error = na_error.message;
+        return 1;
+    }
+
+    const struct ArrowLayout &layout = schema_view.layout;
+    bool fixed_width = layout.buffer_type[1] == NANOARROW_BUFFER_TYPE_DATA && layout.buffer_type[2] == NANOARROW_BUFFER_TYPE_NONE;
+    if (!arrow_array_concat_supported(schema)) {
+        error = std::string("cannot concatenate arrays of format ") + (schema->format ? schema->format : "");
+        return 1;
+    }
+
+    if (ArrowArrayInitFromSchema(out, schema, &na_error) != NANOARROW_OK ||
+        ArrowArrayStartAppending(out) != NANOARROW_OK) {
+        if (out->release) out->release(out);
+        error = na_error.message;
+        return 1;
+    }
+
+    bool has_nulls = false;
+    for (auto values : arrays) {
+        if (values->null_count != 0 && values->buffers[0] != nullptr) {
+            has_nulls = true;
+        }
+    }
+
+    struct ArrowBitmap * validity = ArrowArrayValidityBitmap(out);
+    struct ArrowBuffer * data = ArrowArrayBuffer(out, 1);
+    int64_t data_size_bits = 0;
+    int64_t length = 0, null_count = 0;
+    int code = NANOARROW_OK;
+    for (auto values : arrays) {
+        if (values->length == 0) continue;
+
+        if (has_nulls) {
+            auto bits = (const uint8_t *)values->buffers[0];
+            code = arrow_buffer_append_bits(&validity->buffer, validity->size_bits, bits, values->offset, values->length);
+            if (code != NANOARROW_OK) break;
+            if (bits != nullptr) {
+                null_count += values->length - ArrowBitCountSet(bits, values->offset, values->length);
+            }
+        }
+
+        if (fixed_width && layout.element_size_bits[1] == 1) {
+            code = arrow_buffer_append_bits(data, data_size_bits, (const uint8_t *)values->buffers[1], values->offset, values->length);
+        } else if (fixed_width) {
+            int64_t width = layout.element_size_bits[1] / 8;
+            code = ArrowBufferAppend(data, (const uint8_t *)values->buffers[1] + values->offset * width, values->length * width);
+        } else if (layout.element_size_bits[1] == 32) {
+            code = arrow_array_concat_offsets<int32_t>(data, ArrowArrayBuffer(out, 2), values, error);
+        } else {
+            code = arrow_array_concat_offsets<int64_t>(data, ArrowArrayBuffer(out, 2), values, error);
+        }
+        if (code != NANOARROW_OK) break;
+
+        length += values->length;
+    }
+
+    if (code == NANOARROW_OK) {
+        out->length = length;
+        out->null_count = null_count;
+        code = ArrowArrayFinishBuildingDefault(out, &na_error);
+        if (code != NANOARROW_OK) error = na_error.message;
+    } else if (error.empty()) {
+        error = "cannot allocate memory to concatenate arrays";
+    }
+
+    if (code != NANOARROW_OK) {
+        out->release(out);
+        return 1;
+    }
+    return 0;
+}
+
+// Private data of a record batch concatenated by `arrow_batch_concat`,
+// which owns its columns.
+struct ConcatenatedBatch {
+    std::vector<struct ArrowArray> columns;
+    std::vector<struct ArrowArray *> children;
+    const void * buffers[1] = {nullptr};
+};
+
+static void arrow_batch_concatenated_free(ConcatenatedBatch * data) {
+    for (auto &column : data->columns) {
+        if (column.release) column.release(&column);
+    }
+    delete data;
+}
+
+static void arrow_batch_concatenated_release(struct ArrowArray * array) {
+    arrow_batch_concatenated_free((ConcatenatedBatch *)array->private_data);
+    array->private_data = nullptr;
+    array->release = nullptr;
+}
+
+/// Whether record batches of `schema` can be concatenated by
+/// `arrow_batch_concat`, that is when it is a struct of columns supported
+/// by `arrow_array_concat`.
+static bool arrow_batch_concat_supported(struct ArrowSchema * schema) {
+    if (schema->format == nullptr || strcmp(schema->format, "+s") != 0 || schema->dictionary != nullptr) {
+        return false;
+    }
+    for (int64_t i = 0; i < schema->n_children; i++) {
+        if (!arrow_array_concat_supported(schema->children[i])) return false;
+    }
+    return true;
+}
+
+/// Concatenates the record batches `batches` of `schema`, checked by
+/// `arrow_batch_concat_supported`, into `out`, column by column. The
+/// batches must have no offset nor validity of their own.
+///
+/// Returns 0 on success. On failure, returns 1, `out` is left released and
+/// `error` is set.
+static int arrow_batch_concat(struct ArrowSchema * schema, const std::vector<const struct ArrowArray *> &batches, struct ArrowArray * out, std::string &error) {
+    out->release = nullptr;
+
+    auto data = new ConcatenatedBatch();
+    data->columns.resize((size_t)schema->n_children);
+    int64_t length = 0;
+    for (auto batch : batches) {
+        if (batch->n_children != schema->n_children) {
+            error = "cannot concatenate record batches of different columns";
+            arrow_batch_concatenated_free(data);
+            return 1;
+        }
+        length += batch->length;
+    }
+
+    std::vector<const struct ArrowArray *> columns(batches.size());
+    for (int64_t i = 0; i < schema->n_children; i++) {
+        for (size_t j = 0; j < batches.size(); j++) {
+            columns[j] = batches[j]->children[i];
+        }
+        if (arrow_array_concat(schema->children[i], columns, &data->columns[(size_t)i], error) != 0) {
+            arrow_batch_concatenated_free(data);
+            return 1;
+        }
+        data->children.push_back(&data->columns[(size_t)i]);
+    }
+
+    out->length = length;
+    out->null_count = 0;
+    out->offset = 0;
+    out->n_buffers = 1;
+    out->n_children = schema->n_children;
+    out->buffers = data->buffers;
+    out->children = data->children.empty() ? nullptr : data->children.data();
+    out->dictionary = nullptr;
+    out->release = arrow_batch_concatenated_release;
+    out->private_data = data;
+    return 0;
+}
+
+#endif  // ADBC_ARROW_CONCAT_HPP
@@ -0,0 +1,711 @@
+#ifndef ADBC_ARROW_IPC_HPP
+#define ADBC_ARROW_IPC_HPP
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nanoarrow/nanoarrow.h>
+#include "nif_utils.hpp"
+#ifndef OS_WIN
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "adbc_arrow_serialize.hpp"
+#include "adbc_mapped_file.hpp"
+#include "adbc_memory.hpp"
+
+// Reads Arrow IPC files and streams, as written by Arrow, pyarrow, Polars
+// or DuckDB, from a memory mapping of the file.
+//
+// Only the metadata of the messages, which are flatbuffers, is parsed. The
+// arrays of the record batches point into the mapping, so the bytes of the
+// file reach whoever reads the stream, such as the COPY writer of a
+// driver, without being copied or converted.
+//
+// Dictionary-encoded fields, compressed bodies and files written on hosts
+// of the other endianness are not supported, nor are the view and
+// run-end encoded types, which nanoarrow does not support yet.
+
+constexpr char kArrowIpcMagic[] = "ARROW1";
+constexpr uint32_t kArrowIpcContinuation = 0xFFFFFFFF;
+constexpr int kArrowIpcMaxDepth = 64;
+
+// MessageHeader of Message.fbs
+constexpr uint8_t kArrowIpcHeaderSchema = 1;
+constexpr uint8_t kArrowIpcHeaderDictionaryBatch = 2;
+constexpr uint8_t kArrowIpcHeaderRecordBatch = 3;
+
+// Type of Schema.fbs
+enum ArrowIpcType : uint8_t {
+    kArrowIpcTypeNull = 1,
+    kArrowIpcTypeInt = 2,
+    kArrowIpcTypeFloatingPoint = 3,
+    kArrowIpcTypeBinary = 4,
+    kArrowIpcTypeUtf8 = 5,
+    kArrowIpcTypeBool = 6,
+    kArrowIpcTypeDecimal = 7,
+    kArrowIpcTypeDate = 8,
+    kArrowIpcTypeTime = 9,
+    kArrowIpcTypeTimestamp = 10,
+    kArrowIpcTypeInterval = 11,
+    kArrowIpcTypeList = 12,
+    kArrowIpcTypeStruct = 13,
+    kArrowIpcTypeUnion = 14,
+    kArrowIpcTypeFixedSizeBinary = 15,
+    kArrowIpcTypeFixedSizeList = 16,
+    kArrowIpcTypeMap = 17,
+    kArrowIpcTypeDuration = 18,
+    kArrowIpcTypeLargeBinary = 19,
+    kArrowIpcTypeLargeUtf8 = 20,
+    kArrowIpcTypeLargeList = 21,
+};
+
+// A table of a flatbuffer of `size` bytes at `data`, whose accessors check
+// every offset against the bounds of the buffer, as files may come from
+// anywhere.
+struct ArrowIpcTable {
+    const uint8_t * data = nullptr;
+    size_t size = 0;
+    size_t position = 0;
+    size_t vtable = 0;
+    uint16_t vtable_size = 0;
+
+    template <typename T> static bool read(const uint8_t * data, size_t size, size_t position, T &value) {
+        if (position > size || size - position < sizeof(T)) return false;
+        memcpy(&value, data + position, sizeof(T));
+        return true;
+    }
+
+    // Points at the root table of the flatbuffer
+    bool root(const uint8_t * buffer, size_t buffer_size) {
+        uint32_t offset = 0;
+        return read(buffer, buffer_size, 0, offset) && init(buffer, buffer_size, offset);
+    }
+
+    bool init(const uint8_t * buffer, size_t buffer_size, size_t table) {
+        int32_t soffset = 0;
+        if (!read(buffer, buffer_size, table, soffset)) return false;
+        int64_t at = (int64_t)table - soffset;
+        if (at < 0 || !read(buffer, buffer_size, (size_t)at, vtable_size) || vtable_size < 4 ||
+            (size_t)at + vtable_size > buffer_size) {
+            return false;
+        }
+        data = buffer;
+        size = buffer_size;
+        position = table;
+        vtable = (size_t)at;
+        return true;
+    }
+
+    // Returns the position of field `id`, or 0 if it is not set
+    size_t field(int id) const {
+        uint16_t offset = 0;
+        if (4 + 2 * (size_t)id + 2 > vtable_size || !read(data, size, vtable + 4 + 2 * id, offset) || offset == 0) {
+            return 0;
+        }
+        return position + offset;
+    }
+
+    template <typename T> T scalar(int id, T fallback) const {
+        size_t at = field(id);
+        T value = fallback;
+        if (at != 0 && !read(data, size, at, value)) return fallback;
+        return value;
+    }
+
+    // Sets `at` to the position of the object field `id` refers to
+    bool object(int id, size_t &at) const {
+        size_t from = field(id);
+        uint32_t offset = 0;
+        if (from == 0 || !read(data, size, from, offset)) return false;
+        at = from + offset;
+        return at < size;
+    }
+
+    bool table(int id, ArrowIpcTable &out) const {
+        size_t at = 0;
+        return object(id, at) && out.init(data, size, at);
+    }
+
+    bool string(int id, std::string &out) const {
+        size_t at = 0;
+        uint32_t length = 0;
+        if (!object(id, at) || !read(data, size, at, length) || size - at - 4 < length) return false;
+        out.assign((const char *)data + at + 4, length);
+        return true;
+    }
+
+    // Sets `at` to the first of the `length` elements of `element_size`
+    // bytes of the vector field `id`
+    bool vector(int id, size_t element_size, size_t &at, uint32_t &length) const {
+        if (!object(id, at) || !read(data, size, at, length) ||
+            (uint64_t)length * element_size > (uint64_t)(size - at - 4)) {
+            return false;
+        }
+        at += 4;
+        return true;
+    }
+
+    // Sets `out` to table `i` of the vector of tables starting at `at`
+    bool vector_table(size_t at, uint32_t i, ArrowIpcTable &out) const {
+        uint32_t offset = 0;
+        size_t element = at + 4 * (size_t)i;
+        return read(data, size, element, offset) && out.init(data, size, element + offset);
+    }
+};
+
+static const char * arrow_ipc_time_unit(int16_t unit) {
+    switch (unit) {
+        case 0: return "s";
+        case 1: return "m";
+        case 2: return "u";
+        case 3: return "n";
+        default: return nullptr;
+    }
+}
+
+// Sets `format` to the format string of the type of `field`, or returns
+// false if the type is not supported.
+static bool arrow_ipc_format(const ArrowIpcTable &field, int64_t n_children, std::string &format, int64_t &flags) {
+    uint8_t type_type = field.scalar<uint8_t>(2, 0);
+    ArrowIpcTable type;
+    if (!field.table(3, type)) {
+        // an empty table, all of its fields at their default
+        type = ArrowIpcTable{};
+    }
+    auto int_field = [&](int id, int32_t fallback) { return type.data ? type.scalar<int32_t>(id, fallback) : fallback; };
+    auto short_field = [&](int id, int16_t fallback) { return type.data ? type.scalar<int16_t>(id, fallback) : fallback; };
+
+    switch (type_type) {
+        case kArrowIpcTypeNull: format = "n"; return true;
+        case kArrowIpcTypeBinary: format = "z"; return true;
+        case kArrowIpcTypeUtf8: format = "u"; return true;
+        case kArrowIpcTypeBool: format = "b"; return true;
+        case kArrowIpcTypeLargeBinary: format = "Z"; return true;
+        case kArrowIpcTypeLargeUtf8: format = "U"; return true;
+        case kArrowIpcTypeList: format = "+l"; return true;
+        case kArrowIpcTypeLargeList: format = "+L"; return true;
+        case kArrowIpcTypeStruct: format = "+s"; return true;
+        case kArrowIpcTypeInt: {
+            bool is_signed = type.data ? type.scalar<uint8_t>(1, 0) != 0 : false;
+            switch (int_field(0, 0)) {
+                case 8: format = is_signed ? "c" : "C"; return true;
+                case 16: format = is_signed ? "s" : "S"; return true;
+                case 32: format = is_signed ? "i" : "I"; return true;
+                case 64: format = is_signed ? "l" : "L"; return true;
+                default: return false;
+            }
+        }
+        case kArrowIpcTypeFloatingPoint:
+            switch (short_field(0, 0)) {
+                case 0: format = "e"; return true;
+                case 1: format = "f"; return true;
+                case 2: format = "g"; return true;
+                default: return false;
+            }
+        case kArrowIpcTypeDecimal: {
+            int32_t bit_width = int_field(2, 128);
+            format = "d:" + std::to_string(int_field(0, 0)) + "," + std::to_string(int_field(1, 0));
+            if (bit_width != 128) format += "," + std::to_string(bit_width);
+            return true;
+        }
+        case kArrowIpcTypeDate:
+            format = short_field(0, 1) == 0 ? "tdD" : "tdm";
+            return true;
+        case kArrowIpcTypeTime: {
+            const char * unit = arrow_ipc_time_unit(short_field(0, 1));
+            if (unit == nullptr) return false;
+            format = std::string("tt") + unit;
+            return true;
+        }
+        case kArrowIpcTypeTimestamp: {
+            const char * unit = arrow_ipc_time_unit(short_field(0, 0));
+            if (unit == nullptr) return false;
+            std::string timezone;
+            if (type.data) type.string(1, timezone);
+            format = std::string("ts") + unit + ":" + timezone;
+            return true;
+        }
+        case kArrowIpcTypeDuration: {
+            const char * unit = arrow_ipc_time_unit(short_field(0, 1));
+            if (unit == nullptr) return false;
+            format = std::string("tD") + unit;
+            return true;
+        }
+        case kArrowIpcTypeInterval:
+            switch (short_field(0, 0)) {
+                case 0: format = "tiM"; return true;
+                case 1: format = "tiD"; return true;
+                case 2: format = "tin"; return true;
+                default: return false;
+            }
+        case kArrowIpcTypeFixedSizeBinary:
+            format = "w:" + std::to_string(int_field(0, 0));
+            return true;
+        case kArrowIpcTypeFixedSizeList:
+            format = "+w:" + std::to_string(int_field(0, 0));
+            return true;
+        case kArrowIpcTypeMap:
+            format = "+m";
+            if (type.data && type.scalar<uint8_t>(0, 0) != 0) flags |= ARROW_FLAG_MAP_KEYS_SORTED;
+            return true;
+        case kArrowIpcTypeUnion: {
+            format = short_field(0, 0) == 0 ? "+us:" : "+ud:";
+            size_t at = 0;
+            uint32_t length = 0;
+            if (type.data && type.vector(1, 4, at, length)) {
+                for (uint32_t i = 0; i < length; i++) {
+                    int32_t type_id = 0;
+                    ArrowIpcTable::read(type.data, type.size, at + 4 * i, type_id);
+                    format += (i > 0 ? "," : "") + std::to_string(type_id);
+                }
+            } else {
+                for (int64_t i = 0; i < n_children; i++) {
+                    format += (i > 0 ? "," : "") + std::to_string(i);
+                }
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// Sets the metadata of `schema` to the KeyValue vector field `id` of
+// `table`, if any.
+static int arrow_ipc_metadata(const ArrowIpcTable &table, int id, struct ArrowSchema * schema) {
+    size_t at = 0;
+    uint32_t length = 0;
+    if (!table.vector(id, 4, at, length) || length == 0) return NANOARROW_OK;
+
+    struct ArrowBuffer buffer;
+    int code = ArrowMetadataBuilderInit(&buffer, nullptr);
+    for (uint32_t i = 0; code == NANOARROW_OK && i < length; i++) {
+        ArrowIpcTable pair;
+        std::string key, value;
+        if (!table.vector_table(at, i, pair)) {
+            code = EINVAL;
+            break;
+        }
+        pair.string(0, key);
+        pair.string(1, value);
+        code = ArrowMetadataBuilderAppend(&buffer, {key.data(), (int64_t)key.size()}, {value.data(), (int64_t)value.size()});
+    }
+    if (code == NANOARROW_OK) code = ArrowSchemaSetMetadata(schema, (const char *)buffer.data);
+    ArrowBufferReset(&buffer);
+    return code;
+}
+
+static int arrow_ipc_field(const ArrowIpcTable &field, struct ArrowSchema * out, int depth, std::string &error) {
+    if (depth > kArrowIpcMaxDepth) {
+        error = "Arrow IPC schema is nested too deeply";
+        return 1;
+    }
+    std::string name;
+    field.string(0, name);
+    ArrowIpcTable dictionary;
+    if (field.table(4, dictionary)) {
+        error = "dictionary-encoded field " + name + " of Arrow IPC file is not supported";
+        return 1;
+    }
+
+    size_t children_at = 0;
+    uint32_t n_children = 0;
+    if (field.field(5) != 0 && !field.vector(5, 4, children_at, n_children)) {
+        error = "invalid Arrow IPC schema";
+        return 1;
+    }
+    std::string format;
+    int64_t flags = field.scalar<uint8_t>(1, 0) != 0 ? ARROW_FLAG_NULLABLE : 0;
+    if (!arrow_ipc_format(field, n_children, format, flags)) {
+        error = "type of field " + name + " of Arrow IPC file is not supported";
+        return 1;
+    }
+
+    if (ArrowSchemaSetFormat(out, format.c_str()) != NANOARROW_OK ||
+        ArrowSchemaSetName(out, name.c_str()) != NANOARROW_OK ||
+        arrow_ipc_metadata(field, 6, out) != NANOARROW_OK ||
+        ArrowSchemaAllocateChildren(out, n_children) != NANOARROW_OK) {
+        error = "cannot allocate schema of Arrow IPC file";
+        return 1;
+    }
+    out->flags = flags;
+    for (uint32_t i = 0; i < n_children; i++) {
+        ArrowIpcTable child;
+        ArrowSchemaInit(out->children[i]);
+        if (!field.vector_table(children_at, i, child)) {
+            error = "invalid Arrow IPC schema";
+            return 1;
+        }
+        if (arrow_ipc_field(child, out->children[i], depth + 1, error) != 0) return 1;
+    }
+    return 0;
+}
+
+/// Decodes the Schema table `table` into the record batch schema `out`.
+///
+/// Returns 0 on success. On failure, returns 1, `out` is left released and
+/// `error` is set.
+static int arrow_ipc_schema(const ArrowIpcTable &table, struct ArrowSchema * out, std::string &error) {
+    if (table.scalar<int16_t>(0, 0) != 0 || arrow_serialize_endianness() != 1) {
+        error = "Arrow IPC files are only read when written on hosts of the same endianness";
+        return 1;
+    }
+    size_t at = 0;
+    uint32_t n_fields = 0;
+    if (table.field(1) != 0 && !table.vector(1, 4, at, n_fields)) {
+        error = "invalid Arrow IPC schema";
+        return 1;
+    }
+
+    ArrowSchemaInit(out);
+    if (ArrowSchemaSetTypeStruct(out, n_fields) != NANOARROW_OK || arrow_ipc_metadata(table, 2, out) != NANOARROW_OK) {
+        out->release(out);
+        error = "cannot allocate schema of Arrow IPC file";
+        return 1;
+    }
+    for (uint32_t i = 0; i < n_fields; i++) {
+        ArrowIpcTable field;
+        // `ArrowSchemaSetTypeStruct` initialised the children as nulls
+        out->children[i]->release(out->children[i]);
+        ArrowSchemaInit(out->children[i]);
+        if (!table.vector_table(at, i, field)) {
+            out->release(out);
+            error = "invalid Arrow IPC schema";
+            return 1;
+        }
+        if (arrow_ipc_field(field, out->children[i], 1, error) != 0) {
+            out->release(out);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/// A message of an Arrow IPC file: its metadata and the position and size
+/// of its body in the file.
+struct ArrowIpcMessage {
+    ArrowIpcTable header;
+    uint8_t header_type = 0;
+    int64_t body = 0;
+    int64_t body_length = 0;
+};
+
+/// Reads the encapsulated message at `position` of the `size` bytes of
+/// `data` into `message`, and sets `next` to the position after its body.
+/// Sets `header_type` to 0 at the end-of-stream marker or at the end of
+/// the data.
+static int arrow_ipc_read_message(const uint8_t * data, int64_t size, int64_t position, ArrowIpcMessage &message, int64_t &next, std::string &error) {
+    message = ArrowIpcMessage{};
+    uint32_t marker = 0;
+    if (position == size) return 0;
+    if (!ArrowIpcTable::read(data, (size_t)size, (size_t)position, marker)) {
+        error = "truncated Arrow IPC message";
+        return 1;
+    }
+    int32_t length = (int32_t)marker;
+    position += 4;
+    // messages written before Arrow 0.15 have no continuation marker
+    if (marker == kArrowIpcContinuation) {
+        if (!ArrowIpcTable::read(data, (size_t)size, (size_t)position, length)) {
+            error = "truncated Arrow IPC message";
+            return 1;
+        }
+        position += 4;
+    }
+    if (length == 0) return 0;
+    if (length < 0 || length > size - position) {
+        error = "truncated Arrow IPC message";
+        return 1;
+    }
+
+    ArrowIpcTable root;
+    if (!root.root(data + position, (size_t)length)) {
+        error = "invalid Arrow IPC message";
+        return 1;
+    }
+    message.header_type = root.scalar<uint8_t>(1, 0);
+    message.body_length = root.scalar<int64_t>(3, 0);
+    message.body = position + length;
+    if (!root.table(2, message.header) || message.body_length < 0 || message.body_length > size - message.body) {
+        error = "invalid Arrow IPC message";
+        return 1;
+    }
+    next = message.body + message.body_length;
+    return 0;
+}
+
+/// Where the record batches of an Arrow IPC file are, and the schema of
+/// the file, as read by `arrow_ipc_open`.
+struct ArrowIpcFile {
+    std::shared_ptr<MappedFile> file;
+    struct ArrowSchema schema{};
+    std::vector<ArrowIpcMessage> batches;
+
+    ArrowIpcFile() = default;
+    ArrowIpcFile(const ArrowIpcFile&) = delete;
+    ArrowIpcFile& operator=(const ArrowIpcFile&) = delete;
+
+    ~ArrowIpcFile() {
+        if (schema.release) schema.release(&schema);
+    }
+};
+
+// Reads the messages from `position` to the end of the stream, as is
+// done for both files and streams, as files start with a stream.
+static int arrow_ipc_read_messages(ArrowIpcFile &ipc, int64_t position, int64_t end, std::string &error) {
+    const uint8_t * data = ipc.file->data;
+    while (position < end) {
+        ArrowIpcMessage message;
+        int64_t next = end;
+        if (arrow_ipc_read_message(data, end, position, message, next, error) != 0) return 1;
+        if (message.header_type == 0) break;
+
+        if (message.header_type == kArrowIpcHeaderSchema) {
+            if (ipc.schema.release != nullptr) {
+                error = "Arrow IPC stream has more than one schema";
+                return 1;
+            }
+            if (arrow_ipc_schema(message.header, &ipc.schema, error) != 0) return 1;
+        } else if (message.header_type == kArrowIpcHeaderRecordBatch) {
+            if (ipc.schema.release == nullptr) {
+                error = "Arrow IPC stream has a record batch before its schema";
+                return 1;
+            }
+            ipc.batches.push_back(message);
+        } else if (message.header_type == kArrowIpcHeaderDictionaryBatch) {
+            error = "dictionaries of Arrow IPC files are not supported";
+            return 1;
+        }
+        position = next;
+    }
+    if (ipc.schema.release == nullptr) {
+        error = "Arrow IPC stream has no schema";
+        return 1;
+    }
+    return 0;
+}
+
+/// Maps the Arrow IPC file or stream at `path` and reads its schema and
+/// the metadata of its record batches into `ipc`.
+///
+/// Returns 0 on success. On failure, returns 1 and `error` is set.
+static int arrow_ipc_open(const std::string &path, ArrowIpcFile &ipc, std::string &error) {
+#ifdef OS_WIN
+    (void)path;
+    (void)ipc;
+    error = "memory-mapped files are not supported on this platform";
+    return 1;
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        error = "cannot open " + path + ": " + strerror(errno);
+        return 1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        error = "cannot open " + path + ": " + strerror(errno);
+        close(fd);
+        return 1;
+    }
+    int code = map_file(fd, (int64_t)info.st_size, adbc_memory_stats.mapped_files, adbc_memory_stats.mapped_file_bytes, ipc.file, error);
+    close(fd);
+    if (code != 0) return 1;
+
+    // a file is a stream between magic strings, followed by its footer,
+    // which is skipped as the messages are read in order
+    const uint8_t * data = ipc.file->data;
+    int64_t size = ipc.file->size;
+    size_t magic = sizeof(kArrowIpcMagic) - 1;
+    int64_t start = 0, end = size;
+    if (size >= 12 && memcmp(data, kArrowIpcMagic, magic) == 0) {
+        int32_t footer = 0;
+        if (memcmp(data + size - magic, kArrowIpcMagic, magic) != 0 ||
+            !ArrowIpcTable::read(data, (size_t)size, (size_t)(size - magic - 4), footer) ||
+            footer < 0 || footer > size - 8 - (int64_t)magic - 4) {
+            error = "invalid Arrow IPC file " + path;
+            return 1;
+        }
+        start = 8;
+        end = size - (int64_t)magic - 4 - footer;
+    }
+    if (arrow_ipc_read_messages(ipc, start, end, error) != 0) {
+        error += " in " + path;
+        return 1;
+    }
+    return 0;
+#endif
+}
+
+// Sets `node` to where the buffers of the array `view` are in the body
+// of `message`, consuming its field nodes and buffers from `next_node`
+// and `next_buffer`.
+static int arrow_ipc_node(const ArrowIpcFile &ipc, const ArrowIpcMessage &message, const struct ArrowArrayView * view, MappedArrayNode &node, uint32_t &next_node, uint32_t &next_buffer) {
+    const ArrowIpcTable &batch = message.header;
+    size_t nodes = 0, buffers = 0;
+    uint32_t n_nodes = 0, n_buffers = 0;
+    // FieldNode and Buffer are structs of two longs
+    if (!batch.vector(1, 16, nodes, n_nodes) || next_node >= n_nodes) return 1;
+    if (batch.field(2) != 0 && !batch.vector(2, 16, buffers, n_buffers)) return 1;
+
+    ArrowIpcTable::read(batch.data, batch.size, nodes + 16 * next_node, node.length);
+    ArrowIpcTable::read(batch.data, batch.size, nodes + 16 * next_node + 8, node.null_count);
+    next_node++;
+    if (node.length < 0 || node.null_count < 0 || node.null_count > node.length) return 1;
+    // nanoarrow computes the sizes the buffers need from the length, which
+    // must not overflow for its checks to hold
+    if (node.length == INT64_MAX) return 1;
+    int64_t list_size = view->layout.child_size_elements;
+    if (list_size > 0 && node.length > INT64_MAX / list_size) return 1;
+    for (int i = 0; i < NANOARROW_MAX_FIXED_BUFFERS; i++) {
+        int64_t width = view->layout.element_size_bits[i];
+        if (width > 0 && node.length + 1 > INT64_MAX / width) return 1;
+    }
+
+    for (int i = 0; i < NANOARROW_MAX_FIXED_BUFFERS; i++) {
+        if (view->layout.buffer_type[i] == NANOARROW_BUFFER_TYPE_NONE) break;
+        if (next_buffer >= n_buffers) return 1;
+        int64_t offset = 0, length = 0;
+        ArrowIpcTable::read(batch.data, batch.size, buffers + 16 * next_buffer, offset);
+        ArrowIpcTable::read(batch.data, batch.size, buffers + 16 * next_buffer + 8, length);
+        next_buffer++;
+        if (offset < 0 || length < 0 || offset > message.body_length || length > message.body_length - offset) return 1;
+        // the format aligns buffers to 8 bytes, which the arrays rely on
+        if ((message.body + offset) % 8 != 0) return 1;
+        // writers omit the validity bitmap of arrays without nulls
+        bool omitted = length == 0 && view->layout.buffer_type[i] == NANOARROW_BUFFER_TYPE_VALIDITY;
+        node.buffers.push_back(omitted ? -1 : message.body + offset);
+        node.sizes.push_back(length);
+    }
+
+    node.children.resize((size_t)view->n_children);
+    for (int64_t i = 0; i < view->n_children; i++) {
+        if (arrow_ipc_node(ipc, message, view->children[i], node.children[i], next_node, next_buffer) != 0) return 1;
+    }
+    return 0;
+}
+
+// Points `view` at `array` made from `node`, with the sizes of its buffers
+// given by the file, which `ArrowArrayViewSetArray` would instead infer
+// from the buffers themselves, trusting their offsets.
+static void arrow_ipc_set_view(struct ArrowArrayView * view, const struct ArrowArray * array, const MappedArrayNode &node) {
+    view->array = array;
+    view->offset = array->offset;
+    view->length = array->length;
+    view->null_count = array->null_count;
+    for (int64_t i = 0; i < array->n_buffers; i++) {
+        view->buffer_views[i].data.data = array->buffers[i];
+        view->buffer_views[i].size_bytes = array->buffers[i] == nullptr ? 0 : node.sizes[i];
+    }
+    for (int64_t i = 0; i < array->n_children; i++) {
+        arrow_ipc_set_view(view->children[i], array->children[i], node.children[i]);
+    }
+}
+
+/// Sets `out` to record batch `i` of `ipc`, over the mapping of the file,
+/// once its buffers are fully validated against the schema.
+///
+/// Returns 0 on success. On failure, returns 1 and `error` is set.
+static int arrow_ipc_batch(const ArrowIpcFile &ipc, size_t i, struct ArrowArray * out, std::string &error) {
+    const ArrowIpcMessage &message = ipc.batches[i];
+    ArrowIpcTable compression;
+    if (message.header.table(3, compression)) {
+        error = "compressed Arrow IPC files are not supported";
+        return 1;
+    }
+
+    struct ArrowError na_error{};
+    struct ArrowArrayView view{};
+    if (ArrowArrayViewInitFromSchema(&view, const_cast<struct ArrowSchema *>(&ipc.schema), &na_error) != NANOARROW_OK) {
+        error = na_error.message;
+        return 1;
+    }
+
+    MappedArrayNode node;
+    uint32_t next_node = 0, next_buffer = 0;
+    // the record batch itself has no field node, but its length
+    node.length = message.header.scalar<int64_t>(0, 0);
+    node.buffers.push_back(-1);
+    node.sizes.push_back(0);
+    node.children.resize((size_t)view.n_children);
+    for (int64_t c = 0; c < view.n_children; c++) {
+        if (arrow_ipc_node(ipc, message, view.children[c], node.children[c], next_node, next_buffer) != 0) {
+            ArrowArrayViewReset(&view);
+            error = "invalid record batch in Arrow IPC file";
+            return 1;
+        }
+    }
+
+    arrow_array_from_mapped_file(ipc.file, node, out);
+    // files may come from anywhere, so offsets are checked as well
+    arrow_ipc_set_view(&view, out, node);
+    if (ArrowArrayViewValidate(&view, NANOARROW_VALIDATION_LEVEL_FULL, &na_error) != NANOARROW_OK) {
+        out->release(out);
+        ArrowArrayViewReset(&view);
+        error = std::string("invalid record batch in Arrow IPC file: ") + na_error.message;
+        return 1;
+    }
+    ArrowArrayViewReset(&view);
+    return 0;
+}
+
+/// State of an ArrowArrayStream over the record batches of an Arrow IPC
+/// file.
+struct ArrowIpcStream {
+    std::unique_ptr<ArrowIpcFile> ipc;
+    size_t next = 0;
+    std::string last_error;
+};
+
+static int arrow_ipc_stream_get_schema(struct ArrowArrayStream * stream, struct ArrowSchema * out) {
+    auto ipc_stream = (ArrowIpcStream *)stream->private_data;
+    return ArrowSchemaDeepCopy(&ipc_stream->ipc->schema, out);
+}
+
+static int arrow_ipc_stream_get_next(struct ArrowArrayStream * stream, struct ArrowArray * out) {
+    auto ipc_stream = (ArrowIpcStream *)stream->private_data;
+    if (ipc_stream->next == ipc_stream->ipc->batches.size()) {
+        out->release = nullptr;
+        return 0;
+    }
+    if (arrow_ipc_batch(*ipc_stream->ipc, ipc_stream->next, out, ipc_stream->last_error) != 0) {
+        return EINVAL;
+    }
+    ipc_stream->next++;
+    return 0;
+}
+
+static const char * arrow_ipc_stream_get_last_error(struct ArrowArrayStream * stream) {
+    auto ipc_stream = (ArrowIpcStream *)stream->private_data;
+    return ipc_stream->last_error.empty() ? nullptr : ipc_stream->last_error.c_str();
+}
+
+static void arrow_ipc_stream_release(struct ArrowArrayStream * stream) {
+    delete (ArrowIpcStream *)stream->private_data;
+    stream->private_data = nullptr;
+    stream->release = nullptr;
+}
+
+/// Makes `stream` a stream over the record batches of the Arrow IPC file
+/// or stream at `path`. The file stays mapped until the stream and the
+/// arrays it returned are released.
+///
+/// Returns 0 on success. On failure, returns 1 and `error` is set.
+static int arrow_array_stream_from_ipc_file(struct ArrowArrayStream * stream, const std::string &path, std::string &error) {
+    auto ipc = std::unique_ptr<ArrowIpcFile>(new ArrowIpcFile());
+    if (arrow_ipc_open(path, *ipc, error) != 0) return 1;
+
+    stream->get_schema = arrow_ipc_stream_get_schema;
+    stream->get_next = arrow_ipc_stream_get_next;
+    stream->get_last_error = arrow_ipc_stream_get_last_error;
+    stream->release = arrow_ipc_stream_release;
+    stream->private_data = new ArrowIpcStream{std::move(ipc), 0, {}};
+    return 0;
+}
+
+#endif  // ADBC_ARROW_IPC_HPP
@@ -0,0 +1,169 @@
+#ifndef ADBC_ARROW_MATRIX_HPP
+#define ADBC_ARROW_MATRIX_HPP
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <nanoarrow/nanoarrow.h>
+
+// Numeric columns of a result are stacked into a single matrix binary, as
+// read by `Nx.from_binary/2`, by writing the values of each column of each
+// record batch straight into it, cast to the type of the matrix. Cells are
+// laid out row after row, or column after column, and the nulls of columns
+// are either NaN, for float matrices, or flagged in a mask of one byte per
+// cell, where their value is 0.
+
+/// The element type of a matrix, as the `{:f, 32}` types of Nx.
+struct ArrowMatrixType {
+    // 'f' for floats, 's' for signed and 'u' for unsigned integers
+    char kind = 'f';
+    int bits = 64;
+
+    bool valid() const {
+        if (kind == 'f') return bits == 32 || bits == 64;
+        return (kind == 's' || kind == 'u') && (bits == 8 || bits == 16 || bits == 32 || bits == 64);
+    }
+
+    int64_t width() const { return bits / 8; }
+};
+
+/// Where the values of a column of a batch are written in a matrix.
+struct ArrowMatrixTarget {
+    uint8_t * data = nullptr;
+    // one byte per cell, or null when nulls are NaN
+    uint8_t * mask = nullptr;
+    // the index of the cell of the first value, and the number of cells
+    // from a value to the next
+    int64_t start = 0;
+    int64_t stride = 1;
+};
+
+// Returns whether `format` is a column that can be stacked: booleans,
+// integers and floats, half floats excepted.
+static bool arrow_matrix_column_supported(const char * format) {
+    return format != nullptr && format[0] != '\0' && format[1] == '\0' && strchr("bcCsSiIlLfg", format[0]) != nullptr;
+}
+
+// Checks that the column `name` of `schema` can be written as `type`.
+//
+// Returns 0 on success. On failure, returns 1 and `error` is set.
+static int arrow_matrix_check_column(const struct ArrowSchema * schema, const ArrowMatrixType &type, std::string &error) {
+    const char * name = schema->name ? schema->name : "";
+    if (schema->dictionary != nullptr || !arrow_matrix_column_supported(schema->format)) {
+        error = std::string("column `") + name + "` of format `" + (schema->format ? schema->format : "") + "` is not a numeric column";
+        return 1;
+    }
+    // floats do not convert to integers without losing their fraction, or
+    // at all when NaN or out of range
+    if (type.kind != 'f' && (schema->format[0] == 'f' || schema->format[0] == 'g')) {
+        error = std::string("cannot write float column `") + name + "` to an integer matrix";
+        return 1;
+    }
+    return 0;
+}
+
+template <typename Dst>
+static void arrow_matrix_write_null(const ArrowMatrixTarget &target, int64_t cell) {
+    Dst value = target.mask == nullptr ? std::numeric_limits<Dst>::quiet_NaN() : Dst{};
+    memcpy(target.data + cell * (int64_t)sizeof(Dst), &value, sizeof(Dst));
+    if (target.mask != nullptr) target.mask[cell] = 1;
+}
+
+// Writes the `length` values of `values` from `offset`, whose nulls are in
+// `validity` when not null, to `target` as `Dst`.
+template <typename Dst, typename Src>
+static void arrow_matrix_write_values(const Src * values, const uint8_t * validity, int64_t offset, int64_t length, const ArrowMatrixTarget &target) {
+    auto data = (Dst *)target.data;
+    values += offset;
+    int64_t cell = target.start;
+    if (validity == nullptr && target.stride == 1 && std::is_same<Dst, Src>::value) {
+        memcpy(data + cell, values, (size_t)length * sizeof(Dst));
+        return;
+    }
+    for (int64_t i = 0; i < length; i++, cell += target.stride) {
+        if (validity != nullptr && !ArrowBitGet(validity, offset + i)) {
+            arrow_matrix_write_null<Dst>(target, cell);
+        } else {
+            data[cell] = static_cast<Dst>(values[i]);
+        }
+    }
+}
+
+template <typename Dst>
+static void arrow_matrix_write_booleans(const uint8_t * values, const uint8_t * validity, int64_t offset, int64_t length, const ArrowMatrixTarget &target) {
+    auto data = (Dst *)target.data;
+    int64_t cell = target.start;
+    for (int64_t i = 0; i < length; i++, cell += target.stride) {
+        if (validity != nullptr && !ArrowBitGet(validity, offset + i)) {
+            arrow_matrix_write_null<Dst>(target, cell);
+        } else {
+            data[cell] = static_cast<Dst>(ArrowBitGet(values, offset + i) ? 1 : 0);
+        }
+    }
+}
+
+template <typename Dst>
+static void arrow_matrix_write_column_as(char format, const uint8_t * validity, const void * values, int64_t offset, int64_t length, const ArrowMatrixTarget &target) {
+    switch (format) {
+    case 'b': arrow_matrix_write_booleans<Dst>((const uint8_t *)values, validity, offset, length, target); break;
+    case 'c': arrow_matrix_write_values<Dst>((const int8_t *)values, validity, offset, length, target); break;
+    case 'C': arrow_matrix_write_values<Dst>((const uint8_t *)values, validity, offset, length, target); break;
+    case 's': arrow_matrix_write_values<Dst>((const int16_t *)values, validity, offset, length, target); break;
+    case 'S': arrow_matrix_write_values<Dst>((const uint16_t *)values, validity, offset, length, target); break;
+    case 'i': arrow_matrix_write_values<Dst>((const int32_t *)values, validity, offset, length, target); break;
+    case 'I': arrow_matrix_write_values<Dst>((const uint32_t *)values, validity, offset, length, target); break;
+    case 'l': arrow_matrix_write_values<Dst>((const int64_t *)values, validity, offset, length, target); break;
+    case 'L': arrow_matrix_write_values<Dst>((const uint64_t *)values, validity, offset, length, target); break;
+    case 'f': arrow_matrix_write_values<Dst>((const float *)values, validity, offset, length, target); break;
+    case 'g': arrow_matrix_write_values<Dst>((const double *)values, validity, offset, length, target); break;
+    }
+}
+
+/// Writes the values of `column`, a top-level child of `batch` of the
+/// format `format` checked by `arrow_matrix_check_column`, to `target` in a
+/// matrix of `type`.
+///
+/// Returns 0 on success. On failure, returns 1 and `error` is set, when the
+/// column has nulls and the matrix has neither NaN nor a mask for them.
+static int arrow_matrix_write_column(const char * format, const struct ArrowArray * batch, const struct ArrowArray * column, const ArrowMatrixType &type, const ArrowMatrixTarget &target, std::string &error) {
+    // the offset of the batch applies to its columns
+    int64_t offset = batch->offset + column->offset;
+    int64_t length = batch->length;
+    int64_t null_count = column->null_count;
+    if (column->buffers[0] == nullptr) {
+        null_count = 0;
+    } else if (null_count < 0) {
+        null_count = length - ArrowBitCountSet((const uint8_t *)column->buffers[0], offset, length);
+    }
+    if (null_count != 0 && type.kind != 'f' && target.mask == nullptr) {
+        error = "integer matrices cannot hold nulls, use a float type or a mask";
+        return 1;
+    }
+    // values are only checked against the validity bitmap when needed
+    auto validity = null_count == 0 ? nullptr : (const uint8_t *)column->buffers[0];
+    const void * values = column->buffers[1];
+    if (type.kind == 'f') {
+        if (type.bits == 32) arrow_matrix_write_column_as<float>(format[0], validity, values, offset, length, target);
+        else arrow_matrix_write_column_as<double>(format[0], validity, values, offset, length, target);
+    } else if (type.kind == 's') {
+        switch (type.bits) {
+        case 8: arrow_matrix_write_column_as<int8_t>(format[0], validity, values, offset, length, target); break;
+        case 16: arrow_matrix_write_column_as<int16_t>(format[0], validity, values, offset, length, target); break;
+        case 32: arrow_matrix_write_column_as<int32_t>(format[0], validity, values, offset, length, target); break;
+        default: arrow_matrix_write_column_as<int64_t>(format[0], validity, values, offset, length, target); break;
+        }
+    } else {
+        switch (type.bits) {
+        case 8: arrow_matrix_write_column_as<uint8_t>(format[0], validity, values, offset, length, target); break;
+        case 16: arrow_matrix_write_column_as<uint16_t>(format[0], validity, values, offset, length, target); break;
+        case 32: arrow_matrix_write_column_as<uint32_t>(format[0], validity, values, offset, length, target); break;
+        default: arrow_matrix_write_column_as<uint64_t>(format[0], validity, values, offset, length, target); break;
+        }
+    }
+    return 0;
+}
+
+#endif  // ADBC_ARROW_MATRIX_HPP
@@ -0,0 +1,612 @@
+#ifndef ADBC_ARROW_SERIALIZE_HPP
+#define ADBC_ARROW_SERIALIZE_HPP
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <nanoarrow/nanoarrow.h>
+
+// A self-contained binary encoding of Arrow schemas and record batches.
+//
+// An encoded stream is one schema binary followed by one binary per batch.
+// Buffers are copied as they are laid out in memory, so encoding and
+// decoding are memcpy-bound. Binaries encoded on a host of the other
+// endianness have the values of their buffers byte-swapped a whole buffer
+// at a time when decoded. The encoding is specific to this library and is
+// not the Arrow IPC format.
+//
+// String view, binary view and run-end encoded arrays, which the nanoarrow
+// vendored here predates, are laid out by hand, along with the structs,
+// such as the batch, holding them. Their other descendants go through
+// nanoarrow.
+
+constexpr uint32_t kArrowSerializeSchemaMagic = 0x53434241;  // "ABCS"
+constexpr uint32_t kArrowSerializeBatchMagic = 0x42434241;   // "ABCB"
+constexpr uint8_t kArrowSerializeVersion = 1;
+
+static inline uint8_t arrow_serialize_endianness() {
+    uint16_t one = 1;
+    return *(uint8_t *)&one;
+}
+
+// Reverses the bytes of each of the `count` values of `Width` bytes of
+// `data`. Values are swapped with shifts, in a loop without dependencies
+// between iterations, which compilers turn into vector byte shuffles.
+template <typename T> static void arrow_serialize_swap_words(uint8_t * data, int64_t count) {
+    for (int64_t i = 0; i < count; i++) {
+        T value;
+        memcpy(&value, data + i * sizeof(T), sizeof(T));
+        T swapped = 0;
+        for (size_t b = 0; b < sizeof(T); b++) {
+            swapped = (T)((swapped << 8) | ((value >> (8 * b)) & 0xff));
+        }
+        memcpy(data + i * sizeof(T), &swapped, sizeof(T));
+    }
+}
+
+static void arrow_serialize_swap_values(uint8_t * data, int64_t size, int64_t width) {
+    switch (width) {
+        case 2: arrow_serialize_swap_words<uint16_t>(data, size / 2); break;
+        case 4: arrow_serialize_swap_words<uint32_t>(data, size / 4); break;
+        case 8: arrow_serialize_swap_words<uint64_t>(data, size / 8); break;
+        default:
+            // 128 and 256-bit decimals are single integers
+            for (int64_t i = 0; i + width <= size; i += width) {
+                std::reverse(data + i, data + i + width);
+            }
+            break;
+    }
+}
+
+// Swaps the values of buffer `i` of `array`, which was initialized by
+// nanoarrow from its schema, from the endianness of another host.
+static void arrow_serialize_swap_buffer(const struct ArrowArray * array, int64_t i, uint8_t * data, int64_t size) {
+    auto private_data = (const struct ArrowArrayPrivateData *)array->private_data;
+    const struct ArrowLayout &layout = private_data->layout;
+    int64_t width = layout.element_size_bits[i] / 8;
+    if (layout.buffer_type[i] == NANOARROW_BUFFER_TYPE_VALIDITY || layout.buffer_type[i] == NANOARROW_BUFFER_TYPE_TYPE_ID || width <= 1) {
+        return;
+    }
+
+    switch (layout.buffer_data_type[i]) {
+        case NANOARROW_TYPE_BINARY:
+        case NANOARROW_TYPE_STRING:
+        case NANOARROW_TYPE_LARGE_BINARY:
+        case NANOARROW_TYPE_LARGE_STRING:
+            // the bytes of fixed-size binaries
+            return;
+        case NANOARROW_TYPE_INTERVAL_DAY_TIME:
+            arrow_serialize_swap_values(data, size, 4);
+            return;
+        case NANOARROW_TYPE_INTERVAL_MONTH_DAY_NANO:
+            // months and days, then nanoseconds
+            for (int64_t offset = 0; offset + 16 <= size; offset += 16) {
+                arrow_serialize_swap_words<uint32_t>(data + offset, 2);
+                arrow_serialize_swap_words<uint64_t>(data + offset + 8, 1);
+            }
+            return;
+        default:
+            arrow_serialize_swap_values(data, size, width);
+            return;
+    }
+}
+
+struct ArrowSerializeWriter {
+    std::string out;
+
+    void u8(uint8_t value) { out.push_back((char)value); }
+    void u32(uint32_t value) { out.append((const char *)&value, sizeof(value)); }
+    void i64(int64_t value) { out.append((const char *)&value, sizeof(value)); }
+
+    // A null `data` is written as a length of -1
+    void bytes(const void * data, int64_t size) {
+        if (data == nullptr) {
+            i64(-1);
+            return;
+        }
+        i64(size);
+        out.append((const char *)data, (size_t)size);
+    }
+
+    void string(const char * value) {
+        bytes(value, value ? (int64_t)strlen(value) : 0);
+    }
+};
+
+struct ArrowSerializeReader {
+    const uint8_t * data;
+    const uint8_t * end;
+    // whether the input comes from a host of the other endianness
+    bool swap = false;
+
+    bool u8(uint8_t &value) { return read(&value, sizeof(value)); }
+    bool u32(uint32_t &value) { return read(&value, sizeof(value)) && swapped(&value); }
+    bool i64(int64_t &value) { return read(&value, sizeof(value)) && swapped(&value); }
+
+    // Points `value` into the input, `size` is -1 for a null value
+    bool bytes(const uint8_t * &value, int64_t &size) {
+        if (!i64(size) || size < -1 || size > end - data) return false;
+        value = size == -1 ? nullptr : data;
+        if (size > 0) data += size;
+        return true;
+    }
+
+    bool read(void * value, size_t size) {
+        if ((size_t)(end - data) < size) return false;
+        memcpy(value, data, size);
+        data += size;
+        return true;
+    }
+
+    template <typename T> bool swapped(T * value) {
+        if (swap) arrow_serialize_swap_values((uint8_t *)value, sizeof(T), sizeof(T));
+        return true;
+    }
+};
+
+static void arrow_schema_serialize_node(ArrowSerializeWriter &writer, const struct ArrowSchema * schema) {
+    writer.string(schema->format);
+    writer.string(schema->name);
+    writer.bytes(schema->metadata, ArrowMetadataSizeOf(schema->metadata));
+    writer.i64(schema->flags);
+    writer.i64(schema->n_children);
+    for (int64_t i = 0; i < schema->n_children; i++) {
+        arrow_schema_serialize_node(writer, schema->children[i]);
+    }
+    writer.u8(schema->dictionary != nullptr);
+    if (schema->dictionary != nullptr) {
+        arrow_schema_serialize_node(writer, schema->dictionary);
+    }
+}
+
+static void arrow_array_serialize_node(ArrowSerializeWriter &writer, const struct ArrowArrayView * view, const struct ArrowArray * array) {
+    writer.i64(array->length);
+    writer.i64(array->null_count);
+    writer.i64(array->offset);
+    writer.i64(array->n_buffers);
+    for (int64_t i = 0; i < array->n_buffers; i++) {
+        writer.bytes(array->buffers[i], view->buffer_views[i].size_bytes);
+    }
+    writer.i64(array->n_children);
+    for (int64_t i = 0; i < array->n_children; i++) {
+        arrow_array_serialize_node(writer, view->children[i], array->children[i]);
+    }
+    writer.u8(array->dictionary != nullptr);
+    if (array->dictionary != nullptr) {
+        arrow_array_serialize_node(writer, view->dictionary, array->dictionary);
+    }
+}
+
+// Whether arrays of `schema` are laid out by hand: views, run-end encoded
+// arrays and the structs holding any.
+static bool arrow_serialize_by_hand(const struct ArrowSchema * schema) {
+    const char * format = schema->format ? schema->format : "";
+    if (strcmp(format, "vu") == 0 || strcmp(format, "vz") == 0 || strcmp(format, "+r") == 0) return true;
+    if (strcmp(format, "+s") != 0) return false;
+    for (int64_t i = 0; i < schema->n_children; i++) {
+        if (arrow_serialize_by_hand(schema->children[i])) return true;
+    }
+    return false;
+}
+
+// Sets `sizes` to the sizes of the buffers of `array` laid out by hand:
+// the validity bitmap of structs and views, then the views, the data
+// buffers and the sizes of the data buffers of views.
+static bool arrow_serialize_buffer_sizes(const struct ArrowSchema * schema, const struct ArrowArray * array, std::vector<int64_t> &sizes) {
+    bool views = schema->format[0] == 'v';
+    int64_t n_buffers = array->n_buffers;
+    if (views ? n_buffers < 3 : n_buffers != (strcmp(schema->format, "+s") == 0 ? 1 : 0)) return false;
+
+    int64_t end = array->offset + array->length;
+    sizes.assign((size_t)n_buffers, 0);
+    if (n_buffers > 0) sizes[0] = (end + 7) / 8;
+    if (views) {
+        int64_t n_data = n_buffers - 3;
+        auto data_sizes = (const int64_t *)array->buffers[n_buffers - 1];
+        if (n_data > 0 && data_sizes == nullptr) return false;
+        sizes[1] = end * 16;
+        for (int64_t i = 0; i < n_data; i++) {
+            sizes[(size_t)(2 + i)] = data_sizes[i];
+        }
+        sizes[(size_t)(n_buffers - 1)] = n_data * 8;
+    }
+    return true;
+}
+
+static int arrow_array_serialize_any(ArrowSerializeWriter &writer, struct ArrowSchema * schema, const struct ArrowArray * array, std::string &error);
+
+static int arrow_array_serialize_by_hand(ArrowSerializeWriter &writer, struct ArrowSchema * schema, const struct ArrowArray * array, std::string &error) {
+    std::vector<int64_t> sizes;
+    if (array->n_children != schema->n_children || array->dictionary != nullptr ||
+        !arrow_serialize_buffer_sizes(schema, array, sizes)) {
+        error = std::string("invalid ArrowArray (format=") + schema->format + ")";
+        return 1;
+    }
+
+    writer.i64(array->length);
+    writer.i64(array->null_count);
+    writer.i64(array->offset);
+    writer.i64(array->n_buffers);
+    for (int64_t i = 0; i < array->n_buffers; i++) {
+        writer.bytes(array->buffers[i], sizes[(size_t)i]);
+    }
+    writer.i64(array->n_children);
+    for (int64_t i = 0; i < array->n_children; i++) {
+        if (arrow_array_serialize_any(writer, schema->children[i], array->children[i], error) != 0) return 1;
+    }
+    writer.u8(0);
+    return 0;
+}
+
+static int arrow_array_serialize_any(ArrowSerializeWriter &writer, struct ArrowSchema * schema, const struct ArrowArray * array, std::string &error) {
+    if (arrow_serialize_by_hand(schema)) {
+        return arrow_array_serialize_by_hand(writer, schema, array, error);
+    }
+
+    struct ArrowError na_error{};
+    struct ArrowArrayView view{};
+    // the view computes the size of every buffer, which the C data
+    // interface does not store
+    if (ArrowArrayViewInitFromSchema(&view, schema, &na_error) != NANOARROW_OK ||
+        ArrowArrayViewSetArray(&view, array, &na_error) != NANOARROW_OK) {
+        ArrowArrayViewReset(&view);
+        error = na_error.message;
+        return 1;
+    }
+    arrow_array_serialize_node(writer, &view, array);
+    ArrowArrayViewReset(&view);
+    return 0;
+}
+
+/// Encodes `schema` into `out`.
+static void arrow_schema_serialize(const struct ArrowSchema * schema, std::string &out) {
+    ArrowSerializeWriter writer;
+    writer.u32(kArrowSerializeSchemaMagic);
+    writer.u8(kArrowSerializeVersion);
+    writer.u8(arrow_serialize_endianness());
+    arrow_schema_serialize_node(writer, schema);
+    out = std::move(writer.out);
+}
+
+/// Encodes `array` of `schema` into `out`.
+///
+/// Returns 0 on success. On failure, returns 1 and `error` is set.
+static int arrow_array_serialize(struct ArrowSchema * schema, const struct ArrowArray * array, std::string &out, std::string &error) {
+    ArrowSerializeWriter writer;
+    writer.u32(kArrowSerializeBatchMagic);
+    if (arrow_array_serialize_any(writer, schema, array, error) != 0) return 1;
+    out = std::move(writer.out);
+    return 0;
+}
+
+// Checks that `size` bytes of `metadata` hold the key/value pairs they
+// announce, as nanoarrow trusts the lengths when copying metadata
+static bool arrow_serialize_metadata_valid(const uint8_t * metadata, int64_t size, bool swap) {
+    ArrowSerializeReader reader{metadata, metadata + size, swap};
+    uint32_t n_pairs = 0;
+    if (!reader.u32(n_pairs)) return false;
+    for (uint64_t i = 0; i < 2 * (uint64_t)n_pairs; i++) {
+        uint32_t length = 0;
+        if (!reader.u32(length) || length > (uint64_t)(reader.end - reader.data)) return false;
+        reader.data += length;
+    }
+    return reader.data == reader.end;
+}
+
+// Swaps the lengths of valid `metadata` from the endianness of another host.
+static void arrow_serialize_swap_metadata(std::string &metadata) {
+    auto data = (uint8_t *)&metadata[0];
+    ArrowSerializeReader reader{data, data + metadata.size(), true};
+    uint32_t n_pairs = 0;
+    reader.u32(n_pairs);
+    arrow_serialize_swap_words<uint32_t>(data, 1);
+    for (uint64_t i = 0; i < 2 * (uint64_t)n_pairs; i++) {
+        uint8_t * length_data = (uint8_t *)reader.data;
+        uint32_t length = 0;
+        reader.u32(length);
+        arrow_serialize_swap_words<uint32_t>(length_data, 1);
+        reader.data += length;
+    }
+}
+
+static int arrow_schema_deserialize_node(ArrowSerializeReader &reader, struct ArrowSchema * schema, int depth) {
+    const uint8_t * format = nullptr;
+    const uint8_t * name = nullptr;
+    const uint8_t * metadata = nullptr;
+    int64_t format_size = 0, name_size = 0, metadata_size = 0, flags = 0, n_children = 0;
+    uint8_t has_dictionary = 0;
+    if (depth > 64 || !reader.bytes(format, format_size) || format == nullptr ||
+        !reader.bytes(name, name_size) || !reader.bytes(metadata, metadata_size) ||
+        (metadata != nullptr && !arrow_serialize_metadata_valid(metadata, metadata_size, reader.swap)) ||
+        !reader.i64(flags) || !reader.i64(n_children) || n_children < 0 || n_children > reader.end - reader.data) {
+        return 1;
+    }
+
+    std::string format_string((const char *)format, (size_t)format_size);
+    std::string name_string(name ? (const char *)name : "", name ? (size_t)name_size : 0);
+    // the metadata is copied by nanoarrow, so it no longer points into the input
+    std::string metadata_string(metadata ? (const char *)metadata : "", metadata ? (size_t)metadata_size : 0);
+    if (metadata != nullptr && reader.swap) arrow_serialize_swap_metadata(metadata_string);
+    if (ArrowSchemaSetFormat(schema, format_string.c_str()) != NANOARROW_OK ||
+        ArrowSchemaSetName(schema, name ? name_string.c_str() : nullptr) != NANOARROW_OK ||
+        ArrowSchemaSetMetadata(schema, metadata ? metadata_string.data() : nullptr) != NANOARROW_OK ||
+        ArrowSchemaAllocateChildren(schema, n_children) != NANOARROW_OK) {
+        return 1;
+    }
+    schema->flags = flags;
+
+    for (int64_t i = 0; i < n_children; i++) {
+        ArrowSchemaInit(schema->children[i]);
+        if (arrow_schema_deserialize_node(reader, schema->children[i], depth + 1) != 0) {
+            return 1;
+        }
+    }
+
+    if (!reader.u8(has_dictionary)) return 1;
+    if (has_dictionary) {
+        if (ArrowSchemaAllocateDictionary(schema) != NANOARROW_OK) return 1;
+        ArrowSchemaInit(schema->dictionary);
+        return arrow_schema_deserialize_node(reader, schema->dictionary, depth + 1);
+    }
+    return 0;
+}
+
+/// Decodes a schema encoded by `arrow_schema_serialize` into `out`, with
+/// `swap` set if it was encoded on a host of the other endianness.
+///
+/// Returns 0 on success. On failure, returns 1, `out` is left released and
+/// `error` is set.
+static int arrow_schema_deserialize(const uint8_t * data, size_t size, struct ArrowSchema * out, bool &swap, std::string &error) {
+    out->release = nullptr;
+
+    ArrowSerializeReader reader{data, data + size};
+    uint8_t magic[4] = {0, 0, 0, 0};
+    uint8_t version = 0, endianness = 0;
+    // the magic is only compared once the endianness that follows it is known
+    if (!reader.read(magic, sizeof(magic)) || !reader.u8(version) || !reader.u8(endianness) || endianness > 1) {
+        error = "invalid encoded schema";
+        return 1;
+    }
+    swap = endianness != arrow_serialize_endianness();
+    reader.swap = swap;
+    uint32_t magic_value = 0;
+    memcpy(&magic_value, magic, sizeof(magic));
+    if (!reader.swapped(&magic_value) || magic_value != kArrowSerializeSchemaMagic) {
+        error = "invalid encoded schema";
+        return 1;
+    }
+    if (version != kArrowSerializeVersion) {
+        error = "unsupported version of encoded schema: " + std::to_string(version);
+        return 1;
+    }
+
+    ArrowSchemaInit(out);
+    if (arrow_schema_deserialize_node(reader, out, 0) != 0 || reader.data != reader.end) {
+        out->release(out);
+        error = "invalid encoded schema";
+        return 1;
+    }
+    return 0;
+}
+
+static int arrow_array_deserialize_node(ArrowSerializeReader &reader, struct ArrowArray * array) {
+    int64_t length = 0, null_count = 0, offset = 0, n_buffers = 0, n_children = 0;
+    uint8_t has_dictionary = 0;
+    if (!reader.i64(length) || !reader.i64(null_count) || !reader.i64(offset) || !reader.i64(n_buffers) ||
+        length < 0 || offset < 0 || null_count < -1 || n_buffers != array->n_buffers) {
+        return 1;
+    }
+
+    for (int64_t i = 0; i < n_buffers; i++) {
+        const uint8_t * data = nullptr;
+        int64_t size = 0;
+        if (!reader.bytes(data, size)) return 1;
+        if (data == nullptr) continue;
+
+        struct ArrowBuffer buffer;
+        ArrowBufferInit(&buffer);
+        if (ArrowBufferAppend(&buffer, data, size) != NANOARROW_OK) {
+            ArrowBufferReset(&buffer);
+            return 1;
+        }
+        if (reader.swap) arrow_serialize_swap_buffer(array, i, buffer.data, buffer.size_bytes);
+        if (ArrowArraySetBuffer(array, i, &buffer) != NANOARROW_OK) {
+            ArrowBufferReset(&buffer);
+            return 1;
+        }
+    }
+
+    if (!reader.i64(n_children) || n_children != array->n_children) return 1;
+    for (int64_t i = 0; i < n_children; i++) {
+        if (arrow_array_deserialize_node(reader, array->children[i]) != 0) return 1;
+    }
+
+    if (!reader.u8(has_dictionary) || (has_dictionary != 0) != (array->dictionary != nullptr)) return 1;
+    if (has_dictionary && arrow_array_deserialize_node(reader, array->dictionary) != 0) return 1;
+
+    array->length = length;
+    array->null_count = null_count;
+    array->offset = offset;
+    return 0;
+}
+
+// The private data of arrays decoded by hand, which own their buffers and
+// children.
+struct ArrowSerializeArrayData {
+    std::vector<struct ArrowBuffer> buffers;
+    std::vector<const void *> buffer_data;
+    std::vector<struct ArrowArray> children;
+    std::vector<struct ArrowArray *> child_pointers;
+};
+
+static void arrow_serialize_array_release(struct ArrowArray * array) {
+    auto data = (ArrowSerializeArrayData *)array->private_data;
+    for (auto &buffer : data->buffers) ArrowBufferReset(&buffer);
+    for (auto &child : data->children) {
+        if (child.release != nullptr) child.release(&child);
+    }
+    delete data;
+    array->release = nullptr;
+}
+
+// Swaps the lengths of the 16-byte views of `data` from the endianness of
+// another host, and the buffer indices and offsets of the views whose
+// value is not inlined.
+static void arrow_serialize_swap_views(uint8_t * data, int64_t size) {
+    for (int64_t at = 0; at + 16 <= size; at += 16) {
+        arrow_serialize_swap_words<uint32_t>(data + at, 1);
+        int32_t length = 0;
+        memcpy(&length, data + at, sizeof(length));
+        if (length > 12) arrow_serialize_swap_words<uint32_t>(data + at + 8, 2);
+    }
+}
+
+// Checks the buffers of `array` laid out by hand against its length, and
+// its children against it. The views themselves and the run ends are
+// checked when the array is converted.
+static bool arrow_serialize_by_hand_valid(const struct ArrowSchema * schema, const struct ArrowArray * array) {
+    auto data = (const ArrowSerializeArrayData *)array->private_data;
+    if (array->length > INT64_MAX / 16 - array->offset) return false;
+    int64_t end = array->offset + array->length;
+    if (array->n_buffers > 0 && array->buffers[0] != nullptr && data->buffers[0].size_bytes < (end + 7) / 8) {
+        return false;
+    }
+
+    if (schema->format[0] == 'v') {
+        int64_t n_data = array->n_buffers - 3;
+        const struct ArrowBuffer &sizes = data->buffers[(size_t)(array->n_buffers - 1)];
+        if (data->buffers[1].size_bytes < end * 16 || sizes.size_bytes != n_data * 8) return false;
+        for (int64_t i = 0; i < n_data; i++) {
+            int64_t size = 0;
+            memcpy(&size, sizes.data + 8 * i, sizeof(size));
+            if (size != data->buffers[(size_t)(2 + i)].size_bytes) return false;
+        }
+        return true;
+    }
+    if (strcmp(schema->format, "+r") == 0) {
+        if (array->n_children != 2) return false;
+        const struct ArrowArray * run_ends = array->children[0];
+        return run_ends->null_count == 0 && run_ends->length == array->children[1]->length;
+    }
+    for (int64_t i = 0; i < array->n_children; i++) {
+        if (array->children[i]->length < end) return false;
+    }
+    return true;
+}
+
+static int arrow_array_deserialize_by_hand(ArrowSerializeReader &reader, struct ArrowSchema * schema, struct ArrowArray * array, std::string &error) {
+    int64_t length = 0, null_count = 0, offset = 0, n_buffers = 0, n_children = 0;
+    uint8_t has_dictionary = 0;
+    bool views = schema->format[0] == 'v';
+    if (!reader.i64(length) || !reader.i64(null_count) || !reader.i64(offset) || !reader.i64(n_buffers) ||
+        length < 0 || offset < 0 || null_count < -1 || n_buffers > reader.end - reader.data ||
+        (views ? n_buffers < 3 : n_buffers != (strcmp(schema->format, "+s") == 0 ? 1 : 0))) {
+        return 1;
+    }
+
+    // released along with whatever was decoded should anything fail
+    auto data = new ArrowSerializeArrayData();
+    *array = ArrowArray{};
+    array->private_data = data;
+    array->release = arrow_serialize_array_release;
+
+    data->buffers.resize((size_t)n_buffers);
+    data->buffer_data.assign((size_t)n_buffers, nullptr);
+    for (auto &buffer : data->buffers) ArrowBufferInit(&buffer);
+    for (int64_t i = 0; i < n_buffers; i++) {
+        const uint8_t * bytes = nullptr;
+        int64_t size = 0;
+        if (!reader.bytes(bytes, size)) return 1;
+        if (bytes == nullptr) continue;
+
+        struct ArrowBuffer &buffer = data->buffers[(size_t)i];
+        if (ArrowBufferAppend(&buffer, bytes, size) != NANOARROW_OK) return 1;
+        if (reader.swap && views && i == 1) arrow_serialize_swap_views(buffer.data, buffer.size_bytes);
+        if (reader.swap && views && i == n_buffers - 1) arrow_serialize_swap_values(buffer.data, buffer.size_bytes, 8);
+        data->buffer_data[(size_t)i] = buffer.data;
+    }
+
+    if (!reader.i64(n_children) || n_children != schema->n_children) return 1;
+    data->children.assign((size_t)n_children, ArrowArray{});
+    for (int64_t i = 0; i < n_children; i++) {
+        struct ArrowArray * child = &data->children[(size_t)i];
+        data->child_pointers.push_back(child);
+        if (arrow_serialize_by_hand(schema->children[i])) {
+            if (arrow_array_deserialize_by_hand(reader, schema->children[i], child, error) != 0) return 1;
+            continue;
+        }
+
+        struct ArrowError na_error{};
+        if (ArrowArrayInitFromSchema(child, schema->children[i], &na_error) != NANOARROW_OK) {
+            error = na_error.message;
+            return 1;
+        }
+        if (arrow_array_deserialize_node(reader, child) != 0) return 1;
+        if (ArrowArrayFinishBuilding(child, NANOARROW_VALIDATION_LEVEL_FULL, &na_error) != NANOARROW_OK) {
+            error = na_error.message;
+            return 1;
+        }
+    }
+    if (!reader.u8(has_dictionary) || has_dictionary != 0) return 1;
+
+    array->length = length;
+    array->null_count = null_count;
+    array->offset = offset;
+    array->n_buffers = n_buffers;
+    array->n_children = n_children;
+    array->buffers = data->buffer_data.data();
+    array->children = data->child_pointers.data();
+    return arrow_serialize_by_hand_valid(schema, array) ? 0 : 1;
+}
+
+/// Decodes a batch of `schema` encoded by `arrow_array_serialize` into
+/// `out`, swapping its values if `swap` was set by
+/// `arrow_schema_deserialize`. The buffers are copied and fully validated
+/// against the schema.
+///
+/// Returns 0 on success. On failure, returns 1, `out` is left released and
+/// `error` is set.
+static int arrow_array_deserialize(struct ArrowSchema * schema, const uint8_t * data, size_t size, bool swap, struct ArrowArray * out, std::string &error) {
+    out->release = nullptr;
+
+    if (arrow_serialize_by_hand(schema)) {
+        ArrowSerializeReader reader{data, data + size, swap};
+        uint32_t magic = 0;
+        std::string reason;
+        if (!reader.u32(magic) || magic != kArrowSerializeBatchMagic ||
+            arrow_array_deserialize_by_hand(reader, schema, out, reason) != 0 || reader.data != reader.end) {
+            if (out->release != nullptr) out->release(out);
+            error = reason.empty() ? "invalid encoded record batch" : "invalid encoded record batch: " + reason;
+            return 1;
+        }
+        return 0;
+    }
+
+    struct ArrowError na_error{};
+    if (ArrowArrayInitFromSchema(out, schema, &na_error) != NANOARROW_OK) {
+        error = na_error.message;
+        return 1;
+    }
+
+    ArrowSerializeReader reader{data, data + size, swap};
+    uint32_t magic = 0;
+    if (!reader.u32(magic) || magic != kArrowSerializeBatchMagic ||
+        arrow_array_deserialize_node(reader, out) != 0 || reader.data != reader.end) {
+        out->release(out);
+        error = "invalid encoded record batch";
+        return 1;
+    }
+
+    // binaries may come from anywhere, so offsets are checked as well
+    if (ArrowArrayFinishBuilding(out, NANOARROW_VALIDATION_LEVEL_FULL, &na_error) != NANOARROW_OK) {
+        out->release(out);
+        error = std::string("invalid encoded record batch: ") + na_error.message;
+        return 1;
+    }
+    return 0;
+}
+
+#endif  // ADBC_ARROW_SERIALIZE_HPP
@@ -0,0 +1,298 @@
+#ifndef ADBC_ARROW_TAKE_HPP
+#define ADBC_ARROW_TAKE_HPP
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <nanoarrow/nanoarrow.h>
+#include "adbc_arrow_concat.hpp"
+#include "adbc_bitmap.hpp"
+#include "adbc_type_registry.hpp"
+
+/// A row of one of the arrays given to `arrow_array_take`, with the offset
+/// of the record batch the array belongs to but not its own.
+struct ArrowRowRef {
+    uint32_t array;
+    int64_t row;
+};
+
+template <typename OffsetT>
+static ArrowErrorCode arrow_array_take_offsets(struct ArrowBuffer * offsets_out, struct ArrowBuffer * data_out, const std::vector<const struct ArrowArray *> &arrays, const std::vector<ArrowRowRef> &rows, std::string &error) {
+    // sized up front, so that values are copied without growing the buffer
+    int64_t size = 0;
+    for (const ArrowRowRef &ref : rows) {
+        const struct ArrowArray * values = arrays[ref.array];
+        auto offsets = (const OffsetT *)values->buffers[1] + values->offset + ref.row;
+        size += offsets[1] - offsets[0];
+    }
+    if (size > (int64_t)std::numeric_limits<OffsetT>::max()) {
+        error = "the selected values do not fit the offsets of the type";
+        return EOVERFLOW;
+    }
+
+    NANOARROW_RETURN_NOT_OK(ArrowBufferReserve(offsets_out, (int64_t)rows.size() * (int64_t)sizeof(OffsetT)));
+    NANOARROW_RETURN_NOT_OK(ArrowBufferReserve(data_out, size));
+    OffsetT end = 0;
+    for (const ArrowRowRef &ref : rows) {
+        const struct ArrowArray * values = arrays[ref.array];
+        auto offsets = (const OffsetT *)values->buffers[1] + values->offset + ref.row;
+        OffsetT value_size = offsets[1] - offsets[0];
+        ArrowBufferAppendUnsafe(data_out, (const uint8_t *)values->buffers[2] + offsets[0], value_size);
+        end += value_size;
+        ArrowBufferAppendUnsafe(offsets_out, &end, sizeof(OffsetT));
+    }
+    return NANOARROW_OK;
+}
+
+/// Copies the `rows` of `arrays` of `schema`, in that order, into `out`.
+///
+/// The same types as `arrow_array_concat` are supported, that is arrays
+/// without children.
+///
+/// Returns 0 on success. On failure, returns 1, `out` is left released and
+/// `error` is set.
+static int arrow_array_take(struct ArrowSchema * schema, const std::vector<const struct ArrowArray *> &arrays, const std::vector<ArrowRowRef> &rows, struct ArrowArray * out, std::string &error) {
+    out->release = nullptr;
+
+    struct ArrowError na_error{};
+    struct ArrowSchemaView schema_view{};
+    if (!arrow_array_concat_supported(schema) ||
+        ArrowSchemaViewInit(&schema_view, schema, &na_error) != NANOARROW_OK) {
+        error = std::string("cannot select the rows of columns of format ") + (schema->format ? schema->format : "");
+        return 1;
+    }
+    if (ArrowArrayInitFromSchema(out, schema, &na_error) != NANOARROW_OK ||
+        ArrowArrayStartAppending(out) != NANOARROW_OK) {
+        if (out->release) out->release(out);
+        error = na_error.message;
+        return 1;
+    }
+
+    const struct ArrowLayout &layout = schema_view.layout;
+    bool fixed_width = layout.buffer_type[1] == NANOARROW_BUFFER_TYPE_DATA;
+    int64_t length = (int64_t)rows.size();
+    bool has_nulls = false;
+    for (auto values : arrays) {
+        if (values->null_count != 0 && values->buffers[0] != nullptr) {
+            has_nulls = true;
+        }
+    }
+
+    int64_t null_count = 0;
+    int code = NANOARROW_OK;
+    if (has_nulls) {
+        struct ArrowBitmap * validity = ArrowArrayValidityBitmap(out);
+        code = ArrowBitmapReserve(validity, length);
+        for (int64_t i = 0; code == NANOARROW_OK && i < length; i++) {
+            const struct ArrowArray * values = arrays[rows[i].array];
+            auto bits = (const uint8_t *)values->buffers[0];
+            bool valid = bits == nullptr || arrow_bitmap_get(bits, values->offset + rows[i].row);
+            ArrowBitmapAppendUnsafe(validity, valid, 1);
+            null_count += !valid;
+        }
+    }
+
+    struct ArrowBuffer * data = ArrowArrayBuffer(out, 1);
+    if (code != NANOARROW_OK) {
+        // reported below
+    } else if (fixed_width && layout.element_size_bits[1] == 1) {
+        code = ArrowBufferAppendFill(data, 0, _ArrowBytesForBits(length));
+        for (int64_t i = 0; code == NANOARROW_OK && i < length; i++) {
+            const struct ArrowArray * values = arrays[rows[i].array];
+            if (arrow_bitmap_get((const uint8_t *)values->buffers[1], values->offset + rows[i].row)) {
+                ArrowBitSet(data->data, i);
+            }
+        }
+    } else if (fixed_width) {
+        int64_t width = layout.element_size_bits[1] / 8;
+        code = ArrowBufferReserve(data, length * width);
+        for (int64_t i = 0; code == NANOARROW_OK && i < length; i++) {
+            const struct ArrowArray * values = arrays[rows[i].array];
+            ArrowBufferAppendUnsafe(data, (const uint8_t *)values->buffers[1] + (values->offset + rows[i].row) * width, width);
+        }
+    } else if (layout.element_size_bits[1] == 32) {
+        code = arrow_array_take_offsets<int32_t>(data, ArrowArrayBuffer(out, 2), arrays, rows, error);
+    } else {
+        code = arrow_array_take_offsets<int64_t>(data, ArrowArrayBuffer(out, 2), arrays, rows, error);
+    }
+
+    if (code == NANOARROW_OK) {
+        out->length = length;
+        out->null_count = null_count;
+        code = ArrowArrayFinishBuildingDefault(out, &na_error);
+        if (code != NANOARROW_OK) error = na_error.message;
+    } else if (error.empty()) {
+        error = "cannot allocate memory to select rows";
+    }
+
+    if (code != NANOARROW_OK) {
+        out->release(out);
+        return 1;
+    }
+    return 0;
+}
+
+/// Copies the `rows` of the record `batches` of `schema`, in that order,
+/// into the record batch `out`, with only the `columns` children.
+///
+/// Returns 0 on success. On failure, returns 1, `out` is left released and
+/// `error` is set.
+static int arrow_batch_take(struct ArrowSchema * schema, const std::vector<const struct ArrowArray *> &batches, const std::vector<int64_t> &columns, const std::vector<ArrowRowRef> &rows, struct ArrowArray * out, std::string &error) {
+    out->release = nullptr;
+
+    auto data = new ConcatenatedBatch();
+    data->columns.resize(columns.size());
+    std::vector<const struct ArrowArray *> arrays(batches.size());
+    for (size_t i = 0; i < columns.size(); i++) {
+        for (size_t j = 0; j < batches.size(); j++) {
+            arrays[j] = batches[j]->children[columns[i]];
+        }
+        if (arrow_array_take(schema->children[columns[i]], arrays, rows, &data->columns[i], error) != 0) {
+            arrow_batch_concatenated_free(data);
+            return 1;
+        }
+        data->children.push_back(&data->columns[i]);
+    }
+
+    out->length = (int64_t)rows.size();
+    out->null_count = 0;
+    out->offset = 0;
+    out->n_buffers = 1;
+    out->n_children = (int64_t)columns.size();
+    out->buffers = data->buffers;
+    out->children = data->children.empty() ? nullptr : data->children.data();
+    out->dictionary = nullptr;
+    out->release = arrow_batch_concatenated_release;
+    out->private_data = data;
+    return 0;
+}
+
+enum class ArrowCompareOp { kEq, kNe, kLt, kLe, kGt, kGe };
+
+/// The value compared to a column by `arrow_array_compare`.
+struct ArrowCompareValue {
+    enum { kInteger, kFloat, kBinary, kBoolean } kind;
+    int64_t integer = 0;
+    double number = 0;
+    bool boolean = false;
+    const uint8_t * bytes = nullptr;
+    size_t size = 0;
+};
+
+// -1, 0 or 1 as `x` is less than, equal to or greater than `value`, or 2
+// when they are unordered, such as for NaN
+static inline int arrow_compare_order(double x, double y) {
+    if (x < y) return -1;
+    if (x > y) return 1;
+    return x == y ? 0 : 2;
+}
+
+template <typename T>
+static inline int arrow_compare_number(T x, const ArrowCompareValue &value) {
+    if constexpr (std::is_floating_point<T>::value) {
+        double y = value.kind == ArrowCompareValue::kInteger ? (double)value.integer : value.number;
+        return arrow_compare_order((double)x, y);
+    } else if constexpr (std::is_unsigned<T>::value) {
+        if (value.kind == ArrowCompareValue::kFloat) return arrow_compare_order((double)x, value.number);
+        if (value.integer < 0) return 1;
+        uint64_t y = (uint64_t)value.integer;
+        return x < y ? -1 : (x > y ? 1 : 0);
+    } else {
+        if (value.kind == ArrowCompareValue::kFloat) return arrow_compare_order((double)x, value.number);
+        int64_t y = value.integer;
+        return x < y ? -1 : (x > y ? 1 : 0);
+    }
+}
+
+static inline bool arrow_compare_matches(int order, ArrowCompareOp op) {
+    switch (op) {
+        case ArrowCompareOp::kEq: return order == 0;
+        case ArrowCompareOp::kNe: return order == -1 || order == 1;
+        case ArrowCompareOp::kLt: return order == -1;
+        case ArrowCompareOp::kLe: return order == -1 || order == 0;
+        case ArrowCompareOp::kGt: return order == 1;
+        case ArrowCompareOp::kGe: return order == 1 || order == 0;
+    }
+    return false;
+}
+
+// Appends the rows of `column` for which `matches(index)` holds to `rows`,
+// skipping nulls, where `index` includes the offset of the column.
+template <typename M>
+static void arrow_array_compare_rows(const struct ArrowArray * column, int64_t offset, int64_t length, std::vector<int64_t> &rows, const M &matches) {
+    auto validity = (const uint8_t *)column->buffers[0];
+    int64_t start = column->offset + offset;
+    if (validity == nullptr || column->null_count == 0) {
+        for (int64_t i = 0; i < length; i++) {
+            if (matches(start + i)) rows.push_back(offset + i);
+        }
+    } else {
+        arrow_bitmap_visit(validity, start, length, [&](int64_t i, bool valid) {
+            if (valid && matches(start + i)) rows.push_back(offset + i);
+        });
+    }
+}
+
+template <typename Primitive>
+struct PrimitiveCompare {
+    static void call(const struct ArrowArray * column, int64_t offset, int64_t length, ArrowCompareOp op, const ArrowCompareValue &value, std::vector<int64_t> &rows) {
+        using T = typename Primitive::value_type;
+        auto values = (const T *)column->buffers[1];
+        arrow_array_compare_rows(column, offset, length, rows, [&](int64_t i) {
+            return arrow_compare_matches(arrow_compare_number(values[i], value), op);
+        });
+    }
+};
+
+static constexpr auto kPrimitiveCompares = adbc_primitive_table<PrimitiveCompare>();
+
+template <typename OffsetT>
+static void arrow_array_compare_binary(const struct ArrowArray * column, int64_t offset, int64_t length, ArrowCompareOp op, const ArrowCompareValue &value, std::vector<int64_t> &rows) {
+    auto offsets = (const OffsetT *)column->buffers[1];
+    auto data = (const uint8_t *)column->buffers[2];
+    arrow_array_compare_rows(column, offset, length, rows, [&](int64_t i) {
+        size_t size = (size_t)(offsets[i + 1] - offsets[i]);
+        size_t common = size < value.size ? size : value.size;
+        int order = common == 0 ? 0 : memcmp(data + offsets[i], value.bytes, common);
+        if (order == 0) order = size < value.size ? -1 : (size > value.size ? 1 : 0);
+        return arrow_compare_matches(order < 0 ? -1 : (order > 0 ? 1 : 0), op);
+    });
+}
+
+/// Appends the rows from `offset` to `offset + length` of `column` of
+/// `schema`, including the offset of its record batch, whose value
+/// compares to `value` as `op` to `rows`. Null values never match.
+///
+/// Numeric columns compare to numbers, string and binary columns to
+/// binaries, byte by byte, and boolean columns to booleans.
+///
+/// Returns 0 on success. On failure, returns 1 and `error` is set.
+static int arrow_array_compare(const struct ArrowSchema * schema, const struct ArrowArray * column, int64_t offset, int64_t length, ArrowCompareOp op, const ArrowCompareValue &value, std::vector<int64_t> &rows, std::string &error) {
+    const char * format = schema->format ? schema->format : "";
+    bool number = value.kind == ArrowCompareValue::kInteger || value.kind == ArrowCompareValue::kFloat;
+    int index = schema->dictionary == nullptr ? adbc_primitive_index_of_format(format) : -1;
+
+    if (index != -1 && number) {
+        kPrimitiveCompares[index](column, offset, length, op, value, rows);
+    } else if ((strcmp(format, "u") == 0 || strcmp(format, "z") == 0) && value.kind == ArrowCompareValue::kBinary) {
+        arrow_array_compare_binary<int32_t>(column, offset, length, op, value, rows);
+    } else if ((strcmp(format, "U") == 0 || strcmp(format, "Z") == 0) && value.kind == ArrowCompareValue::kBinary) {
+        arrow_array_compare_binary<int64_t>(column, offset, length, op, value, rows);
+    } else if (strcmp(format, "b") == 0 && value.kind == ArrowCompareValue::kBoolean) {
+        auto values = (const uint8_t *)column->buffers[1];
+        arrow_array_compare_rows(column, offset, length, rows, [&](int64_t i) {
+            int x = arrow_bitmap_get(values, i), y = value.boolean;
+            return arrow_compare_matches(x < y ? -1 : (x > y ? 1 : 0), op);
+        });
+    } else {
+        error = std::string("cannot compare columns of format ") + format + " with the given value";
+        return 1;
+    }
+    return 0;
+}
+
+#endif  // ADBC_ARROW_TAKE_HPP
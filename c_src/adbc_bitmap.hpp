@@ -0,0 +1,70 @@
+#ifndef ADBC_BITMAP_HPP
+#define ADBC_BITMAP_HPP
+#pragma once
+
+#include <cstdint>
+
+// Reads the 64 bits of `bitmap` starting at byte `index`, least significant
+// bit first as in Arrow, whatever the endianness of the machine.
+static inline uint64_t arrow_bitmap_word(const uint8_t * bitmap, int64_t index) {
+    const uint8_t * bytes = bitmap + index;
+    uint64_t word = 0;
+    for (int b = 0; b < 8; b++) {
+        word |= (uint64_t)bytes[b] << (b * 8);
+    }
+    return word;
+}
+
+static inline bool arrow_bitmap_get(const uint8_t * bitmap, int64_t i) {
+    return (bitmap[i / 8] >> (i % 8)) & 1;
+}
+
+// Calls `visit(i, set)` for each bit `offset + i` of `bitmap`, for `i` from
+// 0 to `count`, in order.
+//
+// Bits are read 64 at a time, and words with all their bits set or unset
+// are visited in loops of their own, where `set` is a constant, so that
+// decoders pay for a bit test only where valid and null values mix.
+template <typename V> static inline void arrow_bitmap_visit(const uint8_t * bitmap, int64_t offset, int64_t count, const V &visit) {
+    int64_t i = 0;
+    for (; i < count && (offset + i) % 64 != 0; i++) {
+        visit(i, arrow_bitmap_get(bitmap, offset + i));
+    }
+    for (; i + 64 <= count; i += 64) {
+        uint64_t word = arrow_bitmap_word(bitmap, (offset + i) / 8);
+        if (word == ~(uint64_t)0) {
+            for (int64_t j = 0; j < 64; j++) visit(i + j, true);
+        } else if (word == 0) {
+            for (int64_t j = 0; j < 64; j++) visit(i + j, false);
+        } else {
+            for (int64_t j = 0; j < 64; j++) visit(i + j, (bool)((word >> j) & 1));
+        }
+    }
+    for (; i < count; i++) {
+        visit(i, arrow_bitmap_get(bitmap, offset + i));
+    }
+}
+
+// Same as `arrow_bitmap_visit`, from the last bit to the first, for
+// decoders building lists from their last cell.
+template <typename V> static inline void arrow_bitmap_visit_backwards(const uint8_t * bitmap, int64_t offset, int64_t count, const V &visit) {
+    int64_t i = count;
+    for (; i > 0 && (offset + i) % 64 != 0; i--) {
+        visit(i - 1, arrow_bitmap_get(bitmap, offset + i - 1));
+    }
+    for (; i >= 64; i -= 64) {
+        uint64_t word = arrow_bitmap_word(bitmap, (offset + i - 64) / 8);
+        if (word == ~(uint64_t)0) {
+            for (int64_t j = 63; j >= 0; j--) visit(i - 64 + j, true);
+        } else if (word == 0) {
+            for (int64_t j = 63; j >= 0; j--) visit(i - 64 + j, false);
+        } else {
+            for (int64_t j = 63; j >= 0; j--) visit(i - 64 + j, (bool)((word >> j) & 1));
+        }
+    }
+    for (; i > 0; i--) {
+        visit(i - 1, arrow_bitmap_get(bitmap, offset + i - 1));
+    }
+}
+
+#endif  // ADBC_BITMAP_HPP
@@ -0,0 +1,78 @@
+#ifndef ADBC_CALL_STATS_HPP
+#define ADBC_CALL_STATS_HPP
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// the buckets of the latency histograms: the first counts calls under a
+// microsecond, and each next one the calls under twice the bound of the
+// previous one, the last counting all slower calls
+constexpr int kCallStatsBuckets = 32;
+
+/// Aggregates of the calls of a NIF, reported by `Adbc.Nif.call_stats/0`.
+///
+/// The counters are relaxed atomics updated by the thread running the
+/// call, so that they are cheap enough to be always on.
+struct AdbcCallStats {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<int64_t> in_flight{0};
+    // the sum of the durations of the calls, in nanoseconds
+    std::atomic<uint64_t> total_time{0};
+    std::atomic<uint64_t> buckets[kCallStatsBuckets]{};
+
+    void record(uint64_t nanoseconds) {
+        uint64_t microseconds = nanoseconds / 1000;
+        int bucket = 0;
+        while (microseconds > 0 && bucket < kCallStatsBuckets - 1) {
+            microseconds >>= 1;
+            bucket++;
+        }
+        calls.fetch_add(1, std::memory_order_relaxed);
+        total_time.fetch_add(nanoseconds, std::memory_order_relaxed);
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // the gauge of calls in flight is left as is
+    void reset() {
+        calls.store(0, std::memory_order_relaxed);
+        total_time.store(0, std::memory_order_relaxed);
+        for (auto &bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    }
+};
+
+/// The stats of the hot paths of the NIF, one per kind of call whatever
+/// its variant: dirty or not, async or not, and of any output.
+struct AdbcHotPathStats {
+    AdbcCallStats execute_query;
+    AdbcCallStats stream_next;
+    AdbcCallStats bind;
+    AdbcCallStats get_objects;
+};
+
+static AdbcHotPathStats adbc_call_stats;
+
+/// Records the call in which it lives in `stats`, from its construction
+/// to its destruction, whichever way the call returns.
+class AdbcCallScope {
+public:
+    explicit AdbcCallScope(AdbcCallStats &stats) : stats_(stats), start_(std::chrono::steady_clock::now()) {
+        stats_.in_flight.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~AdbcCallScope() {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        stats_.in_flight.fetch_sub(1, std::memory_order_relaxed);
+        stats_.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    AdbcCallScope(const AdbcCallScope &) = delete;
+    AdbcCallScope &operator=(const AdbcCallScope &) = delete;
+
+private:
+    AdbcCallStats &stats_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif  // ADBC_CALL_STATS_HPP
@@ -0,0 +1,216 @@
+#ifndef ADBC_COALESCE_STREAM_HPP
+#define ADBC_COALESCE_STREAM_HPP
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+#include <nanoarrow/nanoarrow.h>
+#include "adbc_arrow_concat.hpp"
+#include "adbc_memory.hpp"
+
+// the bounds of the rows of the batches handed out by an adaptive stream
+constexpr int64_t kCoalesceMinRows = 64;
+constexpr int64_t kCoalesceMaxRows = 1 << 20;
+// the bytes a batch is never coalesced past by an adaptive stream
+constexpr int64_t kCoalesceMaxBytes = 64 << 20;
+
+/// State of an ArrowArrayStream that concatenates consecutive batches of
+/// the wrapped stream into larger ones.
+///
+/// Batches are coalesced until they have `target_rows` rows or hold
+/// `target_bytes` bytes, so small batches do not pay the overhead of a
+/// call each. With a `target_time` instead, the size of the batches adapts
+/// to their consumer: the time from handing out a batch to the next call
+/// of `get_next` is the time the consumer took to convert it, which gives
+/// the time per row of the result. Batches are then coalesced up to the
+/// rows expected to take `target_time`, and a batch too large for the
+/// target is never coalesced further.
+struct CoalesceStream {
+    struct ArrowArrayStream inner{};
+    struct ArrowSchema schema{};
+    // in nanoseconds
+    int64_t target_time = 0;
+    // the rows and bytes to coalesce batches up to, adapted to the
+    // consumer with a `target_time`, whose first batch is handed out as
+    // read to measure it
+    int64_t target_rows = 0;
+    int64_t target_bytes = kCoalesceMaxBytes;
+
+    // the moving average of the consumer time per row, in nanoseconds,
+    // 0 until measured
+    double row_time = 0;
+    int64_t last_rows = 0;
+    std::chrono::steady_clock::time_point handed_out;
+
+    // a batch read past the coalesced ones, and the error or end of the
+    // wrapped stream reached while coalescing, handed out next
+    struct ArrowArray pending{};
+    bool done = false;
+    int error_code = 0;
+    std::string last_error;
+};
+
+// Updates the time per row and the target rows of `coalesce` from the time
+// its consumer took on the last batch.
+static void coalesce_stream_measure(CoalesceStream * coalesce) {
+    if (coalesce->target_time <= 0 || coalesce->last_rows <= 0) return;
+
+    auto elapsed = std::chrono::steady_clock::now() - coalesce->handed_out;
+    double row_time = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / (double)coalesce->last_rows;
+    coalesce->row_time = coalesce->row_time == 0 ? row_time : 0.75 * coalesce->row_time + 0.25 * row_time;
+    double rows = coalesce->row_time > 0 ? (double)coalesce->target_time / coalesce->row_time : (double)kCoalesceMaxRows;
+    coalesce->target_rows = (int64_t)std::min<double>((double)kCoalesceMaxRows, std::max<double>((double)kCoalesceMinRows, rows));
+}
+
+// Reads the next batch of the wrapped stream, or the pending one.
+static int coalesce_stream_read(CoalesceStream * coalesce, struct ArrowArray * out) {
+    if (coalesce->pending.release != nullptr) {
+        *out = coalesce->pending;
+        coalesce->pending.release = nullptr;
+        return 0;
+    }
+    if (coalesce->done) {
+        out->release = nullptr;
+        return coalesce->error_code;
+    }
+    int code = coalesce->inner.get_next(&coalesce->inner, out);
+    if (code != 0) {
+        const char * reason = coalesce->inner.get_last_error(&coalesce->inner);
+        coalesce->error_code = code;
+        coalesce->last_error = reason ? reason : "unknown error";
+        coalesce->done = true;
+    } else if (out->release == nullptr) {
+        coalesce->done = true;
+    }
+    return code;
+}
+
+// Whether `batch` can be concatenated with others.
+static bool coalesce_stream_batch_supported(const struct ArrowArray * batch) {
+    bool has_validity = batch->n_buffers > 0 && batch->buffers && batch->buffers[0];
+    return batch->offset == 0 && !has_validity;
+}
+
+static int coalesce_stream_get_schema(struct ArrowArrayStream * stream, struct ArrowSchema * out) {
+    auto coalesce = (CoalesceStream *)stream->private_data;
+    return ArrowSchemaDeepCopy(&coalesce->schema, out);
+}
+
+static int coalesce_stream_get_next(struct ArrowArrayStream * stream, struct ArrowArray * out) {
+    auto coalesce = (CoalesceStream *)stream->private_data;
+    coalesce_stream_measure(coalesce);
+    coalesce->last_rows = 0;
+
+    struct ArrowArray first{};
+    int code = coalesce_stream_read(coalesce, &first);
+    if (code != 0 || first.release == nullptr) {
+        out->release = nullptr;
+        return code;
+    }
+
+    // batches are read until they have the target rows, and the error or
+    // end of the wrapped stream is only returned after them
+    std::vector<struct ArrowArray> batches;
+    batches.push_back(first);
+    int64_t rows = first.length;
+    int64_t bytes = adbc_memory_array_bytes(&coalesce->schema, &first);
+    bool supported = coalesce_stream_batch_supported(&first);
+    while (supported && rows < coalesce->target_rows && bytes < coalesce->target_bytes) {
+        struct ArrowArray next{};
+        if (coalesce_stream_read(coalesce, &next) != 0 || next.release == nullptr) break;
+        if (!coalesce_stream_batch_supported(&next)) {
+            coalesce->pending = next;
+            break;
+        }
+        batches.push_back(next);
+        rows += next.length;
+        bytes += adbc_memory_array_bytes(&coalesce->schema, &next);
+    }
+
+    if (batches.size() == 1) {
+        *out = first;
+    } else {
+        std::vector<const struct ArrowArray *> arrays;
+        for (auto &batch : batches) arrays.push_back(&batch);
+        std::string reason;
+        int failed = arrow_batch_concat(&coalesce->schema, arrays, out, reason);
+        for (auto &batch : batches) batch.release(&batch);
+        if (failed != 0) {
+            coalesce->last_error = reason;
+            coalesce->error_code = EIO;
+            coalesce->done = true;
+            out->release = nullptr;
+            return EIO;
+        }
+    }
+
+    coalesce->last_rows = out->length;
+    coalesce->handed_out = std::chrono::steady_clock::now();
+    return 0;
+}
+
+static const char * coalesce_stream_get_last_error(struct ArrowArrayStream * stream) {
+    auto coalesce = (CoalesceStream *)stream->private_data;
+    return coalesce->last_error.empty() ? nullptr : coalesce->last_error.c_str();
+}
+
+static void coalesce_stream_release(struct ArrowArrayStream * stream) {
+    auto coalesce = (CoalesceStream *)stream->private_data;
+    if (coalesce->pending.release) coalesce->pending.release(&coalesce->pending);
+    if (coalesce->inner.release) coalesce->inner.release(&coalesce->inner);
+    if (coalesce->schema.release) coalesce->schema.release(&coalesce->schema);
+    delete coalesce;
+
+    stream->private_data = nullptr;
+    stream->release = nullptr;
+}
+
+/// Replaces `stream` by a stream that coalesces its batches toward taking
+/// `target_time` nanoseconds each to consume when positive, and otherwise
+/// up to `target_rows` rows or `target_bytes` bytes, each ignored when 0.
+/// The original stream is owned and released by the new one. Streams whose
+/// batches cannot be concatenated, with nested or dictionary-encoded
+/// columns, are left as is.
+///
+/// Returns 0 on success. On failure, returns 1, `stream` is left untouched
+/// and `error` is set.
+static int arrow_array_stream_coalesce(struct ArrowArrayStream * stream, int64_t target_time, int64_t target_rows, int64_t target_bytes, std::string &error) {
+    if (stream->release == nullptr) {
+        error = "ArrowArrayStream has already been released";
+        return 1;
+    }
+
+    auto coalesce = new CoalesceStream();
+    coalesce->target_time = target_time;
+    if (target_time <= 0) {
+        coalesce->target_rows = target_rows > 0 ? target_rows : std::numeric_limits<int64_t>::max();
+        coalesce->target_bytes = target_bytes > 0 ? target_bytes : std::numeric_limits<int64_t>::max();
+    }
+    if (stream->get_schema(stream, &coalesce->schema) != 0) {
+        const char * reason = stream->get_last_error(stream);
+        error = reason ? reason : "unknown error";
+        delete coalesce;
+        return 1;
+    }
+    if (!arrow_batch_concat_supported(&coalesce->schema)) {
+        coalesce->schema.release(&coalesce->schema);
+        delete coalesce;
+        return 0;
+    }
+
+    memcpy(&coalesce->inner, stream, sizeof(struct ArrowArrayStream));
+    stream->get_schema = coalesce_stream_get_schema;
+    stream->get_next = coalesce_stream_get_next;
+    stream->get_last_error = coalesce_stream_get_last_error;
+    stream->release = coalesce_stream_release;
+    stream->private_data = coalesce;
+    return 0;
+}
+
+#endif  // ADBC_COALESCE_STREAM_HPP
@@ -1,15 +1,20 @@
 #ifndef ADBC_COLUMN_HPP
 #pragma once
 
-#include <time.h>
+#include <cerrno>
+#include <ctime>
 #include <cstdbool>
 #include <cstdint>
-#include <functional>
+#include <limits>
 #include <type_traits>
 #include <adbc.h>
 #include <erl_nif.h>
 #include "adbc_consts.h"
+#include "adbc_nif_resource.hpp"
 #include "nif_utils.hpp"
+#include "adbc_datetime.hpp"
+#include "adbc_decimal.hpp"
+#include "adbc_type_registry.hpp"
 
 ERL_NIF_TERM make_adbc_column(ErlNifEnv *env, ERL_NIF_TERM name_term, ERL_NIF_TERM type_term, bool nullable, ERL_NIF_TERM metadata, ERL_NIF_TERM data) {
     ERL_NIF_TERM nullable_term = nullable ? kAtomTrue : kAtomFalse;
@@ -46,503 +51,588 @@ ERL_NIF_TERM make_adbc_column(ErlNifEnv *env, const char * name, const char * ty
     return make_adbc_column(env, name_term, type, nullable, metadata, data);
 }
 
-template <typename Integer, typename std::enable_if<
-        std::is_integral<Integer>{} && std::is_signed<Integer>{}, bool>::type = true>
-int get_list_integer(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, const std::function<void(Integer val, bool is_nil)> &callback) {
-    ERL_NIF_TERM head, tail;
-    tail = list;
-    while (enif_get_list_cell(env, tail, &head, &tail)) {
-        int64_t val;
-        if (!erlang::nif::get(env, head, &val)) {
-            if (nullable && enif_is_identical(head, kAtomNil)) {
-                callback(0, true);
-            } else {
-                return 1;
-            }
-        }
-        callback((Integer)val, false);
+// Builders of columns from lists of values.
+//
+// Each `do_get_list_*` reserves the buffers of `array_out` for the
+// `n_items` values of `list` at once and writes values and validity
+// directly. Values are converted by functors, so that every builder is
+// specialized at compile time for its Arrow type. A converter returns 0,
+// `kErrorBufferInvalidValue` for a value it does not accept, or another
+// error code.
+//
+// The type of `schema_out` is only set when it has none yet, as it is the
+// schema cached by the statement when it is bound with columns of the
+// same types again, see `AdbcBindSchema`.
+
+// Walks the values of `list` into `array_out`, whose data buffers must be
+// reserved. `write(term, is_nil)` writes the value, or a placeholder for
+// nil, and nil is only accepted when `nullable`.
+template <typename Write>
+int append_list(ErlNifEnv *env, ERL_NIF_TERM list, unsigned n_items, bool nullable, struct ArrowArray* array_out, struct ArrowError* error_out, const Write &write) {
+    struct ArrowBitmap * validity = ArrowArrayValidityBitmap(array_out);
+    if (nullable) {
+        NANOARROW_RETURN_NOT_OK(ArrowBitmapReserve(validity, n_items));
     }
-    return 0;
-}
 
-template <typename Integer, typename std::enable_if<
-        std::is_integral<Integer>{} && !std::is_signed<Integer>{}, bool>::type = true>
-int get_list_integer(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, const std::function<void(Integer val, bool is_nil)> &callback) {
+    int64_t null_count = 0;
     ERL_NIF_TERM head, tail;
     tail = list;
     while (enif_get_list_cell(env, tail, &head, &tail)) {
-        uint64_t val;
-        if (!erlang::nif::get(env, head, &val)) {
-            if (nullable && enif_is_identical(head, kAtomNil)) {
-                callback(0, true);
-            } else {
-                return 1;
+        bool is_nil = nullable && enif_is_identical(head, kAtomNil);
+        int ret = write(head, is_nil);
+        if (ret != 0) {
+            if (ret == kErrorBufferInvalidValue) {
+                enif_snprintf(error_out->message, sizeof(error_out->message), "invalid value for `Adbc.Column`: `%T`.", head);
             }
+            return ret;
+        }
+        if (nullable) {
+            ArrowBitmapAppendUnsafe(validity, !is_nil, 1);
         }
-        callback((Integer)val, false);
+        null_count += is_nil;
     }
+
+    array_out->length = n_items;
+    array_out->null_count = null_count;
     return 0;
 }
 
-template <typename T>
-int do_get_list_integer(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, ArrowType nanoarrow_type, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
-    NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_out, nanoarrow_type));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(array_out, schema_out, error_out));
+// Appends the values of `list` to the fixed-width array `array_out` of
+// `T`, `convert(term, value)` converts the values that are not nil.
+template <typename T, typename Convert>
+int append_list_values(ErlNifEnv *env, ERL_NIF_TERM list, unsigned n_items, bool nullable, struct ArrowArray* array_out, struct ArrowError* error_out, const Convert &convert) {
     NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array_out));
-    if (nullable) {
-        return get_list_integer<T>(env, list, nullable, [&array_out](T val, bool is_nil) -> void {
-            ArrowArrayAppendInt(array_out, val);
-            if (is_nil) {
-                ArrowArrayAppendNull(array_out, 1);
-            }
-        });
-    } else {
-        return get_list_integer<T>(env, list, nullable, [&array_out](T val, bool) -> void {
-            ArrowArrayAppendInt(array_out, val);
-        });
-    }
+    NANOARROW_RETURN_NOT_OK(ArrowArrayReserve(array_out, n_items));
+    struct ArrowBuffer * data = ArrowArrayBuffer(array_out, 1);
+    return append_list(env, list, n_items, nullable, array_out, error_out, [&](ERL_NIF_TERM term, bool is_nil) -> int {
+        T value{};
+        if (!is_nil) {
+            int ret = convert(term, value);
+            if (ret != 0) return ret;
+        }
+        ArrowBufferAppendUnsafe(data, &value, sizeof(T));
+        return 0;
+    });
 }
 
-int get_list_float(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, const std::function<void(double val, bool is_nil)> &callback) {
-    ERL_NIF_TERM head, tail;
-    tail = list;
-    while (enif_get_list_cell(env, tail, &head, &tail)) {
-        double val;
-        if (!erlang::nif::get(env, head, &val)) {
-            if (nullable && enif_is_identical(head, kAtomNil)) {
-                callback(0, true);
-            } else {
-                return 1;
+template <typename Integer>
+int do_get_list_integer(ErlNifEnv *env, ERL_NIF_TERM list, unsigned n_items, bool nullable, ArrowType nanoarrow_type, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
+    if (schema_out->format == nullptr) {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_out, nanoarrow_type));
+    }
+    NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(array_out, schema_out, error_out));
+    return append_list_values<Integer>(env, list, n_items, nullable, array_out, error_out, [env](ERL_NIF_TERM term, Integer &value) -> int {
+        // values out of the range of the type are rejected instead of wrapped
+        if (std::is_signed<Integer>::value) {
+            int64_t val;
+            if (!erlang::nif::get(env, term, &val) || val < (int64_t)std::numeric_limits<Integer>::min() || val > (int64_t)std::numeric_limits<Integer>::max()) {
+                return kErrorBufferInvalidValue;
+            }
+            value = (Integer)val;
+        } else {
+            uint64_t val;
+            if (!erlang::nif::get(env, term, &val) || val > (uint64_t)std::numeric_limits<Integer>::max()) {
+                return kErrorBufferInvalidValue;
             }
+            value = (Integer)val;
         }
-        callback(val, false);
-    }
-    return 0;
+        return 0;
+    });
 }
 
-int do_get_list_float(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, ArrowType nanoarrow_type, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
-    NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_out, nanoarrow_type));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(array_out, schema_out, error_out));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array_out));
-    if (nullable) {
-        return get_list_float(env, list, nullable, [&array_out](double val, bool is_nil) -> void {
-            ArrowArrayAppendDouble(array_out, val);
-            if (is_nil) {
-                ArrowArrayAppendNull(array_out, 1);
-            }
-        });
-    } else {
-        return get_list_float(env, list, nullable, [&array_out](double val, bool) -> void {
-            ArrowArrayAppendDouble(array_out, val);
-        });
+template <typename Float>
+int do_get_list_float(ErlNifEnv *env, ERL_NIF_TERM list, unsigned n_items, bool nullable, ArrowType nanoarrow_type, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
+    if (schema_out->format == nullptr) {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_out, nanoarrow_type));
     }
+    NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(array_out, schema_out, error_out));
+    return append_list_values<Float>(env, list, n_items, nullable, array_out, error_out, [env](ERL_NIF_TERM term, Float &value) -> int {
+        double val;
+        if (!erlang::nif::get(env, term, &val)) {
+            return kErrorBufferInvalidValue;
+        }
+        value = (Float)val;
+        return 0;
+    });
 }
 
-int get_list_string(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, const std::function<void(struct ArrowStringView val, bool is_nil)> &callback) {
-    ERL_NIF_TERM head, tail;
-    tail = list;
-    while (enif_get_list_cell(env, tail, &head, &tail)) {
-        ErlNifBinary bytes;
-        struct ArrowStringView val{};
-        if (enif_is_binary(env, head) && enif_inspect_binary(env, head, &bytes)) {
-            val.data = (const char *)bytes.data;
-            val.size_bytes = static_cast<int64_t>(bytes.size);
-            callback(val, false);
-        } else if (nullable && enif_is_identical(head, kAtomNil)) {
-            callback(val, true);
+// The encoder of a primitive type of `AdbcPrimitiveTypes`, see
+// `kPrimitiveEncoders`.
+template <typename Primitive> struct PrimitiveEncoder {
+    static int call(ErlNifEnv *env, ERL_NIF_TERM list, unsigned n_items, bool nullable, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
+        using value_type = typename Primitive::value_type;
+        if constexpr (std::is_floating_point<value_type>::value) {
+            return do_get_list_float<value_type>(env, list, n_items, nullable, Primitive::type, array_out, schema_out, error_out);
         } else {
-            return 1;
+            return do_get_list_integer<value_type>(env, list, n_items, nullable, Primitive::type, array_out, schema_out, error_out);
         }
     }
-    return 0;
-}
+};
 
-int do_get_list_string(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, ArrowType nanoarrow_type, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
-    NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_out, nanoarrow_type));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(array_out, schema_out, error_out));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array_out));
-    if (nullable) {
-        return get_list_string(env, list, nullable, [&array_out](struct ArrowStringView val, bool is_nil) -> void {
-            ArrowArrayAppendString(array_out, val);
-            if (is_nil) {
-                ArrowArrayAppendNull(array_out, 1);
-            }
-        });
-    } else {
-        return get_list_string(env, list, nullable, [&array_out](struct ArrowStringView val, bool) -> void {
-            ArrowArrayAppendString(array_out, val);
-        });
+static constexpr auto kPrimitiveEncoders = adbc_primitive_table<PrimitiveEncoder>();
+
+// `Offset` is `int32_t` for strings and binaries, `int64_t` for their
+// large variants.
+template <typename Offset>
+int do_get_list_string(ErlNifEnv *env, ERL_NIF_TERM list, unsigned n_items, bool nullable, ArrowType nanoarrow_type, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
+    if (schema_out->format == nullptr) {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_out, nanoarrow_type));
     }
-}
+    NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(array_out, schema_out, error_out));
+    NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array_out));
 
-int get_list_boolean(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, const std::function<void(bool val, bool is_nil)> &callback) {
+    // a first pass sizes the data buffer, binaries are only inspected
+    int64_t size_bytes = 0;
     ERL_NIF_TERM head, tail;
     tail = list;
     while (enif_get_list_cell(env, tail, &head, &tail)) {
-        if (enif_is_identical(head, kAtomTrue)) {
-            callback(true, false);
-        } else if (enif_is_identical(head, kAtomFalse)) {
-            callback(false, false);
-        } else if (enif_is_identical(head, kAtomNil)) {
-            callback(true, true);
-        } else {
-            return 1;
+        ErlNifBinary bytes;
+        if (enif_inspect_binary(env, head, &bytes)) {
+            size_bytes += static_cast<int64_t>(bytes.size);
+        } else if (!(nullable && enif_is_identical(head, kAtomNil))) {
+            enif_snprintf(error_out->message, sizeof(error_out->message), "invalid value for `Adbc.Column`: `%T`.", head);
+            return kErrorBufferInvalidValue;
         }
     }
-    return 0;
+    if (size_bytes > (int64_t)std::numeric_limits<Offset>::max()) {
+        snprintf(error_out->message, sizeof(error_out->message), "column of %lld bytes is too large, use a large string or binary column instead.", (long long)size_bytes);
+        return kErrorBufferInvalidValue;
+    }
+
+    NANOARROW_RETURN_NOT_OK(ArrowArrayReserve(array_out, n_items));
+    struct ArrowBuffer * offsets = ArrowArrayBuffer(array_out, 1);
+    struct ArrowBuffer * data = ArrowArrayBuffer(array_out, 2);
+    NANOARROW_RETURN_NOT_OK(ArrowBufferReserve(data, size_bytes));
+
+    Offset offset = 0;
+    return append_list(env, list, n_items, nullable, array_out, error_out, [&](ERL_NIF_TERM term, bool is_nil) -> int {
+        ErlNifBinary bytes;
+        if (!is_nil && enif_inspect_binary(env, term, &bytes)) {
+            ArrowBufferAppendUnsafe(data, bytes.data, static_cast<int64_t>(bytes.size));
+            offset += static_cast<Offset>(bytes.size);
+        }
+        ArrowBufferAppendUnsafe(offsets, &offset, sizeof(Offset));
+        return 0;
+    });
 }
 
-int do_get_list_boolean(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, ArrowType nanoarrow_type, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
-    NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_out, nanoarrow_type));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(array_out, schema_out, error_out));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array_out));
-    if (nullable) {
-        return get_list_boolean(env, list, nullable, [&array_out](bool val, bool is_nil) -> void {
-            ArrowArrayAppendInt(array_out, val);
-            if (is_nil) {
-                ArrowArrayAppendNull(array_out, 1);
-            }
-        });
-    } else {
-        return get_list_boolean(env, list, nullable, [&array_out](bool val, bool) -> void {
-            ArrowArrayAppendInt(array_out, val);
-        });
+int do_get_list_boolean(ErlNifEnv *env, ERL_NIF_TERM list, unsigned n_items, bool nullable, ArrowType nanoarrow_type, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
+    if (schema_out->format == nullptr) {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_out, nanoarrow_type));
     }
+    NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(array_out, schema_out, error_out));
+    NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array_out));
+
+    // values are bits, all cleared up front
+    struct ArrowBuffer * data = ArrowArrayBuffer(array_out, 1);
+    NANOARROW_RETURN_NOT_OK(ArrowBufferAppendFill(data, 0, (static_cast<int64_t>(n_items) + 7) / 8));
+    int64_t i = 0;
+    return append_list(env, list, n_items, nullable, array_out, error_out, [&](ERL_NIF_TERM term, bool is_nil) -> int {
+        if (enif_is_identical(term, kAtomTrue)) {
+            ArrowBitSet(data->data, i);
+        } else if (!is_nil && !enif_is_identical(term, kAtomFalse)) {
+            return kErrorBufferInvalidValue;
+        }
+        i++;
+        return 0;
+    });
 }
 
-int get_list_fixed_size_binary(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, const std::function<void(struct ArrowBufferView val, bool is_nil)> &callback) {
+int do_get_list_fixed_size_binary(ErlNifEnv *env, ERL_NIF_TERM list, unsigned n_items, bool nullable, ArrowType nanoarrow_type, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
+    if (schema_out->format == nullptr) {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_out, nanoarrow_type));
+    }
+    NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(array_out, schema_out, error_out));
+    NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array_out));
+    NANOARROW_RETURN_NOT_OK(ArrowArrayReserve(array_out, n_items));
+
+    // nanoarrow checks the width of each value, so they are appended
     ERL_NIF_TERM head, tail;
     tail = list;
     while (enif_get_list_cell(env, tail, &head, &tail)) {
         ErlNifBinary bytes;
-        struct ArrowBufferView val{};
-        if (enif_is_binary(env, head) && enif_inspect_binary(env, head, &bytes)) {
+        if (enif_inspect_binary(env, head, &bytes)) {
+            struct ArrowBufferView val{};
             val.data.data = bytes.data;
             val.size_bytes = static_cast<int64_t>(bytes.size);
-            callback(val, false);
-        } if (nullable && enif_is_identical(head, kAtomNil)) {
-            callback(val, true);
+            NANOARROW_RETURN_NOT_OK(ArrowArrayAppendBytes(array_out, val));
+        } else if (nullable && enif_is_identical(head, kAtomNil)) {
+            NANOARROW_RETURN_NOT_OK(ArrowArrayAppendNull(array_out, 1));
         } else {
-            return 1;
+            enif_snprintf(error_out->message, sizeof(error_out->message), "invalid value for `Adbc.Column`: `%T`.", head);
+            return kErrorBufferInvalidValue;
         }
     }
     return 0;
 }
 
-int do_get_list_fixed_size_binary(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, ArrowType nanoarrow_type, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
-    NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_out, nanoarrow_type));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(array_out, schema_out, error_out));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array_out));
-    if (nullable) {
-        return get_list_fixed_size_binary(env, list, nullable, [&array_out](struct ArrowBufferView val, bool is_nil) -> void {
-            ArrowArrayAppendBytes(array_out, val);
-            if (is_nil) {
-                ArrowArrayAppendNull(array_out, 1);
-            }
-        });
-    } else {
-        return get_list_fixed_size_binary(env, list, nullable, [&array_out](struct ArrowBufferView val, bool) -> void {
-            ArrowArrayAppendBytes(array_out, val);
-        });
+// Reads the seconds since the epoch of a `Date`
+int get_date_seconds(ErlNifEnv *env, ERL_NIF_TERM term, int64_t &seconds) {
+    ERL_NIF_TERM struct_name_term, calendar_term, year_term, month_term, day_term;
+    if (!enif_is_map(env, term)) {
+        return kErrorBufferInvalidValue;
+    }
+    if (!enif_get_map_value(env, term, kAtomStructKey, &struct_name_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_is_identical(struct_name_term, kAtomDateModule)) {
+        return kErrorBufferWrongStruct;
     }
-}
 
-int get_utc_offset() {
-    time_t zero = 24 * 60 * 60L;
-    struct tm * timeptr;
-    int gmtime_hours;
-    timeptr = localtime(&zero);
-    gmtime_hours = timeptr->tm_hour;
-    if (timeptr->tm_mday < 2) {
-        gmtime_hours -= 24;
+    if (!enif_get_map_value(env, term, kAtomCalendarKey, &calendar_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_is_identical(calendar_term, kAtomCalendarISO)) {
+        return kErrorExpectedCalendarISO;
     }
-    return gmtime_hours;
-}
 
-int get_list_date(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, const std::function<int64_t(int64_t)> &normalize_ex_value, const std::function<void(int64_t val, bool is_nil)> &callback) {
-    ERL_NIF_TERM head, tail;
-    tail = list;
-    while (enif_get_list_cell(env, tail, &head, &tail)) {
-        if (enif_is_identical(head, kAtomNil)) {
-            callback(0, true);
-        } else {
-            int64_t val;
-            if (erlang::nif::get(env, head, &val)) {
-                callback(val, false);
-            } else if (enif_is_map(env, head)) {
-                ERL_NIF_TERM struct_name_term, calendar_term, year_term, month_term, day_term;
-                if (!enif_get_map_value(env, head, kAtomStructKey, &struct_name_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_is_identical(struct_name_term, kAtomDateModule)) {
-                    return kErrorBufferWrongStruct;
-                }
+    if (!enif_get_map_value(env, term, kAtomYearKey, &year_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_get_map_value(env, term, kAtomMonthKey, &month_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_get_map_value(env, term, kAtomDayKey, &day_term)) {
+        return kErrorBufferGetMapValue;
+    }
 
-                if (!enif_get_map_value(env, head, kAtomCalendarKey, &calendar_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_is_identical(calendar_term, kAtomCalendarISO)) {
-                    return kErrorExpectedCalendarISO;
-                }
+    tm time{};
+    if (!erlang::nif::get(env, year_term, &time.tm_year) || !erlang::nif::get(env, month_term, &time.tm_mon) || !erlang::nif::get(env, day_term, &time.tm_mday)) {
+        return kErrorBufferGetMapValue;
+    }
+    seconds = days_from_civil(time.tm_year, time.tm_mon, time.tm_mday) * 86400;
+    return 0;
+}
 
-                if (!enif_get_map_value(env, head, kAtomYearKey, &year_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_get_map_value(env, head, kAtomMonthKey, &month_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_get_map_value(env, head, kAtomDayKey, &day_term)) {
-                    return kErrorBufferGetMapValue;
-                }
+// Reads the microseconds of a `Time` or `NaiveDateTime`
+int get_microseconds(ErlNifEnv *env, ERL_NIF_TERM term, uint64_t &us) {
+    ERL_NIF_TERM microsecond_term;
+    if (!enif_get_map_value(env, term, kAtomMicrosecondKey, &microsecond_term)) {
+        return kErrorBufferGetMapValue;
+    }
 
-                tm time{};
-                if (!erlang::nif::get(env, year_term, &time.tm_year) || !erlang::nif::get(env, month_term, &time.tm_mon) || !erlang::nif::get(env, day_term, &time.tm_mday)) {
-                    return kErrorBufferGetMapValue;
-                }
-                time.tm_year -= 1900;
-                time.tm_mon -= 1;
-                // mktime always gives local time
-                // so we need to adjust it to UTC
-                val = mktime(&time) + get_utc_offset() * 3600;
-                callback(normalize_ex_value(val), false);
-            } else {
-                return 1;
-            }
-        }
+    const ERL_NIF_TERM *us_tuple = nullptr;
+    int us_arity;
+    int us_precision;
+    if (!enif_get_tuple(env, microsecond_term, &us_arity, &us_tuple) || us_arity != 2) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!erlang::nif::get(env, us_tuple[0], &us) || !erlang::nif::get(env, us_tuple[1], &us_precision)) {
+        return kErrorBufferGetMapValue;
     }
     return 0;
 }
 
-int do_get_list_date(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, ArrowType nanoarrow_type, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
-    NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_out, nanoarrow_type));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(array_out, schema_out, error_out));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array_out));
-    std::function<int64_t(int64_t)> normalize_ex_value;
-    if (nanoarrow_type == NANOARROW_TYPE_DATE32) {
-        normalize_ex_value = [](int64_t val) -> int64_t {
-            return val / (24 * 60 * 60);
-        };
-    } else {
-        normalize_ex_value = [](int64_t val) -> int64_t {
-            return val * 1000;
-        };
+// Reads the seconds since midnight and the microseconds of a `Time`
+int get_time_seconds(ErlNifEnv *env, ERL_NIF_TERM term, int64_t &seconds, uint64_t &us) {
+    ERL_NIF_TERM struct_name_term, calendar_term, hour_term, minute_term, second_term;
+    if (!enif_is_map(env, term)) {
+        return kErrorBufferInvalidValue;
     }
-    if (nullable) {
-        return get_list_date(env, list, nullable, normalize_ex_value, [&array_out](int64_t val, bool is_nil) -> void {
-            ArrowArrayAppendInt(array_out, val);
-            if (is_nil) {
-                ArrowArrayAppendNull(array_out, 1);
-            }
-        });
-    } else {
-        return get_list_date(env, list, nullable, normalize_ex_value, [&array_out](int64_t val, bool) -> void {
-            ArrowArrayAppendInt(array_out, val);
-        });
+    if (!enif_get_map_value(env, term, kAtomStructKey, &struct_name_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_is_identical(struct_name_term, kAtomTimeModule)) {
+        return kErrorBufferWrongStruct;
+    }
+
+    if (!enif_get_map_value(env, term, kAtomCalendarKey, &calendar_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_is_identical(calendar_term, kAtomCalendarISO)) {
+        return kErrorExpectedCalendarISO;
+    }
+
+    if (!enif_get_map_value(env, term, kAtomHourKey, &hour_term)) {
+        return kErrorBufferGetMapValue;
     }
+    if (!enif_get_map_value(env, term, kAtomMinuteKey, &minute_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_get_map_value(env, term, kAtomSecondKey, &second_term)) {
+        return kErrorBufferGetMapValue;
+    }
+
+    tm time{};
+    if (!erlang::nif::get(env, hour_term, &time.tm_hour) || !erlang::nif::get(env, minute_term, &time.tm_min) || !erlang::nif::get(env, second_term, &time.tm_sec)) {
+        return kErrorBufferGetMapValue;
+    }
+
+    seconds = time.tm_hour * 3600 + time.tm_min * 60 + time.tm_sec;
+    return get_microseconds(env, term, us);
 }
 
-int get_list_time(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, const std::function<int64_t(int64_t, uint64_t)> &normalize_ex_value, const std::function<void(int64_t val, bool is_nil)> &callback) {
-    ERL_NIF_TERM head, tail;
-    tail = list;
-    while (enif_get_list_cell(env, tail, &head, &tail)) {
-        if (enif_is_identical(head, kAtomNil)) {
-            callback(0, true);
-        } else {
-            int64_t val;
-            if (erlang::nif::get(env, head, &val)) {
-                callback(val, false);
-            } else if (enif_is_map(env, head)) {
-                ERL_NIF_TERM struct_name_term, calendar_term, hour_term, minute_term, second_term, microsecond_term;
-                if (!enif_get_map_value(env, head, kAtomStructKey, &struct_name_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_is_identical(struct_name_term, kAtomTimeModule)) {
-                    return kErrorBufferWrongStruct;
-                }
+// Reads the seconds since the epoch and the microseconds of a
+// `NaiveDateTime`
+int get_naive_datetime_seconds(ErlNifEnv *env, ERL_NIF_TERM term, int64_t &seconds, uint64_t &us) {
+    ERL_NIF_TERM struct_name_term, calendar_term, year_term, month_term, day_term, hour_term, minute_term, second_term;
+    if (!enif_is_map(env, term)) {
+        return kErrorBufferInvalidValue;
+    }
+    if (!enif_get_map_value(env, term, kAtomStructKey, &struct_name_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_is_identical(struct_name_term, kAtomNaiveDateTimeModule)) {
+        return kErrorBufferWrongStruct;
+    }
 
-                if (!enif_get_map_value(env, head, kAtomCalendarKey, &calendar_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_is_identical(calendar_term, kAtomCalendarISO)) {
-                    return kErrorExpectedCalendarISO;
-                }
+    if (!enif_get_map_value(env, term, kAtomCalendarKey, &calendar_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_is_identical(calendar_term, kAtomCalendarISO)) {
+        return kErrorExpectedCalendarISO;
+    }
 
-                if (!enif_get_map_value(env, head, kAtomHourKey, &hour_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_get_map_value(env, head, kAtomMinuteKey, &minute_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_get_map_value(env, head, kAtomSecondKey, &second_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_get_map_value(env, head, kAtomMicrosecondKey, &microsecond_term)) {
-                    return kErrorBufferGetMapValue;
-                }
+    if (!enif_get_map_value(env, term, kAtomYearKey, &year_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_get_map_value(env, term, kAtomMonthKey, &month_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_get_map_value(env, term, kAtomDayKey, &day_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_get_map_value(env, term, kAtomHourKey, &hour_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_get_map_value(env, term, kAtomMinuteKey, &minute_term)) {
+        return kErrorBufferGetMapValue;
+    }
+    if (!enif_get_map_value(env, term, kAtomSecondKey, &second_term)) {
+        return kErrorBufferGetMapValue;
+    }
 
-                tm time{};
-                if (!erlang::nif::get(env, hour_term, &time.tm_hour) || !erlang::nif::get(env, minute_term, &time.tm_min) || !erlang::nif::get(env, second_term, &time.tm_sec)) {
-                    return kErrorBufferGetMapValue;
-                }
+    tm time{};
+    if (!erlang::nif::get(env, year_term, &time.tm_year) ||
+        !erlang::nif::get(env, month_term, &time.tm_mon) ||
+        !erlang::nif::get(env, day_term, &time.tm_mday) ||
+        !erlang::nif::get(env, hour_term, &time.tm_hour) ||
+        !erlang::nif::get(env, minute_term, &time.tm_min) ||
+        !erlang::nif::get(env, second_term, &time.tm_sec)) {
+        return kErrorBufferGetMapValue;
+    }
 
-                const ERL_NIF_TERM *us_tuple = nullptr;
-                int us_arity;
-                uint64_t us;
-                int us_precision;
-                if (!enif_get_tuple(env, microsecond_term, &us_arity, &us_tuple) || us_arity != 2) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!erlang::nif::get(env, us_tuple[0], &us) || !erlang::nif::get(env, us_tuple[1], &us_precision)) {
-                    return kErrorBufferGetMapValue;
-                }
+    seconds = days_from_civil(time.tm_year, time.tm_mon, time.tm_mday) * 86400 +
+        time.tm_hour * 3600 + time.tm_min * 60 + time.tm_sec;
+    return get_microseconds(env, term, us);
+}
 
-                val = time.tm_hour * 3600 + time.tm_min * 60 + time.tm_sec;
-                callback(normalize_ex_value(val, us), false);
-            } else {
-                return 1;
-            }
+// Integers are taken as they are, while structs are read by
+// `get_seconds(term, seconds, us)` and converted by `normalize(seconds, us)`.
+template <typename T, typename GetSeconds, typename Normalize>
+int append_list_temporal(ErlNifEnv *env, ERL_NIF_TERM list, unsigned n_items, bool nullable, struct ArrowArray* array_out, struct ArrowError* error_out, const GetSeconds &get_seconds, const Normalize &normalize) {
+    return append_list_values<T>(env, list, n_items, nullable, array_out, error_out, [&](ERL_NIF_TERM term, T &value) -> int {
+        int64_t val;
+        if (erlang::nif::get(env, term, &val)) {
+            value = (T)val;
+            return 0;
         }
+
+        uint64_t us = 0;
+        int ret = get_seconds(term, val, us);
+        if (ret != 0) return ret;
+        value = (T)normalize(val, us);
+        return 0;
+    });
+}
+
+int do_get_list_date(ErlNifEnv *env, ERL_NIF_TERM list, unsigned n_items, bool nullable, ArrowType nanoarrow_type, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
+    if (schema_out->format == nullptr) {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_out, nanoarrow_type));
     }
-    return 0;
+    NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(array_out, schema_out, error_out));
+    auto get_seconds = [env](ERL_NIF_TERM term, int64_t &seconds, uint64_t &) -> int {
+        return get_date_seconds(env, term, seconds);
+    };
+    if (nanoarrow_type == NANOARROW_TYPE_DATE32) {
+        return append_list_temporal<int32_t>(env, list, n_items, nullable, array_out, error_out, get_seconds, [](int64_t val, uint64_t) -> int64_t {
+            return val / (24 * 60 * 60);
+        });
+    }
+    return append_list_temporal<int64_t>(env, list, n_items, nullable, array_out, error_out, get_seconds, [](int64_t val, uint64_t) -> int64_t {
+        return val * 1000;
+    });
 }
 
-int do_get_list_time(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, ArrowType nanoarrow_type, enum ArrowTimeUnit time_unit, uint64_t unit, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
-    NANOARROW_RETURN_NOT_OK(ArrowSchemaSetTypeDateTime(schema_out, nanoarrow_type, time_unit, NULL));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(array_out, schema_out, error_out));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array_out));
+int do_get_list_time(ErlNifEnv *env, ERL_NIF_TERM list, unsigned n_items, bool nullable, ArrowType nanoarrow_type, enum ArrowTimeUnit time_unit, uint64_t unit, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
+    if (schema_out->format == nullptr) {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetTypeDateTime(schema_out, nanoarrow_type, time_unit, NULL));
+    }
+    NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(array_out, schema_out, error_out));
+    auto get_seconds = [env](ERL_NIF_TERM term, int64_t &seconds, uint64_t &us) -> int {
+        return get_time_seconds(env, term, seconds, us);
+    };
     auto normalize_ex_value = [=](int64_t val, uint64_t us) -> int64_t {
         if (time_unit == NANOARROW_TIME_UNIT_SECOND) {
             return val;
         }
-        val = (val * 1000000 + us) * 1000 / unit;
-        return val;
+        return (val * 1000000 + us) * 1000 / unit;
     };
-    if (nullable) {
-        return get_list_time(env, list, nullable, normalize_ex_value, [&array_out](int64_t val, bool is_nil) -> void {
-            ArrowArrayAppendInt(array_out, val);
-            if (is_nil) {
-                ArrowArrayAppendNull(array_out, 1);
-            }
-        });
-    } else {
-        return get_list_time(env, list, nullable, normalize_ex_value, [&array_out](int64_t val, bool) -> void {
-            ArrowArrayAppendInt(array_out, val);
-        });
+    if (nanoarrow_type == NANOARROW_TYPE_TIME32) {
+        return append_list_temporal<int32_t>(env, list, n_items, nullable, array_out, error_out, get_seconds, normalize_ex_value);
     }
+    return append_list_temporal<int64_t>(env, list, n_items, nullable, array_out, error_out, get_seconds, normalize_ex_value);
 }
 
-int get_list_timestamp(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, const std::function<int64_t(int64_t, uint64_t)> &normalize_ex_value, const std::function<void(int64_t val, bool is_nil)> &callback) {
+int do_get_list_timestamp(ErlNifEnv *env, ERL_NIF_TERM list, unsigned n_items, bool nullable, ArrowType nanoarrow_type, enum ArrowTimeUnit time_unit, uint64_t unit, const char * timezone, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
+    if (schema_out->format == nullptr) {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetTypeDateTime(schema_out, nanoarrow_type, time_unit, timezone));
+    }
+    NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(array_out, schema_out, error_out));
+    auto get_seconds = [env](ERL_NIF_TERM term, int64_t &seconds, uint64_t &us) -> int {
+        return get_naive_datetime_seconds(env, term, seconds, us);
+    };
+    auto normalize_ex_value = [=](int64_t val, uint64_t us) -> int64_t {
+        if (time_unit == NANOARROW_TIME_UNIT_SECOND) {
+            return val;
+        }
+        return (val * 1000000 + us) * 1000 / unit;
+    };
+    return append_list_temporal<int64_t>(env, list, n_items, nullable, array_out, error_out, get_seconds, normalize_ex_value);
+}
+
+// non-zero return value indicating errors
+// Values are `{coefficient, exponent}` tuples whose exponent is the
+// opposite of `scale`, as returned for decimal columns, or nil.
+int do_get_list_decimal(ErlNifEnv *env, ERL_NIF_TERM list, unsigned n_items, bool nullable, int32_t bitwidth, int32_t precision, int32_t scale, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
+    ArrowType nanoarrow_type = bitwidth == 128 ? NANOARROW_TYPE_DECIMAL128 : NANOARROW_TYPE_DECIMAL256;
+    if (schema_out->format == nullptr) {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetTypeDecimal(schema_out, nanoarrow_type, precision, scale));
+    }
+    NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(array_out, schema_out, error_out));
+    NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array_out));
+    NANOARROW_RETURN_NOT_OK(ArrowArrayReserve(array_out, n_items));
+
+    struct ArrowDecimal decimal;
+    ArrowDecimalInit(&decimal, bitwidth, precision, scale);
     ERL_NIF_TERM head, tail;
     tail = list;
     while (enif_get_list_cell(env, tail, &head, &tail)) {
-        if (enif_is_identical(head, kAtomNil)) {
-            callback(0, true);
+        const ERL_NIF_TERM *tuple = nullptr;
+        int arity = 0, exponent = 0;
+        if (nullable && enif_is_identical(head, kAtomNil)) {
+            NANOARROW_RETURN_NOT_OK(ArrowArrayAppendNull(array_out, 1));
+        } else if (enif_get_tuple(env, head, &arity, &tuple) && arity == 2 &&
+                   enif_get_int(env, tuple[1], &exponent) && exponent == -scale &&
+                   arrow_decimal_from_nif_term(env, tuple[0], &decimal)) {
+            NANOARROW_RETURN_NOT_OK(ArrowArrayAppendDecimal(array_out, &decimal));
         } else {
-            int64_t val;
-            if (erlang::nif::get(env, head, &val)) {
-                callback(val, false);
-            } else if (enif_is_map(env, head)) {
-                ERL_NIF_TERM struct_name_term, calendar_term, year_term, month_term, day_term, hour_term, minute_term, second_term, microsecond_term;
-                if (!enif_get_map_value(env, head, kAtomStructKey, &struct_name_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_is_identical(struct_name_term, kAtomNaiveDateTimeModule)) {
-                    return kErrorBufferWrongStruct;
-                }
+            enif_snprintf(error_out->message, sizeof(error_out->message), "invalid decimal%d value with scale %d: `%T`", bitwidth, scale, head);
+            return kErrorBufferInvalidDecimal;
+        }
+    }
+    return 0;
+}
 
-                if (!enif_get_map_value(env, head, kAtomCalendarKey, &calendar_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_is_identical(calendar_term, kAtomCalendarISO)) {
-                    return kErrorExpectedCalendarISO;
-                }
+static void arrow_column_reference_release(struct ArrowArray * array) {
+    enif_release_resource(array->private_data);
+    array->private_data = nullptr;
+    array->release = nullptr;
+}
 
-                if (!enif_get_map_value(env, head, kAtomYearKey, &year_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_get_map_value(env, head, kAtomMonthKey, &month_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_get_map_value(env, head, kAtomDayKey, &day_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_get_map_value(env, head, kAtomHourKey, &hour_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_get_map_value(env, head, kAtomMinuteKey, &minute_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_get_map_value(env, head, kAtomSecondKey, &second_term)) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!enif_get_map_value(env, head, kAtomMicrosecondKey, &microsecond_term)) {
-                    return kErrorBufferGetMapValue;
-                }
+// Makes `array_out` an array of `length` values of `reference` starting at
+// `offset`, sharing its buffers. The record batch of `reference` is kept in
+// memory until `array_out` is released.
+static void arrow_column_reference_to_arrow_array(NifRes<ArrowColumnReference> * reference, int64_t offset, int64_t length, struct ArrowArray* array_out) {
+    struct ArrowArray * values = reference->val.values;
+    memset(array_out, 0, sizeof(struct ArrowArray));
+    array_out->length = length;
+    array_out->offset = values->offset + offset;
+    array_out->null_count = (offset == 0 && length == values->length) ? values->null_count : -1;
+    array_out->n_buffers = values->n_buffers;
+    array_out->buffers = values->buffers;
 
-                tm time{};
-                if (!erlang::nif::get(env, year_term, &time.tm_year) ||
-                    !erlang::nif::get(env, month_term, &time.tm_mon) ||
-                    !erlang::nif::get(env, day_term, &time.tm_mday) ||
-                    !erlang::nif::get(env, hour_term, &time.tm_hour) ||
-                    !erlang::nif::get(env, minute_term, &time.tm_min) ||
-                    !erlang::nif::get(env, second_term, &time.tm_sec)) {
-                    return kErrorBufferGetMapValue;
-                }
+    enif_keep_resource(reference);
+    array_out->private_data = reference;
+    array_out->release = arrow_column_reference_release;
+}
 
-                const ERL_NIF_TERM *us_tuple = nullptr;
-                int us_arity;
-                uint64_t us;
-                int us_precision;
-                if (!enif_get_tuple(env, microsecond_term, &us_arity, &us_tuple) || us_arity != 2) {
-                    return kErrorBufferGetMapValue;
-                }
-                if (!erlang::nif::get(env, us_tuple[0], &us) || !erlang::nif::get(env, us_tuple[1], &us_precision)) {
-                    return kErrorBufferGetMapValue;
-                }
+static void raw_buffer_free(struct ArrowBufferAllocator* allocator, uint8_t*, int64_t) {
+    enif_free_env((ErlNifEnv *)allocator->private_data);
+}
 
-                time.tm_year -= 1900;
-                time.tm_mon -= 1;
-                // mktime always gives local time
-                // so we need to adjust it to UTC
-                val = mktime(&time) + get_utc_offset() * 3600;
-                callback(normalize_ex_value(val, us), false);
-            } else {
-                return 1;
-            }
-        }
+// Makes `buffer` point to the bytes of `binary` without copying them. A
+// copy of the term is kept in a process-independent env, which shares
+// refc binaries, until the buffer is released.
+static int raw_buffer_wrap(ERL_NIF_TERM binary, struct ArrowBuffer * buffer) {
+    ArrowBufferInit(buffer);
+
+    ErlNifEnv * owner = enif_alloc_env();
+    if (owner == nullptr) return ENOMEM;
+    ErlNifBinary bytes;
+    if (!enif_inspect_binary(owner, enif_make_copy(owner, binary), &bytes) || bytes.size == 0) {
+        enif_free_env(owner);
+        return 0;
     }
+
+    NANOARROW_RETURN_NOT_OK(ArrowBufferSetAllocator(buffer, ArrowBufferDeallocator(raw_buffer_free, owner)));
+    buffer->data = bytes.data;
+    buffer->size_bytes = static_cast<int64_t>(bytes.size);
+    buffer->capacity_bytes = static_cast<int64_t>(bytes.size);
     return 0;
 }
 
-int do_get_list_timestamp(ErlNifEnv *env, ERL_NIF_TERM list, bool nullable, ArrowType nanoarrow_type, enum ArrowTimeUnit time_unit, uint64_t unit, const char * timezone, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
-    NANOARROW_RETURN_NOT_OK(ArrowSchemaSetTypeDateTime(schema_out, nanoarrow_type, time_unit, timezone));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(array_out, schema_out, error_out));
-    NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array_out));
-    auto normalize_ex_value = [=](int64_t val, uint64_t us) -> int64_t {
-        if (time_unit == NANOARROW_TIME_UNIT_SECOND) {
-            return val;
-        }
-        val = (val * 1000000 + us) * 1000 / unit;
-        return val;
-    };
-    if (nullable) {
-        return get_list_timestamp(env, list, nullable, normalize_ex_value, [&array_out](int64_t val, bool is_nil) -> void {
-            ArrowArrayAppendInt(array_out, val);
-            if (is_nil) {
-                ArrowArrayAppendNull(array_out, 1);
-            }
-        });
-    } else {
-        return get_list_timestamp(env, list, nullable, normalize_ex_value, [&array_out](int64_t val, bool) -> void {
-            ArrowArrayAppendInt(array_out, val);
-        });
+// Replaces the buffers of the empty fixed-width `array_out` by the binaries
+// of `{:raw, values, validity}`, so that they are bound without conversion.
+static int adbc_column_set_raw_data(ErlNifEnv *env, ERL_NIF_TERM type_term, ERL_NIF_TERM values, ERL_NIF_TERM validity, bool nullable, struct ArrowArray* array_out, struct ArrowError* error_out) {
+    auto private_data = (struct ArrowArrayPrivateData *)array_out->private_data;
+    const struct ArrowLayout &layout = private_data->layout;
+    int64_t width = layout.element_size_bits[1] / 8;
+    if (layout.buffer_type[0] != NANOARROW_BUFFER_TYPE_VALIDITY || layout.buffer_type[1] != NANOARROW_BUFFER_TYPE_DATA ||
+        layout.buffer_type[2] != NANOARROW_BUFFER_TYPE_NONE || layout.element_size_bits[1] % 8 != 0 || width == 0) {
+        enif_snprintf(error_out->message, sizeof(error_out->message), "raw `data` is not supported for columns of type `%T`.", type_term);
+        return kErrorBufferInvalidRawData;
+    }
+
+    ErlNifBinary values_bytes, validity_bytes;
+    if (!enif_inspect_binary(env, values, &values_bytes) || values_bytes.size % width != 0) {
+        snprintf(error_out->message, sizeof(error_out->message), "expected the raw values of `Adbc.Column` to be a binary of %lld-byte values.", (long long)width);
+        return kErrorBufferInvalidRawData;
+    }
+    int64_t length = static_cast<int64_t>(values_bytes.size) / width;
+
+    bool has_validity = !enif_is_identical(validity, kAtomNil);
+    if (has_validity && !nullable) {
+        snprintf(error_out->message, sizeof(error_out->message), "a validity bitmap is only accepted by nullable columns.");
+        return kErrorBufferInvalidRawData;
+    }
+    if (has_validity && (!enif_inspect_binary(env, validity, &validity_bytes) || static_cast<int64_t>(validity_bytes.size) < (length + 7) / 8)) {
+        snprintf(error_out->message, sizeof(error_out->message), "expected the validity bitmap of `Adbc.Column` to have a bit for each of the %lld values.", (long long)length);
+        return kErrorBufferInvalidRawData;
     }
+
+    struct ArrowBuffer buffer;
+    NANOARROW_RETURN_NOT_OK(raw_buffer_wrap(values, &buffer));
+    ArrowBufferReset(ArrowArrayBuffer(array_out, 1));
+    NANOARROW_RETURN_NOT_OK(ArrowArraySetBuffer(array_out, 1, &buffer));
+
+    array_out->null_count = 0;
+    if (has_validity) {
+        struct ArrowBitmap * bitmap = ArrowArrayValidityBitmap(array_out);
+        NANOARROW_RETURN_NOT_OK(raw_buffer_wrap(validity, &buffer));
+        ArrowBufferReset(&bitmap->buffer);
+        NANOARROW_RETURN_NOT_OK(ArrowArraySetBuffer(array_out, 0, &buffer));
+        bitmap->size_bits = length;
+        array_out->null_count = length - ArrowBitCountSet(bitmap->buffer.data, 0, length);
+    }
+    array_out->length = length;
+    return 0;
 }
 
-// non-zero return value indicating errors
-int adbc_column_to_adbc_field(ErlNifEnv *env, ERL_NIF_TERM adbc_buffer, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
+// `lazy_out` is set to the values of a lazy column, while `array_out` is
+// then an empty placeholder the caller must replace once the parent array
+// is built, as nanoarrow can only finish arrays it created itself.
+//
+// When `trusted`, the array is finished without being validated, as the
+// builders above already wrote as many values as the list has, and `data`
+// is only checked to be a proper list once, by taking its length.
+//
+// When `reuse_schema`, `schema_out` is the schema built for a column of the
+// same name, type, nullability and metadata before, which is left as is,
+// and the column must not be lazy.
+int adbc_column_to_adbc_field(ErlNifEnv *env, ERL_NIF_TERM adbc_buffer, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowArray* lazy_out, struct ArrowError* error_out, bool trusted = false, bool reuse_schema = false) {
     array_out->release = NULL;
-    schema_out->release = NULL;
+    if (!reuse_schema) schema_out->release = NULL;
 
     if (!enif_is_map(env, adbc_buffer)) {
         return kErrorBufferIsNotAMap;
@@ -571,16 +661,38 @@ int adbc_column_to_adbc_field(ErlNifEnv *env, ERL_NIF_TERM adbc_buffer, struct A
     if (!enif_get_map_value(env, adbc_buffer, kAtomDataKey, &data_term)) {
         return kErrorBufferGetMapValue;
     }
-    if (!enif_is_list(env, data_term)) {
-        return kErrorBufferDataIsNotAList;
-    }
+    NifRes<ArrowColumnReference> * lazy = nullptr;
+    int64_t lazy_offset = 0, lazy_length = 0;
     unsigned n_items = 0;
-    if (!enif_get_list_length(env, data_term, &n_items)) {
-        return kErrorBufferGetDataListLength;
+    const ERL_NIF_TERM *data_tuple = nullptr;
+    int data_arity = 0;
+    // raw data is bound by building an empty column of its type, whose
+    // buffers are then replaced by its binaries
+    bool raw = false;
+    ERL_NIF_TERM raw_values{}, raw_validity{};
+    if (enif_get_tuple(env, data_term, &data_arity, &data_tuple) && data_arity == 4 && enif_is_identical(data_tuple[0], kAtomLazy)) {
+        ERL_NIF_TERM error{};
+        lazy = NifRes<ArrowColumnReference>::get_resource(env, data_tuple[1], error);
+        if (lazy == nullptr || !erlang::nif::get(env, data_tuple[2], &lazy_offset) || !erlang::nif::get(env, data_tuple[3], &lazy_length) ||
+            lazy_offset < 0 || lazy_length < 0 || lazy_offset + lazy_length > lazy->val.values->length) {
+            return kErrorBufferInvalidLazyData;
+        }
+    } else if (data_arity == 3 && enif_is_identical(data_tuple[0], kAtomRaw)) {
+        raw = true;
+        raw_values = data_tuple[1];
+        raw_validity = data_tuple[2];
+        data_term = enif_make_list(env, 0);
+    } else {
+        if (!trusted && !enif_is_list(env, data_term)) {
+            return kErrorBufferDataIsNotAList;
+        }
+        if (!enif_get_list_length(env, data_term, &n_items)) {
+            return kErrorBufferGetDataListLength;
+        }
     }
 
     std::string name;
-    if (!enif_is_identical(name_term, kAtomNil)) {
+    if (!reuse_schema && !enif_is_identical(name_term, kAtomNil)) {
         if (!erlang::nif::get(env, name_term, name)) {
             erlang::nif::get_atom(env, name_term, name);
         }
@@ -590,7 +702,7 @@ int adbc_column_to_adbc_field(ErlNifEnv *env, ERL_NIF_TERM adbc_buffer, struct A
 
     struct ArrowBuffer metadata_buffer{};
     NANOARROW_RETURN_NOT_OK(ArrowMetadataBuilderInit(&metadata_buffer, nullptr));
-    if (enif_is_map(env, metadata_term)) {
+    if (!reuse_schema && enif_is_map(env, metadata_term)) {
         ERL_NIF_TERM metadata_key, metadata_value;
         ErlNifMapIterator iter;
         enif_map_iterator_create(env, metadata_term, &iter, ERL_NIF_MAP_ITERATOR_FIRST);
@@ -623,76 +735,84 @@ int adbc_column_to_adbc_field(ErlNifEnv *env, ERL_NIF_TERM adbc_buffer, struct A
         enif_map_iterator_destroy(env, &iter);
     }
 
-    ArrowSchemaInit(schema_out);
-    NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema_out, name.c_str()));
-    NANOARROW_RETURN_NOT_OK(ArrowSchemaSetMetadata(schema_out, (const char*)metadata_buffer.data));
+    if (lazy != nullptr) {
+        int code = ArrowSchemaDeepCopy(&lazy->val.schema, schema_out);
+        if (code == NANOARROW_OK) code = ArrowSchemaSetName(schema_out, name.c_str());
+        if (code == NANOARROW_OK) code = ArrowSchemaSetMetadata(schema_out, (const char*)metadata_buffer.data);
+        ArrowBufferReset(&metadata_buffer);
+        if (code == NANOARROW_OK) code = ArrowArrayInitFromSchema(array_out, schema_out, error_out);
+        if (code != NANOARROW_OK) {
+            if (schema_out->release) schema_out->release(schema_out);
+            return code;
+        }
+        arrow_column_reference_to_arrow_array(lazy, lazy_offset, lazy_length, lazy_out);
+        return 0;
+    }
+
+    if (!reuse_schema) {
+        ArrowSchemaInit(schema_out);
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema_out, name.c_str()));
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetMetadata(schema_out, (const char*)metadata_buffer.data));
+    }
     ArrowBufferReset(&metadata_buffer);
 
     int ret = kErrorBufferUnknownType;
-    if (enif_is_identical(type_term, kAdbcColumnTypeI8)) {
-        ret = do_get_list_integer<int8_t>(env, data_term, nullable, NANOARROW_TYPE_INT8, array_out, schema_out, error_out);
-    } else if (enif_is_identical(type_term, kAdbcColumnTypeI16)) {
-        ret = do_get_list_integer<int16_t>(env, data_term, nullable, NANOARROW_TYPE_INT16, array_out, schema_out, error_out);
-    } else if (enif_is_identical(type_term, kAdbcColumnTypeI32)) {
-        ret = do_get_list_integer<int32_t>(env, data_term, nullable, NANOARROW_TYPE_INT32, array_out, schema_out, error_out);
-    } else if (enif_is_identical(type_term, kAdbcColumnTypeI64)) {
-        ret = do_get_list_integer<int64_t>(env, data_term, nullable, NANOARROW_TYPE_INT64, array_out, schema_out, error_out);
-    } else if (enif_is_identical(type_term, kAdbcColumnTypeU8)) {
-        ret = do_get_list_integer<uint8_t>(env, data_term, nullable, NANOARROW_TYPE_UINT8, array_out, schema_out, error_out);
-    } else if (enif_is_identical(type_term, kAdbcColumnTypeU16)) {
-        ret = do_get_list_integer<uint16_t>(env, data_term, nullable, NANOARROW_TYPE_UINT16, array_out, schema_out, error_out);
-    } else if (enif_is_identical(type_term, kAdbcColumnTypeU32)) {
-        ret = do_get_list_integer<uint32_t>(env, data_term, nullable, NANOARROW_TYPE_UINT32, array_out, schema_out, error_out);
-    } else if (enif_is_identical(type_term, kAdbcColumnTypeU64)) {
-        ret = do_get_list_integer<uint64_t>(env, data_term, nullable, NANOARROW_TYPE_UINT64, array_out, schema_out, error_out);
-    } else if (enif_is_identical(type_term, kAdbcColumnTypeF32)) {
-        ret = do_get_list_float(env, data_term, nullable, NANOARROW_TYPE_FLOAT, array_out, schema_out, error_out);
-    } else if (enif_is_identical(type_term, kAdbcColumnTypeF64)) {
-        ret = do_get_list_float(env, data_term, nullable, NANOARROW_TYPE_DOUBLE, array_out, schema_out, error_out);
+    if (int primitive = adbc_primitive_index_of_column_type(type_term); primitive >= 0) {
+        ret = kPrimitiveEncoders[primitive](env, data_term, n_items, nullable, array_out, schema_out, error_out);
     } else if (enif_is_identical(type_term, kAdbcColumnTypeString)) {
-        ret = do_get_list_string(env, data_term, nullable, NANOARROW_TYPE_STRING, array_out, schema_out, error_out);
+        ret = do_get_list_string<int32_t>(env, data_term, n_items, nullable, NANOARROW_TYPE_STRING, array_out, schema_out, error_out);
     } else if (enif_is_identical(type_term, kAdbcColumnTypeLargeString)) {
-        ret = do_get_list_string(env, data_term, nullable, NANOARROW_TYPE_LARGE_STRING, array_out, schema_out, error_out);
+        ret = do_get_list_string<int64_t>(env, data_term, n_items, nullable, NANOARROW_TYPE_LARGE_STRING, array_out, schema_out, error_out);
     } else if (enif_is_identical(type_term, kAdbcColumnTypeBinary)) {
-        ret = do_get_list_string(env, data_term, nullable, NANOARROW_TYPE_BINARY, array_out, schema_out, error_out);
+        ret = do_get_list_string<int32_t>(env, data_term, n_items, nullable, NANOARROW_TYPE_BINARY, array_out, schema_out, error_out);
     } else if (enif_is_identical(type_term, kAdbcColumnTypeLargeBinary)) {
-        ret = do_get_list_string(env, data_term, nullable, NANOARROW_TYPE_LARGE_BINARY, array_out, schema_out, error_out);
+        ret = do_get_list_string<int64_t>(env, data_term, n_items, nullable, NANOARROW_TYPE_LARGE_BINARY, array_out, schema_out, error_out);
     } else if (enif_is_identical(type_term, kAdbcColumnTypeFixedSizeBinary)) {
-        ret = do_get_list_fixed_size_binary(env, data_term, nullable, NANOARROW_TYPE_FIXED_SIZE_BINARY, array_out, schema_out, error_out);
+        ret = do_get_list_fixed_size_binary(env, data_term, n_items, nullable, NANOARROW_TYPE_FIXED_SIZE_BINARY, array_out, schema_out, error_out);
     } else if (enif_is_identical(type_term, kAdbcColumnTypeDate32)) {
-        ret = do_get_list_date(env, data_term, nullable, NANOARROW_TYPE_DATE32, array_out, schema_out, error_out);
+        ret = do_get_list_date(env, data_term, n_items, nullable, NANOARROW_TYPE_DATE32, array_out, schema_out, error_out);
     } else if (enif_is_identical(type_term, kAdbcColumnTypeDate64)) {
-        ret = do_get_list_date(env, data_term, nullable, NANOARROW_TYPE_DATE64, array_out, schema_out, error_out);
+        ret = do_get_list_date(env, data_term, n_items, nullable, NANOARROW_TYPE_DATE64, array_out, schema_out, error_out);
     } else if (enif_is_identical(type_term, kAdbcColumnTypeBool)) {
-        ret = do_get_list_boolean(env, data_term, nullable, NANOARROW_TYPE_BOOL, array_out, schema_out, error_out);
+        ret = do_get_list_boolean(env, data_term, n_items, nullable, NANOARROW_TYPE_BOOL, array_out, schema_out, error_out);
     } else if (enif_is_tuple(env, type_term)) {
         // NANOARROW_TYPE_TIME32
         // NANOARROW_TYPE_TIME64
         if (enif_is_identical(type_term, kAdbcColumnTypeTime32Seconds)) {
-            ret = do_get_list_time(env, data_term, nullable, NANOARROW_TYPE_TIME32, NANOARROW_TIME_UNIT_SECOND, 1000000000, array_out, schema_out, error_out);
+            ret = do_get_list_time(env, data_term, n_items, nullable, NANOARROW_TYPE_TIME32, NANOARROW_TIME_UNIT_SECOND, 1000000000, array_out, schema_out, error_out);
         } else if (enif_is_identical(type_term, kAdbcColumnTypeTime32Milliseconds)) {
-            ret = do_get_list_time(env, data_term, nullable, NANOARROW_TYPE_TIME32, NANOARROW_TIME_UNIT_MILLI, 1000000, array_out, schema_out, error_out);
+            ret = do_get_list_time(env, data_term, n_items, nullable, NANOARROW_TYPE_TIME32, NANOARROW_TIME_UNIT_MILLI, 1000000, array_out, schema_out, error_out);
         } else if (enif_is_identical(type_term, kAdbcColumnTypeTime64Microseconds)) {
-            ret = do_get_list_time(env, data_term, nullable, NANOARROW_TYPE_TIME64, NANOARROW_TIME_UNIT_MICRO, 1000, array_out, schema_out, error_out);
+            ret = do_get_list_time(env, data_term, n_items, nullable, NANOARROW_TYPE_TIME64, NANOARROW_TIME_UNIT_MICRO, 1000, array_out, schema_out, error_out);
         } else if (enif_is_identical(type_term, kAdbcColumnTypeTime64Nanoseconds)) {
-            ret = do_get_list_time(env, data_term, nullable, NANOARROW_TYPE_TIME64, NANOARROW_TIME_UNIT_NANO, 1, array_out, schema_out, error_out);
+            ret = do_get_list_time(env, data_term, n_items, nullable, NANOARROW_TYPE_TIME64, NANOARROW_TIME_UNIT_NANO, 1, array_out, schema_out, error_out);
         } else {
             const ERL_NIF_TERM *tuple = nullptr;
             int arity;
             if (enif_get_tuple(env, type_term, &arity, &tuple)) {
+                if (arity == 4 && enif_is_identical(tuple[0], kAtomDecimal)) {
+                    // NANOARROW_TYPE_DECIMAL128
+                    // NANOARROW_TYPE_DECIMAL256
+                    int bitwidth = 0, precision = 0, scale = 0;
+                    if (enif_get_int(env, tuple[1], &bitwidth) && (bitwidth == 128 || bitwidth == 256) &&
+                        enif_get_int(env, tuple[2], &precision) && precision >= 1 && precision <= (bitwidth == 128 ? 38 : 76) &&
+                        enif_get_int(env, tuple[3], &scale)) {
+                        ret = do_get_list_decimal(env, data_term, n_items, nullable, bitwidth, precision, scale, array_out, schema_out, error_out);
+                    }
+                }
                 if (arity == 3) {
                     // NANOARROW_TYPE_TIMESTAMP
                     if (enif_is_identical(tuple[0], kAtomTimestamp)) {
                         std::string timezone;
                         if (erlang::nif::get(env, tuple[2], timezone) && !timezone.empty()) {
                             if (enif_is_identical(tuple[1], kAtomSeconds)) {
-                                ret = do_get_list_timestamp(env, data_term, nullable, NANOARROW_TYPE_TIMESTAMP, NANOARROW_TIME_UNIT_SECOND, 1000000000, timezone.c_str(), array_out, schema_out, error_out);
+                                ret = do_get_list_timestamp(env, data_term, n_items, nullable, NANOARROW_TYPE_TIMESTAMP, NANOARROW_TIME_UNIT_SECOND, 1000000000, timezone.c_str(), array_out, schema_out, error_out);
                             } else if (enif_is_identical(tuple[1], kAtomMilliseconds)) {
-                                ret = do_get_list_timestamp(env, data_term, nullable, NANOARROW_TYPE_TIMESTAMP, NANOARROW_TIME_UNIT_MILLI, 1000000, timezone.c_str(), array_out, schema_out, error_out);
+                                ret = do_get_list_timestamp(env, data_term, n_items, nullable, NANOARROW_TYPE_TIMESTAMP, NANOARROW_TIME_UNIT_MILLI, 1000000, timezone.c_str(), array_out, schema_out, error_out);
                             } else if (enif_is_identical(tuple[1], kAtomMicroseconds)) {
-                                ret = do_get_list_timestamp(env, data_term, nullable, NANOARROW_TYPE_TIMESTAMP, NANOARROW_TIME_UNIT_MICRO, 1000, timezone.c_str(), array_out, schema_out, error_out);
+                                ret = do_get_list_timestamp(env, data_term, n_items, nullable, NANOARROW_TYPE_TIMESTAMP, NANOARROW_TIME_UNIT_MICRO, 1000, timezone.c_str(), array_out, schema_out, error_out);
                             } else if (enif_is_identical(tuple[1], kAtomNanoseconds)) {
-                                ret = do_get_list_timestamp(env, data_term, nullable, NANOARROW_TYPE_TIMESTAMP, NANOARROW_TIME_UNIT_NANO, 1, timezone.c_str(), array_out, schema_out, error_out);
+                                ret = do_get_list_timestamp(env, data_term, n_items, nullable, NANOARROW_TYPE_TIMESTAMP, NANOARROW_TIME_UNIT_NANO, 1, timezone.c_str(), array_out, schema_out, error_out);
                             }
                         }
                     }         
@@ -701,8 +821,12 @@ int adbc_column_to_adbc_field(ErlNifEnv *env, ERL_NIF_TERM adbc_buffer, struct A
         }
     }
 
+    if (ret == 0 && raw) {
+        ret = adbc_column_set_raw_data(env, type_term, raw_values, raw_validity, nullable, array_out, error_out);
+    }
+
     if (ret != 0) {
-        if (schema_out->release) schema_out->release(schema_out);
+        if (!reuse_schema && schema_out->release) schema_out->release(schema_out);
         if (array_out->release) array_out->release(array_out);
 
         if (ret == kErrorBufferUnknownType) {
@@ -711,12 +835,20 @@ int adbc_column_to_adbc_field(ErlNifEnv *env, ERL_NIF_TERM adbc_buffer, struct A
         return ret;
     }
 
-    NANOARROW_RETURN_NOT_OK(ArrowArrayFinishBuildingDefault(array_out, error_out));
+    auto validation_level = trusted ? NANOARROW_VALIDATION_LEVEL_NONE : NANOARROW_VALIDATION_LEVEL_DEFAULT;
+    NANOARROW_RETURN_NOT_OK(ArrowArrayFinishBuilding(array_out, validation_level, error_out));
     return 0;   
 }
 
+// When `trusted`, the columns and the struct are finished without being
+// validated, see `adbc_column_to_adbc_field`.
+//
+// When `cached_schema` is given, it is the schema built for `values` of the
+// same signature before, see `adbc_column_bind_signature`, and the arrays
+// are built for its children while `schema_out` is left unset.
+//
 // non-zero return value indicating errors
-int adbc_column_to_arrow_type_struct(ErlNifEnv *env, ERL_NIF_TERM values, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out) {
+int adbc_column_to_arrow_type_struct(ErlNifEnv *env, ERL_NIF_TERM values, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out, bool trusted = false, const struct ArrowSchema * cached_schema = nullptr) {
     array_out->release = NULL;
     schema_out->release = NULL;
 
@@ -725,35 +857,61 @@ int adbc_column_to_arrow_type_struct(ErlNifEnv *env, ERL_NIF_TERM values, struct
         return 1;
     }
 
-    ArrowSchemaInit(schema_out);
-    NANOARROW_RETURN_NOT_OK(ArrowSchemaSetTypeStruct(schema_out, n_items));
+    bool reuse_schema = cached_schema != nullptr;
+    if (reuse_schema && cached_schema->n_children != static_cast<int64_t>(n_items)) {
+        snprintf(error_out->message, sizeof(error_out->message), "expected %lld parameters for the cached schema, got %u.", (long long)cached_schema->n_children, n_items);
+        return 1;
+    }
+    if (!reuse_schema) {
+        ArrowSchemaInit(schema_out);
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetTypeStruct(schema_out, n_items));
+    }
     NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromType(array_out, NANOARROW_TYPE_STRUCT));
+    adbc_memory_set_allocator(array_out, adbc_memory_allocator(adbc_memory_stats.bind_bytes));
     NANOARROW_RETURN_NOT_OK(ArrowArrayAllocateChildren(array_out, static_cast<int64_t>(n_items)));
-    array_out->length = 1;
+    // the number of rows, every column must have as many values, while
+    // other parameters are a single row
+    int64_t length = -1;
+
+    // values of lazy columns by index, moved into the children once the
+    // struct is built and released on any early return
+    struct LazyChildren {
+        std::vector<std::pair<int64_t, struct ArrowArray>> items;
+        ~LazyChildren() {
+            for (auto &item : items) {
+                if (item.second.release) item.second.release(&item.second);
+            }
+        }
+    } lazy_children;
 
     ERL_NIF_TERM head, tail;
     tail = values;
     int64_t processed = 0;
     while (enif_get_list_cell(env, tail, &head, &tail)) {
-        auto schema_i = schema_out->children[processed];
-        ArrowSchemaInit(schema_i);
+        auto schema_i = reuse_schema ? cached_schema->children[processed] : schema_out->children[processed];
+        if (!reuse_schema) ArrowSchemaInit(schema_i);
 
         auto child_i = array_out->children[processed];
+        int64_t child_length = 1;
 
         ErlNifSInt64 i64;
         double f64;
         ErlNifBinary bytes;
 
         if (enif_get_int64(env, head, &i64)) {
-            NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_i, NANOARROW_TYPE_INT64));
-            NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema_i, ""));
-            NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(child_i, schema_i, error_out));
+            if (!reuse_schema) {
+                NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_i, NANOARROW_TYPE_INT64));
+                NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema_i, ""));
+            }
+            NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(child_i, schema_i, error_out));
             NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(child_i));
             NANOARROW_RETURN_NOT_OK(ArrowArrayAppendInt(child_i, i64));
         } else if (enif_get_double(env, head, &f64)) {
-            NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_i, NANOARROW_TYPE_DOUBLE));
-            NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema_i, ""));
-            NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(child_i, schema_i, error_out));
+            if (!reuse_schema) {
+                NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_i, NANOARROW_TYPE_DOUBLE));
+                NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema_i, ""));
+            }
+            NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(child_i, schema_i, error_out));
             NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(child_i));
             NANOARROW_RETURN_NOT_OK(ArrowArrayAppendDouble(child_i, f64));
         } else if (enif_is_binary(env, head) && enif_inspect_binary(env, head, &bytes)) {
@@ -764,9 +922,11 @@ int adbc_column_to_arrow_type_struct(ErlNifEnv *env, ERL_NIF_TERM values, struct
             struct ArrowStringView view{};
             view.data = (const char*)(bytes.data);
             view.size_bytes = static_cast<int64_t>(bytes.size);
-            NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_i, type));
-            NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema_i, ""));
-            NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(child_i, schema_i, error_out));
+            if (!reuse_schema) {
+                NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_i, type));
+                NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema_i, ""));
+            }
+            NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(child_i, schema_i, error_out));
             NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(child_i));
             NANOARROW_RETURN_NOT_OK(ArrowArrayAppendString(child_i, view));
         } else if (enif_is_atom(env, head)) {
@@ -783,9 +943,11 @@ int adbc_column_to_arrow_type_struct(ErlNifEnv *env, ERL_NIF_TERM values, struct
                 return 1;
             }
             
-            NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_i, type));
-            NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema_i, ""));
-            NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(child_i, schema_i, error_out));
+            if (!reuse_schema) {
+                NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_i, type));
+                NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema_i, ""));
+            }
+            NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(child_i, schema_i, error_out));
             NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(child_i));
             if (type == NANOARROW_TYPE_BOOL) {
                 NANOARROW_RETURN_NOT_OK(ArrowArrayAppendInt(child_i, val));
@@ -795,7 +957,12 @@ int adbc_column_to_arrow_type_struct(ErlNifEnv *env, ERL_NIF_TERM values, struct
                 NANOARROW_RETURN_NOT_OK(ArrowArrayAppendNull(child_i, val));
             }
         } else if (enif_is_map(env, head)) {
-            int ret = adbc_column_to_adbc_field(env, head, child_i, schema_i, error_out);
+            struct ArrowArray lazy_child{};
+            int ret = adbc_column_to_adbc_field(env, head, child_i, schema_i, &lazy_child, error_out, trusted, reuse_schema);
+            if (lazy_child.release) {
+                lazy_children.items.emplace_back(processed, lazy_child);
+            }
+            child_length = lazy_child.release ? lazy_child.length : child_i->length;
             switch (ret)
             {
             case kErrorBufferIsNotAMap:
@@ -809,25 +976,292 @@ int adbc_column_to_arrow_type_struct(ErlNifEnv *env, ERL_NIF_TERM values, struct
             case kErrorBufferDataIsNotAList:
                 snprintf(error_out->message, sizeof(error_out->message), "Expected the `data` field of `Adbc.Column` to be a list of values.");
                 return 1;
+            case kErrorBufferInvalidLazyData:
+                snprintf(error_out->message, sizeof(error_out->message), "Invalid lazy `data` field of `Adbc.Column`.");
+                return 1;
             case kErrorBufferUnknownType:
             case kErrorBufferGetMetadataKey:
             case kErrorBufferGetMetadataValue:
+            case kErrorBufferInvalidDecimal:
+            case kErrorBufferInvalidValue:
+            case kErrorBufferInvalidRawData:
                 // error message is already set
                 return 1;
             case kErrorExpectedCalendarISO:
                 snprintf(error_out->message, sizeof(error_out->message), "Expected `Calendar.ISO`.");
                 return 1;
             default:
+                // errors from nanoarrow, which sets the message
+                if (ret != 0) return 1;
                 break;
             }
         } else {
             snprintf(error_out->message, sizeof(error_out->message), "type not supported yet.");
             return 1;
         }
+        if (length != -1 && child_length != length) {
+            snprintf(error_out->message, sizeof(error_out->message), "all parameters must have the same number of rows, expected %lld, got %lld for parameter %lld.", (long long)length, (long long)child_length, (long long)(processed + 1));
+            return 1;
+        }
+        length = child_length;
         processed++;
     }
-    NANOARROW_RETURN_NOT_OK(ArrowArrayFinishBuildingDefault(array_out, error_out));
+    array_out->length = length == -1 ? 1 : length;
+    // the placeholders of lazy columns are empty and would fail validation
+    auto validation_level = lazy_children.items.empty() && !trusted ? NANOARROW_VALIDATION_LEVEL_DEFAULT : NANOARROW_VALIDATION_LEVEL_NONE;
+    NANOARROW_RETURN_NOT_OK(ArrowArrayFinishBuilding(array_out, validation_level, error_out));
+    for (auto &item : lazy_children.items) {
+        struct ArrowArray * child = array_out->children[item.first];
+        child->release(child);
+        *child = item.second;
+        item.second.release = nullptr;
+    }
     return !(processed == n_items);
 }
 
+enum class ParameterKind { kNil, kInteger, kFloat, kBinary, kBoolean };
+
+// Returns the kind of a parameter given in a row, or false if it is not
+// supported.
+static bool get_parameter_kind(ErlNifEnv *env, ERL_NIF_TERM value, ParameterKind &kind, size_t &size) {
+    ErlNifSInt64 i64;
+    double f64;
+    ErlNifBinary bytes;
+    if (enif_is_identical(value, kAtomNil)) {
+        kind = ParameterKind::kNil;
+    } else if (enif_get_int64(env, value, &i64)) {
+        kind = ParameterKind::kInteger;
+    } else if (enif_get_double(env, value, &f64)) {
+        kind = ParameterKind::kFloat;
+    } else if (enif_is_binary(env, value) && enif_inspect_binary(env, value, &bytes)) {
+        kind = ParameterKind::kBinary;
+        size = bytes.size;
+    } else if (enif_is_identical(value, kAtomTrue) || enif_is_identical(value, kAtomFalse)) {
+        kind = ParameterKind::kBoolean;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Sets `out` to the signature of the parameters `values` bound as columns,
+// a list of what the schema of each is built from: the name, type,
+// nullability and metadata of an `Adbc.Column`, or the kind of any other
+// value. Parameters of the same signature have the same schema, so that
+// the schema built for the first ones can be reused.
+//
+// Returns false if the schema cannot be known from the terms, as for lazy
+// columns, which have the schema of the result they reference.
+static bool adbc_column_bind_signature(ErlNifEnv *env, ERL_NIF_TERM values, ERL_NIF_TERM &out) {
+    std::vector<ERL_NIF_TERM> items;
+    ERL_NIF_TERM head, tail = values;
+    while (enif_get_list_cell(env, tail, &head, &tail)) {
+        ParameterKind kind;
+        size_t size = 0;
+        if (enif_is_map(env, head)) {
+            ERL_NIF_TERM struct_name, name, type, nullable, metadata, data;
+            const ERL_NIF_TERM *data_tuple = nullptr;
+            int data_arity = 0;
+            if (!enif_get_map_value(env, head, kAtomStructKey, &struct_name) ||
+                !enif_is_identical(struct_name, kAtomAdbcColumnModule) ||
+                !enif_get_map_value(env, head, kAtomNameKey, &name) ||
+                !enif_get_map_value(env, head, kAtomTypeKey, &type) ||
+                !enif_get_map_value(env, head, kAtomNullableKey, &nullable) ||
+                !enif_get_map_value(env, head, kAtomMetadataKey, &metadata) ||
+                !enif_get_map_value(env, head, kAtomDataKey, &data)) {
+                return false;
+            }
+            if (enif_get_tuple(env, data, &data_arity, &data_tuple) && data_arity > 0 && enif_is_identical(data_tuple[0], kAtomLazy)) {
+                return false;
+            }
+            items.push_back(enif_make_tuple4(env, name, type, nullable, metadata));
+        } else if (get_parameter_kind(env, head, kind, size)) {
+            // strings too large for 32-bit offsets are large strings
+            int large = kind == ParameterKind::kBinary && size > INT32_MAX;
+            items.push_back(enif_make_tuple2(env, enif_make_int(env, static_cast<int>(kind)), enif_make_int(env, large)));
+        } else {
+            return false;
+        }
+    }
+    out = enif_make_list_from_array(env, items.data(), static_cast<unsigned>(items.size()));
+    return true;
+}
+
+// Walks the cells of `column` in the `n_rows` rows of `cells` into
+// `array_out`, whose buffers must be reserved, as `append_list` does for
+// the values of a list. The kinds of the cells were already checked, so
+// `write(value, is_nil)` cannot fail.
+template <typename Write>
+static void append_row_cells(const std::vector<ERL_NIF_TERM> &cells, unsigned column, unsigned n_columns, int64_t n_rows, struct ArrowArray* array_out, const Write &write) {
+    struct ArrowBitmap * validity = ArrowArrayValidityBitmap(array_out);
+    int64_t null_count = 0;
+    for (int64_t i = 0; i < n_rows; i++) {
+        ERL_NIF_TERM value = cells[i * n_columns + column];
+        bool is_nil = enif_is_identical(value, kAtomNil);
+        write(value, is_nil);
+        ArrowBitmapAppendUnsafe(validity, !is_nil, 1);
+        null_count += is_nil;
+    }
+    array_out->length = n_rows;
+    array_out->null_count = null_count;
+}
+
+template <typename Offset>
+static void append_row_binaries(ErlNifEnv *env, const std::vector<ERL_NIF_TERM> &cells, unsigned column, unsigned n_columns, int64_t n_rows, struct ArrowArray* array_out) {
+    struct ArrowBuffer * offsets = ArrowArrayBuffer(array_out, 1);
+    struct ArrowBuffer * data = ArrowArrayBuffer(array_out, 2);
+    Offset offset = 0;
+    append_row_cells(cells, column, n_columns, n_rows, array_out, [&](ERL_NIF_TERM value, bool is_nil) {
+        ErlNifBinary bytes;
+        if (!is_nil && enif_inspect_binary(env, value, &bytes)) {
+            ArrowBufferAppendUnsafe(data, bytes.data, static_cast<int64_t>(bytes.size));
+            offset += static_cast<Offset>(bytes.size);
+        }
+        ArrowBufferAppendUnsafe(offsets, &offset, sizeof(Offset));
+    });
+}
+
+// Builds a struct array with one row per element of `rows`, each a list of
+// parameters, so that a statement is executed for every row by the driver.
+//
+// The type of each column is inferred from its values as for single
+// parameters, integers being widened to floats in columns that have both
+// and columns of nils only having the null type.
+//
+// When `trusted`, each row is walked once instead of taking its length
+// first, and the struct is finished without being validated. Rows must
+// still have the same length, which the columns are laid out by.
+//
+// non-zero return value indicating errors
+int adbc_rows_to_arrow_type_struct(ErlNifEnv *env, ERL_NIF_TERM rows, struct ArrowArray* array_out, struct ArrowSchema* schema_out, struct ArrowError* error_out, bool trusted = false) {
+    array_out->release = NULL;
+    schema_out->release = NULL;
+
+    std::vector<ERL_NIF_TERM> cells;
+    unsigned n_columns = 0;
+    int64_t n_rows = 0;
+    ERL_NIF_TERM row, tail = rows;
+    while (enif_get_list_cell(env, tail, &row, &tail)) {
+        unsigned row_length = 0;
+        if (!trusted && !enif_get_list_length(env, row, &row_length)) {
+            snprintf(error_out->message, sizeof(error_out->message), "expected every row of parameters to be a list.");
+            return 1;
+        }
+        size_t row_start = cells.size();
+        ERL_NIF_TERM value, values = row;
+        while (enif_get_list_cell(env, values, &value, &values)) {
+            cells.push_back(value);
+        }
+        if (trusted) {
+            row_length = static_cast<unsigned>(cells.size() - row_start);
+        }
+        if (n_rows == 0) {
+            n_columns = row_length;
+        } else if (row_length != n_columns) {
+            snprintf(error_out->message, sizeof(error_out->message), "all rows of parameters must have the same length, expected %u, got %u for row %lld.", n_columns, row_length, (long long)(n_rows + 1));
+            return 1;
+        }
+        n_rows++;
+    }
+
+    std::vector<ParameterKind> kinds(n_columns, ParameterKind::kNil);
+    std::vector<size_t> sizes(n_columns, 0);
+    for (size_t i = 0; i < cells.size(); i++) {
+        size_t column = i % n_columns;
+        ParameterKind kind;
+        size_t size = 0;
+        if (!get_parameter_kind(env, cells[i], kind, size)) {
+            enif_snprintf(error_out->message, sizeof(error_out->message), "parameter `%T` in a row is not supported yet.", cells[i]);
+            return 1;
+        }
+        ParameterKind &column_kind = kinds[column];
+        sizes[column] += size;
+        if (kind == ParameterKind::kNil || kind == column_kind) {
+            continue;
+        } else if (column_kind == ParameterKind::kNil) {
+            column_kind = kind;
+        } else if ((kind == ParameterKind::kFloat && column_kind == ParameterKind::kInteger) ||
+                   (kind == ParameterKind::kInteger && column_kind == ParameterKind::kFloat)) {
+            column_kind = ParameterKind::kFloat;
+        } else {
+            snprintf(error_out->message, sizeof(error_out->message), "parameter %zu has values of different types in different rows.", column + 1);
+            return 1;
+        }
+    }
+
+    ArrowSchemaInit(schema_out);
+    NANOARROW_RETURN_NOT_OK(ArrowSchemaSetTypeStruct(schema_out, n_columns));
+    for (unsigned column = 0; column < n_columns; column++) {
+        ArrowType type = NANOARROW_TYPE_NA;
+        switch (kinds[column]) {
+            case ParameterKind::kInteger: type = NANOARROW_TYPE_INT64; break;
+            case ParameterKind::kFloat: type = NANOARROW_TYPE_DOUBLE; break;
+            case ParameterKind::kBinary: type = sizes[column] > INT32_MAX ? NANOARROW_TYPE_LARGE_STRING : NANOARROW_TYPE_STRING; break;
+            case ParameterKind::kBoolean: type = NANOARROW_TYPE_BOOL; break;
+            default: break;
+        }
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema_out->children[column], type));
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema_out->children[column], ""));
+    }
+    NANOARROW_RETURN_NOT_OK(adbc_memory_init_bind_array(array_out, schema_out, error_out));
+    NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array_out));
+
+    // the type of every column is known, so each is built by a loop of its
+    // own into buffers reserved for all of its rows
+    for (unsigned column = 0; column < n_columns; column++) {
+        struct ArrowArray * child = array_out->children[column];
+        if (kinds[column] == ParameterKind::kNil) {
+            NANOARROW_RETURN_NOT_OK(ArrowArrayAppendNull(child, n_rows));
+            continue;
+        }
+        NANOARROW_RETURN_NOT_OK(ArrowArrayReserve(child, n_rows));
+        NANOARROW_RETURN_NOT_OK(ArrowBitmapReserve(ArrowArrayValidityBitmap(child), n_rows));
+        struct ArrowBuffer * data = ArrowArrayBuffer(child, 1);
+        switch (kinds[column]) {
+            case ParameterKind::kInteger:
+                append_row_cells(cells, column, n_columns, n_rows, child, [&](ERL_NIF_TERM value, bool is_nil) {
+                    ErlNifSInt64 i64 = 0;
+                    if (!is_nil) enif_get_int64(env, value, &i64);
+                    int64_t out = i64;
+                    ArrowBufferAppendUnsafe(data, &out, sizeof(out));
+                });
+                break;
+            case ParameterKind::kFloat:
+                append_row_cells(cells, column, n_columns, n_rows, child, [&](ERL_NIF_TERM value, bool is_nil) {
+                    ErlNifSInt64 i64;
+                    double f64 = 0;
+                    if (!is_nil && enif_get_int64(env, value, &i64)) {
+                        f64 = (double)i64;
+                    } else if (!is_nil) {
+                        enif_get_double(env, value, &f64);
+                    }
+                    ArrowBufferAppendUnsafe(data, &f64, sizeof(f64));
+                });
+                break;
+            case ParameterKind::kBinary:
+                NANOARROW_RETURN_NOT_OK(ArrowBufferReserve(ArrowArrayBuffer(child, 2), (int64_t)sizes[column]));
+                if (sizes[column] > INT32_MAX) {
+                    append_row_binaries<int64_t>(env, cells, column, n_columns, n_rows, child);
+                } else {
+                    append_row_binaries<int32_t>(env, cells, column, n_columns, n_rows, child);
+                }
+                break;
+            default: {
+                // values are bits, all cleared up front
+                NANOARROW_RETURN_NOT_OK(ArrowBufferAppendFill(data, 0, (n_rows + 7) / 8));
+                int64_t i = 0;
+                append_row_cells(cells, column, n_columns, n_rows, child, [&](ERL_NIF_TERM value, bool is_nil) {
+                    if (enif_is_identical(value, kAtomTrue)) ArrowBitSet(data->data, i);
+                    i++;
+                });
+                break;
+            }
+        }
+    }
+    array_out->length = n_rows;
+    auto validation_level = trusted ? NANOARROW_VALIDATION_LEVEL_NONE : NANOARROW_VALIDATION_LEVEL_DEFAULT;
+    NANOARROW_RETURN_NOT_OK(ArrowArrayFinishBuilding(array_out, validation_level, error_out));
+    return 0;
+}
+
 #endif  // ADBC_COLUMN_HPP
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <erl_nif.h>
+#include "nif_utils.hpp"
 
 // Atoms
 static ERL_NIF_TERM kAtomAdbcError;
@@ -17,6 +18,12 @@ static ERL_NIF_TERM kAtomMilliseconds;
 static ERL_NIF_TERM kAtomMicroseconds;
 static ERL_NIF_TERM kAtomNanoseconds;
 static ERL_NIF_TERM kAtomTimestamp;
+static ERL_NIF_TERM kAtomRaw;
+static ERL_NIF_TERM kAtomLazy;
+static ERL_NIF_TERM kAtomDictionary;
+static ERL_NIF_TERM kAtomDecimal;
+static ERL_NIF_TERM kAtomAdbcIngestNext;
+static ERL_NIF_TERM kAtomAdbcStreamReleased;
 
 static ERL_NIF_TERM kAtomCalendarKey;
 static ERL_NIF_TERM kAtomCalendarISO;
@@ -33,6 +40,12 @@ static ERL_NIF_TERM kAtomMinuteKey;
 static ERL_NIF_TERM kAtomSecondKey;
 static ERL_NIF_TERM kAtomMicrosecondKey;
 
+static ERL_NIF_TERM kAtomDateTimeModule;
+static ERL_NIF_TERM kAtomTimeZoneKey;
+static ERL_NIF_TERM kAtomZoneAbbrKey;
+static ERL_NIF_TERM kAtomUtcOffsetKey;
+static ERL_NIF_TERM kAtomStdOffsetKey;
+
 static ERL_NIF_TERM kAtomAdbcColumnModule;
 static ERL_NIF_TERM kAtomNameKey;
 static ERL_NIF_TERM kAtomTypeKey;
@@ -73,6 +86,84 @@ static ERL_NIF_TERM kAdbcColumnTypeBool;
 #define kAdbcColumnTypeTime64Microseconds enif_make_tuple2(env, kAtomTime64, kAtomMicroseconds)
 #define kAdbcColumnTypeTime64Nanoseconds enif_make_tuple2(env, kAtomTime64, kAtomNanoseconds)
 
+// Creates the atoms above, from the `on_load` of the NIF library.
+static void adbc_consts_init(ErlNifEnv *env) {
+    kAtomAdbcError = erlang::nif::atom(env, "adbc_error");
+    kAtomNil = erlang::nif::atom(env, "nil");
+    kAtomTrue = erlang::nif::atom(env, "true");
+    kAtomFalse = erlang::nif::atom(env, "false");
+    kAtomEndOfSeries = erlang::nif::atom(env, "end_of_series");
+    kAtomStructKey = erlang::nif::atom(env, "__struct__");
+    kAtomTime32 = erlang::nif::atom(env, "time32");
+    kAtomTime64 = erlang::nif::atom(env, "time64");
+    kAtomSeconds = erlang::nif::atom(env, "seconds");
+    kAtomMilliseconds = erlang::nif::atom(env, "milliseconds");
+    kAtomMicroseconds = erlang::nif::atom(env, "microseconds");
+    kAtomNanoseconds = erlang::nif::atom(env, "nanoseconds");
+    kAtomTimestamp = erlang::nif::atom(env, "timestamp");
+    kAtomRaw = erlang::nif::atom(env, "raw");
+    kAtomLazy = erlang::nif::atom(env, "lazy");
+    kAtomDictionary = erlang::nif::atom(env, "dictionary");
+    kAtomDecimal = erlang::nif::atom(env, "decimal");
+    kAtomAdbcIngestNext = erlang::nif::atom(env, "adbc_ingest_next");
+    kAtomAdbcStreamReleased = erlang::nif::atom(env, "adbc_stream_released");
+
+    kAtomCalendarKey = erlang::nif::atom(env, "calendar");
+    kAtomCalendarISO = erlang::nif::atom(env, "Elixir.Calendar.ISO");
+
+    kAtomDateModule = erlang::nif::atom(env, "Elixir.Date");
+    kAtomYearKey = erlang::nif::atom(env, "year");
+    kAtomMonthKey = erlang::nif::atom(env, "month");
+    kAtomDayKey = erlang::nif::atom(env, "day");
+
+    kAtomNaiveDateTimeModule = erlang::nif::atom(env, "Elixir.NaiveDateTime");
+    kAtomTimeModule = erlang::nif::atom(env, "Elixir.Time");
+    kAtomHourKey = erlang::nif::atom(env, "hour");
+    kAtomMinuteKey = erlang::nif::atom(env, "minute");
+    kAtomSecondKey = erlang::nif::atom(env, "second");
+    kAtomMicrosecondKey = erlang::nif::atom(env, "microsecond");
+
+    kAtomDateTimeModule = erlang::nif::atom(env, "Elixir.DateTime");
+    kAtomTimeZoneKey = erlang::nif::atom(env, "time_zone");
+    kAtomZoneAbbrKey = erlang::nif::atom(env, "zone_abbr");
+    kAtomUtcOffsetKey = erlang::nif::atom(env, "utc_offset");
+    kAtomStdOffsetKey = erlang::nif::atom(env, "std_offset");
+
+    kAtomAdbcColumnModule = erlang::nif::atom(env, "Elixir.Adbc.Column");
+    kAtomNameKey = erlang::nif::atom(env, "name");
+    kAtomTypeKey = erlang::nif::atom(env, "type");
+    kAtomNullableKey = erlang::nif::atom(env, "nullable");
+    kAtomMetadataKey = erlang::nif::atom(env, "metadata");
+    kAtomDataKey = erlang::nif::atom(env, "data");
+    // kAdbcBufferPrivateKey = enif_make_atom(env, "__private__");
+
+    kAdbcColumnTypeU8 = erlang::nif::atom(env, "u8");
+    kAdbcColumnTypeU16 = erlang::nif::atom(env, "u16");
+    kAdbcColumnTypeU32 = erlang::nif::atom(env, "u32");
+    kAdbcColumnTypeU64 = erlang::nif::atom(env, "u64");
+    kAdbcColumnTypeI8 = erlang::nif::atom(env, "i8");
+    kAdbcColumnTypeI16 = erlang::nif::atom(env, "i16");
+    kAdbcColumnTypeI32 = erlang::nif::atom(env, "i32");
+    kAdbcColumnTypeI64 = erlang::nif::atom(env, "i64");
+    kAdbcColumnTypeF32 = erlang::nif::atom(env, "f32");
+    kAdbcColumnTypeF64 = erlang::nif::atom(env, "f64");
+    kAdbcColumnTypeStruct = erlang::nif::atom(env, "struct");
+    kAdbcColumnTypeMap = erlang::nif::atom(env, "map");
+    kAdbcColumnTypeList = erlang::nif::atom(env, "list");
+    kAdbcColumnTypeLargeList = erlang::nif::atom(env, "large_list");
+    kAdbcColumnTypeFixedSizeList = erlang::nif::atom(env, "fixed_size_list");
+    kAdbcColumnTypeString = erlang::nif::atom(env, "string");
+    kAdbcColumnTypeLargeString = erlang::nif::atom(env, "large_string");
+    kAdbcColumnTypeBinary = erlang::nif::atom(env, "binary");
+    kAdbcColumnTypeLargeBinary = erlang::nif::atom(env, "large_binary");
+    kAdbcColumnTypeFixedSizeBinary = erlang::nif::atom(env, "fixed_size_binary");
+    kAdbcColumnTypeDenseUnion = erlang::nif::atom(env, "dense_union");
+    kAdbcColumnTypeSparseUnion = erlang::nif::atom(env, "sparse_union");
+    kAdbcColumnTypeDate32 = erlang::nif::atom(env, "date32");
+    kAdbcColumnTypeDate64 = erlang::nif::atom(env, "date64");
+    kAdbcColumnTypeBool = erlang::nif::atom(env, "boolean");
+}
+
 // error codes
 constexpr int kErrorBufferIsNotAMap = 1;
 constexpr int kErrorBufferGetDataListLength = 2;
@@ -83,5 +174,9 @@ constexpr int kErrorBufferUnknownType = 6;
 constexpr int kErrorBufferGetMetadataKey = 7;
 constexpr int kErrorBufferGetMetadataValue = 8;
 constexpr int kErrorExpectedCalendarISO = 9;
+constexpr int kErrorBufferInvalidLazyData = 10;
+constexpr int kErrorBufferInvalidDecimal = 11;
+constexpr int kErrorBufferInvalidValue = 12;
+constexpr int kErrorBufferInvalidRawData = 13;
 
 #endif  // ADBC_CONSTS_H
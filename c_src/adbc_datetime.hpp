@@ -0,0 +1,88 @@
+#ifndef ADBC_DATETIME_HPP
+#define ADBC_DATETIME_HPP
+#pragma once
+
+#include <cstdint>
+
+// Calendar arithmetic used to convert Arrow dates, times and timestamps.
+//
+// Unlike `gmtime`, these functions are thread-safe, do not allocate and
+// also handle values before the Unix epoch.
+
+constexpr int64_t kMicrosecondsPerSecond = 1000000;
+constexpr int64_t kMicrosecondsPerDay = 86400 * kMicrosecondsPerSecond;
+constexpr int64_t kMillisecondsPerDay = 86400 * 1000;
+
+struct CivilDate {
+    int64_t year;
+    unsigned month;
+    unsigned day;
+};
+
+struct CivilTime {
+    unsigned hour;
+    unsigned minute;
+    unsigned second;
+    unsigned microsecond;
+};
+
+static inline int64_t floor_div(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0))) q--;
+    return q;
+}
+
+static inline int64_t floor_mod(int64_t a, int64_t b) {
+    return a - floor_div(a, b) * b;
+}
+
+// Returns the proleptic Gregorian date of `days` since 1970-01-01,
+// see http://howardhinnant.github.io/date_algorithms.html#civil_from_days
+static inline CivilDate civil_from_days(int64_t days) {
+    days += 719468;
+    const int64_t era = floor_div(days, 146097);
+    const unsigned doe = (unsigned)(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+    return {(int64_t)yoe + era * 400 + (month <= 2), month, day};
+}
+
+// Returns the number of days since 1970-01-01 of the given proleptic
+// Gregorian date, the inverse of `civil_from_days`.
+static inline int64_t days_from_civil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const int64_t era = floor_div(year, 400);
+    const unsigned yoe = (unsigned)(year - era * 400);
+    const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+// Returns the time of the day of `us` microseconds since midnight, wrapping
+// values outside of the day.
+static inline CivilTime civil_time_from_microseconds(int64_t us) {
+    int64_t time_of_day = floor_mod(us, kMicrosecondsPerDay);
+    int64_t seconds = time_of_day / kMicrosecondsPerSecond;
+    return {
+        (unsigned)(seconds / 3600),
+        (unsigned)(seconds / 60 % 60),
+        (unsigned)(seconds % 60),
+        (unsigned)(time_of_day % kMicrosecondsPerSecond)
+    };
+}
+
+// Converts `value` in the Arrow time `unit` ('s', 'm', 'u' or 'n') to
+// microseconds, truncating nanoseconds as Elixir only supports microseconds.
+static inline int64_t to_microseconds(int64_t value, char unit) {
+    switch (unit) {
+        case 's': return value * kMicrosecondsPerSecond;
+        case 'm': return value * 1000;
+        case 'u': return value;
+        default: return floor_div(value, 1000);
+    }
+}
+
+#endif  // ADBC_DATETIME_HPP
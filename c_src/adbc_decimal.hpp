@@ -0,0 +1,137 @@
+#ifndef ADBC_DECIMAL_HPP
+#define ADBC_DECIMAL_HPP
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <erl_nif.h>
+#include <nanoarrow/nanoarrow.h>
+
+// Conversions between the unscaled values of Arrow decimals and integers.
+//
+// The NIF API can neither make nor read integers wider than 64 bits, so
+// those go through the external term format, where such an integer is a
+// sign byte followed by its magnitude in little-endian bytes.
+
+constexpr uint8_t kExternalTermFormatVersion = 131;
+constexpr uint8_t kExternalTermSmallBigExt = 110;
+
+/// Returns the unscaled value of `decimal` as an integer.
+static ERL_NIF_TERM arrow_decimal_to_nif_term(ErlNifEnv *env, const struct ArrowDecimal * decimal) {
+    struct ArrowDecimal magnitude = *decimal;
+    bool negative = ArrowDecimalSign(decimal) < 0;
+    if (negative) ArrowDecimalNegate(&magnitude);
+
+    // from the least significant word
+    uint64_t words[4];
+    int n_words = magnitude.n_words;
+    for (int i = 0; i < n_words; i++) {
+        words[i] = magnitude.words[magnitude.low_word_index == 0 ? i : n_words - 1 - i];
+    }
+    while (n_words > 1 && words[n_words - 1] == 0) n_words--;
+    if (n_words == 1 && words[0] <= (uint64_t)INT64_MAX) {
+        return enif_make_int64(env, negative ? -(int64_t)words[0] : (int64_t)words[0]);
+    }
+
+    uint8_t term[4 + sizeof(words)];
+    size_t n_bytes = 0;
+    for (int i = 0; i < n_words; i++) {
+        for (int b = 0; b < 8; b++) {
+            term[4 + n_bytes++] = (uint8_t)(words[i] >> (8 * b));
+        }
+    }
+    while (term[3 + n_bytes] == 0) n_bytes--;
+    term[0] = kExternalTermFormatVersion;
+    term[1] = kExternalTermSmallBigExt;
+    term[2] = (uint8_t)n_bytes;
+    term[3] = negative;
+
+    ERL_NIF_TERM out;
+    enif_binary_to_term(env, term, 4 + n_bytes, &out, 0);
+    return out;
+}
+
+/// Sets the unscaled value of `decimal`, which must be initialized, to the
+/// integer `term`.
+///
+/// Returns false if `term` is not an integer or does not fit the bit width
+/// of `decimal`. The precision of `decimal` is not checked.
+static bool arrow_decimal_from_nif_term(ErlNifEnv *env, ERL_NIF_TERM term, struct ArrowDecimal * decimal) {
+    ErlNifSInt64 value;
+    if (enif_get_int64(env, term, &value)) {
+        ArrowDecimalSetInt(decimal, value);
+        return true;
+    }
+
+    ErlNifBinary binary;
+    if (!enif_is_number(env, term) || !enif_term_to_binary(env, term, &binary)) {
+        return false;
+    }
+
+    const uint8_t * data = binary.data;
+    size_t max_bytes = decimal->n_words * sizeof(uint64_t);
+    bool ok = binary.size >= 4 && data[0] == kExternalTermFormatVersion && data[1] == kExternalTermSmallBigExt &&
+        binary.size == 4 + (size_t)data[2] && data[2] <= max_bytes;
+    if (ok) {
+        bool negative = data[3] != 0;
+        uint64_t words[4] = {0, 0, 0, 0};
+        for (size_t i = 0; i < data[2]; i++) {
+            words[i / 8] |= (uint64_t)data[4 + i] << (8 * (i % 8));
+        }
+
+        // the magnitude may only take the sign bit for the smallest value
+        int n_words = decimal->n_words;
+        uint64_t high = words[n_words - 1];
+        bool low_zero = true;
+        for (int i = 0; i < n_words - 1; i++) low_zero = low_zero && words[i] == 0;
+        ok = (high >> 63) == 0 || (negative && high == (uint64_t)1 << 63 && low_zero);
+
+        if (ok) {
+            for (int i = 0; i < n_words; i++) {
+                decimal->words[decimal->low_word_index == 0 ? i : n_words - 1 - i] = words[i];
+            }
+            if (negative) ArrowDecimalNegate(decimal);
+        }
+    }
+
+    enif_release_binary(&binary);
+    return ok;
+}
+
+/// A decimal written as `[-]digits[.digits]`, the way PostgreSQL writes its
+/// `numeric` values.
+struct DecimalDigits {
+    bool negative = false;
+    // the integer and fractional digits, without leading zeros or the point
+    std::string digits;
+    // the number of fractional digits
+    int32_t scale = 0;
+};
+
+/// Returns false if `data` is not such a decimal, as for `NaN` and
+/// `Infinity`.
+static bool parse_decimal_digits(const char * data, int64_t size, DecimalDigits &out) {
+    int64_t i = 0;
+    out.negative = size > 0 && data[0] == '-';
+    if (out.negative || (size > 0 && data[0] == '+')) i++;
+
+    out.digits.clear();
+    out.scale = 0;
+    bool point = false, any = false;
+    for (; i < size; i++) {
+        char c = data[i];
+        if (c == '.' && !point) {
+            point = true;
+        } else if (c >= '0' && c <= '9') {
+            any = true;
+            if (point) out.scale++;
+            if (!(c == '0' && out.digits.empty())) out.digits.push_back(c);
+        } else {
+            return false;
+        }
+    }
+    if (out.digits.empty()) out.negative = false;
+    return any;
+}
+
+#endif  // ADBC_DECIMAL_HPP
@@ -0,0 +1,124 @@
+#ifndef ADBC_DRIVER_CACHE_HPP
+#define ADBC_DRIVER_CACHE_HPP
+#pragma once
+
+#include <cctype>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <adbc.h>
+#include <adbc_driver_manager.h>
+#include "nif_utils.hpp"
+
+#ifdef OS_WIN
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+/// The entrypoints of the drivers loaded by the NIF, keyed by the path of
+/// the driver and the entrypoint asked for.
+///
+/// `AdbcDatabaseInit` loads the driver again for every database, searching
+/// for the library and its entrypoint each time. Instead, a driver is
+/// loaded once and stays loaded for as long as the NIF, so that restarting
+/// a database only initialises the driver from its cached entrypoint.
+class AdbcDriverCache {
+public:
+  /// The entrypoint of `driver`, loading it on first use. An empty
+  /// `entrypoint` resolves like the driver manager does.
+  ///
+  /// Returns nullptr when the driver or its entrypoint cannot be found,
+  /// the driver manager is then left to load it and report why it failed.
+  AdbcDriverInitFunc get(const std::string &driver, const std::string &entrypoint) {
+    auto key = std::make_pair(driver, entrypoint);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = drivers_.find(key);
+    if (it != drivers_.end()) {
+      return it->second;
+    }
+
+    void * handle = open(driver);
+    if (handle == nullptr) return nullptr;
+
+    AdbcDriverInitFunc init_func = nullptr;
+    if (entrypoint.empty()) {
+      init_func = symbol(handle, default_entrypoint(driver));
+      if (init_func == nullptr) init_func = symbol(handle, "AdbcDriverInit");
+    } else {
+      init_func = symbol(handle, entrypoint);
+    }
+    if (init_func == nullptr) {
+      close(handle);
+      return nullptr;
+    }
+
+    drivers_[key] = init_func;
+    return init_func;
+  }
+
+private:
+  /// The entrypoint the driver manager looks for first when none is
+  /// given, derived from the file name of the driver, such as
+  /// `AdbcDriverSqliteInit` for `libadbc_driver_sqlite.so`.
+  static std::string default_entrypoint(const std::string &driver) {
+    std::string filename = driver;
+    size_t pos = filename.find_last_of("/\\");
+    if (pos != std::string::npos) filename = filename.substr(pos + 1);
+
+    // all extensions, such as `.so.1.0.0`
+    pos = filename.find('.');
+    if (pos != std::string::npos) filename = filename.substr(0, pos);
+
+    if (filename.rfind("lib", 0) == 0) filename = filename.substr(3);
+
+    std::string entrypoint;
+    entrypoint.reserve(filename.size() + 8);
+    bool upper = true;
+    for (char c : filename) {
+      if (c == '_' || c == '-') {
+        upper = true;
+      } else {
+        entrypoint += upper ? (char)std::toupper((unsigned char)c) : c;
+        upper = false;
+      }
+    }
+
+    if (entrypoint.rfind("Adbc", 0) != 0) entrypoint = "Adbc" + entrypoint;
+    return entrypoint + "Init";
+  }
+
+#ifdef OS_WIN
+  static void * open(const std::string &driver) {
+    return (void *)LoadLibraryExA(driver.c_str(), NULL, 0);
+  }
+
+  static AdbcDriverInitFunc symbol(void * handle, const std::string &name) {
+    return (AdbcDriverInitFunc)GetProcAddress((HMODULE)handle, name.c_str());
+  }
+
+  static void close(void * handle) {
+    FreeLibrary((HMODULE)handle);
+  }
+#else
+  static void * open(const std::string &driver) {
+    return dlopen(driver.c_str(), RTLD_NOW | RTLD_LOCAL);
+  }
+
+  static AdbcDriverInitFunc symbol(void * handle, const std::string &name) {
+    return (AdbcDriverInitFunc)dlsym(handle, name.c_str());
+  }
+
+  static void close(void * handle) {
+    dlclose(handle);
+  }
+#endif
+
+  std::mutex mutex_;
+  std::map<std::pair<std::string, std::string>, AdbcDriverInitFunc> drivers_;
+};
+
+static AdbcDriverCache adbc_driver_cache;
+
+#endif  // ADBC_DRIVER_CACHE_HPP
@@ -0,0 +1,252 @@
+#ifndef ADBC_INGEST_STREAM_HPP
+#define ADBC_INGEST_STREAM_HPP
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <erl_nif.h>
+#include <nanoarrow/nanoarrow.h>
+#include "adbc_nif_resource.hpp"
+#include "adbc_consts.h"
+
+/// State of an ArrowArrayStream whose batches are produced by an Erlang
+/// process.
+///
+/// Each `{:adbc_ingest_next, tag}` sent to the producer allows it to push
+/// one more batch, up to `capacity` batches being converted or waiting for
+/// the consumer. Every batch taken by `get_next` requests the next one, so
+/// the producer converts batches while the driver sends the previous ones.
+/// The state is shared by the stream and by the
+/// `NifRes<IngestStreamProducer>` of the producer and freed once both are
+/// released.
+struct IngestStream {
+    enum class State {
+        kOpen,
+        kDone,
+        kFailed
+    };
+
+    struct ArrowSchema schema{};
+    std::deque<struct ArrowArray> ready;
+
+    ErlNifPid producer;
+    ErlNifEnv * env = nullptr;
+    ERL_NIF_TERM tag{};
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    State state = State::kOpen;
+    // batches requested from the producer and not pushed yet
+    size_t requested = 0;
+    // set once the stream was released by its consumer
+    bool closed = false;
+    // set once the resource of the producer was garbage collected
+    bool producer_exited = false;
+    std::string last_error;
+
+    std::atomic<int> refs{2};
+
+    IngestStream() : env(enif_alloc_env()) {}
+
+    ~IngestStream() {
+        release_ready();
+        if (schema.release) schema.release(&schema);
+        if (env) enif_free_env(env);
+    }
+
+    void unref() {
+        if (refs.fetch_sub(1) == 1) delete this;
+    }
+
+    void release_ready() {
+        for (auto &batch : ready) {
+            if (batch.release) batch.release(&batch);
+        }
+        ready.clear();
+    }
+
+    // must be called with `mutex` held, returns whether the request could
+    // be sent
+    bool request() {
+        ErlNifEnv * msg_env = enif_alloc_env();
+        if (msg_env == nullptr) {
+            fail("out of memory");
+            return false;
+        }
+        ERL_NIF_TERM msg = enif_make_tuple2(msg_env, kAtomAdbcIngestNext, enif_make_copy(msg_env, tag));
+        bool sent = enif_send(nullptr, &producer, msg_env, msg);
+        enif_free_env(msg_env);
+        if (!sent) {
+            fail("the producer of the ingested batches exited");
+            return false;
+        }
+        requested++;
+        return true;
+    }
+
+    // must be called with `mutex` held
+    void fail(const char * reason) {
+        release_ready();
+        state = State::kFailed;
+        last_error = reason;
+        cond.notify_all();
+    }
+};
+
+/// Kept in a `NifRes<IngestStreamProducer>` by the producer of the batches.
+struct IngestStreamProducer {
+    IngestStream * stream;
+};
+
+/// Whether batches of `a` and `b` can be given to the same stream.
+static bool ingest_stream_same_schema(const struct ArrowSchema * a, const struct ArrowSchema * b) {
+    if (strcmp(a->format, b->format) != 0 || a->n_children != b->n_children) return false;
+    for (int64_t i = 0; i < a->n_children; i++) {
+        if (!ingest_stream_same_schema(a->children[i], b->children[i])) return false;
+    }
+    return true;
+}
+
+static int ingest_stream_get_schema(struct ArrowArrayStream * stream, struct ArrowSchema * out) {
+    auto ingest = (IngestStream *)stream->private_data;
+    std::lock_guard<std::mutex> lock(ingest->mutex);
+    return ArrowSchemaDeepCopy(&ingest->schema, out) == NANOARROW_OK ? 0 : ENOMEM;
+}
+
+static int ingest_stream_get_next(struct ArrowArrayStream * stream, struct ArrowArray * out) {
+    auto ingest = (IngestStream *)stream->private_data;
+    std::unique_lock<std::mutex> lock(ingest->mutex);
+
+    if (ingest->state == IngestStream::State::kOpen && ingest->ready.empty() && ingest->producer_exited) {
+        ingest->fail("the producer of the ingested batches exited");
+    }
+    ingest->cond.wait(lock, [ingest]() {
+        return !ingest->ready.empty() || ingest->state != IngestStream::State::kOpen;
+    });
+
+    if (!ingest->ready.empty()) {
+        ArrowArrayMove(&ingest->ready.front(), out);
+        ingest->ready.pop_front();
+        if (ingest->state == IngestStream::State::kOpen && !ingest->producer_exited) {
+            ingest->request();
+        }
+        return 0;
+    }
+    if (ingest->state == IngestStream::State::kDone) {
+        out->release = nullptr;
+        return 0;
+    }
+    return EIO;
+}
+
+static const char * ingest_stream_get_last_error(struct ArrowArrayStream * stream) {
+    auto ingest = (IngestStream *)stream->private_data;
+    std::lock_guard<std::mutex> lock(ingest->mutex);
+    return ingest->last_error.empty() ? nullptr : ingest->last_error.c_str();
+}
+
+static void ingest_stream_release(struct ArrowArrayStream * stream) {
+    auto ingest = (IngestStream *)stream->private_data;
+    {
+        std::lock_guard<std::mutex> lock(ingest->mutex);
+        ingest->closed = true;
+        ingest->release_ready();
+    }
+    ingest->unref();
+
+    stream->private_data = nullptr;
+    stream->release = nullptr;
+}
+
+/// Initializes `stream` to read batches of `schema` pushed by `producer`,
+/// starting with `first`, with up to `capacity` batches ahead of the
+/// consumer. Both `schema` and `first` are moved into the stream, `tag` is
+/// copied. The producer is asked for the batches that fit after `first`.
+///
+/// Returns the state to be kept by the producer.
+static IngestStream * ingest_stream_init(struct ArrowArrayStream * stream, struct ArrowSchema * schema, struct ArrowArray * first, ErlNifPid producer, ERL_NIF_TERM tag, size_t capacity) {
+    auto ingest = new IngestStream();
+    ArrowSchemaMove(schema, &ingest->schema);
+    ingest->ready.emplace_back();
+    ArrowArrayMove(first, &ingest->ready.back());
+    ingest->producer = producer;
+    ingest->tag = enif_make_copy(ingest->env, tag);
+    {
+        std::lock_guard<std::mutex> lock(ingest->mutex);
+        for (size_t i = 1; i < capacity && ingest->request(); i++) {}
+    }
+
+    stream->get_schema = ingest_stream_get_schema;
+    stream->get_next = ingest_stream_get_next;
+    stream->get_last_error = ingest_stream_get_last_error;
+    stream->release = ingest_stream_release;
+    stream->private_data = ingest;
+    return ingest;
+}
+
+enum class IngestStreamPush {
+    kBatch,
+    kDone,
+    kError
+};
+
+/// Hands `batch`, the end of the stream or the error `reason` to the
+/// consumer of `ingest`. A batch is moved into the stream on success and
+/// released otherwise.
+///
+/// Returns 0 on success. On failure, returns 1 and `error` is set.
+static int ingest_stream_push(IngestStream * ingest, IngestStreamPush kind, struct ArrowSchema * schema, struct ArrowArray * batch, const std::string &reason, std::string &error) {
+    std::lock_guard<std::mutex> lock(ingest->mutex);
+    bool open = !ingest->closed && ingest->state == IngestStream::State::kOpen;
+
+    if (kind == IngestStreamPush::kBatch) {
+        if (!open) {
+            error = "the ingest stream is closed";
+        } else if (ingest->requested == 0) {
+            error = "no batch was requested by the ingest stream";
+        } else if (!ingest_stream_same_schema(&ingest->schema, schema)) {
+            error = "all batches must have the same schema";
+            ingest->fail(error.c_str());
+        } else {
+            ingest->requested--;
+            ingest->ready.emplace_back();
+            ArrowArrayMove(batch, &ingest->ready.back());
+            ingest->cond.notify_all();
+            return 0;
+        }
+        batch->release(batch);
+        return 1;
+    }
+
+    if (open) {
+        if (kind == IngestStreamPush::kDone) {
+            ingest->state = IngestStream::State::kDone;
+            ingest->cond.notify_all();
+        } else {
+            ingest->fail(reason.c_str());
+        }
+    }
+    return 0;
+}
+
+static void destruct_ingest_stream_producer(ErlNifEnv *env, void *args) {
+    auto res = (NifRes<IngestStreamProducer> *)args;
+    IngestStream * ingest = res->val.stream;
+    if (ingest == nullptr) return;
+
+    {
+        std::lock_guard<std::mutex> lock(ingest->mutex);
+        ingest->producer_exited = true;
+        if (ingest->state == IngestStream::State::kOpen && ingest->ready.empty()) {
+            ingest->fail("the producer of the ingested batches exited");
+        }
+    }
+    ingest->unref();
+}
+
+#endif  // ADBC_INGEST_STREAM_HPP
@@ -0,0 +1,149 @@
+#ifndef ADBC_MAPPED_FILE_HPP
+#define ADBC_MAPPED_FILE_HPP
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nanoarrow/nanoarrow.h>
+#include "nif_utils.hpp"
+#ifndef OS_WIN
+#include <sys/mman.h>
+#endif
+
+/// A file mapped read-only in memory, unmapped once the last array over it
+/// is released. The mapping is counted in `count` and `bytes` for as long
+/// as it lives.
+struct MappedFile {
+    const uint8_t * data = nullptr;
+    int64_t size = 0;
+    std::atomic<int64_t> &count;
+    std::atomic<int64_t> &bytes;
+
+    MappedFile(const uint8_t * data, int64_t size, std::atomic<int64_t> &count, std::atomic<int64_t> &bytes)
+        : data(data), size(size), count(count), bytes(bytes) {
+        count++;
+        bytes += size;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifndef OS_WIN
+        if (data != nullptr) munmap((void *)data, (size_t)size);
+#endif
+        count--;
+        bytes -= size;
+    }
+};
+
+/// Maps the `size` first bytes of the open file `fd` into `out`. The file
+/// may be closed afterwards, as the mapping keeps it alive.
+///
+/// Returns 0 on success. On failure, returns 1 and `error` is set.
+static int map_file(int fd, int64_t size, std::atomic<int64_t> &count, std::atomic<int64_t> &bytes, std::shared_ptr<MappedFile> &out, std::string &error) {
+#ifdef OS_WIN
+    (void)fd;
+    (void)size;
+    (void)count;
+    (void)bytes;
+    (void)out;
+    error = "memory-mapped files are not supported on this platform";
+    return 1;
+#else
+    const uint8_t * data = nullptr;
+    // empty files cannot be mapped, and need not be
+    if (size > 0) {
+        void * mapped = mmap(nullptr, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            error = std::string("cannot map file: ") + strerror(errno);
+            return 1;
+        }
+        data = (const uint8_t *)mapped;
+    }
+    out = std::make_shared<MappedFile>(data, size, count, bytes);
+    return 0;
+#endif
+}
+
+/// Where the buffers of an array, its children and its dictionary are in
+/// a mapped file, with -1 for null buffers, and their sizes when known.
+struct MappedArrayNode {
+    int64_t length = 0;
+    int64_t null_count = 0;
+    int64_t offset = 0;
+    std::vector<int64_t> buffers;
+    std::vector<int64_t> sizes;
+    std::vector<MappedArrayNode> children;
+    std::vector<MappedArrayNode> dictionary;
+};
+
+// Private data of the arrays over a mapped file, which own their children
+// and dictionary arrays and a reference to the mapping.
+struct MappedArrayData {
+    std::shared_ptr<MappedFile> file;
+    std::vector<const void *> buffers;
+    std::vector<struct ArrowArray *> children;
+    struct ArrowArray * dictionary = nullptr;
+};
+
+static void arrow_array_mapped_release(struct ArrowArray * array) {
+    auto data = (MappedArrayData *)array->private_data;
+    for (auto child : data->children) {
+        child->release(child);
+        delete child;
+    }
+    if (data->dictionary) {
+        data->dictionary->release(data->dictionary);
+        delete data->dictionary;
+    }
+    delete data;
+    array->private_data = nullptr;
+    array->release = nullptr;
+}
+
+/// Makes `out` the array of `node` over `file`, without copying any of
+/// its buffers.
+static void arrow_array_from_mapped_file(const std::shared_ptr<MappedFile> &file, const MappedArrayNode &node, struct ArrowArray * out) {
+    // buffers of no bytes may be at the very end of the file, or in an
+    // empty file which is not mapped at all
+    alignas(64) static const uint8_t empty[64] = {0};
+
+    auto data = new MappedArrayData{file, {}, {}, nullptr};
+    for (int64_t position : node.buffers) {
+        if (position < 0) {
+            data->buffers.push_back(nullptr);
+        } else if (position < file->size) {
+            data->buffers.push_back(file->data + position);
+        } else {
+            data->buffers.push_back(empty);
+        }
+    }
+    for (const MappedArrayNode &child : node.children) {
+        auto array = new struct ArrowArray;
+        arrow_array_from_mapped_file(file, child, array);
+        data->children.push_back(array);
+    }
+    if (!node.dictionary.empty()) {
+        data->dictionary = new struct ArrowArray;
+        arrow_array_from_mapped_file(file, node.dictionary[0], data->dictionary);
+    }
+
+    out->length = node.length;
+    out->null_count = node.null_count;
+    out->offset = node.offset;
+    out->n_buffers = (int64_t)data->buffers.size();
+    out->n_children = (int64_t)data->children.size();
+    out->buffers = data->buffers.empty() ? nullptr : data->buffers.data();
+    out->children = data->children.empty() ? nullptr : data->children.data();
+    out->dictionary = data->dictionary;
+    out->release = arrow_array_mapped_release;
+    out->private_data = data;
+}
+
+#endif  // ADBC_MAPPED_FILE_HPP
@@ -0,0 +1,221 @@
+#ifndef ADBC_MEMORY_HPP
+#define ADBC_MEMORY_HPP
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <erl_nif.h>
+#include <nanoarrow/nanoarrow.h>
+
+/// Native memory held by the NIF, reported by `Adbc.Nif.memory_stats/0`.
+///
+/// The counters are updated from whichever thread allocates or releases
+/// the memory, which is not always a scheduler, as drivers may release
+/// bound arrays from their own threads.
+struct AdbcMemoryStats {
+    // bytes of the buffers of the arrays built to be bound to statements
+    std::atomic<int64_t> bind_bytes{0};
+    // record batches kept alive by the columns referencing them
+    std::atomic<int64_t> retained_batches{0};
+    std::atomic<int64_t> retained_batch_bytes{0};
+    // schemas kept by streams and by the columns referencing a batch
+    std::atomic<int64_t> retained_schemas{0};
+    // stream resources not yet garbage collected, and the bytes of the
+    // batches read ahead for them by `:prefetch`
+    std::atomic<int64_t> live_streams{0};
+    std::atomic<int64_t> live_stream_bytes{0};
+    // results kept by the cache of queries run with `:cache`
+    std::atomic<int64_t> cached_results{0};
+    std::atomic<int64_t> cached_result_bytes{0};
+    // results held by `Adbc.SharedResult` handles not yet garbage collected
+    std::atomic<int64_t> shared_results{0};
+    std::atomic<int64_t> shared_result_bytes{0};
+    // files mapped by results spilled with `:spill`, which are not
+    // resident unless read
+    std::atomic<int64_t> spilled_results{0};
+    std::atomic<int64_t> spilled_bytes{0};
+    // Arrow IPC files mapped by streams or arrays not yet released
+    std::atomic<int64_t> mapped_files{0};
+    std::atomic<int64_t> mapped_file_bytes{0};
+    // buffers freed by `adbc_memory_allocator` and kept for reuse
+    std::atomic<int64_t> pooled_bytes{0};
+};
+
+static AdbcMemoryStats adbc_memory_stats;
+
+// Buffers of 4 KiB to 64 MiB are allocated in powers of two and, once
+// freed, kept in a free list per size for the next arrays, so that the
+// arrays built for each batch of a bind or an ingest reuse the buffers of
+// the batches the driver released. The lists are bounded, in blocks per
+// size and in bytes overall, and other buffers are freed.
+constexpr int kAdbcMemoryMinPooledClass = 12;
+constexpr int kAdbcMemoryMaxPooledClass = 26;
+constexpr size_t kAdbcMemoryPooledBlocks = 8;
+constexpr int64_t kAdbcMemoryMaxPooledBytes = int64_t{256} << 20;
+// the size class of a buffer is stored before it, keeping the alignment
+// of `enif_alloc`
+constexpr size_t kAdbcMemoryHeader = 16;
+constexpr uint8_t kAdbcMemoryUnpooled = 0xFF;
+
+struct AdbcMemoryPool {
+    std::mutex mutex;
+    std::vector<uint8_t *> blocks[kAdbcMemoryMaxPooledClass + 1];
+};
+
+static AdbcMemoryPool adbc_memory_pool;
+
+static uint8_t adbc_memory_class(int64_t size) {
+    if (size < (int64_t{1} << kAdbcMemoryMinPooledClass) ||
+        size > (int64_t{1} << kAdbcMemoryMaxPooledClass)) {
+        return kAdbcMemoryUnpooled;
+    }
+    int size_class = kAdbcMemoryMinPooledClass;
+    while ((int64_t{1} << size_class) < size) size_class++;
+    return (uint8_t)size_class;
+}
+
+// Returns a buffer of at least `size` bytes, from the pool when possible.
+static uint8_t * adbc_memory_take(int64_t size) {
+    uint8_t size_class = adbc_memory_class(size);
+    uint8_t * block = nullptr;
+    if (size_class != kAdbcMemoryUnpooled) {
+        std::lock_guard<std::mutex> lock(adbc_memory_pool.mutex);
+        auto &blocks = adbc_memory_pool.blocks[size_class];
+        if (!blocks.empty()) {
+            block = blocks.back();
+            blocks.pop_back();
+            adbc_memory_stats.pooled_bytes -= int64_t{1} << size_class;
+            return block + kAdbcMemoryHeader;
+        }
+    }
+
+    size_t bytes = size_class == kAdbcMemoryUnpooled ? (size_t)size : (size_t{1} << size_class);
+    block = (uint8_t *)enif_alloc(kAdbcMemoryHeader + bytes);
+    if (block == nullptr) return nullptr;
+    block[0] = size_class;
+    return block + kAdbcMemoryHeader;
+}
+
+// Gives a buffer of `adbc_memory_take` back to the pool, or frees it when
+// the pool is full.
+static void adbc_memory_give(uint8_t * ptr) {
+    uint8_t * block = ptr - kAdbcMemoryHeader;
+    uint8_t size_class = block[0];
+    if (size_class != kAdbcMemoryUnpooled) {
+        std::lock_guard<std::mutex> lock(adbc_memory_pool.mutex);
+        auto &blocks = adbc_memory_pool.blocks[size_class];
+        int64_t bytes = int64_t{1} << size_class;
+        if (blocks.size() < kAdbcMemoryPooledBlocks &&
+            adbc_memory_stats.pooled_bytes + bytes <= kAdbcMemoryMaxPooledBytes) {
+            blocks.push_back(block);
+            adbc_memory_stats.pooled_bytes += bytes;
+            return;
+        }
+    }
+    enif_free(block);
+}
+
+static uint8_t * adbc_memory_reallocate(struct ArrowBufferAllocator * allocator, uint8_t * ptr, int64_t old_size, int64_t new_size) {
+    auto counter = (std::atomic<int64_t> *)allocator->private_data;
+    uint8_t * out = nullptr;
+    if (ptr == nullptr) {
+        out = adbc_memory_take(new_size);
+    } else {
+        uint8_t size_class = ptr[-(ptrdiff_t)kAdbcMemoryHeader];
+        if (size_class != kAdbcMemoryUnpooled && new_size <= (int64_t{1} << size_class)) {
+            // the buffer already has room for the new size
+            out = ptr;
+        } else if (size_class == kAdbcMemoryUnpooled && adbc_memory_class(new_size) == kAdbcMemoryUnpooled) {
+            auto block = (uint8_t *)enif_realloc(ptr - kAdbcMemoryHeader, kAdbcMemoryHeader + (size_t)new_size);
+            out = block == nullptr ? nullptr : block + kAdbcMemoryHeader;
+        } else if ((out = adbc_memory_take(new_size)) != nullptr) {
+            memcpy(out, ptr, (size_t)(old_size < new_size ? old_size : new_size));
+            adbc_memory_give(ptr);
+        }
+    }
+    if (out != nullptr) {
+        *counter += new_size - (ptr == nullptr ? 0 : old_size);
+    }
+    return out;
+}
+
+static void adbc_memory_free(struct ArrowBufferAllocator * allocator, uint8_t * ptr, int64_t size) {
+    if (ptr == nullptr) return;
+    auto counter = (std::atomic<int64_t> *)allocator->private_data;
+    adbc_memory_give(ptr);
+    *counter -= size;
+}
+
+/// An allocator whose memory comes from `enif_alloc`, so that it shows up
+/// in `erlang:memory/0`, and whose live bytes are kept in `counter`. Freed
+/// buffers are pooled, see `adbc_memory_take`.
+static struct ArrowBufferAllocator adbc_memory_allocator(std::atomic<int64_t> &counter) {
+    struct ArrowBufferAllocator allocator{};
+    allocator.reallocate = adbc_memory_reallocate;
+    allocator.free = adbc_memory_free;
+    allocator.private_data = &counter;
+    return allocator;
+}
+
+/// Sets `allocator` on the buffers of `array`, its children and its
+/// dictionary. `array` must have been just initialised by nanoarrow, as
+/// only buffers that were not allocated yet can change allocator.
+static void adbc_memory_set_allocator(struct ArrowArray * array, struct ArrowBufferAllocator allocator) {
+    auto private_data = (struct ArrowArrayPrivateData *)array->private_data;
+    if (private_data == nullptr) return;
+
+    ArrowBufferSetAllocator(&private_data->bitmap.buffer, allocator);
+    for (int i = 0; i < NANOARROW_MAX_FIXED_BUFFERS - 1; i++) {
+        ArrowBufferSetAllocator(&private_data->buffers[i], allocator);
+    }
+    for (int64_t i = 0; i < array->n_children; i++) {
+        if (array->children[i]->release) {
+            adbc_memory_set_allocator(array->children[i], allocator);
+        }
+    }
+    if (array->dictionary != nullptr && array->dictionary->release) {
+        adbc_memory_set_allocator(array->dictionary, allocator);
+    }
+}
+
+/// Like `ArrowArrayInitFromSchema`, but the buffers of `array` count
+/// towards `AdbcMemoryStats::bind_bytes`.
+static ArrowErrorCode adbc_memory_init_bind_array(struct ArrowArray * array, const struct ArrowSchema * schema, struct ArrowError * error) {
+    NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(array, schema, error));
+    adbc_memory_set_allocator(array, adbc_memory_allocator(adbc_memory_stats.bind_bytes));
+    return NANOARROW_OK;
+}
+
+static int64_t adbc_memory_array_view_bytes(const struct ArrowArrayView * view) {
+    int64_t bytes = 0;
+    for (int i = 0; i < NANOARROW_MAX_FIXED_BUFFERS; i++) {
+        if (view->buffer_views[i].size_bytes > 0) {
+            bytes += view->buffer_views[i].size_bytes;
+        }
+    }
+    for (int64_t i = 0; i < view->n_children; i++) {
+        bytes += adbc_memory_array_view_bytes(view->children[i]);
+    }
+    if (view->dictionary != nullptr) {
+        bytes += adbc_memory_array_view_bytes(view->dictionary);
+    }
+    return bytes;
+}
+
+/// The bytes of the buffers of `array`, or 0 when its type is not known to
+/// nanoarrow.
+static int64_t adbc_memory_array_bytes(const struct ArrowSchema * schema, const struct ArrowArray * array) {
+    struct ArrowArrayView view{};
+    int64_t bytes = 0;
+    if (ArrowArrayViewInitFromSchema(&view, schema, nullptr) == NANOARROW_OK &&
+        ArrowArrayViewSetArray(&view, array, nullptr) == NANOARROW_OK) {
+        bytes = adbc_memory_array_view_bytes(&view);
+    }
+    ArrowArrayViewReset(&view);
+    return bytes;
+}
+
+#endif  // ADBC_MEMORY_HPP
@@ -1,6 +1,8 @@
 #include <cstdbool>
 #include <cstdio>
 #include <climits>
+#include <algorithm>
+#include <numeric>
 #include <adbc.h>
 #include <erl_nif.h>
 #include <nanoarrow/nanoarrow.h>
@@ -9,12 +11,31 @@
 #include "adbc_consts.h"
 #include "adbc_column.hpp"
 #include "adbc_arrow_array.hpp"
+#include "adbc_arena.hpp"
+#include "adbc_call_stats.hpp"
+#include "adbc_worker_pool.hpp"
+#include "adbc_result_cache.hpp"
+#include "adbc_spill.hpp"
+#include "adbc_prefetch_stream.hpp"
+#include "adbc_coalesce_stream.hpp"
+#include "adbc_arrow_concat.hpp"
+#include "adbc_arrow_take.hpp"
+#include "adbc_statistics.hpp"
+#include "adbc_arrow_matrix.hpp"
+#include "adbc_arrow_serialize.hpp"
+#include "adbc_arrow_ipc.hpp"
+#include "adbc_ingest_stream.hpp"
+#include "adbc_driver_cache.hpp"
 
 template<> ErlNifResourceType * NifRes<struct AdbcDatabase>::type = nullptr;
 template<> ErlNifResourceType * NifRes<struct AdbcConnection>::type = nullptr;
 template<> ErlNifResourceType * NifRes<struct AdbcStatement>::type = nullptr;
 template<> ErlNifResourceType * NifRes<struct AdbcError>::type = nullptr;
 template<> ErlNifResourceType * NifRes<struct ArrowArrayStream>::type = nullptr;
+template<> ErlNifResourceType * NifRes<struct ArrowArray>::type = nullptr;
+template<> ErlNifResourceType * NifRes<ArrowColumnReference>::type = nullptr;
+template<> ErlNifResourceType * NifRes<IngestStreamProducer>::type = nullptr;
+template<> ErlNifResourceType * NifRes<SharedResultHandle>::type = nullptr;
 
 static ERL_NIF_TERM nif_error_from_adbc_error(ErlNifEnv *env, struct AdbcError * adbc_error) {
     char const* message = (adbc_error->message == nullptr) ? "unknown error" : adbc_error->message;
@@ -32,6 +53,30 @@ static ERL_NIF_TERM nif_error_from_adbc_error(ErlNifEnv *env, struct AdbcError *
     return nif_error;
 }
 
+// Allocates a stream resource, counted in `AdbcMemoryStats::live_streams`
+// until it is garbage collected.
+static NifRes<struct ArrowArrayStream> * allocate_arrow_array_stream(ErlNifEnv *env, ERL_NIF_TERM &error) {
+    auto res = NifRes<struct ArrowArrayStream>::allocate_resource(env, error);
+    if (res != nullptr) {
+        adbc_memory_stats.live_streams++;
+    }
+    return res;
+}
+
+// Keeps `statement` or `connection` alive until the stream of `res`,
+// which comes from it, is garbage collected.
+static void arrow_array_stream_keep_parent(NifRes<struct ArrowArrayStream> * res, NifRes<struct AdbcStatement> * statement, NifRes<struct AdbcConnection> * connection) {
+    auto state = arrow_array_stream_state(res);
+    if (statement != nullptr) {
+        enif_keep_resource(statement);
+        state->statement = statement;
+    }
+    if (connection != nullptr) {
+        enif_keep_resource(connection);
+        state->connection_resource = connection;
+    }
+}
+
 static ERL_NIF_TERM adbc_database_new(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
     using res_type = NifRes<struct AdbcDatabase>;
 
@@ -211,6 +256,70 @@ static ERL_NIF_TERM adbc_database_set_option(ErlNifEnv *env, int argc, const ERL
     );
 }
 
+// Sets the driver of `database` from its path and entrypoint, an empty
+// entrypoint resolving like the driver manager does. The entrypoint of a
+// driver loaded before is taken from `adbc_driver_cache`, otherwise the
+// driver manager loads it when the database is initialised.
+static ERL_NIF_TERM adbc_database_set_driver(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct AdbcDatabase>;
+
+    ERL_NIF_TERM error{};
+    res_type * database = nullptr;
+    if ((database = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    std::string driver, entrypoint;
+    if (!erlang::nif::get(env, argv[1], driver) || !erlang::nif::get(env, argv[2], entrypoint)) {
+        return enif_make_badarg(env);
+    }
+
+    struct AdbcError adbc_error{};
+    AdbcStatusCode code;
+    AdbcDriverInitFunc init_func = adbc_driver_cache.get(driver, entrypoint);
+    if (init_func != nullptr) {
+        code = AdbcDriverManagerDatabaseSetInitFunc(&database->val, init_func, &adbc_error);
+    } else {
+        code = AdbcDatabaseSetOption(&database->val, "driver", driver.c_str(), &adbc_error);
+        if (code == ADBC_STATUS_OK && !entrypoint.empty()) {
+            code = AdbcDatabaseSetOption(&database->val, "entrypoint", entrypoint.c_str(), &adbc_error);
+        }
+    }
+    if (code != ADBC_STATUS_OK) {
+        return nif_error_from_adbc_error(env, &adbc_error);
+    }
+    return erlang::nif::ok(env);
+}
+
+// Loads the driver at the path given with its entrypoint, as
+// `adbc_database_set_driver` would, and initialises it once, so that the
+// first database started for it does not pay for loading it.
+static ERL_NIF_TERM adbc_driver_preload(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    std::string driver, entrypoint;
+    if (!erlang::nif::get(env, argv[0], driver) || !erlang::nif::get(env, argv[1], entrypoint)) {
+        return enif_make_badarg(env);
+    }
+
+    AdbcDriverInitFunc init_func = adbc_driver_cache.get(driver, entrypoint);
+    if (init_func == nullptr) {
+        return erlang::nif::error(env, "could not load driver or its entrypoint");
+    }
+
+    struct AdbcDriver loaded{};
+    struct AdbcError adbc_error{};
+    AdbcStatusCode code = AdbcLoadDriverFromInitFunc(init_func, ADBC_VERSION_1_1_0, &loaded, &adbc_error);
+    if (code != ADBC_STATUS_OK) {
+        return nif_error_from_adbc_error(env, &adbc_error);
+    }
+    if (loaded.release != nullptr) {
+        loaded.release(&loaded, &adbc_error);
+    }
+    if (adbc_error.release != nullptr) {
+        adbc_error.release(&adbc_error);
+    }
+    return erlang::nif::ok(env);
+}
+
 static ERL_NIF_TERM adbc_database_init(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
     using res_type = NifRes<struct AdbcDatabase>;
 
@@ -295,9 +404,32 @@ static ERL_NIF_TERM adbc_connection_init(ErlNifEnv *env, int argc, const ERL_NIF
     return erlang::nif::ok(env);
 }
 
+// Releases the connection without waiting for it to be garbage collected,
+// for connections no other process holds. The database is still kept
+// until then, and releasing the connection again does nothing.
+static ERL_NIF_TERM adbc_connection_release(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct AdbcConnection>;
+
+    ERL_NIF_TERM error{};
+    res_type * connection = nullptr;
+    if ((connection = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    if (connection->val.private_driver == nullptr && connection->val.private_data == nullptr) {
+        return erlang::nif::ok(env);
+    }
+
+    struct AdbcError adbc_error{};
+    AdbcStatusCode code = AdbcConnectionRelease(&connection->val, &adbc_error);
+    if (code != ADBC_STATUS_OK) {
+        return nif_error_from_adbc_error(env, &adbc_error);
+    }
+    return erlang::nif::ok(env);
+}
+
 static ERL_NIF_TERM adbc_connection_get_info(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
     using res_type = NifRes<struct AdbcConnection>;
-    using array_stream_type = NifRes<struct ArrowArrayStream>;
 
     ERL_NIF_TERM error{};
     res_type * connection = nullptr;
@@ -315,7 +447,7 @@ static ERL_NIF_TERM adbc_connection_get_info(ErlNifEnv *env, int argc, const ERL
         ptr = info_codes.data();
     }
 
-    auto array_stream = array_stream_type::allocate_resource(env, error);
+    auto array_stream = allocate_arrow_array_stream(env, error);
     if (array_stream == nullptr) {
         return error;
     }
@@ -323,16 +455,19 @@ static ERL_NIF_TERM adbc_connection_get_info(ErlNifEnv *env, int argc, const ERL
     struct AdbcError adbc_error{};
     AdbcStatusCode code = AdbcConnectionGetInfo(&connection->val, ptr, info_codes_length, &array_stream->val, &adbc_error);
     if (code != ADBC_STATUS_OK) {
+        enif_release_resource(array_stream);
         return nif_error_from_adbc_error(env, &adbc_error);
     }
+    arrow_array_stream_keep_parent(array_stream, nullptr, connection);
 
     ERL_NIF_TERM ret = array_stream->make_resource(env);
+    enif_release_resource(array_stream);
     return erlang::nif::ok(env, ret);
 }
 
 static ERL_NIF_TERM adbc_connection_get_objects(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    AdbcCallScope scope(adbc_call_stats.get_objects);
     using res_type = NifRes<struct AdbcConnection>;
-    using array_stream_type = NifRes<struct ArrowArrayStream>;
 
     ERL_NIF_TERM error{};
     res_type * connection = nullptr;
@@ -386,27 +521,21 @@ static ERL_NIF_TERM adbc_connection_get_objects(ErlNifEnv *env, int argc, const
         }
     }
 
-    std::vector<const char *> table_types;
+    ScratchArena arena;
+    std::vector<const char *, ScratchAllocator<const char *>> table_types{ScratchAllocator<const char *>(arena)};
+    table_types.reserve(table_type.size() + 1);
     for (auto& tt : table_type) {
-        char * t = (char *)enif_alloc(tt.size + 1);
+        char * t = arena.copy_string(tt.data, tt.size);
         if (t == nullptr) {
-            for (auto& at : table_types) {
-                enif_free((void *)at);
-            }
             return erlang::nif::error(env, "out of memory");
         }
-        memcpy(t, tt.data, tt.size);
-        t[tt.size] = '\0';
         table_types.emplace_back(t);
     }
     // Terminate the list with a NULL entry.
     table_types.emplace_back(nullptr);
 
-    auto array_stream = array_stream_type::allocate_resource(env, error);
+    auto array_stream = allocate_arrow_array_stream(env, error);
     if (array_stream == nullptr) {
-        for (auto& at : table_types) {
-            if (at) enif_free((void *)at);
-        }
         return error;
     }
 
@@ -422,23 +551,18 @@ static ERL_NIF_TERM adbc_connection_get_objects(ErlNifEnv *env, int argc, const
         &array_stream->val,
         &adbc_error);
     if (code != ADBC_STATUS_OK) {
-        for (auto& at : table_types) {
-            if (at) enif_free((void *)at);
-        }
+        enif_release_resource(array_stream);
         return nif_error_from_adbc_error(env, &adbc_error);
     }
+    arrow_array_stream_keep_parent(array_stream, nullptr, connection);
 
     ERL_NIF_TERM ret = array_stream->make_resource(env);
-    for (auto& at : table_types) {
-        if (at) enif_free((void *)at);
-    }
-
+    enif_release_resource(array_stream);
     return enif_make_tuple2(env, erlang::nif::ok(env), ret);
 }
 
 static ERL_NIF_TERM adbc_connection_get_table_types(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
     using res_type = NifRes<struct AdbcConnection>;
-    using array_stream_type = NifRes<struct ArrowArrayStream>;
 
     ERL_NIF_TERM error{};
     res_type * connection = nullptr;
@@ -446,7 +570,7 @@ static ERL_NIF_TERM adbc_connection_get_table_types(ErlNifEnv *env, int argc, co
         return error;
     }
 
-    auto array_stream = array_stream_type::allocate_resource(env, error);
+    auto array_stream = allocate_arrow_array_stream(env, error);
     if (array_stream == nullptr) {
         return error;
     }
@@ -454,238 +578,2751 @@ static ERL_NIF_TERM adbc_connection_get_table_types(ErlNifEnv *env, int argc, co
     struct AdbcError adbc_error{};
     AdbcStatusCode code = AdbcConnectionGetTableTypes(&connection->val, &array_stream->val, &adbc_error);
     if (code != ADBC_STATUS_OK) {
+        enif_release_resource(array_stream);
         return nif_error_from_adbc_error(env, &adbc_error);
     }
+    arrow_array_stream_keep_parent(array_stream, nullptr, connection);
 
     ERL_NIF_TERM ret = array_stream->make_resource(env);
+    enif_release_resource(array_stream);
 
     return enif_make_tuple2(env, erlang::nif::ok(env), ret);
 }
 
-static ERL_NIF_TERM adbc_arrow_array_stream_get_pointer(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-    using res_type = NifRes<struct ArrowArrayStream>;
-    ERL_NIF_TERM error{};
-
-    res_type * res = nullptr;
-    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
-        return error;
-    }
-
-    return enif_make_uint64(env, reinterpret_cast<uint64_t>(&res->val));
-}
+// Returns a stream of the statistics of the tables matching the catalog,
+// database schema and table name patterns, any of which may be nil, only
+// exact when `argv[4]` is false.
+static ERL_NIF_TERM adbc_connection_get_statistics(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct AdbcConnection>;
 
-static ERL_NIF_TERM adbc_arrow_array_stream_next(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-    using res_type = NifRes<struct ArrowArrayStream>;
-    ERL_NIF_TERM ret{};
     ERL_NIF_TERM error{};
-
-    res_type * res = nullptr;
-    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
-        return error;
-    }
-    if (res->val.get_next == nullptr) {
-        return enif_make_badarg(env);
-    }
-
-    struct ArrowArray out{};
-    int code = res->val.get_next(&res->val, &out);
-    if (code != 0) {
-        const char * reason = res->val.get_last_error(&res->val);
-        return erlang::nif::error(env, reason ? reason : "unknown error");
-    }
-
-    if (res->private_data != nullptr) {
-        enif_free(res->private_data);
-        res->private_data = nullptr;
-    }
-
-    res->private_data = enif_alloc(sizeof(struct ArrowSchema));
-    memset(res->private_data, 0, sizeof(struct ArrowSchema));
-    code = res->val.get_schema(&res->val, (struct ArrowSchema *)res->private_data);
-    if (code != 0) {
-        const char * reason = res->val.get_last_error(&res->val);
-        enif_free(res->private_data);
-        res->private_data = nullptr;
-        return erlang::nif::error(env, reason ? reason : "unknown error");
-    }
-
-    std::vector<ERL_NIF_TERM> out_terms;
-
-    auto schema = (struct ArrowSchema*)res->private_data;
-    bool end_of_series = false;
-    ERL_NIF_TERM out_type;
-    ERL_NIF_TERM out_metadata;
-    if (arrow_array_to_nif_term(env, schema, &out, 0, out_terms, out_type, out_metadata, error, &end_of_series) == 1) {
-        if (out.release) out.release(&out);
+    res_type * connection = nullptr;
+    if ((connection = res_type::get_resource(env, argv[0], error)) == nullptr) {
         return error;
     }
 
-    if (out_terms.size() == 1) {
-        ret = out_terms[0];
-        if (end_of_series) {
-            if (out.release) {
-                out.release(&out);
-            }
-            return kAtomEndOfSeries;
+    std::string patterns[3];
+    const char * patterns_p[3] = {nullptr, nullptr, nullptr};
+    for (int i = 0; i < 3; i++) {
+        if (erlang::nif::get(env, argv[i + 1], patterns[i])) {
+            patterns_p[i] = patterns[i].c_str();
+        } else if (!erlang::nif::check_nil(env, argv[i + 1])) {
+            return enif_make_badarg(env);
         }
-    } else {
-        ret = enif_make_tuple2(env, out_terms[0], out_terms[1]);
     }
-
-    if (out.release) {
-        out.release(&out);
-        return enif_make_tuple3(env, erlang::nif::ok(env), ret, enif_make_int64(env, 1));
-    } else {
-        return enif_make_tuple3(env, erlang::nif::ok(env), ret, enif_make_int64(env, 0));
+    bool approximate = false;
+    if (!erlang::nif::get(env, argv[4], &approximate)) {
+        return enif_make_badarg(env);
     }
-}
-
-static ERL_NIF_TERM adbc_arrow_array_stream_release(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-    using res_type = NifRes<struct ArrowArrayStream>;
-    ERL_NIF_TERM error{};
 
-    res_type * res = nullptr;
-    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+    auto array_stream = allocate_arrow_array_stream(env, error);
+    if (array_stream == nullptr) {
         return error;
     }
 
-    if (res->val.release) {
-        res->val.release(&res->val);
-        res->val.release = nullptr;
+    struct AdbcError adbc_error{};
+    AdbcStatusCode code = AdbcConnectionGetStatistics(&connection->val, patterns_p[0], patterns_p[1], patterns_p[2], approximate ? 1 : 0, &array_stream->val, &adbc_error);
+    if (code != ADBC_STATUS_OK) {
+        enif_release_resource(array_stream);
+        return nif_error_from_adbc_error(env, &adbc_error);
     }
+    arrow_array_stream_keep_parent(array_stream, nullptr, connection);
 
-    return erlang::nif::ok(env);
+    ERL_NIF_TERM ret = array_stream->make_resource(env);
+    enif_release_resource(array_stream);
+
+    return enif_make_tuple2(env, erlang::nif::ok(env), ret);
 }
 
-static ERL_NIF_TERM adbc_statement_new(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-    using res_type = NifRes<struct AdbcStatement>;
-    using connection_type = NifRes<struct AdbcConnection>;
+static ERL_NIF_TERM adbc_connection_get_statistic_names(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct AdbcConnection>;
 
     ERL_NIF_TERM error{};
-
-    connection_type * connection = nullptr;
-    if ((connection = connection_type::get_resource(env, argv[0], error)) == nullptr) {
+    res_type * connection = nullptr;
+    if ((connection = res_type::get_resource(env, argv[0], error)) == nullptr) {
         return error;
     }
 
-    auto statement = res_type::allocate_resource(env, error);
-    if (statement == nullptr) {
+    auto array_stream = allocate_arrow_array_stream(env, error);
+    if (array_stream == nullptr) {
         return error;
     }
 
     struct AdbcError adbc_error{};
-    AdbcStatusCode code = AdbcStatementNew(&connection->val, &statement->val, &adbc_error);
+    AdbcStatusCode code = AdbcConnectionGetStatisticNames(&connection->val, &array_stream->val, &adbc_error);
     if (code != ADBC_STATUS_OK) {
+        enif_release_resource(array_stream);
         return nif_error_from_adbc_error(env, &adbc_error);
     }
+    arrow_array_stream_keep_parent(array_stream, nullptr, connection);
 
-    connection->private_data = &connection->val;
-    enif_keep_resource(&connection->val);
-    ERL_NIF_TERM ret = statement->make_resource(env);
-    return erlang::nif::ok(env, ret);
-}
-
-static ERL_NIF_TERM adbc_statement_get_option(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-    return adbc_get_option<struct AdbcStatement>(
-        env,
-        argv,
-        AdbcStatementGetOption,
-        AdbcStatementGetOptionBytes,
-        AdbcStatementGetOptionInt,
-        AdbcStatementGetOptionDouble
-    );
-}
+    ERL_NIF_TERM ret = array_stream->make_resource(env);
+    enif_release_resource(array_stream);
 
-static ERL_NIF_TERM adbc_statement_set_option(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-    return adbc_set_option<struct AdbcStatement>(
-        env,
-        argv,
-        AdbcStatementSetOption,
-        AdbcStatementSetOptionBytes,
-        AdbcStatementSetOptionInt,
-        AdbcStatementSetOptionDouble
-    );
+    return enif_make_tuple2(env, erlang::nif::ok(env), ret);
 }
 
-static ERL_NIF_TERM adbc_statement_execute_query(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-    using res_type = NifRes<struct AdbcStatement>;
-    using array_stream_type = NifRes<struct ArrowArrayStream>;
+static ERL_NIF_TERM adbc_connection_read_partition(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct AdbcConnection>;
 
     ERL_NIF_TERM error{};
-
-    res_type * statement = nullptr;
-    if ((statement = res_type::get_resource(env, argv[0], error)) == nullptr) {
+    res_type * connection = nullptr;
+    if ((connection = res_type::get_resource(env, argv[0], error)) == nullptr) {
         return error;
     }
 
-    auto array_stream = array_stream_type::allocate_resource(env, error);
+    ErlNifBinary partition;
+    if (!enif_inspect_binary(env, argv[1], &partition)) {
+        return enif_make_badarg(env);
+    }
+
+    auto array_stream = allocate_arrow_array_stream(env, error);
     if (array_stream == nullptr) {
         return error;
     }
 
-    int64_t rows_affected = 0;
     struct AdbcError adbc_error{};
-    AdbcStatusCode code = AdbcStatementExecuteQuery(&statement->val, &array_stream->val, &rows_affected, &adbc_error);
+    AdbcStatusCode code = AdbcConnectionReadPartition(&connection->val, partition.data, partition.size, &array_stream->val, &adbc_error);
     if (code != ADBC_STATUS_OK) {
+        enif_release_resource(array_stream);
         return nif_error_from_adbc_error(env, &adbc_error);
     }
+    arrow_array_stream_keep_parent(array_stream, nullptr, connection);
 
     ERL_NIF_TERM ret = array_stream->make_resource(env);
-    return enif_make_tuple3(env,
-        erlang::nif::ok(env),
-        ret,
-        enif_make_int64(env, rows_affected)
-    );
-}
+    enif_release_resource(array_stream);
 
-static ERL_NIF_TERM adbc_statement_prepare(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-    using res_type = NifRes<struct AdbcStatement>;
+    return enif_make_tuple2(env, erlang::nif::ok(env), ret);
+}
 
+static ERL_NIF_TERM adbc_arrow_array_stream_get_pointer(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
     ERL_NIF_TERM error{};
 
-    res_type * statement = nullptr;
-    if ((statement = res_type::get_resource(env, argv[0], error)) == nullptr) {
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
         return error;
     }
 
-    struct AdbcError adbc_error{};
-    AdbcStatusCode code = AdbcStatementPrepare(&statement->val, &adbc_error);
-    if (code != ADBC_STATUS_OK) {
-        return nif_error_from_adbc_error(env, &adbc_error);
-    }
-
-    return erlang::nif::ok(env);
+    return enif_make_uint64(env, reinterpret_cast<uint64_t>(&res->val));
 }
 
-static ERL_NIF_TERM adbc_statement_set_sql_query(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-    using res_type = NifRes<struct AdbcStatement>;
-
-    ERL_NIF_TERM error{};
+// Number of rows converted at a time before checking the timeslice
+constexpr int64_t kArrowArrayStreamNextChunkRows = 4096;
 
-    res_type * statement = nullptr;
-    if ((statement = res_type::get_resource(env, argv[0], error)) == nullptr) {
-        return error;
+// Concatenates a list of lists given in reverse order.
+static ERL_NIF_TERM concat_reversed_lists(ErlNifEnv *env, ERL_NIF_TERM reversed_lists) {
+    std::vector<ERL_NIF_TERM> lists;
+    ERL_NIF_TERM head, tail = reversed_lists;
+    while (enif_get_list_cell(env, tail, &head, &tail)) {
+        lists.push_back(head);
     }
-
-    std::string query;
-    if (!erlang::nif::get(env, argv[1], query)) {
-        return enif_make_badarg(env);
+    if (lists.size() == 1) {
+        return lists[0];
     }
 
-    struct AdbcError adbc_error{};
-    AdbcStatusCode code = AdbcStatementSetSqlQuery(&statement->val, query.c_str(), &adbc_error);
-    if (code != ADBC_STATUS_OK) {
-        return nif_error_from_adbc_error(env, &adbc_error);
+    std::vector<ERL_NIF_TERM> items;
+    for (auto list = lists.rbegin(); list != lists.rend(); ++list) {
+        tail = *list;
+        while (enif_get_list_cell(env, tail, &head, &tail)) {
+            items.push_back(head);
+        }
     }
+    return enif_make_list_from_array(env, items.data(), (unsigned)items.size());
+}
 
-    return erlang::nif::ok(env);
+// Sorts `keys`, shared by the maps of many rows, and sets `positions` to
+// the index of each key once sorted. Given sorted keys, with the values
+// stored at these positions, enif_make_map_from_arrays only checks the
+// order of the keys of each map instead of sorting them again.
+// Returns false if there are duplicate keys.
+static bool sort_shared_map_keys(ErlNifEnv *env, std::vector<ERL_NIF_TERM> &keys, std::vector<size_t> &positions) {
+    std::vector<size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return enif_compare(keys[a], keys[b]) < 0;
+    });
+
+    std::vector<ERL_NIF_TERM> sorted(keys.size());
+    positions.resize(keys.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        sorted[i] = keys[order[i]];
+        positions[order[i]] = i;
+        if (i > 0 && enif_compare(sorted[i - 1], sorted[i]) == 0) {
+            return false;
+        }
+    }
+    keys.swap(sorted);
+    return true;
 }
 
-static ERL_NIF_TERM adbc_statement_bind(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-    using res_type = NifRes<struct AdbcStatement>;
+// Returns the value of each row of a column term. Struct columns have a
+// map of the values of their children per row.
+static int adbc_column_row_values(ErlNifEnv *env, ERL_NIF_TERM column, std::vector<ERL_NIF_TERM> &values, ERL_NIF_TERM &error) {
+    ERL_NIF_TERM type, data;
+    if (!enif_get_map_value(env, column, kAtomTypeKey, &type) || !enif_get_map_value(env, column, kAtomDataKey, &data)) {
+        error = erlang::nif::error(env, "invalid Adbc.Column");
+        return 1;
+    }
+
+    ERL_NIF_TERM head, tail = data;
+    if (enif_is_identical(type, kAdbcColumnTypeStruct)) {
+        std::vector<ERL_NIF_TERM> names;
+        std::vector<std::vector<ERL_NIF_TERM>> children;
+        while (enif_get_list_cell(env, tail, &head, &tail)) {
+            ERL_NIF_TERM name;
+            if (!enif_get_map_value(env, head, kAtomNameKey, &name)) {
+                error = erlang::nif::error(env, "invalid Adbc.Column");
+                return 1;
+            }
+            names.push_back(name);
+            children.emplace_back();
+            if (adbc_column_row_values(env, head, children.back(), error) == 1) {
+                return 1;
+            }
+        }
 
-    ERL_NIF_TERM ret{};
-    ERL_NIF_TERM error{};
+        size_t n_rows = children.empty() ? 0 : children[0].size();
+        for (auto &child_values : children) {
+            if (child_values.size() != n_rows) {
+                error = erlang::nif::error(env, "struct children have different lengths");
+                return 1;
+            }
+        }
+        std::vector<size_t> positions;
+        if (!sort_shared_map_keys(env, names, positions)) {
+            error = erlang::nif::error(env, "struct children have duplicate names");
+            return 1;
+        }
+
+        std::vector<ERL_NIF_TERM> row(children.size());
+        values.reserve(n_rows);
+        for (size_t i = 0; i < n_rows; i++) {
+            for (size_t c = 0; c < children.size(); c++) {
+                row[positions[c]] = children[c][i];
+            }
+            ERL_NIF_TERM value;
+            enif_make_map_from_arrays(env, names.data(), row.data(), row.size(), &value);
+            values.push_back(value);
+        }
+        return 0;
+    }
+
+    while (enif_get_list_cell(env, tail, &head, &tail)) {
+        values.push_back(head);
+    }
+    if (!enif_is_empty_list(env, tail)) {
+        error = erlang::nif::error(env, "cannot return the values of a column as rows");
+        return 1;
+    }
+    return 0;
+}
+
+// Turns a list of column terms into a list of rows, either tuples or maps.
+// All maps are built from a single array of keys, sorted once.
+static int adbc_columns_to_rows(ErlNifEnv *env, ERL_NIF_TERM columns, ArrowStreamOutput output, ERL_NIF_TERM &rows, ERL_NIF_TERM &error) {
+    std::vector<ERL_NIF_TERM> keys;
+    std::vector<std::vector<ERL_NIF_TERM>> values;
+    ERL_NIF_TERM head, tail = columns;
+    while (enif_get_list_cell(env, tail, &head, &tail)) {
+        ERL_NIF_TERM name;
+        if (!enif_get_map_value(env, head, kAtomNameKey, &name)) {
+            error = erlang::nif::error(env, "invalid Adbc.Column");
+            return 1;
+        }
+        keys.push_back(name);
+        values.emplace_back();
+        if (adbc_column_row_values(env, head, values.back(), error) == 1) {
+            return 1;
+        }
+    }
+
+    size_t n_rows = values.empty() ? 0 : values[0].size();
+    for (auto &column_values : values) {
+        if (column_values.size() != n_rows) {
+            error = erlang::nif::error(env, "columns have different lengths");
+            return 1;
+        }
+    }
+
+    std::vector<size_t> positions(keys.size());
+    std::iota(positions.begin(), positions.end(), 0);
+    if (output == ArrowStreamOutput::kRowsMaps && !sort_shared_map_keys(env, keys, positions)) {
+        error = erlang::nif::error(env, "cannot return rows as maps, the result has duplicate column names");
+        return 1;
+    }
+
+    std::vector<ERL_NIF_TERM> row_terms(n_rows);
+    std::vector<ERL_NIF_TERM> row(keys.size());
+    for (size_t i = 0; i < n_rows; i++) {
+        for (size_t c = 0; c < keys.size(); c++) {
+            row[positions[c]] = values[c][i];
+        }
+        if (output == ArrowStreamOutput::kRowsTuples) {
+            row_terms[i] = enif_make_tuple_from_array(env, row.data(), (unsigned)row.size());
+        } else {
+            enif_make_map_from_arrays(env, keys.data(), row.data(), row.size(), &row_terms[i]);
+        }
+    }
+
+    rows = enif_make_list_from_array(env, row_terms.data(), (unsigned)row_terms.size());
+    return 0;
+}
+
+// Returns the state of the stream, reading its schema and compiling the
+// plan of its top-level columns the first time it is called.
+static ArrowArrayStreamState * get_arrow_array_stream_state(ErlNifEnv *env, NifRes<struct ArrowArrayStream> * res, ERL_NIF_TERM &error) {
+    auto state = arrow_array_stream_state(res);
+    if (state->schema.release != nullptr) {
+        return state;
+    }
+
+    if (res->val.get_schema(&res->val, &state->schema) != 0) {
+        const char * reason = res->val.get_last_error(&res->val);
+        error = erlang::nif::error(env, reason ? reason : "unknown error");
+        return nullptr;
+    }
+    adbc_memory_stats.retained_schemas++;
+
+    struct ArrowSchema * schema = &state->schema;
+    if (schema->children != nullptr) {
+        state->columns.resize(schema->n_children);
+        for (int64_t i = 0; i < schema->n_children; i++) {
+            struct ArrowSchema * column_schema = schema->children[i];
+            auto &plan = state->columns[i];
+            plan.sliceable = arrow_array_is_row_sliceable(column_schema);
+            plan.nullable = column_schema->flags & ARROW_FLAG_NULLABLE;
+            plan.name = erlang::nif::make_binary(state->env, column_schema->name ? column_schema->name : "");
+            plan.metadata = arrow_schema_metadata_to_nif_term(state->env, column_schema);
+            plan.raw_width = arrow_schema_raw_width(state->env, column_schema, plan.raw_type);
+            const char * format = column_schema->format ? column_schema->format : "";
+            if (plan.raw_width > 0 && strlen(format) == 1) {
+                plan.flat_format = format[0];
+            }
+            if (strncmp(format, "+w:", 3) == 0 && column_schema->n_children == 1) {
+                ERL_NIF_TERM item_type;
+                size_t width = arrow_schema_raw_width(state->env, column_schema->children[0], item_type);
+                int64_t size = strtoll(format + 3, nullptr, 10);
+                if (width > 0 && size > 0) {
+                    plan.list_size = size;
+                    plan.list_width = width;
+                    plan.list_type = enif_make_tuple3(state->env, kAdbcColumnTypeFixedSizeList, item_type, enif_make_int64(state->env, size));
+                }
+            }
+            if (column_schema->metadata != nullptr && (strcmp(format, "u") == 0 || strcmp(format, "U") == 0)) {
+                struct ArrowStringView typname{};
+                ArrowMetadataGetValue(column_schema->metadata, ArrowCharView("ADBC:postgresql:typname"), &typname);
+                plan.numeric = typname.data != nullptr && typname.size_bytes == 7 && strncmp(typname.data, "numeric", 7) == 0;
+            }
+        }
+        state->flat_rows = schema->n_children > 0 && std::all_of(state->columns.begin(), state->columns.end(), [](const ArrowStreamColumnPlan &plan) {
+            return plan.flat_format != 0;
+        });
+    }
+
+    return state;
+}
+
+// Writes the values of rows `offset` to `offset + count` of a fixed-width
+// column to every `stride`-th cell of `cells`.
+template <typename T, typename M>
+static void flat_column_cells(ErlNifEnv *env, const struct ArrowArray * column, int64_t offset, int64_t count, ERL_NIF_TERM * cells, size_t stride, const M &value_to_nif) {
+    auto validity = (const uint8_t *)column->buffers[0];
+    auto data = (const T *)column->buffers[1] + column->offset;
+    if (validity == nullptr || column->null_count == 0) {
+        for (int64_t i = 0; i < count; i++) {
+            cells[i * stride] = value_to_nif(env, data[offset + i]);
+        }
+        return;
+    }
+    arrow_bitmap_visit(validity, column->offset + offset, count, [&](int64_t i, bool valid) {
+        cells[i * stride] = valid ? value_to_nif(env, data[offset + i]) : kAtomNil;
+    });
+}
+
+// Builds rows `offset` to `offset + count` of a batch whose columns all
+// have a `flat_format`, filling the cells of each column in a loop of its
+// own type and then each row from contiguous cells.
+static int arrow_batch_to_flat_rows(ErlNifEnv *env, ArrowArrayStreamState * state, const struct ArrowArray * batch, int64_t offset, int64_t count, ERL_NIF_TERM &rows, ERL_NIF_TERM &error) {
+    size_t n_columns = state->columns.size();
+    // the buffers are checked once per batch rather than once per value
+    for (size_t c = 0; c < n_columns; c++) {
+        const struct ArrowArray * column = batch->children[c];
+        if (column->n_buffers != 2 || column->buffers == nullptr || column->buffers[1] == nullptr || column->length < batch->length) {
+            error = erlang::nif::error(env, "invalid ArrowArray of a fixed-width column");
+            return 1;
+        }
+    }
+
+    // the cells of maps are written in the order of their sorted keys
+    std::vector<ERL_NIF_TERM> keys;
+    std::vector<size_t> positions(n_columns);
+    std::iota(positions.begin(), positions.end(), 0);
+    if (state->output == ArrowStreamOutput::kRowsMaps) {
+        for (auto &plan : state->columns) {
+            keys.push_back(enif_make_copy(env, plan.name));
+        }
+        if (!sort_shared_map_keys(env, keys, positions)) {
+            error = erlang::nif::error(env, "cannot return rows as maps, the result has duplicate column names");
+            return 1;
+        }
+    }
+
+    std::vector<ERL_NIF_TERM> cells((size_t)count * n_columns);
+    for (size_t c = 0; c < n_columns; c++) {
+        const struct ArrowArray * column = batch->children[c];
+        ERL_NIF_TERM * column_cells = cells.data() + positions[c];
+        switch (state->columns[c].flat_format) {
+            case 'c': flat_column_cells<int8_t>(env, column, offset, count, column_cells, n_columns, enif_make_int64); break;
+            case 's': flat_column_cells<int16_t>(env, column, offset, count, column_cells, n_columns, enif_make_int64); break;
+            case 'i': flat_column_cells<int32_t>(env, column, offset, count, column_cells, n_columns, enif_make_int64); break;
+            case 'l': flat_column_cells<int64_t>(env, column, offset, count, column_cells, n_columns, enif_make_int64); break;
+            case 'C': flat_column_cells<uint8_t>(env, column, offset, count, column_cells, n_columns, enif_make_uint64); break;
+            case 'S': flat_column_cells<uint16_t>(env, column, offset, count, column_cells, n_columns, enif_make_uint64); break;
+            case 'I': flat_column_cells<uint32_t>(env, column, offset, count, column_cells, n_columns, enif_make_uint64); break;
+            case 'L': flat_column_cells<uint64_t>(env, column, offset, count, column_cells, n_columns, enif_make_uint64); break;
+            case 'f': flat_column_cells<float>(env, column, offset, count, column_cells, n_columns, enif_make_double); break;
+            default: flat_column_cells<double>(env, column, offset, count, column_cells, n_columns, enif_make_double); break;
+        }
+    }
+
+    std::vector<ERL_NIF_TERM> row_terms((size_t)count);
+    for (int64_t i = 0; i < count; i++) {
+        ERL_NIF_TERM * row = cells.data() + i * n_columns;
+        if (state->output == ArrowStreamOutput::kRowsTuples) {
+            row_terms[i] = enif_make_tuple_from_array(env, row, (unsigned)n_columns);
+        } else {
+            enif_make_map_from_arrays(env, keys.data(), row, n_columns, &row_terms[i]);
+        }
+    }
+
+    rows = enif_make_list_from_array(env, row_terms.data(), (unsigned)row_terms.size());
+    return 0;
+}
+
+// Builds the rows of a batch with `arrow_batch_to_flat_rows`,
+// `kArrowArrayStreamNextChunkRows` at a time, and reschedules itself
+// whenever the timeslice is used up.
+//
+// argv: stream, batch, row offset and built chunks of rows (reversed).
+static ERL_NIF_TERM adbc_arrow_array_stream_next_flat_rows(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    AdbcCallScope scope(adbc_call_stats.stream_next);
+    using res_type = NifRes<struct ArrowArrayStream>;
+    using array_type = NifRes<struct ArrowArray>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    array_type * batch = nullptr;
+    if ((batch = array_type::get_resource(env, argv[1], error)) == nullptr) {
+        return error;
+    }
+    int64_t offset = 0;
+    if (!erlang::nif::get(env, argv[2], &offset)) {
+        return enif_make_badarg(env);
+    }
+    ERL_NIF_TERM chunks = argv[3];
+
+    auto state = (ArrowArrayStreamState *)res->private_data;
+    if (state == nullptr || batch->val.release == nullptr) {
+        return erlang::nif::error(env, "invalid ArrowArrayStream, the stream was released while reading a batch");
+    }
+
+    bool can_yield = enif_thread_type() == ERL_NIF_THR_NORMAL_SCHEDULER;
+    ErlNifTime start = enif_monotonic_time(ERL_NIF_USEC);
+    int64_t length = batch->val.length;
+    while (offset < length) {
+        int64_t count = can_yield ? std::min(kArrowArrayStreamNextChunkRows, length - offset) : length - offset;
+        ERL_NIF_TERM rows;
+        if (arrow_batch_to_flat_rows(env, state, &batch->val, offset, count, rows, error) == 1) {
+            return error;
+        }
+        chunks = enif_make_list_cell(env, rows, chunks);
+        offset += count;
+
+        if (can_yield && offset < length) {
+            ErlNifTime now = enif_monotonic_time(ERL_NIF_USEC);
+            // a timeslice is 1ms, so 10us is 1 percent of it
+            int percent = (int)std::max<ErlNifTime>(1, std::min<ErlNifTime>(100, (now - start) / 10));
+            start = now;
+            if (enif_consume_timeslice(env, percent)) {
+                ERL_NIF_TERM args[] = {argv[0], argv[1], enif_make_int64(env, offset), chunks};
+                return enif_schedule_nif(env, "adbc_arrow_array_stream_next", 0, adbc_arrow_array_stream_next_flat_rows, 4, args);
+            }
+        }
+    }
+
+    ERL_NIF_TERM ret = concat_reversed_lists(env, chunks);
+    release_retained_batch(batch);
+    return enif_make_tuple3(env, erlang::nif::ok(env), ret, enif_make_int64(env, 1));
+}
+
+// Whether `batch` can be read by `arrow_batch_to_flat_rows`.
+static bool arrow_batch_has_flat_rows(ArrowArrayStreamState * state, const struct ArrowArray * batch) {
+    bool has_validity = batch->n_buffers > 0 && batch->buffers && batch->buffers[0];
+    return state->flat_rows && state->output != ArrowStreamOutput::kColumns && batch->release != nullptr &&
+        !has_validity && batch->children != nullptr && batch->n_children == (int64_t)state->columns.size();
+}
+
+// Makes a column of `batch` whose data is `{:lazy, reference, 0, length}`
+// and is only converted when requested.
+static int make_lazy_adbc_column(ErlNifEnv *env, NifRes<struct ArrowArray> * batch, struct ArrowSchema * column_schema, struct ArrowArray * column_values, const ArrowStreamColumnPlan &plan, ERL_NIF_TERM &out, ERL_NIF_TERM &error) {
+    using reference_type = NifRes<ArrowColumnReference>;
+
+    // converting no rows gives the type of the column without reading it
+    ArrowColumnContext context{enif_make_copy(env, plan.name), enif_make_copy(env, plan.metadata), nullptr};
+    std::vector<ERL_NIF_TERM> out_terms;
+    ERL_NIF_TERM column_type;
+    ERL_NIF_TERM column_metadata;
+    if (arrow_array_to_nif_term(env, column_schema, column_values, 0, 0, 1, out_terms, column_type, column_metadata, error, nullptr, &context) == 1) {
+        return 1;
+    }
+    if (out_terms.size() != 2) {
+        error = erlang::nif::error(env, "cannot make a lazy column of a nested type");
+        return 1;
+    }
+
+    auto reference = reference_type::allocate_resource(env, error);
+    if (reference == nullptr) {
+        return 1;
+    }
+    if (ArrowSchemaDeepCopy(column_schema, &reference->val.schema) != NANOARROW_OK) {
+        enif_release_resource(reference);
+        error = erlang::nif::error(env, "cannot copy the schema of a lazy column");
+        return 1;
+    }
+    adbc_memory_stats.retained_schemas++;
+    reference->val.values = column_values;
+    enif_keep_resource(batch);
+    reference->val.owner = batch;
+    ERL_NIF_TERM reference_term = reference->make_resource(env);
+    enif_release_resource(reference);
+
+    ERL_NIF_TERM data = enif_make_tuple4(env, kAtomLazy, reference_term, enif_make_int64(env, 0), enif_make_int64(env, column_values->length));
+    bool nullable = plan.nullable || (column_values->null_count != 0);
+    out = make_adbc_column(env, out_terms[0], column_type, nullable, column_metadata, data);
+    return 0;
+}
+
+// Converts the columns of a record batch, `kArrowArrayStreamNextChunkRows`
+// rows at a time, and reschedules itself whenever the timeslice is used up.
+//
+// argv: stream, batch, column index, row offset within the column,
+// converted columns (reversed) and converted chunks of the current column
+// (reversed).
+static ERL_NIF_TERM adbc_arrow_array_stream_next_batch(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    AdbcCallScope scope(adbc_call_stats.stream_next);
+    using res_type = NifRes<struct ArrowArrayStream>;
+    using array_type = NifRes<struct ArrowArray>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    array_type * batch = nullptr;
+    if ((batch = array_type::get_resource(env, argv[1], error)) == nullptr) {
+        return error;
+    }
+    int64_t column = 0, offset = 0;
+    if (!erlang::nif::get(env, argv[2], &column) || !erlang::nif::get(env, argv[3], &offset)) {
+        return enif_make_badarg(env);
+    }
+    ERL_NIF_TERM columns = argv[4];
+    ERL_NIF_TERM chunks = argv[5];
+
+    auto state = (ArrowArrayStreamState *)res->private_data;
+    struct ArrowArray * values = &batch->val;
+    if (state == nullptr || values->release == nullptr) {
+        return erlang::nif::error(env, "invalid ArrowArrayStream, the stream was released while reading a batch");
+    }
+
+    bool can_yield = enif_thread_type() == ERL_NIF_THR_NORMAL_SCHEDULER;
+    ErlNifTime start = enif_monotonic_time(ERL_NIF_USEC);
+    while (column < values->n_children) {
+        struct ArrowSchema * column_schema = state->schema.children[column];
+        struct ArrowArray * column_values = values->children[column];
+        const auto &plan = state->columns[column];
+
+        bool as_columns = state->output == ArrowStreamOutput::kColumns;
+        if (as_columns && state->raw_columns && plan.raw_width > 0) {
+            ERL_NIF_TERM data;
+            if (arrow_array_to_raw_nif_term(env, column_values, plan.raw_width, data, error) == 1) {
+                return error;
+            }
+            bool nullable = plan.nullable || (column_values->null_count != 0);
+            ERL_NIF_TERM column_term = make_adbc_column(env, enif_make_copy(env, plan.name), enif_make_copy(env, plan.raw_type), nullable, enif_make_copy(env, plan.metadata), data);
+            columns = enif_make_list_cell(env, column_term, columns);
+            column++;
+        } else if (as_columns && state->vector_columns && plan.list_size > 0) {
+            ERL_NIF_TERM data;
+            void * buffer_owner = state->zero_copy_binaries ? (void *)batch : nullptr;
+            if (arrow_fixed_size_list_to_binaries_nif_term(env, column_values, plan.list_size, plan.list_width, buffer_owner, data, error) == 1) {
+                return error;
+            }
+            bool nullable = plan.nullable || (column_values->null_count != 0);
+            ERL_NIF_TERM column_term = make_adbc_column(env, enif_make_copy(env, plan.name), enif_make_copy(env, plan.list_type), nullable, enif_make_copy(env, plan.metadata), data);
+            columns = enif_make_list_cell(env, column_term, columns);
+            column++;
+        } else if (as_columns && state->dictionary_columns && column_schema->dictionary != nullptr) {
+            ArrowColumnContext context{kAtomNil, kAtomNil, state->zero_copy_binaries ? (void *)batch : nullptr};
+            ERL_NIF_TERM data, column_type;
+            if (arrow_dictionary_to_native_nif_term(env, column_schema, column_values, data, column_type, error, &context) == 1) {
+                return error;
+            }
+            bool nullable = plan.nullable || (column_values->null_count != 0);
+            ERL_NIF_TERM column_term = make_adbc_column(env, enif_make_copy(env, plan.name), column_type, nullable, enif_make_copy(env, plan.metadata), data);
+            columns = enif_make_list_cell(env, column_term, columns);
+            column++;
+        } else if (as_columns && state->numeric_columns && plan.numeric) {
+            auto &numeric_plan = state->columns[column];
+            bool large = column_schema->format[0] == 'U';
+            if (numeric_plan.numeric_scale < 0) {
+                numeric_plan.numeric_scale = large ? numeric_strings_scale<int64_t>(column_values) : numeric_strings_scale<int32_t>(column_values);
+            }
+            int32_t scale = numeric_plan.numeric_scale;
+            ERL_NIF_TERM data = large ? numeric_strings_to_decimals<int64_t>(env, column_values, scale) : numeric_strings_to_decimals<int32_t>(env, column_values, scale);
+            ERL_NIF_TERM column_type = enif_make_tuple4(env, kAtomDecimal, enif_make_int(env, 128), enif_make_int(env, kDecimal128MaxPrecision), enif_make_int(env, scale));
+            bool nullable = plan.nullable || (column_values->null_count != 0);
+            ERL_NIF_TERM column_term = make_adbc_column(env, enif_make_copy(env, plan.name), column_type, nullable, enif_make_copy(env, plan.metadata), data);
+            columns = enif_make_list_cell(env, column_term, columns);
+            column++;
+        } else if (state->intern_columns && plan.intern) {
+            ArrowColumnContext context{kAtomNil, kAtomNil, state->zero_copy_binaries ? (void *)batch : nullptr};
+            bool large = column_schema->format[0] == 'U' || column_schema->format[0] == 'Z';
+            bool interned = true;
+            ERL_NIF_TERM data = large ? interned_strings_to_nif_term<int64_t>(env, column_values, state->intern_atoms, &context, interned) : interned_strings_to_nif_term<int32_t>(env, column_values, state->intern_atoms, &context, interned);
+            if (!interned) {
+                state->columns[column].intern = false;
+            }
+            ERL_NIF_TERM column_type;
+            switch (column_schema->format[0]) {
+                case 'u': column_type = kAdbcColumnTypeString; break;
+                case 'U': column_type = kAdbcColumnTypeLargeString; break;
+                case 'z': column_type = kAdbcColumnTypeBinary; break;
+                default: column_type = kAdbcColumnTypeLargeBinary; break;
+            }
+            bool nullable = plan.nullable || (column_values->null_count != 0);
+            ERL_NIF_TERM column_term = make_adbc_column(env, enif_make_copy(env, plan.name), column_type, nullable, enif_make_copy(env, plan.metadata), data);
+            columns = enif_make_list_cell(env, column_term, columns);
+            column++;
+        } else if (as_columns && state->lazy_columns && plan.sliceable && column_schema->dictionary == nullptr && !(state->datetime_columns && plan.timezone)) {
+            ERL_NIF_TERM column_term;
+            if (make_lazy_adbc_column(env, batch, column_schema, column_values, plan, column_term, error) == 1) {
+                return error;
+            }
+            columns = enif_make_list_cell(env, column_term, columns);
+            column++;
+        } else {
+            int64_t count = plan.sliceable ? std::min(kArrowArrayStreamNextChunkRows, column_values->length - offset) : -1;
+
+            ArrowColumnContext context{
+                enif_make_copy(env, plan.name),
+                enif_make_copy(env, plan.metadata),
+                state->zero_copy_binaries ? (void *)batch : nullptr,
+                state->datetime_columns ? plan.timezone.get() : nullptr
+            };
+            std::vector<ERL_NIF_TERM> out_terms;
+            ERL_NIF_TERM column_type;
+            ERL_NIF_TERM column_metadata;
+            if (arrow_array_to_nif_term(env, column_schema, column_values, offset, count, 1, out_terms, column_type, column_metadata, error, nullptr, &context) == 1) {
+                return error;
+            }
+
+            ERL_NIF_TERM data = kAtomNil;
+            if (out_terms.size() == 2) {
+                chunks = enif_make_list_cell(env, out_terms[1], chunks);
+                offset += (count == -1) ? column_values->length : count;
+                if (offset >= column_values->length) {
+                    data = concat_reversed_lists(env, chunks);
+                }
+            } else {
+                offset = column_values->length;
+            }
+
+            if (offset >= column_values->length) {
+                ERL_NIF_TERM column_term = out_terms[0];
+                if (out_terms.size() == 2) {
+                    bool nullable = plan.nullable || (column_values->null_count > 0);
+                    column_term = make_adbc_column(env, out_terms[0], column_type, nullable, column_metadata, data);
+                }
+                columns = enif_make_list_cell(env, column_term, columns);
+                chunks = enif_make_list(env, 0);
+                offset = 0;
+                column++;
+            }
+        }
+
+        if (can_yield && column < values->n_children) {
+            ErlNifTime now = enif_monotonic_time(ERL_NIF_USEC);
+            // a timeslice is 1ms, so 10us is 1 percent of it
+            int percent = (int)std::max<ErlNifTime>(1, std::min<ErlNifTime>(100, (now - start) / 10));
+            start = now;
+            if (enif_consume_timeslice(env, percent)) {
+                ERL_NIF_TERM args[] = {
+                    argv[0],
+                    argv[1],
+                    enif_make_int64(env, column),
+                    enif_make_int64(env, offset),
+                    columns,
+                    chunks
+                };
+                return enif_schedule_nif(env, "adbc_arrow_array_stream_next", 0, adbc_arrow_array_stream_next_batch, 6, args);
+            }
+        }
+    }
+
+    ERL_NIF_TERM ret{};
+    enif_make_reverse_list(env, columns, &ret);
+    if (state->output != ArrowStreamOutput::kColumns && adbc_columns_to_rows(env, ret, state->output, ret, error) == 1) {
+        return error;
+    }
+    // the batch may be large, release it now instead of waiting for the GC,
+    // unless binaries or lazy columns still reference its buffers
+    if (!state->zero_copy_binaries && !state->lazy_columns) {
+        release_retained_batch(batch);
+    }
+    return enif_make_tuple3(env, erlang::nif::ok(env), ret, enif_make_int64(env, 1));
+}
+
+// The nulls of `array`, counted from its validity bitmap when the driver
+// did not count them.
+static int64_t arrow_array_null_count(const struct ArrowSchema * schema, const struct ArrowArray * array) {
+    if (schema->format != nullptr && strcmp(schema->format, "n") == 0) {
+        return array->length;
+    }
+    if (array->null_count >= 0) {
+        return array->null_count;
+    }
+    if (array->n_buffers == 0 || array->buffers == nullptr || array->buffers[0] == nullptr) {
+        return 0;
+    }
+    auto validity = (const uint8_t *)array->buffers[0];
+    return array->length - ArrowBitCountSet(validity, array->offset, array->length);
+}
+
+// Adds a batch read in `fetch_time` nanoseconds to the stats of `state`,
+// when collected. `batch` is released at the end of the stream.
+static void arrow_array_stream_track_fetch(ArrowArrayStreamState * state, const struct ArrowArray * batch, int64_t fetch_time) {
+    if (!state->collect_stats) return;
+    state->fetch_time += fetch_time;
+    if (batch->release == nullptr) return;
+
+    state->batch_fetch_time = fetch_time;
+    state->batch_rows = batch->length;
+    state->batch_bytes = 0;
+    state->batch_null_counts.clear();
+    if (state->schema.release != nullptr) {
+        state->batch_bytes = adbc_memory_array_bytes(&state->schema, batch);
+        if (batch->n_children == state->schema.n_children) {
+            for (int64_t i = 0; i < batch->n_children; i++) {
+                state->batch_null_counts.push_back(arrow_array_null_count(state->schema.children[i], batch->children[i]));
+            }
+        }
+    }
+    state->fetched_rows += state->batch_rows;
+    state->fetched_bytes += state->batch_bytes;
+}
+
+// Adds `batch` to what was read from the stream, measured from its buffers
+// before any term is built.
+//
+// Returns whether a limit of the stream is now exceeded, with `error` set.
+static bool arrow_array_stream_exceeds_limits(ErlNifEnv *env, ArrowArrayStreamState * state, const struct ArrowArray * batch, ERL_NIF_TERM &error) {
+    if (state->max_result_bytes < 0 && state->max_rows < 0) {
+        return false;
+    }
+
+    if (state->max_result_bytes >= 0) {
+        state->result_bytes += adbc_memory_array_bytes(&state->schema, batch);
+    }
+    state->result_rows += batch->length;
+
+    char message[128];
+    if (state->max_rows >= 0 && state->result_rows > state->max_rows) {
+        snprintf(message, sizeof(message), "the result exceeds :max_rows of %lld", (long long)state->max_rows);
+    } else if (state->max_result_bytes >= 0 && state->result_bytes > state->max_result_bytes) {
+        snprintf(message, sizeof(message), "the result exceeds :max_result_bytes of %lld", (long long)state->max_result_bytes);
+    } else {
+        return false;
+    }
+
+    // 54000: program limit exceeded
+    error = erlang::nif::error(env, enif_make_tuple4(env,
+        kAtomAdbcError,
+        erlang::nif::make_binary(env, message),
+        enif_make_int(env, 0),
+        erlang::nif::make_binary(env, "54000")
+    ));
+    return true;
+}
+
+// Cancels the statement of the stream, if any, and releases the stream.
+static void arrow_array_stream_abort(ErlNifEnv *env, NifRes<struct ArrowArrayStream> * res, ArrowArrayStreamState * state) {
+    if (state->statement != nullptr) {
+        struct AdbcError adbc_error{};
+        AdbcStatementCancel(&state->statement->val, &adbc_error);
+        if (adbc_error.release != nullptr) adbc_error.release(&adbc_error);
+    }
+    release_owned_arrow_array_stream(env, res, false);
+}
+
+// Converts a whole batch within `env`, as `adbc_arrow_array_stream_next`
+// does on dirty schedulers.
+static bool arrow_array_stream_convert_batch(ErlNifEnv *env, ArrowArrayStreamState * state, struct ArrowArray * batch, ERL_NIF_TERM &out) {
+    std::vector<ERL_NIF_TERM> out_terms;
+    ERL_NIF_TERM out_type, out_metadata, error;
+    if (arrow_batch_has_flat_rows(state, batch)) {
+        if (arrow_batch_to_flat_rows(env, state, batch, 0, batch->length, out, error) == 1) {
+            out = error;
+            return false;
+        }
+        return true;
+    }
+    if (arrow_array_to_nif_term(env, &state->schema, batch, 0, out_terms, out_type, out_metadata, error) == 1) {
+        out = error;
+        return false;
+    }
+
+    if (out_terms.size() != 1) {
+        out = enif_make_tuple2(env, out_terms[0], out_terms[1]);
+    } else if (state->output != ArrowStreamOutput::kColumns) {
+        if (adbc_columns_to_rows(env, out_terms[0], state->output, out, error) == 1) {
+            out = error;
+            return false;
+        }
+    } else {
+        out = out_terms[0];
+    }
+    return true;
+}
+
+// Batches of fewer values than this are converted by a single thread with
+// `:parallel_columns`, as their conversion takes less time than copying
+// their terms across environments.
+constexpr int64_t kParallelColumnsMinValues = 1 << 16;
+
+// Whether `batch` is worth converting with `arrow_batch_to_columns_parallel`.
+static bool arrow_batch_has_parallel_columns(const struct ArrowSchema * schema, const struct ArrowArray * batch) {
+    bool top_level_struct = schema->format && strcmp(schema->format, "+s") == 0;
+    bool has_validity = batch->n_buffers > 0 && batch->buffers && batch->buffers[0];
+    return top_level_struct && !has_validity && batch->release != nullptr && batch->n_children >= 2 &&
+        batch->n_children == schema->n_children && batch->children != nullptr && schema->children != nullptr &&
+        batch->length * batch->n_children >= kParallelColumnsMinValues;
+}
+
+// Converts the top-level columns of `batch` to a list of `Adbc.Column` on
+// the worker pool, a range of columns per worker, the first range being
+// converted by the calling thread itself. Each range is built in a process
+// independent environment of its own, whose terms are then copied into
+// `env`.
+//
+// Waits for the workers, so it must only be called on dirty schedulers,
+// and never from a job of the worker pool itself.
+static int arrow_batch_to_columns_parallel(ErlNifEnv *env, struct ArrowSchema * schema, struct ArrowArray * batch, ERL_NIF_TERM &out, ERL_NIF_TERM &error) {
+    struct ColumnsJob {
+        ErlNifEnv * env = nullptr;
+        int64_t first = 0;
+        int64_t count = 0;
+        std::vector<ERL_NIF_TERM> columns;
+        ERL_NIF_TERM error{};
+        bool failed = false;
+    };
+
+    WorkerPool &pool = get_worker_pool();
+    size_t n_jobs = std::min<size_t>(pool.size() + 1, (size_t)batch->n_children);
+    std::vector<ColumnsJob> jobs(n_jobs);
+    for (size_t i = 0; i < n_jobs; i++) {
+        jobs[i].env = enif_alloc_env();
+        if (jobs[i].env == nullptr) {
+            for (size_t j = 0; j < i; j++) enif_free_env(jobs[j].env);
+            error = erlang::nif::error(env, "out of memory");
+            return 1;
+        }
+        jobs[i].first = batch->n_children * (int64_t)i / (int64_t)n_jobs;
+        jobs[i].count = batch->n_children * (int64_t)(i + 1) / (int64_t)n_jobs - jobs[i].first;
+    }
+
+    auto convert = [schema, batch](ColumnsJob &job) {
+        if (get_arrow_array_children_as_list(job.env, schema, batch, job.first, job.count, 0, job.columns, job.error) == 1) {
+            job.failed = true;
+        }
+    };
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    size_t pending = n_jobs - 1;
+    for (size_t i = 1; i < n_jobs; i++) {
+        ColumnsJob &job = jobs[i];
+        pool.submit([&job, &mutex, &cond, &pending, &convert]() {
+            convert(job);
+            std::lock_guard<std::mutex> lock(mutex);
+            pending--;
+            cond.notify_all();
+        });
+    }
+    convert(jobs[0]);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&pending]() { return pending == 0; });
+    }
+
+    int ret = 0;
+    std::vector<ERL_NIF_TERM> columns;
+    columns.reserve((size_t)batch->n_children);
+    for (auto &job : jobs) {
+        if (ret == 0 && job.failed) {
+            error = enif_make_copy(env, job.error);
+            ret = 1;
+        }
+        for (size_t i = 0; ret == 0 && i < job.columns.size(); i++) {
+            columns.push_back(enif_make_copy(env, job.columns[i]));
+        }
+        enif_free_env(job.env);
+    }
+    if (ret == 0) {
+        out = enif_make_list_from_array(env, columns.data(), (unsigned)columns.size());
+    }
+    return ret;
+}
+
+// `adbc_arrow_array_stream_next` with `ArrowArrayStreamState::decoder`:
+// reads batches until the decoder has a full window of them, then returns
+// the oldest once converted. An error of the stream is returned after the
+// batches read before it.
+static ERL_NIF_TERM arrow_array_stream_next_parallel(ErlNifEnv *env, NifRes<struct ArrowArrayStream> * res, ArrowArrayStreamState * state) {
+    ERL_NIF_TERM error{};
+    ParallelDecoder * decoder = state->decoder.get();
+
+    while (!state->decoder_done && !decoder->full()) {
+        struct ArrowArray out{};
+        int64_t started = enif_monotonic_time(ERL_NIF_NSEC);
+        int code = res->val.get_next(&res->val, &out);
+        arrow_array_stream_track_fetch(state, &out, enif_monotonic_time(ERL_NIF_NSEC) - started);
+        if (code != 0) {
+            const char * reason = res->val.get_last_error(&res->val);
+            state->decoder_error = reason ? reason : "unknown error";
+            state->decoder_done = true;
+        } else if (out.release == nullptr) {
+            state->decoder_done = true;
+        } else if (arrow_array_stream_exceeds_limits(env, state, &out, error)) {
+            out.release(&out);
+            arrow_array_stream_abort(env, res, state);
+            return error;
+        } else {
+            // the stream, and so its state and decoder, must outlive the job
+            enif_keep_resource(res);
+            auto convert = [state](ErlNifEnv *job_env, struct ArrowArray *batch, ERL_NIF_TERM &term) {
+                return arrow_array_stream_convert_batch(job_env, state, batch, term);
+            };
+            if (!decoder->submit(&out, convert, [res]() { enif_release_resource(res); })) {
+                enif_release_resource(res);
+                out.release(&out);
+                return erlang::nif::error(env, "out of memory");
+            }
+        }
+    }
+
+    if (decoder->empty()) {
+        if (!state->decoder_error.empty()) {
+            return erlang::nif::error(env, state->decoder_error.c_str());
+        }
+        return kAtomEndOfSeries;
+    }
+
+    ERL_NIF_TERM ret{};
+    if (!decoder->pop(env, ret)) {
+        return ret;
+    }
+    return enif_make_tuple3(env, erlang::nif::ok(env), ret, enif_make_int64(env, 1));
+}
+
+static ERL_NIF_TERM adbc_arrow_array_stream_next(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    AdbcCallScope scope(adbc_call_stats.stream_next);
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM ret{};
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    if (res->val.get_next == nullptr) {
+        return enif_make_badarg(env);
+    }
+    if (res->val.release == nullptr) {
+        return erlang::nif::error(env, "ArrowArrayStream has already been released");
+    }
+
+    // waiting for the decoder would block a normal scheduler
+    auto current = (ArrowArrayStreamState *)res->private_data;
+    if (current != nullptr && current->decoder && enif_thread_type() != ERL_NIF_THR_NORMAL_SCHEDULER) {
+        return arrow_array_stream_next_parallel(env, res, current);
+    }
+
+    struct ArrowArray out{};
+    int64_t started = enif_monotonic_time(ERL_NIF_NSEC);
+    int code = res->val.get_next(&res->val, &out);
+    int64_t fetch_time = enif_monotonic_time(ERL_NIF_NSEC) - started;
+    if (code != 0) {
+        const char * reason = res->val.get_last_error(&res->val);
+        return erlang::nif::error(env, reason ? reason : "unknown error");
+    }
+
+    auto state = get_arrow_array_stream_state(env, res, error);
+    if (state == nullptr) {
+        if (out.release) out.release(&out);
+        return error;
+    }
+    auto schema = &state->schema;
+    arrow_array_stream_track_fetch(state, &out, fetch_time);
+
+    if (out.release != nullptr && arrow_array_stream_exceeds_limits(env, state, &out, error)) {
+        out.release(&out);
+        arrow_array_stream_abort(env, res, state);
+        return error;
+    }
+
+    if (arrow_batch_has_flat_rows(state, &out)) {
+        using array_type = NifRes<struct ArrowArray>;
+        auto batch = array_type::allocate_resource(env, error);
+        if (batch == nullptr) {
+            out.release(&out);
+            return error;
+        }
+        batch->val = out;
+        track_retained_batch(batch, schema);
+        ERL_NIF_TERM batch_term = batch->make_resource(env);
+        enif_release_resource(batch);
+
+        ERL_NIF_TERM args[] = {argv[0], batch_term, enif_make_int64(env, 0), enif_make_list(env, 0)};
+        return adbc_arrow_array_stream_next_flat_rows(env, 4, args);
+    }
+
+    // On normal schedulers, record batches are converted in chunks that
+    // yield in between, so a large batch does not exceed the NIF time budget.
+    // Dirty schedulers have no such budget and convert the batch at once,
+    // unless the batch must be kept in a resource for zero-copy binaries or
+    // lazy columns, or its columns are returned as raw buffers,
+    // dictionaries or decimals parsed from strings.
+    bool top_level_struct = schema->format && strcmp(schema->format, "+s") == 0;
+    bool has_validity = out.n_buffers > 0 && out.buffers && out.buffers[0];
+    bool use_batch = enif_thread_type() == ERL_NIF_THR_NORMAL_SCHEDULER || state->zero_copy_binaries || state->raw_columns || state->vector_columns || state->lazy_columns || state->dictionary_columns || state->numeric_columns || state->intern_columns || state->datetime_columns;
+    if (use_batch && out.release != nullptr &&
+        top_level_struct && !has_validity && out.n_children == schema->n_children &&
+        (out.n_children == 0 || (out.children != nullptr && schema->children != nullptr))) {
+        using array_type = NifRes<struct ArrowArray>;
+        auto batch = array_type::allocate_resource(env, error);
+        if (batch == nullptr) {
+            out.release(&out);
+            return error;
+        }
+        // move the batch into the resource, which now owns it
+        batch->val = out;
+        track_retained_batch(batch, schema);
+        ERL_NIF_TERM batch_term = batch->make_resource(env);
+        enif_release_resource(batch);
+
+        ERL_NIF_TERM args[] = {
+            argv[0],
+            batch_term,
+            enif_make_int64(env, 0),
+            enif_make_int64(env, 0),
+            enif_make_list(env, 0),
+            enif_make_list(env, 0)
+        };
+        return adbc_arrow_array_stream_next_batch(env, 6, args);
+    }
+
+    if (state->parallel_columns && arrow_batch_has_parallel_columns(schema, &out)) {
+        ret = kAtomNil;
+        int failed = arrow_batch_to_columns_parallel(env, schema, &out, ret, error);
+        if (failed == 0 && state->output != ArrowStreamOutput::kColumns) {
+            failed = adbc_columns_to_rows(env, ret, state->output, ret, error);
+        }
+        out.release(&out);
+        if (failed == 1) {
+            return error;
+        }
+        return enif_make_tuple3(env, erlang::nif::ok(env), ret, enif_make_int64(env, 1));
+    }
+
+    std::vector<ERL_NIF_TERM> out_terms;
+
+    bool end_of_series = false;
+    ERL_NIF_TERM out_type;
+    ERL_NIF_TERM out_metadata;
+    if (arrow_array_to_nif_term(env, schema, &out, 0, out_terms, out_type, out_metadata, error, &end_of_series) == 1) {
+        if (out.release) out.release(&out);
+        return error;
+    }
+
+    if (out_terms.size() == 1) {
+        ret = out_terms[0];
+        if (end_of_series) {
+            if (out.release) {
+                out.release(&out);
+            }
+            return kAtomEndOfSeries;
+        }
+        if (state->output != ArrowStreamOutput::kColumns && adbc_columns_to_rows(env, ret, state->output, ret, error) == 1) {
+            if (out.release) out.release(&out);
+            return error;
+        }
+    } else {
+        ret = enif_make_tuple2(env, out_terms[0], out_terms[1]);
+    }
+
+    if (out.release) {
+        out.release(&out);
+        return enif_make_tuple3(env, erlang::nif::ok(env), ret, enif_make_int64(env, 1));
+    } else {
+        return enif_make_tuple3(env, erlang::nif::ok(env), ret, enif_make_int64(env, 0));
+    }
+}
+
+// Reads up to `capacity` batches ahead, and up to `max_bytes` of them
+// unless 0, see `arrow_array_stream_prefetch`.
+static ERL_NIF_TERM adbc_arrow_array_stream_prefetch(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    uint64_t capacity = 0;
+    int64_t max_bytes = 0;
+    if (!erlang::nif::get(env, argv[1], &capacity) || capacity == 0 ||
+        !erlang::nif::get(env, argv[2], &max_bytes) || max_bytes < 0) {
+        return enif_make_badarg(env);
+    }
+
+    std::string reason;
+    if (arrow_array_stream_prefetch(&res->val, (size_t)capacity, max_bytes, reason) != 0) {
+        return erlang::nif::error(env, reason.c_str());
+    }
+
+    return erlang::nif::ok(env);
+}
+
+// Sets the number of batches read ahead by a stream given to
+// `adbc_arrow_array_stream_prefetch`, see `arrow_array_stream_set_prefetch`.
+static ERL_NIF_TERM adbc_arrow_array_stream_set_prefetch(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    uint64_t capacity = 0;
+    if (!erlang::nif::get(env, argv[1], &capacity) || capacity == 0) {
+        return enif_make_badarg(env);
+    }
+
+    std::string reason;
+    if (arrow_array_stream_set_prefetch(&res->val, (size_t)capacity, reason) != 0) {
+        return erlang::nif::error(env, reason.c_str());
+    }
+
+    return erlang::nif::ok(env);
+}
+
+// Coalesces the following batches toward taking the given nanoseconds each
+// to convert, or else up to the given rows or bytes, each ignored when 0,
+// see `arrow_array_stream_coalesce`.
+static ERL_NIF_TERM adbc_arrow_array_stream_coalesce(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    int64_t target_time = 0, target_rows = 0, target_bytes = 0;
+    if (!erlang::nif::get(env, argv[1], &target_time) || target_time < 0 ||
+        !erlang::nif::get(env, argv[2], &target_rows) || target_rows < 0 ||
+        !erlang::nif::get(env, argv[3], &target_bytes) || target_bytes < 0 ||
+        (target_time == 0 && target_rows == 0 && target_bytes == 0)) {
+        return enif_make_badarg(env);
+    }
+
+    std::string reason;
+    if (arrow_array_stream_coalesce(&res->val, target_time, target_rows, target_bytes, reason) != 0) {
+        return erlang::nif::error(env, reason.c_str());
+    }
+
+    return erlang::nif::ok(env);
+}
+
+// Caches the batches of the stream under the key binary for the given
+// milliseconds once it is fully read, along with the given rows affected.
+static ERL_NIF_TERM adbc_arrow_array_stream_cache(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    ErlNifBinary key;
+    int64_t ttl = 0;
+    int64_t rows_affected = 0;
+    if (!enif_inspect_binary(env, argv[1], &key) ||
+        !erlang::nif::get(env, argv[2], &ttl) || ttl <= 0 ||
+        !erlang::nif::get(env, argv[3], &rows_affected)) {
+        return enif_make_badarg(env);
+    }
+
+    std::string reason;
+    std::string cache_key((const char *)key.data, key.size);
+    if (arrow_array_stream_cache(&res->val, std::move(cache_key), ttl, rows_affected, reason) != 0) {
+        return erlang::nif::error(env, reason.c_str());
+    }
+
+    return erlang::nif::ok(env);
+}
+
+// Returns `{:ok, stream, rows_affected}` over the cached result of the key
+// binary, or `:miss`.
+static ERL_NIF_TERM adbc_result_cache_fetch(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    ErlNifBinary key;
+    if (!enif_inspect_binary(env, argv[0], &key)) {
+        return enif_make_badarg(env);
+    }
+
+    std::string cache_key((const char *)key.data, key.size);
+    auto result = adbc_result_cache.get(cache_key, enif_monotonic_time(ERL_NIF_MSEC));
+    if (result == nullptr) {
+        return erlang::nif::atom(env, "miss");
+    }
+
+    ERL_NIF_TERM error{};
+    auto array_stream = allocate_arrow_array_stream(env, error);
+    if (array_stream == nullptr) {
+        return error;
+    }
+    int64_t rows_affected = result->rows_affected;
+    arrow_array_stream_from_cache(&array_stream->val, std::move(result));
+
+    ERL_NIF_TERM ret = enif_make_tuple3(env,
+        erlang::nif::ok(env),
+        array_stream->make_resource(env),
+        enif_make_int64(env, rows_affected)
+    );
+    enif_release_resource(array_stream);
+    return ret;
+}
+
+static ERL_NIF_TERM adbc_result_cache_clear(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    adbc_result_cache.clear();
+    return erlang::nif::ok(env);
+}
+
+// Evicts the cached results whose key starts with the prefix binary.
+static ERL_NIF_TERM adbc_result_cache_evict(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    ErlNifBinary prefix;
+    if (!enif_inspect_binary(env, argv[0], &prefix)) {
+        return enif_make_badarg(env);
+    }
+
+    adbc_result_cache.erase_prefix(std::string((const char *)prefix.data, prefix.size));
+    return erlang::nif::ok(env);
+}
+
+// Reads all the batches of a stream of `AdbcConnectionGetStatistics` and
+// returns `{:ok, statistics}`, as flattened by `arrow_statistics_to_terms`.
+static ERL_NIF_TERM adbc_arrow_array_stream_statistics(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    if (res->val.release == nullptr) {
+        return erlang::nif::error(env, "ArrowArrayStream has already been released");
+    }
+    auto state = get_arrow_array_stream_state(env, res, error);
+    if (state == nullptr) {
+        return error;
+    }
+
+    std::vector<ERL_NIF_TERM> statistics;
+    std::string reason;
+    while (true) {
+        struct ArrowArray out{};
+        if (res->val.get_next(&res->val, &out) != 0) {
+            const char * last_error = res->val.get_last_error(&res->val);
+            return erlang::nif::error(env, last_error ? last_error : "unknown error");
+        }
+        if (out.release == nullptr) break;
+
+        int code = arrow_statistics_to_terms(env, &state->schema, &out, statistics, reason);
+        out.release(&out);
+        if (code != 0) {
+            return erlang::nif::error(env, reason.c_str());
+        }
+    }
+
+    return erlang::nif::ok(env, enif_make_list_from_array(env, statistics.data(), (unsigned)statistics.size()));
+}
+
+// Wraps `result` in a new `Adbc.SharedResult` handle and returns
+// `{:ok, handle, rows, column_names}`.
+static ERL_NIF_TERM make_shared_result(ErlNifEnv *env, std::shared_ptr<CachedResult> result, int64_t rows) {
+    using handle_type = NifRes<SharedResultHandle>;
+    ERL_NIF_TERM error{};
+
+    auto handle = handle_type::allocate_resource(env, error);
+    if (handle == nullptr) {
+        return error;
+    }
+    adbc_memory_stats.shared_results++;
+    adbc_memory_stats.shared_result_bytes += result->bytes;
+    handle->val.result = new std::shared_ptr<CachedResult>(std::move(result));
+    handle->val.rows = rows;
+    std::vector<ERL_NIF_TERM> names;
+    const struct ArrowSchema &schema = (*handle->val.result)->schema;
+    for (int64_t i = 0; i < schema.n_children; i++) {
+        names.push_back(erlang::nif::make_binary(env, schema.children[i]->name ? schema.children[i]->name : ""));
+    }
+    ERL_NIF_TERM handle_term = handle->make_resource(env);
+    enif_release_resource(handle);
+    return enif_make_tuple4(env,
+        erlang::nif::ok(env),
+        handle_term,
+        enif_make_int64(env, rows),
+        enif_make_list_from_array(env, names.data(), (unsigned)names.size())
+    );
+}
+
+// Reads all the batches of the stream into a shared result and returns
+// `{:ok, handle, rows, column_names}`, enforcing the limits of the stream
+// as it goes. With `spill`, the batches are written to its file as they
+// are read and the result is made of arrays over the mapped file.
+static ERL_NIF_TERM share_arrow_array_stream(ErlNifEnv *env, ERL_NIF_TERM stream_term, AdbcSpillWriter * spill) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, stream_term, error)) == nullptr) {
+        return error;
+    }
+    if (res->val.release == nullptr) {
+        return erlang::nif::error(env, "ArrowArrayStream has already been released");
+    }
+    auto state = get_arrow_array_stream_state(env, res, error);
+    if (state == nullptr) {
+        return error;
+    }
+
+    auto result = std::make_shared<CachedResult>();
+    if (ArrowSchemaDeepCopy(&state->schema, &result->schema) != NANOARROW_OK) {
+        return erlang::nif::error(env, "cannot copy the schema of the stream");
+    }
+    int64_t rows = 0;
+    std::vector<MappedArrayNode> spilled;
+    while (true) {
+        struct ArrowArray out{};
+        int64_t started = enif_monotonic_time(ERL_NIF_NSEC);
+        int code = res->val.get_next(&res->val, &out);
+        int64_t fetch_time = enif_monotonic_time(ERL_NIF_NSEC) - started;
+        if (code != 0) {
+            const char * reason = res->val.get_last_error(&res->val);
+            return erlang::nif::error(env, reason ? reason : "unknown error");
+        }
+        arrow_array_stream_track_fetch(state, &out, fetch_time);
+        if (out.release == nullptr) break;
+
+        if (arrow_array_stream_exceeds_limits(env, state, &out, error)) {
+            out.release(&out);
+            arrow_array_stream_abort(env, res, state);
+            return error;
+        }
+        rows += out.length;
+        if (spill != nullptr) {
+            std::string reason;
+            spilled.emplace_back();
+            int code = spill->append(&result->schema, &out, spilled.back(), reason);
+            out.release(&out);
+            if (code != 0) {
+                arrow_array_stream_abort(env, res, state);
+                return erlang::nif::error(env, reason.c_str());
+            }
+            continue;
+        }
+        auto batch = arrow_array_make_shared(&out);
+        result->bytes += adbc_memory_array_bytes(&result->schema, batch.get());
+        result->batches.push_back(std::move(batch));
+    }
+
+    if (spill != nullptr) {
+        std::shared_ptr<MappedFile> mapping;
+        std::string reason;
+        if (spill->finish(mapping, reason) != 0) {
+            return erlang::nif::error(env, reason.c_str());
+        }
+        for (const MappedArrayNode &node : spilled) {
+            struct ArrowArray out{};
+            arrow_array_from_mapped_file(mapping, node, &out);
+            result->batches.push_back(arrow_array_make_shared(&out));
+        }
+    }
+
+    return make_shared_result(env, std::move(result), rows);
+}
+
+static ERL_NIF_TERM adbc_arrow_array_stream_share(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    return share_arrow_array_stream(env, argv[0], nullptr);
+}
+
+// Same as `adbc_arrow_array_stream_share/1`, spilling the batches to a
+// temporary file in the directory `dir`.
+static ERL_NIF_TERM adbc_arrow_array_stream_spill(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    std::string dir;
+    if (!erlang::nif::get(env, argv[1], dir)) {
+        return enif_make_badarg(env);
+    }
+    AdbcSpillWriter spill;
+    std::string reason;
+    if (spill.open(dir, reason) != 0) {
+        return erlang::nif::error(env, reason.c_str());
+    }
+    return share_arrow_array_stream(env, argv[0], &spill);
+}
+
+// Reads all batches of the stream `argv[0]` and stacks the numeric columns
+// named `argv[1]`, or all columns when nil, into a matrix binary of the
+// type `argv[2]`, such as `{:f, 32}`. Cells are laid out by row when
+// `argv[3]` is `:row_major` and by column when `:column_major`. Nulls are
+// NaN when `argv[4]` is `:nan`, and flagged in a mask binary of one byte
+// per cell when `:mask`.
+//
+// Returns `{:ok, data, rows, names, mask}`, with `mask` nil without one.
+static ERL_NIF_TERM adbc_arrow_array_stream_to_matrix(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    ArrowMatrixType type;
+    std::string kind, layout, nulls;
+    const ERL_NIF_TERM * type_tuple = nullptr;
+    int type_arity = 0;
+    if (!enif_get_tuple(env, argv[2], &type_arity, &type_tuple) || type_arity != 2 ||
+        !erlang::nif::get_atom(env, type_tuple[0], kind) || kind.size() != 1 ||
+        !enif_get_int(env, type_tuple[1], &type.bits) ||
+        !erlang::nif::get_atom(env, argv[3], layout) || (layout != "row_major" && layout != "column_major") ||
+        !erlang::nif::get_atom(env, argv[4], nulls) || (nulls != "nan" && nulls != "mask") ||
+        !(enif_is_identical(argv[1], kAtomNil) || enif_is_list(env, argv[1]))) {
+        return enif_make_badarg(env);
+    }
+    type.kind = kind[0];
+    if (!type.valid()) {
+        char message[128];
+        enif_snprintf(message, sizeof(message), "unsupported matrix type: %T", argv[2]);
+        return erlang::nif::error(env, message);
+    }
+
+    if (res->val.release == nullptr) {
+        return erlang::nif::error(env, "ArrowArrayStream has already been released");
+    }
+    auto state = get_arrow_array_stream_state(env, res, error);
+    if (state == nullptr) {
+        return error;
+    }
+
+    // the columns to stack, in order
+    const struct ArrowSchema &schema = state->schema;
+    std::vector<int64_t> columns;
+    if (enif_is_identical(argv[1], kAtomNil)) {
+        for (int64_t i = 0; i < schema.n_children; i++) columns.push_back(i);
+    } else {
+        ERL_NIF_TERM head, tail = argv[1];
+        while (enif_get_list_cell(env, tail, &head, &tail)) {
+            std::string name;
+            if (!erlang::nif::get(env, head, name)) {
+                return enif_make_badarg(env);
+            }
+            int64_t found = -1;
+            for (int64_t i = 0; i < schema.n_children && found == -1; i++) {
+                if (schema.children[i]->name != nullptr && name == schema.children[i]->name) found = i;
+            }
+            if (found == -1) {
+                return erlang::nif::error(env, ("unknown column `" + name + "`").c_str());
+            }
+            columns.push_back(found);
+        }
+    }
+    std::string reason;
+    for (int64_t column : columns) {
+        if (arrow_matrix_check_column(schema.children[column], type, reason) != 0) {
+            return erlang::nif::error(env, reason.c_str());
+        }
+    }
+
+    // the number of rows is only known once all batches are read
+    std::vector<std::shared_ptr<struct ArrowArray>> batches;
+    int64_t rows = 0;
+    while (true) {
+        struct ArrowArray out{};
+        int64_t started = enif_monotonic_time(ERL_NIF_NSEC);
+        int code = res->val.get_next(&res->val, &out);
+        int64_t fetch_time = enif_monotonic_time(ERL_NIF_NSEC) - started;
+        if (code != 0) {
+            const char * last_error = res->val.get_last_error(&res->val);
+            return erlang::nif::error(env, last_error ? last_error : "unknown error");
+        }
+        arrow_array_stream_track_fetch(state, &out, fetch_time);
+        if (out.release == nullptr) break;
+
+        if (arrow_array_stream_exceeds_limits(env, state, &out, error)) {
+            out.release(&out);
+            arrow_array_stream_abort(env, res, state);
+            return error;
+        }
+        rows += out.length;
+        batches.push_back(arrow_array_make_shared(&out));
+    }
+
+    int64_t n_columns = (int64_t)columns.size();
+    int64_t cells = rows * n_columns;
+    ErlNifBinary data, mask;
+    if (!enif_alloc_binary((size_t)(cells * type.width()), &data)) {
+        return erlang::nif::error(env, "cannot allocate the matrix");
+    }
+    bool has_mask = nulls == "mask";
+    if (has_mask) {
+        if (!enif_alloc_binary((size_t)cells, &mask)) {
+            enif_release_binary(&data);
+            return erlang::nif::error(env, "cannot allocate the mask of the matrix");
+        }
+        memset(mask.data, 0, mask.size);
+    }
+
+    bool column_major = layout == "column_major";
+    int64_t row = 0;
+    for (const auto &batch : batches) {
+        for (int64_t j = 0; j < n_columns; j++) {
+            const struct ArrowSchema * column_schema = schema.children[columns[j]];
+            ArrowMatrixTarget target;
+            target.data = data.data;
+            target.mask = has_mask ? mask.data : nullptr;
+            target.start = column_major ? j * rows + row : row * n_columns + j;
+            target.stride = column_major ? 1 : n_columns;
+            if (arrow_matrix_write_column(column_schema->format, batch.get(), batch->children[columns[j]], type, target, reason) != 0) {
+                enif_release_binary(&data);
+                if (has_mask) enif_release_binary(&mask);
+                return erlang::nif::error(env, reason.c_str());
+            }
+        }
+        row += batch->length;
+    }
+
+    std::vector<ERL_NIF_TERM> names;
+    for (int64_t column : columns) {
+        const char * name = schema.children[column]->name;
+        names.push_back(erlang::nif::make_binary(env, name ? name : ""));
+    }
+    return enif_make_tuple5(env,
+        erlang::nif::ok(env),
+        enif_make_binary(env, &data),
+        enif_make_int64(env, rows),
+        enif_make_list_from_array(env, names.data(), (unsigned)names.size()),
+        has_mask ? enif_make_binary(env, &mask) : kAtomNil
+    );
+}
+
+// Returns `{:ok, stream, skip}` over the batches of a shared result with
+// the rows from `offset` to `offset + length`, and only the columns of the
+// given indices unless `nil`. `skip` is the number of rows of the first
+// batch before `offset`.
+static ERL_NIF_TERM adbc_shared_result_stream(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using handle_type = NifRes<SharedResultHandle>;
+    ERL_NIF_TERM error{};
+
+    handle_type * handle = nullptr;
+    if ((handle = handle_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    const std::shared_ptr<CachedResult> &result = *handle->val.result;
+    std::vector<int64_t> columns;
+    if (!enif_is_identical(argv[1], kAtomNil)) {
+        if (!erlang::nif::get_list(env, argv[1], columns)) {
+            return enif_make_badarg(env);
+        }
+        for (int64_t column : columns) {
+            if (column < 0 || column >= result->schema.n_children) {
+                return enif_make_badarg(env);
+            }
+        }
+    }
+    int64_t offset = 0, length = 0;
+    if (!erlang::nif::get(env, argv[2], &offset) || !erlang::nif::get(env, argv[3], &length) ||
+        offset < 0 || length < 0) {
+        return enif_make_badarg(env);
+    }
+
+    // the batches with rows within the range
+    size_t first = 0, end = 0;
+    int64_t start = 0, skip = 0;
+    for (size_t i = 0; i < result->batches.size(); i++) {
+        int64_t batch_rows = result->batches[i]->length;
+        if (start + batch_rows <= offset) {
+            first = end = i + 1;
+        } else if (start < offset + length) {
+            if (end == first) skip = offset - start;
+            end = i + 1;
+        }
+        start += batch_rows;
+    }
+    if (end == first) {
+        first = end = 0;
+    }
+
+    auto array_stream = allocate_arrow_array_stream(env, error);
+    if (array_stream == nullptr) {
+        return error;
+    }
+    arrow_array_stream_from_cache(&array_stream->val, result, first, end, std::move(columns));
+    ERL_NIF_TERM ret = enif_make_tuple3(env,
+        erlang::nif::ok(env),
+        array_stream->make_resource(env),
+        enif_make_int64(env, skip)
+    );
+    enif_release_resource(array_stream);
+    return ret;
+}
+
+// Parses the comparison `{column, op, value}` of a selection of
+// `adbc_shared_result_select/3`.
+static bool get_shared_result_comparison(ErlNifEnv *env, ERL_NIF_TERM term, int64_t n_columns, int64_t &column, ArrowCompareOp &op, ArrowCompareValue &value) {
+    const ERL_NIF_TERM * tuple = nullptr;
+    int arity = 0;
+    std::string op_name;
+    if (!enif_get_tuple(env, term, &arity, &tuple) || arity != 3 ||
+        !erlang::nif::get(env, tuple[0], &column) || column < 0 || column >= n_columns ||
+        !erlang::nif::get_atom(env, tuple[1], op_name)) {
+        return false;
+    }
+
+    if (op_name == "==") op = ArrowCompareOp::kEq;
+    else if (op_name == "!=") op = ArrowCompareOp::kNe;
+    else if (op_name == "<") op = ArrowCompareOp::kLt;
+    else if (op_name == "<=") op = ArrowCompareOp::kLe;
+    else if (op_name == ">") op = ArrowCompareOp::kGt;
+    else if (op_name == ">=") op = ArrowCompareOp::kGe;
+    else return false;
+
+    ErlNifSInt64 integer = 0;
+    ErlNifBinary bytes;
+    if (enif_get_int64(env, tuple[2], &integer)) {
+        value.kind = ArrowCompareValue::kInteger;
+        value.integer = (int64_t)integer;
+    } else if (enif_get_double(env, tuple[2], &value.number)) {
+        value.kind = ArrowCompareValue::kFloat;
+    } else if (enif_is_identical(tuple[2], kAtomTrue) || enif_is_identical(tuple[2], kAtomFalse)) {
+        value.kind = ArrowCompareValue::kBoolean;
+        value.boolean = enif_is_identical(tuple[2], kAtomTrue);
+    } else if (enif_inspect_binary(env, tuple[2], &bytes)) {
+        value.kind = ArrowCompareValue::kBinary;
+        value.bytes = bytes.data;
+        value.size = bytes.size;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Returns `{:ok, handle, rows, column_names}` of a new shared result with
+// the columns of the given indices of a shared result, or all of them when
+// `nil`, and the rows of the selection `argv[2]`, which is one of:
+//
+//   * `nil` - all the rows
+//   * `{:slice, offset, length}` - the rows from `offset` to `offset + length`
+//   * `{:take, indices}` - the rows at `indices`, in that order
+//   * `{:mask, booleans}` - the rows whose boolean is `true`
+//   * `{:compare, {column, op, value}}` - the rows whose value of the column
+//     of index `column` compares to `value` as `op`, such as `:<`
+//
+// Rows are copied by native kernels over the Arrow buffers, so only the
+// selected ones are converted to terms once read. Batches selected whole
+// are shared with the source rather than copied.
+static ERL_NIF_TERM adbc_shared_result_select(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using handle_type = NifRes<SharedResultHandle>;
+    ERL_NIF_TERM error{};
+
+    handle_type * handle = nullptr;
+    if ((handle = handle_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    const std::shared_ptr<CachedResult> &source = *handle->val.result;
+    std::vector<int64_t> columns;
+    if (enif_is_identical(argv[1], kAtomNil)) {
+        for (int64_t i = 0; i < source->schema.n_children; i++) columns.push_back(i);
+    } else {
+        if (!erlang::nif::get_list(env, argv[1], columns)) {
+            return enif_make_badarg(env);
+        }
+        for (int64_t column : columns) {
+            if (column < 0 || column >= source->schema.n_children) {
+                return enif_make_badarg(env);
+            }
+        }
+    }
+
+    std::string kind = "all";
+    const ERL_NIF_TERM * selection = nullptr;
+    int arity = 0;
+    if (!enif_is_identical(argv[2], kAtomNil) &&
+        (!enif_get_tuple(env, argv[2], &arity, &selection) || arity < 2 ||
+         !erlang::nif::get_atom(env, selection[0], kind))) {
+        return enif_make_badarg(env);
+    }
+
+    auto result = std::make_shared<CachedResult>();
+    if (arrow_schema_select_columns(&source->schema, columns, &result->schema) != NANOARROW_OK) {
+        return erlang::nif::error(env, "cannot copy the schema of the result");
+    }
+    int64_t rows = 0;
+    std::string reason;
+    auto add_batch = [&](struct ArrowArray * out) {
+        rows += out->length;
+        auto batch = arrow_array_make_shared(out);
+        result->bytes += adbc_memory_array_bytes(&result->schema, batch.get());
+        result->batches.push_back(std::move(batch));
+    };
+    // adds the `selected` rows of the source batch `i`, or the batch itself
+    // when they are all of its rows
+    auto add_rows = [&](size_t i, const std::vector<int64_t> &selected) -> bool {
+        const std::shared_ptr<struct ArrowArray> &batch = source->batches[i];
+        struct ArrowArray out{};
+        if (selected.empty()) {
+            return true;
+        } else if ((int64_t)selected.size() == batch->length) {
+            arrow_array_share_columns(batch, columns, &out);
+        } else {
+            std::vector<ArrowRowRef> refs;
+            refs.reserve(selected.size());
+            for (int64_t row : selected) refs.push_back({0, row});
+            if (arrow_batch_take(&source->schema, {batch.get()}, columns, refs, &out, reason) != 0) {
+                return false;
+            }
+        }
+        add_batch(&out);
+        return true;
+    };
+
+    std::vector<int64_t> selected;
+    if (kind == "all" || kind == "slice") {
+        int64_t offset = 0, end = std::numeric_limits<int64_t>::max();
+        if (kind == "slice") {
+            int64_t length = 0;
+            if (arity != 3 || !erlang::nif::get(env, selection[1], &offset) ||
+                !erlang::nif::get(env, selection[2], &length) || offset < 0 || length < 0) {
+                return enif_make_badarg(env);
+            }
+            end = length > end - offset ? end : offset + length;
+        }
+        int64_t start = 0;
+        for (size_t i = 0; i < source->batches.size(); i++) {
+            const struct ArrowArray * batch = source->batches[i].get();
+            int64_t first = std::max(offset, start), last = std::min(end, start + batch->length);
+            selected.clear();
+            if (first == start && last == start + batch->length) {
+                struct ArrowArray out{};
+                arrow_array_share_columns(source->batches[i], columns, &out);
+                add_batch(&out);
+            } else {
+                for (int64_t row = first; row < last; row++) selected.push_back(batch->offset + row - start);
+                if (!add_rows(i, selected)) return erlang::nif::error(env, reason.c_str());
+            }
+            start += batch->length;
+        }
+    } else if (kind == "take" && arity == 2) {
+        std::vector<int64_t> indices;
+        if (!erlang::nif::get_list(env, selection[1], indices)) {
+            return enif_make_badarg(env);
+        }
+        // the first row of each batch, to find the batch of each index
+        std::vector<int64_t> starts;
+        std::vector<const struct ArrowArray *> batches;
+        int64_t total = 0;
+        for (const auto &batch : source->batches) {
+            starts.push_back(total);
+            batches.push_back(batch.get());
+            total += batch->length;
+        }
+        std::vector<ArrowRowRef> refs;
+        refs.reserve(indices.size());
+        for (int64_t index : indices) {
+            if (index < 0 || index >= total) {
+                return erlang::nif::error(env, "row index out of range");
+            }
+            size_t i = (size_t)(std::upper_bound(starts.begin(), starts.end(), index) - starts.begin()) - 1;
+            refs.push_back({(uint32_t)i, batches[i]->offset + index - starts[i]});
+        }
+        if (!refs.empty()) {
+            struct ArrowArray out{};
+            if (arrow_batch_take(&source->schema, batches, columns, refs, &out, reason) != 0) {
+                return erlang::nif::error(env, reason.c_str());
+            }
+            add_batch(&out);
+        }
+    } else if (kind == "mask" && arity == 2) {
+        ERL_NIF_TERM head, tail = selection[1];
+        for (size_t i = 0; i < source->batches.size(); i++) {
+            const struct ArrowArray * batch = source->batches[i].get();
+            selected.clear();
+            for (int64_t row = 0; row < batch->length; row++) {
+                if (!enif_get_list_cell(env, tail, &head, &tail)) {
+                    return erlang::nif::error(env, "the mask has fewer booleans than the result has rows");
+                }
+                if (enif_is_identical(head, kAtomTrue)) selected.push_back(batch->offset + row);
+            }
+            if (!add_rows(i, selected)) return erlang::nif::error(env, reason.c_str());
+        }
+        if (!enif_is_empty_list(env, tail)) {
+            return erlang::nif::error(env, "the mask has more booleans than the result has rows");
+        }
+    } else if (kind == "compare" && arity == 2) {
+        int64_t column = 0;
+        ArrowCompareOp op = ArrowCompareOp::kEq;
+        ArrowCompareValue value{};
+        if (!get_shared_result_comparison(env, selection[1], source->schema.n_children, column, op, value)) {
+            return enif_make_badarg(env);
+        }
+        for (size_t i = 0; i < source->batches.size(); i++) {
+            const struct ArrowArray * batch = source->batches[i].get();
+            selected.clear();
+            if (arrow_array_compare(source->schema.children[column], batch->children[column], batch->offset, batch->length, op, value, selected, reason) != 0 ||
+                !add_rows(i, selected)) {
+                return erlang::nif::error(env, reason.c_str());
+            }
+        }
+    } else {
+        return enif_make_badarg(env);
+    }
+
+    return make_shared_result(env, std::move(result), rows);
+}
+
+// Returns repeated values of the given top-level string and binary columns
+// of the following batches as the same term, for all of them when given
+// `true` instead of a list of column names. With `atoms`, values naming
+// existing atoms are returned as atoms.
+static ERL_NIF_TERM arrow_array_stream_set_intern_columns(ErlNifEnv *env, ArrowArrayStreamState * state, ERL_NIF_TERM value) {
+    int arity = 0;
+    const ERL_NIF_TERM * tuple = nullptr;
+    if (!enif_get_tuple(env, value, &arity, &tuple) || arity != 2) {
+        return enif_make_badarg(env);
+    }
+    bool all = enif_is_identical(tuple[0], kAtomTrue);
+    std::vector<ErlNifBinary> name_binaries;
+    if (!all && !erlang::nif::get_list(env, tuple[0], name_binaries)) {
+        return enif_make_badarg(env);
+    }
+    std::vector<std::string> names;
+    for (auto &binary : name_binaries) {
+        names.emplace_back((const char *)binary.data, binary.size);
+    }
+    bool atoms = false;
+    if (!erlang::nif::get(env, tuple[1], &atoms)) {
+        return enif_make_badarg(env);
+    }
+
+    for (int64_t i = 0; i < state->schema.n_children; i++) {
+        struct ArrowSchema * column_schema = state->schema.children[i];
+        const char * format = column_schema->format ? column_schema->format : "";
+        const char * name = column_schema->name ? column_schema->name : "";
+        bool strings = strlen(format) == 1 && strchr("uUzZ", format[0]) != nullptr && column_schema->dictionary == nullptr;
+        bool listed = all || std::find(names.begin(), names.end(), name) != names.end();
+        state->columns[i].intern = strings && listed;
+        state->intern_columns = state->intern_columns || state->columns[i].intern;
+    }
+    state->intern_atoms = atoms;
+
+    return erlang::nif::ok(env);
+}
+
+// Returns the values of the top-level timestamp columns with a time zone
+// of the following batches as `DateTime`s in that zone. Each zone is read
+// once from the zoneinfo database of the system.
+static ERL_NIF_TERM arrow_array_stream_set_datetime_columns(ErlNifEnv *env, ArrowArrayStreamState * state, ERL_NIF_TERM value) {
+    bool enabled = false;
+    if (!erlang::nif::get(env, value, &enabled)) {
+        return enif_make_badarg(env);
+    }
+
+    // the zones read so far, by the name given in their column format
+    std::vector<std::pair<std::string, std::shared_ptr<const AdbcTimeZone>>> zones;
+    for (int64_t i = 0; enabled && i < state->schema.n_children; i++) {
+        struct ArrowSchema * column_schema = state->schema.children[i];
+        const char * format = column_schema->format ? column_schema->format : "";
+        if (strncmp(format, "ts", 2) != 0 || strlen(format) <= 4 || column_schema->dictionary != nullptr) {
+            continue;
+        }
+        std::string name(format + 4);
+        auto found = std::find_if(zones.begin(), zones.end(), [&](const auto &zone) { return zone.first == name; });
+        if (found == zones.end()) {
+            auto zone = std::make_shared<AdbcTimeZone>();
+            if (!zone->load(name)) {
+                return erlang::nif::error(env, ("unknown time zone: " + name).c_str());
+            }
+            zones.emplace_back(name, zone);
+            found = zones.end() - 1;
+        }
+        state->columns[i].timezone = found->second;
+    }
+    state->datetime_columns = !zones.empty();
+
+    return erlang::nif::ok(env);
+}
+
+// Converts up to `window` batches of the stream at once on the worker
+// pool. It only applies to `adbc_arrow_array_stream_next` on dirty
+// schedulers, and not to streams with zero-copy binaries, raw, lazy,
+// dictionary or numeric columns, whose batches are converted as they are
+// read.
+static ERL_NIF_TERM arrow_array_stream_set_parallel_batches(ErlNifEnv *env, ArrowArrayStreamState * state, ERL_NIF_TERM value) {
+    uint64_t window = 0;
+    if (!erlang::nif::get(env, value, &window) || window == 0) {
+        return enif_make_badarg(env);
+    }
+    if (state->decoder) {
+        return erlang::nif::error(env, "the batches of the stream are already converted in parallel");
+    }
+    if (!state->zero_copy_binaries && !state->raw_columns && !state->vector_columns && !state->lazy_columns && !state->dictionary_columns && !state->numeric_columns && !state->intern_columns && !state->datetime_columns) {
+        state->decoder.reset(new ParallelDecoder((size_t)window));
+    }
+
+    return erlang::nif::ok(env);
+}
+
+// Sets the shape of the results of the following batches, either
+// `:columns`, `:rows_tuples` or `:rows_maps`.
+static ERL_NIF_TERM arrow_array_stream_set_output(ErlNifEnv *env, ArrowArrayStreamState * state, ERL_NIF_TERM value) {
+    std::string output_name;
+    if (!erlang::nif::get_atom(env, value, output_name)) {
+        return enif_make_badarg(env);
+    }
+
+    if (output_name == "columns") {
+        state->output = ArrowStreamOutput::kColumns;
+    } else if (output_name == "rows_tuples") {
+        state->output = ArrowStreamOutput::kRowsTuples;
+    } else if (output_name == "rows_maps") {
+        state->output = ArrowStreamOutput::kRowsMaps;
+    } else {
+        return enif_make_badarg(env);
+    }
+
+    return erlang::nif::ok(env);
+}
+
+// Sets how the following batches of the stream are converted, with `key`
+// one of:
+//
+//   * `:zero_copy_binaries` - top-level string and binary columns are
+//     sub-binaries of the batch buffers instead of copies, which keeps the
+//     whole batch in memory for as long as any of its values is referenced
+//   * `:raw_columns` - fixed-width top-level columns are returned as
+//     `{:raw, values, validity}` binaries instead of lists of terms
+//   * `:vector_columns` - top-level fixed-size lists of fixed-width items
+//     are returned as a binary of the items of each row
+//   * `:lazy_columns` - top-level columns reference the batch, see
+//     `adbc_column_materialize`
+//   * `:dictionary_columns` - dictionary-encoded top-level columns are
+//     returned as `{:dictionary, indices, values}`
+//   * `:numeric_columns` - top-level string columns of PostgreSQL `numeric`
+//     values are returned as `{:decimal, 128, 38, scale}` columns
+//   * `:parallel_columns` - batches converted at once, on dirty schedulers,
+//     are converted a range of their columns per worker of the worker pool
+//     once they have enough values, see `arrow_batch_to_columns_parallel`
+//   * `:stats` - the stream collects the time spent in `get_next` and what
+//     it read, returned by `adbc_arrow_array_stream_stats`
+//
+// each given a boolean, and `:intern_columns`, `:datetime_columns`,
+// `:parallel_batches` and `:output` described above.
+static ERL_NIF_TERM adbc_arrow_array_stream_set_option(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    std::string key;
+    if (!erlang::nif::get_atom(env, argv[1], key)) {
+        return enif_make_badarg(env);
+    }
+    ERL_NIF_TERM value = argv[2];
+
+    // stats need no schema, and are kept once the stream is released
+    if (key == "stats") {
+        bool enabled = false;
+        if (!erlang::nif::get(env, value, &enabled)) {
+            return enif_make_badarg(env);
+        }
+        arrow_array_stream_state(res)->collect_stats = enabled;
+        return erlang::nif::ok(env);
+    }
+
+    if (res->val.release == nullptr) {
+        return erlang::nif::error(env, "ArrowArrayStream has already been released");
+    }
+    auto state = get_arrow_array_stream_state(env, res, error);
+    if (state == nullptr) {
+        return error;
+    }
+
+    static const std::pair<const char *, bool ArrowArrayStreamState::*> flags[] = {
+        {"zero_copy_binaries", &ArrowArrayStreamState::zero_copy_binaries},
+        {"raw_columns", &ArrowArrayStreamState::raw_columns},
+        {"vector_columns", &ArrowArrayStreamState::vector_columns},
+        {"lazy_columns", &ArrowArrayStreamState::lazy_columns},
+        {"dictionary_columns", &ArrowArrayStreamState::dictionary_columns},
+        {"numeric_columns", &ArrowArrayStreamState::numeric_columns},
+        {"parallel_columns", &ArrowArrayStreamState::parallel_columns},
+    };
+    for (auto &flag : flags) {
+        if (key == flag.first) {
+            bool enabled = false;
+            if (!erlang::nif::get(env, value, &enabled)) {
+                return enif_make_badarg(env);
+            }
+            state->*flag.second = enabled;
+            return erlang::nif::ok(env);
+        }
+    }
+
+    if (key == "intern_columns") {
+        return arrow_array_stream_set_intern_columns(env, state, value);
+    } else if (key == "datetime_columns") {
+        return arrow_array_stream_set_datetime_columns(env, state, value);
+    } else if (key == "parallel_batches") {
+        return arrow_array_stream_set_parallel_batches(env, state, value);
+    } else if (key == "output") {
+        return arrow_array_stream_set_output(env, state, value);
+    }
+    return enif_make_badarg(env);
+}
+
+// Returns `{execute_time, fetch_time, rows, bytes}` of the stream, with
+// times in nanoseconds, see `ArrowArrayStreamState::collect_stats`.
+static ERL_NIF_TERM adbc_arrow_array_stream_stats(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    auto state = arrow_array_stream_state(res);
+    return enif_make_tuple4(env,
+        enif_make_int64(env, state->execute_time),
+        enif_make_int64(env, state->fetch_time),
+        enif_make_int64(env, state->fetched_rows),
+        enif_make_int64(env, state->fetched_bytes)
+    );
+}
+
+// Returns the stats of the last batch read from the stream as a map of
+// `:fetch_time`, in nanoseconds, `:rows`, `:bytes` and `:null_counts`, a
+// list with the nulls of each top-level column, see
+// `ArrowArrayStreamState::collect_stats`.
+static ERL_NIF_TERM adbc_arrow_array_stream_batch_stats(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    auto state = arrow_array_stream_state(res);
+    std::vector<ERL_NIF_TERM> null_counts;
+    null_counts.reserve(state->batch_null_counts.size());
+    for (int64_t null_count : state->batch_null_counts) {
+        null_counts.push_back(enif_make_int64(env, null_count));
+    }
+
+    ERL_NIF_TERM keys[] = {
+        erlang::nif::atom(env, "fetch_time"),
+        erlang::nif::atom(env, "rows"),
+        erlang::nif::atom(env, "bytes"),
+        erlang::nif::atom(env, "null_counts"),
+    };
+    ERL_NIF_TERM values[] = {
+        enif_make_int64(env, state->batch_fetch_time),
+        enif_make_int64(env, state->batch_rows),
+        enif_make_int64(env, state->batch_bytes),
+        enif_make_list_from_array(env, null_counts.data(), (unsigned)null_counts.size()),
+    };
+
+    ERL_NIF_TERM stats;
+    enif_make_map_from_arrays(env, keys, values, sizeof(keys)/sizeof(keys[0]), &stats);
+    return stats;
+}
+
+// Limits the rows and bytes of the buffers read from the stream, -1 for
+// no limit. Once exceeded, `adbc_arrow_array_stream_next` cancels the
+// statement of the stream, `statement` unless it is nil, and releases the
+// stream.
+static ERL_NIF_TERM adbc_arrow_array_stream_set_limits(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    using statement_type = NifRes<struct AdbcStatement>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    statement_type * statement = nullptr;
+    if (!enif_is_identical(argv[1], kAtomNil) &&
+        (statement = statement_type::get_resource(env, argv[1], error)) == nullptr) {
+        return error;
+    }
+    int64_t max_result_bytes = -1, max_rows = -1;
+    if (!erlang::nif::get(env, argv[2], &max_result_bytes) || !erlang::nif::get(env, argv[3], &max_rows)) {
+        return enif_make_badarg(env);
+    }
+    if (res->val.release == nullptr) {
+        return erlang::nif::error(env, "ArrowArrayStream has already been released");
+    }
+
+    auto state = get_arrow_array_stream_state(env, res, error);
+    if (state == nullptr) {
+        return error;
+    }
+    state->max_result_bytes = max_result_bytes;
+    state->max_rows = max_rows;
+    // streams from a statement already keep it
+    if (statement != nullptr && statement != state->statement) {
+        enif_keep_resource(statement);
+        if (state->statement != nullptr) {
+            enif_release_resource(state->statement);
+        }
+        state->statement = statement;
+    }
+
+    return erlang::nif::ok(env);
+}
+
+// Converts `length` values of a lazy column starting at `offset` to a list.
+static ERL_NIF_TERM adbc_column_materialize(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using reference_type = NifRes<ArrowColumnReference>;
+    ERL_NIF_TERM error{};
+
+    reference_type * reference = nullptr;
+    if ((reference = reference_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    int64_t offset = 0, length = 0;
+    if (!erlang::nif::get(env, argv[1], &offset) || !erlang::nif::get(env, argv[2], &length) ||
+        offset < 0 || length < 0 || offset + length > reference->val.values->length) {
+        return enif_make_badarg(env);
+    }
+
+    std::vector<ERL_NIF_TERM> out_terms;
+    ERL_NIF_TERM out_type;
+    ERL_NIF_TERM out_metadata;
+    if (arrow_array_to_nif_term(env, &reference->val.schema, reference->val.values, offset, length, 1, out_terms, out_type, out_metadata, error) == 1) {
+        return error;
+    }
+    if (out_terms.size() != 2) {
+        return erlang::nif::error(env, "invalid lazy column");
+    }
+
+    return enif_make_tuple2(env, erlang::nif::ok(env), out_terms[1]);
+}
+
+// Concatenates a list of `{:lazy, reference, offset, length}` columns of the
+// same type into a single lazy column owning a copy of their buffers.
+static ERL_NIF_TERM adbc_column_concat(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using reference_type = NifRes<ArrowColumnReference>;
+    using array_type = NifRes<struct ArrowArray>;
+    ERL_NIF_TERM error{};
+
+    // shallow copies of the referenced arrays, narrowed to each slice
+    std::vector<struct ArrowArray> slices;
+    reference_type * first = nullptr;
+    ERL_NIF_TERM head, tail = argv[0];
+    while (enif_get_list_cell(env, tail, &head, &tail)) {
+        const ERL_NIF_TERM *tuple = nullptr;
+        int arity = 0;
+        reference_type * reference = nullptr;
+        int64_t offset = 0, length = 0;
+        if (!enif_get_tuple(env, head, &arity, &tuple) || arity != 4 || !enif_is_identical(tuple[0], kAtomLazy) ||
+            (reference = reference_type::get_resource(env, tuple[1], error)) == nullptr ||
+            !erlang::nif::get(env, tuple[2], &offset) || !erlang::nif::get(env, tuple[3], &length) ||
+            offset < 0 || length < 0 || offset + length > reference->val.values->length) {
+            return enif_make_badarg(env);
+        }
+
+        if (first == nullptr) {
+            first = reference;
+        } else if (strcmp(first->val.schema.format, reference->val.schema.format) != 0) {
+            return erlang::nif::error(env, "cannot concatenate columns of different types");
+        }
+
+        struct ArrowArray slice = *reference->val.values;
+        slice.offset += offset;
+        if (offset != 0 || length != slice.length) slice.null_count = -1;
+        slice.length = length;
+        slices.push_back(slice);
+    }
+    if (first == nullptr) {
+        return enif_make_badarg(env);
+    }
+
+    std::vector<const struct ArrowArray *> arrays;
+    for (auto &slice : slices) {
+        arrays.push_back(&slice);
+    }
+
+    auto owner = array_type::allocate_resource(env, error);
+    if (owner == nullptr) {
+        return error;
+    }
+    std::string reason;
+    if (arrow_array_concat(&first->val.schema, arrays, &owner->val, reason) != 0) {
+        enif_release_resource(owner);
+        return erlang::nif::error(env, reason.c_str());
+    }
+    track_retained_batch(owner, &first->val.schema);
+
+    auto reference = reference_type::allocate_resource(env, error);
+    if (reference == nullptr) {
+        enif_release_resource(owner);
+        return error;
+    }
+    // the reference takes over the only reference to the owner
+    reference->val.owner = owner;
+    reference->val.values = &owner->val;
+    if (ArrowSchemaDeepCopy(&first->val.schema, &reference->val.schema) != NANOARROW_OK) {
+        enif_release_resource(reference);
+        return erlang::nif::error(env, "cannot copy the schema of a lazy column");
+    }
+    adbc_memory_stats.retained_schemas++;
+    ERL_NIF_TERM reference_term = reference->make_resource(env);
+    enif_release_resource(reference);
+
+    ERL_NIF_TERM data = enif_make_tuple4(env, kAtomLazy, reference_term, enif_make_int64(env, 0), enif_make_int64(env, owner->val.length));
+    return enif_make_tuple2(env, erlang::nif::ok(env), data);
+}
+
+// Moves the stream into a new resource, leaving the given one released as
+// in the Arrow C stream interface, so it no longer depends on its owner.
+static ERL_NIF_TERM adbc_arrow_array_stream_move(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    if (res->val.release == nullptr) {
+        return erlang::nif::error(env, "ArrowArrayStream has already been released");
+    }
+
+    auto moved = allocate_arrow_array_stream(env, error);
+    if (moved == nullptr) {
+        return error;
+    }
+    memcpy(&moved->val, &res->val, sizeof(struct ArrowArrayStream));
+    res->val.release = nullptr;
+    if (res->private_data != nullptr) {
+        // the driver may still read from the statement or connection
+        auto state = (ArrowArrayStreamState *)res->private_data;
+        arrow_array_stream_keep_parent(moved, state->statement, state->connection_resource);
+    }
+
+    ERL_NIF_TERM ret = moved->make_resource(env);
+    enif_release_resource(moved);
+    return enif_make_tuple2(env, erlang::nif::ok(env), ret);
+}
+
+static ERL_NIF_TERM adbc_arrow_array_stream_release(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    release_owned_arrow_array_stream(env, res, false);
+    return erlang::nif::ok(env);
+}
+
+// Hands the stream over to `owner`, called by the connection that ran
+// the query. The stream is released, and the calling process sent
+// `{:adbc_stream_released, tag}`, once the owner releases it or exits.
+static ERL_NIF_TERM adbc_arrow_array_stream_set_owner(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    ErlNifPid owner;
+    if (!enif_get_local_pid(env, argv[1], &owner)) {
+        return enif_make_badarg(env);
+    }
+
+    auto state = arrow_array_stream_state(res);
+    {
+        std::lock_guard<std::mutex> lock(state->owner_mutex);
+        if (state->owned) {
+            return erlang::nif::error(env, "ArrowArrayStream already has an owner");
+        }
+        state->owned = true;
+        enif_self(env, &state->connection);
+        state->owner_tag = enif_make_copy(state->env, argv[2]);
+        if (enif_monitor_process(env, res, &owner, &state->owner_monitor) == 0) {
+            return erlang::nif::ok(env);
+        }
+    }
+
+    // the owner already exited
+    release_owned_arrow_array_stream(env, res, true);
+    return erlang::nif::ok(env);
+}
+
+static ERL_NIF_TERM string_to_binary_term(ErlNifEnv *env, const std::string &value) {
+    ERL_NIF_TERM term;
+    unsigned char * data = enif_make_new_binary(env, value.size(), &term);
+    memcpy(data, value.data(), value.size());
+    return term;
+}
+
+// Reads the rest of the stream and encodes it as a list of binaries, the
+// schema followed by one binary per batch, see adbc_arrow_serialize.hpp.
+static ERL_NIF_TERM adbc_arrow_array_stream_encode(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct ArrowArrayStream>;
+    ERL_NIF_TERM error{};
+
+    res_type * res = nullptr;
+    if ((res = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+    if (res->val.release == nullptr) {
+        return erlang::nif::error(env, "ArrowArrayStream has already been released");
+    }
+
+    struct ArrowSchema schema{};
+    if (res->val.get_schema(&res->val, &schema) != 0) {
+        const char * reason = res->val.get_last_error(&res->val);
+        return erlang::nif::error(env, reason ? reason : "unknown error");
+    }
+
+    std::string encoded;
+    arrow_schema_serialize(&schema, encoded);
+    std::vector<ERL_NIF_TERM> binaries{string_to_binary_term(env, encoded)};
+
+    std::string reason;
+    while (true) {
+        struct ArrowArray batch{};
+        if (res->val.get_next(&res->val, &batch) != 0) {
+            const char * last_error = res->val.get_last_error(&res->val);
+            reason = last_error ? last_error : "unknown error";
+            break;
+        }
+        if (batch.release == nullptr) break;
+
+        int failed = arrow_array_serialize(&schema, &batch, encoded, reason);
+        batch.release(&batch);
+        if (failed) break;
+        binaries.push_back(string_to_binary_term(env, encoded));
+    }
+    schema.release(&schema);
+
+    if (!reason.empty()) {
+        return erlang::nif::error(env, reason.c_str());
+    }
+    return enif_make_tuple2(env, erlang::nif::ok(env), enif_make_list_from_array(env, binaries.data(), (unsigned)binaries.size()));
+}
+
+// Decodes binaries produced by `adbc_arrow_array_stream_encode` into a new
+// stream resource holding copies of the batches.
+static ERL_NIF_TERM adbc_arrow_array_stream_decode(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    ERL_NIF_TERM error{};
+
+    std::vector<ErlNifBinary> binaries;
+    ERL_NIF_TERM head, tail = argv[0];
+    while (enif_get_list_cell(env, tail, &head, &tail)) {
+        ErlNifBinary binary;
+        if (!enif_inspect_binary(env, head, &binary)) {
+            return enif_make_badarg(env);
+        }
+        binaries.push_back(binary);
+    }
+    if (binaries.empty() || !enif_is_empty_list(env, tail)) {
+        return enif_make_badarg(env);
+    }
+
+    std::string reason;
+    struct ArrowSchema schema{};
+    bool swap = false;
+    if (arrow_schema_deserialize(binaries[0].data, binaries[0].size, &schema, swap, reason) != 0) {
+        return erlang::nif::error(env, reason.c_str());
+    }
+
+    std::vector<struct ArrowArray> batches;
+    for (size_t i = 1; i < binaries.size(); i++) {
+        struct ArrowArray batch{};
+        if (arrow_array_deserialize(&schema, binaries[i].data, binaries[i].size, swap, &batch, reason) != 0) {
+            break;
+        }
+        batches.push_back(batch);
+    }
+
+    auto release_all = [&]() {
+        for (auto &batch : batches) batch.release(&batch);
+        schema.release(&schema);
+    };
+    if (!reason.empty()) {
+        release_all();
+        return erlang::nif::error(env, reason.c_str());
+    }
+
+    auto res = allocate_arrow_array_stream(env, error);
+    if (res == nullptr) {
+        release_all();
+        return error;
+    }
+    if (ArrowBasicArrayStreamInit(&res->val, &schema, (int64_t)batches.size()) != NANOARROW_OK) {
+        release_all();
+        enif_release_resource(res);
+        return erlang::nif::error(env, "cannot allocate ArrowArrayStream");
+    }
+    // the stream took over the schema and takes over each batch
+    for (size_t i = 0; i < batches.size(); i++) {
+        ArrowBasicArrayStreamSetArray(&res->val, (int64_t)i, &batches[i]);
+    }
+
+    ERL_NIF_TERM ret = res->make_resource(env);
+    enif_release_resource(res);
+    return enif_make_tuple2(env, erlang::nif::ok(env), ret);
+}
+
+// Returns `{:ok, stream}` over the record batches of the Arrow IPC file or
+// stream at the given path, which is mapped in memory until the stream
+// and its batches are released.
+static ERL_NIF_TERM adbc_arrow_ipc_file_open(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    ERL_NIF_TERM error{};
+
+    std::string path;
+    if (!erlang::nif::get(env, argv[0], path)) {
+        return enif_make_badarg(env);
+    }
+
+    auto res = allocate_arrow_array_stream(env, error);
+    if (res == nullptr) {
+        return error;
+    }
+    std::string reason;
+    if (arrow_array_stream_from_ipc_file(&res->val, path, reason) != 0) {
+        enif_release_resource(res);
+        return erlang::nif::error(env, reason.c_str());
+    }
+
+    ERL_NIF_TERM ret = res->make_resource(env);
+    enif_release_resource(res);
+    return enif_make_tuple2(env, erlang::nif::ok(env), ret);
+}
+
+static ERL_NIF_TERM adbc_statement_new(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct AdbcStatement>;
+    using connection_type = NifRes<struct AdbcConnection>;
+
+    ERL_NIF_TERM error{};
+
+    connection_type * connection = nullptr;
+    if ((connection = connection_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    auto statement = res_type::allocate_resource(env, error);
+    if (statement == nullptr) {
+        return error;
+    }
+
+    struct AdbcError adbc_error{};
+    AdbcStatusCode code = AdbcStatementNew(&connection->val, &statement->val, &adbc_error);
+    if (code != ADBC_STATUS_OK) {
+        return nif_error_from_adbc_error(env, &adbc_error);
+    }
+
+    statement->private_data = new AdbcStatementState();
+    connection->private_data = &connection->val;
+    enif_keep_resource(&connection->val);
+    ERL_NIF_TERM ret = statement->make_resource(env);
+    return erlang::nif::ok(env, ret);
+}
+
+static ERL_NIF_TERM adbc_statement_get_option(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    return adbc_get_option<struct AdbcStatement>(
+        env,
+        argv,
+        AdbcStatementGetOption,
+        AdbcStatementGetOptionBytes,
+        AdbcStatementGetOptionInt,
+        AdbcStatementGetOptionDouble
+    );
+}
+
+static ERL_NIF_TERM adbc_statement_set_option(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    return adbc_set_option<struct AdbcStatement>(
+        env,
+        argv,
+        AdbcStatementSetOption,
+        AdbcStatementSetOptionBytes,
+        AdbcStatementSetOptionInt,
+        AdbcStatementSetOptionDouble
+    );
+}
+
+static ERL_NIF_TERM adbc_statement_execute_query(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    AdbcCallScope scope(adbc_call_stats.execute_query);
+    using res_type = NifRes<struct AdbcStatement>;
+
+    ERL_NIF_TERM error{};
+
+    res_type * statement = nullptr;
+    if ((statement = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    auto array_stream = allocate_arrow_array_stream(env, error);
+    if (array_stream == nullptr) {
+        return error;
+    }
+
+    int64_t rows_affected = 0;
+    struct AdbcError adbc_error{};
+    int64_t started = enif_monotonic_time(ERL_NIF_NSEC);
+    AdbcStatusCode code = AdbcStatementExecuteQuery(&statement->val, &array_stream->val, &rows_affected, &adbc_error);
+    if (code != ADBC_STATUS_OK) {
+        enif_release_resource(array_stream);
+        return nif_error_from_adbc_error(env, &adbc_error);
+    }
+    arrow_array_stream_keep_parent(array_stream, statement, nullptr);
+    arrow_array_stream_state(array_stream)->execute_time = enif_monotonic_time(ERL_NIF_NSEC) - started;
+
+    ERL_NIF_TERM ret = array_stream->make_resource(env);
+    enif_release_resource(array_stream);
+    return enif_make_tuple3(env,
+        erlang::nif::ok(env),
+        ret,
+        enif_make_int64(env, rows_affected)
+    );
+}
+
+// Executes `statement` as a partitioned result set and returns its
+// serialized partitions as binaries, each to be read with
+// `adbc_connection_read_partition` on any connection to the database.
+static ERL_NIF_TERM adbc_statement_execute_partitions(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct AdbcStatement>;
+
+    ERL_NIF_TERM error{};
+    res_type * statement = nullptr;
+    if ((statement = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    struct ArrowSchema schema{};
+    struct AdbcPartitions partitions{};
+    int64_t rows_affected = 0;
+    struct AdbcError adbc_error{};
+    AdbcStatusCode code = AdbcStatementExecutePartitions(&statement->val, &schema, &partitions, &rows_affected, &adbc_error);
+    if (code != ADBC_STATUS_OK) {
+        return nif_error_from_adbc_error(env, &adbc_error);
+    }
+    if (schema.release != nullptr) {
+        schema.release(&schema);
+    }
+
+    std::vector<ERL_NIF_TERM> terms;
+    terms.reserve(partitions.num_partitions);
+    for (size_t i = 0; i < partitions.num_partitions; i++) {
+        ERL_NIF_TERM term;
+        unsigned char * data = enif_make_new_binary(env, partitions.partition_lengths[i], &term);
+        if (partitions.partition_lengths[i] > 0) {
+            memcpy(data, partitions.partitions[i], partitions.partition_lengths[i]);
+        }
+        terms.push_back(term);
+    }
+    if (partitions.release != nullptr) {
+        partitions.release(&partitions);
+    }
+
+    return enif_make_tuple3(env,
+        erlang::nif::ok(env),
+        enif_make_list_from_array(env, terms.data(), (unsigned)terms.size()),
+        enif_make_int64(env, rows_affected)
+    );
+}
+
+static ERL_NIF_TERM statement_execute_async(ErlNifEnv *env, const ERL_NIF_TERM argv[], bool update) {
+    using res_type = NifRes<struct AdbcStatement>;
+
+    ERL_NIF_TERM error{};
+
+    res_type * statement = nullptr;
+    if ((statement = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    ErlNifPid pid;
+    if (!enif_get_local_pid(env, argv[1], &pid)) {
+        return enif_make_badarg(env);
+    }
+
+    auto array_stream = allocate_arrow_array_stream(env, error);
+    if (array_stream == nullptr) {
+        return error;
+    }
+
+    ErlNifEnv * msg_env = enif_alloc_env();
+    if (msg_env == nullptr) {
+        enif_release_resource(array_stream);
+        return erlang::nif::error(env, "out of memory");
+    }
+    arrow_array_stream_keep_parent(array_stream, statement, nullptr);
+
+    ERL_NIF_TERM ref = enif_make_ref(env);
+    ERL_NIF_TERM msg_ref = enif_make_copy(msg_env, ref);
+
+    // the statement must outlive the job even if Erlang drops it meanwhile
+    enif_keep_resource(statement);
+    get_worker_pool().submit_blocking([statement, array_stream, pid, msg_env, msg_ref, update]() {
+        int64_t rows_affected = 0;
+        struct AdbcError adbc_error{};
+        // without an output stream, the stream resource stays released
+        struct ArrowArrayStream * out = update ? nullptr : &array_stream->val;
+        AdbcStatusCode code;
+        int64_t started = enif_monotonic_time(ERL_NIF_NSEC);
+        {
+            AdbcCallScope scope(adbc_call_stats.execute_query);
+            code = AdbcStatementExecuteQuery(&statement->val, out, &rows_affected, &adbc_error);
+        }
+        arrow_array_stream_state(array_stream)->execute_time = enif_monotonic_time(ERL_NIF_NSEC) - started;
+
+        ERL_NIF_TERM result;
+        if (code != ADBC_STATUS_OK) {
+            result = nif_error_from_adbc_error(msg_env, &adbc_error);
+        } else {
+            result = enif_make_tuple3(msg_env,
+                erlang::nif::ok(msg_env),
+                array_stream->make_resource(msg_env),
+                enif_make_int64(msg_env, rows_affected)
+            );
+        }
+
+        enif_send(nullptr, &pid, msg_env, enif_make_tuple2(msg_env, msg_ref, result));
+        enif_free_env(msg_env);
+        enif_release_resource(array_stream);
+        enif_release_resource(statement);
+    });
+
+    return erlang::nif::ok(env, ref);
+}
+
+// Same as `adbc_statement_execute_query` but runs the query on the blocking
+// lane of the worker pool. It returns `{:ok, ref}` right away and later sends
+// `{ref, {:ok, stream, rows_affected}}` or `{ref, {:error, reason}}` to `pid`.
+static ERL_NIF_TERM adbc_statement_execute_query_async(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    return statement_execute_async(env, argv, false);
+}
+
+// Same as `adbc_statement_execute_query_async` but does not ask for a
+// result set, which drivers require when ingesting a bound stream. The
+// stream in the reply is already released.
+static ERL_NIF_TERM adbc_statement_execute_update_async(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    return statement_execute_async(env, argv, true);
+}
+
+static ERL_NIF_TERM adbc_statement_prepare(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct AdbcStatement>;
+
+    ERL_NIF_TERM error{};
+
+    res_type * statement = nullptr;
+    if ((statement = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    struct AdbcError adbc_error{};
+    AdbcStatusCode code = AdbcStatementPrepare(&statement->val, &adbc_error);
+    if (code != ADBC_STATUS_OK) {
+        return nif_error_from_adbc_error(env, &adbc_error);
+    }
+
+    return erlang::nif::ok(env);
+}
+
+// Cancels the query currently executing on the statement, if any.
+// It is safe to call it while another thread executes the statement.
+static ERL_NIF_TERM adbc_statement_cancel(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct AdbcStatement>;
+
+    ERL_NIF_TERM error{};
+
+    res_type * statement = nullptr;
+    if ((statement = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    struct AdbcError adbc_error{};
+    AdbcStatusCode code = AdbcStatementCancel(&statement->val, &adbc_error);
+    if (code != ADBC_STATUS_OK) {
+        return nif_error_from_adbc_error(env, &adbc_error);
+    }
+
+    return erlang::nif::ok(env);
+}
+
+static ERL_NIF_TERM adbc_statement_set_sql_query(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct AdbcStatement>;
+
+    ERL_NIF_TERM error{};
+
+    res_type * statement = nullptr;
+    if ((statement = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    std::string query;
+    if (!erlang::nif::get(env, argv[1], query)) {
+        return enif_make_badarg(env);
+    }
+
+    struct AdbcError adbc_error{};
+    AdbcStatusCode code = AdbcStatementSetSqlQuery(&statement->val, query.c_str(), &adbc_error);
+    if (code != ADBC_STATUS_OK) {
+        return nif_error_from_adbc_error(env, &adbc_error);
+    }
+
+    return erlang::nif::ok(env);
+}
+
+static ERL_NIF_TERM adbc_statement_bind(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    AdbcCallScope scope(adbc_call_stats.bind);
+    using res_type = NifRes<struct AdbcStatement>;
+
+    ERL_NIF_TERM ret{};
+    ERL_NIF_TERM error{};
 
     res_type * statement = nullptr;
     if ((statement = res_type::get_resource(env, argv[0], error)) == nullptr) {
@@ -696,17 +3333,47 @@ static ERL_NIF_TERM adbc_statement_bind(ErlNifEnv *env, int argc, const ERL_NIF_
         return enif_make_badarg(env);
     }
 
+    // parameters built by trusted code skip the validation of the arrays
+    bool trusted = enif_is_identical(argv[2], kAtomTrue);
+
     struct ArrowArray values{};
     struct ArrowSchema schema{};
     struct ArrowError arrow_error{};
     struct AdbcError adbc_error{};
     AdbcStatusCode code{};
 
-    if (adbc_column_to_arrow_type_struct(env, argv[1], &values, &schema, &arrow_error)) {
+    ERL_NIF_TERM head, tail, signature;
+    bool as_rows, cacheable;
+    std::shared_ptr<AdbcBindSchema> bind_schema;
+    as_rows = enif_get_list_cell(env, argv[1], &head, &tail) && enif_is_list(env, head);
+    // columns of the same types as the last bind reuse its schema
+    cacheable = !as_rows && statement->private_data != nullptr && adbc_column_bind_signature(env, argv[1], signature);
+    if (cacheable) {
+        auto state = (AdbcStatementState *)statement->private_data;
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->bind_schema && enif_is_identical(state->signature, signature)) {
+            bind_schema = state->bind_schema;
+        }
+    }
+
+    if (as_rows ? adbc_rows_to_arrow_type_struct(env, argv[1], &values, &schema, &arrow_error, trusted) : adbc_column_to_arrow_type_struct(env, argv[1], &values, &schema, &arrow_error, trusted, bind_schema ? &bind_schema->schema : nullptr)) {
         ret = erlang::nif::error(env, arrow_error.message);
         goto cleanup;
     }
 
+    if (cacheable && !bind_schema) {
+        bind_schema = std::make_shared<AdbcBindSchema>();
+        ArrowSchemaMove(&schema, &bind_schema->schema);
+        auto state = (AdbcStatementState *)statement->private_data;
+        std::lock_guard<std::mutex> lock(state->mutex);
+        enif_clear_env(state->env);
+        state->signature = enif_make_copy(state->env, signature);
+        state->bind_schema = bind_schema;
+    }
+    if (bind_schema) {
+        adbc_bind_schema_view(bind_schema, &schema);
+    }
+
     code = AdbcStatementBind(&statement->val, &values, &schema, &adbc_error);
     if (code != ADBC_STATUS_OK) {
         ret = nif_error_from_adbc_error(env, &adbc_error);
@@ -720,7 +3387,158 @@ cleanup:
     return ret;
 }
 
+// Binds each row of parameters of `argv[1]` in turn and executes the
+// statement for it without a result set. Returns `{:ok, rows_affected}`,
+// a list with the rows affected by each row, or -1 where the driver does
+// not report it. Rows executed before an error are not rolled back.
+static ERL_NIF_TERM adbc_statement_execute_many(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct AdbcStatement>;
+
+    ERL_NIF_TERM error{};
+
+    res_type * statement = nullptr;
+    if ((statement = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    unsigned n_rows = 0;
+    if (!enif_get_list_length(env, argv[1], &n_rows)) {
+        return enif_make_badarg(env);
+    }
+
+    std::vector<ERL_NIF_TERM> counts;
+    counts.reserve(n_rows);
+    ERL_NIF_TERM row, tail = argv[1];
+    while (enif_get_list_cell(env, tail, &row, &tail)) {
+        struct ArrowArray values{};
+        struct ArrowSchema schema{};
+        struct ArrowError arrow_error{};
+        struct AdbcError adbc_error{};
+
+        ERL_NIF_TERM ret{};
+        bool failed = true;
+        int64_t rows_affected = -1;
+        if (adbc_rows_to_arrow_type_struct(env, enif_make_list1(env, row), &values, &schema, &arrow_error)) {
+            ret = erlang::nif::error(env, arrow_error.message);
+        } else if (AdbcStatementBind(&statement->val, &values, &schema, &adbc_error) != ADBC_STATUS_OK) {
+            ret = nif_error_from_adbc_error(env, &adbc_error);
+        } else if (AdbcStatementExecuteQuery(&statement->val, nullptr, &rows_affected, &adbc_error) != ADBC_STATUS_OK) {
+            ret = nif_error_from_adbc_error(env, &adbc_error);
+        } else {
+            failed = false;
+        }
+
+        if (values.release) values.release(&values);
+        if (schema.release) schema.release(&schema);
+        if (failed) return ret;
+        counts.push_back(enif_make_int64(env, rows_affected));
+    }
+
+    return erlang::nif::ok(env, enif_make_list_from_array(env, counts.data(), static_cast<unsigned>(counts.size())));
+}
+
+// Executes `query`, bound to the parameters `params` unless empty, with a
+// statement of its own released right after, without a result set.
+//
+// Returns 0 on success. On failure, returns 1 and `error` is set.
+static int adbc_connection_execute_one(ErlNifEnv *env, struct AdbcConnection * connection, const std::string &query, ERL_NIF_TERM params, int64_t &rows_affected, ERL_NIF_TERM &error) {
+    struct AdbcStatement statement{};
+    struct AdbcError adbc_error{};
+    if (AdbcStatementNew(connection, &statement, &adbc_error) != ADBC_STATUS_OK) {
+        error = nif_error_from_adbc_error(env, &adbc_error);
+        return 1;
+    }
+
+    struct ArrowArray values{};
+    struct ArrowSchema schema{};
+    struct ArrowError arrow_error{};
+    bool failed = true;
+    rows_affected = -1;
+    if (AdbcStatementSetSqlQuery(&statement, query.c_str(), &adbc_error) != ADBC_STATUS_OK) {
+        error = nif_error_from_adbc_error(env, &adbc_error);
+    } else if (!enif_is_empty_list(env, params) && adbc_rows_to_arrow_type_struct(env, enif_make_list1(env, params), &values, &schema, &arrow_error)) {
+        error = erlang::nif::error(env, arrow_error.message);
+    } else if (values.release != nullptr && AdbcStatementBind(&statement, &values, &schema, &adbc_error) != ADBC_STATUS_OK) {
+        error = nif_error_from_adbc_error(env, &adbc_error);
+    } else if (AdbcStatementExecuteQuery(&statement, nullptr, &rows_affected, &adbc_error) != ADBC_STATUS_OK) {
+        error = nif_error_from_adbc_error(env, &adbc_error);
+    } else {
+        failed = false;
+    }
+
+    if (values.release) values.release(&values);
+    if (schema.release) schema.release(&schema);
+    struct AdbcError release_error{};
+    AdbcStatementRelease(&statement, &release_error);
+    if (release_error.release) release_error.release(&release_error);
+    return failed ? 1 : 0;
+}
+
+// Executes each `{query, params}` of `argv[1]` in turn, each with its own
+// statement, without result sets, in a single call. Returns
+// `{:ok, rows_affected}`, a list with the rows affected by each query, or
+// -1 where the driver does not report it. When `argv[2]` is true, the
+// queries run between `BEGIN` and `COMMIT`, and `ROLLBACK` is run instead
+// once one fails. Otherwise queries executed before an error are kept.
+static ERL_NIF_TERM adbc_connection_execute_batch(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using res_type = NifRes<struct AdbcConnection>;
+
+    ERL_NIF_TERM error{};
+    res_type * connection = nullptr;
+    if ((connection = res_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    unsigned n_queries = 0;
+    if (!enif_get_list_length(env, argv[1], &n_queries)) {
+        return enif_make_badarg(env);
+    }
+    bool transaction = enif_is_identical(argv[2], kAtomTrue);
+
+    // the whole batch is checked before anything runs
+    std::vector<std::pair<std::string, ERL_NIF_TERM>> queries;
+    queries.reserve(n_queries);
+    ERL_NIF_TERM head, tail = argv[1];
+    while (enif_get_list_cell(env, tail, &head, &tail)) {
+        const ERL_NIF_TERM * pair = nullptr;
+        int arity = 0;
+        std::string query;
+        if (!enif_get_tuple(env, head, &arity, &pair) || arity != 2 ||
+            !erlang::nif::get(env, pair[0], query) || !enif_is_list(env, pair[1])) {
+            return enif_make_badarg(env);
+        }
+        queries.emplace_back(std::move(query), pair[1]);
+    }
+
+    ERL_NIF_TERM empty = enif_make_list(env, 0);
+    int64_t ignored = 0;
+    if (transaction && adbc_connection_execute_one(env, &connection->val, "BEGIN", empty, ignored, error) != 0) {
+        return error;
+    }
+
+    std::vector<ERL_NIF_TERM> counts;
+    counts.reserve(n_queries);
+    for (const auto &query : queries) {
+        int64_t rows_affected = -1;
+        if (adbc_connection_execute_one(env, &connection->val, query.first, query.second, rows_affected, error) != 0) {
+            if (transaction) {
+                ERL_NIF_TERM rollback_error{};
+                adbc_connection_execute_one(env, &connection->val, "ROLLBACK", empty, ignored, rollback_error);
+            }
+            return error;
+        }
+        counts.push_back(enif_make_int64(env, rows_affected));
+    }
+
+    if (transaction && adbc_connection_execute_one(env, &connection->val, "COMMIT", empty, ignored, error) != 0) {
+        return error;
+    }
+
+    return erlang::nif::ok(env, enif_make_list_from_array(env, counts.data(), static_cast<unsigned>(counts.size())));
+}
+
 static ERL_NIF_TERM adbc_statement_bind_stream(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    AdbcCallScope scope(adbc_call_stats.bind);
     using res_type = NifRes<struct AdbcStatement>;
     using array_stream_type = NifRes<struct ArrowArrayStream>;
 
@@ -735,6 +3553,9 @@ static ERL_NIF_TERM adbc_statement_bind_stream(ErlNifEnv *env, int argc, const E
     if ((stream = array_stream_type::get_resource(env, argv[1], error)) == nullptr) {
         return error;
     }
+    if (stream->val.release == nullptr) {
+        return erlang::nif::error(env, "ArrowArrayStream has already been released");
+    }
     struct AdbcError adbc_error{};
     AdbcStatusCode code = AdbcStatementBindStream(&statement->val, &stream->val, &adbc_error);
     if (code != ADBC_STATUS_OK) {
@@ -744,7 +3565,276 @@ static ERL_NIF_TERM adbc_statement_bind_stream(ErlNifEnv *env, int argc, const E
     return erlang::nif::ok(env);
 }
 
-static int on_load(ErlNifEnv *env, void **, ERL_NIF_TERM) {
+// Creates an ArrowArrayStream of the batches pushed by the calling process
+// with `adbc_ingest_stream_push`, starting with `first_batch`, a list of
+// columns, with up to `capacity` batches ahead of the driver. Each
+// `{:adbc_ingest_next, tag}` sent to the calling process asks it for one
+// more batch.
+//
+// Returns `{:ok, producer, stream}`.
+static ERL_NIF_TERM adbc_ingest_stream_new(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using producer_type = NifRes<IngestStreamProducer>;
+
+    ERL_NIF_TERM error{};
+
+    uint64_t capacity = 0;
+    if (!enif_is_list(env, argv[0]) || !erlang::nif::get(env, argv[2], &capacity) || capacity == 0) {
+        return enif_make_badarg(env);
+    }
+
+    struct ArrowArray first{};
+    struct ArrowSchema schema{};
+    struct ArrowError arrow_error{};
+    if (adbc_column_to_arrow_type_struct(env, argv[0], &first, &schema, &arrow_error)) {
+        if (first.release) first.release(&first);
+        if (schema.release) schema.release(&schema);
+        return erlang::nif::error(env, arrow_error.message);
+    }
+
+    auto array_stream = allocate_arrow_array_stream(env, error);
+    if (array_stream == nullptr) {
+        first.release(&first);
+        schema.release(&schema);
+        return error;
+    }
+
+    auto producer = producer_type::allocate_resource(env, error);
+    if (producer == nullptr) {
+        first.release(&first);
+        schema.release(&schema);
+        enif_release_resource(array_stream);
+        return error;
+    }
+
+    ErlNifPid self;
+    enif_self(env, &self);
+    producer->val.stream = ingest_stream_init(&array_stream->val, &schema, &first, self, argv[1], (size_t)capacity);
+
+    ERL_NIF_TERM ret = enif_make_tuple3(env,
+        erlang::nif::ok(env),
+        producer->make_resource(env),
+        array_stream->make_resource(env)
+    );
+    enif_release_resource(producer);
+    enif_release_resource(array_stream);
+    return ret;
+}
+
+// Answers a request of an ingest stream with a list of columns, `:done`
+// or `{:error, reason}`. `:done` and errors may be pushed at any time.
+static ERL_NIF_TERM adbc_ingest_stream_push(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    using producer_type = NifRes<IngestStreamProducer>;
+
+    ERL_NIF_TERM error{};
+
+    producer_type * producer = nullptr;
+    if ((producer = producer_type::get_resource(env, argv[0], error)) == nullptr) {
+        return error;
+    }
+
+    std::string reason, push_error;
+    int arity;
+    const ERL_NIF_TERM * tuple;
+    if (enif_is_identical(argv[1], erlang::nif::atom(env, "done"))) {
+        ingest_stream_push(producer->val.stream, IngestStreamPush::kDone, nullptr, nullptr, reason, push_error);
+        return erlang::nif::ok(env);
+    }
+
+    if (enif_get_tuple(env, argv[1], &arity, &tuple) && arity == 2 &&
+        enif_is_identical(tuple[0], erlang::nif::atom(env, "error"))) {
+        if (!erlang::nif::get(env, tuple[1], reason)) {
+            return enif_make_badarg(env);
+        }
+        ingest_stream_push(producer->val.stream, IngestStreamPush::kError, nullptr, nullptr, reason, push_error);
+        return erlang::nif::ok(env);
+    }
+
+    if (!enif_is_list(env, argv[1])) {
+        return enif_make_badarg(env);
+    }
+
+    // converted before taking the lock, the consumer only waits on the handoff
+    struct ArrowArray batch{};
+    struct ArrowSchema schema{};
+    struct ArrowError arrow_error{};
+    if (adbc_column_to_arrow_type_struct(env, argv[1], &batch, &schema, &arrow_error)) {
+        if (batch.release) batch.release(&batch);
+        if (schema.release) schema.release(&schema);
+        return erlang::nif::error(env, arrow_error.message);
+    }
+
+    int code = ingest_stream_push(producer->val.stream, IngestStreamPush::kBatch, &schema, &batch, reason, push_error);
+    schema.release(&schema);
+    if (code != 0) {
+        return erlang::nif::error(env, push_error.c_str());
+    }
+    return erlang::nif::ok(env);
+}
+
+// Returns the counters of `adbc_memory_stats` as a map.
+static ERL_NIF_TERM memory_stats(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    ERL_NIF_TERM keys[] = {
+        erlang::nif::atom(env, "bind_bytes"),
+        erlang::nif::atom(env, "retained_batches"),
+        erlang::nif::atom(env, "retained_batch_bytes"),
+        erlang::nif::atom(env, "retained_schemas"),
+        erlang::nif::atom(env, "live_streams"),
+        erlang::nif::atom(env, "live_stream_bytes"),
+        erlang::nif::atom(env, "cached_results"),
+        erlang::nif::atom(env, "cached_result_bytes"),
+        erlang::nif::atom(env, "shared_results"),
+        erlang::nif::atom(env, "shared_result_bytes"),
+        erlang::nif::atom(env, "spilled_results"),
+        erlang::nif::atom(env, "spilled_bytes"),
+        erlang::nif::atom(env, "mapped_files"),
+        erlang::nif::atom(env, "mapped_file_bytes"),
+        erlang::nif::atom(env, "pooled_bytes"),
+    };
+    ERL_NIF_TERM values[] = {
+        enif_make_int64(env, adbc_memory_stats.bind_bytes.load()),
+        enif_make_int64(env, adbc_memory_stats.retained_batches.load()),
+        enif_make_int64(env, adbc_memory_stats.retained_batch_bytes.load()),
+        enif_make_int64(env, adbc_memory_stats.retained_schemas.load()),
+        enif_make_int64(env, adbc_memory_stats.live_streams.load()),
+        enif_make_int64(env, adbc_memory_stats.live_stream_bytes.load()),
+        enif_make_int64(env, adbc_memory_stats.cached_results.load()),
+        enif_make_int64(env, adbc_memory_stats.cached_result_bytes.load()),
+        enif_make_int64(env, adbc_memory_stats.shared_results.load()),
+        enif_make_int64(env, adbc_memory_stats.shared_result_bytes.load()),
+        enif_make_int64(env, adbc_memory_stats.spilled_results.load()),
+        enif_make_int64(env, adbc_memory_stats.spilled_bytes.load()),
+        enif_make_int64(env, adbc_memory_stats.mapped_files.load()),
+        enif_make_int64(env, adbc_memory_stats.mapped_file_bytes.load()),
+        enif_make_int64(env, adbc_memory_stats.pooled_bytes.load()),
+    };
+
+    ERL_NIF_TERM stats;
+    enif_make_map_from_arrays(env, keys, values, sizeof(keys)/sizeof(keys[0]), &stats);
+    return stats;
+}
+
+// Returns the stats of the worker pool as a map.
+static ERL_NIF_TERM worker_pool_stats(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    WorkerPoolStats pool = get_worker_pool().stats();
+
+    std::vector<ERL_NIF_TERM> depths;
+    depths.reserve(pool.queue_depths.size());
+    for (size_t depth : pool.queue_depths) {
+        depths.push_back(enif_make_uint64(env, depth));
+    }
+
+    ERL_NIF_TERM keys[] = {
+        erlang::nif::atom(env, "threads"),
+        erlang::nif::atom(env, "affinity"),
+        erlang::nif::atom(env, "queue_depths"),
+        erlang::nif::atom(env, "busy_threads"),
+        erlang::nif::atom(env, "submitted"),
+        erlang::nif::atom(env, "completed"),
+        erlang::nif::atom(env, "stolen"),
+        erlang::nif::atom(env, "busy_time"),
+        erlang::nif::atom(env, "uptime"),
+        erlang::nif::atom(env, "blocking_threads"),
+        erlang::nif::atom(env, "blocking_busy_threads"),
+        erlang::nif::atom(env, "blocking_submitted"),
+    };
+    ERL_NIF_TERM values[] = {
+        enif_make_uint64(env, pool.threads),
+        erlang::nif::atom(env, pool.affinity ? "true" : "false"),
+        enif_make_list_from_array(env, depths.data(), (unsigned)depths.size()),
+        enif_make_uint64(env, pool.busy_threads),
+        enif_make_uint64(env, pool.submitted),
+        enif_make_uint64(env, pool.completed),
+        enif_make_uint64(env, pool.stolen),
+        enif_make_uint64(env, pool.busy_time),
+        enif_make_uint64(env, pool.uptime),
+        enif_make_uint64(env, pool.blocking_threads),
+        enif_make_uint64(env, pool.blocking_busy_threads),
+        enif_make_uint64(env, pool.blocking_submitted),
+    };
+
+    ERL_NIF_TERM stats;
+    enif_make_map_from_arrays(env, keys, values, sizeof(keys)/sizeof(keys[0]), &stats);
+    return stats;
+}
+
+static ERL_NIF_TERM call_stats_to_nif_term(ErlNifEnv *env, const AdbcCallStats &stats) {
+    ERL_NIF_TERM buckets[kCallStatsBuckets];
+    for (int i = 0; i < kCallStatsBuckets; i++) {
+        buckets[i] = enif_make_uint64(env, stats.buckets[i].load(std::memory_order_relaxed));
+    }
+
+    ERL_NIF_TERM keys[] = {
+        erlang::nif::atom(env, "calls"),
+        erlang::nif::atom(env, "in_flight"),
+        erlang::nif::atom(env, "total_time"),
+        erlang::nif::atom(env, "buckets"),
+    };
+    ERL_NIF_TERM values[] = {
+        enif_make_uint64(env, stats.calls.load(std::memory_order_relaxed)),
+        enif_make_int64(env, stats.in_flight.load(std::memory_order_relaxed)),
+        enif_make_uint64(env, stats.total_time.load(std::memory_order_relaxed)),
+        enif_make_list_from_array(env, buckets, kCallStatsBuckets),
+    };
+
+    ERL_NIF_TERM out;
+    enif_make_map_from_arrays(env, keys, values, sizeof(keys)/sizeof(keys[0]), &out);
+    return out;
+}
+
+// Returns the stats of `adbc_call_stats` as a map of the stats of each
+// kind of call.
+static ERL_NIF_TERM call_stats(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    ERL_NIF_TERM keys[] = {
+        erlang::nif::atom(env, "execute_query"),
+        erlang::nif::atom(env, "stream_next"),
+        erlang::nif::atom(env, "bind"),
+        erlang::nif::atom(env, "get_objects"),
+    };
+    ERL_NIF_TERM values[] = {
+        call_stats_to_nif_term(env, adbc_call_stats.execute_query),
+        call_stats_to_nif_term(env, adbc_call_stats.stream_next),
+        call_stats_to_nif_term(env, adbc_call_stats.bind),
+        call_stats_to_nif_term(env, adbc_call_stats.get_objects),
+    };
+
+    ERL_NIF_TERM out;
+    enif_make_map_from_arrays(env, keys, values, sizeof(keys)/sizeof(keys[0]), &out);
+    return out;
+}
+
+// Resets the counters and histograms of `adbc_call_stats`.
+static ERL_NIF_TERM reset_call_stats(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    adbc_call_stats.execute_query.reset();
+    adbc_call_stats.stream_next.reset();
+    adbc_call_stats.bind.reset();
+    adbc_call_stats.get_objects.reset();
+    return erlang::nif::ok(env);
+}
+
+// Starts the worker pool and sizes the result cache as given by the
+// `:worker_threads`, `:worker_affinity` and `:result_cache_bytes` keys of
+// the load info map, see `Adbc.Nif.load_nif/0`.
+static void on_load_config(ErlNifEnv *env, ERL_NIF_TERM load_info) {
+    unsigned threads = 0;
+    bool affinity = false;
+    ERL_NIF_TERM value;
+    if (enif_is_map(env, load_info)) {
+        if (enif_get_map_value(env, load_info, erlang::nif::atom(env, "worker_threads"), &value)) {
+            enif_get_uint(env, value, &threads);
+        }
+        if (enif_get_map_value(env, load_info, erlang::nif::atom(env, "worker_affinity"), &value)) {
+            affinity = enif_is_identical(value, erlang::nif::atom(env, "true"));
+        }
+        int64_t cache_bytes = 0;
+        if (enif_get_map_value(env, load_info, erlang::nif::atom(env, "result_cache_bytes"), &value) &&
+            erlang::nif::get(env, value, &cache_bytes) && cache_bytes >= 0) {
+            adbc_result_cache.set_max_bytes(cache_bytes);
+        }
+    }
+    init_worker_pool(threads, affinity);
+}
+
+static int on_load(ErlNifEnv *env, void **, ERL_NIF_TERM load_info) {
     ErlNifResourceType *rt;
 
     {
@@ -777,73 +3867,45 @@ static int on_load(ErlNifEnv *env, void **, ERL_NIF_TERM) {
 
     {
         using res_type = NifRes<struct ArrowArrayStream>;
-        rt = enif_open_resource_type(env, "Elixir.Adbc.Nif", "NifResArrowArrayStream", destruct_adbc_arrow_array_stream, ERL_NIF_RT_CREATE, NULL);
+        // streams monitor the process reading them, see `adbc_arrow_array_stream_set_owner`
+        ErlNifResourceTypeInit init{};
+        init.dtor = destruct_adbc_arrow_array_stream;
+        init.down = down_adbc_arrow_array_stream;
+        rt = enif_open_resource_type_x(env, "NifResArrowArrayStream", &init, ERL_NIF_RT_CREATE, NULL);
+        if (!rt) return -1;
+        res_type::type = rt;
+    }
+
+    {
+        using res_type = NifRes<struct ArrowArray>;
+        rt = enif_open_resource_type(env, "Elixir.Adbc.Nif", "NifResArrowArray", destruct_arrow_array, ERL_NIF_RT_CREATE, NULL);
+        if (!rt) return -1;
+        res_type::type = rt;
+    }
+
+    {
+        using res_type = NifRes<ArrowColumnReference>;
+        rt = enif_open_resource_type(env, "Elixir.Adbc.Nif", "NifResArrowColumnReference", destruct_arrow_column_reference, ERL_NIF_RT_CREATE, NULL);
+        if (!rt) return -1;
+        res_type::type = rt;
+    }
+
+    {
+        using res_type = NifRes<IngestStreamProducer>;
+        rt = enif_open_resource_type(env, "Elixir.Adbc.Nif", "NifResIngestStreamProducer", destruct_ingest_stream_producer, ERL_NIF_RT_CREATE, NULL);
+        if (!rt) return -1;
+        res_type::type = rt;
+    }
+
+    {
+        using res_type = NifRes<SharedResultHandle>;
+        rt = enif_open_resource_type(env, "Elixir.Adbc.Nif", "NifResSharedResultHandle", destruct_shared_result_handle, ERL_NIF_RT_CREATE, NULL);
         if (!rt) return -1;
         res_type::type = rt;
     }
 
-    kAtomAdbcError = erlang::nif::atom(env, "adbc_error");
-    kAtomNil = erlang::nif::atom(env, "nil");
-    kAtomTrue = erlang::nif::atom(env, "true");
-    kAtomFalse = erlang::nif::atom(env, "false");
-    kAtomEndOfSeries = erlang::nif::atom(env, "end_of_series");
-    kAtomStructKey = erlang::nif::atom(env, "__struct__");
-    kAtomTime32 = erlang::nif::atom(env, "time32");
-    kAtomTime64 = erlang::nif::atom(env, "time64");
-    kAtomSeconds = erlang::nif::atom(env, "seconds");
-    kAtomMilliseconds = erlang::nif::atom(env, "milliseconds");
-    kAtomMicroseconds = erlang::nif::atom(env, "microseconds");
-    kAtomNanoseconds = erlang::nif::atom(env, "nanoseconds");
-    kAtomTimestamp = erlang::nif::atom(env, "timestamp");
-
-    kAtomCalendarKey = erlang::nif::atom(env, "calendar");
-    kAtomCalendarISO = erlang::nif::atom(env, "Elixir.Calendar.ISO");
-
-    kAtomDateModule = erlang::nif::atom(env, "Elixir.Date");
-    kAtomYearKey = erlang::nif::atom(env, "year");
-    kAtomMonthKey = erlang::nif::atom(env, "month");
-    kAtomDayKey = erlang::nif::atom(env, "day");
-
-    kAtomNaiveDateTimeModule = erlang::nif::atom(env, "Elixir.NaiveDateTime");
-    kAtomTimeModule = erlang::nif::atom(env, "Elixir.Time");
-    kAtomHourKey = erlang::nif::atom(env, "hour");
-    kAtomMinuteKey = erlang::nif::atom(env, "minute");
-    kAtomSecondKey = erlang::nif::atom(env, "second");
-    kAtomMicrosecondKey = erlang::nif::atom(env, "microsecond");
-
-    kAtomAdbcColumnModule = erlang::nif::atom(env, "Elixir.Adbc.Column");
-    kAtomNameKey = erlang::nif::atom(env, "name");
-    kAtomTypeKey = erlang::nif::atom(env, "type");
-    kAtomNullableKey = erlang::nif::atom(env, "nullable");
-    kAtomMetadataKey = erlang::nif::atom(env, "metadata");
-    kAtomDataKey = erlang::nif::atom(env, "data");
-    // kAdbcBufferPrivateKey = enif_make_atom(env, "__private__");
-
-    kAdbcColumnTypeU8 = erlang::nif::atom(env, "u8");
-    kAdbcColumnTypeU16 = erlang::nif::atom(env, "u16");
-    kAdbcColumnTypeU32 = erlang::nif::atom(env, "u32");
-    kAdbcColumnTypeU64 = erlang::nif::atom(env, "u64");
-    kAdbcColumnTypeI8 = erlang::nif::atom(env, "i8");
-    kAdbcColumnTypeI16 = erlang::nif::atom(env, "i16");
-    kAdbcColumnTypeI32 = erlang::nif::atom(env, "i32");
-    kAdbcColumnTypeI64 = erlang::nif::atom(env, "i64");
-    kAdbcColumnTypeF32 = erlang::nif::atom(env, "f32");
-    kAdbcColumnTypeF64 = erlang::nif::atom(env, "f64");
-    kAdbcColumnTypeStruct = erlang::nif::atom(env, "struct");
-    kAdbcColumnTypeMap = erlang::nif::atom(env, "map");
-    kAdbcColumnTypeList = erlang::nif::atom(env, "list");
-    kAdbcColumnTypeLargeList = erlang::nif::atom(env, "large_list");
-    kAdbcColumnTypeFixedSizeList = erlang::nif::atom(env, "fixed_size_list");
-    kAdbcColumnTypeString = erlang::nif::atom(env, "string");
-    kAdbcColumnTypeLargeString = erlang::nif::atom(env, "large_string");
-    kAdbcColumnTypeBinary = erlang::nif::atom(env, "binary");
-    kAdbcColumnTypeLargeBinary = erlang::nif::atom(env, "large_binary");
-    kAdbcColumnTypeFixedSizeBinary = erlang::nif::atom(env, "fixed_size_binary");
-    kAdbcColumnTypeDenseUnion = erlang::nif::atom(env, "dense_union");
-    kAdbcColumnTypeSparseUnion = erlang::nif::atom(env, "sparse_union");
-    kAdbcColumnTypeDate32 = erlang::nif::atom(env, "date32");
-    kAdbcColumnTypeDate64 = erlang::nif::atom(env, "date64");
-    kAdbcColumnTypeBool = erlang::nif::atom(env, "boolean");
+    adbc_consts_init(env);
+    on_load_config(env, load_info);
 
     return 0;
 }
@@ -856,32 +3918,97 @@ static int on_upgrade(ErlNifEnv *, void **, void **, ERL_NIF_TERM) {
     return 0;
 }
 
+// Calls that may block on the network or disk (or run for a long time) are
+// also registered as `*_dirty_io` variants, the Elixir side picks one of them
+// based on the `:scheduler` option of the database.
 static ErlNifFunc nif_functions[] = {
     {"adbc_database_new", 0, adbc_database_new, 0},
     {"adbc_database_get_option", 3, adbc_database_get_option, 0},
     {"adbc_database_set_option", 4, adbc_database_set_option, 0},
+    {"adbc_database_set_driver", 3, adbc_database_set_driver, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_driver_preload", 2, adbc_driver_preload, ERL_NIF_DIRTY_JOB_IO_BOUND},
     {"adbc_database_init", 1, adbc_database_init, 0},
+    {"adbc_database_init_dirty_io", 1, adbc_database_init, ERL_NIF_DIRTY_JOB_IO_BOUND},
 
     {"adbc_connection_new", 0, adbc_connection_new, 0},
     {"adbc_connection_get_option", 3, adbc_connection_get_option, 0},
     {"adbc_connection_set_option", 4, adbc_connection_set_option, 0},
     {"adbc_connection_init", 2, adbc_connection_init, 0},
+    {"adbc_connection_init_dirty_io", 2, adbc_connection_init, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_connection_release", 1, adbc_connection_release, 0},
     {"adbc_connection_get_info", 2, adbc_connection_get_info, 0},
+    {"adbc_connection_get_info_dirty_io", 2, adbc_connection_get_info, ERL_NIF_DIRTY_JOB_IO_BOUND},
     {"adbc_connection_get_objects", 7, adbc_connection_get_objects, 0},
+    {"adbc_connection_get_objects_dirty_io", 7, adbc_connection_get_objects, ERL_NIF_DIRTY_JOB_IO_BOUND},
     {"adbc_connection_get_table_types", 1, adbc_connection_get_table_types, 0},
+    {"adbc_connection_get_table_types_dirty_io", 1, adbc_connection_get_table_types, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_connection_get_statistics", 5, adbc_connection_get_statistics, 0},
+    {"adbc_connection_get_statistics_dirty_io", 5, adbc_connection_get_statistics, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_connection_get_statistic_names", 1, adbc_connection_get_statistic_names, 0},
+    {"adbc_connection_get_statistic_names_dirty_io", 1, adbc_connection_get_statistic_names, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_connection_read_partition", 2, adbc_connection_read_partition, 0},
+    {"adbc_connection_read_partition_dirty_io", 2, adbc_connection_read_partition, ERL_NIF_DIRTY_JOB_IO_BOUND},
 
     {"adbc_statement_new", 1, adbc_statement_new, 0},
     {"adbc_statement_get_option", 3, adbc_statement_get_option, 0},
     {"adbc_statement_set_option", 4, adbc_statement_set_option, 0},
     {"adbc_statement_execute_query", 1, adbc_statement_execute_query, 0},
+    {"adbc_statement_execute_query_async", 2, adbc_statement_execute_query_async, 0},
+    {"adbc_statement_execute_update_async", 2, adbc_statement_execute_update_async, 0},
     {"adbc_statement_prepare", 1, adbc_statement_prepare, 0},
+    {"adbc_statement_prepare_dirty_io", 1, adbc_statement_prepare, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_statement_cancel", 1, adbc_statement_cancel, 0},
     {"adbc_statement_set_sql_query", 2, adbc_statement_set_sql_query, 0},
-    {"adbc_statement_bind", 2, adbc_statement_bind, 0},
+    {"adbc_statement_bind", 3, adbc_statement_bind, 0},
     {"adbc_statement_bind_stream", 2, adbc_statement_bind_stream, 0},
+    {"adbc_statement_execute_many", 2, adbc_statement_execute_many, 0},
+    {"adbc_statement_execute_many_dirty_io", 2, adbc_statement_execute_many, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_connection_execute_batch", 3, adbc_connection_execute_batch, 0},
+    {"adbc_connection_execute_batch_dirty_io", 3, adbc_connection_execute_batch, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_statement_execute_partitions", 1, adbc_statement_execute_partitions, 0},
+    {"adbc_statement_execute_partitions_dirty_io", 1, adbc_statement_execute_partitions, ERL_NIF_DIRTY_JOB_IO_BOUND},
 
     {"adbc_arrow_array_stream_get_pointer", 1, adbc_arrow_array_stream_get_pointer, 0},
     {"adbc_arrow_array_stream_next", 1, adbc_arrow_array_stream_next, 0},
-    {"adbc_arrow_array_stream_release", 1, adbc_arrow_array_stream_release, 0}
+    {"adbc_arrow_array_stream_next_dirty_io", 1, adbc_arrow_array_stream_next, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_arrow_array_stream_prefetch", 3, adbc_arrow_array_stream_prefetch, 0},
+    {"adbc_arrow_array_stream_set_prefetch", 2, adbc_arrow_array_stream_set_prefetch, 0},
+    {"adbc_arrow_array_stream_coalesce", 4, adbc_arrow_array_stream_coalesce, 0},
+    {"adbc_arrow_array_stream_cache", 4, adbc_arrow_array_stream_cache, 0},
+    {"adbc_arrow_array_stream_stats", 1, adbc_arrow_array_stream_stats, 0},
+    {"adbc_arrow_array_stream_batch_stats", 1, adbc_arrow_array_stream_batch_stats, 0},
+    {"adbc_arrow_array_stream_set_option", 3, adbc_arrow_array_stream_set_option, 0},
+    {"adbc_arrow_array_stream_set_limits", 4, adbc_arrow_array_stream_set_limits, 0},
+    {"adbc_column_materialize", 3, adbc_column_materialize, ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {"adbc_column_concat", 1, adbc_column_concat, ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {"adbc_arrow_array_stream_encode", 1, adbc_arrow_array_stream_encode, 0},
+    {"adbc_arrow_array_stream_encode_dirty_io", 1, adbc_arrow_array_stream_encode, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_arrow_array_stream_decode", 1, adbc_arrow_array_stream_decode, ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {"adbc_arrow_ipc_file_open", 1, adbc_arrow_ipc_file_open, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_arrow_array_stream_move", 1, adbc_arrow_array_stream_move, 0},
+    {"adbc_arrow_array_stream_release", 1, adbc_arrow_array_stream_release, 0},
+    {"adbc_arrow_array_stream_set_owner", 3, adbc_arrow_array_stream_set_owner, 0},
+
+    {"adbc_ingest_stream_new", 3, adbc_ingest_stream_new, 0},
+    {"adbc_ingest_stream_push", 2, adbc_ingest_stream_push, 0},
+
+    {"adbc_result_cache_fetch", 1, adbc_result_cache_fetch, 0},
+    {"adbc_result_cache_clear", 0, adbc_result_cache_clear, 0},
+    {"adbc_result_cache_evict", 1, adbc_result_cache_evict, 0},
+    {"adbc_arrow_array_stream_share", 1, adbc_arrow_array_stream_share, 0},
+    {"adbc_arrow_array_stream_share_dirty_io", 1, adbc_arrow_array_stream_share, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_arrow_array_stream_spill", 2, adbc_arrow_array_stream_spill, 0},
+    {"adbc_arrow_array_stream_spill_dirty_io", 2, adbc_arrow_array_stream_spill, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_arrow_array_stream_to_matrix", 5, adbc_arrow_array_stream_to_matrix, 0},
+    {"adbc_arrow_array_stream_to_matrix_dirty_io", 5, adbc_arrow_array_stream_to_matrix, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_arrow_array_stream_statistics", 1, adbc_arrow_array_stream_statistics, ERL_NIF_DIRTY_JOB_IO_BOUND},
+    {"adbc_shared_result_stream", 4, adbc_shared_result_stream, 0},
+    {"adbc_shared_result_select", 3, adbc_shared_result_select, ERL_NIF_DIRTY_JOB_CPU_BOUND},
+
+    {"memory_stats", 0, memory_stats, 0},
+    {"worker_pool_stats", 0, worker_pool_stats, 0},
+    {"call_stats", 0, call_stats, 0},
+    {"reset_call_stats", 0, reset_call_stats, 0}
 };
 
 ERL_NIF_INIT(Elixir.Adbc.Nif, nif_functions, on_load, on_reload, on_upgrade, NULL);
@@ -0,0 +1,246 @@
+// Micro-benchmarks of the conversions between Arrow arrays and terms,
+// built as the `adbc_nif_bench` NIF library with `-DADBC_NIF_BENCH=ON`
+// and driven by `bench/nif.exs`.
+//
+// Each benchmark builds a record batch of a single synthetic column with
+// nanoarrow and converts it a number of times in a fresh environment, so
+// the measured time does not include building the batch.
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <adbc.h>
+#include <erl_nif.h>
+#include <nanoarrow/nanoarrow.h>
+#include "adbc_nif_resource.hpp"
+#include "nif_utils.hpp"
+#include "adbc_consts.h"
+#include "adbc_column.hpp"
+#include "adbc_arrow_array.hpp"
+#include "adbc_memory.hpp"
+
+template<> ErlNifResourceType * NifRes<struct ArrowArray>::type = nullptr;
+template<> ErlNifResourceType * NifRes<ArrowColumnReference>::type = nullptr;
+
+// Whether the next value is null, for nulls spread evenly over the batch
+// with the given density.
+struct NullPattern {
+    double density;
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+
+    bool next() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (double)(state >> 11) / (double)(1ULL << 53) < density;
+    }
+};
+
+static const char * kBenchStrings[] = {"", "a", "adbc", "arrow database connectivity", "elixir"};
+
+static ArrowErrorCode bench_append_value(struct ArrowArray * array, const std::string &kind, int64_t i) {
+    if (kind == "i64" || kind == "timestamp") {
+        return ArrowArrayAppendInt(array, i * 1000003);
+    } else if (kind == "f64") {
+        return ArrowArrayAppendDouble(array, (double)i / 7.0);
+    } else if (kind == "string") {
+        return ArrowArrayAppendString(array, ArrowCharView(kBenchStrings[i % 5]));
+    } else if (kind == "list") {
+        for (int64_t j = 0; j < 4; j++) {
+            NANOARROW_RETURN_NOT_OK(ArrowArrayAppendInt(array->children[0], i + j));
+        }
+        return ArrowArrayFinishElement(array);
+    } else if (kind == "struct") {
+        NANOARROW_RETURN_NOT_OK(ArrowArrayAppendInt(array->children[0], i));
+        NANOARROW_RETURN_NOT_OK(ArrowArrayAppendString(array->children[1], ArrowCharView(kBenchStrings[i % 5])));
+        return ArrowArrayFinishElement(array);
+    } else if (kind == "map") {
+        struct ArrowArray * entries = array->children[0];
+        for (int64_t j = 0; j < 2; j++) {
+            NANOARROW_RETURN_NOT_OK(ArrowArrayAppendString(entries->children[0], ArrowCharView(kBenchStrings[(i + j) % 5])));
+            NANOARROW_RETURN_NOT_OK(ArrowArrayAppendInt(entries->children[1], i + j));
+            NANOARROW_RETURN_NOT_OK(ArrowArrayFinishElement(entries));
+        }
+        return ArrowArrayFinishElement(array);
+    } else if (kind == "dense_union") {
+        int8_t type_id = (int8_t)(i % 2);
+        if (type_id == 0) {
+            NANOARROW_RETURN_NOT_OK(ArrowArrayAppendInt(array->children[0], i));
+        } else {
+            NANOARROW_RETURN_NOT_OK(ArrowArrayAppendString(array->children[1], ArrowCharView(kBenchStrings[i % 5])));
+        }
+        return ArrowArrayFinishUnionElement(array, type_id);
+    }
+    return EINVAL;
+}
+
+static ArrowErrorCode bench_column_schema(struct ArrowSchema * schema, const std::string &kind) {
+    if (kind == "i64") {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema, NANOARROW_TYPE_INT64));
+    } else if (kind == "f64") {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema, NANOARROW_TYPE_DOUBLE));
+    } else if (kind == "string") {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema, NANOARROW_TYPE_STRING));
+    } else if (kind == "timestamp") {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetTypeDateTime(schema, NANOARROW_TYPE_TIMESTAMP, NANOARROW_TIME_UNIT_MICRO, nullptr));
+    } else if (kind == "list") {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema, NANOARROW_TYPE_LIST));
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema->children[0], NANOARROW_TYPE_INT64));
+    } else if (kind == "struct") {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetTypeStruct(schema, 2));
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema->children[0], NANOARROW_TYPE_INT64));
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema->children[0], "id"));
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema->children[1], NANOARROW_TYPE_STRING));
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema->children[1], "name"));
+    } else if (kind == "map") {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema, NANOARROW_TYPE_MAP));
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema->children[0]->children[0], NANOARROW_TYPE_STRING));
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema->children[0]->children[1], NANOARROW_TYPE_INT64));
+    } else if (kind == "dense_union") {
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetTypeUnion(schema, NANOARROW_TYPE_DENSE_UNION, 2));
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema->children[0], NANOARROW_TYPE_INT64));
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema->children[0], "i"));
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetType(schema->children[1], NANOARROW_TYPE_STRING));
+        NANOARROW_RETURN_NOT_OK(ArrowSchemaSetName(schema->children[1], "s"));
+    } else {
+        return EINVAL;
+    }
+    return ArrowSchemaSetName(schema, "column");
+}
+
+// Builds a record batch with a single column of `kind` and `rows` rows,
+// `null_density` of them null. Unions have no validity and no nulls.
+static ArrowErrorCode bench_batch(const std::string &kind, int64_t rows, double null_density, struct ArrowSchema * schema, struct ArrowArray * array) {
+    ArrowSchemaInit(schema);
+    NANOARROW_RETURN_NOT_OK(ArrowSchemaSetTypeStruct(schema, 1));
+    NANOARROW_RETURN_NOT_OK(bench_column_schema(schema->children[0], kind));
+
+    NANOARROW_RETURN_NOT_OK(ArrowArrayInitFromSchema(array, schema, nullptr));
+    NANOARROW_RETURN_NOT_OK(ArrowArrayStartAppending(array));
+    struct ArrowArray * column = array->children[0];
+    NullPattern nulls{kind == "dense_union" ? 0.0 : null_density};
+    for (int64_t i = 0; i < rows; i++) {
+        if (nulls.next()) {
+            NANOARROW_RETURN_NOT_OK(ArrowArrayAppendNull(column, 1));
+        } else {
+            NANOARROW_RETURN_NOT_OK(bench_append_value(column, kind, i));
+        }
+        NANOARROW_RETURN_NOT_OK(ArrowArrayFinishElement(array));
+    }
+    return ArrowArrayFinishBuildingDefault(array, nullptr);
+}
+
+static bool bench_get_args(ErlNifEnv *env, const ERL_NIF_TERM argv[], std::string &kind, int64_t &rows, double &null_density, int64_t &iterations) {
+    return erlang::nif::get_atom(env, argv[0], kind) &&
+        erlang::nif::get(env, argv[1], &rows) && rows >= 0 &&
+        erlang::nif::get(env, argv[2], &null_density) &&
+        erlang::nif::get(env, argv[3], &iterations) && iterations > 0;
+}
+
+// Converts the batch of `kind`, as `adbc_arrow_array_stream_next` does,
+// `iterations` times. Returns `{:ok, nanoseconds, bytes}`, with the total
+// time and the bytes of the Arrow buffers of the batch.
+static ERL_NIF_TERM bench_arrow_to_term(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    std::string kind;
+    int64_t rows = 0, iterations = 0;
+    double null_density = 0;
+    if (!bench_get_args(env, argv, kind, rows, null_density, iterations)) {
+        return enif_make_badarg(env);
+    }
+
+    struct ArrowSchema schema{};
+    struct ArrowArray array{};
+    if (bench_batch(kind, rows, null_density, &schema, &array) != NANOARROW_OK) {
+        if (array.release) array.release(&array);
+        if (schema.release) schema.release(&schema);
+        return erlang::nif::error(env, "cannot build the batch");
+    }
+    int64_t bytes = adbc_memory_array_bytes(&schema, &array);
+
+    ERL_NIF_TERM ret = erlang::nif::ok(env);
+    int64_t elapsed = 0;
+    for (int64_t i = 0; i < iterations; i++) {
+        ErlNifEnv * work_env = enif_alloc_env();
+        std::vector<ERL_NIF_TERM> out_terms;
+        ERL_NIF_TERM out_type, out_metadata, error;
+        auto started = std::chrono::steady_clock::now();
+        int code = arrow_array_to_nif_term(work_env, &schema, &array, 0, out_terms, out_type, out_metadata, error);
+        elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+        if (code == 1) {
+            ret = enif_make_copy(env, error);
+        }
+        enif_free_env(work_env);
+        if (code == 1) break;
+    }
+
+    array.release(&array);
+    schema.release(&schema);
+    if (!enif_is_identical(ret, erlang::nif::ok(env))) {
+        return ret;
+    }
+    return enif_make_tuple3(env, ret, enif_make_int64(env, elapsed), enif_make_int64(env, bytes));
+}
+
+// Converts the `Adbc.Column` of the batch of `kind` back into an Arrow
+// array, as binding parameters does, `iterations` times. Returns the same
+// as `bench_arrow_to_term/4`.
+static ERL_NIF_TERM bench_term_to_arrow(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+    std::string kind;
+    int64_t rows = 0, iterations = 0;
+    double null_density = 0;
+    if (!bench_get_args(env, argv, kind, rows, null_density, iterations)) {
+        return enif_make_badarg(env);
+    }
+
+    struct ArrowSchema schema{};
+    struct ArrowArray array{};
+    if (bench_batch(kind, rows, null_density, &schema, &array) != NANOARROW_OK) {
+        if (array.release) array.release(&array);
+        if (schema.release) schema.release(&schema);
+        return erlang::nif::error(env, "cannot build the batch");
+    }
+    int64_t bytes = adbc_memory_array_bytes(&schema, &array);
+
+    std::vector<ERL_NIF_TERM> out_terms;
+    ERL_NIF_TERM out_type, out_metadata, error;
+    int code = arrow_array_to_nif_term(env, &schema, &array, 0, out_terms, out_type, out_metadata, error);
+    array.release(&array);
+    schema.release(&schema);
+    ERL_NIF_TERM column;
+    if (code == 1) {
+        return error;
+    }
+    if (out_terms.size() != 1 || !enif_get_list_cell(env, out_terms[0], &column, &error)) {
+        return erlang::nif::error(env, "unexpected conversion of the batch");
+    }
+
+    int64_t elapsed = 0;
+    for (int64_t i = 0; i < iterations; i++) {
+        struct ArrowArray column_array{};
+        struct ArrowSchema column_schema{};
+        struct ArrowArray lazy{};
+        struct ArrowError arrow_error{};
+        auto started = std::chrono::steady_clock::now();
+        code = adbc_column_to_adbc_field(env, column, &column_array, &column_schema, &lazy, &arrow_error);
+        elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+        if (column_array.release) column_array.release(&column_array);
+        if (column_schema.release) column_schema.release(&column_schema);
+        if (lazy.release) lazy.release(&lazy);
+        if (code != 0) {
+            return erlang::nif::error(env, arrow_error.message[0] ? arrow_error.message : "cannot convert the column");
+        }
+    }
+
+    return enif_make_tuple3(env, erlang::nif::ok(env), enif_make_int64(env, elapsed), enif_make_int64(env, bytes));
+}
+
+static int on_load(ErlNifEnv *env, void **, ERL_NIF_TERM) {
+    adbc_consts_init(env);
+    return 0;
+}
+
+static ErlNifFunc nif_functions[] = {
+    {"arrow_to_term", 4, bench_arrow_to_term, ERL_NIF_DIRTY_JOB_CPU_BOUND},
+    {"term_to_arrow", 4, bench_term_to_arrow, ERL_NIF_DIRTY_JOB_CPU_BOUND},
+};
+
+ERL_NIF_INIT(Elixir.Adbc.NifBench, nif_functions, on_load, NULL, NULL, NULL);
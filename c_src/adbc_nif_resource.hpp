@@ -5,8 +5,15 @@
 #include <atomic>
 #include <erl_nif.h>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <type_traits>
+#include <vector>
 #include "nif_utils.hpp"
+#include "adbc_consts.h"
+#include "adbc_memory.hpp"
+#include "adbc_parallel_decode.hpp"
+#include "adbc_timezone.hpp"
 
 // Only for debugging:
 #include <cstdio>
@@ -97,6 +104,262 @@ template <typename T> struct NifRes {
   }
 };
 
+/// What is known about a top-level column of a stream once its schema has
+/// been read, so it does not have to be computed again for every batch.
+struct ArrowStreamColumnPlan {
+  // whether the column can be converted a range of rows at a time
+  bool sliceable = false;
+  bool nullable = false;
+  // the byte width of its values if it can be returned as a raw buffer,
+  // 0 otherwise
+  size_t raw_width = 0;
+  // the format of an integer or float column, whose values are read
+  // straight into rows, 0 otherwise
+  char flat_format = 0;
+  // the number of items of a fixed-size list of fixed-width items, whose
+  // rows are returned as binaries by `:vector_columns`, and their byte
+  // width, 0 otherwise
+  int64_t list_size = 0;
+  size_t list_width = 0;
+  // whether it is a string column of PostgreSQL `numeric` values, and the
+  // scale of its decimals once the first batch is read by
+  // `:numeric_columns`, -1 before
+  bool numeric = false;
+  int32_t numeric_scale = -1;
+  // whether it is a string or binary column whose repeated values are
+  // returned as the same term by `:intern_columns`, until it has too many
+  // distinct values
+  bool intern = false;
+  // the zone of a timestamp column with a time zone once
+  // `:datetime_columns` is set, shared by the columns of the same zone
+  std::shared_ptr<const AdbcTimeZone> timezone;
+  // terms living in `ArrowArrayStreamState::env`
+  ERL_NIF_TERM name{};
+  ERL_NIF_TERM metadata{};
+  ERL_NIF_TERM raw_type{};
+  ERL_NIF_TERM list_type{};
+};
+
+/// The shape of the results returned by `adbc_arrow_array_stream_next`.
+enum class ArrowStreamOutput {
+  // a list of `Adbc.Column`
+  kColumns,
+  // a list of rows, each a tuple of the values of the columns
+  kRowsTuples,
+  // a list of rows, each a map of the column names to their values
+  kRowsMaps
+};
+
+/// Kept in the `private_data` of a `NifRes<struct ArrowArrayStream>`.
+///
+/// The schema of a stream is read once, when the state is created, and
+/// compiled into a plan of its top-level columns.
+struct ArrowArrayStreamState {
+  struct ArrowSchema schema{};
+  ErlNifEnv * env = nullptr;
+  std::vector<ArrowStreamColumnPlan> columns;
+  // whether top-level string and binary columns reference the batch
+  // buffers instead of copying them
+  bool zero_copy_binaries = false;
+  // whether fixed-width top-level columns are returned as raw buffers
+  bool raw_columns = false;
+  // whether top-level fixed-size lists of fixed-width items are returned
+  // as a binary per row
+  bool vector_columns = false;
+  // whether top-level columns reference the batch instead of being
+  // converted, see `ArrowColumnReference`
+  bool lazy_columns = false;
+  // whether dictionary-encoded top-level columns are returned as
+  // `{:dictionary, indices, values}` instead of their decoded values
+  bool dictionary_columns = false;
+  // whether PostgreSQL `numeric` top-level columns are returned as
+  // decimals instead of strings
+  bool numeric_columns = false;
+  // whether some top-level columns have `intern` set, and whether their
+  // values naming existing atoms are returned as atoms
+  bool intern_columns = false;
+  bool intern_atoms = false;
+  // whether some top-level columns have a `timezone` and are returned as
+  // `DateTime`s
+  bool datetime_columns = false;
+  // whether batches converted at once are converted a range of columns
+  // per worker, see `arrow_batch_to_columns_parallel`
+  bool parallel_columns = false;
+  ArrowStreamOutput output = ArrowStreamOutput::kColumns;
+  // whether all top-level columns have a `flat_format`, so rows are built
+  // without converting each column to a list first
+  bool flat_rows = false;
+  // limits of the whole result, -1 when unlimited, and what was read so far
+  int64_t max_result_bytes = -1;
+  int64_t max_rows = -1;
+  int64_t result_bytes = 0;
+  int64_t result_rows = 0;
+  // native time spent executing the query of the stream, in nanoseconds
+  int64_t execute_time = 0;
+  // set by the `:stats` option of `adbc_arrow_array_stream_set_option`: the
+  // native time spent in `get_next`, in nanoseconds, and the rows and bytes
+  // of the batches read
+  bool collect_stats = false;
+  int64_t fetch_time = 0;
+  int64_t fetched_rows = 0;
+  int64_t fetched_bytes = 0;
+  // the same stats of the last batch read, with the nulls of each of its
+  // top-level columns
+  int64_t batch_fetch_time = 0;
+  int64_t batch_rows = 0;
+  int64_t batch_bytes = 0;
+  std::vector<int64_t> batch_null_counts;
+  // the statement or the connection the stream comes from, kept alive for
+  // as long as the stream, as drivers require streams to be released
+  // first. The statement is cancelled once a limit is exceeded
+  NifRes<struct AdbcStatement> * statement = nullptr;
+  NifRes<struct AdbcConnection> * connection_resource = nullptr;
+  // set by the `:parallel_batches` option of
+  // `adbc_arrow_array_stream_set_option`: converts the batches on the
+  // worker pool, with the stream read up to its end or first error ahead
+  // of them
+  std::unique_ptr<ParallelDecoder> decoder;
+  bool decoder_done = false;
+  std::string decoder_error;
+  // set by `adbc_arrow_array_stream_set_owner`: the process reading the
+  // stream, monitored natively, and the connection to notify with
+  // `{:adbc_stream_released, owner_tag}` once it is done
+  std::mutex owner_mutex;
+  bool owned = false;
+  ErlNifMonitor owner_monitor;
+  ErlNifPid connection;
+  ERL_NIF_TERM owner_tag{};
+
+  ArrowArrayStreamState() : env(enif_alloc_env()) {}
+  ArrowArrayStreamState(const ArrowArrayStreamState&) = delete;
+  ArrowArrayStreamState& operator=(const ArrowArrayStreamState&) = delete;
+
+  ~ArrowArrayStreamState() {
+    if (schema.release) {
+      adbc_memory_stats.retained_schemas--;
+      schema.release(&schema);
+    }
+    if (env) {
+      enif_free_env(env);
+    }
+    if (statement) {
+      enif_release_resource(statement);
+    }
+    if (connection_resource) {
+      enif_release_resource(connection_resource);
+    }
+  }
+};
+
+/// Returns the state of the stream, creating it without reading its schema.
+static ArrowArrayStreamState * arrow_array_stream_state(NifRes<struct ArrowArrayStream> * res) {
+  if (res->private_data == nullptr) {
+    res->private_data = new ArrowArrayStreamState();
+  }
+  return (ArrowArrayStreamState *)res->private_data;
+}
+
+/// Releases the stream of `res` and, if it has an owner, notifies the
+/// connection that it may run its next query, at most once per owner.
+///
+/// `env` is the environment of the calling NIF or callback. The owner is
+/// demonitored unless `owner_down`.
+static void release_owned_arrow_array_stream(ErlNifEnv * env, NifRes<struct ArrowArrayStream> * res, bool owner_down) {
+  auto state = (ArrowArrayStreamState *)res->private_data;
+  std::unique_lock<std::mutex> lock;
+  if (state != nullptr) {
+    lock = std::unique_lock<std::mutex>(state->owner_mutex);
+  }
+
+  if (res->val.release) {
+    res->val.release(&res->val);
+    res->val.release = nullptr;
+  }
+  if (state == nullptr || !state->owned) {
+    return;
+  }
+
+  state->owned = false;
+  if (!owner_down) {
+    enif_demonitor_process(env, res, &state->owner_monitor);
+  }
+  ErlNifEnv * msg_env = enif_alloc_env();
+  if (msg_env != nullptr) {
+    ERL_NIF_TERM msg = enif_make_tuple2(msg_env, kAtomAdbcStreamReleased, enif_make_copy(msg_env, state->owner_tag));
+    enif_send(env, &state->connection, msg_env, msg);
+    enif_free_env(msg_env);
+  }
+}
+
+static void down_adbc_arrow_array_stream(ErlNifEnv *env, void *obj, ErlNifPid *pid, ErlNifMonitor *mon) {
+  release_owned_arrow_array_stream(env, (NifRes<struct ArrowArrayStream> *)obj, true);
+}
+
+/// A column of a record batch that is converted to Erlang terms only when
+/// requested, kept in a `NifRes<ArrowColumnReference>`.
+///
+/// `values` points into the record batch held by `owner`, which is kept
+/// alive for as long as the reference is.
+struct ArrowColumnReference {
+  struct ArrowSchema schema;
+  struct ArrowArray * values;
+  NifRes<struct ArrowArray> * owner;
+};
+
+// defined in adbc_nif.cpp, declared here as the resource is also used when
+// binding columns
+template<> ErlNifResourceType * NifRes<ArrowColumnReference>::type;
+
+/// The schema a statement was last bound with, shared by the schemas given
+/// to the driver, see `adbc_bind_schema_view`.
+struct AdbcBindSchema {
+  struct ArrowSchema schema{};
+
+  AdbcBindSchema() = default;
+  AdbcBindSchema(const AdbcBindSchema&) = delete;
+  AdbcBindSchema& operator=(const AdbcBindSchema&) = delete;
+
+  ~AdbcBindSchema() {
+    if (schema.release) schema.release(&schema);
+  }
+};
+
+/// Kept in the `private_data` of a `NifRes<struct AdbcStatement>`.
+///
+/// Binding columns of the same types again, as prepared statements are,
+/// reuses the schema of the last bind instead of building it again. It is
+/// keyed by the signature of the parameters, see
+/// `adbc_column_bind_signature`, which lives in `env`.
+struct AdbcStatementState {
+  std::mutex mutex;
+  ErlNifEnv * env = nullptr;
+  ERL_NIF_TERM signature{};
+  std::shared_ptr<AdbcBindSchema> bind_schema;
+
+  AdbcStatementState() : env(enif_alloc_env()) {}
+  AdbcStatementState(const AdbcStatementState&) = delete;
+  AdbcStatementState& operator=(const AdbcStatementState&) = delete;
+
+  ~AdbcStatementState() {
+    enif_free_env(env);
+  }
+};
+
+static void adbc_bind_schema_view_release(struct ArrowSchema * schema) {
+  delete (std::shared_ptr<AdbcBindSchema> *)schema->private_data;
+  schema->private_data = nullptr;
+  schema->release = nullptr;
+}
+
+/// Makes `out` a schema over the same children as `bind_schema`, which is
+/// kept alive until `out` is released, as the driver takes ownership of
+/// the schemas it is bound with.
+static void adbc_bind_schema_view(const std::shared_ptr<AdbcBindSchema> &bind_schema, struct ArrowSchema * out) {
+  *out = bind_schema->schema;
+  out->private_data = new std::shared_ptr<AdbcBindSchema>(bind_schema);
+  out->release = adbc_bind_schema_view_release;
+}
+
 static void destruct_adbc_database_resource(ErlNifEnv *env, void *args) {
   auto res = (NifRes<struct AdbcDatabase> *)args;
   struct AdbcError adbc_error{};
@@ -113,8 +376,8 @@ static void destruct_adbc_connection_resource(ErlNifEnv *env, void *args) {
 static void destruct_adbc_statement_resource(ErlNifEnv *env, void *args) {
   auto res = (NifRes<struct AdbcStatement> *)args;
   struct AdbcError adbc_error{};
-  if(res->private_data != nullptr) enif_release_resource(&res->private_data);
   AdbcStatementRelease(&res->val, &adbc_error);
+  delete (AdbcStatementState *)res->private_data;
 }
 
 static void destruct_adbc_error(ErlNifEnv *env, void *args) {
@@ -125,15 +388,51 @@ static void destruct_adbc_error(ErlNifEnv *env, void *args) {
 }
 
 static void destruct_adbc_arrow_array_stream(ErlNifEnv *env, void *args) {
-  auto res = (NifRes<struct AdbcStatement> *)args;
+  auto res = (NifRes<struct ArrowArrayStream> *)args;
+  // streams that were never released explicitly still hold the buffers
+  // and cursors of the driver, release them before the statement or the
+  // connection kept by their state. The connection waiting for an owned
+  // one is notified, the monitor of its owner goes with the resource
+  release_owned_arrow_array_stream(env, res, true);
   if (res->private_data) {
-    auto schema = (struct ArrowSchema*)res->private_data;
-    if (schema->release) {
-      schema->release(schema);
-    }
-    enif_free(schema);
+    delete (ArrowArrayStreamState *)res->private_data;
     res->private_data = nullptr;
   }
+  adbc_memory_stats.live_streams--;
+}
+
+/// Accounts for `batch` in the retained batches of `adbc_memory_stats`
+/// once its array was set. Its size is kept in its `private_data` for
+/// `destruct_arrow_array`.
+static void track_retained_batch(NifRes<struct ArrowArray> * batch, const struct ArrowSchema * schema) {
+  int64_t bytes = adbc_memory_array_bytes(schema, &batch->val);
+  batch->private_data = reinterpret_cast<void *>(static_cast<intptr_t>(bytes));
+  adbc_memory_stats.retained_batches++;
+  adbc_memory_stats.retained_batch_bytes += bytes;
+}
+
+/// Releases the array of `batch`, if not released yet, and removes it from
+/// the retained batches.
+static void release_retained_batch(NifRes<struct ArrowArray> * batch) {
+  if (batch->val.release == nullptr) return;
+  adbc_memory_stats.retained_batches--;
+  adbc_memory_stats.retained_batch_bytes -= static_cast<int64_t>(reinterpret_cast<intptr_t>(batch->private_data));
+  batch->val.release(&batch->val);
+}
+
+static void destruct_arrow_array(ErlNifEnv *env, void *args) {
+  release_retained_batch((NifRes<struct ArrowArray> *)args);
+}
+
+static void destruct_arrow_column_reference(ErlNifEnv *env, void *args) {
+  auto res = (NifRes<ArrowColumnReference> *)args;
+  if (res->val.schema.release) {
+    adbc_memory_stats.retained_schemas--;
+    res->val.schema.release(&res->val.schema);
+  }
+  if (res->val.owner) {
+    enif_release_resource(res->val.owner);
+  }
 }
 
 #endif /* ADBC_NIF_RESOURCE_HPP */
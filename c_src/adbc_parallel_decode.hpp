@@ -0,0 +1,117 @@
+#ifndef ADBC_PARALLEL_DECODE_HPP
+#define ADBC_PARALLEL_DECODE_HPP
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <erl_nif.h>
+#include <nanoarrow/nanoarrow.h>
+#include "adbc_worker_pool.hpp"
+
+/// Converts up to `window` record batches of a stream at once on the
+/// worker pool, while handing out their terms in the order the batches
+/// were read.
+///
+/// Each batch is converted in its own process independent environment and
+/// its terms are copied into the environment of the NIF that pops them.
+/// Conversion jobs must keep alive whatever owns the decoder until they
+/// call their `done` callback.
+class ParallelDecoder {
+public:
+  /// Converts `batch` within `env`. Returns false, with `out` set to the
+  /// error term, on failure.
+  using Convert = std::function<bool(ErlNifEnv *env, struct ArrowArray *batch, ERL_NIF_TERM &out)>;
+
+  explicit ParallelDecoder(size_t window) : window_(window) {}
+
+  ParallelDecoder(const ParallelDecoder&) = delete;
+  ParallelDecoder& operator=(const ParallelDecoder&) = delete;
+
+  // only destroyed once no job is running
+  ~ParallelDecoder() {
+    for (auto slot : slots_) {
+      enif_free_env(slot->env);
+      delete slot;
+    }
+  }
+
+  bool full() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.size() >= window_;
+  }
+
+  bool empty() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.empty();
+  }
+
+  /// Takes over `batch` and converts it on the worker pool, then releases
+  /// it and calls `done` from the worker thread.
+  ///
+  /// Returns false when out of memory, `batch` is then left untouched.
+  bool submit(struct ArrowArray * batch, Convert convert, std::function<void()> done) {
+    ErlNifEnv * env = enif_alloc_env();
+    if (env == nullptr) return false;
+
+    auto slot = new Slot{env, {}, false, false};
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      slots_.push_back(slot);
+    }
+
+    struct ArrowArray values = *batch;
+    batch->release = nullptr;
+    get_worker_pool().submit([this, slot, values, convert, done]() mutable {
+      ERL_NIF_TERM out{};
+      bool ok = convert(slot->env, &values, out);
+      if (values.release) values.release(&values);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        slot->result = out;
+        slot->ok = ok;
+        slot->ready = true;
+      }
+      cond_.notify_all();
+      done();
+    });
+    return true;
+  }
+
+  /// Waits for the oldest batch still pending and copies its terms into
+  /// `env`. Must not be called when `empty()`.
+  ///
+  /// Returns false, with `out` set to the error term, if it failed.
+  bool pop(ErlNifEnv * env, ERL_NIF_TERM &out) {
+    Slot * slot = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait(lock, [this]() { return slots_.front()->ready; });
+      slot = slots_.front();
+      slots_.pop_front();
+    }
+
+    out = enif_make_copy(env, slot->result);
+    bool ok = slot->ok;
+    enif_free_env(slot->env);
+    delete slot;
+    return ok;
+  }
+
+private:
+  struct Slot {
+    ErlNifEnv * env;
+    ERL_NIF_TERM result;
+    bool ok;
+    bool ready;
+  };
+
+  size_t window_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<Slot *> slots_;
+};
+
+#endif  // ADBC_PARALLEL_DECODE_HPP
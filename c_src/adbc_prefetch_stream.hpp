@@ -0,0 +1,217 @@
+#ifndef ADBC_PREFETCH_STREAM_HPP
+#define ADBC_PREFETCH_STREAM_HPP
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <nanoarrow/nanoarrow.h>
+#include "adbc_memory.hpp"
+#include "adbc_worker_pool.hpp"
+
+/// A batch read ahead and the bytes of its buffers, counted in
+/// `AdbcMemoryStats::live_stream_bytes` until it is handed out.
+struct PrefetchedBatch {
+    struct ArrowArray array;
+    int64_t bytes;
+};
+
+/// State of an ArrowArrayStream that reads ahead of its consumer.
+///
+/// Jobs of the blocking lane of the worker pool call `get_next` on the
+/// wrapped stream, one batch
+/// per job, and store up to `capacity` batches, so the driver fetches the
+/// next batch while the current one is converted to Erlang terms. With
+/// `max_bytes`, they also stop once the stored batches hold that many
+/// bytes, but always store at least one. A job is only queued while there
+/// is room for its batch, so no worker waits for the consumer.
+struct PrefetchStream {
+    struct ArrowArrayStream inner{};
+    struct ArrowSchema schema{};
+    size_t capacity = 0;
+    int64_t max_bytes = 0;
+    int64_t bytes = 0;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<PrefetchedBatch> batches;
+    // set once the producer reached the end of the stream or failed
+    bool done = false;
+    bool stopping = false;
+    int error_code = 0;
+    std::string last_error;
+
+    // set while a job reading the next batch is queued or running
+    bool producing = false;
+};
+
+static void prefetch_stream_produce(PrefetchStream * prefetch);
+
+// Queues a job reading the next batch if there is room for it. Must be
+// called with `mutex` held.
+static void prefetch_stream_schedule(PrefetchStream * prefetch) {
+    if (prefetch->producing || prefetch->done || prefetch->stopping) return;
+    bool over_bytes = prefetch->max_bytes > 0 && prefetch->bytes >= prefetch->max_bytes;
+    if (!prefetch->batches.empty() && (prefetch->batches.size() >= prefetch->capacity || over_bytes)) return;
+
+    prefetch->producing = true;
+    get_worker_pool().submit_blocking([prefetch]() { prefetch_stream_produce(prefetch); });
+}
+
+static void prefetch_stream_produce(PrefetchStream * prefetch) {
+    {
+        std::lock_guard<std::mutex> lock(prefetch->mutex);
+        if (prefetch->stopping) {
+            prefetch->producing = false;
+            prefetch->cond.notify_all();
+            return;
+        }
+    }
+
+    struct ArrowArray batch{};
+    int code = prefetch->inner.get_next(&prefetch->inner, &batch);
+    int64_t bytes = 0;
+    if (code == 0 && batch.release != nullptr) {
+        bytes = adbc_memory_array_bytes(&prefetch->schema, &batch);
+        adbc_memory_stats.live_stream_bytes += bytes;
+    }
+
+    std::lock_guard<std::mutex> lock(prefetch->mutex);
+    if (code != 0) {
+        const char * reason = prefetch->inner.get_last_error(&prefetch->inner);
+        prefetch->error_code = code;
+        prefetch->last_error = reason ? reason : "unknown error";
+        prefetch->done = true;
+    } else {
+        // an array without release marks the end of the stream and is
+        // handed to the consumer like any other batch
+        prefetch->done = batch.release == nullptr;
+        prefetch->batches.push_back(PrefetchedBatch{batch, bytes});
+        prefetch->bytes += bytes;
+    }
+    prefetch->producing = false;
+    prefetch_stream_schedule(prefetch);
+    // notified with the lock held, as `prefetch` may be released as soon
+    // as it is unlocked
+    prefetch->cond.notify_all();
+}
+
+static int prefetch_stream_get_schema(struct ArrowArrayStream * stream, struct ArrowSchema * out) {
+    auto prefetch = (PrefetchStream *)stream->private_data;
+    return ArrowSchemaDeepCopy(&prefetch->schema, out);
+}
+
+static int prefetch_stream_get_next(struct ArrowArrayStream * stream, struct ArrowArray * out) {
+    auto prefetch = (PrefetchStream *)stream->private_data;
+    std::unique_lock<std::mutex> lock(prefetch->mutex);
+    prefetch->cond.wait(lock, [prefetch]() {
+        return !prefetch->batches.empty() || prefetch->done;
+    });
+
+    if (!prefetch->batches.empty()) {
+        PrefetchedBatch &batch = prefetch->batches.front();
+        *out = batch.array;
+        prefetch->bytes -= batch.bytes;
+        adbc_memory_stats.live_stream_bytes -= batch.bytes;
+        prefetch->batches.pop_front();
+        prefetch_stream_schedule(prefetch);
+        return 0;
+    }
+
+    if (prefetch->error_code != 0) {
+        return prefetch->error_code;
+    }
+
+    out->release = nullptr;
+    return 0;
+}
+
+static const char * prefetch_stream_get_last_error(struct ArrowArrayStream * stream) {
+    auto prefetch = (PrefetchStream *)stream->private_data;
+    std::lock_guard<std::mutex> lock(prefetch->mutex);
+    return prefetch->last_error.empty() ? nullptr : prefetch->last_error.c_str();
+}
+
+static void prefetch_stream_release(struct ArrowArrayStream * stream) {
+    auto prefetch = (PrefetchStream *)stream->private_data;
+    {
+        // waits for at most one in-flight `get_next` of the wrapped stream
+        std::unique_lock<std::mutex> lock(prefetch->mutex);
+        prefetch->stopping = true;
+        prefetch->cond.wait(lock, [prefetch]() { return !prefetch->producing; });
+    }
+
+    for (auto &batch : prefetch->batches) {
+        adbc_memory_stats.live_stream_bytes -= batch.bytes;
+        if (batch.array.release) batch.array.release(&batch.array);
+    }
+    if (prefetch->inner.release) prefetch->inner.release(&prefetch->inner);
+    if (prefetch->schema.release) prefetch->schema.release(&prefetch->schema);
+    delete prefetch;
+
+    stream->private_data = nullptr;
+    stream->release = nullptr;
+}
+
+/// Replaces `stream` by a stream that prefetches up to `capacity` batches
+/// of it, holding up to `max_bytes` when positive, on the worker pool. The
+/// original stream is owned and released by the new one.
+///
+/// Returns 0 on success. On failure, returns 1, `stream` is left untouched
+/// and `error` is set.
+static int arrow_array_stream_prefetch(struct ArrowArrayStream * stream, size_t capacity, int64_t max_bytes, std::string &error) {
+    if (stream->release == nullptr) {
+        error = "ArrowArrayStream has already been released";
+        return 1;
+    }
+
+    auto prefetch = new PrefetchStream();
+    prefetch->capacity = capacity;
+    prefetch->max_bytes = max_bytes;
+
+    // the wrapped stream is not thread-safe, so the schema is read once now
+    // rather than while the producer calls `get_next`
+    if (stream->get_schema(stream, &prefetch->schema) != 0) {
+        const char * reason = stream->get_last_error(stream);
+        error = reason ? reason : "unknown error";
+        delete prefetch;
+        return 1;
+    }
+
+    memcpy(&prefetch->inner, stream, sizeof(struct ArrowArrayStream));
+    stream->get_schema = prefetch_stream_get_schema;
+    stream->get_next = prefetch_stream_get_next;
+    stream->get_last_error = prefetch_stream_get_last_error;
+    stream->release = prefetch_stream_release;
+    stream->private_data = prefetch;
+
+    {
+        std::lock_guard<std::mutex> lock(prefetch->mutex);
+        prefetch_stream_schedule(prefetch);
+    }
+    return 0;
+}
+
+/// Sets the number of batches read ahead by a stream replaced by
+/// `arrow_array_stream_prefetch`, so that it follows the demand of its
+/// consumer, and queues a read if there is now room for it. Batches read
+/// ahead past a lower capacity are kept.
+///
+/// Returns 0 on success. On failure, returns 1 and `error` is set.
+static int arrow_array_stream_set_prefetch(struct ArrowArrayStream * stream, size_t capacity, std::string &error) {
+    if (stream->release != prefetch_stream_release) {
+        error = "ArrowArrayStream does not prefetch";
+        return 1;
+    }
+
+    auto prefetch = (PrefetchStream *)stream->private_data;
+    std::lock_guard<std::mutex> lock(prefetch->mutex);
+    prefetch->capacity = capacity;
+    prefetch_stream_schedule(prefetch);
+    return 0;
+}
+
+#endif  // ADBC_PREFETCH_STREAM_HPP
@@ -0,0 +1,389 @@
+#ifndef ADBC_RESULT_CACHE_HPP
+#define ADBC_RESULT_CACHE_HPP
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <erl_nif.h>
+#include <nanoarrow/nanoarrow.h>
+#include "adbc_memory.hpp"
+#include "adbc_nif_resource.hpp"
+
+/// The record batches of a query result, shared by the cache, by
+/// `Adbc.SharedResult` handles and by the streams reading them.
+///
+/// Each batch is kept behind a `std::shared_ptr` which releases it once
+/// neither the cache nor any array handed out by `arrow_array_share`
+/// references it.
+struct CachedResult {
+    struct ArrowSchema schema{};
+    std::vector<std::shared_ptr<struct ArrowArray>> batches;
+    int64_t bytes = 0;
+    int64_t rows_affected = -1;
+
+    CachedResult() = default;
+    CachedResult(const CachedResult&) = delete;
+    CachedResult& operator=(const CachedResult&) = delete;
+
+    ~CachedResult() {
+        if (schema.release) schema.release(&schema);
+    }
+};
+
+/// Takes over `array` in a `std::shared_ptr` releasing it with the last
+/// reference.
+static std::shared_ptr<struct ArrowArray> arrow_array_make_shared(struct ArrowArray * array) {
+    auto shared = std::shared_ptr<struct ArrowArray>(new struct ArrowArray(*array), [](struct ArrowArray * array) {
+        if (array->release) array->release(array);
+        delete array;
+    });
+    array->release = nullptr;
+    return shared;
+}
+
+// Private data of the arrays made by `arrow_array_share`, which only own
+// their children and dictionary arrays and a reference to the batch.
+struct SharedArrayData {
+    std::shared_ptr<struct ArrowArray> owner;
+    std::vector<struct ArrowArray *> children;
+    struct ArrowArray * dictionary = nullptr;
+    const void ** buffers = nullptr;
+};
+
+static void arrow_array_share_release(struct ArrowArray * array) {
+    auto data = (SharedArrayData *)array->private_data;
+    for (auto child : data->children) {
+        child->release(child);
+        delete child;
+    }
+    if (data->dictionary) {
+        data->dictionary->release(data->dictionary);
+        delete data->dictionary;
+    }
+    delete[] data->buffers;
+    delete data;
+    array->private_data = nullptr;
+    array->release = nullptr;
+}
+
+static void arrow_array_share_node(const struct ArrowArray * array, const std::shared_ptr<struct ArrowArray> &owner, struct ArrowArray * out) {
+    auto data = new SharedArrayData{owner, {}, nullptr, nullptr};
+    *out = *array;
+    data->buffers = new const void *[array->n_buffers > 0 ? array->n_buffers : 1];
+    for (int64_t i = 0; i < array->n_buffers; i++) {
+        data->buffers[i] = array->buffers[i];
+    }
+    out->buffers = data->buffers;
+    data->children.reserve((size_t)array->n_children);
+    for (int64_t i = 0; i < array->n_children; i++) {
+        auto child = new struct ArrowArray;
+        arrow_array_share_node(array->children[i], owner, child);
+        data->children.push_back(child);
+    }
+    out->children = data->children.empty() ? nullptr : data->children.data();
+    if (array->dictionary != nullptr) {
+        data->dictionary = new struct ArrowArray;
+        arrow_array_share_node(array->dictionary, owner, data->dictionary);
+        out->dictionary = data->dictionary;
+    }
+    out->private_data = data;
+    out->release = arrow_array_share_release;
+}
+
+/// Makes `out` an array over the same buffers as `batch`, which stays
+/// alive until `out` is released.
+static void arrow_array_share(const std::shared_ptr<struct ArrowArray> &batch, struct ArrowArray * out) {
+    arrow_array_share_node(batch.get(), batch, out);
+}
+
+/// Same as `arrow_array_share`, with only the `columns` children of the
+/// record batch `batch`, in that order.
+static void arrow_array_share_columns(const std::shared_ptr<struct ArrowArray> &batch, const std::vector<int64_t> &columns, struct ArrowArray * out) {
+    struct ArrowArray top = *batch;
+    std::vector<struct ArrowArray *> children;
+    children.reserve(columns.size());
+    for (int64_t column : columns) {
+        children.push_back(batch->children[column]);
+    }
+    top.n_children = (int64_t)children.size();
+    top.children = children.empty() ? nullptr : children.data();
+    arrow_array_share_node(&top, batch, out);
+}
+
+/// Sets `out` to the record batch schema `schema` with only its `columns`
+/// children, in that order.
+static int arrow_schema_select_columns(const struct ArrowSchema * schema, const std::vector<int64_t> &columns, struct ArrowSchema * out) {
+    ArrowSchemaInit(out);
+    int code = ArrowSchemaSetTypeStruct(out, (int64_t)columns.size());
+    if (code == NANOARROW_OK && schema->name) code = ArrowSchemaSetName(out, schema->name);
+    if (code == NANOARROW_OK && schema->metadata) code = ArrowSchemaSetMetadata(out, schema->metadata);
+    out->flags = schema->flags;
+    for (size_t i = 0; code == NANOARROW_OK && i < columns.size(); i++) {
+        out->children[i]->release(out->children[i]);
+        code = ArrowSchemaDeepCopy(schema->children[columns[i]], out->children[i]);
+    }
+    if (code != NANOARROW_OK) out->release(out);
+    return code;
+}
+
+/// The results of queries run with the `:cache` option, by key, evicted
+/// once expired or when the bytes of all results exceed the budget, least
+/// recently used first.
+///
+/// Keys are the binary made by `Adbc.Connection` of the driver, database,
+/// query, parameters and statement options, so only exact repetitions hit.
+class AdbcResultCache {
+public:
+    void set_max_bytes(int64_t max_bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        max_bytes_ = max_bytes;
+        evict(0);
+    }
+
+    int64_t max_bytes() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return max_bytes_;
+    }
+
+    /// Returns the live result of `key`, or null.
+    std::shared_ptr<CachedResult> get(const std::string &key, int64_t now) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it == entries_.end()) return nullptr;
+        if (it->second.expires_at <= now) {
+            erase(it);
+            return nullptr;
+        }
+        order_.splice(order_.end(), order_, it->second.order);
+        return it->second.result;
+    }
+
+    /// Caches `result` under `key` until `expires_at`, evicting the least
+    /// recently used results as needed. Results larger than the whole
+    /// budget are not cached.
+    void put(const std::string &key, std::shared_ptr<CachedResult> result, int64_t expires_at) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) erase(it);
+        if (result->bytes > max_bytes_) return;
+
+        evict(result->bytes);
+        auto order = order_.insert(order_.end(), key);
+        bytes_ += result->bytes;
+        adbc_memory_stats.cached_results++;
+        adbc_memory_stats.cached_result_bytes += result->bytes;
+        entries_.emplace(key, Entry{std::move(result), expires_at, order});
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!entries_.empty()) erase(entries_.begin());
+    }
+
+    /// Evicts the results whose key starts with `prefix`.
+    void erase_prefix(const std::string &prefix) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            auto current = it++;
+            if (current->first.compare(0, prefix.size(), prefix) == 0) erase(current);
+        }
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<CachedResult> result;
+        int64_t expires_at;
+        std::list<std::string>::iterator order;
+    };
+
+    // Evicts results until `bytes` more fit in the budget.
+    void evict(int64_t bytes) {
+        while (!order_.empty() && bytes_ + bytes > max_bytes_) {
+            erase(entries_.find(order_.front()));
+        }
+    }
+
+    void erase(std::unordered_map<std::string, Entry>::iterator it) {
+        bytes_ -= it->second.result->bytes;
+        adbc_memory_stats.cached_results--;
+        adbc_memory_stats.cached_result_bytes -= it->second.result->bytes;
+        order_.erase(it->second.order);
+        entries_.erase(it);
+    }
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    // keys from the least to the most recently used
+    std::list<std::string> order_;
+    int64_t bytes_ = 0;
+    int64_t max_bytes_ = 64 * 1024 * 1024;
+};
+
+static AdbcResultCache adbc_result_cache;
+
+/// State of an ArrowArrayStream that records the batches it hands out and
+/// caches them under `key` once it reaches the end of the wrapped stream.
+/// Recording stops, and nothing is cached, if the stream fails, is
+/// released before its end or its batches exceed the budget of the cache.
+struct CachingStream {
+    struct ArrowArrayStream inner{};
+    std::shared_ptr<CachedResult> result;
+    std::string key;
+    int64_t ttl = 0;
+    std::string last_error;
+};
+
+static int caching_stream_get_schema(struct ArrowArrayStream * stream, struct ArrowSchema * out) {
+    auto caching = (CachingStream *)stream->private_data;
+    return caching->inner.get_schema(&caching->inner, out);
+}
+
+static int caching_stream_get_next(struct ArrowArrayStream * stream, struct ArrowArray * out) {
+    auto caching = (CachingStream *)stream->private_data;
+    int code = caching->inner.get_next(&caching->inner, out);
+    if (code != 0 || caching->result == nullptr) {
+        caching->result = nullptr;
+        return code;
+    }
+
+    if (out->release == nullptr) {
+        int64_t expires_at = enif_monotonic_time(ERL_NIF_MSEC) + caching->ttl;
+        adbc_result_cache.put(caching->key, std::move(caching->result), expires_at);
+        caching->result = nullptr;
+        return 0;
+    }
+
+    auto batch = arrow_array_make_shared(out);
+    caching->result->bytes += adbc_memory_array_bytes(&caching->result->schema, batch.get());
+    if (caching->result->bytes > adbc_result_cache.max_bytes()) {
+        caching->result = nullptr;
+    } else {
+        caching->result->batches.push_back(batch);
+    }
+    arrow_array_share(batch, out);
+    return 0;
+}
+
+static const char * caching_stream_get_last_error(struct ArrowArrayStream * stream) {
+    auto caching = (CachingStream *)stream->private_data;
+    return caching->inner.get_last_error(&caching->inner);
+}
+
+static void caching_stream_release(struct ArrowArrayStream * stream) {
+    auto caching = (CachingStream *)stream->private_data;
+    if (caching->inner.release) caching->inner.release(&caching->inner);
+    delete caching;
+    stream->private_data = nullptr;
+    stream->release = nullptr;
+}
+
+/// Replaces `stream` by a stream that caches its batches under `key` for
+/// `ttl` milliseconds once fully read, with `rows_affected`. The original
+/// stream is owned and released by the new one.
+///
+/// Returns 0 on success. On failure, returns 1, `stream` is left untouched
+/// and `error` is set.
+static int arrow_array_stream_cache(struct ArrowArrayStream * stream, std::string key, int64_t ttl, int64_t rows_affected, std::string &error) {
+    if (stream->release == nullptr) {
+        error = "ArrowArrayStream has already been released";
+        return 1;
+    }
+
+    auto result = std::make_shared<CachedResult>();
+    result->rows_affected = rows_affected;
+    if (stream->get_schema(stream, &result->schema) != 0) {
+        const char * reason = stream->get_last_error(stream);
+        error = reason ? reason : "unknown error";
+        return 1;
+    }
+
+    auto caching = new CachingStream{*stream, std::move(result), std::move(key), ttl, {}};
+    stream->get_schema = caching_stream_get_schema;
+    stream->get_next = caching_stream_get_next;
+    stream->get_last_error = caching_stream_get_last_error;
+    stream->release = caching_stream_release;
+    stream->private_data = caching;
+    return 0;
+}
+
+/// State of an ArrowArrayStream over the batches `next` to `end` of a
+/// cached result, with only its `columns` unless empty.
+struct CachedStream {
+    std::shared_ptr<CachedResult> result;
+    size_t next = 0;
+    size_t end = 0;
+    std::vector<int64_t> columns;
+};
+
+static int cached_stream_get_schema(struct ArrowArrayStream * stream, struct ArrowSchema * out) {
+    auto cached = (CachedStream *)stream->private_data;
+    if (cached->columns.empty()) {
+        return ArrowSchemaDeepCopy(&cached->result->schema, out);
+    }
+    return arrow_schema_select_columns(&cached->result->schema, cached->columns, out);
+}
+
+static int cached_stream_get_next(struct ArrowArrayStream * stream, struct ArrowArray * out) {
+    auto cached = (CachedStream *)stream->private_data;
+    if (cached->next == cached->end) {
+        out->release = nullptr;
+        return 0;
+    }
+    auto &batch = cached->result->batches[cached->next++];
+    if (cached->columns.empty()) {
+        arrow_array_share(batch, out);
+    } else {
+        arrow_array_share_columns(batch, cached->columns, out);
+    }
+    return 0;
+}
+
+static const char * cached_stream_get_last_error(struct ArrowArrayStream *) {
+    return nullptr;
+}
+
+static void cached_stream_release(struct ArrowArrayStream * stream) {
+    delete (CachedStream *)stream->private_data;
+    stream->private_data = nullptr;
+    stream->release = nullptr;
+}
+
+/// Makes `stream` a stream over the batches `first` to `end` of `result`,
+/// with only its `columns` unless empty, which must be valid indices.
+static void arrow_array_stream_from_cache(struct ArrowArrayStream * stream, std::shared_ptr<CachedResult> result, size_t first, size_t end, std::vector<int64_t> columns = {}) {
+    stream->get_schema = cached_stream_get_schema;
+    stream->get_next = cached_stream_get_next;
+    stream->get_last_error = cached_stream_get_last_error;
+    stream->release = cached_stream_release;
+    stream->private_data = new CachedStream{std::move(result), first, end, std::move(columns)};
+}
+
+/// Makes `stream` a stream over all the batches of `result`.
+static void arrow_array_stream_from_cache(struct ArrowArrayStream * stream, std::shared_ptr<CachedResult> result) {
+    size_t end = result->batches.size();
+    arrow_array_stream_from_cache(stream, std::move(result), 0, end);
+}
+
+/// The value of the resources behind `Adbc.SharedResult` handles, which
+/// keep their result alive until garbage collected.
+struct SharedResultHandle {
+    std::shared_ptr<CachedResult> * result;
+    int64_t rows;
+};
+
+static void destruct_shared_result_handle(ErlNifEnv *env, void *args) {
+    auto res = (NifRes<SharedResultHandle> *)args;
+    if (res->val.result == nullptr) return;
+    adbc_memory_stats.shared_results--;
+    adbc_memory_stats.shared_result_bytes -= (*res->val.result)->bytes;
+    delete res->val.result;
+    res->val.result = nullptr;
+}
+
+#endif  // ADBC_RESULT_CACHE_HPP
@@ -0,0 +1,165 @@
+#ifndef ADBC_SPILL_HPP
+#define ADBC_SPILL_HPP
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nanoarrow/nanoarrow.h>
+#include "nif_utils.hpp"
+#ifndef OS_WIN
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+#include "adbc_mapped_file.hpp"
+#include "adbc_memory.hpp"
+
+// Spilling writes the record batches of a result to a temporary file as
+// they are read, so that only one batch at a time is held in memory, and
+// then maps the file to read them back. Buffers are written as they are
+// laid out in memory, each aligned to 64 bytes, so the arrays read back
+// point into the mapping instead of copying it and the pages of the file
+// are only resident while in use.
+//
+// The file is unlinked as soon as it is created, so it is removed by the
+// system once the mapping is gone, even if the VM crashes. It is read on
+// the host that wrote it only, so it has no header and the layout of the
+// batches, which is small, is kept in memory instead.
+
+constexpr int64_t kSpillAlignment = 64;
+
+/// Writes record batches to a temporary file and maps it once done.
+class AdbcSpillWriter {
+public:
+    AdbcSpillWriter() = default;
+    AdbcSpillWriter(const AdbcSpillWriter&) = delete;
+    AdbcSpillWriter& operator=(const AdbcSpillWriter&) = delete;
+
+    ~AdbcSpillWriter() {
+#ifndef OS_WIN
+        if (fd_ != -1) close(fd_);
+#endif
+    }
+
+    /// Creates the file in the directory `dir`.
+    ///
+    /// Returns 0 on success. On failure, returns 1 and `error` is set.
+    int open(const std::string &dir, std::string &error) {
+#ifdef OS_WIN
+        (void)dir;
+        error = "spilling results is not supported on this platform";
+        return 1;
+#else
+        std::string path = dir + "/adbc-spill-XXXXXX";
+        fd_ = mkstemp(&path[0]);
+        if (fd_ == -1) {
+            error = "cannot create spill file in " + dir + ": " + strerror(errno);
+            return 1;
+        }
+        unlink(path.c_str());
+        return 0;
+#endif
+    }
+
+    /// Writes the buffers of `array` of `schema` and sets `node` to where
+    /// they were written.
+    ///
+    /// Returns 0 on success. On failure, returns 1 and `error` is set.
+    int append(struct ArrowSchema * schema, const struct ArrowArray * array, MappedArrayNode &node, std::string &error) {
+        struct ArrowError na_error{};
+        struct ArrowArrayView view{};
+        // the view computes the size of every buffer, which the C data
+        // interface does not store
+        if (ArrowArrayViewInitFromSchema(&view, schema, &na_error) != NANOARROW_OK ||
+            ArrowArrayViewSetArray(&view, array, &na_error) != NANOARROW_OK) {
+            ArrowArrayViewReset(&view);
+            error = na_error.message;
+            return 1;
+        }
+        int code = append_node(&view, array, node, error);
+        ArrowArrayViewReset(&view);
+        return code;
+    }
+
+    /// Maps the file written so far into `mapping`.
+    ///
+    /// Returns 0 on success. On failure, returns 1 and `error` is set.
+    int finish(std::shared_ptr<MappedFile> &mapping, std::string &error) {
+        if (map_file(fd_, size_, adbc_memory_stats.spilled_results, adbc_memory_stats.spilled_bytes, mapping, error) != 0) {
+            return 1;
+        }
+#ifndef OS_WIN
+        close(fd_);
+#endif
+        fd_ = -1;
+        return 0;
+    }
+
+private:
+    int append_node(const struct ArrowArrayView * view, const struct ArrowArray * array, MappedArrayNode &node, std::string &error) {
+        node.length = array->length;
+        node.null_count = array->null_count;
+        node.offset = array->offset;
+        for (int64_t i = 0; i < array->n_buffers; i++) {
+            if (array->buffers[i] == nullptr) {
+                node.buffers.push_back(-1);
+                continue;
+            }
+            node.buffers.push_back(size_);
+            if (write(array->buffers[i], view->buffer_views[i].size_bytes, error) != 0) return 1;
+        }
+        node.children.resize((size_t)array->n_children);
+        for (int64_t i = 0; i < array->n_children; i++) {
+            if (append_node(view->children[i], array->children[i], node.children[i], error) != 0) return 1;
+        }
+        if (array->dictionary != nullptr) {
+            node.dictionary.resize(1);
+            if (append_node(view->dictionary, array->dictionary, node.dictionary[0], error) != 0) return 1;
+        }
+        return 0;
+    }
+
+    // Writes `size` bytes of `data`, padded to the alignment.
+    int write(const void * data, int64_t size, std::string &error) {
+#ifdef OS_WIN
+        (void)data;
+        (void)size;
+        error = "spilling results is not supported on this platform";
+        return 1;
+#else
+        static const uint8_t padding[kSpillAlignment] = {0};
+        int64_t padded = (size + kSpillAlignment - 1) / kSpillAlignment * kSpillAlignment;
+        if (write_all((const uint8_t *)data, size, error) != 0 ||
+            write_all(padding, padded - size, error) != 0) {
+            return 1;
+        }
+        size_ += padded;
+        return 0;
+#endif
+    }
+
+#ifndef OS_WIN
+    int write_all(const uint8_t * data, int64_t size, std::string &error) {
+        while (size > 0) {
+            ssize_t written = ::write(fd_, data, (size_t)size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                error = std::string("cannot write spill file: ") + strerror(errno);
+                return 1;
+            }
+            data += written;
+            size -= written;
+        }
+        return 0;
+    }
+#endif
+
+    int fd_ = -1;
+    int64_t size_ = 0;
+};
+
+#endif  // ADBC_SPILL_HPP
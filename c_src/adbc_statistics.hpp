@@ -0,0 +1,113 @@
+#ifndef ADBC_STATISTICS_HPP
+#define ADBC_STATISTICS_HPP
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <erl_nif.h>
+#include <nanoarrow/nanoarrow.h>
+#include "adbc_consts.h"
+#include "nif_utils.hpp"
+
+// The result of `AdbcConnectionGetStatistics` nests statistics by catalog
+// and database schema, with values in a dense union, as a list of catalogs
+// of:
+//
+//   catalog_name: utf8
+//   catalog_db_schemas: list<struct<
+//     db_schema_name: utf8,
+//     db_schema_statistics: list<struct<
+//       table_name: utf8 not null,
+//       column_name: utf8,
+//       statistic_key: int16 not null,
+//       statistic_value: dense_union<int64, uint64, float64, binary> not null,
+//       statistic_is_approximate: bool not null
+//     >>
+//   >>
+//
+// which is flattened into one tuple per statistic, so that callers need not
+// walk the nesting to find the row count of a table.
+
+static ERL_NIF_TERM arrow_statistics_string(ErlNifEnv *env, const struct ArrowArrayView * view, int64_t i) {
+    if (ArrowArrayViewIsNull(view, i)) return kAtomNil;
+    struct ArrowStringView string = ArrowArrayViewGetStringUnsafe(view, i);
+    return erlang::nif::make_binary(env, string.data, (size_t)string.size_bytes);
+}
+
+static ERL_NIF_TERM arrow_statistics_value(ErlNifEnv *env, const struct ArrowArrayView * view, int64_t i) {
+    int8_t child = ArrowArrayViewUnionChildIndex(view, i);
+    int64_t offset = ArrowArrayViewUnionChildOffset(view, i);
+    const struct ArrowArrayView * values = view->children[child];
+    if (ArrowArrayViewIsNull(values, offset)) return kAtomNil;
+
+    switch (values->storage_type) {
+        case NANOARROW_TYPE_INT64:
+            return enif_make_int64(env, ArrowArrayViewGetIntUnsafe(values, offset));
+        case NANOARROW_TYPE_UINT64:
+            return enif_make_uint64(env, ArrowArrayViewGetUIntUnsafe(values, offset));
+        case NANOARROW_TYPE_DOUBLE:
+            return enif_make_double(env, ArrowArrayViewGetDoubleUnsafe(values, offset));
+        default: {
+            struct ArrowBufferView bytes = ArrowArrayViewGetBytesUnsafe(values, offset);
+            return erlang::nif::make_binary(env, bytes.data.as_char, (size_t)bytes.size_bytes);
+        }
+    }
+}
+
+/// Appends a `{catalog, db_schema, table_name, column_name, key, value,
+/// approximate}` tuple to `out` for each statistic of `array`, a batch of
+/// the result of `AdbcConnectionGetStatistics` of schema `schema`.
+///
+/// Returns 0 on success. On failure, returns 1 and `error` is set.
+static int arrow_statistics_to_terms(ErlNifEnv *env, const struct ArrowSchema * schema, const struct ArrowArray * array, std::vector<ERL_NIF_TERM> &out, std::string &error) {
+    struct ArrowArrayView view{};
+    struct ArrowError na_error{};
+    if (ArrowArrayViewInitFromSchema(&view, (struct ArrowSchema *)schema, &na_error) != NANOARROW_OK ||
+        ArrowArrayViewSetArray(&view, array, &na_error) != NANOARROW_OK) {
+        ArrowArrayViewReset(&view);
+        error = na_error.message;
+        return 1;
+    }
+    if (view.n_children != 2 || view.children[1]->n_children != 1 ||
+        view.children[1]->children[0]->n_children != 2 ||
+        view.children[1]->children[0]->children[1]->n_children != 1 ||
+        view.children[1]->children[0]->children[1]->children[0]->n_children != 5) {
+        ArrowArrayViewReset(&view);
+        error = "unexpected schema of the statistics";
+        return 1;
+    }
+
+    const struct ArrowArrayView * catalogs = view.children[0];
+    const struct ArrowArrayView * db_schema_lists = view.children[1];
+    const struct ArrowArrayView * db_schemas = db_schema_lists->children[0];
+    const struct ArrowArrayView * statistic_lists = db_schemas->children[1];
+    const struct ArrowArrayView * statistics = statistic_lists->children[0];
+    for (int64_t i = 0; i < array->length; i++) {
+        ERL_NIF_TERM catalog = arrow_statistics_string(env, catalogs, i);
+        if (ArrowArrayViewIsNull(db_schema_lists, i)) continue;
+
+        for (int64_t j = ArrowArrayViewListChildOffset(db_schema_lists, i); j < ArrowArrayViewListChildOffset(db_schema_lists, i + 1); j++) {
+            ERL_NIF_TERM db_schema = arrow_statistics_string(env, db_schemas->children[0], j);
+            if (ArrowArrayViewIsNull(statistic_lists, j)) continue;
+
+            for (int64_t k = ArrowArrayViewListChildOffset(statistic_lists, j); k < ArrowArrayViewListChildOffset(statistic_lists, j + 1); k++) {
+                ERL_NIF_TERM terms[7] = {
+                    catalog,
+                    db_schema,
+                    arrow_statistics_string(env, statistics->children[0], k),
+                    arrow_statistics_string(env, statistics->children[1], k),
+                    enif_make_int64(env, ArrowArrayViewGetIntUnsafe(statistics->children[2], k)),
+                    arrow_statistics_value(env, statistics->children[3], k),
+                    ArrowArrayViewGetIntUnsafe(statistics->children[4], k) ? kAtomTrue : kAtomFalse
+                };
+                out.push_back(enif_make_tuple_from_array(env, terms, 7));
+            }
+        }
+    }
+
+    ArrowArrayViewReset(&view);
+    return 0;
+}
+
+#endif  // ADBC_STATISTICS_HPP
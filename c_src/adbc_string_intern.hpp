@@ -0,0 +1,92 @@
+#ifndef ADBC_STRING_INTERN_HPP
+#define ADBC_STRING_INTERN_HPP
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <erl_nif.h>
+
+// Interning stops once a column has more distinct values than this, or
+// than a `kInternMaxDistinctRatio`th of its values once at least
+// `kInternMinValues` were seen, as then few values repeat.
+constexpr size_t kInternMaxDistinct = 4096;
+constexpr size_t kInternMaxDistinctRatio = 4;
+constexpr size_t kInternMinValues = 4096;
+
+/// The terms of the distinct values of a string or binary column, so that
+/// repeated values are returned as the same term instead of a new binary
+/// each. An open-addressing hash table over the bytes of the values,
+/// which point into the buffers of the record batch being converted.
+///
+/// Terms are only valid in the env of the call converting the batch, so
+/// an interner lives for the conversion of a single column of a batch.
+class AdbcStringInterner {
+public:
+  AdbcStringInterner() : slots_(64) {}
+
+  /// Returns the term of an already seen value in `term`, or false if it
+  /// is new, in which case the term made for it must be given to `add`.
+  bool find(const uint8_t * data, size_t size, ERL_NIF_TERM &term) {
+    seen_++;
+    hash_ = hash(data, size);
+    slot_ = hash_ & (slots_.size() - 1);
+    while (slots_[slot_].used) {
+      const Slot &slot = slots_[slot_];
+      if (slot.hash == hash_ && slot.size == size && memcmp(slot.data, data, size) == 0) {
+        term = slot.term;
+        return true;
+      }
+      slot_ = (slot_ + 1) & (slots_.size() - 1);
+    }
+    return false;
+  }
+
+  /// Adds the value last given to `find`. Returns false once the column
+  /// has too many distinct values for interning to pay off.
+  bool add(const uint8_t * data, size_t size, ERL_NIF_TERM term) {
+    slots_[slot_] = Slot{true, hash_, data, size, term};
+    distinct_++;
+    // kept at most half full
+    if (distinct_ * 2 > slots_.size()) grow();
+    if (distinct_ >= kInternMaxDistinct) return false;
+    return seen_ < kInternMinValues || distinct_ * kInternMaxDistinctRatio <= seen_;
+  }
+
+private:
+  struct Slot {
+    bool used = false;
+    uint64_t hash = 0;
+    const uint8_t * data = nullptr;
+    size_t size = 0;
+    ERL_NIF_TERM term{};
+  };
+
+  void grow() {
+    std::vector<Slot> slots(slots_.size() * 2);
+    for (const Slot &slot : slots_) {
+      if (!slot.used) continue;
+      size_t index = slot.hash & (slots.size() - 1);
+      while (slots[index].used) index = (index + 1) & (slots.size() - 1);
+      slots[index] = slot;
+    }
+    slots_.swap(slots);
+  }
+
+  // FNV-1a
+  static uint64_t hash(const uint8_t * data, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+      hash = (hash ^ data[i]) * 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  std::vector<Slot> slots_;
+  size_t seen_ = 0;
+  size_t distinct_ = 0;
+  uint64_t hash_ = 0;
+  size_t slot_ = 0;
+};
+
+#endif  // ADBC_STRING_INTERN_HPP
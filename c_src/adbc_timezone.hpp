@@ -0,0 +1,436 @@
+#ifndef ADBC_TIMEZONE_HPP
+#define ADBC_TIMEZONE_HPP
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+#include "adbc_datetime.hpp"
+
+/// The offsets from UTC of a time zone over a period of time, as in the
+/// fields of an Elixir `DateTime`: `utc_offset` is the standard offset of
+/// the zone and `std_offset` what daylight saving time adds to it.
+struct AdbcZonePeriod {
+    int32_t utc_offset = 0;
+    int32_t std_offset = 0;
+    // index in `AdbcTimeZone::abbreviations()`
+    size_t abbreviation = 0;
+};
+
+/// The period of a time zone that a time falls in, from `from` included to
+/// `until` excluded, in seconds since the Unix epoch in UTC. Times within
+/// the same span have the same offsets, so decoders converting many times
+/// only look a zone up again once a time falls out of the last span.
+struct AdbcZoneSpan {
+    int64_t from = std::numeric_limits<int64_t>::max();
+    int64_t until = std::numeric_limits<int64_t>::min();
+    size_t period = 0;
+
+    bool contains(int64_t seconds) const { return from <= seconds && seconds < until; }
+};
+
+/// The transitions of a time zone, read once from the TZif file of the
+/// system's zoneinfo database, in `TZDIR` or else `/usr/share/zoneinfo`.
+///
+/// `UTC` and fixed offsets such as `+01:00` have a single period and need
+/// no database. Times after the last transition of the file follow the
+/// POSIX `TZ` rule in its footer.
+class AdbcTimeZone {
+public:
+    /// Loads the zone of the given name, returns false if it is unknown.
+    bool load(const std::string &name) {
+        name_ = name;
+        if (name == "UTC" || name == "Etc/UTC" || name == "Z" || name == "GMT" || name == "Etc/GMT" ||
+            name == "+00:00" || name == "-00:00") {
+            // as `DateTime.from_unix/2`
+            name_ = "Etc/UTC";
+            return set_fixed(0, "UTC");
+        }
+        int32_t offset = 0;
+        if (parse_fixed_offset(name, offset)) {
+            return set_fixed(offset, name);
+        }
+        return load_tzif(name);
+    }
+
+    /// The name of the zone, as the `time_zone` of its `DateTime`s.
+    const std::string &name() const { return name_; }
+
+    const std::vector<std::string> &abbreviations() const { return abbreviations_; }
+
+    const AdbcZonePeriod &period(size_t index) const { return periods_[index]; }
+
+    /// Returns the span of the zone that `seconds` since the Unix epoch in
+    /// UTC falls in.
+    AdbcZoneSpan span_at(int64_t seconds) const {
+        AdbcZoneSpan span;
+        span.from = std::numeric_limits<int64_t>::min();
+        span.until = std::numeric_limits<int64_t>::max();
+        span.period = initial_period_;
+
+        size_t after = std::upper_bound(transitions_.begin(), transitions_.end(), seconds) - transitions_.begin();
+        if (after < transitions_.size()) {
+            span.until = transitions_[after];
+        }
+        if (after > 0) {
+            span.from = transitions_[after - 1];
+            span.period = transition_periods_[after - 1];
+        }
+        if (after == transitions_.size() && has_rule_) {
+            rule_span(seconds, span);
+        }
+        return span;
+    }
+
+private:
+    // a date of a POSIX TZ rule: `Jn`, `n` or `Mm.w.d`, and the local time
+    // in seconds at which it applies
+    struct RuleDate {
+        char kind = 'M';
+        int32_t day = 0;
+        int32_t week = 0;
+        int32_t month = 0;
+        int32_t time = 7200;
+    };
+
+    bool set_fixed(int32_t offset, const std::string &abbreviation) {
+        abbreviations_ = {abbreviation};
+        periods_ = {AdbcZonePeriod{offset, 0, 0}};
+        initial_period_ = 0;
+        return true;
+    }
+
+    // `+HH`, `+HHMM` or `+HH:MM`, as in the time zones of Arrow timestamps
+    static bool parse_fixed_offset(const std::string &name, int32_t &offset) {
+        if (name.size() < 3 || (name[0] != '+' && name[0] != '-')) return false;
+        std::string digits;
+        for (size_t i = 1; i < name.size(); i++) {
+            if (name[i] == ':' && i == 3) continue;
+            if (name[i] < '0' || name[i] > '9') return false;
+            digits.push_back(name[i]);
+        }
+        if (digits.size() != 2 && digits.size() != 4) return false;
+        int32_t hours = std::atoi(digits.substr(0, 2).c_str());
+        int32_t minutes = digits.size() == 4 ? std::atoi(digits.substr(2, 2).c_str()) : 0;
+        if (hours > 23 || minutes > 59) return false;
+        offset = (name[0] == '-' ? -1 : 1) * (hours * 3600 + minutes * 60);
+        return true;
+    }
+
+    static bool valid_zone_name(const std::string &name) {
+        if (name.empty() || name[0] == '/' || name.find("..") != std::string::npos) return false;
+        for (char c : name) {
+            if (!(isalnum((unsigned char)c) || c == '/' || c == '_' || c == '-' || c == '+')) return false;
+        }
+        return true;
+    }
+
+    static uint32_t read_u32(const uint8_t * data) {
+        return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+    }
+
+    static int64_t read_i64(const uint8_t * data) {
+        return (int64_t)(((uint64_t)read_u32(data) << 32) | read_u32(data + 4));
+    }
+
+    bool load_tzif(const std::string &name) {
+        if (!valid_zone_name(name)) return false;
+        const char * dir = getenv("TZDIR");
+        std::string path = std::string(dir && dir[0] ? dir : "/usr/share/zoneinfo") + "/" + name;
+
+        std::vector<uint8_t> data;
+        FILE * file = fopen(path.c_str(), "rb");
+        if (file == nullptr) return false;
+        uint8_t chunk[4096];
+        size_t read = 0;
+        while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            data.insert(data.end(), chunk, chunk + read);
+        }
+        fclose(file);
+        return parse_tzif(data);
+    }
+
+    // See RFC 8536. Version 1 files only have 32-bit transitions, later
+    // versions repeat the data with 64-bit ones, followed by a footer.
+    bool parse_tzif(const std::vector<uint8_t> &data) {
+        const size_t header_size = 44;
+        if (data.size() < header_size || memcmp(data.data(), "TZif", 4) != 0) return false;
+        bool v2 = data[4] >= '2';
+        size_t start = 0;
+        size_t time_size = 4;
+        if (v2) {
+            size_t skip = 0;
+            if (!block_size(data, 0, 4, skip)) return false;
+            start = header_size + skip;
+            time_size = 8;
+            if (data.size() < start + header_size || memcmp(data.data() + start, "TZif", 4) != 0) return false;
+        }
+
+        const uint8_t * header = data.data() + start;
+        uint32_t isutcnt = read_u32(header + 20), isstdcnt = read_u32(header + 24), leapcnt = read_u32(header + 28);
+        uint32_t timecnt = read_u32(header + 32), typecnt = read_u32(header + 36), charcnt = read_u32(header + 40);
+        size_t size = 0;
+        if (typecnt == 0 || !block_size(data, start, time_size, size)) return false;
+
+        const uint8_t * p = header + header_size;
+        std::vector<int64_t> times(timecnt);
+        for (uint32_t i = 0; i < timecnt; i++, p += time_size) {
+            times[i] = time_size == 8 ? read_i64(p) : (int64_t)(int32_t)read_u32(p);
+        }
+        std::vector<uint8_t> indices(p, p + timecnt);
+        p += timecnt;
+        struct LocalType {
+            int32_t offset;
+            bool dst;
+            uint8_t abbreviation;
+        };
+        std::vector<LocalType> types(typecnt);
+        for (uint32_t i = 0; i < typecnt; i++, p += 6) {
+            types[i] = LocalType{(int32_t)read_u32(p), p[4] != 0, p[5]};
+        }
+        std::string chars((const char *)p, charcnt);
+        p += charcnt + leapcnt * (time_size + 4) + isstdcnt + isutcnt;
+        for (uint8_t index : indices) {
+            if (index >= typecnt) return false;
+        }
+
+        // daylight saving time is the difference with the offset of the
+        // last standard time before it, `DateTime` keeps both apart
+        auto abbreviation = [&](uint8_t index) {
+            return add_abbreviation(index < chars.size() ? std::string(chars.c_str() + index) : std::string());
+        };
+        int32_t standard = types[0].offset;
+        for (const LocalType &type : types) {
+            if (!type.dst) {
+                standard = type.offset;
+                break;
+            }
+        }
+        initial_period_ = add_period(types[0].dst ? standard : types[0].offset, types[0].dst ? types[0].offset - standard : 0, abbreviation(types[0].abbreviation));
+        if (!types[0].dst) standard = types[0].offset;
+        for (uint32_t i = 0; i < timecnt; i++) {
+            const LocalType &type = types[indices[i]];
+            if (!type.dst) standard = type.offset;
+            transitions_.push_back(times[i]);
+            transition_periods_.push_back(add_period(type.dst ? standard : type.offset, type.dst ? type.offset - standard : 0, abbreviation(type.abbreviation)));
+        }
+
+        if (v2) {
+            const uint8_t * end = data.data() + data.size();
+            if (p < end && *p == '\n') {
+                const uint8_t * footer_end = std::find(p + 1, end, '\n');
+                std::string footer((const char *)p + 1, (const char *)footer_end);
+                if (!footer.empty()) parse_rule(footer);
+            }
+        }
+        return true;
+    }
+
+    // the size of the data block following the header at `start`
+    static bool block_size(const std::vector<uint8_t> &data, size_t start, size_t time_size, size_t &size) {
+        if (data.size() < start + 44) return false;
+        const uint8_t * header = data.data() + start;
+        uint64_t isutcnt = read_u32(header + 20), isstdcnt = read_u32(header + 24), leapcnt = read_u32(header + 28);
+        uint64_t timecnt = read_u32(header + 32), typecnt = read_u32(header + 36), charcnt = read_u32(header + 40);
+        uint64_t total = timecnt * time_size + timecnt + typecnt * 6 + charcnt + leapcnt * (time_size + 4) + isstdcnt + isutcnt;
+        if (data.size() < start + 44 + total) return false;
+        size = (size_t)total;
+        return true;
+    }
+
+    size_t add_abbreviation(const std::string &abbreviation) {
+        auto found = std::find(abbreviations_.begin(), abbreviations_.end(), abbreviation);
+        if (found != abbreviations_.end()) return found - abbreviations_.begin();
+        abbreviations_.push_back(abbreviation);
+        return abbreviations_.size() - 1;
+    }
+
+    size_t add_period(int32_t utc_offset, int32_t std_offset, size_t abbreviation) {
+        for (size_t i = 0; i < periods_.size(); i++) {
+            const AdbcZonePeriod &period = periods_[i];
+            if (period.utc_offset == utc_offset && period.std_offset == std_offset && period.abbreviation == abbreviation) return i;
+        }
+        periods_.push_back(AdbcZonePeriod{utc_offset, std_offset, abbreviation});
+        return periods_.size() - 1;
+    }
+
+    // A POSIX TZ string such as `CET-1CEST,M3.5.0,M10.5.0/3`, where offsets
+    // are west of UTC and daylight saving time is an hour by default.
+    // Strings that cannot be parsed leave the last transition in effect.
+    void parse_rule(const std::string &rule) {
+        const char * p = rule.c_str();
+        std::string std_name, dst_name;
+        int32_t std_offset = 0, dst_offset = 0;
+        if (!parse_rule_name(p, std_name) || !parse_rule_offset(p, std_offset)) return;
+        std_offset = -std_offset;
+        if (*p == '\0') {
+            rule_std_ = add_period(std_offset, 0, add_abbreviation(std_name));
+            rule_dst_ = rule_std_;
+            has_rule_ = true;
+            fixed_rule_ = true;
+            return;
+        }
+        if (!parse_rule_name(p, dst_name)) return;
+        dst_offset = std_offset + 3600;
+        if (*p != ',' && *p != '\0') {
+            if (!parse_rule_offset(p, dst_offset)) return;
+            dst_offset = -dst_offset;
+        }
+        if (*p != ',') return;
+        p++;
+        if (!parse_rule_date(p, rule_start_) || *p != ',') return;
+        p++;
+        if (!parse_rule_date(p, rule_end_) || *p != '\0') return;
+
+        rule_std_ = add_period(std_offset, 0, add_abbreviation(std_name));
+        rule_dst_ = add_period(std_offset, dst_offset - std_offset, add_abbreviation(dst_name));
+        rule_std_offset_ = std_offset;
+        rule_dst_offset_ = dst_offset;
+        has_rule_ = true;
+    }
+
+    static bool parse_rule_name(const char *&p, std::string &name) {
+        if (*p == '<') {
+            const char * end = strchr(p, '>');
+            if (end == nullptr) return false;
+            name.assign(p + 1, end);
+            p = end + 1;
+        } else {
+            const char * start = p;
+            while (isalpha((unsigned char)*p)) p++;
+            name.assign(start, p);
+        }
+        return name.size() >= 3;
+    }
+
+    // `[+-]hh[:mm[:ss]]`, hours may go up to 167 in rule times
+    static bool parse_rule_offset(const char *&p, int32_t &offset) {
+        int32_t sign = 1;
+        if (*p == '+' || *p == '-') {
+            sign = *p == '-' ? -1 : 1;
+            p++;
+        }
+        if (!isdigit((unsigned char)*p)) return false;
+        int32_t parts[3] = {0, 0, 0};
+        for (int i = 0; i < 3; i++) {
+            if (i > 0) {
+                if (*p != ':') break;
+                p++;
+            }
+            if (!isdigit((unsigned char)*p)) return false;
+            int32_t value = 0;
+            while (isdigit((unsigned char)*p)) value = value * 10 + (*p++ - '0');
+            parts[i] = value;
+        }
+        offset = sign * (parts[0] * 3600 + parts[1] * 60 + parts[2]);
+        return true;
+    }
+
+    static bool parse_rule_number(const char *&p, int32_t &value) {
+        if (!isdigit((unsigned char)*p)) return false;
+        value = 0;
+        while (isdigit((unsigned char)*p)) value = value * 10 + (*p++ - '0');
+        return true;
+    }
+
+    static bool parse_rule_date(const char *&p, RuleDate &date) {
+        if (*p == 'M') {
+            p++;
+            date.kind = 'M';
+            if (!parse_rule_number(p, date.month) || *p++ != '.' || !parse_rule_number(p, date.week) ||
+                *p++ != '.' || !parse_rule_number(p, date.day)) return false;
+            if (date.month < 1 || date.month > 12 || date.week < 1 || date.week > 5 || date.day > 6) return false;
+        } else if (*p == 'J') {
+            p++;
+            date.kind = 'J';
+            if (!parse_rule_number(p, date.day) || date.day < 1 || date.day > 365) return false;
+        } else {
+            date.kind = 'n';
+            if (!parse_rule_number(p, date.day) || date.day > 365) return false;
+        }
+        date.time = 7200;
+        if (*p == '/') {
+            p++;
+            if (!parse_rule_offset(p, date.time)) return false;
+        }
+        return true;
+    }
+
+    static bool is_leap_year(int64_t year) {
+        return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    }
+
+    // the days since the Unix epoch of `date` in `year`
+    static int64_t rule_day(const RuleDate &date, int64_t year) {
+        int64_t first = days_from_civil(year, 1, 1);
+        switch (date.kind) {
+            case 'J': return first + date.day - 1 + (is_leap_year(year) && date.day >= 60 ? 1 : 0);
+            case 'n': return first + date.day;
+            default: break;
+        }
+        int64_t month_first = days_from_civil(year, (unsigned)date.month, 1);
+        int64_t next_month_first = date.month == 12 ? days_from_civil(year + 1, 1, 1) : days_from_civil(year, (unsigned)date.month + 1, 1);
+        // 1970-01-01 is a Thursday
+        int64_t weekday = floor_mod(month_first + 4, 7);
+        int64_t day = month_first + floor_mod(date.day - weekday, 7) + (date.week - 1) * 7;
+        while (day >= next_month_first) day -= 7;
+        return day;
+    }
+
+    // Finds the span of `seconds` between the transitions of the rule in
+    // the years around it.
+    void rule_span(int64_t seconds, AdbcZoneSpan &span) const {
+        if (fixed_rule_) {
+            span.period = rule_std_;
+            return;
+        }
+        int64_t year = civil_from_days(floor_div(seconds + rule_std_offset_, 86400)).year;
+        // (time of the transition in UTC, whether daylight saving time starts)
+        std::vector<std::pair<int64_t, bool>> changes;
+        for (int64_t y = year - 1; y <= year + 1; y++) {
+            // daylight saving time starts in standard time and ends in
+            // daylight saving time
+            changes.emplace_back(rule_day(rule_start_, y) * 86400 + rule_start_.time - rule_std_offset_, true);
+            changes.emplace_back(rule_day(rule_end_, y) * 86400 + rule_end_.time - rule_dst_offset_, false);
+        }
+        std::sort(changes.begin(), changes.end());
+        size_t after = 0;
+        while (after < changes.size() && changes[after].first <= seconds) after++;
+        if (after == 0) {
+            // before the first change of the previous year, impossible as
+            // `seconds` is in the middle year
+            span.period = changes[0].second ? rule_std_ : rule_dst_;
+            span.until = std::min(span.until, changes[0].first);
+            return;
+        }
+        span.period = changes[after - 1].second ? rule_dst_ : rule_std_;
+        span.from = std::max(span.from, changes[after - 1].first);
+        if (after < changes.size()) span.until = changes[after].first;
+    }
+
+    std::string name_;
+    std::vector<std::string> abbreviations_;
+    std::vector<AdbcZonePeriod> periods_;
+    // the period before the first transition
+    size_t initial_period_ = 0;
+    std::vector<int64_t> transitions_;
+    std::vector<size_t> transition_periods_;
+    // the POSIX TZ rule of the times after the last transition
+    bool has_rule_ = false;
+    bool fixed_rule_ = false;
+    size_t rule_std_ = 0;
+    size_t rule_dst_ = 0;
+    int32_t rule_std_offset_ = 0;
+    int32_t rule_dst_offset_ = 0;
+    RuleDate rule_start_;
+    RuleDate rule_end_;
+};
+
+#endif  // ADBC_TIMEZONE_HPP
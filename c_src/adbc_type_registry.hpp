@@ -0,0 +1,100 @@
+#ifndef ADBC_TYPE_REGISTRY_HPP
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <erl_nif.h>
+#include <nanoarrow/nanoarrow.h>
+#include "adbc_consts.h"
+
+// A fixed-width numeric type, tying its `ArrowType`, its Arrow format
+// character, its C type and its `Adbc.Column` type together.
+template <ArrowType Type, char Format, typename T, const ERL_NIF_TERM * ColumnType>
+struct AdbcPrimitiveType {
+    using value_type = T;
+    static constexpr ArrowType type = Type;
+    static constexpr char format = Format;
+    // set from the `on_load` of the NIF library, see `adbc_consts_init`
+    static constexpr const ERL_NIF_TERM * column_type = ColumnType;
+};
+
+// The types converted by the encoder (`adbc_column_to_adbc_field`) and the
+// decoder (`arrow_array_to_nif_term`) with one specialization each, looked
+// up by index in tables built from this list rather than by chains of
+// comparisons on every column.
+using AdbcPrimitiveTypes = std::tuple<
+    AdbcPrimitiveType<NANOARROW_TYPE_INT8, 'c', int8_t, &kAdbcColumnTypeI8>,
+    AdbcPrimitiveType<NANOARROW_TYPE_INT16, 's', int16_t, &kAdbcColumnTypeI16>,
+    AdbcPrimitiveType<NANOARROW_TYPE_INT32, 'i', int32_t, &kAdbcColumnTypeI32>,
+    AdbcPrimitiveType<NANOARROW_TYPE_INT64, 'l', int64_t, &kAdbcColumnTypeI64>,
+    AdbcPrimitiveType<NANOARROW_TYPE_UINT8, 'C', uint8_t, &kAdbcColumnTypeU8>,
+    AdbcPrimitiveType<NANOARROW_TYPE_UINT16, 'S', uint16_t, &kAdbcColumnTypeU16>,
+    AdbcPrimitiveType<NANOARROW_TYPE_UINT32, 'I', uint32_t, &kAdbcColumnTypeU32>,
+    AdbcPrimitiveType<NANOARROW_TYPE_UINT64, 'L', uint64_t, &kAdbcColumnTypeU64>,
+    AdbcPrimitiveType<NANOARROW_TYPE_FLOAT, 'f', float, &kAdbcColumnTypeF32>,
+    AdbcPrimitiveType<NANOARROW_TYPE_DOUBLE, 'g', double, &kAdbcColumnTypeF64>
+>;
+
+constexpr size_t kAdbcPrimitiveTypeCount = std::tuple_size<AdbcPrimitiveTypes>::value;
+
+template <size_t I>
+using AdbcPrimitiveTypeAt = std::tuple_element_t<I, AdbcPrimitiveTypes>;
+
+// An array of `Op<Primitive>::call` for every primitive type, in the order
+// of `AdbcPrimitiveTypes`.
+template <template <typename> class Op, size_t... I>
+constexpr auto adbc_primitive_table(std::index_sequence<I...>) {
+    using Function = decltype(&Op<AdbcPrimitiveTypeAt<0>>::call);
+    return std::array<Function, sizeof...(I)>{&Op<AdbcPrimitiveTypeAt<I>>::call...};
+}
+
+template <template <typename> class Op>
+constexpr auto adbc_primitive_table() {
+    return adbc_primitive_table<Op>(std::make_index_sequence<kAdbcPrimitiveTypeCount>{});
+}
+
+template <size_t... I>
+constexpr std::array<size_t, sizeof...(I)> adbc_primitive_widths(std::index_sequence<I...>) {
+    return {sizeof(typename AdbcPrimitiveTypeAt<I>::value_type)...};
+}
+
+template <size_t... I>
+constexpr std::array<const ERL_NIF_TERM *, sizeof...(I)> adbc_primitive_column_types(std::index_sequence<I...>) {
+    return {AdbcPrimitiveTypeAt<I>::column_type...};
+}
+
+static constexpr auto kAdbcPrimitiveWidths = adbc_primitive_widths(std::make_index_sequence<kAdbcPrimitiveTypeCount>{});
+static constexpr auto kAdbcPrimitiveColumnTypes = adbc_primitive_column_types(std::make_index_sequence<kAdbcPrimitiveTypeCount>{});
+
+template <size_t... I>
+constexpr std::array<int8_t, 256> adbc_primitive_format_index(std::index_sequence<I...>) {
+    std::array<int8_t, 256> index{};
+    for (auto &entry : index) entry = -1;
+    ((index[static_cast<unsigned char>(AdbcPrimitiveTypeAt<I>::format)] = static_cast<int8_t>(I)), ...);
+    return index;
+}
+
+// The index of the primitive type of each format character, or -1
+static constexpr auto kAdbcPrimitiveFormatIndex = adbc_primitive_format_index(std::make_index_sequence<kAdbcPrimitiveTypeCount>{});
+
+// Returns the index in `AdbcPrimitiveTypes` of the type of the Arrow
+// `format`, or -1 if it is not a primitive type.
+static inline int adbc_primitive_index_of_format(const char * format) {
+    if (format[0] == '\0' || format[1] != '\0') return -1;
+    return kAdbcPrimitiveFormatIndex[static_cast<unsigned char>(format[0])];
+}
+
+// Returns the index in `AdbcPrimitiveTypes` of the `Adbc.Column` type
+// `type`, or -1 if it is not a primitive type. Column types of primitives
+// are atoms, which are equal only if they are the same term.
+static inline int adbc_primitive_index_of_column_type(ERL_NIF_TERM type) {
+    for (size_t i = 0; i < kAdbcPrimitiveTypeCount; i++) {
+        if (*kAdbcPrimitiveColumnTypes[i] == type) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+#endif  // ADBC_TYPE_REGISTRY_HPP
@@ -0,0 +1,294 @@
+#ifndef ADBC_WORKER_POOL_HPP
+#define ADBC_WORKER_POOL_HPP
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/// Counters of a `WorkerPool`, see `WorkerPool::stats`.
+struct WorkerPoolStats {
+  size_t threads = 0;
+  bool affinity = false;
+  std::vector<size_t> queue_depths;
+  size_t busy_threads = 0;
+  uint64_t submitted = 0;
+  uint64_t completed = 0;
+  uint64_t stolen = 0;
+  // nanoseconds spent running jobs, by all threads
+  uint64_t busy_time = 0;
+  // nanoseconds since the pool started
+  uint64_t uptime = 0;
+  // threads of the blocking lane, and those running a job
+  size_t blocking_threads = 0;
+  size_t blocking_busy_threads = 0;
+  uint64_t blocking_submitted = 0;
+};
+
+/// Threads for jobs that block in driver calls, such as executing a query
+/// or reading the next batch of a result, for as long as the database or
+/// the ingested stream takes.
+///
+/// A job starts a new thread when no thread is idle, so blocking jobs never
+/// wait for each other, and threads idle for `kIdleTimeout` exit.
+class BlockingLane {
+public:
+  static constexpr std::chrono::seconds kIdleTimeout{30};
+
+  BlockingLane() = default;
+  BlockingLane(const BlockingLane&) = delete;
+  BlockingLane& operator=(const BlockingLane&) = delete;
+
+  void submit(std::function<void()> job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.emplace_back(std::move(job));
+    submitted_++;
+    if (idle_ >= jobs_.size()) {
+      cond_.notify_one();
+      return;
+    }
+
+    threads_++;
+    // the lane is never destroyed, see `get_worker_pool`
+    std::thread([this]() { this->run(); }).detach();
+  }
+
+  void stats(WorkerPoolStats &stats) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.blocking_threads = threads_;
+    stats.blocking_busy_threads = threads_ - idle_;
+    stats.blocking_submitted = submitted_;
+  }
+
+private:
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      if (jobs_.empty()) {
+        idle_++;
+        bool woken = cond_.wait_for(lock, kIdleTimeout, [this]() { return !jobs_.empty(); });
+        idle_--;
+        if (!woken) {
+          threads_--;
+          return;
+        }
+      }
+
+      std::function<void()> job = std::move(jobs_.front());
+      jobs_.pop_front();
+      lock.unlock();
+      job();
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<std::function<void()>> jobs_;
+  size_t threads_ = 0;
+  size_t idle_ = 0;
+  uint64_t submitted_ = 0;
+};
+
+/// A fixed-size pool of native threads that runs the CPU-bound background
+/// work of the NIF, such as parallel conversions, so that none of it
+/// occupies a BEAM scheduler thread or starts threads of its own. Jobs
+/// blocking in driver calls go to the `BlockingLane` of the pool instead,
+/// with `submit_blocking`, so that they never hold the threads that other
+/// jobs, possibly waited on by a dirty scheduler, need.
+///
+/// Each thread has its own queue. Jobs submitted from a worker go to its
+/// own queue, other jobs are spread over the queues in turn, and a thread
+/// whose queue is empty steals the oldest job of the others.
+///
+/// Jobs are plain closures and are responsible for reporting their results
+/// back to Erlang themselves, usually with `enif_send` from a process
+/// independent environment.
+class WorkerPool {
+public:
+  /// Starts `num_workers` threads, pinned to a CPU each in turn with
+  /// `affinity`, where supported.
+  WorkerPool(size_t num_workers, bool affinity) : affinity_(affinity), started_(std::chrono::steady_clock::now()) {
+    num_workers = std::max<size_t>(1, num_workers);
+    queues_.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; i++) {
+      queues_.emplace_back(new Queue());
+    }
+    workers_.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; i++) {
+      workers_.emplace_back([this, i]() { this->run(i); });
+    }
+  }
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  void submit(std::function<void()> job) {
+    size_t index = current_pool_ == this ? current_index_ : next_queue_++ % queues_.size();
+    {
+      // counted before the queue is unlocked, as `take` may pop it right away
+      std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+      queues_[index]->jobs.emplace_back(std::move(job));
+      std::lock_guard<std::mutex> pending_lock(mutex_);
+      pending_++;
+    }
+    submitted_++;
+    cond_.notify_one();
+  }
+
+  /// Runs `job`, which may block in a driver call, on the blocking lane.
+  void submit_blocking(std::function<void()> job) {
+    blocking_.submit(std::move(job));
+  }
+
+  size_t size() const {
+    return workers_.size();
+  }
+
+  WorkerPoolStats stats() {
+    WorkerPoolStats stats;
+    stats.threads = workers_.size();
+    stats.affinity = affinity_;
+    stats.queue_depths.reserve(queues_.size());
+    for (auto &queue : queues_) {
+      std::lock_guard<std::mutex> lock(queue->mutex);
+      stats.queue_depths.push_back(queue->jobs.size());
+    }
+    stats.busy_threads = busy_.load();
+    stats.submitted = submitted_.load();
+    stats.completed = completed_.load();
+    stats.stolen = stolen_.load();
+    stats.busy_time = busy_time_.load();
+    stats.uptime = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started_).count();
+    blocking_.stats(stats);
+    return stats;
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> jobs;
+  };
+
+  void run(size_t index) {
+    current_pool_ = this;
+    current_index_ = index;
+    pin(index);
+
+    while (true) {
+      std::function<void()> job;
+      if (!take(index, job)) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [this]() { return pending_ > 0; });
+        continue;
+      }
+
+      busy_++;
+      auto started = std::chrono::steady_clock::now();
+      job();
+      busy_time_ += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+      busy_--;
+      completed_++;
+    }
+  }
+
+  // Pops the oldest job of the queue of `index`, or else of the first
+  // other queue with any.
+  bool take(size_t index, std::function<void()> &job) {
+    for (size_t i = 0; i < queues_.size(); i++) {
+      Queue &queue = *queues_[(index + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.jobs.empty()) continue;
+      job = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+      {
+        std::lock_guard<std::mutex> pending_lock(mutex_);
+        pending_--;
+      }
+      if (i > 0) stolen_++;
+      return true;
+    }
+    return false;
+  }
+
+  void pin(size_t index) {
+#if defined(__linux__)
+    unsigned cpus = std::thread::hardware_concurrency();
+    if (!affinity_ || cpus == 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(index % cpus, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)index;
+#endif
+  }
+
+  bool affinity_;
+  std::chrono::steady_clock::time_point started_;
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> workers_;
+
+  // guards `pending_`, the number of queued jobs, for sleeping workers
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  size_t pending_ = 0;
+
+  std::atomic<size_t> next_queue_{0};
+  std::atomic<size_t> busy_{0};
+  std::atomic<uint64_t> submitted_{0};
+  std::atomic<uint64_t> completed_{0};
+  std::atomic<uint64_t> stolen_{0};
+  std::atomic<uint64_t> busy_time_{0};
+
+  BlockingLane blocking_;
+
+  static thread_local WorkerPool * current_pool_;
+  static thread_local size_t current_index_;
+};
+
+inline thread_local WorkerPool * WorkerPool::current_pool_ = nullptr;
+inline thread_local size_t WorkerPool::current_index_ = 0;
+
+static std::atomic<WorkerPool *> adbc_worker_pool{nullptr};
+static std::mutex adbc_worker_pool_mutex;
+
+/// Starts the worker pool shared by the whole NIF library with
+/// `num_workers` threads, zero meaning as many as there are CPUs, but at
+/// least 4. Does nothing if it is already started. Each loaded copy of
+/// the library starts a pool of its own.
+static WorkerPool& init_worker_pool(size_t num_workers, bool affinity) {
+  std::lock_guard<std::mutex> lock(adbc_worker_pool_mutex);
+  WorkerPool * pool = adbc_worker_pool.load();
+  if (pool == nullptr) {
+    if (num_workers == 0) num_workers = std::max<size_t>(4, std::thread::hardware_concurrency());
+    pool = new WorkerPool(num_workers, affinity);
+    adbc_worker_pool.store(pool);
+  }
+  return *pool;
+}
+
+/// Returns the worker pool shared by the whole NIF library, started by
+/// `on_load`, or with the defaults of `init_worker_pool` on first use.
+///
+/// The pool is intentionally never destroyed: a worker may be blocked inside
+/// a driver call when the VM halts and joining it would hang the shutdown.
+static WorkerPool& get_worker_pool() {
+  WorkerPool * pool = adbc_worker_pool.load();
+  return pool ? *pool : init_worker_pool(0, false);
+}
+
+#endif  // ADBC_WORKER_POOL_HPP
@@ -19,6 +19,17 @@ defmodule Adbc do
   If you are using a notebook or scripting, you can also use
   `Adbc.download_driver!/1` to dynamically download one.
 
+  Drivers are loaded when the first database using them starts. To
+  load them instead when the `:adbc` application starts, so that the
+  first database after a deploy starts as fast as the following ones,
+  list them under `:preload_drivers`:
+
+      config :adbc, :preload_drivers, [:sqlite, postgresql: [version: "1.0.0"]]
+
+  Each driver is given as in the `:driver` option of `Adbc.Database`,
+  optionally with its `:entrypoint` and `:version`. Drivers are loaded
+  in parallel, and a driver that cannot be loaded is logged.
+
   Then start the database and the relevant connection processes
   in your supervision tree:
 
@@ -46,6 +57,31 @@ defmodule Adbc do
       # When using the conn PID directly
       {:ok, _} = Adbc.Connection.query(conn, "SELECT 123")
 
+  ## Native threads
+
+  CPU-bound work that must not hold a BEAM scheduler, such as the
+  parallel conversions of `Adbc.Connection.query/4`, runs on a single pool
+  of native threads shared by the whole library. It is started when the
+  NIF loads, with as many threads as there are CPUs, but at least 4,
+  unless configured otherwise:
+
+      # 8 threads
+      config :adbc, :worker_threads, 8
+
+      # half as many threads as BEAM schedulers
+      config :adbc, :worker_threads, {:schedulers, 0.5}
+
+  On Linux, `config :adbc, :worker_affinity, true` also pins each thread
+  to a CPU in turn. `worker_pool_stats/0` reports how busy the pool is.
+
+  Drivers do their own I/O and do not expose the sockets of their
+  connections, so a driver call may block until the database answers,
+  which for PostgreSQL includes the time `libpq` waits on the server.
+  Such calls, from asynchronous queries, `:prefetch`ing and ingestion,
+  run outside of the pool, each on a thread of its own, started when no
+  other is idle and stopped after 30 seconds without work, so that
+  they never delay, nor wait for, the work of the pool.
+
   ## Supported drivers
 
   Below we list all drivers supported out of the box. You may also
@@ -73,6 +109,19 @@ defmodule Adbc do
   You must pass the `:uri` option using Postgres'
   [connection URI](https://www.postgresql.org/docs/current/libpq-connect.html#LIBPQ-CONNSTRING):
 
+  The driver reads the `pg_type` catalog once, when the `Adbc.Database`
+  starts, and shares it with all of its connections. Columns of types
+  created afterwards, such as new enums or the types of extensions
+  installed later, are returned as binaries until the database is
+  restarted. Casting them in the query, as in `SELECT mood::text`,
+  returns them as strings regardless.
+
+  The driver reads result sets with `COPY`, which cannot execute a
+  statement prepared on the server. Statements from
+  `Adbc.Connection.prepare/2` may therefore bind parameters to insert or
+  update rows, but not to return them, and queries returning rows are
+  parsed and planned by the server on every execution.
+
   ### Sqlite
 
   The SQLite driver provides access to SQLite databases.
@@ -88,6 +137,27 @@ defmodule Adbc do
   If omitted, it will default to an in-memory database, but
   one that is shared across all connections.
 
+  SQLite columns have no fixed type, so the driver infers the type of each
+  result column from its values in the first record batch, of
+  `"adbc.sqlite.query.batch_rows"` rows (1024 by default). Every column
+  starts as integers and is upcast to floats, then strings, as values of
+  those types are seen, which copies the values read so far. Once the
+  first batch is done, later values are converted to the inferred type or
+  the query fails. When the types are known ahead, `CAST`ing the columns
+  in the query saves the upcasts and keeps the types stable across
+  batches.
+
+  Bound or ingested `Adbc.Column.date32/2` and `Adbc.Column.timestamp/4`
+  values are stored as ISO 8601 text, which the driver formats into a
+  string allocated for every value. Where integers are acceptable, such
+  as for columns compared or sorted by time, binding
+  `DateTime.to_unix/2` integers instead stores them as `INTEGER` and
+  skips the formatting.
+
+  To skip compiling the SQL of repeated queries, connections keep their
+  prepared statements with the `:statement_cache` option of
+  `Adbc.Connection.start_link/1`.
+
   ### Snowflake
 
   The Snowflake driver provides access to Snowflake Database Warehouses.
@@ -107,6 +177,115 @@ defmodule Adbc do
   See [Account identifiers](https://docs.snowflake.com/en/user-guide/admin-account-identifier) for more information.
   """
 
+  @doc """
+  Returns the stats of the native worker pool, see "Native threads".
+
+    * `:threads` - the number of threads of the pool
+    * `:affinity` - whether threads are pinned to CPUs
+    * `:queue_depths` - the number of jobs waiting in the queue of each thread
+    * `:busy_threads` - the number of threads running a job
+    * `:submitted` and `:completed` - the number of jobs queued and
+      run since the pool started
+    * `:stolen` - the number of jobs run by another thread than the one
+      they were queued to
+    * `:busy_time` - the nanoseconds spent running jobs, by all threads
+    * `:uptime` - the nanoseconds since the pool started
+    * `:blocking_threads` and `:blocking_busy_threads` - the number of
+      threads running blocking driver calls, and of those running one now
+    * `:blocking_submitted` - the number of blocking driver calls run
+      since the pool started
+    * `:utilization` - `:busy_time` over the time of all threads since
+      the pool started, from `0.0` to `1.0`
+
+  Utilization over an interval is the difference of `:busy_time` between
+  two calls, divided by `:threads` times the difference of `:uptime`.
+  """
+  @spec worker_pool_stats() :: map
+  def worker_pool_stats do
+    %{busy_time: busy, uptime: uptime, threads: threads} = stats = Adbc.Nif.worker_pool_stats()
+    utilization = if uptime > 0, do: min(busy / (uptime * threads), 1.0), else: 0.0
+    Map.put(stats, :utilization, utilization)
+  end
+
+  @doc """
+  Returns the counters and latency histograms of the hot paths of the
+  native code, kept for all connections since the library was loaded or
+  since `reset_call_stats/0`.
+
+  They are updated by the native code itself with atomic counters, cheap
+  enough to be always on, and are keyed by kind of call, whatever its
+  variant:
+
+    * `:execute_query` - the execution of queries by the driver, until
+      their result set is ready
+    * `:stream_next` - the reads of the record batches of a result set,
+      converted to Elixir terms
+    * `:bind` - the binding of parameters to statements
+    * `:get_objects` - the driver calls of `Adbc.Connection.get_objects/3`
+
+  Each is a map of:
+
+    * `:calls` - the number of calls completed
+    * `:in_flight` - the number of calls running
+    * `:total_time` - the nanoseconds spent in calls completed
+    * `:histogram` - the calls completed by duration, as a list of
+      `{upper_bound, count}` tuples, where `upper_bound` is in
+      microseconds and doubles from a bucket to the next, starting at
+      `1`, the last bucket being `{:infinity, count}`
+
+  The histograms are not cumulative: the calls of each bucket took at
+  least the upper bound of the previous bucket. Quantiles, such as the
+  99th percentile of the latency of reads, can be estimated from them or
+  exported as they are to monitoring systems.
+  """
+  @spec call_stats() :: %{atom => map}
+  def call_stats do
+    Map.new(Adbc.Nif.call_stats(), fn {kind, stats} ->
+      {buckets, stats} = Map.pop(stats, :buckets)
+      bounds = Enum.map(0..(length(buckets) - 2), &:erlang.bsl(1, &1)) ++ [:infinity]
+      {kind, Map.put(stats, :histogram, Enum.zip(bounds, buckets))}
+    end)
+  end
+
+  @doc """
+  Resets the counters and histograms of `call_stats/0`, except for the
+  calls in flight.
+  """
+  @spec reset_call_stats() :: :ok
+  def reset_call_stats, do: Adbc.Nif.reset_call_stats()
+
+  @doc """
+  Evicts all results cached by the `:cache` option of
+  `Adbc.Connection.query/4`.
+
+  Streams already reading a cached result keep its record batches until
+  they are released.
+  """
+  @spec clear_result_cache() :: :ok
+  def clear_result_cache, do: Adbc.Nif.adbc_result_cache_clear()
+
+  @doc """
+  Opens the Arrow IPC file or stream at `path` as a stream of record
+  batches, to be given to `Adbc.Connection.ingest/4`.
+
+  The file is mapped in memory and its record batches point into the
+  mapping, so their bytes reach the driver without being converted, and
+  the pages of the file are only resident while read. Each record batch
+  is validated against the schema of the file before it is handed out.
+  The file stays mapped until the stream is ingested or garbage
+  collected. The stream can only be read once.
+
+  Dictionary-encoded columns and compressed files are not supported,
+  nor is Windows.
+  """
+  @spec open_arrow_file(Path.t()) :: {:ok, reference} | {:error, Exception.t()}
+  def open_arrow_file(path) do
+    case Adbc.Nif.adbc_arrow_ipc_file_open(IO.chardata_to_string(path)) do
+      {:ok, stream_ref} -> {:ok, stream_ref}
+      {:error, reason} -> {:error, Adbc.Helper.error_to_exception(reason)}
+    end
+  end
+
   @doc """
   Downloads a driver.
 
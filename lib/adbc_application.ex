@@ -0,0 +1,35 @@
+defmodule Adbc.Application do
+  @moduledoc false
+  use Application
+  require Logger
+
+  @impl true
+  def start(_type, _args) do
+    preload(Application.get_env(:adbc, :preload_drivers, []))
+    Supervisor.start_link([], strategy: :one_for_one, name: Adbc.Supervisor)
+  end
+
+  # Drivers are loaded in parallel, a driver that cannot be loaded is
+  # logged and left to fail when a database is started for it.
+  defp preload(drivers) do
+    drivers
+    |> Enum.map(fn
+      {driver, opts} -> {driver, opts}
+      driver -> {driver, []}
+    end)
+    |> Task.async_stream(
+      fn {driver, opts} -> {driver, Adbc.Database.preload(driver, opts)} end,
+      ordered: false,
+      timeout: :infinity
+    )
+    |> Enum.each(fn
+      {:ok, {_driver, :ok}} ->
+        :ok
+
+      {:ok, {driver, {:error, error}}} ->
+        Logger.warning(
+          "could not preload Adbc driver #{inspect(driver)}: " <> Exception.message(error)
+        )
+    end)
+  end
+end
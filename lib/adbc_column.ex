@@ -4,7 +4,72 @@ defmodule Adbc.Column do
 
   `Adbc.Column` corresponds to a column in the table. It contains the column's name, type, and
   data. The data is a list of values of the column's data type.
+
+  String and binary view columns are returned as `:string` and `:binary`
+  columns, and run-end encoded columns as columns of the type of their
+  values, where the rows of a run share the term of its value.
+
+  ## Raw columns
+
+  When results are read with the `:raw_columns` option of `Adbc.Connection.query/4`,
+  the data of integer, float, date and timestamp columns is instead
+  `{:raw, values, validity}`:
+
+    * `values` - a binary with the values in the native endianness, each
+      taking the width of the type (for example, 8 bytes for `:i64`). Dates
+      are given in days (`:date32`) or milliseconds (`:date64`) since the
+      Unix epoch and timestamps in their unit since the Unix epoch. The
+      contents of null slots are undefined
+
+    * `validity` - `nil` if there are no nulls, otherwise a bitmap with one
+      bit per value, set if the value is not null. As in Arrow, the first
+      value is the least significant bit of the first byte
+
+  Columns of fixed-width types can also be given as parameters with raw
+  data, built with `raw/3`, in which case the NIF hands the binaries to the
+  driver as Arrow buffers without copying nor converting them. For example,
+  an `Nx` tensor of type `{:f, 32}` can be bound with
+  `Adbc.Column.raw(:f32, Nx.to_binary(tensor))`.
+
+  ## Vector columns
+
+  When results are read with the `:vector_columns` option of
+  `Adbc.Connection.query/4`, top-level fixed-size lists of integers,
+  floats, dates or timestamps are of type `{:fixed_size_list, item_type, size}`
+  and their data is a list with, for each row, a binary of its `size` items
+  in the native endianness, or `nil` for null rows. A column of embeddings
+  of 768 floats can then be read into a tensor with
+  `Nx.from_binary(IO.iodata_to_binary(data), {:f, 32})`.
+
+  ## Lazy columns
+
+  When results are read with the `:lazy_columns` option of `Adbc.Connection.query/4`,
+  the data of top-level columns, except nested ones, is instead
+  `{:lazy, reference, offset, length}`. It references the record batch
+  the column comes from, which is kept in memory for as long as the column
+  is, and is only converted by `to_list/1`. Lazy columns can be sliced
+  with `slice/3` and given back as query parameters without conversion.
+
+  ## Decimal columns
+
+  The data of `{:decimal, bitwidth, precision, scale}` columns is a list
+  of `{coefficient, exponent}` tuples, whose value is
+  `coefficient * 10 ** exponent` and whose exponent is always the opposite
+  of the scale. With the `decimal` package, they can be converted with
+  `Decimal.new(if(coefficient < 0, do: -1, else: 1), abs(coefficient), exponent)`.
+
+  ## Dictionary columns
+
+  Dictionary-encoded columns are decoded to their values by default. When
+  results are read with the `:dictionary_columns` option of
+  `Adbc.Connection.query/4`, the data of top-level dictionary-encoded
+  columns is instead `{:dictionary, indices, values}`, where `values` is the
+  list of distinct values of the dictionary and `indices` a list with, for
+  each row, the position of its value in `values`, or `nil` for nulls. The
+  type of the column is the type of the values.
   """
+
+  import Bitwise
   defstruct name: nil,
             type: nil,
             nullable: false,
@@ -40,6 +105,8 @@ defmodule Adbc.Column do
           | {:timestamp, :milliseconds, String.t()}
           | {:timestamp, :microseconds, String.t()}
           | {:timestamp, :nanoseconds, String.t()}
+  @type decimal_t ::
+          {:decimal, bitwidth :: 128 | 256, precision :: pos_integer(), scale :: integer()}
   @type data_type ::
           :boolean
           | signed_integer
@@ -55,6 +122,13 @@ defmodule Adbc.Column do
           | time32_t
           | time64_t
           | timestamp_t
+          | decimal_t
+
+  @type raw_data :: {:raw, values :: binary, validity :: binary | nil}
+  @type lazy_data ::
+          {:lazy, reference(), offset :: non_neg_integer(), length :: non_neg_integer()}
+
+  @type dictionary_data :: {:dictionary, indices :: [non_neg_integer() | nil], values :: list}
 
   @spec column(data_type(), list, Keyword.t()) :: %Adbc.Column{}
   def column(type, data, opts \\ [])
@@ -72,6 +146,41 @@ defmodule Adbc.Column do
     }
   end
 
+  @doc """
+  A column of a fixed-width `type` whose data is given as raw binaries.
+
+  `values` is a binary with the values in the native endianness, which is
+  bound without being copied. See the "Raw columns" section of the module
+  documentation.
+
+  ## Options
+
+  * `:validity` - A bitmap with one bit per value, set if the value is not
+    null, or `nil` if there are no nulls. Defaults to `nil`
+  * `:name` - The name of the column
+  * `:nullable` - A boolean value indicating whether the column is nullable,
+    defaults to `true` when a validity bitmap is given
+  * `:metadata` - A map of metadata
+
+  ## Examples
+
+      iex> Adbc.Column.raw(:i32, <<1::32-native, 2::32-native>>)
+      %Adbc.Column{
+        name: nil,
+        type: :i32,
+        nullable: false,
+        metadata: nil,
+        data: {:raw, <<1::32-native, 2::32-native>>, nil}
+      }
+
+  """
+  @spec raw(data_type(), binary, Keyword.t()) :: %Adbc.Column{}
+  def raw(type, values, opts \\ []) when is_binary(values) and is_list(opts) do
+    {validity, opts} = Keyword.pop(opts, :validity)
+    opts = Keyword.put_new(opts, :nullable, validity != nil)
+    %Adbc.Column{column(type, [], opts) | data: {:raw, values, validity}}
+  end
+
   @spec get_metadata(%Adbc.Column{}, String.t(), String.t() | nil) :: String.t() | nil
   def get_metadata(%Adbc.Column{metadata: metadata}, key, default \\ nil)
       when is_binary(key) or is_atom(key) do
@@ -95,6 +204,208 @@ defmodule Adbc.Column do
     %Adbc.Column{buffer | metadata: %{}}
   end
 
+  @doc """
+  Returns the values of `column` as a list.
+
+  Raw, lazy and dictionary columns are converted, the data of other
+  columns is returned as is.
+  """
+  @spec to_list(%Adbc.Column{}) :: list
+  def to_list(%Adbc.Column{type: type, data: data}), do: data_to_list(type, data)
+
+  @doc """
+  Returns a column with `length` values of `column` starting at `offset`.
+
+  Lazy columns stay lazy and keep referencing the same record batch.
+  """
+  @spec slice(%Adbc.Column{}, non_neg_integer(), non_neg_integer()) :: %Adbc.Column{}
+  def slice(%Adbc.Column{type: type, data: data} = column, offset, length)
+      when is_integer(offset) and offset >= 0 and is_integer(length) and length >= 0 do
+    %Adbc.Column{column | data: slice_data(type, data, offset, length)}
+  end
+
+  @doc false
+  # Concatenates the data of the chunks of a column, one per record batch.
+  def concat_data(type, chunks) do
+    cond do
+      Enum.all?(chunks, &is_list/1) ->
+        Enum.concat(chunks)
+
+      Enum.all?(chunks, &match?({:raw, _, _}, &1)) ->
+        concat_raw(type, chunks)
+
+      Enum.all?(chunks, &match?({:dictionary, _, _}, &1)) ->
+        concat_dictionary(chunks)
+
+      Enum.all?(chunks, &match?({:lazy, _, _, _}, &1)) ->
+        case Adbc.Nif.adbc_column_concat(chunks) do
+          {:ok, data} -> data
+          {:error, _reason} -> Enum.flat_map(chunks, &data_to_list(type, &1))
+        end
+
+      true ->
+        Enum.flat_map(chunks, &data_to_list(type, &1))
+    end
+  end
+
+  defp concat_raw(type, chunks) do
+    values = IO.iodata_to_binary(for {:raw, values, _} <- chunks, do: values)
+
+    validity =
+      if Enum.any?(chunks, &match?({:raw, _, validity} when validity != nil, &1)) do
+        width = raw_width(type)
+
+        chunks
+        |> Enum.map(fn {:raw, values, validity} ->
+          validity_bits(validity, div(byte_size(values), width))
+        end)
+        |> :erlang.list_to_bitstring()
+        |> validity_from_bits()
+      end
+
+    {:raw, values, validity}
+  end
+
+  # The dictionary of each batch is kept and its indices are shifted past
+  # the values of the previous ones, so no value is converted again
+  defp concat_dictionary(chunks) do
+    {indices, values, _size} =
+      Enum.reduce(chunks, {[], [], 0}, fn {:dictionary, indices, values}, {acc, vals, size} ->
+        shifted = Enum.map(indices, &(&1 && &1 + size))
+        {[shifted | acc], [values | vals], size + length(values)}
+      end)
+
+    indices = indices |> Enum.reverse() |> Enum.concat()
+    values = values |> Enum.reverse() |> Enum.concat()
+    {:dictionary, indices, values}
+  end
+
+  defp data_to_list(_type, data) when is_list(data), do: data
+
+  defp data_to_list(_type, {:dictionary, indices, values}) do
+    values = List.to_tuple(values)
+    Enum.map(indices, &(&1 && elem(values, &1)))
+  end
+
+  defp data_to_list(_type, {:lazy, reference, offset, length}) do
+    case Adbc.Nif.adbc_column_materialize(reference, offset, length) do
+      {:ok, list} -> list
+      {:error, reason} -> raise Adbc.Helper.error_to_exception(reason)
+    end
+  end
+
+  defp data_to_list(type, {:raw, values, validity}) do
+    list = raw_to_list(type, values)
+
+    if validity do
+      bits = validity_bits(validity, length(list))
+      Enum.zip_with(list, for(<<bit::1 <- bits>>, do: bit), fn
+        value, 1 -> value
+        _value, 0 -> nil
+      end)
+    else
+      list
+    end
+  end
+
+  defp slice_data(_type, data, offset, length) when is_list(data),
+    do: Enum.slice(data, offset, length)
+
+  defp slice_data(_type, {:dictionary, indices, values}, offset, length),
+    do: {:dictionary, Enum.slice(indices, offset, length), values}
+
+  defp slice_data(_type, {:lazy, reference, start, size}, offset, length) do
+    offset = min(offset, size)
+    {:lazy, reference, start + offset, min(length, size - offset)}
+  end
+
+  defp slice_data(type, {:raw, values, validity}, offset, length) do
+    width = raw_width(type)
+    size = div(byte_size(values), width)
+    offset = min(offset, size)
+    length = min(length, size - offset)
+
+    validity =
+      if validity do
+        <<_::size(offset), bits::bitstring-size(length), _::bitstring>> =
+          validity_bits(validity, size)
+
+        validity_from_bits(bits)
+      end
+
+    {:raw, binary_part(values, offset * width, length * width), validity}
+  end
+
+  defp raw_width(type) when type in [:i8, :u8], do: 1
+  defp raw_width(type) when type in [:i16, :u16], do: 2
+  defp raw_width(type) when type in [:i32, :u32, :f32, :date32], do: 4
+  defp raw_width(_type), do: 8
+
+  @unix_epoch ~N[1970-01-01 00:00:00]
+
+  defp raw_to_list(type, values) do
+    case type do
+      :i8 -> for <<v::8-signed-native <- values>>, do: v
+      :i16 -> for <<v::16-signed-native <- values>>, do: v
+      :i32 -> for <<v::32-signed-native <- values>>, do: v
+      :i64 -> for <<v::64-signed-native <- values>>, do: v
+      :u8 -> for <<v::8-unsigned-native <- values>>, do: v
+      :u16 -> for <<v::16-unsigned-native <- values>>, do: v
+      :u32 -> for <<v::32-unsigned-native <- values>>, do: v
+      :u64 -> for <<v::64-unsigned-native <- values>>, do: v
+      :f32 -> for <<v::binary-size(4) <- values>>, do: raw_float(v)
+      :f64 -> for <<v::binary-size(8) <- values>>, do: raw_float(v)
+      :date32 -> for <<v::32-signed-native <- values>>, do: Date.add(~D[1970-01-01], v)
+      :date64 -> for <<v::64-signed-native <- values>>, do: date_from_milliseconds(v)
+      {:timestamp, unit, _} -> for <<v::64-signed-native <- values>>, do: raw_timestamp(v, unit)
+    end
+  end
+
+  # non-finite floats do not match float segments
+  defp raw_float(<<value::32-float-native>>), do: value
+  defp raw_float(<<value::64-float-native>>), do: value
+  defp raw_float(<<bits::32-native>>), do: non_finite(bits >>> 31, bits &&& 0x7FFFFF)
+  defp raw_float(<<bits::64-native>>), do: non_finite(bits >>> 63, bits &&& 0xFFFFFFFFFFFFF)
+
+  defp non_finite(_sign, mantissa) when mantissa != 0, do: :nan
+  defp non_finite(0, _mantissa), do: :infinity
+  defp non_finite(1, _mantissa), do: :neg_infinity
+
+  defp date_from_milliseconds(ms),
+    do: Date.add(~D[1970-01-01], Integer.floor_div(ms, 86_400_000))
+
+  defp raw_timestamp(value, :seconds), do: NaiveDateTime.add(@unix_epoch, value, :second)
+
+  defp raw_timestamp(value, :milliseconds),
+    do: NaiveDateTime.add(%{@unix_epoch | microsecond: {0, 3}}, value, :millisecond)
+
+  defp raw_timestamp(value, :microseconds),
+    do: NaiveDateTime.add(%{@unix_epoch | microsecond: {0, 6}}, value, :microsecond)
+
+  defp raw_timestamp(value, :nanoseconds),
+    do: raw_timestamp(Integer.floor_div(value, 1000), :microseconds)
+
+  # Arrow bitmaps store the first value in the least significant bit of
+  # each byte, while Elixir bitstrings start with the most significant one,
+  # so the bits of each byte are reversed to work on them as bitstrings.
+  defp validity_bits(nil, size), do: <<-1::size(size)>>
+
+  defp validity_bits(validity, size) do
+    <<bits::bitstring-size(size), _::bitstring>> = reverse_bits(validity)
+    bits
+  end
+
+  defp validity_from_bits(bits) do
+    padding = rem(8 - rem(bit_size(bits), 8), 8)
+    reverse_bits(<<bits::bitstring, 0::size(padding)>>)
+  end
+
+  defp reverse_bits(bitmap) do
+    for <<b0::1, b1::1, b2::1, b3::1, b4::1, b5::1, b6::1, b7::1 <- bitmap>>,
+      into: <<>>,
+      do: <<b7::1, b6::1, b5::1, b4::1, b3::1, b2::1, b1::1, b0::1>>
+  end
+
   @doc """
   A column that contains booleans.
 
@@ -737,4 +1048,80 @@ defmodule Adbc.Column do
       when is_list(data) and is_binary(timezone) and is_list(opts) do
     column({:timestamp, :nanoseconds, timezone}, data, opts)
   end
+
+  @doc """
+  A column that contains decimals with the given precision and scale.
+
+  ## Arguments
+
+  * `data`:
+    * a list of `{coefficient, exponent}` tuples, whose value is
+      `coefficient * 10 ** exponent`
+    * a list of `Decimal` structs
+    * a list of integers
+
+    Values are rescaled to `scale`, an `ArgumentError` is raised if that
+    would lose digits.
+
+  * `precision`: the number of significant digits, up to 38 for 128-bit
+    decimals and up to 76 for 256-bit decimals
+
+  * `scale`: the number of digits after the decimal point
+
+  * `opts`: A keyword list of options
+
+  ## Options
+
+  * `:name` - The name of the column
+  * `:nullable` - A boolean value indicating whether the column is nullable
+  * `:metadata` - A map of metadata
+  * `:bitwidth` - `128` or `256`, defaults to `128` if `precision` is at
+    most 38 and to `256` otherwise
+
+  ## Examples
+
+      iex> Adbc.Column.decimal([{1234, -2}, 5, nil], 10, 2, nullable: true)
+      %Adbc.Column{
+        name: nil,
+        type: {:decimal, 128, 10, 2},
+        nullable: true,
+        metadata: nil,
+        data: [{1234, -2}, {500, -2}, nil]
+      }
+
+  """
+  @spec decimal(list, pos_integer(), integer(), Keyword.t()) :: %Adbc.Column{}
+  def decimal(data, precision, scale, opts \\ [])
+      when is_list(data) and is_integer(precision) and precision > 0 and is_integer(scale) and
+             is_list(opts) do
+    {bitwidth, opts} = Keyword.pop(opts, :bitwidth, if(precision <= 38, do: 128, else: 256))
+    data = Enum.map(data, &rescale_decimal(&1, scale))
+    column({:decimal, bitwidth, precision, scale}, data, opts)
+  end
+
+  defp rescale_decimal(nil, _scale), do: nil
+  defp rescale_decimal(value, scale) when is_integer(value),
+    do: rescale_decimal({value, 0}, scale)
+
+  defp rescale_decimal(%{__struct__: Decimal, sign: sign, coef: coef, exp: exp}, scale)
+       when is_integer(coef),
+       do: rescale_decimal({sign * coef, exp}, scale)
+
+  defp rescale_decimal({coef, exp}, scale) when is_integer(coef) and exp >= -scale,
+    do: {coef * Integer.pow(10, exp + scale), -scale}
+
+  defp rescale_decimal({coef, exp} = value, scale) when is_integer(coef) and is_integer(exp) do
+    divisor = Integer.pow(10, -scale - exp)
+
+    if rem(coef, divisor) != 0 do
+      raise ArgumentError,
+            "cannot represent #{inspect(value)} with a scale of #{scale} without losing digits"
+    end
+
+    {div(coef, divisor), -scale}
+  end
+
+  defp rescale_decimal(value, _scale) do
+    raise ArgumentError, "expected a decimal value, got: #{inspect(value)}"
+  end
 end
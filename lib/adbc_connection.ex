@@ -4,6 +4,22 @@ defmodule Adbc.Connection do
 
   Connection are modelled as processes. They require
   an `Adbc.Database` to be started.
+
+  ## Metadata cache
+
+  The results of `get_info/3`, `get_objects/3`, `get_table_types/2`,
+  `get_statistics/2` and `get_statistic_names/2` are cached natively with
+  their `:cache` option, for the given number of milliseconds, by the
+  driver and database of the connection and the arguments of the call.
+  Any connection to the same database then reads them again instead of
+  querying the catalog, until they expire or are evicted with
+  `clear_metadata_cache/1`. They share the budget of the results cached
+  by `query/4`.
+
+  A connection evicts them before running statements starting with
+  `CREATE`, `ALTER`, `DROP`, `RENAME`, `TRUNCATE` or `COMMENT` and before
+  ingesting data, as those may change the catalog. Changes made by other
+  clients of the database are only seen once the results expire.
   """
 
   @type t :: GenServer.server()
@@ -12,6 +28,48 @@ defmodule Adbc.Connection do
   use GenServer
   import Adbc.Helper, only: [error_to_exception: 1]
 
+  @ingest_modes %{
+    create: "adbc.ingest.mode.create",
+    append: "adbc.ingest.mode.append",
+    replace: "adbc.ingest.mode.replace",
+    create_append: "adbc.ingest.mode.create_append"
+  }
+
+  # in the order they are dequeued
+  @priorities [:high, :normal, :low]
+
+  # Options of `query/4` that apply to reading the results rather than
+  # being given to the driver as statement options
+  @stream_options [
+    :prefetch,
+    :prefetch_bytes,
+    :target_batch_time,
+    :coalesce_rows,
+    :coalesce_bytes,
+    :zero_copy_binaries,
+    :raw_columns,
+    :vector_columns,
+    :lazy_columns,
+    :dictionary_columns,
+    :numeric_columns,
+    :intern_columns,
+    :intern_atoms,
+    :datetime_columns,
+    :output,
+    :parallel_batches,
+    :parallel_columns,
+    :shared,
+    :spill
+  ]
+
+  @limit_options [:max_result_bytes, :max_rows]
+
+  # statements which may change what `get_objects/3` returns
+  @ddl ~r/^\s*(create|alter|drop|rename|truncate|comment)\b/i
+
+  # the number of batches read ahead when only `:prefetch_bytes` is given
+  @max_prefetch 1024
+
   @doc """
   Starts a connection process.
 
@@ -22,6 +80,26 @@ defmodule Adbc.Connection do
     * `:process_options` - the options to be given to the underlying
       process. See `GenServer.start_link/3` for all options
 
+    * `:statement_cache` - the number of prepared statements to keep,
+      defaults to `0` (no cache). Queries given as binaries then reuse the
+      statement prepared for the same query and statement options, which
+      is only bound to the new parameters, evicting the least recently used
+      statement once the cache is full. Statements whose execution fails are
+      evicted too. As a statement keeps its parameters, a cached query run
+      without parameters reuses those of its previous run
+
+    * `:max_result_bytes` - the default of the option of the same name of
+      `query/4`, defaults to `nil` (no limit)
+
+    * `:max_rows` - the default of the option of the same name of
+      `query/4`, defaults to `nil` (no limit)
+
+    * `:queue_limits` - the number of calls of each priority that may
+      wait for the connection, as a keyword list such as `[low: 10]`,
+      see the `:priority` option of `query/4`. Calls made while the
+      queue of their priority is full return an error right away.
+      Priorities without a limit can queue any number of calls
+
   ## Examples
 
       Adbc.Connection.start_link(
@@ -46,10 +124,32 @@ defmodule Adbc.Connection do
     end
 
     {process_options, opts} = Keyword.pop(opts, :process_options, [])
+    {statement_cache, opts} = Keyword.pop(opts, :statement_cache, 0)
+
+    unless is_integer(statement_cache) and statement_cache >= 0 do
+      raise ArgumentError, ":statement_cache must be a non-negative integer"
+    end
+
+    {limits, opts} = Keyword.split(opts, @limit_options)
+    validate_limits!(limits)
+
+    {queue_limits, opts} = Keyword.pop(opts, :queue_limits, [])
+
+    unless Keyword.keyword?(queue_limits) and
+             Enum.all?(queue_limits, fn {priority, limit} ->
+               priority in @priorities and is_integer(limit) and limit >= 0
+             end) do
+      raise ArgumentError,
+            ":queue_limits must be a keyword list of #{inspect(@priorities)} to " <>
+              "non-negative integers, got: #{inspect(queue_limits)}"
+    end
+
+    queue_limits = Map.new(queue_limits)
 
     with {:ok, conn} <- Adbc.Nif.adbc_connection_new(),
          :ok <- init_options(conn, opts) do
-      GenServer.start_link(__MODULE__, {db, conn}, process_options)
+      args = {db, conn, statement_cache, limits, queue_limits}
+      GenServer.start_link(__MODULE__, args, process_options)
     else
       {:error, reason} -> {:error, error_to_exception(reason)}
     end
@@ -119,7 +219,8 @@ defmodule Adbc.Connection do
     Adbc.Helper.option(conn, :adbc_connection_set_option, [:float, key, value])
   end
 
-  defp init_options(ref, opts) do
+  @doc false
+  def init_options(ref, opts) do
     Enum.reduce_while(opts, :ok, fn
       {key, value}, :ok when is_atom(value) or is_binary(value) ->
         Adbc.Helper.option_ok_or_halt(ref, :adbc_connection_set_option, [:string, key, value])
@@ -153,13 +254,277 @@ defmodule Adbc.Connection do
 
   @doc """
   Runs the given `query` with `params` and `statement_options`.
+
+  `params` is either a list of parameters or a list of rows, each a list
+  of parameters. Parameters are integers, floats, binaries, booleans,
+  `nil` or `Adbc.Column`s. A column binds one row per value, so all
+  columns must have the same length and other parameters are then given
+  as single-value columns. In both forms, all the rows are bound at once
+  and the driver executes the statement for each of them, which is much
+  faster than one query per row. The type of each parameter given in rows
+  is inferred from its values.
+
+  A parameter may also be `{:array, values}`, a list of values bound as a
+  single parameter holding the text of a SQL array, such as `{1,2,3}`,
+  which PostgreSQL casts to an array of the type given in the query. A
+  whole list of values then takes a single statement and round trip:
+
+      Adbc.Connection.query(conn, "DELETE FROM users WHERE id = ANY($1::bigint[])", [
+        {:array, ids}
+      ])
+
+      Adbc.Connection.query(
+        conn,
+        "UPDATE users SET name = u.name FROM unnest($1::bigint[], $2::text[]) AS u(id, name) " <>
+          "WHERE users.id = u.id",
+        [{:array, ids}, {:array, names}]
+      )
+
+  Values are integers, floats, binaries, booleans, `nil`, nested
+  `{:array, values}` for multidimensional arrays, or any term that
+  implements `String.Chars` in the text format of its type, such as dates.
+
+  ## Options
+
+  Besides statement options given to the driver, `statement_options`
+  accepts:
+
+    * `:timeout` - the time in milliseconds the query may run for,
+      defaults to `:infinity`. Once it elapses, the query is cancelled
+      with `AdbcStatementCancel` and an error is returned. Queries are
+      also cancelled if the caller exits while they run. Cancellation is
+      not available when the database uses the `:normal` scheduler,
+      as queries then run within the connection process
+
+    * `:prefetch` - the number of record batches to read ahead on the
+      native threads while the current one is converted, defaults to `0`
+      (no prefetching). Useful for large results from remote databases,
+      as fetching and conversion then overlap
+
+    * `:prefetch_bytes` - the maximum size in bytes of the Arrow buffers
+      of the record batches read ahead, defaults to `nil` (no limit). At
+      least one batch is always read ahead. When given without
+      `:prefetch`, batches are read ahead up to this size alone
+
+    * `:target_batch_time` - the time in milliseconds each record batch
+      should take to convert, defaults to `nil` (batches are converted as
+      the driver returns them). The time the caller takes per row is
+      measured as batches are read, and consecutive small batches are
+      concatenated natively up to the rows expected to take this long, so
+      the cost of each call is paid once per many rows. Results with
+      nested or dictionary-encoded columns are read as is
+
+    * `:coalesce_rows` - the number of rows to concatenate consecutive
+      record batches natively up to before converting them, defaults to
+      `nil`. Useful for drivers returning many small batches, such as
+      selective PostgreSQL queries. Ignored with `:target_batch_time`
+
+    * `:coalesce_bytes` - the size in bytes of the Arrow buffers to
+      concatenate consecutive record batches natively up to, defaults to
+      `nil`. When given with `:coalesce_rows`, batches are concatenated
+      until either is reached. Ignored with `:target_batch_time`
+
+    * `:zero_copy_binaries` - when `true`, string and binary columns
+      reference the memory of the record batch they come from instead
+      of copying each value, defaults to `false`. A record batch is then
+      kept in memory for as long as any of its values is referenced.
+      Only top-level columns are affected
+
+    * `:raw_columns` - when `true`, top-level integer, float, date and
+      timestamp columns hold their values as a single native-endian binary
+      instead of a list, defaults to `false`. See `Adbc.Column` for the
+      representation, which can be given directly to libraries such as
+      Nx or Explorer
+
+    * `:vector_columns` - when `true`, top-level fixed-size list columns of
+      integers, floats, dates or timestamps, such as embeddings, hold a
+      native-endian binary of the items of each row instead of a nested
+      column, defaults to `false`. Their type is
+      `{:fixed_size_list, item_type, size}`. With `:zero_copy_binaries`,
+      the binaries reference the record batch instead of copying it
+
+    * `:lazy_columns` - when `true`, top-level columns that are not nested
+      reference the record batch they come from and are only converted by
+      `Adbc.Column.to_list/1`, defaults to `false`. Useful when only some
+      columns or rows of a result are read. Results spanning several
+      record batches are concatenated into a single lazy column
+
+    * `:dictionary_columns` - when `true`, dictionary-encoded top-level
+      columns hold their indices and the values of their dictionary
+      instead of the decoded values, defaults to `false`. See `Adbc.Column`
+      for the representation. Decoded values repeated across rows of a
+      record batch share the same term either way
+
+    * `:numeric_columns` - when `true`, top-level PostgreSQL `numeric`
+      columns, which the driver returns as strings, are parsed natively
+      into `{:decimal, 128, 38, scale}` columns, defaults to `false`. As
+      Arrow has no scale for them, the scale is the largest one in their
+      first record batch. Values with more fractional digits keep their
+      own exponent, while `NaN`, infinities and values of more than 38
+      digits are kept as strings
+
+    * `:intern_columns` - `true` or a list of names of top-level string
+      and binary columns whose repeated values are returned as the same
+      binary within each record batch, instead of a binary per value,
+      defaults to `false`. Useful for columns of a few distinct values,
+      such as statuses or categories, as results then take far less
+      memory. A column stops being interned once a record batch has 4096
+      distinct values in it, or, past its first 4096 rows, distinct values
+      in more than a quarter of its rows
+
+    * `:intern_atoms` - when `true`, values of columns in `:intern_columns`
+      that are ASCII names of existing atoms are returned as those atoms
+      instead, defaults to `false`
+
+    * `:datetime_columns` - when `true`, values of top-level timestamp
+      columns with a time zone are returned as `DateTime`s in that zone
+      instead of `NaiveDateTime`s in UTC, defaults to `false`. Zones are
+      read once per query from the zoneinfo database of the system, in
+      `TZDIR` or `/usr/share/zoneinfo`, so no time zone database needs to
+      be configured in Elixir. `UTC` and fixed offsets such as `+01:00`
+      need no database. An unknown zone returns an error
+
+    * `:parallel_batches` - the number of record batches to convert at
+      once on native threads, defaults to `0` (batches are converted one
+      at a time as they are read). Batches are still returned in order.
+      Useful for results of many batches whose conversion takes longer
+      than fetching them. Ignored with `:zero_copy_binaries`, `:raw_columns`,
+      `:vector_columns`, `:lazy_columns`, `:dictionary_columns`, `:numeric_columns`,
+      `:intern_columns` or `:datetime_columns`, and
+      results are then not concatenated natively before being converted
+
+    * `:parallel_columns` - when `true`, the columns of each record batch
+      of at least 65536 values are converted at once on native threads,
+      a range of columns per thread, defaults to `false`. Useful for wide
+      results, as each thread builds the terms of its columns on its own,
+      and they are then copied into the caller. Ignored with the same
+      options as `:parallel_batches`, or when combined with it, and results
+      are then not concatenated natively before being converted
+
+    * `:output` - the shape of the `:data` of the result, defaults to
+      `:columns`, a list of `Adbc.Column`. `:rows_tuples` returns a list
+      of rows as tuples, in the order of the columns, and `:rows_maps`
+      returns a list of rows as maps from column names to values. Rows are
+      built natively as each record batch is read. `:raw_columns`,
+      `:vector_columns`, `:lazy_columns`, `:dictionary_columns` and
+      `:numeric_columns` only
+      apply to `:columns`
+
+    * `:max_result_bytes` - the maximum size in bytes of the Arrow buffers
+      of the result, defaults to the option of the same name given to
+      `start_link/1`. Each record batch is measured once it is fetched and
+      before it is converted. Once the limit is exceeded, the query is
+      cancelled, its result released and an `Adbc.Error` with the
+      `"54000"` SQL state is returned
+
+    * `:max_rows` - the maximum number of rows of the result, defaults to
+      the option of the same name given to `start_link/1`, enforced as
+      `:max_result_bytes`. With `:prefetch`, up to that many batches more
+      may be held before the limit is detected
+
+    * `:shared` - when `true`, the `:data` of the result is an
+      `Adbc.SharedResult`, which keeps the record batches of the result
+      natively instead of converting them, defaults to `false`. It can be
+      sent to other processes without copying the result, and read with
+      `Adbc.SharedResult.to_result/2` by any of them. The options shaping
+      the result are then given to `Adbc.SharedResult.to_result/2`
+      instead
+
+    * `:spill` - same as `:shared`, but the record batches are written to
+      a temporary file as they are fetched, which is then mapped in
+      memory to read them back without copying. Only one batch at a time
+      is held in memory while the query runs, and the pages of the file
+      are only resident while read, so results larger than memory can be
+      read many times and out of order. It is `true` to write the file to
+      `System.tmp_dir!/0`, or the directory to write it to, defaults to
+      `false`. The file is deleted once the result is garbage collected.
+      Not supported on Windows
+
+    * `:cache` - the number of milliseconds to cache the result for,
+      defaults to `nil` (no caching). The record batches of the result
+      are kept natively, keyed by the driver and database of the
+      connection, the query, its parameters and statement options, and
+      running the same query while cached reads them again instead of
+      running it. Results are only cached once fully read, and are
+      evicted, least recently used first, when all cached results exceed
+      the `:result_cache_bytes` config, which defaults to 64 MiB. See
+      `Adbc.clear_result_cache/0`
+
+    * `:trusted_params` - when `true`, the Arrow arrays of `params` are
+      built without being validated, defaults to `false`. Values are still
+      converted to their column type, but the arrays are not checked once
+      built, which saves a pass over large columns of parameters. Only
+      use it for parameters built by your own code, as invalid ones may
+      then reach the driver
+
+    * `:priority` - `:high`, `:normal` or `:low`, defaults to `:normal`.
+      Calls waiting for the connection run by priority first, and in the
+      order they were made within a priority, so that short interactive
+      queries are not stuck behind queued analytic ones. A running query
+      is never interrupted, nor is a stream while it is being read. See
+      the `:queue_limits` option of `start_link/1`
   """
   @spec query(t(), binary | reference, [term], Keyword.t()) ::
           {:ok, result_set} | {:error, Exception.t()}
   def query(conn, query, params \\ [], statement_options \\ [])
       when (is_binary(query) or is_reference(query)) and is_list(params) and
              is_list(statement_options) do
-    stream(conn, {:query, query, params, statement_options}, &stream_results/2)
+    {priority, statement_options} = pop_priority!(statement_options)
+    {stream_options, statement_options} = Keyword.split(statement_options, @stream_options)
+    command = query_command(:query, query, params, statement_options)
+
+    Adbc.Telemetry.span(%{connection: conn, query: query}, fn telemetry ->
+      consume(
+        conn,
+        command,
+        fn scheduler, stream_ref, rows ->
+          read_results(scheduler, stream_ref, rows, stream_options, telemetry)
+        end,
+        priority
+      )
+    end)
+  end
+
+  @doc false
+  def pop_priority!(options) do
+    case Keyword.pop(options, :priority, :normal) do
+      {priority, options} when priority in @priorities ->
+        {priority, options}
+
+      {priority, _options} ->
+        raise ArgumentError,
+              ":priority must be one of #{inspect(@priorities)}, got: #{inspect(priority)}"
+    end
+  end
+
+  # The connection completes the key with its driver and database. The
+  # limits and timeout only bound the same result, so they are not part of it
+  defp cache_option(nil, _query, _params, statement_options), do: statement_options
+
+  defp cache_option(ttl, query, params, statement_options) when is_integer(ttl) and ttl > 0 do
+    key = {query, params, Keyword.drop(statement_options, [:timeout | @limit_options])}
+    [{:cache, {ttl, key}} | statement_options]
+  end
+
+  defp cache_option(ttl, _query, _params, _statement_options) do
+    raise ArgumentError, ":cache must be nil or a positive integer, got: #{inspect(ttl)}"
+  end
+
+  # Options read by the connection process are validated in the caller,
+  # as an invalid one would otherwise crash the connection
+  defp query_command(kind, query, params, statement_options) do
+    validate_timeout!(Keyword.get(statement_options, :timeout, :infinity))
+    validate_limits!(Keyword.take(statement_options, @limit_options))
+    {cache, statement_options} = Keyword.pop(statement_options, :cache)
+    statement_options = cache_option(cache, query, params, statement_options)
+    {kind, query, params, statement_options}
+  end
+
+  defp validate_timeout!(timeout) do
+    unless timeout == :infinity or (is_integer(timeout) and timeout >= 0) do
+      raise ArgumentError,
+            ":timeout must be :infinity or a non-negative integer, got: #{inspect(timeout)}"
+    end
   end
 
   @doc """
@@ -176,342 +541,2041 @@ defmodule Adbc.Connection do
   end
 
   @doc """
-  Prepares the given `query`.
-  """
-  @spec prepare(t(), binary) :: {:ok, reference} | {:error, Exception.t()}
-  def prepare(conn, query) when is_binary(query) do
-    command(conn, {:prepare, query})
-  end
+  Runs the given `query` with `params` and returns a stream of its
+  results, one `Adbc.Result` per record batch.
+
+  The query runs once the stream is enumerated, and each record batch is
+  only fetched and converted when the next element is requested, so
+  results larger than the available memory can be processed in constant
+  memory. The connection stays locked by the enumerating process until
+  the enumeration completes or halts, which releases the result.
+
+  Accepts the same `statement_options` as `query/4`, except that record
+  batches are never concatenated, so `:lazy_columns` columns reference
+  their own batch. Errors raise once the stream is enumerated.
+
+  With the `:cursor_rows` option, the query instead runs in a server-side
+  cursor, declared in a transaction of its own with `DECLARE ... CURSOR`,
+  and each element is the `Adbc.Result` of a `FETCH` of up to that many
+  rows. The server then only produces rows as they are requested, so
+  memory stays bounded by `:cursor_rows` even when the stream is consumed
+  slowly. It requires a database with SQL cursors, such as PostgreSQL.
+  The connection is only locked during each `FETCH`, so it must not be
+  used by other processes until the enumeration completes or halts, which
+  commits the transaction.
 
-  @doc """
-  Runs the given `query` with `params` and
-  pass the ArrowStream pointer to the given function.
+  ## Examples
+
+      conn
+      |> Adbc.Connection.stream("SELECT * FROM events")
+      |> Stream.map(fn %Adbc.Result{data: columns} -> process(columns) end)
+      |> Stream.run()
 
-  The pointer will point to a valid ArrowStream through
-  the duration of the function. The function may call
-  native code that consumes the ArrowStream accordingly.
   """
-  def query_pointer(conn, query, params \\ [], fun, statement_options \\ [])
-      when (is_binary(query) or is_reference(query)) and is_list(params) and is_function(fun) and
+  @spec stream(t(), binary | reference, [term], Keyword.t()) :: Enumerable.t()
+  def stream(conn, query, params \\ [], statement_options \\ [])
+      when (is_binary(query) or is_reference(query)) and is_list(params) and
              is_list(statement_options) do
-    stream(conn, {:query, query, params, statement_options}, fn stream_ref, rows_affected ->
-      {:ok, fun.(Adbc.Nif.adbc_arrow_array_stream_get_pointer(stream_ref), rows_affected)}
-    end)
-  end
-
-  @doc """
-  Get metadata about the database/driver.
-
-  The result is an Arrow dataset with the following schema:
-
-
-  | Field Name                 |  Field Type    | Null Contstraint  |
-  | -------------------------- | ---------------|------------------ |
-  | `info_name`                |  `uint32`      | not null          |
-  | `info_value`               |  `INFO_SCHEMA` |                   |
-
-  `INFO_SCHEMA` is a dense union with members:
+    {cursor_rows, statement_options} = Keyword.pop(statement_options, :cursor_rows)
 
-  | Field Name       | Type Code |  Field Type                   |
-  | -----------------| --------- | ----------------------------- |
-  | `string_value`              | 0 |  `utf8`                    |
-  | `bool_value`                | 1 |  `bool`                    |
-  | `int64_value`               | 2 |  `int64`                   |
-  | `int32_bitmask`             | 3 |  `int32`                   |
-  | `string_list`               | 4 |  `list<utf8>`              |
-  | `int32_to_int32_list_map`   | 5 |  `map<int32, list<int32>>` |
+    if cursor_rows do
+      cursor_stream(conn, query, params, cursor_rows, statement_options)
+    else
+      {priority, statement_options} = pop_priority!(statement_options)
+      {stream_options, statement_options} = Keyword.split(statement_options, @stream_options)
+      command = query_command(:query, query, params, statement_options)
+      batch_stream(conn, command, stream_options, priority)
+    end
+  end
 
-  Each metadatum is identified by an integer code. The recognized
-  codes are defined as constants. Codes [0, 10_000) are reserved
-  for ADBC usage. Drivers/vendors will ignore requests for
-  unrecognized codes (the row will be omitted from the result).
-  """
-  @spec get_info(t(), list(non_neg_integer())) ::
-          {:ok, result_set} | {:error, Exception.t()}
-  def get_info(conn, info_codes \\ []) when is_list(info_codes) do
-    stream(conn, {:adbc_connection_get_info, [info_codes]}, &stream_results/2)
+  defp batch_stream(conn, command, stream_options, priority) do
+    Stream.resource(
+      fn -> open_stream(conn, command, stream_options, priority) end,
+      &next_result/1,
+      fn {_scheduler, stream_ref, _num_rows} ->
+        Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
+      end
+    )
   end
 
-  @doc """
-  Get a hierarchical view of all catalogs, database schemas, tables, and columns.
+  # Used by `Adbc.Producer`, which keeps the stream of a query open across
+  # its callbacks and reads a batch at a time as demand arrives.
+  @doc false
+  def __open_stream__(conn, query, params, statement_options) do
+    {priority, statement_options} = pop_priority!(statement_options)
+    {stream_options, statement_options} = Keyword.split(statement_options, @stream_options)
+    command = query_command(:query, query, params, statement_options)
+    open_stream(conn, command, stream_options, priority)
+  end
 
-  The result is an Arrow dataset with the following schema:
+  @doc false
+  def __next_result__(stream), do: next_result(stream)
 
-  | Field Name               | Field Type                |
-  |--------------------------|---------------------------|
-  | `catalog_name`           | `utf8`                    |
-  | `catalog_db_schemas`     | `list<DB_SCHEMA_SCHEMA>`  |
+  @doc false
+  def __set_prefetch__({_scheduler, stream_ref, _num_rows}, capacity),
+    do: Adbc.Nif.adbc_arrow_array_stream_set_prefetch(stream_ref, capacity)
 
-  `DB_SCHEMA_SCHEMA` is a Struct with fields:
+  @doc false
+  def __close_stream__({_scheduler, stream_ref, _num_rows}),
+    do: Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
 
-  | Field Name             | Field Type              |
-  |------------------------|-------------------------|
-  | `db_schema_name`       | `utf8`                  |
-  | `db_schema_tables`     | `list<TABLE_SCHEMA>`    |
+  defp cursor_stream(conn, query, params, rows, statement_options)
+       when is_binary(query) and is_integer(rows) and rows > 0 do
+    cursor = "adbc_cursor_#{System.unique_integer([:positive])}"
+    fetch = "FETCH FORWARD #{rows} FROM #{cursor}"
 
-  `TABLE_SCHEMA` is a Struct with fields:
+    Stream.resource(
+      fn ->
+        query!(conn, "BEGIN")
 
-  | Field Name           | Field Type                | Null Contstraint   |
-  |----------------------|---------------------------|--------------------|
-  | `table_name`         | `utf8`                    | not null           |
-  | `table_type`         | `utf8`                    | not null           |
-  | `table_columns`      | `list<COLUMN_SCHEMA>`     |                    |
-  | `table_constraints`  | `list<CONSTRAINT_SCHEMA>` |                    |
+        case query(conn, "DECLARE #{cursor} NO SCROLL CURSOR FOR #{query}", params) do
+          {:ok, _} ->
+            :open
 
-  `COLUMN_SCHEMA` is a Struct with fields:
+          {:error, error} ->
+            query(conn, "COMMIT")
+            raise error
+        end
+      end,
+      fn :open ->
+        %Adbc.Result{data: data} = result = query!(conn, fetch, [], statement_options)
+        if result_empty?(data), do: {:halt, :open}, else: {[result], :open}
+      end,
+      # a failed transaction is rolled back by COMMIT, which closes the cursor
+      fn _ -> query(conn, "COMMIT") end
+    )
+  end
 
-  | Field Name                 | Field Type  | Null Contstraint | Comments |
-  |----------------------------|-------------|------------------|----------|
-  | `column_name`              | `utf8`      | not null         |          |
-  | `ordinal_position`         | `int32`     |                  | (1)      |
-  | `remarks`                  | `utf8`      |                  | (2)      |
-  | `xdbc_data_type`           | `int16`     |                  | (3)      |
-  | `xdbc_type_name`           | `utf8`      |                  | (3)      |
-  | `xdbc_column_size`         | `int32`     |                  | (3)      |
-  | `xdbc_decimal_digits`      | `int16`     |                  | (3)      |
-  | `xdbc_num_prec_radix`      | `int16`     |                  | (3)      |
-  | `xdbc_nullable`            | `int16`     |                  | (3)      |
-  | `xdbc_column_def`          | `utf8`      |                  | (3)      |
-  | `xdbc_sql_data_type`       | `int16`     |                  | (3)      |
-  | `xdbc_datetime_sub`        | `int16`     |                  | (3)      |
-  | `xdbc_char_octet_length`   | `int32`     |                  | (3)      |
-  | `xdbc_is_nullable`         | `utf8`      |                  | (3)      |
-  | `xdbc_scope_catalog`       | `utf8`      |                  | (3)      |
-  | `xdbc_scope_schema`        | `utf8`      |                  | (3)      |
-  | `xdbc_scope_table`         | `utf8`      |                  | (3)      |
-  | `xdbc_is_autoincrement`    | `bool`      |                  | (3)      |
-  | `xdbc_is_generatedcolumn`  | `bool`      |                  | (3)      |
+  defp result_empty?([%Adbc.Column{} = column | _]),
+    do: Adbc.Column.to_list(Adbc.Column.slice(column, 0, 1)) == []
 
-  1. The column's ordinal position in the table (starting from 1).
-  2. Database-specific description of the column.
-  3. Optional value. Should be null if not supported by the driver.
-     `xdbc_` values are meant to provide JDBC/ODBC-compatible metadata
-     in an agnostic manner.
+  defp result_empty?(data), do: data == []
 
-  `CONSTRAINT_SCHEMA` is a Struct with fields:
+  defp open_stream(conn, command, stream_options, priority) do
+    case GenServer.call(conn, {:stream, command, priority}, :infinity) do
+      {:ok, scheduler, stream_ref, rows_affected} ->
+        case configure_stream(stream_ref, stream_options) do
+          :ok ->
+            {next_scheduler(scheduler, stream_options), stream_ref, normalize_rows(rows_affected)}
 
-  | Field Name                | Field Type           | Null Contstraint | Comments |
-  |---------------------------|----------------------|------------------|----------|
-  | `constraint_name`         | `utf8`               |                  |          |
-  | `constraint_type`         | `utf8`               | not null         | (1)      |
-  | `constraint_column_names` | `list<utf8>`         | not null         | (2)      |
-  | `constraint_column_usage` | `list<USAGE_SCHEMA>` |                  | (3)      |
+          {:error, reason} ->
+            Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
+            raise error_to_exception(reason)
+        end
 
-  1. One of 'CHECK', 'FOREIGN KEY', 'PRIMARY KEY', or 'UNIQUE'.
-  2. The columns on the current table that are constrained, in order.
-  3. For FOREIGN KEY only, the referenced table and columns.
+      {:error, reason} ->
+        raise error_to_exception(reason)
+    end
+  end
 
-  `USAGE_SCHEMA` is a Struct with fields:
+  defp next_result({scheduler, stream_ref, num_rows} = acc) do
+    case Adbc.Helper.nif(scheduler, :adbc_arrow_array_stream_next, [stream_ref]) do
+      {:ok, data, _done} -> {[%Adbc.Result{data: data, num_rows: num_rows}], acc}
+      :end_of_series -> {:halt, acc}
+      {:error, reason} -> raise error_to_exception(reason)
+    end
+  end
 
-  | Field Name               | Field Type    | Null Contstraint |
-  |--------------------------|---------------|------------------|
-  | `fk_catalog`             | `utf8`        |                  |
-  | `fk_db_schema`           | `utf8`        |                  |
-  | `fk_table`               | `utf8`        | not null         |
-  | `fk_column_name`         | `utf8`        | not null         |
-  """
-  @spec get_objects(
-          t(),
-          non_neg_integer(),
-          catalog: String.t(),
-          db_schema: String.t(),
-          table_name: String.t(),
-          table_type: [String.t()],
-          column_name: String.t()
-        ) :: {:ok, result_set} | {:error, Exception.t()}
-  def get_objects(conn, depth, opts \\ [])
-      when is_integer(depth) and depth >= 0 do
-    opts = Keyword.validate!(opts, [:catalog, :db_schema, :table_name, :table_type, :column_name])
+  @doc """
+  Scans `table` with a query per connection of `conns`, run concurrently
+  over consecutive ranges of its rows, and returns the merged result.
 
-    args = [
-      depth,
-      opts[:catalog],
-      opts[:db_schema],
-      opts[:table_name],
-      opts[:table_type],
-      opts[:column_name]
-    ]
+  By default, the ranges are ranges of `rowid`s. This is meant for
+  SQLite, whose scans use a single core per connection, with connections
+  of the same database, in WAL mode so that readers do not block each
+  other. Tables without a `rowid` cannot be scanned this way.
 
-    stream(conn, {:adbc_connection_get_objects, args}, &stream_results/2)
-  end
+  With `partition: :ctid`, the ranges are ranges of the blocks of a
+  PostgreSQL table, given by the `ctid` of rows, which the server reads
+  with TID range scans, so that large extracts use a backend process per
+  connection. All the connections read the same snapshot of the table: the
+  first one exports its snapshot with `pg_export_snapshot()` within a
+  `REPEATABLE READ` transaction, which the others import, and all of them
+  commit once the scan is done. `conns` must therefore not be in a
+  transaction already.
 
-  @doc """
-  Gets the underlying driver of a connection process.
+  `table` is interpolated into the queries as is.
 
-  ## Examples
+  ## Options
 
-      ADBC.Connection.get_driver(conn)
-      #=> {:ok, :sqlite}
-  """
-  @spec get_driver(t()) :: {:ok, atom() | String.t()} | :error
-  def get_driver(conn) do
-    with pid when pid != nil <- GenServer.whereis(conn),
-         {:dictionary, dictionary} <- Process.info(pid, :dictionary),
-         {:adbc_driver, module} <- List.keyfind(dictionary, :adbc_driver, 0),
-         do: {:ok, module},
-         else: (_ -> :error)
-  end
+  Besides the options of `query/4`, `options` accepts:
 
-  @doc """
-  Get a list of table types in the database.
+    * `:columns` - the columns to select, as SQL, defaults to `"*"`
 
-  The result is an Arrow dataset with the following schema:
+    * `:ordered` - whether rows are returned in the order of their
+      ranges, defaults to `true`. When `false`, the result of each range
+      is merged as soon as it is read, in any order
 
-  | Field Name     | Field Type    | Null Contstraint |
-  |----------------|---------------|------------------|
-  | `table_type`   | `utf8`        | not null         |
+    * `:partition` - how the table is split in ranges, `:rowid` or
+      `:ctid`, defaults to `:rowid`
 
+    * `:min_range_rows` - the minimum number of rows of a range, defaults
+      to `10_000`. When the driver reports the number of rows of `table`
+      with `get_statistics/2`, small tables are scanned with fewer
+      connections, down to one, rather than paying for a query per
+      connection. The statistics of drivers that do not report them,
+      or of schema-qualified tables, are not used
   """
-  @spec get_table_types(t) ::
+  @spec parallel_scan([t(), ...], binary, Keyword.t()) ::
           {:ok, result_set} | {:error, Exception.t()}
-  def get_table_types(conn) do
-    stream(conn, {:adbc_connection_get_table_types, []}, &stream_results/2)
-  end
-
-  defp command(conn, command) do
-    case GenServer.call(conn, {:command, command}, :infinity) do
-      {:ok, result} -> {:ok, result}
-      {:error, reason} -> {:error, error_to_exception(reason)}
+  def parallel_scan([_ | _] = conns, table, options \\ [])
+      when is_binary(table) and is_list(options) do
+    {columns, options} = Keyword.pop(options, :columns, "*")
+    {ordered, options} = Keyword.pop(options, :ordered, true)
+    {partition, options} = Keyword.pop(options, :partition, :rowid)
+    {min_range_rows, options} = Keyword.pop(options, :min_range_rows, 10_000)
+    conns = Enum.take(conns, max_ranges(hd(conns), table, min_range_rows) || length(conns))
+
+    case partition do
+      :rowid -> rowid_scan(conns, table, columns, ordered, options)
+      :ctid -> ctid_scan(conns, table, columns, ordered, options)
     end
   end
 
-  defp stream(conn, command, fun) do
-    case GenServer.call(conn, {:stream, command}, :infinity) do
-      {:ok, conn, unlock_ref, stream_ref, rows_affected} ->
-        try do
-          fun.(stream_ref, normalize_rows(rows_affected))
-        after
-          GenServer.cast(conn, {:unlock, unlock_ref})
-        end
-
-      {:error, reason} ->
-        {:error, error_to_exception(reason)}
+  # the number of rows is only known from approximate statistics, which
+  # are enough to avoid splitting small tables in many ranges
+  defp max_ranges(conn, table, min_range_rows)
+       when is_integer(min_range_rows) and min_range_rows > 0 do
+    with false <- String.contains?(table, "."),
+         {:ok, statistics} <- get_statistics(conn, table_name: table, approximate: true),
+         [rows | _] when is_number(rows) and rows > 0 <-
+           for(
+             %{table_name: ^table, column_name: nil, name: :row_count, value: rows} <- statistics,
+             do: rows
+           ) do
+      ceil(rows / min_range_rows)
+    else
+      _ -> nil
     end
   end
 
-  defp normalize_rows(-1), do: nil
-  defp normalize_rows(rows) when is_integer(rows) and rows >= 0, do: rows
+  defp rowid_scan([conn | _] = conns, table, columns, ordered, options) do
+    bounds = "SELECT min(rowid), max(rowid) FROM #{table}"
 
-  defp stream_results(reference, num_rows), do: stream_results(reference, [], num_rows)
+    case query(conn, bounds, [], output: :rows_tuples) do
+      {:ok, %Adbc.Result{data: [{nil, nil}]}} ->
+        query(conn, "SELECT #{columns} FROM #{table}", [], options)
 
-  defp stream_results(reference, acc, num_rows) do
-    case Adbc.Nif.adbc_arrow_array_stream_next(reference) do
-      {:ok, results, _done} ->
-        stream_results(reference, [results | acc], num_rows)
+      {:ok, %Adbc.Result{data: [{first, last}]}} ->
+        range_query = "SELECT #{columns} FROM #{table} WHERE rowid BETWEEN ? AND ? ORDER BY rowid"
 
-      :end_of_series ->
-        {:ok, %Adbc.Result{data: merge_columns(Enum.reverse(acc)), num_rows: num_rows}}
+        conns
+        |> Enum.zip(rowid_ranges(first, last, length(conns)))
+        |> scan_ranges(ordered, options, fn {first, last} -> {range_query, [first, last]} end)
 
-      {:error, reason} ->
-        {:error, error_to_exception(reason)}
+      {:error, _} = error ->
+        error
     end
   end
 
-  defp merge_columns([result]), do: result
-
-  defp merge_columns(chucked_results) do
-    Enum.zip_with(chucked_results, fn columns ->
-      Enum.reduce(columns, fn column, merged_column ->
-        %{merged_column | data: merged_column.data ++ column.data}
-      end)
-    end)
+  defp rowid_ranges(first, last, count) do
+    size = div(last - first + count, count)
+    for start <- first..last//size, do: {start, min(start + size - 1, last)}
   end
 
-  ## Callbacks
-
-  @impl true
-  def init({db, conn}) do
-    case GenServer.call(db, {:initialize_connection, conn}, :infinity) do
-      {:ok, driver} ->
-        Process.put(:adbc_driver, driver)
-        {:ok, %{conn: conn, lock: :none, queue: :queue.new()}}
-
-      {:error, reason} ->
-        {:stop, error_to_exception(reason)}
+  @ctid_begin "BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY"
+
+  # the blocks are counted from the size of the table rather than from
+  # `pg_class.relpages`, which is only updated by VACUUM and ANALYZE, and
+  # the last range is left open for the rows added past them
+  defp ctid_scan([conn | others] = conns, table, columns, ordered, options) do
+    blocks =
+      "SELECT pg_relation_size($1::regclass) / current_setting('block_size')::bigint, " <>
+        "pg_export_snapshot()"
+
+    with {:ok, _} <- query(conn, @ctid_begin) do
+      try do
+        with {:ok, %Adbc.Result{data: [{pages, snapshot}]}} <-
+               query(conn, blocks, [table], output: :rows_tuples),
+             :ok <- import_snapshot(others, snapshot) do
+          conns
+          |> Enum.zip(ctid_ranges(pages, length(conns)))
+          |> scan_ranges(ordered, options, fn range ->
+            {"SELECT #{columns} FROM #{table} WHERE #{ctid_condition(range)}", []}
+          end)
+        end
+      after
+        for conn <- conns, do: query(conn, "COMMIT")
+      end
     end
   end
 
-  @impl true
-  def handle_call({:stream, command}, from, state) do
-    state = update_in(state.queue, &:queue.in({:stream, command, from}, &1))
-    {:noreply, maybe_dequeue(state)}
+  defp import_snapshot(conns, snapshot) do
+    Enum.reduce_while(conns, :ok, fn conn, :ok ->
+      with {:ok, _} <- query(conn, @ctid_begin),
+           {:ok, _} <- query(conn, "SET TRANSACTION SNAPSHOT '#{snapshot}'") do
+        {:cont, :ok}
+      else
+        error -> {:halt, error}
+      end
+    end)
   end
 
-  def handle_call({:command, command}, from, state) do
-    state = update_in(state.queue, &:queue.in({:command, command, from}, &1))
-    {:noreply, maybe_dequeue(state)}
-  end
+  defp ctid_ranges(pages, count) when pages <= count, do: [{0, nil}]
 
-  def handle_call({:option, func, args}, _from, state = %{conn: conn}) do
-    {:reply, Adbc.Helper.option(conn, func, args), state}
+  defp ctid_ranges(pages, count) do
+    size = div(pages + count - 1, count)
+    starts = Enum.take_every(0..(pages - 1), size)
+    Enum.zip(starts, tl(starts) ++ [nil])
   end
 
-  @impl true
-  def handle_cast({:unlock, ref}, %{lock: {ref, stream_ref}} = state) do
-    # We could let the GC be the one release it but,
-    # since a stream can be a large resource, we release
-    # it now and let the GC free the remaining resources.
-    Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
-    Process.demonitor(ref, [:flush])
-    {:noreply, maybe_dequeue(%{state | lock: :none})}
+  defp ctid_condition({first, nil}), do: "ctid >= '(#{first},0)'::tid"
+
+  defp ctid_condition({first, last}),
+    do: "ctid >= '(#{first},0)'::tid AND ctid < '(#{last},0)'::tid"
+
+  defp scan_ranges(conns_and_ranges, ordered, options, range_query) do
+    conns_and_ranges
+    |> Task.async_stream(
+      fn {conn, range} ->
+        {query, params} = range_query.(range)
+        query(conn, query, params, options)
+      end,
+      ordered: ordered,
+      timeout: :infinity
+    )
+    |> Enum.map(fn {:ok, result} -> result end)
+    |> merge_scans(Keyword.get(options, :output, :columns))
   end
 
-  @impl true
-  def handle_info({:DOWN, ref, _, _, _}, %{lock: {ref, stream_ref}} = state) do
-    Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
-    {:noreply, maybe_dequeue(%{state | lock: :none})}
+  defp merge_scans(results, output) do
+    case Enum.find(results, &match?({:error, _}, &1)) do
+      nil ->
+        data = merge_batches(output, for({:ok, %Adbc.Result{data: data}} <- results, do: data))
+        {:ok, %Adbc.Result{data: data, num_rows: nil}}
+
+      error ->
+        error
+    end
   end
 
-  ## Queue helpers
+  @doc """
+  Returns a stream of the bytes of a large binary value in chunks, read
+  with a query each, so that only one chunk is held in memory at a time.
+
+  The value is the one of `column` in the row of `table` matching `where`,
+  a SQL condition given `params`. Each chunk is read with
+  `substr(column, start, chunk_size)`, which both SQLite and PostgreSQL
+  apply to `BLOB` and `bytea` values in bytes. PostgreSQL only reads the
+  slice of values stored uncompressed, with `STORAGE EXTERNAL`, while
+  SQLite and compressed values are read whole by the server for every
+  chunk, but still returned one chunk at a time. The value should not
+  change while it is read.
+
+  `table`, `column` and `where` are interpolated into the queries as is.
+  The stream is empty if no row matches or the value is `NULL`, and
+  errors raise once it is enumerated, as does an `ArgumentError` when
+  `where` matches several rows.
 
-  defp maybe_dequeue(%{lock: :none, queue: queue} = state) do
-    case :queue.out(queue) do
-      {:empty, queue} ->
-        %{state | queue: queue}
+  ## Options
 
-      {{:value, {:command, command, from}}, queue} ->
-        result = handle_command(command, state.conn)
-        GenServer.reply(from, result)
-        maybe_dequeue(%{state | queue: queue})
+  Besides the options of `query/4`, `options` accepts:
 
-      {{:value, {:stream, command, from}}, queue} ->
-        {pid, _} = from
+    * `:chunk_size` - the number of bytes of each chunk, defaults to
+      `1_048_576`
 
-        case handle_stream(command, state.conn) do
-          {:ok, stream_ref, rows_affected} when is_reference(stream_ref) ->
-            unlock_ref = Process.monitor(pid)
-            GenServer.reply(from, {:ok, self(), unlock_ref, stream_ref, rows_affected})
-            %{state | lock: {unlock_ref, stream_ref}, queue: queue}
+  ## Examples
 
-          {:error, error} ->
-            GenServer.reply(from, {:error, error})
-            maybe_dequeue(%{state | queue: queue})
-        end
+      conn
+      |> Adbc.Connection.blob_stream("documents", "content", "id = ?", [id])
+      |> Stream.into(File.stream!("document.pdf"))
+      |> Stream.run()
+
+  """
+  @spec blob_stream(t(), binary, binary, binary, [term], Keyword.t()) :: Enumerable.t()
+  def blob_stream(conn, table, column, where, params \\ [], options \\ [])
+      when is_binary(table) and is_binary(column) and is_binary(where) and is_list(params) and
+             is_list(options) do
+    {chunk_size, options} = Keyword.pop(options, :chunk_size, 1_048_576)
+
+    unless is_integer(chunk_size) and chunk_size > 0 do
+      raise ArgumentError, ":chunk_size must be a positive integer, got: #{inspect(chunk_size)}"
     end
-  end
 
-  defp maybe_dequeue(state), do: state
+    options = Keyword.put(options, :output, :rows_tuples)
 
-  defp handle_command({:prepare, query}, conn) do
-    with {:ok, stmt} <- create_statement(conn, query),
-         :ok <- Adbc.Nif.adbc_statement_prepare(stmt) do
-      {:ok, stmt}
-    end
-  end
+    Stream.unfold(1, fn
+      nil ->
+        nil
+
+      start ->
+        query = "SELECT substr(#{column}, #{start}, #{chunk_size}) FROM #{table} WHERE #{where}"
+
+        case query!(conn, query, params, options) do
+          %Adbc.Result{data: [{chunk}]} when byte_size(chunk) == chunk_size ->
+            {chunk, start + chunk_size}
+
+          %Adbc.Result{data: [{chunk}]} when is_binary(chunk) and chunk != "" ->
+            {chunk, nil}
+
+          %Adbc.Result{data: data} when data in [[], [{nil}], [{""}]] ->
+            nil
+
+          %Adbc.Result{data: [_, _ | _]} ->
+            raise ArgumentError,
+                  "expected where to match a single row of #{table}, got: #{inspect(where)}"
+        end
+    end)
+  end
+
+  @doc """
+  Prepares the given `query`.
+  """
+  @spec prepare(t(), binary) :: {:ok, reference} | {:error, Exception.t()}
+  def prepare(conn, query) when is_binary(query) do
+    command(conn, {:prepare, query})
+  end
+
+  @doc """
+  Executes `query` once for each row of `rows` and returns the number of
+  rows affected by each of them, or `nil` where the driver does not
+  report it.
+
+  `query` is a binary or a statement returned by `prepare/2` and `rows`
+  a list of rows, each a list of parameters as in `query/4`. All the rows
+  are bound and executed in turn by a single native call, on a dirty
+  scheduler unless the database uses the `:normal` one. Unlike `query/4`
+  given a list of rows, which reports the total number of rows affected,
+  the count of each row is kept. Execution stops at the first row that
+  fails, without undoing the rows executed before it, so use a transaction
+  to apply all rows or none.
+
+  A single native call does not mean a single round trip: drivers may
+  still execute the bound rows one at a time. The PostgreSQL driver does,
+  waiting for the server after each row, so for large writes that need no
+  `ON CONFLICT` clause, `ingest/4` is much faster, as it uses `COPY`.
+
+  `statement_options` are given to the driver. The connection runs no
+  other query meanwhile and `:timeout` is not supported.
+  """
+  @spec execute_many(t(), binary | reference, [[term]], Keyword.t()) ::
+          {:ok, [non_neg_integer | nil]} | {:error, Exception.t()}
+  def execute_many(conn, query, rows, statement_options \\ [])
+      when (is_binary(query) or is_reference(query)) and is_list(rows) and
+             is_list(statement_options) do
+    command(conn, {:execute_many, query, rows, statement_options})
+  end
+
+  @doc """
+  Executes each of `statements` in turn, in a single native call, and
+  returns the number of rows affected by each of them, or `nil` where the
+  driver does not report it.
+
+  Each statement is a query binary or a `{query, params}` tuple, with
+  `params` a list of parameters as in `query/4`. They run one after the
+  other on the connection, each with a statement of its own, on a dirty
+  scheduler unless the database uses the `:normal` one, so a short batch
+  costs a single call to the connection process instead of one per
+  statement. Result sets are discarded, so use `query/4` for queries whose
+  rows are needed.
+
+  Execution stops at the first statement that fails, without undoing the
+  statements executed before it. See `transaction/2` to apply all of them
+  or none.
+
+  ## Examples
+
+      Adbc.Connection.batch(conn, [
+        {"UPDATE accounts SET balance = balance - ? WHERE id = ?", [10, 1]},
+        {"INSERT INTO transfers (account_id, amount) VALUES (?, ?)", [1, 10]}
+      ])
+      #=> {:ok, [1, 1]}
+
+  """
+  @spec batch(t(), [binary | {binary, [term]}]) ::
+          {:ok, [non_neg_integer | nil]} | {:error, Exception.t()}
+  def batch(conn, statements) when is_list(statements) do
+    command(conn, {:batch, Enum.map(statements, &batch_statement/1), false})
+  end
+
+  @doc """
+  Same as `batch/2`, with `statements` run between `BEGIN` and `COMMIT`.
+
+  Once a statement fails, `ROLLBACK` is executed instead of the remaining
+  statements and the error is returned, so either all statements apply or
+  none do. The transaction runs in a single native call, so no other
+  process can run queries in the middle of it.
+  """
+  @spec transaction(t(), [binary | {binary, [term]}]) ::
+          {:ok, [non_neg_integer | nil]} | {:error, Exception.t()}
+  def transaction(conn, statements) when is_list(statements) do
+    command(conn, {:batch, Enum.map(statements, &batch_statement/1), true})
+  end
+
+  defp batch_statement(query) when is_binary(query), do: {query, []}
+
+  defp batch_statement({query, params}) when is_binary(query) and is_list(params),
+    do: {query, array_params(params)}
+
+  defp batch_statement(other) do
+    raise ArgumentError,
+          "expected a query or a {query, params} tuple in the batch, got: #{inspect(other)}"
+  end
+
+  @doc """
+  Runs the given `query` with `params` and
+  pass the ArrowStream pointer to the given function.
+
+  The pointer will point to a valid ArrowStream through
+  the duration of the function. The function may call
+  native code that consumes the ArrowStream accordingly.
+  """
+  def query_pointer(conn, query, params \\ [], fun, statement_options \\ [])
+      when (is_binary(query) or is_reference(query)) and is_list(params) and is_function(fun) and
+             is_list(statement_options) do
+    command = query_command(:query, query, params, statement_options)
+
+    consume(conn, command, fn _scheduler, stream_ref, rows ->
+      {:ok, fun.(Adbc.Nif.adbc_arrow_array_stream_get_pointer(stream_ref), rows)}
+    end)
+  end
+
+  @doc """
+  Runs the given `query` with `params` and moves the resulting
+  ArrowStream out of the connection before passing its pointer to the
+  given function.
+
+  Unlike `query_pointer/5`, the connection is unlocked as soon as the
+  query runs, so it may serve other queries while `fun` reads the stream.
+  `fun` may also take ownership of the stream, as in the Arrow C stream
+  interface, by moving it to its own allocation and marking the given one
+  as released. Explorer and Polars do so when importing a stream pointer.
+  Any stream left behind is released once `fun` returns. The statement
+  is never taken from nor kept in the statement cache, as the stream
+  could not be read once the statement runs again.
+
+  Reading the stream after the connection runs another query requires
+  driver support, which SQLite has but PostgreSQL does not.
+  """
+  def query_export(conn, query, params \\ [], fun, statement_options \\ [])
+      when (is_binary(query) or is_reference(query)) and is_list(params) and is_function(fun) and
+             is_list(statement_options) do
+    command = query_command(:export, query, params, statement_options)
+
+    moved =
+      consume(conn, command, fn _scheduler, stream_ref, rows ->
+        case Adbc.Nif.adbc_arrow_array_stream_move(stream_ref) do
+          {:ok, exported_ref} -> {:ok, exported_ref, rows}
+          {:error, reason} -> {:error, error_to_exception(reason)}
+        end
+      end)
+
+    with {:ok, exported_ref, rows} <- moved do
+      try do
+        {:ok, fun.(Adbc.Nif.adbc_arrow_array_stream_get_pointer(exported_ref), rows)}
+      after
+        Adbc.Nif.adbc_arrow_array_stream_release(exported_ref)
+      end
+    end
+  end
+
+  @doc """
+  Ingests `batches` into `table` and returns the number of rows ingested,
+  or `nil` if the driver does not report it.
+
+  `batches` is an enumerable of record batches, each a list of
+  `Adbc.Column`s with the same names and types. The enumerable is
+  consumed in the calling process, which converts the next batches while
+  the driver sends the previous ones, so enumerables far larger than
+  memory can be ingested. Drivers such as PostgreSQL load the batches
+  with `COPY`.
+  Since the first batch gives the schema of the table, `batches` must
+  have at least one batch.
+
+  `batches` may also be a stream of record batches, such as the one
+  returned by `Adbc.open_arrow_file/1`, which is bound to the statement
+  as is, without converting its batches. The stream is released once
+  ingested.
+
+  ## Options
+
+  Besides statement options given to the driver, `options` accepts:
+
+    * `:mode` - how to handle an existing table, one of `:create` (the
+      table must not exist), `:append` (the table must exist),
+      `:replace`, `:create_append` or `:upsert`, defaults to `:create`.
+      With `:upsert`, the batches are bulk loaded into a temporary staging
+      table, then merged into `table`, which must exist, with a single
+      `INSERT ... SELECT ... ON CONFLICT DO UPDATE`, so that upserts run
+      at the speed of bulk loads, such as `COPY` on PostgreSQL, instead of
+      one bound insert per row. The number of rows returned is then the
+      one the driver reports for the merge
+
+    * `:conflict_keys` - the columns of the unique constraint of `table`
+      that rows conflict on, required with `mode: :upsert`. All the other
+      columns of the batches are updated on conflict
+
+    * `:pending_batches` - the number of converted batches that may wait
+      for the driver, defaults to `2`. Higher values smooth out batches
+      that vary in size, at the cost of holding more of them in memory
+
+    * `:pragmas` - a keyword list of SQLite pragmas set for the duration
+      of the ingest and restored afterwards, defaults to `[]`. For
+      example, `[synchronous: "OFF", journal_mode: "MEMORY"]` speeds up
+      loading data that can be loaded again if the machine crashes
+
+    * `:timeout` - same as in `query/4`
+  """
+  @spec ingest(t(), binary, Enumerable.t() | reference, Keyword.t()) ::
+          {:ok, non_neg_integer | nil} | {:error, Exception.t()}
+  def ingest(conn, table, batches, options \\ []) when is_binary(table) and is_list(options) do
+    {mode, statement_options} = Keyword.pop(options, :mode, :create)
+    {pending, statement_options} = Keyword.pop(statement_options, :pending_batches, 2)
+    {pragmas, statement_options} = Keyword.pop(statement_options, :pragmas, [])
+    {keys, statement_options} = Keyword.pop(statement_options, :conflict_keys)
+    validate_timeout!(Keyword.get(statement_options, :timeout, :infinity))
+
+    with_pragmas(conn, pragmas, fn ->
+      if mode == :upsert do
+        upsert(conn, table, batches, keys, pending, statement_options)
+      else
+        mode = Map.fetch!(@ingest_modes, mode)
+        do_ingest(conn, table, batches, mode, pending, statement_options)
+      end
+    end)
+  end
+
+  @doc """
+  Registers `data` as the temporary table `name` of the connection, to be
+  joined against the tables of the database, and returns the number of
+  rows registered, or `nil` if the driver does not report it.
+
+  `data` is either a list of `Adbc.Column`s, all of the same length, or a
+  stream of record batches, such as the one returned by
+  `Adbc.open_arrow_file/1`. Either way, it is ingested with a single bulk
+  bind with the `"adbc.ingest.temporary"` statement option, instead of one
+  insert per row, and the table is dropped with the connection. A table
+  already registered with the same name is replaced.
+
+  It accepts the same options as `ingest/4`, with `:mode` defaulting to
+  `:replace`. Drivers without temporary tables, such as the ones that
+  ingest to remote warehouses, return an error.
+  """
+  @spec register_table(t(), binary, [Adbc.Column.t()] | reference, Keyword.t()) ::
+          {:ok, non_neg_integer | nil} | {:error, Exception.t()}
+  def register_table(conn, name, data, options \\ [])
+
+  def register_table(conn, name, [%Adbc.Column{} | _] = columns, options) do
+    register_table(conn, name, [columns], options)
+  end
+
+  def register_table(conn, name, data, options)
+      when is_binary(name) and (is_list(data) or is_reference(data)) and is_list(options) do
+    options = Keyword.put_new(options, :mode, :replace)
+    ingest(conn, name, data, [{"adbc.ingest.temporary", "true"} | options])
+  end
+
+  @doc """
+  Writes a copy of the SQLite database of `conn` to the database file at
+  `path`, to be given as the `:snapshot` of `Adbc.Database.start_link/1`.
+
+  It runs `VACUUM INTO`, which writes a compact copy of the `main`
+  database, without temporary tables, and fails if `path` exists. A
+  database loaded once with reference data can then be copied into the
+  in-memory databases of many workers.
+  """
+  @spec snapshot(t(), Path.t()) :: :ok | {:error, Exception.t()}
+  def snapshot(conn, path) when is_binary(path) do
+    with {:ok, _} <- query(conn, "VACUUM INTO ?", [path]), do: :ok
+  end
+
+  defp do_ingest(conn, table, stream_ref, mode, _pending, statement_options)
+       when is_reference(stream_ref) do
+    command = {:ingest, table, mode, stream_ref, statement_options}
+
+    try do
+      consume(conn, command, fn _, _, rows -> {:ok, rows} end)
+    after
+      # the driver did not take the stream if the statement failed early
+      Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
+    end
+  end
+
+  defp do_ingest(conn, table, batches, mode, pending, statement_options) do
+    tag = make_ref()
+
+    {:suspended, nil, continuation} =
+      Enumerable.reduce(batches, {:suspend, nil}, fn batch, _ -> {:suspend, batch} end)
+
+    with {:ok, first, continuation} <- next_batch(continuation),
+         {:ok, producer, stream_ref} <- new_ingest_stream(first, tag, pending, continuation) do
+      command = {:ingest, table, mode, stream_ref, statement_options}
+      task = Task.async(fn -> consume(conn, command, fn _, _, rows -> {:ok, rows} end) end)
+
+      try do
+        feed_ingest(task, stream_ref, producer, tag, continuation, nil)
+      catch
+        kind, reason ->
+          # fails the pending `get_next`, so the connection is unlocked
+          Adbc.Nif.adbc_ingest_stream_push(producer, {:error, "ingest was aborted"})
+          Task.shutdown(task, :brutal_kill)
+          flush_ingest_requests(tag)
+          :erlang.raise(kind, reason, __STACKTRACE__)
+      end
+    else
+      :done ->
+        {:error, ArgumentError.exception("expected at least one batch to ingest")}
+
+      {:error, reason} ->
+        {:error, error_to_exception(reason)}
+    end
+  end
+
+  defp upsert(conn, table, batches, keys, pending, statement_options) do
+    unless is_list(keys) and keys != [] and Enum.all?(keys, &is_binary/1) do
+      raise ArgumentError, "mode: :upsert expects :conflict_keys to be a list of column names"
+    end
+
+    staging = "adbc_upsert_#{:erlang.unique_integer([:positive])}"
+    mode = @ingest_modes.create
+    options = [{"adbc.ingest.temporary", "true"} | statement_options]
+
+    with {:ok, _} <- do_ingest(conn, staging, batches, mode, pending, options) do
+      try do
+        with {:ok, %Adbc.Result{data: columns}} <-
+               query(conn, "SELECT * FROM #{quote_name(staging)} WHERE 1 = 0"),
+             {:ok, [rows]} <- batch(conn, [upsert_query(table, staging, columns, keys)]) do
+          {:ok, rows}
+        end
+      after
+        query(conn, "DROP TABLE #{quote_name(staging)}")
+      end
+    end
+  end
+
+  # `WHERE true` tells SQLite that `ON CONFLICT` is not part of a join
+  defp upsert_query(table, staging, columns, keys) do
+    names = Enum.map(columns, & &1.name)
+    list = Enum.map_join(names, ", ", &quote_name/1)
+    conflict = Enum.map_join(keys, ", ", &quote_name/1)
+
+    action =
+      case names -- keys do
+        [] ->
+          "DO NOTHING"
+
+        updated ->
+          "DO UPDATE SET " <>
+            Enum.map_join(updated, ", ", &"#{quote_name(&1)} = excluded.#{quote_name(&1)}")
+      end
+
+    "INSERT INTO #{quote_name(table)} (#{list}) SELECT #{list} FROM #{quote_name(staging)} " <>
+      "WHERE true ON CONFLICT (#{conflict}) #{action}"
+  end
+
+  defp quote_name(name), do: ~s(") <> String.replace(name, ~s("), ~s("")) <> ~s(")
+
+  defp with_pragmas(_conn, [], fun), do: fun.()
+
+  defp with_pragmas(conn, [{name, value} | pragmas], fun)
+       when is_atom(name) and (is_integer(value) or is_binary(value)) do
+    query = "PRAGMA #{name}"
+
+    with {:ok, %Adbc.Result{data: [{previous}]}} <- query(conn, query, [], output: :rows_tuples),
+         {:ok, _} <- query(conn, "#{query} = #{pragma_value(value)}") do
+      try do
+        with_pragmas(conn, pragmas, fun)
+      after
+        query(conn, "#{query} = #{pragma_value(previous)}")
+      end
+    end
+  end
+
+  defp pragma_value(value) when is_integer(value), do: Integer.to_string(value)
+  defp pragma_value(value), do: "'" <> String.replace(value, "'", "''") <> "'"
+
+  defp next_batch(nil), do: :done
+
+  defp next_batch(continuation) do
+    case continuation.({:cont, nil}) do
+      {:suspended, batch, continuation} -> {:ok, batch, continuation}
+      {:done, nil} -> :done
+    end
+  end
+
+  defp halt_batches(nil), do: :ok
+  defp halt_batches(continuation), do: continuation.({:halt, nil})
+
+  defp new_ingest_stream(first, tag, pending, continuation)
+       when is_integer(pending) and pending > 0 do
+    with {:error, _} = error <- Adbc.Nif.adbc_ingest_stream_new(first, tag, pending) do
+      halt_batches(continuation)
+      error
+    end
+  end
+
+  # The driver runs the statement on a native thread and asks for each
+  # batch with a message, while `task` waits for the connection to reply.
+  # Requests may arrive after the last batch, and are answered with `:done`.
+  defp feed_ingest(%Task{ref: ref} = task, stream_ref, producer, tag, continuation, push_error) do
+    receive do
+      {:adbc_ingest_next, ^tag} ->
+        case next_batch(continuation) do
+          {:ok, batch, continuation} ->
+            case Adbc.Nif.adbc_ingest_stream_push(producer, batch) do
+              :ok ->
+                feed_ingest(task, stream_ref, producer, tag, continuation, push_error)
+
+              {:error, reason} ->
+                # a batch that cannot be converted does not fail the stream
+                Adbc.Nif.adbc_ingest_stream_push(producer, {:error, reason})
+                halt_batches(continuation)
+                feed_ingest(task, stream_ref, producer, tag, nil, reason)
+            end
+
+          :done ->
+            Adbc.Nif.adbc_ingest_stream_push(producer, :done)
+            feed_ingest(task, stream_ref, producer, tag, nil, push_error)
+        end
+
+      {^ref, result} ->
+        Process.demonitor(ref, [:flush])
+        halt_batches(continuation)
+        # the driver did not take the stream if the statement failed early
+        Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
+        flush_ingest_requests(tag)
+
+        case result do
+          {:error, _} when push_error != nil -> {:error, error_to_exception(push_error)}
+          result -> result
+        end
+    end
+  end
+
+  defp flush_ingest_requests(tag) do
+    receive do
+      {:adbc_ingest_next, ^tag} -> flush_ingest_requests(tag)
+    after
+      0 -> :ok
+    end
+  end
+
+  @doc """
+  Runs the given `query` with `params` and returns its result encoded
+  as a list of binaries, without converting it to Elixir terms.
+
+  The first binary holds the schema and each of the following ones a
+  record batch, copied from the memory layout of Arrow. They are cheap to
+  send to other nodes or to cache, and are converted back with
+  `decode_result/2`. This is an encoding specific to this library, not
+  the Arrow IPC format. Binaries encoded on machines of the other
+  endianness have their values byte-swapped when decoded.
+  """
+  @spec query_encoded(t(), binary | reference, [term], Keyword.t()) ::
+          {:ok, [binary]} | {:error, Exception.t()}
+  def query_encoded(conn, query, params \\ [], statement_options \\ [])
+      when (is_binary(query) or is_reference(query)) and is_list(params) and
+             is_list(statement_options) do
+    command = query_command(:query, query, params, statement_options)
+
+    consume(conn, command, fn scheduler, stream_ref, _rows ->
+      case Adbc.Helper.nif(scheduler, :adbc_arrow_array_stream_encode, [stream_ref]) do
+        {:ok, binaries} -> {:ok, binaries}
+        {:error, reason} -> {:error, error_to_exception(reason)}
+      end
+    end)
+  end
+
+  @matrix_types [{:f, 32}, {:f, 64}] ++ for(k <- [:s, :u], b <- [8, 16, 32, 64], do: {k, b})
+
+  @doc """
+  Runs the given `query` with `params` and stacks its numeric columns into
+  a single matrix binary, without converting them to Elixir terms.
+
+  All record batches of the result are read and the values of each column
+  written natively into one binary, cast to the type of the matrix, which
+  can be given to `Nx.from_binary/2` as is. Integer, float and boolean
+  columns are supported, float columns only in float matrices.
+
+  Returns a map with the `:data` of the matrix, its `:shape`, its
+  `:type`, the `:names` of its columns and its `:mask`, if any. The shape
+  is `{rows, columns}`, or `{columns, rows}` with `:column_major`.
+
+  ## Options
+
+    * `:columns` - the names of the columns to stack, in order, defaults
+      to all columns of the result
+
+    * `:type` - the type of the cells of the matrix, as the types of Nx:
+      `{:f, 32}`, `{:f, 64}`, `{:s, 8}` to `{:s, 64}` or `{:u, 8}` to
+      `{:u, 64}`, defaults to `{:f, 64}`. Integers are cast as in C, so
+      they wrap when they do not fit
+
+    * `:layout` - `:row_major` to lay out the cells row after row, as Nx
+      does for a tensor of shape `{rows, columns}`, or `:column_major` to
+      lay them out column after column, as in a tensor of shape
+      `{columns, rows}`, defaults to `:row_major`
+
+    * `:nulls` - `:nan` to write nulls as NaN, which requires a float
+      type, or `:mask` to write them as 0 and return a `:mask` binary of
+      one byte per cell, in the same layout, that is 1 for nulls, defaults
+      to `:nan`
+
+  Other options are given to the statement, as in `query/4`.
+
+  ## Examples
+
+      {:ok, %{data: data, shape: shape, type: type}} =
+        Adbc.Connection.query_matrix(conn, "SELECT x, y FROM points", [], type: {:f, 32})
+
+      data |> Nx.from_binary(type) |> Nx.reshape(shape)
+
+  """
+  @spec query_matrix(t(), binary | reference, [term], Keyword.t()) ::
+          {:ok, map} | {:error, Exception.t()}
+  def query_matrix(conn, query, params \\ [], options \\ [])
+      when (is_binary(query) or is_reference(query)) and is_list(params) and is_list(options) do
+    {columns, options} = Keyword.pop(options, :columns)
+    {type, options} = Keyword.pop(options, :type, {:f, 64})
+    {layout, options} = Keyword.pop(options, :layout, :row_major)
+    {nulls, statement_options} = Keyword.pop(options, :nulls, :nan)
+
+    unless type in @matrix_types do
+      raise ArgumentError, ":type must be one of #{inspect(@matrix_types)}, got: #{inspect(type)}"
+    end
+
+    unless layout in [:row_major, :column_major] do
+      raise ArgumentError, ":layout must be :row_major or :column_major, got: #{inspect(layout)}"
+    end
+
+    unless nulls in [:nan, :mask] do
+      raise ArgumentError, ":nulls must be :nan or :mask, got: #{inspect(nulls)}"
+    end
+
+    columns = if columns, do: Enum.map(columns, &to_string/1)
+    args = [columns, type, layout, nulls]
+    command = query_command(:query, query, params, statement_options)
+
+    consume(conn, command, fn scheduler, stream_ref, _rows ->
+      nif = :adbc_arrow_array_stream_to_matrix
+
+      case Adbc.Helper.nif(scheduler, nif, [stream_ref | args]) do
+        {:ok, data, rows, names, mask} ->
+          columns = length(names)
+          shape = if layout == :row_major, do: {rows, columns}, else: {columns, rows}
+          {:ok, %{data: data, shape: shape, type: type, names: names, mask: mask}}
+
+        {:error, reason} ->
+          {:error, error_to_exception(reason)}
+      end
+    end)
+  end
+
+  @doc """
+  Decodes binaries returned by `query_encoded/4` into a result.
+
+  It accepts the same `:zero_copy_binaries`, `:raw_columns`, `:vector_columns`,
+  `:lazy_columns`, `:dictionary_columns`, `:numeric_columns` and `:output`
+  options as `query/4`.
+  """
+  @spec decode_result([binary], Keyword.t()) :: {:ok, result_set} | {:error, Exception.t()}
+  def decode_result([schema | _] = binaries, options \\ [])
+      when is_binary(schema) and is_list(options) do
+    case Adbc.Nif.adbc_arrow_array_stream_decode(binaries) do
+      {:ok, stream_ref} ->
+        try do
+          read_results(:normal, stream_ref, nil, Keyword.take(options, @stream_options))
+        after
+          Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
+        end
+
+      {:error, reason} ->
+        {:error, error_to_exception(reason)}
+    end
+  end
+
+  @doc """
+  Get metadata about the database/driver.
+
+  The result is an Arrow dataset with the following schema:
+
+
+  | Field Name                 |  Field Type    | Null Contstraint  |
+  | -------------------------- | ---------------|------------------ |
+  | `info_name`                |  `uint32`      | not null          |
+  | `info_value`               |  `INFO_SCHEMA` |                   |
+
+  `INFO_SCHEMA` is a dense union with members:
+
+  | Field Name       | Type Code |  Field Type                   |
+  | -----------------| --------- | ----------------------------- |
+  | `string_value`              | 0 |  `utf8`                    |
+  | `bool_value`                | 1 |  `bool`                    |
+  | `int64_value`               | 2 |  `int64`                   |
+  | `int32_bitmask`             | 3 |  `int32`                   |
+  | `string_list`               | 4 |  `list<utf8>`              |
+  | `int32_to_int32_list_map`   | 5 |  `map<int32, list<int32>>` |
+
+  Each metadatum is identified by an integer code. The recognized
+  codes are defined as constants. Codes [0, 10_000) are reserved
+  for ADBC usage. Drivers/vendors will ignore requests for
+  unrecognized codes (the row will be omitted from the result).
+
+  ## Options
+
+    * `:cache` - the number of milliseconds to cache the result for,
+      defaults to `nil` (no caching). See "Metadata cache" in the module
+      documentation
+  """
+  @spec get_info(t(), list(non_neg_integer()), Keyword.t()) ::
+          {:ok, result_set} | {:error, Exception.t()}
+  def get_info(conn, info_codes \\ [], opts \\ []) when is_list(info_codes) do
+    opts = Keyword.validate!(opts, [:cache])
+    command = metadata_command(:adbc_connection_get_info, [info_codes], opts[:cache])
+    consume(conn, command, &stream_results/3)
+  end
+
+  @doc """
+  Get a hierarchical view of all catalogs, database schemas, tables, and columns.
+
+  The result is an Arrow dataset with the following schema:
+
+  | Field Name               | Field Type                |
+  |--------------------------|---------------------------|
+  | `catalog_name`           | `utf8`                    |
+  | `catalog_db_schemas`     | `list<DB_SCHEMA_SCHEMA>`  |
+
+  `DB_SCHEMA_SCHEMA` is a Struct with fields:
+
+  | Field Name             | Field Type              |
+  |------------------------|-------------------------|
+  | `db_schema_name`       | `utf8`                  |
+  | `db_schema_tables`     | `list<TABLE_SCHEMA>`    |
+
+  `TABLE_SCHEMA` is a Struct with fields:
+
+  | Field Name           | Field Type                | Null Contstraint   |
+  |----------------------|---------------------------|--------------------|
+  | `table_name`         | `utf8`                    | not null           |
+  | `table_type`         | `utf8`                    | not null           |
+  | `table_columns`      | `list<COLUMN_SCHEMA>`     |                    |
+  | `table_constraints`  | `list<CONSTRAINT_SCHEMA>` |                    |
+
+  `COLUMN_SCHEMA` is a Struct with fields:
+
+  | Field Name                 | Field Type  | Null Contstraint | Comments |
+  |----------------------------|-------------|------------------|----------|
+  | `column_name`              | `utf8`      | not null         |          |
+  | `ordinal_position`         | `int32`     |                  | (1)      |
+  | `remarks`                  | `utf8`      |                  | (2)      |
+  | `xdbc_data_type`           | `int16`     |                  | (3)      |
+  | `xdbc_type_name`           | `utf8`      |                  | (3)      |
+  | `xdbc_column_size`         | `int32`     |                  | (3)      |
+  | `xdbc_decimal_digits`      | `int16`     |                  | (3)      |
+  | `xdbc_num_prec_radix`      | `int16`     |                  | (3)      |
+  | `xdbc_nullable`            | `int16`     |                  | (3)      |
+  | `xdbc_column_def`          | `utf8`      |                  | (3)      |
+  | `xdbc_sql_data_type`       | `int16`     |                  | (3)      |
+  | `xdbc_datetime_sub`        | `int16`     |                  | (3)      |
+  | `xdbc_char_octet_length`   | `int32`     |                  | (3)      |
+  | `xdbc_is_nullable`         | `utf8`      |                  | (3)      |
+  | `xdbc_scope_catalog`       | `utf8`      |                  | (3)      |
+  | `xdbc_scope_schema`        | `utf8`      |                  | (3)      |
+  | `xdbc_scope_table`         | `utf8`      |                  | (3)      |
+  | `xdbc_is_autoincrement`    | `bool`      |                  | (3)      |
+  | `xdbc_is_generatedcolumn`  | `bool`      |                  | (3)      |
+
+  1. The column's ordinal position in the table (starting from 1).
+  2. Database-specific description of the column.
+  3. Optional value. Should be null if not supported by the driver.
+     `xdbc_` values are meant to provide JDBC/ODBC-compatible metadata
+     in an agnostic manner.
+
+  `CONSTRAINT_SCHEMA` is a Struct with fields:
+
+  | Field Name                | Field Type           | Null Contstraint | Comments |
+  |---------------------------|----------------------|------------------|----------|
+  | `constraint_name`         | `utf8`               |                  |          |
+  | `constraint_type`         | `utf8`               | not null         | (1)      |
+  | `constraint_column_names` | `list<utf8>`         | not null         | (2)      |
+  | `constraint_column_usage` | `list<USAGE_SCHEMA>` |                  | (3)      |
+
+  1. One of 'CHECK', 'FOREIGN KEY', 'PRIMARY KEY', or 'UNIQUE'.
+  2. The columns on the current table that are constrained, in order.
+  3. For FOREIGN KEY only, the referenced table and columns.
+
+  `USAGE_SCHEMA` is a Struct with fields:
+
+  | Field Name               | Field Type    | Null Contstraint |
+  |--------------------------|---------------|------------------|
+  | `fk_catalog`             | `utf8`        |                  |
+  | `fk_db_schema`           | `utf8`        |                  |
+  | `fk_table`               | `utf8`        | not null         |
+  | `fk_column_name`         | `utf8`        | not null         |
+
+  Drivers build the whole hierarchy before returning it, so on large
+  catalogs give the lowest `depth` needed (`1` for catalogs, `2` for
+  database schemas, `3` for tables, `0` for everything) and filter with
+  the `:catalog`, `:db_schema`, `:table_name` and `:column_name` options,
+  which are patterns as in SQL `LIKE`, instead of filtering the result.
+  The result also accepts the options of `query/4` that shape it, such as
+  `:lazy_columns` and `:output`, and is cached for the given milliseconds
+  with `:cache`, see "Metadata cache" in the module documentation.
+  """
+  @spec get_objects(
+          t(),
+          non_neg_integer(),
+          catalog: String.t(),
+          db_schema: String.t(),
+          table_name: String.t(),
+          table_type: [String.t()],
+          column_name: String.t(),
+          cache: pos_integer()
+        ) :: {:ok, result_set} | {:error, Exception.t()}
+  def get_objects(conn, depth, opts \\ [])
+      when is_integer(depth) and depth >= 0 do
+    {stream_options, opts} = Keyword.split(opts, @stream_options)
+    filters = [:catalog, :db_schema, :table_name, :table_type, :column_name]
+    opts = Keyword.validate!(opts, [:cache | filters])
+
+    args = [
+      depth,
+      opts[:catalog],
+      opts[:db_schema],
+      opts[:table_name],
+      opts[:table_type],
+      opts[:column_name]
+    ]
+
+    command = metadata_command(:adbc_connection_get_objects, args, opts[:cache])
+
+    consume(conn, command, fn scheduler, stream_ref, rows ->
+      read_results(scheduler, stream_ref, rows, stream_options)
+    end)
+  end
+
+  @doc """
+  Gets the underlying driver of a connection process.
+
+  ## Examples
+
+      ADBC.Connection.get_driver(conn)
+      #=> {:ok, :sqlite}
+  """
+  @spec get_driver(t()) :: {:ok, atom() | String.t()} | :error
+  def get_driver(conn) do
+    with pid when pid != nil <- GenServer.whereis(conn),
+         {:dictionary, dictionary} <- Process.info(pid, :dictionary),
+         {:adbc_driver, module} <- List.keyfind(dictionary, :adbc_driver, 0),
+         do: {:ok, module},
+         else: (_ -> :error)
+  end
+
+  @doc """
+  Get a list of table types in the database.
+
+  The result is an Arrow dataset with the following schema:
+
+  | Field Name     | Field Type    | Null Contstraint |
+  |----------------|---------------|------------------|
+  | `table_type`   | `utf8`        | not null         |
+
+  ## Options
+
+    * `:cache` - the number of milliseconds to cache the result for,
+      defaults to `nil` (no caching). See "Metadata cache" in the module
+      documentation
+  """
+  @spec get_table_types(t, Keyword.t()) ::
+          {:ok, result_set} | {:error, Exception.t()}
+  def get_table_types(conn, opts \\ []) do
+    opts = Keyword.validate!(opts, [:cache])
+    command = metadata_command(:adbc_connection_get_table_types, [], opts[:cache])
+    consume(conn, command, &stream_results/3)
+  end
+
+  @doc """
+  Gets the statistics of the tables of the database, as reported by the
+  driver, such as the number of rows of tables and the number of distinct
+  and null values of columns.
+
+  Returns a list of maps with the `:catalog`, `:db_schema`, `:table_name`
+  and `:column_name` (`nil` for statistics of whole tables) they apply to,
+  the `:name` of the statistic, its `:value` and whether it is
+  `:approximate`. The standard statistics are named `:average_byte_width`,
+  `:distinct_count`, `:max_byte_width`, `:max_value`, `:min_value`,
+  `:null_count` and `:row_count`, the others by the names given by the
+  driver, see `get_statistic_names/2`.
+
+  Not all drivers report statistics: PostgreSQL does, from its catalogs,
+  while SQLite returns an error.
+
+  ## Options
+
+    * `:catalog`, `:db_schema`, `:table_name` - only return the statistics
+      of the matching tables, given as patterns as in `get_objects/3`,
+      defaults to `nil` (all)
+
+    * `:approximate` - whether approximate statistics, which are cheaper
+      to compute, may be returned, defaults to `true`. Drivers may still
+      return approximate statistics when `false`, see `:approximate` in
+      the result
+
+    * `:cache` - the number of milliseconds to cache the result for,
+      defaults to `nil` (no caching). See "Metadata cache" in the module
+      documentation
+
+  ## Examples
+
+      {:ok, statistics} = Adbc.Connection.get_statistics(conn, table_name: "events")
+      for %{column_name: nil, name: :row_count, value: rows} <- statistics, do: rows
+      #=> [1048576]
+
+  """
+  @spec get_statistics(t, Keyword.t()) :: {:ok, [map]} | {:error, Exception.t()}
+  def get_statistics(conn, opts \\ []) do
+    opts =
+      Keyword.validate!(opts, [:catalog, :db_schema, :table_name, :cache, approximate: true])
+
+    args = [opts[:catalog], opts[:db_schema], opts[:table_name], opts[:approximate] == true]
+    command = metadata_command(:adbc_connection_get_statistics, args, opts[:cache])
+
+    with {:ok, statistics} <- consume(conn, command, &read_statistics/3) do
+      names =
+        if Enum.any?(statistics, fn {_, _, _, _, key, _, _} -> key > @max_statistic_key end),
+          do: statistic_names(conn),
+          else: %{}
+
+      {:ok,
+       for {catalog, db_schema, table_name, column_name, key, value, approximate} <- statistics do
+         %{
+           catalog: catalog,
+           db_schema: db_schema,
+           table_name: table_name,
+           column_name: column_name,
+           name: statistic_name(key, names),
+           value: value,
+           approximate: approximate
+         }
+       end}
+    end
+  end
+
+  @statistic_keys [
+    :average_byte_width,
+    :distinct_count,
+    :max_byte_width,
+    :max_value,
+    :min_value,
+    :null_count,
+    :row_count
+  ]
+
+  @max_statistic_key length(@statistic_keys) - 1
+
+  defp read_statistics(scheduler, stream_ref, _rows) do
+    case Adbc.Helper.nif(scheduler, :adbc_arrow_array_stream_statistics, [stream_ref]) do
+      {:ok, statistics} -> {:ok, statistics}
+      {:error, reason} -> {:error, error_to_exception(reason)}
+    end
+  end
+
+  # driver-specific keys are named by the driver, or left as integers
+  defp statistic_name(key, _names) when key in 0..@max_statistic_key,
+    do: Enum.at(@statistic_keys, key)
+
+  defp statistic_name(key, names), do: Map.get(names, key, key)
+
+  defp statistic_names(conn) do
+    with {:ok, %Adbc.Result{} = result} <- get_statistic_names(conn),
+         %{"statistic_name" => names, "statistic_key" => keys} <- Adbc.Result.to_map(result) do
+      Map.new(Enum.zip(keys, names))
+    else
+      _ -> %{}
+    end
+  end
+
+  @doc """
+  Get the names of the driver-specific statistics of `get_statistics/2`.
+
+  The result is an Arrow dataset with the following schema:
+
+  | Field Name       | Field Type | Null Contstraint |
+  |------------------|------------|------------------|
+  | `statistic_name` | `utf8`     | not null         |
+  | `statistic_key`  | `int16`    | not null         |
+
+  ## Options
+
+    * `:cache` - the number of milliseconds to cache the result for,
+      defaults to `nil` (no caching). See "Metadata cache" in the module
+      documentation
+  """
+  @spec get_statistic_names(t, Keyword.t()) :: {:ok, result_set} | {:error, Exception.t()}
+  def get_statistic_names(conn, opts \\ []) do
+    opts = Keyword.validate!(opts, [:cache])
+    command = metadata_command(:adbc_connection_get_statistic_names, [], opts[:cache])
+    consume(conn, command, &stream_results/3)
+  end
+
+  @doc """
+  Evicts the results of `get_info/3`, `get_objects/3`,
+  `get_table_types/2`, `get_statistics/2` and `get_statistic_names/2`
+  cached with `:cache` for the database of `conn`.
+
+  Connections evict them on their own before running DDL, see "Metadata
+  cache" in the module documentation.
+  """
+  @spec clear_metadata_cache(t()) :: :ok
+  def clear_metadata_cache(conn), do: GenServer.call(conn, :clear_metadata_cache, :infinity)
+
+  # Metadata results are cached natively like query results, under a key
+  # prefixed by the database so they can be evicted together
+  defp metadata_command(name, args, nil), do: {name, args}
+
+  defp metadata_command(name, args, ttl) when is_integer(ttl) and ttl > 0,
+    do: {:metadata, name, args, ttl}
+
+  defp metadata_command(_name, _args, ttl) do
+    raise ArgumentError, ":cache must be nil or a positive integer, got: #{inspect(ttl)}"
+  end
+
+  @doc """
+  Runs the given `query` with `params` as a partitioned result set and
+  returns its partitions.
+
+  Each partition is an opaque binary, to be read with `read_partition/3`
+  by any connection to the same database, possibly in another process or
+  on another node, so that large results are read in parallel instead of
+  through a single stream. Only drivers that split their results, such as
+  Flight SQL and Snowflake, support partitions, others return an error.
+
+  ## Examples
+
+      {:ok, partitions} = Adbc.Connection.execute_partitions(conn, "SELECT * FROM events")
+
+      partitions
+      |> Enum.zip(Stream.cycle(conns))
+      |> Task.async_stream(fn {partition, conn} ->
+        Adbc.Connection.read_partition(conn, partition)
+      end)
+
+  """
+  @spec execute_partitions(t(), binary | reference, [term], Keyword.t()) ::
+          {:ok, [binary]} | {:error, Exception.t()}
+  def execute_partitions(conn, query, params \\ [], statement_options \\ [])
+      when (is_binary(query) or is_reference(query)) and is_list(params) and
+             is_list(statement_options) do
+    command(conn, {:execute_partitions, query, params, statement_options})
+  end
+
+  @doc """
+  Reads a partition returned by `execute_partitions/4`.
+
+  Accepts the options of `query/4` that shape its result, such as
+  `:lazy_columns` and `:output`.
+  """
+  @spec read_partition(t(), binary, Keyword.t()) :: {:ok, result_set} | {:error, Exception.t()}
+  def read_partition(conn, partition, opts \\ []) when is_binary(partition) and is_list(opts) do
+    {stream_options, _opts} = Keyword.split(opts, @stream_options)
+    command = {:adbc_connection_read_partition, [partition]}
+
+    consume(conn, command, fn scheduler, stream_ref, rows ->
+      read_results(scheduler, stream_ref, rows, stream_options)
+    end)
+  end
+
+  defp command(conn, command) do
+    case GenServer.call(conn, {:command, command, :normal}, :infinity) do
+      {:ok, result} -> {:ok, result}
+      {:error, reason} -> {:error, error_to_exception(reason)}
+    end
+  end
+
+  defp consume(conn, command, fun, priority \\ :normal) do
+    case GenServer.call(conn, {:stream, command, priority}, :infinity) do
+      {:ok, scheduler, stream_ref, rows_affected} ->
+        try do
+          fun.(scheduler, stream_ref, normalize_rows(rows_affected))
+        after
+          # Releasing the stream natively unlocks the connection
+          Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
+        end
+
+      {:error, reason} ->
+        {:error, error_to_exception(reason)}
+    end
+  end
+
+  # Runs a query on `conn` from the calling process, used by `Adbc.Pool`.
+  @doc false
+  def __query__(conn, scheduler, query_or_prepared, params, statement_options) do
+    {timeout, statement_options} = Keyword.pop(statement_options, :timeout, :infinity)
+    validate_timeout!(timeout)
+    {stream_options, statement_options} = Keyword.split(statement_options, @stream_options)
+    {limits, statement_options} = Keyword.split(statement_options, @limit_options)
+    validate_limits!(limits)
+    {trusted, statement_options} = Keyword.pop(statement_options, :trusted_params, false)
+    # results are only cached by queries through the connection process
+    statement_options = Keyword.delete(statement_options, :cache)
+
+    Adbc.Telemetry.span(%{connection: conn, query: query_or_prepared}, fn telemetry ->
+      with {:ok, stmt} <- ensure_statement(conn, query_or_prepared, statement_options),
+           :ok <- maybe_bind(stmt, params, trusted),
+           {:ok, stream_ref, rows_affected} <- await_query(scheduler, stmt, timeout),
+           :ok <- limit_stream(stream_ref, stmt, limits) do
+        rows = normalize_rows(rows_affected)
+
+        try do
+          read_results(scheduler, stream_ref, rows, stream_options, telemetry)
+        after
+          Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
+        end
+      else
+        {:error, reason} -> {:error, error_to_exception(reason)}
+      end
+    end)
+  end
+
+  defp await_query(scheduler, stmt, timeout) do
+    case execute_query(scheduler, stmt) do
+      {:async, ref} ->
+        receive do
+          {^ref, result} -> result
+        after
+          timeout ->
+            # The connection cannot be reused until the query completes
+            Adbc.Nif.adbc_statement_cancel(stmt)
+
+            receive do
+              {^ref, {:ok, stream_ref, _rows_affected}} ->
+                Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
+
+              {^ref, {:error, _reason}} ->
+                :ok
+            end
+
+            {:error, {:adbc_error, "query timed out", 0, "HYT00"}}
+        end
+
+      other ->
+        other
+    end
+  end
+
+  defp normalize_rows(-1), do: nil
+  defp normalize_rows(rows) when is_integer(rows) and rows >= 0, do: rows
+
+  defp read_results(scheduler, reference, num_rows, stream_options, telemetry \\ nil) do
+    {shared, stream_options} = Keyword.pop(stream_options, :shared, false)
+    {spill, stream_options} = Keyword.pop(stream_options, :spill, false)
+
+    cond do
+      spill ->
+        dir = if spill == true, do: System.tmp_dir!(), else: spill
+        args = [reference, to_string(dir)]
+        share_results(scheduler, :adbc_arrow_array_stream_spill, args, num_rows, telemetry)
+
+      shared ->
+        args = [reference]
+        share_results(scheduler, :adbc_arrow_array_stream_share, args, num_rows, telemetry)
+
+      true ->
+        convert_results(scheduler, reference, num_rows, stream_options, telemetry)
+    end
+  end
+
+  defp share_results(scheduler, nif, [reference | _] = args, num_rows, telemetry) do
+    Adbc.Telemetry.read(telemetry, reference, fn ->
+      case Adbc.Helper.nif(scheduler, nif, args) do
+        {:ok, ref, rows, columns} ->
+          shared = %Adbc.SharedResult{ref: ref, num_rows: rows, columns: columns}
+          {:ok, %Adbc.Result{data: shared, num_rows: num_rows}}
+
+        {:error, reason} ->
+          {:error, error_to_exception(reason)}
+      end
+    end)
+  end
+
+  defp convert_results(scheduler, reference, num_rows, stream_options, telemetry) do
+    zero_copy_binaries = Keyword.get(stream_options, :zero_copy_binaries, false)
+    lazy_columns = Keyword.get(stream_options, :lazy_columns, false)
+    parallel_batches = Keyword.get(stream_options, :parallel_batches, 0)
+    parallel_columns = Keyword.get(stream_options, :parallel_columns, false)
+    output = Keyword.get(stream_options, :output, :columns)
+
+    # Columns are read lazily and their record batches concatenated natively,
+    # so each column is converted once instead of once per batch and then
+    # merged. Zero-copy binaries must reference their own batch instead, and
+    # batches converted in parallel are converted whole.
+    materialize? =
+      output == :columns and not lazy_columns and not zero_copy_binaries and
+        parallel_batches == 0 and not parallel_columns
+
+    stream_options = Keyword.put(stream_options, :lazy_columns, lazy_columns or materialize?)
+    scheduler = next_scheduler(scheduler, stream_options)
+
+    with :ok <- configure_stream(reference, stream_options) do
+      Adbc.Telemetry.read(telemetry, reference, fn ->
+        case stream_results(scheduler, reference, num_rows, output, telemetry) do
+          {:ok, result} when materialize? -> {:ok, materialize(result)}
+          other -> other
+        end
+      end)
+    else
+      {:error, reason} -> {:error, error_to_exception(reason)}
+    end
+  end
+
+  # Reads the stream of `Adbc.SharedResult.to_result/2`, whose first batch
+  # starts `skip` rows before the range of `length` rows to return.
+  @doc false
+  def __read_shared__(stream_ref, skip, length, stream_options) do
+    shaping_options = @stream_options -- [:shared, :spill]
+    {stream_options, _opts} = Keyword.split(stream_options, shaping_options)
+    output = Keyword.get(stream_options, :output, :columns)
+
+    try do
+      with {:ok, %Adbc.Result{data: data} = result} <-
+             read_results(:normal, stream_ref, nil, stream_options) do
+        data =
+          case output do
+            :columns -> Enum.map(data, &Adbc.Column.slice(&1, skip, length))
+            _rows -> Enum.slice(data, skip, length)
+          end
+
+        {:ok, %Adbc.Result{result | data: data}}
+      end
+    after
+      Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
+    end
+  end
+
+  defp configure_stream(reference, stream_options) do
+    opt = &Keyword.get(stream_options, &1, &2)
+    intern_atoms = opt.(:intern_atoms, false)
+
+    with :ok <- maybe_prefetch(reference, opt.(:prefetch, 0), opt.(:prefetch_bytes, nil)),
+         :ok <- maybe_coalesce(reference, stream_options),
+         :ok <- maybe_zero_copy_binaries(reference, opt.(:zero_copy_binaries, false)),
+         :ok <- maybe_raw_columns(reference, opt.(:raw_columns, false)),
+         :ok <- maybe_vector_columns(reference, opt.(:vector_columns, false)),
+         :ok <- maybe_lazy_columns(reference, opt.(:lazy_columns, false)),
+         :ok <- maybe_dictionary_columns(reference, opt.(:dictionary_columns, false)),
+         :ok <- maybe_numeric_columns(reference, opt.(:numeric_columns, false)),
+         :ok <- maybe_intern_columns(reference, opt.(:intern_columns, false), intern_atoms),
+         :ok <- maybe_datetime_columns(reference, opt.(:datetime_columns, false)),
+         :ok <- maybe_output(reference, opt.(:output, :columns)),
+         :ok <- maybe_parallel_columns(reference, opt.(:parallel_columns, false)) do
+      maybe_parallel_batches(reference, opt.(:parallel_batches, 0))
+    end
+  end
+
+  # Batches and columns converted in parallel are waited for on a dirty
+  # scheduler.
+  defp next_scheduler(scheduler, stream_options) do
+    parallel? =
+      Keyword.get(stream_options, :parallel_batches, 0) > 0 or
+        Keyword.get(stream_options, :parallel_columns, false)
+
+    if parallel?, do: :dirty_io, else: scheduler
+  end
+
+  defp materialize(%Adbc.Result{data: columns} = result) do
+    columns =
+      Enum.map(columns, fn
+        %Adbc.Column{data: {:lazy, _, _, _}} = column ->
+          %Adbc.Column{column | data: Adbc.Column.to_list(column)}
+
+        column ->
+          column
+      end)
+
+    %Adbc.Result{result | data: columns}
+  end
+
+  defp maybe_prefetch(_reference, 0, nil), do: :ok
+
+  defp maybe_prefetch(reference, 0, max_bytes),
+    do: maybe_prefetch(reference, @max_prefetch, max_bytes)
+
+  defp maybe_prefetch(reference, prefetch, max_bytes)
+       when is_integer(prefetch) and prefetch > 0 and
+              (is_nil(max_bytes) or (is_integer(max_bytes) and max_bytes > 0)),
+       do: Adbc.Nif.adbc_arrow_array_stream_prefetch(reference, prefetch, max_bytes || 0)
+
+  defp maybe_coalesce(reference, stream_options) do
+    target_time = Keyword.get(stream_options, :target_batch_time)
+    rows = Keyword.get(stream_options, :coalesce_rows)
+    bytes = Keyword.get(stream_options, :coalesce_bytes)
+
+    if target_time || rows || bytes do
+      target_time = if target_time, do: target_time * 1_000_000, else: 0
+      Adbc.Nif.adbc_arrow_array_stream_coalesce(reference, target_time, rows || 0, bytes || 0)
+    else
+      :ok
+    end
+  end
+
+  defp maybe_zero_copy_binaries(_reference, false), do: :ok
+
+  defp maybe_zero_copy_binaries(reference, true),
+    do: Adbc.Nif.adbc_arrow_array_stream_set_option(reference, :zero_copy_binaries, true)
+
+  defp maybe_raw_columns(_reference, false), do: :ok
+
+  defp maybe_raw_columns(reference, true),
+    do: Adbc.Nif.adbc_arrow_array_stream_set_option(reference, :raw_columns, true)
+
+  defp maybe_vector_columns(_reference, false), do: :ok
+
+  defp maybe_vector_columns(reference, true),
+    do: Adbc.Nif.adbc_arrow_array_stream_set_option(reference, :vector_columns, true)
+
+  defp maybe_output(_reference, :columns), do: :ok
+
+  defp maybe_output(reference, output) when output in [:rows_tuples, :rows_maps],
+    do: Adbc.Nif.adbc_arrow_array_stream_set_option(reference, :output, output)
+
+  defp maybe_parallel_batches(_reference, 0), do: :ok
+
+  defp maybe_parallel_batches(reference, window) when is_integer(window) and window > 0,
+    do: Adbc.Nif.adbc_arrow_array_stream_set_option(reference, :parallel_batches, window)
+
+  defp maybe_parallel_columns(_reference, false), do: :ok
+
+  defp maybe_parallel_columns(reference, true),
+    do: Adbc.Nif.adbc_arrow_array_stream_set_option(reference, :parallel_columns, true)
+
+  defp maybe_lazy_columns(_reference, false), do: :ok
+
+  defp maybe_lazy_columns(reference, true),
+    do: Adbc.Nif.adbc_arrow_array_stream_set_option(reference, :lazy_columns, true)
+
+  defp maybe_dictionary_columns(_reference, false), do: :ok
+
+  defp maybe_dictionary_columns(reference, true),
+    do: Adbc.Nif.adbc_arrow_array_stream_set_option(reference, :dictionary_columns, true)
+
+  defp maybe_numeric_columns(_reference, false), do: :ok
+
+  defp maybe_numeric_columns(reference, true),
+    do: Adbc.Nif.adbc_arrow_array_stream_set_option(reference, :numeric_columns, true)
+
+  defp maybe_intern_columns(_reference, false, _atoms), do: :ok
+
+  defp maybe_intern_columns(reference, columns, atoms)
+       when (columns == true or is_list(columns)) and is_boolean(atoms) do
+    Adbc.Nif.adbc_arrow_array_stream_set_option(reference, :intern_columns, {columns, atoms})
+  end
+
+  defp maybe_datetime_columns(_reference, false), do: :ok
+
+  defp maybe_datetime_columns(reference, true),
+    do: Adbc.Nif.adbc_arrow_array_stream_set_option(reference, :datetime_columns, true)
+
+  defp stream_results(scheduler, reference, num_rows, output \\ :columns, telemetry \\ nil),
+    do: read_batches(scheduler, reference, [], num_rows, output, telemetry)
+
+  defp read_batches(scheduler, reference, acc, num_rows, output, telemetry) do
+    next = fn -> Adbc.Helper.nif(scheduler, :adbc_arrow_array_stream_next, [reference]) end
+
+    case Adbc.Telemetry.batch(telemetry, reference, next) do
+      {:ok, results, _done} ->
+        read_batches(scheduler, reference, [results | acc], num_rows, output, telemetry)
+
+      :end_of_series ->
+        {:ok, %Adbc.Result{data: merge_batches(output, Enum.reverse(acc)), num_rows: num_rows}}
+
+      {:error, reason} ->
+        {:error, error_to_exception(reason)}
+    end
+  end
+
+  defp merge_batches(:columns, batches), do: merge_columns(batches)
+  defp merge_batches(_rows, batches), do: Enum.concat(batches)
+
+  defp merge_columns([result]), do: result
+
+  defp merge_columns(chunked_results) do
+    Enum.zip_with(chunked_results, fn [column | _] = columns ->
+      %{column | data: Adbc.Column.concat_data(column.type, Enum.map(columns, & &1.data))}
+    end)
+  end
+
+  ## Callbacks
+
+  @impl true
+  def init({db, conn, statement_cache, limits, queue_limits}) do
+    case Adbc.Database.init_connection(Adbc.Database.connect(db), conn) do
+      {:ok, driver, scheduler} ->
+        Process.put(:adbc_driver, driver)
+
+        {:ok,
+         %{
+           conn: conn,
+           cache_scope: {driver, db},
+           scheduler: scheduler,
+           lock: :none,
+           queues: Map.new(@priorities, &{&1, :queue.new()}),
+           queue_limits: queue_limits,
+           statements: new_statement_cache(statement_cache),
+           limits: limits
+         }}
+
+      {:error, reason} ->
+        {:stop, error_to_exception(reason)}
+    end
+  end
+
+  @impl true
+  def handle_call({kind, command, priority}, from, state) when kind in [:stream, :command] do
+    queue = Map.fetch!(state.queues, priority)
+
+    if :queue.len(queue) < Map.get(state.queue_limits, priority, :infinity) do
+      queue = :queue.in({kind, command, from}, queue)
+      {:noreply, maybe_dequeue(put_in(state.queues[priority], queue))}
+    else
+      message = "the queue of #{inspect(priority)} priority calls of the connection is full"
+      {:reply, {:error, {:adbc_error, message, 0, nil}}, state}
+    end
+  end
+
+  def handle_call(:clear_metadata_cache, _from, state) do
+    {:reply, Adbc.Nif.adbc_result_cache_evict(metadata_prefix(state)), state}
+  end
+
+  def handle_call({:option, func, args}, _from, state = %{conn: conn}) do
+    {:reply, Adbc.Helper.option(conn, func, args), state}
+  end
+
+  @impl true
+  def handle_info(
+        {ref, result},
+        %{lock: {:executing, ref, stmt, from, monitor_ref, timer, limits}} = state
+      ) do
+    if timer, do: Process.cancel_timer(timer)
+    if monitor_ref, do: Process.demonitor(monitor_ref, [:flush])
+
+    case result do
+      {:ok, stream_ref, rows_affected} when from != nil ->
+        case setup_stream(stream_ref, stmt, rows_affected, limits) do
+          :ok ->
+            {:noreply, lock_stream(from, stream_ref, rows_affected, state)}
+
+          {:error, error} ->
+            GenServer.reply(from, {:error, error})
+            {:noreply, maybe_dequeue(%{state | lock: :none})}
+        end
+
+      {:ok, stream_ref, _rows_affected} ->
+        # The query was cancelled but finished anyway
+        Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
+        {:noreply, maybe_dequeue(%{state | lock: :none})}
+
+      {:error, error} ->
+        if from, do: GenServer.reply(from, {:error, error})
+        state = forget_statement(state, stmt)
+        {:noreply, maybe_dequeue(%{state | lock: :none})}
+    end
+  end
+
+  def handle_info(
+        {:timeout, ref},
+        %{lock: {:executing, ref, stmt, from, monitor_ref, _timer, limits}} = state
+      )
+      when from != nil do
+    Adbc.Nif.adbc_statement_cancel(stmt)
+    Process.demonitor(monitor_ref, [:flush])
+    GenServer.reply(from, {:error, {:adbc_error, "query timed out", 0, "HYT00"}})
+    {:noreply, %{state | lock: {:executing, ref, stmt, nil, nil, nil, limits}}}
+  end
+
+  def handle_info({:timeout, _ref}, state) do
+    {:noreply, state}
+  end
+
+  def handle_info(
+        {:DOWN, monitor_ref, _, _, _},
+        %{lock: {:executing, ref, stmt, _, monitor_ref, timer, limits}} = state
+      ) do
+    # Keep the connection locked until the cancelled query completes
+    Adbc.Nif.adbc_statement_cancel(stmt)
+    if timer, do: Process.cancel_timer(timer)
+    {:noreply, %{state | lock: {:executing, ref, stmt, nil, nil, nil, limits}}}
+  end
+
+  # Sent natively once the owner of the stream released it or exited
+  def handle_info({:adbc_stream_released, ref}, %{lock: {:streaming, ref}} = state) do
+    {:noreply, maybe_dequeue(%{state | lock: :none})}
+  end
+
+  def handle_info({:adbc_stream_released, _ref}, state) do
+    {:noreply, state}
+  end
+
+  ## Queue helpers
+
+  defp maybe_dequeue(%{lock: :none} = state) do
+    case dequeue(state) do
+      :empty ->
+        state
+
+      {{:command, command, from}, state} ->
+        maybe_evict_metadata(command, state)
+        {command, state} = cached_statement(command, state)
+        result = handle_command(command, state)
+        GenServer.reply(from, result)
+
+        state =
+          case result do
+            {:error, _} -> forget_statement(state, elem(command, 1))
+            _ -> state
+          end
+
+        maybe_dequeue(state)
+
+      {{:stream, command, from}, state} ->
+        maybe_evict_metadata(command, state)
+        {command, state} = cached_statement(command, state)
+
+        case handle_stream(command, state) do
+          {:ok, stream_ref, rows_affected} when is_reference(stream_ref) ->
+            lock_stream(from, stream_ref, rows_affected, state)
+
+          {:async, ref, stmt, timeout, limits} ->
+            {pid, _} = from
+            monitor_ref = Process.monitor(pid)
+            timer = start_timer(ref, timeout)
+            lock = {:executing, ref, stmt, from, monitor_ref, timer, limits}
+            %{state | lock: lock}
+
+          {:error, error} ->
+            GenServer.reply(from, {:error, error})
+            state = forget_statement(state, elem(command, 1))
+            maybe_dequeue(state)
+        end
+    end
+  end
+
+  defp maybe_dequeue(state), do: state
+
+  # Takes the oldest call of the highest priority
+  defp dequeue(%{queues: queues} = state) do
+    Enum.find_value(@priorities, :empty, fn priority ->
+      case :queue.out(Map.fetch!(queues, priority)) do
+        {{:value, call}, queue} -> {call, put_in(state.queues[priority], queue)}
+        {:empty, _queue} -> nil
+      end
+    end)
+  end
+
+  defp start_timer(_ref, :infinity), do: nil
+
+  defp start_timer(ref, timeout) when is_integer(timeout) and timeout >= 0,
+    do: Process.send_after(self(), {:timeout, ref}, timeout)
+
+  # The caller owns the stream until it releases it, drops it or exits,
+  # which the stream notifies natively with `{:adbc_stream_released,
+  # unlock_ref}`. The lock does not keep the stream, so it can be dropped
+  defp lock_stream({pid, _} = from, stream_ref, rows_affected, state) do
+    unlock_ref = make_ref()
+    :ok = Adbc.Nif.adbc_arrow_array_stream_set_owner(stream_ref, pid, unlock_ref)
+    GenServer.reply(from, {:ok, state.scheduler, stream_ref, rows_affected})
+    %{state | lock: {:streaming, unlock_ref}}
+  end
+
+  defp handle_command({:prepare, query}, state), do: prepare_statement(state, query, [])
+
+  defp handle_command({:execute_partitions, query, params, statement_options}, state) do
+    %{conn: conn, scheduler: scheduler} = state
+    {trusted, statement_options} = Keyword.pop(statement_options, :trusted_params, false)
+
+    with {:ok, stmt} <- ensure_statement(conn, query, statement_options),
+         :ok <- maybe_bind(stmt, params, trusted),
+         {:ok, partitions, _rows_affected} <-
+           Adbc.Helper.nif(scheduler, :adbc_statement_execute_partitions, [stmt]) do
+      {:ok, partitions}
+    end
+  end
+
+  defp handle_command({:batch, statements, transaction}, state) do
+    %{conn: conn, scheduler: scheduler} = state
+    args = [conn, statements, transaction]
+
+    with {:ok, counts} <- Adbc.Helper.nif(scheduler, :adbc_connection_execute_batch, args) do
+      {:ok, Enum.map(counts, &normalize_rows/1)}
+    end
+  end
+
+  defp handle_command({:execute_many, query_or_prepared, rows, statement_options}, state) do
+    %{conn: conn, scheduler: scheduler} = state
 
-  defp handle_stream({:query, query_or_prepared, params, statement_options}, conn) do
     with {:ok, stmt} <- ensure_statement(conn, query_or_prepared, statement_options),
-         :ok <- maybe_bind(stmt, params) do
-      Adbc.Nif.adbc_statement_execute_query(stmt)
+         {:ok, counts} <-
+           Adbc.Helper.nif(scheduler, :adbc_statement_execute_many, [stmt, rows]) do
+      {:ok, Enum.map(counts, &normalize_rows/1)}
+    end
+  end
+
+  defp prepare_statement(%{conn: conn, scheduler: scheduler}, query, statement_options) do
+    with {:ok, stmt} <- create_statement(conn, query, statement_options),
+         :ok <- Adbc.Helper.nif(scheduler, :adbc_statement_prepare, [stmt]) do
+      {:ok, stmt}
+    end
+  end
+
+  ## Statement cache
+
+  # Statements are kept by query and statement options in `entries`, along
+  # with the tick of their last use, and `order` maps ticks back to keys,
+  # so the least recently used statement is the smallest key of `order`.
+  defp new_statement_cache(0), do: nil
+
+  defp new_statement_cache(size),
+    do: %{size: size, entries: %{}, order: :gb_trees.empty(), tick: 0}
+
+  # Replaces the query of `command` by its cached statement, preparing and
+  # caching it on a miss. Queries that cannot be prepared run uncached.
+  defp cached_statement(
+         {kind, query, params, statement_options} = command,
+         %{statements: %{} = cache} = state
+       )
+       when kind in [:query, :execute_many] and is_binary(query) do
+    dropped = [:timeout, :cache, :trusted_params | @limit_options]
+    key = {query, Keyword.drop(statement_options, dropped)}
+
+    case cache.entries do
+      %{^key => {stmt, tick}} ->
+        order = :gb_trees.delete(tick, cache.order)
+        cache = put_statement(%{cache | order: order}, key, stmt)
+        {{kind, stmt, params, statement_options}, %{state | statements: cache}}
+
+      %{} ->
+        case prepare_statement(state, query, elem(key, 1)) do
+          {:ok, stmt} ->
+            cache = put_statement(cache, key, stmt)
+            {{kind, stmt, params, statement_options}, %{state | statements: cache}}
+
+          {:error, _reason} ->
+            {command, state}
+        end
+    end
+  end
+
+  defp cached_statement(command, state), do: {command, state}
+
+  defp put_statement(%{entries: entries, order: order, tick: tick} = cache, key, stmt) do
+    entries = Map.put(entries, key, {stmt, tick})
+    order = :gb_trees.insert(tick, key, order)
+
+    if map_size(entries) > cache.size do
+      {_tick, oldest, order} = :gb_trees.take_smallest(order)
+      %{cache | entries: Map.delete(entries, oldest), order: order, tick: tick + 1}
+    else
+      %{cache | entries: entries, order: order, tick: tick + 1}
+    end
+  end
+
+  # Evicts `stmt` after it failed, as it may have been invalidated by
+  # changes to the schema of the database
+  defp forget_statement(%{statements: %{} = cache} = state, stmt) when is_reference(stmt) do
+    case Enum.find(cache.entries, fn {_key, {cached, _tick}} -> cached == stmt end) do
+      {key, {_stmt, tick}} ->
+        cache = %{
+          cache
+          | entries: Map.delete(cache.entries, key),
+            order: :gb_trees.delete(tick, cache.order)
+        }
+
+        %{state | statements: cache}
+
+      nil ->
+        state
+    end
+  end
+
+  defp forget_statement(state, _stmt), do: state
+
+  defp handle_stream({:query, query_or_prepared, params, statement_options}, state) do
+    %{conn: conn, scheduler: scheduler} = state
+    {timeout, statement_options} = Keyword.pop(statement_options, :timeout, :infinity)
+    {cache, statement_options} = Keyword.pop(statement_options, :cache)
+    {limits, statement_options} = Keyword.split(statement_options, @limit_options)
+    {trusted, statement_options} = Keyword.pop(statement_options, :trusted_params, false)
+    limits = Keyword.merge(state.limits, limits)
+
+    case fetch_cached(state, cache) do
+      {:ok, stream_ref, rows_affected} ->
+        with :ok <- limit_stream(stream_ref, nil, limits) do
+          {:ok, stream_ref, rows_affected}
+        end
+
+      {:miss, cache} ->
+        # the result is cached along with the limits of the stream
+        limits = if cache, do: [{:cache, cache} | limits], else: limits
+
+        with {:ok, stmt} <- ensure_statement(conn, query_or_prepared, statement_options),
+             :ok <- maybe_bind(stmt, params, trusted) do
+          case execute_query(scheduler, stmt) do
+            {:async, ref} ->
+              {:async, ref, stmt, timeout, limits}
+
+            {:ok, stream_ref, rows_affected} ->
+              with :ok <- setup_stream(stream_ref, stmt, rows_affected, limits) do
+                {:ok, stream_ref, rows_affected}
+              end
+
+            {:error, reason} ->
+              {:error, reason}
+          end
+        end
+    end
+  end
+
+  # The caller owns exported streams, so they are not limited
+  defp handle_stream({:export, query_or_prepared, params, statement_options}, state) do
+    state = %{state | limits: []}
+    statement_options = Keyword.drop(statement_options, @limit_options)
+    handle_stream({:query, query_or_prepared, params, statement_options}, state)
+  end
+
+  # Always runs on a native thread, as the driver blocks in `get_next`
+  # until the caller pushes the next batch
+  defp handle_stream({:ingest, table, mode, stream_ref, statement_options}, %{conn: conn}) do
+    {timeout, statement_options} = Keyword.pop(statement_options, :timeout, :infinity)
+    options = [{"adbc.ingest.target_table", table}, {"adbc.ingest.mode", mode}]
+
+    with {:ok, stmt} <- Adbc.Nif.adbc_statement_new(conn),
+         :ok <- init_statement_options(stmt, options ++ statement_options),
+         :ok <- Adbc.Nif.adbc_statement_bind_stream(stmt, stream_ref),
+         {:ok, ref} <- Adbc.Nif.adbc_statement_execute_update_async(stmt, self()) do
+      {:async, ref, stmt, timeout, []}
+    end
+  end
+
+  defp handle_stream({:metadata, name, args, ttl}, state) do
+    key = metadata_prefix(state) <> :erlang.term_to_binary({name, args})
+
+    case Adbc.Nif.adbc_result_cache_fetch(key) do
+      {:ok, stream_ref, rows_affected} ->
+        {:ok, stream_ref, rows_affected}
+
+      :miss ->
+        with {:ok, stream_ref, rows_affected} <- handle_stream({name, args}, state),
+             :ok <- setup_stream(stream_ref, nil, rows_affected, cache: {key, ttl}) do
+          {:ok, stream_ref, rows_affected}
+        end
     end
   end
 
-  defp handle_stream({name, args}, conn) do
-    with {:ok, stream_ref} <- apply(Adbc.Nif, name, [conn | args]) do
+  defp handle_stream({name, args}, %{conn: conn, scheduler: scheduler}) do
+    with {:ok, stream_ref} <- Adbc.Helper.nif(scheduler, name, [conn | args]) do
       {:ok, stream_ref, -1}
     end
   end
 
+  # Off the normal schedulers, queries run on native threads and
+  # the result arrives as a message, so the connection stays responsive.
+  defp execute_query(:normal, stmt), do: Adbc.Nif.adbc_statement_execute_query(stmt)
+
+  defp execute_query(_scheduler, stmt) do
+    with {:ok, ref} <- Adbc.Nif.adbc_statement_execute_query_async(stmt, self()) do
+      {:async, ref}
+    end
+  end
+
   defp ensure_statement(conn, query, statement_options)
        when is_binary(query) and is_list(statement_options),
        do: create_statement(conn, query, statement_options)
@@ -527,6 +2591,131 @@ defmodule Adbc.Connection do
     end
   end
 
-  defp maybe_bind(_stmt, []), do: :ok
-  defp maybe_bind(stmt, params), do: Adbc.Nif.adbc_statement_bind(stmt, params)
+  defp validate_limits!(limits) do
+    for {name, value} <- limits, not (is_nil(value) or (is_integer(value) and value >= 0)) do
+      raise ArgumentError, "#{inspect(name)} must be nil or a non-negative integer"
+    end
+
+    :ok
+  end
+
+  defp metadata_prefix(%{cache_scope: scope}), do: :erlang.term_to_binary({:metadata, scope})
+
+  # Queries changing the schema, and ingestion, which may create or drop
+  # tables, evict the cached metadata of the database first
+  defp maybe_evict_metadata({kind, query, _params, _options}, state)
+       when kind in [:query, :export, :execute_many] and is_binary(query) do
+    if Regex.match?(@ddl, query) do
+      Adbc.Nif.adbc_result_cache_evict(metadata_prefix(state))
+    end
+
+    :ok
+  end
+
+  defp maybe_evict_metadata({:batch, statements, _transaction}, state) do
+    if Enum.any?(statements, fn {query, _params} -> Regex.match?(@ddl, query) end) do
+      Adbc.Nif.adbc_result_cache_evict(metadata_prefix(state))
+    end
+
+    :ok
+  end
+
+  defp maybe_evict_metadata({:ingest, _table, _mode, _stream_ref, _options}, state),
+    do: Adbc.Nif.adbc_result_cache_evict(metadata_prefix(state))
+
+  defp maybe_evict_metadata(_command, _state), do: :ok
+
+  defp fetch_cached(_state, nil), do: {:miss, nil}
+
+  defp fetch_cached(%{cache_scope: scope}, {ttl, key}) do
+    key = :erlang.term_to_binary({scope, key})
+
+    case Adbc.Nif.adbc_result_cache_fetch(key) do
+      {:ok, stream_ref, rows_affected} -> {:ok, stream_ref, rows_affected}
+      :miss -> {:miss, {key, ttl}}
+    end
+  end
+
+  # Caches the result of the stream when asked by `:cache` in `limits`,
+  # then limits it.
+  defp setup_stream(stream_ref, stmt, rows_affected, limits) do
+    case limits[:cache] do
+      nil ->
+        limit_stream(stream_ref, stmt, limits)
+
+      {key, ttl} ->
+        case Adbc.Nif.adbc_arrow_array_stream_cache(stream_ref, key, ttl, rows_affected) do
+          :ok ->
+            limit_stream(stream_ref, stmt, limits)
+
+          {:error, _} = error ->
+            Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
+            error
+        end
+    end
+  end
+
+  # Has the stream cancel `stmt` and release itself once `limits` are
+  # exceeded. A stream that cannot be limited is released right away.
+  defp limit_stream(stream_ref, stmt, limits) do
+    case {limits[:max_result_bytes], limits[:max_rows]} do
+      {nil, nil} ->
+        :ok
+
+      {max_bytes, max_rows} ->
+        max_bytes = max_bytes || -1
+        max_rows = max_rows || -1
+
+        case Adbc.Nif.adbc_arrow_array_stream_set_limits(stream_ref, stmt, max_bytes, max_rows) do
+          :ok ->
+            :ok
+
+          {:error, _} = error ->
+            Adbc.Nif.adbc_arrow_array_stream_release(stream_ref)
+            error
+        end
+    end
+  end
+
+  defp maybe_bind(_stmt, [], _trusted), do: :ok
+
+  defp maybe_bind(stmt, params, trusted),
+    do: Adbc.Nif.adbc_statement_bind(stmt, array_params(params), trusted)
+
+  # `{:array, values}` is bound as the text of a SQL array, in rows too.
+  # Params without arrays, by far the most common, are kept as is.
+  defp array_params(params) do
+    if Enum.any?(params, &array_param?/1) do
+      Enum.map(params, fn
+        {:array, values} when is_list(values) -> IO.iodata_to_binary(array_literal(values))
+        row when is_list(row) -> array_params(row)
+        param -> param
+      end)
+    else
+      params
+    end
+  end
+
+  defp array_param?({:array, values}) when is_list(values), do: true
+  defp array_param?(row) when is_list(row), do: Enum.any?(row, &array_param?/1)
+  defp array_param?(_param), do: false
+
+  defp array_literal(values), do: [?{, Enum.map_intersperse(values, ?,, &array_element/1), ?}]
+
+  defp array_element(nil), do: "NULL"
+  defp array_element(true), do: "t"
+  defp array_element(false), do: "f"
+  defp array_element(value) when is_integer(value), do: Integer.to_string(value)
+  defp array_element(value) when is_float(value), do: Float.to_string(value)
+  defp array_element({:array, values}) when is_list(values), do: array_literal(values)
+
+  defp array_element(value) do
+    escaped =
+      value
+      |> to_string()
+      |> String.replace("\\", "\\\\")
+      |> String.replace(~s("), ~s(\\"))
+
+    [?", escaped, ?"]
+  end
 end
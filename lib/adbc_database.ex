@@ -21,6 +21,25 @@ defmodule Adbc.Database do
     * `:process_options` - the options to be given to the underlying
       process. See `GenServer.start_link/3` for all options
 
+    * `:scheduler` - where calls that may block, such as executing
+      queries or fetching results, run. `:dirty_io` (the default) runs
+      them on dirty I/O schedulers, so a slow query does not stall
+      other processes, and executes queries on a native worker pool,
+      so connections remain responsive while their queries run.
+      `:normal` runs them on regular schedulers, which avoids the
+      scheduling overhead for fast, local drivers.
+      Connections inherit the scheduler of their database
+
+    * `:snapshot` - the path of an SQLite database file, such as one
+      written by `Adbc.Connection.snapshot/2`, copied into each connection
+      to the database as it starts. Tables are created and filled within
+      SQLite with a single `INSERT ... SELECT` each, followed by the
+      indexes, views and triggers of the file, in a single transaction,
+      which is far faster than loading the same data with queries. It is
+      meant for in-memory databases, `uri: ":memory:"`, whose connections
+      each have a database of their own, so that every worker starts from
+      a copy of the same reference data
+
   All other options are given as database options to the underlying driver.
 
   ## Examples
@@ -47,13 +66,23 @@ defmodule Adbc.Database do
     end
 
     {process_options, opts} = Keyword.pop(opts, :process_options, [])
+    {scheduler, opts} = Keyword.pop(opts, :scheduler, :dirty_io)
+    {snapshot, opts} = Keyword.pop(opts, :snapshot)
+
+    unless scheduler in Adbc.Helper.schedulers() do
+      raise ArgumentError,
+            ":scheduler must be one of #{inspect(Adbc.Helper.schedulers())}, got: #{inspect(scheduler)}"
+    end
+
     opts = Keyword.merge(driver_default_options(driver), opts)
+    {entrypoint, opts} = pop_entrypoint(opts)
 
     with {:ok, ref} <- Adbc.Nif.adbc_database_new(),
-         :ok <- init_driver(ref, driver),
+         :ok <- init_driver(ref, driver, entrypoint),
          :ok <- init_options(ref, opts),
-         :ok <- Adbc.Nif.adbc_database_init(ref) do
-      GenServer.start_link(__MODULE__, {driver, ref}, process_options)
+         :ok <- Adbc.Helper.nif(scheduler, :adbc_database_init, [ref]),
+         {:ok, restore} <- snapshot_restore(ref, scheduler, snapshot) do
+      GenServer.start_link(__MODULE__, {driver, ref, scheduler, restore}, process_options)
     else
       {:error, reason} -> {:error, error_to_exception(reason)}
     end
@@ -123,39 +152,169 @@ defmodule Adbc.Database do
     Adbc.Helper.option(db, :adbc_database_set_option, [:float, key, value])
   end
 
+  @doc false
+  # Loads and initialises `driver` ahead of the first database started
+  # for it, with the same `:entrypoint` and `:version` options.
+  def preload(driver, opts \\ []) do
+    {version, opts} = Keyword.pop(opts, :version)
+    opts = Keyword.merge(driver_default_options(driver), opts)
+    {entrypoint, _opts} = pop_entrypoint(opts)
+
+    with {:ok, path} <- Adbc.Driver.so_path(driver, version: version),
+         :ok <- Adbc.Nif.adbc_driver_preload(path, entrypoint) do
+      :ok
+    else
+      {:error, reason} -> {:error, error_to_exception(reason)}
+    end
+  end
+
+  @doc false
+  # Links the calling process to the database and returns what it needs
+  # to initialise connections to it with `init_connection/2`.
+  def connect(db) do
+    GenServer.call(db, :connect, :infinity)
+  end
+
+  @doc false
+  # Initialises `conn_ref` from the calling process rather than from the
+  # database, so that connections to it are initialised in parallel.
+  def init_connection({driver, db_ref, scheduler, restore}, conn_ref) do
+    with :ok <- Adbc.Helper.nif(scheduler, :adbc_connection_init, [conn_ref, db_ref]),
+         :ok <- restore_snapshot(conn_ref, scheduler, restore) do
+      {:ok, driver, scheduler}
+    end
+  end
+
+  # The statements copying the snapshot into a connection, read once from
+  # the schema of the snapshot with a connection of its own
+  defp snapshot_restore(_db_ref, _scheduler, nil), do: {:ok, nil}
+
+  defp snapshot_restore(db_ref, scheduler, path) when is_binary(path) do
+    with {:ok, conn} <- Adbc.Nif.adbc_connection_new() do
+      try do
+        with {:ok, rows} <- snapshot_schema(db_ref, scheduler, conn, path) do
+          statements =
+            Enum.flat_map(rows, fn
+              {"table", name, sql} ->
+                quoted = ~s(") <> String.replace(name, ~s("), ~s("")) <> ~s(")
+                copy = "INSERT INTO main.#{quoted} SELECT * FROM adbc_snapshot.#{quoted}"
+                [{sql, []}, {copy, []}]
+
+              {_type, _name, sql} ->
+                [{sql, []}]
+            end)
+
+          {:ok, {path, statements}}
+        end
+      after
+        Adbc.Nif.adbc_connection_release(conn)
+      end
+    end
+  end
+
+  defp snapshot_schema(db_ref, scheduler, conn, path) do
+    query = """
+    SELECT type, name, sql FROM adbc_snapshot.sqlite_master
+    WHERE sql IS NOT NULL AND name NOT LIKE 'sqlite_%'
+    ORDER BY CASE type WHEN 'table' THEN 0 WHEN 'index' THEN 1 ELSE 2 END, rowid
+    """
+
+    with :ok <- Adbc.Helper.nif(scheduler, :adbc_connection_init, [conn, db_ref]),
+         {:ok, _} <- execute_batch(scheduler, conn, [attach_snapshot(path)], false),
+         {:ok, stmt} <- Adbc.Nif.adbc_statement_new(conn),
+         :ok <- Adbc.Nif.adbc_statement_set_sql_query(stmt, query),
+         {:ok, stream, _} <- execute_query(scheduler, stmt) do
+      try do
+        read_rows(scheduler, stream, [])
+      after
+        Adbc.Nif.adbc_arrow_array_stream_release(stream)
+      end
+    end
+  end
+
+  # Off the normal schedulers, the query runs on the worker pool, as the
+  # queries of connections do
+  defp execute_query(:normal, stmt), do: Adbc.Nif.adbc_statement_execute_query(stmt)
+
+  defp execute_query(_scheduler, stmt) do
+    with {:ok, ref} <- Adbc.Nif.adbc_statement_execute_query_async(stmt, self()) do
+      receive do
+        {^ref, result} -> result
+      end
+    end
+  end
+
+  defp read_rows(scheduler, stream, acc) do
+    case Adbc.Helper.nif(scheduler, :adbc_arrow_array_stream_next, [stream]) do
+      {:ok, columns, _done} ->
+        rows = columns |> Enum.map(&Adbc.Column.to_list/1) |> Enum.zip()
+        read_rows(scheduler, stream, [rows | acc])
+
+      :end_of_series ->
+        {:ok, acc |> Enum.reverse() |> Enum.concat()}
+
+      {:error, reason} ->
+        {:error, reason}
+    end
+  end
+
+  # ATTACH and DETACH cannot run within a transaction
+  defp restore_snapshot(_conn_ref, _scheduler, nil), do: :ok
+
+  defp restore_snapshot(conn_ref, scheduler, {path, statements}) do
+    with {:ok, _} <- execute_batch(scheduler, conn_ref, [attach_snapshot(path)], false),
+         {:ok, _} <- execute_batch(scheduler, conn_ref, statements, true),
+         {:ok, _} <- execute_batch(scheduler, conn_ref, [{"DETACH adbc_snapshot", []}], false) do
+      :ok
+    end
+  end
+
+  defp attach_snapshot(path), do: {"ATTACH DATABASE ? AS adbc_snapshot", [path]}
+
+  defp execute_batch(scheduler, conn_ref, statements, transaction) do
+    args = [conn_ref, statements, transaction]
+    Adbc.Helper.nif(scheduler, :adbc_connection_execute_batch, args)
+  end
+
   defp driver_default_options(:duckdb), do: [entrypoint: "duckdb_adbc_init"]
   defp driver_default_options(_), do: []
 
   ## Callbacks
 
   @impl true
-  def init({driver, db}) do
+  def init({driver, db, scheduler, restore}) do
     Process.flag(:trap_exit, true)
-    {:ok, {driver, db}}
+    {:ok, %{driver: driver, db: db, scheduler: scheduler, restore: restore}}
   end
 
   @impl true
-  def handle_call({:initialize_connection, conn_ref}, {pid, _}, {driver, db}) do
-    case Adbc.Nif.adbc_connection_init(conn_ref, db) do
-      :ok ->
-        Process.link(pid)
-        {:reply, {:ok, driver}, {driver, db}}
-
-      {:error, reason} ->
-        {:reply, {:error, reason}, {driver, db}}
-    end
+  def handle_call(:connect, {pid, _}, state) do
+    %{driver: driver, db: db, scheduler: scheduler, restore: restore} = state
+    Process.link(pid)
+    {:reply, {driver, db, scheduler, restore}, state}
   end
 
-  def handle_call({:option, func, args}, _from, {driver, db}) do
-    {:reply, Adbc.Helper.option(db, func, args), {driver, db}}
+  def handle_call({:option, func, args}, _from, %{db: db} = state) do
+    {:reply, Adbc.Helper.option(db, func, args), state}
   end
 
   @impl true
   def handle_info(_msg, state), do: {:noreply, state}
 
-  defp init_driver(ref, driver) do
+  defp pop_entrypoint(opts) do
+    {entrypoint, opts} = Keyword.pop(opts, :entrypoint, "")
+
+    case List.keytake(opts, "entrypoint", 0) do
+      {{_, entrypoint}, opts} -> {to_string(entrypoint), opts}
+      nil -> {to_string(entrypoint), opts}
+    end
+  end
+
+  # The driver is loaded once per path and entrypoint by the NIF, so that
+  # databases started again for the same driver do not load it again.
+  defp init_driver(ref, driver, entrypoint) do
     case Adbc.Driver.so_path(driver) do
-      {:ok, path} -> Adbc.Helper.option(ref, :adbc_database_set_option, [:string, "driver", path])
+      {:ok, path} -> Adbc.Nif.adbc_database_set_driver(ref, path, entrypoint)
       {:error, reason} -> {:error, reason}
     end
   end
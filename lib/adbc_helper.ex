@@ -39,6 +39,38 @@ defmodule Adbc.Helper do
     end
   end
 
+  # NIFs that may block on I/O and therefore have a `*_dirty_io` variant.
+  @dirty_io_nifs %{
+    adbc_database_init: :adbc_database_init_dirty_io,
+    adbc_connection_init: :adbc_connection_init_dirty_io,
+    adbc_connection_get_info: :adbc_connection_get_info_dirty_io,
+    adbc_connection_get_objects: :adbc_connection_get_objects_dirty_io,
+    adbc_connection_get_table_types: :adbc_connection_get_table_types_dirty_io,
+    adbc_connection_get_statistics: :adbc_connection_get_statistics_dirty_io,
+    adbc_connection_get_statistic_names: :adbc_connection_get_statistic_names_dirty_io,
+    adbc_connection_read_partition: :adbc_connection_read_partition_dirty_io,
+    adbc_statement_prepare: :adbc_statement_prepare_dirty_io,
+    adbc_statement_execute_many: :adbc_statement_execute_many_dirty_io,
+    adbc_connection_execute_batch: :adbc_connection_execute_batch_dirty_io,
+    adbc_statement_execute_partitions: :adbc_statement_execute_partitions_dirty_io,
+    adbc_arrow_array_stream_next: :adbc_arrow_array_stream_next_dirty_io,
+    adbc_arrow_array_stream_share: :adbc_arrow_array_stream_share_dirty_io,
+    adbc_arrow_array_stream_spill: :adbc_arrow_array_stream_spill_dirty_io,
+    adbc_arrow_array_stream_to_matrix: :adbc_arrow_array_stream_to_matrix_dirty_io,
+    adbc_arrow_array_stream_encode: :adbc_arrow_array_stream_encode_dirty_io
+  }
+
+  @doc false
+  def schedulers, do: [:dirty_io, :normal]
+
+  @doc false
+  def nif(scheduler, func, args)
+
+  def nif(:normal, func, args), do: apply(Adbc.Nif, func, args)
+
+  def nif(:dirty_io, func, args),
+    do: apply(Adbc.Nif, Map.get(@dirty_io_nifs, func, func), args)
+
   def option_ok_or_halt(callee, func, args) do
     case option(callee, func, args) do
       :ok -> {:cont, :ok}
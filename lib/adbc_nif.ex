@@ -14,21 +14,48 @@ defmodule Adbc.Nif do
           :ok
       end
 
-    case :erlang.load_nif(nif_file, 0) do
+    case :erlang.load_nif(nif_file, load_info()) do
       :ok -> :ok
       {:error, {:reload, _}} -> :ok
       {:error, reason} -> IO.puts("Failed to load nif: #{inspect(reason)}")
     end
   end
 
+  # The native worker pool is started when the NIF loads, see the
+  # "Native threads" section of `Adbc`.
+  defp load_info do
+    threads =
+      case Application.get_env(:adbc, :worker_threads) do
+        nil -> 0
+        threads when is_integer(threads) and threads > 0 -> threads
+        {:schedulers, factor} when is_number(factor) and factor > 0 ->
+          max(1, round(:erlang.system_info(:schedulers) * factor))
+
+        other ->
+          raise ArgumentError,
+                "the :worker_threads config of :adbc must be a positive integer or " <>
+                  "{:schedulers, factor}, got: #{inspect(other)}"
+      end
+
+    affinity = Application.get_env(:adbc, :worker_affinity, false)
+    cache_bytes = Application.get_env(:adbc, :result_cache_bytes, 64 * 1024 * 1024)
+    %{worker_threads: threads, worker_affinity: affinity, result_cache_bytes: cache_bytes}
+  end
+
   def adbc_database_new, do: :erlang.nif_error(:not_loaded)
 
   def adbc_database_get_option(_self, _type, _key), do: :erlang.nif_error(:not_loaded)
 
   def adbc_database_set_option(_self, _type, _key, _value), do: :erlang.nif_error(:not_loaded)
 
+  def adbc_database_set_driver(_self, _driver, _entrypoint), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_driver_preload(_driver, _entrypoint), do: :erlang.nif_error(:not_loaded)
+
   def adbc_database_init(_self), do: :erlang.nif_error(:not_loaded)
 
+  def adbc_database_init_dirty_io(_self), do: :erlang.nif_error(:not_loaded)
+
   def adbc_connection_new, do: :erlang.nif_error(:not_loaded)
 
   def adbc_connection_get_option(_self, _type, _key), do: :erlang.nif_error(:not_loaded)
@@ -37,8 +64,14 @@ defmodule Adbc.Nif do
 
   def adbc_connection_init(_self, _database), do: :erlang.nif_error(:not_loaded)
 
+  def adbc_connection_init_dirty_io(_self, _database), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_connection_release(_self), do: :erlang.nif_error(:not_loaded)
+
   def adbc_connection_get_info(_self, _info_codes), do: :erlang.nif_error(:not_loaded)
 
+  def adbc_connection_get_info_dirty_io(_self, _info_codes), do: :erlang.nif_error(:not_loaded)
+
   def adbc_connection_get_objects(
         _self,
         _depth,
@@ -50,8 +83,42 @@ defmodule Adbc.Nif do
       ),
       do: :erlang.nif_error(:not_loaded)
 
+  def adbc_connection_get_objects_dirty_io(
+        _self,
+        _depth,
+        _catalog,
+        _db_schema,
+        _table_name,
+        _table_type,
+        _column_name
+      ),
+      do: :erlang.nif_error(:not_loaded)
+
   def adbc_connection_get_table_types(_self), do: :erlang.nif_error(:not_loaded)
 
+  def adbc_connection_get_table_types_dirty_io(_self), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_connection_get_statistics(_self, _catalog, _db_schema, _table_name, _approximate),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_connection_get_statistics_dirty_io(
+        _self,
+        _catalog,
+        _db_schema,
+        _table_name,
+        _approximate
+      ),
+      do: :erlang.nif_error(:not_loaded)
+
+  def adbc_connection_get_statistic_names(_self), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_connection_get_statistic_names_dirty_io(_self), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_connection_read_partition(_self, _partition), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_connection_read_partition_dirty_io(_self, _partition),
+    do: :erlang.nif_error(:not_loaded)
+
   def adbc_statement_new(_self), do: :erlang.nif_error(:not_loaded)
 
   def adbc_statement_get_option(_self, _type, _key), do: :erlang.nif_error(:not_loaded)
@@ -60,17 +127,135 @@ defmodule Adbc.Nif do
 
   def adbc_statement_execute_query(_self), do: :erlang.nif_error(:not_loaded)
 
+  def adbc_statement_execute_query_async(_self, _pid), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_statement_execute_update_async(_self, _pid), do: :erlang.nif_error(:not_loaded)
+
   def adbc_statement_prepare(_self), do: :erlang.nif_error(:not_loaded)
 
+  def adbc_statement_prepare_dirty_io(_self), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_statement_cancel(_self), do: :erlang.nif_error(:not_loaded)
+
   def adbc_statement_set_sql_query(_self, _query), do: :erlang.nif_error(:not_loaded)
 
-  def adbc_statement_bind(_self, _values), do: :erlang.nif_error(:not_loaded)
+  def adbc_statement_bind(_self, _values, _trusted), do: :erlang.nif_error(:not_loaded)
 
   def adbc_statement_bind_stream(_self, _stream), do: :erlang.nif_error(:not_loaded)
 
+  def adbc_statement_execute_many(_self, _rows), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_statement_execute_many_dirty_io(_self, _rows), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_connection_execute_batch(_conn, _statements, _transaction),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_connection_execute_batch_dirty_io(_conn, _statements, _transaction),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_statement_execute_partitions(_self), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_statement_execute_partitions_dirty_io(_self), do: :erlang.nif_error(:not_loaded)
+
   def adbc_arrow_array_stream_get_pointer(_arrow_array_stream), do: :erlang.nif_error(:not_loaded)
 
+  def adbc_arrow_array_stream_statistics(_arrow_array_stream),
+    do: :erlang.nif_error(:not_loaded)
+
   def adbc_arrow_array_stream_next(_arrow_array_stream), do: :erlang.nif_error(:not_loaded)
 
+  def adbc_arrow_array_stream_next_dirty_io(_arrow_array_stream),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_prefetch(_arrow_array_stream, _capacity, _max_bytes),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_set_prefetch(_arrow_array_stream, _capacity),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_coalesce(_arrow_array_stream, _target_time, _rows, _bytes),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_set_option(_arrow_array_stream, _key, _value),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_stats(_arrow_array_stream), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_batch_stats(_arrow_array_stream),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_set_limits(_arrow_array_stream, _stmt, _max_bytes, _max_rows),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_column_materialize(_reference, _offset, _length), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_column_concat(_columns), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_encode(_arrow_array_stream), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_encode_dirty_io(_arrow_array_stream),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_decode(_binaries), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_ipc_file_open(_path), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_move(_arrow_array_stream), do: :erlang.nif_error(:not_loaded)
+
   def adbc_arrow_array_stream_release(_arrow_array_stream), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_set_owner(_arrow_array_stream, _owner, _tag),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_ingest_stream_new(_first_batch, _tag, _capacity),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_ingest_stream_push(_producer, _batch), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_cache(_self, _key, _ttl, _rows_affected),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_result_cache_fetch(_key), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_result_cache_clear, do: :erlang.nif_error(:not_loaded)
+
+  def adbc_result_cache_evict(_prefix), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_share(_self), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_share_dirty_io(_self), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_spill(_self, _dir), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_spill_dirty_io(_self, _dir), do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_to_matrix(_self, _columns, _type, _layout, _nulls),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_arrow_array_stream_to_matrix_dirty_io(_self, _columns, _type, _layout, _nulls),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_shared_result_stream(_handle, _columns, _offset, _length),
+    do: :erlang.nif_error(:not_loaded)
+
+  def adbc_shared_result_select(_handle, _columns, _selection),
+    do: :erlang.nif_error(:not_loaded)
+
+  # Returns the native memory held by the NIF as a map of `:bind_bytes`,
+  # `:retained_batches`, `:retained_batch_bytes`, `:retained_schemas`,
+  # `:live_streams`, `:live_stream_bytes`, `:cached_results`,
+  # `:cached_result_bytes`, `:shared_results`, `:shared_result_bytes`,
+  # `:spilled_results`, `:spilled_bytes`, `:mapped_files`,
+  # `:mapped_file_bytes` and `:pooled_bytes`.
+  def memory_stats, do: :erlang.nif_error(:not_loaded)
+
+  # Returns the stats of the native worker pool as a map, see
+  # `Adbc.worker_pool_stats/0`.
+  def worker_pool_stats, do: :erlang.nif_error(:not_loaded)
+
+  # Returns the counters and latency histograms of the hot paths of the NIF
+  # as a map, see `Adbc.call_stats/0`.
+  def call_stats, do: :erlang.nif_error(:not_loaded)
+
+  def reset_call_stats, do: :erlang.nif_error(:not_loaded)
 end
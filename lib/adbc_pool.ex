@@ -0,0 +1,222 @@
+defmodule Adbc.Pool do
+  @moduledoc """
+  A pool of connections to an `Adbc.Database`.
+
+  An `Adbc.Connection` runs all of its commands within a single process,
+  one at a time. A pool instead opens several connections and checks one
+  out to the calling process, which then runs the query itself. Parallel
+  queries therefore scale with the number of connections in the pool,
+  rather than queueing behind a single mailbox.
+  """
+
+  @type t :: GenServer.server()
+
+  use GenServer
+  import Adbc.Helper, only: [error_to_exception: 1]
+
+  @doc """
+  Starts a connection pool process.
+
+  ## Options
+
+    * `:database` (required) - the database process to connect to
+
+    * `:size` - the number of connections in the pool. Defaults to
+      `System.schedulers_online/0`
+
+    * `:process_options` - the options to be given to the underlying
+      process. See `GenServer.start_link/3` for all options
+
+  All other options are given as connection options to each of the
+  underlying connections.
+
+  ## Examples
+
+      Adbc.Pool.start_link(
+        database: MyApp.DB,
+        size: 10,
+        process_options: [name: MyApp.Pool]
+      )
+
+  """
+  def start_link(opts) do
+    {db, opts} = Keyword.pop(opts, :database, nil)
+
+    unless db do
+      raise ArgumentError, ":database option must be specified"
+    end
+
+    {size, opts} = Keyword.pop(opts, :size, System.schedulers_online())
+
+    unless is_integer(size) and size > 0 do
+      raise ArgumentError, ":size must be a positive integer, got: #{inspect(size)}"
+    end
+
+    {process_options, opts} = Keyword.pop(opts, :process_options, [])
+    GenServer.start_link(__MODULE__, {db, size, opts}, process_options)
+  end
+
+  @doc """
+  Checks out a connection and runs the given `query` with `params` and
+  `statement_options` from the calling process.
+
+  See `Adbc.Connection.query/4` for the supported options. Callers
+  waiting for a connection are given one by their `:priority`, and in
+  the order they asked within a priority. A checked out connection only
+  runs the query of its caller, so short queries never queue behind a
+  long one on the same connection, only for a free connection.
+  """
+  @spec query(t(), binary | reference, [term], Keyword.t()) ::
+          {:ok, Adbc.Result.t()} | {:error, Exception.t()}
+  def query(pool, query, params \\ [], statement_options \\ [])
+      when (is_binary(query) or is_reference(query)) and is_list(params) and
+             is_list(statement_options) do
+    {priority, statement_options} = Adbc.Connection.pop_priority!(statement_options)
+
+    checkout(pool, priority, fn conn, scheduler ->
+      Adbc.Connection.__query__(conn, scheduler, query, params, statement_options)
+    end)
+  end
+
+  @doc """
+  Same as `query/4` but raises an exception on error.
+  """
+  @spec query!(t(), binary | reference, [term], Keyword.t()) :: Adbc.Result.t()
+  def query!(pool, query, params \\ [], statement_options \\ [])
+      when (is_binary(query) or is_reference(query)) and is_list(params) and
+             is_list(statement_options) do
+    case query(pool, query, params, statement_options) do
+      {:ok, result} -> result
+      {:error, reason} -> raise reason
+    end
+  end
+
+  defp checkout(pool, priority, fun) do
+    {conn, scheduler, checkout_ref} = GenServer.call(pool, {:checkout, priority}, :infinity)
+
+    try do
+      fun.(conn, scheduler)
+    after
+      GenServer.cast(pool, {:checkin, checkout_ref})
+    end
+  end
+
+  ## Callbacks
+
+  @impl true
+  def init({db, size, opts}) do
+    state = %{
+      db: Adbc.Database.connect(db),
+      opts: opts,
+      scheduler: nil,
+      available: [],
+      checked_out: %{},
+      waiting: %{high: :queue.new(), normal: :queue.new(), low: :queue.new()}
+    }
+
+    # Connections are opened in parallel, so that warming up the pool takes
+    # about as long as opening a single connection.
+    results =
+      1..size
+      |> Task.async_stream(fn _ -> open_connection(state) end,
+        max_concurrency: size,
+        timeout: :infinity
+      )
+      |> Enum.map(fn {:ok, result} -> result end)
+
+    case Enum.find(results, &match?({:error, _}, &1)) do
+      nil ->
+        [{:ok, _conn, scheduler} | _] = results
+        available = for {:ok, conn, _scheduler} <- results, do: conn
+        {:ok, %{state | available: available, scheduler: scheduler}}
+
+      {:error, reason} ->
+        # the connections which did open are closed rather than left to
+        # be garbage collected
+        for {:ok, conn, _scheduler} <- results, do: Adbc.Nif.adbc_connection_release(conn)
+        {:stop, error_to_exception(reason)}
+    end
+  end
+
+  @impl true
+  def handle_call({:checkout, priority}, {pid, _} = from, state) do
+    case state.available do
+      [conn | available] ->
+        state = %{state | available: available}
+        {:noreply, check_out(conn, from, Process.monitor(pid), state)}
+
+      [] ->
+        # Waiters are monitored, so that those which exit leave the queue
+        # and the monitor then covers the checkout
+        waiter = {from, Process.monitor(pid)}
+        {:noreply, update_in(state.waiting[priority], &:queue.in(waiter, &1))}
+    end
+  end
+
+  @impl true
+  def handle_cast({:checkin, checkout_ref}, state) do
+    case Map.pop(state.checked_out, checkout_ref) do
+      {nil, _checked_out} ->
+        {:noreply, state}
+
+      {conn, checked_out} ->
+        Process.demonitor(checkout_ref, [:flush])
+        {:noreply, check_in(conn, %{state | checked_out: checked_out})}
+    end
+  end
+
+  @impl true
+  def handle_info({:DOWN, checkout_ref, _, _, _}, state) do
+    case Map.pop(state.checked_out, checkout_ref) do
+      {nil, _checked_out} ->
+        waiting =
+          Map.new(state.waiting, fn {priority, queue} ->
+            {priority, :queue.filter(fn {_from, ref} -> ref != checkout_ref end, queue)}
+          end)
+
+        {:noreply, %{state | waiting: waiting}}
+
+      {_conn, checked_out} ->
+        # The caller may have exited in the middle of a query, so the
+        # connection is discarded and replaced by a new one.
+        state = %{state | checked_out: checked_out}
+
+        case open_connection(state) do
+          {:ok, conn, _scheduler} -> {:noreply, check_in(conn, state)}
+          {:error, reason} -> {:stop, error_to_exception(reason), state}
+        end
+    end
+  end
+
+  defp open_connection(%{db: db, opts: opts}) do
+    with {:ok, conn} <- Adbc.Nif.adbc_connection_new(),
+         :ok <- Adbc.Connection.init_options(conn, opts),
+         {:ok, _driver, scheduler} <- Adbc.Database.init_connection(db, conn) do
+      {:ok, conn, scheduler}
+    end
+  end
+
+  defp check_out(conn, from, checkout_ref, state) do
+    GenServer.reply(from, {conn, state.scheduler, checkout_ref})
+    put_in(state.checked_out[checkout_ref], conn)
+  end
+
+  defp check_in(conn, state) do
+    case next_waiting(state.waiting, [:high, :normal, :low]) do
+      {{from, checkout_ref}, waiting} ->
+        check_out(conn, from, checkout_ref, %{state | waiting: waiting})
+
+      nil ->
+        %{state | available: [conn | state.available]}
+    end
+  end
+
+  defp next_waiting(_waiting, []), do: nil
+
+  defp next_waiting(waiting, [priority | priorities]) do
+    case :queue.out(Map.fetch!(waiting, priority)) do
+      {{:value, from}, queue} -> {from, %{waiting | priority => queue}}
+      {:empty, _queue} -> next_waiting(waiting, priorities)
+    end
+  end
+end
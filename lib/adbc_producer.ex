@@ -0,0 +1,270 @@
+if Code.ensure_loaded?(GenStage) do
+  defmodule Adbc.Producer do
+    @moduledoc """
+    A `GenStage` producer of the results of a query on an `Adbc.Connection`.
+
+    The query runs once the first demand arrives, and each record batch is
+    then only fetched from the driver as consumers ask for more events, so
+    a pipeline reads its results at the pace of its slowest stage, in
+    constant memory. The batches read ahead natively follow the pending
+    demand, up to `:max_prefetch` batches.
+
+    As with `Adbc.Connection.stream/4`, the connection stays locked by the
+    producer until the results are exhausted, or until all of its
+    consumers cancel their subscriptions, which releases them.
+
+    Requires the optional `:gen_stage` dependency.
+
+    ## Examples
+
+        {:ok, producer} =
+          Adbc.Producer.start_link(
+            connection: conn,
+            query: "SELECT * FROM events WHERE day = ?",
+            params: [~D[2024-01-01]],
+            events: :rows
+          )
+
+        GenStage.stream([{producer, max_demand: 1000}])
+        |> Stream.each(&process_row/1)
+        |> Stream.run()
+
+    With Broadway, give the producer with a transformer wrapping its
+    events in `Broadway.Message` structs, and `on_end: :hold`, as Broadway
+    restarts producers that stop:
+
+        producer: [
+          module:
+            {Adbc.Producer,
+             connection: conn, query: "SELECT * FROM events", events: :rows, on_end: :hold},
+          transformer: {MyPipeline, :transform, []}
+        ]
+
+    """
+
+    use GenStage
+
+    @doc """
+    Starts a producer of the results of `:query`.
+
+    ## Options
+
+      * `:connection` (required) - the connection to run the query on
+
+      * `:query` (required) - the query to run, or a prepared statement
+
+      * `:params` - the parameters of the query, defaults to `[]`
+
+      * `:events` - `:batches` to emit an `Adbc.Result` per record batch,
+        or `:rows` to emit a row per event, in the format of `:output`,
+        which then defaults to `:rows_maps`. Defaults to `:batches`
+
+      * `:max_prefetch` - the maximum number of batches read ahead of the
+        demand, defaults to `8`. Batches are not read ahead when they are
+        coalesced, see `:coalesce_rows` in `Adbc.Connection.query/4`
+
+      * `:on_end` - `:stop` to stop with reason `:normal` once the results
+        are exhausted and emitted, or `:hold` to keep running without
+        emitting events. Defaults to `:stop`
+
+      * `:process_options` - the options to be given to the underlying
+        process. See `GenStage.start_link/3` for all options
+
+    All other options are given as statement options to the query, see
+    `Adbc.Connection.query/4`, except `:prefetch`, which is set from the
+    demand.
+    """
+    def start_link(opts) do
+      {process_options, opts} = Keyword.pop(opts, :process_options, [])
+      GenStage.start_link(__MODULE__, opts, process_options)
+    end
+
+    ## Callbacks
+
+    @impl true
+    def init(opts) do
+      {conn, opts} = Keyword.pop(opts, :connection)
+      {query, opts} = Keyword.pop(opts, :query)
+
+      unless conn && (is_binary(query) or is_reference(query)) do
+        raise ArgumentError, ":connection and :query options must be specified"
+      end
+
+      {params, opts} = Keyword.pop(opts, :params, [])
+      {events, opts} = Keyword.pop(opts, :events, :batches)
+      {max_prefetch, opts} = Keyword.pop(opts, :max_prefetch, 8)
+      {on_end, opts} = Keyword.pop(opts, :on_end, :stop)
+
+      unless is_integer(max_prefetch) and max_prefetch > 0 do
+        raise ArgumentError,
+              ":max_prefetch must be a positive integer, got: #{inspect(max_prefetch)}"
+      end
+
+      unless on_end in [:stop, :hold] do
+        raise ArgumentError, ":on_end must be :stop or :hold, got: #{inspect(on_end)}"
+      end
+
+      opts =
+        case events do
+          :batches ->
+            opts
+
+          :rows ->
+            case Keyword.get(opts, :output, :rows_maps) do
+              output when output in [:rows_maps, :rows_tuples] ->
+                Keyword.put(opts, :output, output)
+
+              output ->
+                raise ArgumentError,
+                      ":output must be :rows_maps or :rows_tuples with events: :rows, " <>
+                        "got: #{inspect(output)}"
+            end
+
+          _ ->
+            raise ArgumentError, ":events must be :batches or :rows, got: #{inspect(events)}"
+        end
+
+      state = %{
+        conn: conn,
+        query: query,
+        params: params,
+        opts: Keyword.put(opts, :prefetch, 1),
+        events: events,
+        max_prefetch: max_prefetch,
+        on_end: on_end,
+        # :idle until the first demand, then the open stream, then :done
+        stream: :idle,
+        prefetch: 1,
+        demand: 0,
+        # the rows of the last batch not emitted yet, with events: :rows
+        rows: [],
+        batch_rows: nil,
+        consumers: 0,
+        dispatching: false
+      }
+
+      {:producer, state}
+    end
+
+    @impl true
+    def handle_subscribe(:consumer, _opts, _from, state),
+      do: {:automatic, %{state | consumers: state.consumers + 1}}
+
+    @impl true
+    def handle_cancel(_reason, _from, state) do
+      state = %{state | consumers: state.consumers - 1}
+
+      if state.consumers == 0 do
+        {:stop, :normal, close(state)}
+      else
+        {:noreply, [], state}
+      end
+    end
+
+    @impl true
+    def handle_demand(demand, state), do: dispatch(%{state | demand: state.demand + demand})
+
+    # Events are emitted a batch at a time, so that consumers start on the
+    # first batch while the next ones are read, and new demand and
+    # cancellations are handled in between.
+    @impl true
+    def handle_info(:dispatch, state), do: dispatch(%{state | dispatching: false})
+
+    def handle_info(:end_of_results, state), do: {:stop, :normal, state}
+
+    def handle_info(_message, state), do: {:noreply, [], state}
+
+    @impl true
+    def terminate(_reason, state), do: close(state)
+
+    defp dispatch(%{demand: 0} = state), do: {:noreply, [], state}
+    defp dispatch(%{dispatching: true} = state), do: {:noreply, [], state}
+    defp dispatch(%{stream: :done, rows: []} = state), do: {:noreply, [], state}
+
+    defp dispatch(%{stream: :idle} = state) do
+      stream = Adbc.Connection.__open_stream__(state.conn, state.query, state.params, state.opts)
+      dispatch(%{state | stream: stream})
+    end
+
+    defp dispatch(state) do
+      {events, state} = next_events(state)
+      state = %{state | demand: state.demand - length(events)}
+
+      state =
+        if state.demand > 0 and (state.stream != :done or state.rows != []) do
+          send(self(), :dispatch)
+          %{state | dispatching: true}
+        else
+          adjust_prefetch(state)
+        end
+
+      {:noreply, events, state}
+    end
+
+    defp next_events(%{rows: [_ | _] = rows, demand: demand} = state) do
+      {events, rows} = Enum.split(rows, demand)
+      {events, %{state | rows: rows}}
+    end
+
+    defp next_events(%{stream: :done} = state), do: {[], state}
+
+    defp next_events(state) do
+      state = adjust_prefetch(state)
+
+      case Adbc.Connection.__next_result__(state.stream) do
+        {[%Adbc.Result{} = result], stream} ->
+          state = %{state | stream: stream}
+
+          case state.events do
+            :batches ->
+              {[result], state}
+
+            :rows ->
+              rows = result.data
+              next_events(%{state | rows: rows, batch_rows: max(length(rows), 1)})
+          end
+
+        {:halt, _stream} ->
+          state = close(state)
+          if state.on_end == :stop, do: GenStage.async_info(self(), :end_of_results)
+          {[], state}
+      end
+    end
+
+    # Batches are read ahead for the pending demand, counted in batches of
+    # the size of the last one with events: :rows
+    defp adjust_prefetch(%{stream: stream} = state) when stream in [:idle, :done], do: state
+    defp adjust_prefetch(%{prefetch: nil} = state), do: state
+
+    defp adjust_prefetch(state) do
+      pending =
+        case state.events do
+          :batches -> state.demand
+          :rows when state.batch_rows == nil -> 1
+          :rows -> div(state.demand - length(state.rows) + state.batch_rows - 1, state.batch_rows)
+        end
+
+      capacity = pending |> max(1) |> min(state.max_prefetch)
+
+      cond do
+        capacity == state.prefetch ->
+          state
+
+        Adbc.Connection.__set_prefetch__(state.stream, capacity) == :ok ->
+          %{state | prefetch: capacity}
+
+        true ->
+          # the stream is wrapped, such as when coalesced, and not adjusted
+          %{state | prefetch: nil}
+      end
+    end
+
+    defp close(%{stream: stream} = state) when stream in [:idle, :done],
+      do: %{state | stream: :done}
+
+    defp close(state) do
+      Adbc.Connection.__close_stream__(state.stream)
+      %{state | stream: :done}
+    end
+  end
+end
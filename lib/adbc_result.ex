@@ -4,7 +4,9 @@ defmodule Adbc.Result do
 
   It has two fields:
 
-    * `:data` - a list of `Adbc.Column`
+    * `:data` - a list of `Adbc.Column`, a list of rows when the
+      query was run with the `:output` option of `Adbc.Connection.query/4`,
+      or an `Adbc.SharedResult` with its `:shared` option
 
     * `:num_rows` - the number of rows returned, if returned
       by the database
@@ -13,7 +15,7 @@ defmodule Adbc.Result do
 
   @type t :: %Adbc.Result{
           num_rows: non_neg_integer() | nil,
-          data: [%Adbc.Column{}]
+          data: [%Adbc.Column{}] | [tuple()] | [map()] | Adbc.SharedResult.t()
         }
   @doc """
   Returns a map of columns as a result.
@@ -0,0 +1,175 @@
+defmodule Adbc.SharedResult do
+  @moduledoc """
+  A query result kept natively as Arrow record batches, returned by the
+  `:shared` and `:spill` options of `Adbc.Connection.query/4`.
+
+  It is a small struct around a reference-counted native resource, so it
+  can be sent to other processes without copying the result, and any of
+  them can read it with `to_result/2`, as a whole or some of its columns
+  and rows. Its memory is freed once no process references it anymore.
+
+  Its rows and columns can also be narrowed down natively with `select/2`,
+  `slice/3`, `take/2` and `filter/2`, which return a new shared result,
+  so that rows dropped on the way are never converted to Elixir terms.
+
+  It has three fields:
+
+    * `:ref` - the native resource
+    * `:num_rows` - the number of rows of the result
+    * `:columns` - the names of the columns of the result
+  """
+  defstruct [:ref, :num_rows, :columns]
+
+  @type t :: %Adbc.SharedResult{
+          ref: reference(),
+          num_rows: non_neg_integer(),
+          columns: [String.t()]
+        }
+
+  @doc """
+  Converts `shared` to an `Adbc.Result`.
+
+  ## Options
+
+    * `:columns` - the names of the columns to read, in that order,
+      defaults to all of them
+
+    * `:offset` - the first row to read, defaults to `0`
+
+    * `:length` - the number of rows to read, defaults to all the rows
+      after `:offset`
+
+  It also accepts the options of `Adbc.Connection.query/4` that shape
+  the result, such as `:output` and `:lazy_columns`. Only the record
+  batches with rows in the range are read.
+  """
+  @spec to_result(t(), Keyword.t()) :: {:ok, Adbc.Result.t()} | {:error, Exception.t()}
+  def to_result(%Adbc.SharedResult{} = shared, opts \\ []) when is_list(opts) do
+    {columns, opts} = Keyword.pop(opts, :columns)
+    {offset, opts} = Keyword.pop(opts, :offset, 0)
+    {length, opts} = Keyword.pop(opts, :length, max(shared.num_rows - offset, 0))
+
+    unless is_integer(offset) and offset >= 0 and is_integer(length) and length >= 0 do
+      raise ArgumentError, ":offset and :length must be non-negative integers"
+    end
+
+    case column_indices(shared, columns) do
+      [] ->
+        {:ok, %Adbc.Result{data: [], num_rows: nil}}
+
+      indices ->
+        case Adbc.Nif.adbc_shared_result_stream(shared.ref, indices, offset, length) do
+          {:ok, stream_ref, skip} ->
+            Adbc.Connection.__read_shared__(stream_ref, skip, length, opts)
+
+          {:error, reason} ->
+            {:error, Adbc.Helper.error_to_exception(reason)}
+        end
+    end
+  end
+
+  @doc """
+  Same as `to_result/2` but raises an exception on error.
+  """
+  @spec to_result!(t(), Keyword.t()) :: Adbc.Result.t()
+  def to_result!(%Adbc.SharedResult{} = shared, opts \\ []) do
+    case to_result(shared, opts) do
+      {:ok, result} -> result
+      {:error, reason} -> raise reason
+    end
+  end
+
+  @doc """
+  Returns a shared result with only the given `columns` of `shared`, in
+  that order.
+
+  The record batches of `shared` are shared rather than copied.
+  """
+  @spec select(t(), [String.t()]) :: t()
+  def select(%Adbc.SharedResult{} = shared, columns) when is_list(columns) do
+    select!(shared, column_indices(shared, columns), nil)
+  end
+
+  @doc """
+  Returns a shared result with the `length` rows of `shared` starting at
+  `offset`.
+
+  Record batches within the range are shared, only the rows of those
+  crossing its bounds are copied.
+  """
+  @spec slice(t(), non_neg_integer(), non_neg_integer()) :: t()
+  def slice(%Adbc.SharedResult{} = shared, offset, length)
+      when is_integer(offset) and offset >= 0 and is_integer(length) and length >= 0 do
+    select!(shared, nil, {:slice, offset, length})
+  end
+
+  @doc """
+  Returns a shared result with the rows of `shared` at the given
+  zero-based `indices`, in that order.
+
+  Indices may repeat. Raises if any of them is out of range.
+  """
+  @spec take(t(), [non_neg_integer()]) :: t()
+  def take(%Adbc.SharedResult{} = shared, indices) when is_list(indices) do
+    select!(shared, nil, {:take, indices})
+  end
+
+  @doc """
+  Returns a shared result with the rows of `shared` matching `filter`,
+  which is either:
+
+    * a list of booleans, one per row of `shared`, keeping the rows
+      whose boolean is `true`
+
+    * `{column, op, value}`, keeping the rows whose value of `column`
+      compares to `value` as `op`, one of `:==`, `:!=`, `:<`, `:<=`, `:>`
+      and `:>=`. Numeric columns compare to numbers, string and binary
+      columns to binaries, byte by byte, and boolean columns to booleans.
+      Null values never match
+
+  Record batches whose rows all match are shared, the matching rows of
+  the others are copied. Only columns of primitive, boolean, string and
+  binary types can be filtered, other columns can first be dropped with
+  `select/2`.
+
+  ## Examples
+
+      shared
+      |> Adbc.SharedResult.filter({"amount", :>, 100})
+      |> Adbc.SharedResult.to_result!()
+
+  """
+  @spec filter(t(), [boolean()] | {String.t(), atom(), term()}) :: t()
+  def filter(%Adbc.SharedResult{} = shared, mask) when is_list(mask) do
+    select!(shared, nil, {:mask, mask})
+  end
+
+  def filter(%Adbc.SharedResult{} = shared, {column, op, value})
+      when op in [:==, :!=, :<, :<=, :>, :>=] do
+    [index] = column_indices(shared, [column])
+    select!(shared, nil, {:compare, {index, op, value}})
+  end
+
+  defp select!(shared, indices, selection) do
+    case Adbc.Nif.adbc_shared_result_select(shared.ref, indices, selection) do
+      {:ok, ref, num_rows, columns} ->
+        %Adbc.SharedResult{ref: ref, num_rows: num_rows, columns: columns}
+
+      {:error, reason} ->
+        raise Adbc.Helper.error_to_exception(reason)
+    end
+  end
+
+  defp column_indices(_shared, nil), do: nil
+
+  defp column_indices(%{columns: names}, columns) when is_list(columns) do
+    indices = names |> Enum.with_index() |> Map.new()
+
+    Enum.map(columns, fn column ->
+      case indices do
+        %{^column => index} -> index
+        %{} -> raise ArgumentError, "unknown column #{inspect(column)}"
+      end
+    end)
+  end
+end
@@ -0,0 +1,136 @@
+defmodule Adbc.Telemetry do
+  @moduledoc """
+  Telemetry events emitted by Adbc.
+
+  Queries run with `Adbc.Connection.query/4` and `Adbc.Pool.query/4`
+  emit the following events, with times in `:native` units. The times
+  spent executing the query and fetching its batches are measured by the
+  NIF, and only while a handler is attached to an `[:adbc | _]` event.
+
+    * `[:adbc, :query, :start]` - before the query is sent to the
+      connection, with the `:system_time` and `:monotonic_time`
+      measurements
+
+    * `[:adbc, :query, :stop]` - once the query completed, with the
+      following measurements:
+
+      * `:duration` - the time from the start event to the stop event
+      * `:queue_time` - the time spent before the query was executed,
+        such as waiting for the connection
+      * `:execute_time` - the time spent executing the query in the
+        driver, until its first batch can be fetched
+      * `:fetch_time` - the time spent fetching batches from the driver
+      * `:decode_time` - the time spent converting batches to terms
+      * `:rows` and `:bytes` - the rows and the bytes of the Arrow
+        buffers of the batches fetched
+
+    * `[:adbc, :fetch, :batch]` - after each batch is fetched and
+      converted, with the `:fetch_time`, `:decode_time`, `:rows` and
+      `:bytes` of the batch. Its metadata also holds the `:null_counts`,
+      a list with the nulls of each column of the batch. With
+      `:parallel_batches`, batches are fetched ahead of their conversion,
+      so these are the stats of the last batch fetched
+
+  The metadata of all events holds the `:connection` and the `:query`.
+  The stop event also holds the `:result`, either `:ok` or `:error`, and
+  the `:error` on failure.
+  """
+
+  @doc false
+  # Runs `fun` between the start and stop events of a query, giving it the
+  # handle to pass to `read/3` and `batch/3`, or nil when no handler is
+  # attached.
+  def span(metadata, fun) do
+    if :telemetry.list_handlers([:adbc]) == [] do
+      fun.(nil)
+    else
+      start = System.monotonic_time()
+      measurements = %{system_time: System.system_time(), monotonic_time: start}
+      :telemetry.execute([:adbc, :query, :start], measurements, metadata)
+
+      telemetry = %{metadata: metadata, key: {__MODULE__, make_ref()}}
+      result = fun.(telemetry)
+      stop(telemetry, start, result)
+      result
+    end
+  end
+
+  defp stop(%{metadata: metadata, key: key}, start, result) do
+    stop = System.monotonic_time()
+
+    stats =
+      Process.delete(key) ||
+        %{read_start: stop, execute_time: 0, fetch_time: 0, rows: 0, bytes: 0}
+
+    measurements = %{
+      duration: stop - start,
+      queue_time: max(stats.read_start - start - stats.execute_time, 0),
+      execute_time: stats.execute_time,
+      fetch_time: stats.fetch_time,
+      decode_time: max(stop - stats.read_start - stats.fetch_time, 0),
+      rows: stats.rows,
+      bytes: stats.bytes
+    }
+
+    metadata =
+      case result do
+        {:error, error} -> Map.merge(metadata, %{result: :error, error: error})
+        _ -> Map.put(metadata, :result, :ok)
+      end
+
+    :telemetry.execute([:adbc, :query, :stop], measurements, metadata)
+  end
+
+  @doc false
+  # Has the stream `reference` collect its stats while `fun` reads it.
+  def read(nil, _reference, fun), do: fun.()
+
+  def read(%{key: key}, reference, fun) do
+    read_start = System.monotonic_time()
+    :ok = Adbc.Nif.adbc_arrow_array_stream_set_option(reference, :stats, true)
+
+    try do
+      fun.()
+    after
+      {execute_time, fetch_time, rows, bytes} = Adbc.Nif.adbc_arrow_array_stream_stats(reference)
+
+      Process.put(key, %{
+        read_start: read_start,
+        execute_time: native(execute_time),
+        fetch_time: native(fetch_time),
+        rows: rows,
+        bytes: bytes
+      })
+    end
+  end
+
+  @doc false
+  # Fetches and converts the next batch of the stream `reference` with
+  # `fun`, emitting its batch event.
+  def batch(nil, _reference, fun), do: fun.()
+
+  def batch(%{metadata: metadata}, reference, fun) do
+    started = System.monotonic_time()
+    result = fun.()
+    elapsed = System.monotonic_time() - started
+
+    with {:ok, _data, _done} <- result do
+      stats = Adbc.Nif.adbc_arrow_array_stream_batch_stats(reference)
+      fetch_time = native(stats.fetch_time)
+
+      measurements = %{
+        fetch_time: fetch_time,
+        decode_time: max(elapsed - fetch_time, 0),
+        rows: stats.rows,
+        bytes: stats.bytes
+      }
+
+      metadata = Map.put(metadata, :null_counts, stats.null_counts)
+      :telemetry.execute([:adbc, :fetch, :batch], measurements, metadata)
+    end
+
+    result
+  end
+
+  defp native(nanoseconds), do: System.convert_time_unit(nanoseconds, :nanosecond, :native)
+end
@@ -41,6 +41,7 @@ defmodule Adbc.MixProject do
 
   def application do
     [
+      mod: {Adbc.Application, []},
       extra_applications: [:logger, inets: :optional, ssl: :optional]
     ]
   end
@@ -53,7 +54,9 @@ defmodule Adbc.MixProject do
 
       # runtime
       {:dll_loader_helper_beam, "~> 1.0"},
+      {:telemetry, "~> 0.4 or ~> 1.0"},
       {:castore, "~> 1.0", optional: true},
+      {:gen_stage, "~> 1.0", optional: true},
 
       # docs
       {:ex_doc, "~> 0.29", only: :docs, runtime: false}
@@ -118,6 +118,14 @@ defmodule Adbc.Connection.Test do
   end
 
   describe "get_objects" do
+    test "shapes the result with the options of query", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      Connection.query!(conn, "CREATE TABLE listed (id INTEGER)")
+
+      assert {:ok, %Adbc.Result{data: [%{"catalog_name" => "main"} | _]}} =
+               Connection.get_objects(conn, 1, output: :rows_maps)
+    end
+
     test "get all objects from a connection", %{db: db} do
       conn = start_supervised!({Connection, database: db})
 
@@ -457,6 +465,71 @@ defmodule Adbc.Connection.Test do
     end
   end
 
+  describe "metadata cache" do
+    test "caches metadata until evicted", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      Connection.query!(conn, "CREATE TABLE cached_a (id INTEGER)")
+
+      assert {:ok, before} = Connection.get_objects(conn, 3, cache: 60_000)
+      assert {:ok, ^before} = Connection.get_objects(conn, 3, cache: 60_000)
+      assert {:ok, %Adbc.Result{}} = Connection.get_table_types(conn, cache: 60_000)
+      assert {:ok, %Adbc.Result{}} = Connection.get_info(conn, [0], cache: 60_000)
+
+      # prepared statements are not checked for DDL
+      {:ok, create} = Connection.prepare(conn, "CREATE TABLE cached_b (id INTEGER)")
+      Connection.query!(conn, create)
+      assert {:ok, ^before} = Connection.get_objects(conn, 3, cache: 60_000)
+
+      assert :ok = Connection.clear_metadata_cache(conn)
+      assert {:ok, now} = Connection.get_objects(conn, 3, cache: 60_000)
+      assert now != before
+
+      Connection.query!(conn, "DROP TABLE cached_b")
+      assert {:ok, ^before} = Connection.get_objects(conn, 3, cache: 60_000)
+    end
+
+    test "validates the ttl", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert_raise ArgumentError, ~r/:cache must be nil or a positive integer/, fn ->
+        Connection.get_table_types(conn, cache: 0)
+      end
+    end
+  end
+
+  describe "telemetry" do
+    test "emits events with the timings of a query", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      events = [[:adbc, :query, :start], [:adbc, :query, :stop], [:adbc, :fetch, :batch]]
+      test = self()
+      handler_id = make_ref()
+
+      :telemetry.attach_many(handler_id, events, &send(test, {&1, &2, &3, &4}), nil)
+      on_exit(fn -> :telemetry.detach(handler_id) end)
+
+      assert {:ok, _} = Connection.query(conn, "SELECT 1 AS a UNION ALL SELECT 2")
+
+      assert_received {[:adbc, :query, :start], %{system_time: _}, %{query: _}, nil}
+      assert_received {[:adbc, :fetch, :batch], %{rows: 2, fetch_time: _}, batch_metadata, nil}
+      assert batch_metadata.null_counts == [0]
+      assert_received {[:adbc, :query, :stop], measurements, %{result: :ok}, nil}
+      assert %{rows: 2, execute_time: _, decode_time: _, queue_time: _} = measurements
+
+      assert {:error, _} = Connection.query(conn, "SELECT * FROM who_knows")
+      assert_received {[:adbc, :query, :stop], _, %{result: :error, error: %Adbc.Error{}}, nil}
+    end
+  end
+
+  describe "partitions" do
+    test "errors when the driver does not partition results", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert {:error, %Adbc.Error{}} = Connection.execute_partitions(conn, "SELECT 1")
+      assert {:error, %Adbc.Error{}} = Connection.read_partition(conn, "who_knows")
+      assert {:ok, %Adbc.Result{}} = Connection.query(conn, "SELECT 1")
+    end
+  end
+
   describe "query" do
     test "select", %{db: db} do
       conn = start_supervised!({Connection, database: db})
@@ -514,12 +587,74 @@ defmodule Adbc.Connection.Test do
                Connection.query(conn, "SELECT 123 + ? as num", [456])
     end
 
+    test "select with trusted parameters", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      params = [
+        Adbc.Column.i64([1, 2, nil], nullable: true),
+        Adbc.Column.string(["a", nil, "c"], nullable: true)
+      ]
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{data: [1, 2, nil]}, %Adbc.Column{}]}} =
+               Connection.query(conn, "SELECT ? AS a, ? AS b", params, trusted_params: true)
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{data: [1, 3]}, %Adbc.Column{}]}} =
+               Connection.query(conn, "SELECT ? AS a, ? AS b", [[1, "a"], [3, "c"]],
+                 trusted_params: true
+               )
+    end
+
     test "fails on invalid query", %{db: db} do
       conn = start_supervised!({Connection, database: db})
       assert {:error, %Adbc.Error{} = error} = Connection.query(conn, "NOT VALID SQL")
       assert Exception.message(error) =~ "[SQLite] Failed to prepare query"
     end
 
+    test "select on normal schedulers" do
+      db = start_supervised!({Adbc.Database, driver: :sqlite, scheduler: :normal}, id: :normal_db)
+      conn = start_supervised!({Connection, database: db})
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{name: "num", data: [123]}]}} =
+               Connection.query(conn, "SELECT 123 as num")
+
+      assert {:ok, %Adbc.Result{}} = Connection.get_table_types(conn)
+    end
+
+    test "select large batches on normal schedulers" do
+      db = start_supervised!({Adbc.Database, driver: :sqlite, scheduler: :normal}, id: :normal_db)
+      conn = start_supervised!({Connection, database: db})
+
+      query = """
+      WITH RECURSIVE nums(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM nums WHERE n < 20000)
+      SELECT n, 'row ' || n AS label FROM nums
+      """
+
+      assert %Adbc.Result{
+               data: [
+                 %Adbc.Column{name: "n", type: :i64, data: nums},
+                 %Adbc.Column{name: "label", type: :string, data: labels}
+               ]
+             } = Connection.query!(conn, query, [], "adbc.sqlite.query.batch_rows": 20000)
+
+      assert nums == Enum.to_list(1..20000)
+      assert labels == Enum.map(1..20000, &"row #{&1}")
+    end
+
+    test "concurrent queries across connections", %{db: db} do
+      conns = for i <- 1..8, do: start_supervised!({Connection, database: db}, id: {:conn, i})
+
+      results =
+        conns
+        |> Enum.with_index()
+        |> Enum.map(fn {conn, i} ->
+          Task.async(fn -> Connection.query(conn, "SELECT #{i} as num") end)
+        end)
+        |> Task.await_many()
+
+      for {result, i} <- Enum.with_index(results) do
+        assert {:ok, %Adbc.Result{data: [%Adbc.Column{name: "num", data: [^i]}]}} = result
+      end
+    end
+
     test "select with prepared query", %{db: db} do
       conn = start_supervised!({Connection, database: db})
       assert {:ok, ref} = Connection.prepare(conn, "SELECT 123 + ? as num")
@@ -539,6 +674,26 @@ defmodule Adbc.Connection.Test do
                Connection.query(conn, ref, [456])
     end
 
+    test "select with prepared query bound with the same and other types", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      assert {:ok, ref} = Connection.prepare(conn, "SELECT ? AS a, ? AS b")
+
+      for {a, b} <- [{[1, 2], ["x", "y"]}, {[3], ["z"]}, {[4, 5], ["v", "w"]}] do
+        params = [Adbc.Column.i64(a, name: "a"), Adbc.Column.string(b, name: "b")]
+
+        assert {:ok, %Adbc.Result{data: [%Adbc.Column{data: ^a}, %Adbc.Column{data: ^b}]}} =
+                 Connection.query(conn, ref, params)
+      end
+
+      params = [Adbc.Column.f64([1.5], name: "a"), Adbc.Column.string(["x"], name: "b")]
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{data: [1.5]}, %Adbc.Column{data: ["x"]}]}} =
+               Connection.query(conn, ref, params)
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{data: [7]}, %Adbc.Column{data: ["q"]}]}} =
+               Connection.query(conn, ref, [7, "q"])
+    end
+
     test "select with multiple prepared queries", %{db: db} do
       conn = start_supervised!({Connection, database: db})
       assert {:ok, ref_a} = Connection.prepare(conn, "SELECT 123 + ? as num")
@@ -574,154 +729,1692 @@ defmodule Adbc.Connection.Test do
     end
   end
 
-  describe "query!" do
-    test "select", %{db: db} do
+  describe "query with prefetch" do
+    test "reads batches ahead", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      query = """
+      WITH RECURSIVE nums(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM nums WHERE n < 5000)
+      SELECT n FROM nums
+      """
+
+      assert %Adbc.Result{data: [%Adbc.Column{name: "n", data: nums}]} =
+               Connection.query!(conn, query, [],
+                 prefetch: 2,
+                 "adbc.sqlite.query.batch_rows": 100
+               )
+
+      assert nums == Enum.to_list(1..5000)
+    end
+
+    test "reads batches ahead up to a size", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      query = """
+      WITH RECURSIVE nums(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM nums WHERE n < 5000)
+      SELECT n FROM nums
+      """
+
+      for opts <- [[prefetch_bytes: 1], [prefetch: 4, prefetch_bytes: 4096]] do
+        assert %Adbc.Result{data: [%Adbc.Column{name: "n", data: nums}]} =
+                 Connection.query!(conn, query, [], ["adbc.sqlite.query.batch_rows": 100] ++ opts)
+
+        assert nums == Enum.to_list(1..5000)
+      end
+    end
+  end
+
+  describe "query with target batch time" do
+    test "coalesces small batches", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      query = """
+      WITH RECURSIVE nums(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM nums WHERE n < 5000)
+      SELECT n, 'row ' || n AS s FROM nums
+      """
+
+      opts = [target_batch_time: 1000, "adbc.sqlite.query.batch_rows": 10]
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: nums}, %Adbc.Column{data: strings}]} =
+               Connection.query!(conn, query, [], opts)
+
+      assert nums == Enum.to_list(1..5000)
+      assert strings == Enum.map(1..5000, &"row #{&1}")
+
+      # the first batch is read as is, to measure the time per row
+      batches = Enum.to_list(Connection.stream(conn, query, [], opts))
+      assert length(batches) < 500
+
+      assert Enum.flat_map(batches, fn %Adbc.Result{data: [column, _]} -> column.data end) ==
+               Enum.to_list(1..5000)
+    end
+  end
+
+  describe "query with coalesced batches" do
+    @nums """
+    WITH RECURSIVE nums(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM nums WHERE n < 1000)
+    SELECT n, CASE WHEN n % 3 = 0 THEN NULL ELSE 'row ' || n END AS s FROM nums
+    """
+
+    test "concatenates batches up to a number of rows", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      opts = [coalesce_rows: 250, "adbc.sqlite.query.batch_rows": 64]
+
+      batches = Enum.to_list(Connection.stream(conn, @nums, [], opts))
+      sizes = Enum.map(batches, fn %Adbc.Result{data: [column, _]} -> length(column.data) end)
+      assert sizes == [256, 256, 256, 232]
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: nums}, %Adbc.Column{data: strings}]} =
+               Connection.query!(conn, @nums, [], opts)
+
+      assert nums == Enum.to_list(1..1000)
+      assert strings == Enum.map(1..1000, &if(rem(&1, 3) == 0, do: nil, else: "row #{&1}"))
+    end
+
+    test "concatenates batches up to a size", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      opts = [coalesce_bytes: 4096, "adbc.sqlite.query.batch_rows": 64]
+
+      batches = Enum.to_list(Connection.stream(conn, @nums, [], opts))
+      assert length(batches) < 16
+
+      assert Enum.flat_map(batches, fn %Adbc.Result{data: [column, _]} -> column.data end) ==
+               Enum.to_list(1..1000)
+    end
+  end
+
+  describe "query with zero copy binaries" do
+    test "returns strings and binaries", %{db: db} do
       conn = start_supervised!({Connection, database: db})
 
       assert %Adbc.Result{
                data: [
-                 %Adbc.Column{
-                   name: "num",
-                   type: :i64,
-                   nullable: true,
-                   metadata: nil,
-                   data: [123]
-                 }
+                 %Adbc.Column{name: "text", type: :string, data: ["hello", nil, "world"]},
+                 %Adbc.Column{name: "blob", type: :binary, data: [<<1, 2>>, nil, <<3>>]}
                ]
              } =
-               Connection.query!(conn, "SELECT 123 as num")
+               Connection.query!(
+                 conn,
+                 """
+                 SELECT 'hello' AS text, x'0102' AS blob
+                 UNION ALL SELECT NULL, NULL
+                 UNION ALL SELECT 'world', x'03'
+                 """,
+                 [],
+                 zero_copy_binaries: true
+               )
+    end
+  end
+
+  describe "query with interned columns" do
+    @statuses """
+    WITH RECURSIVE t(i) AS (SELECT 0 UNION ALL SELECT i + 1 FROM t WHERE i < 99)
+    SELECT CASE i % 3 WHEN 0 THEN 'ok' WHEN 1 THEN 'error' END AS status,
+           'row ' || i AS name
+    FROM t
+    """
+
+    test "returns the same values", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      expected = Connection.query!(conn, @statuses)
+
+      assert Connection.query!(conn, @statuses, [], intern_columns: true) == expected
+      assert Connection.query!(conn, @statuses, [], intern_columns: ["status"]) == expected
+    end
+
+    test "returns values naming existing atoms as atoms", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      opts = [intern_columns: ["status"], intern_atoms: true]
+
+      assert %Adbc.Result{data: [status, name]} = Connection.query!(conn, @statuses, [], opts)
+      assert Enum.take(status.data, 3) == [:ok, :error, nil]
+      assert Enum.take(name.data, 2) == ["row 0", "row 1"]
+    end
+  end
+
+  describe "query with raw columns" do
+    test "returns fixed-width columns as binaries", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
 
       assert %Adbc.Result{
                data: [
-                 %Adbc.Column{
-                   name: "num",
-                   type: :i64,
-                   nullable: true,
-                   metadata: nil,
-                   data: [123]
-                 },
-                 %Adbc.Column{name: "bool", type: :i64, nullable: true, metadata: nil, data: [1]}
+                 %Adbc.Column{name: "int", type: :i64, data: {:raw, ints, nil}},
+                 %Adbc.Column{name: "float", type: :f64, data: {:raw, floats, nil}},
+                 %Adbc.Column{name: "text", type: :string, data: ["a", "b"]}
                ]
              } =
-               Connection.query!(conn, "SELECT 123 as num, true as bool")
+               Connection.query!(
+                 conn,
+                 "SELECT 1 AS int, 1.5 AS float, 'a' AS text UNION ALL SELECT -2, 2.5, 'b'",
+                 [],
+                 raw_columns: true
+               )
+
+      assert ints == <<1::64-signed-native, -2::64-signed-native>>
+      assert floats == <<1.5::64-float-native, 2.5::64-float-native>>
     end
 
-    test "select with parameters", %{db: db} do
+    test "merges the values and validity of all batches", %{db: db} do
       conn = start_supervised!({Connection, database: db})
 
       assert %Adbc.Result{
-               data: [
-                 %Adbc.Column{
-                   name: "num",
-                   type: :i64,
-                   nullable: true,
-                   metadata: nil,
-                   data: [579]
-                 }
-               ]
+               data: [%Adbc.Column{name: "int", type: :i64, nullable: true, data: data}]
              } =
-               Connection.query!(conn, "SELECT 123 + ? as num", [456])
+               Connection.query!(
+                 conn,
+                 "SELECT 1 AS int UNION ALL SELECT NULL UNION ALL SELECT 3",
+                 [],
+                 raw_columns: true,
+                 "adbc.sqlite.query.batch_rows": 2
+               )
+
+      assert {:raw, <<1::64-signed-native, _::64, 3::64-signed-native>>, <<0b101>>} = data
     end
 
-    test "fails on invalid query", %{db: db} do
+    test "can be converted to lists and sliced", %{db: db} do
       conn = start_supervised!({Connection, database: db})
 
-      assert_raise Adbc.Error,
-                   ~s([SQLite] Failed to prepare query: near "NOT": syntax error\nquery: NOT VALID SQL),
-                   fn -> Connection.query!(conn, "NOT VALID SQL") end
+      %Adbc.Result{data: [num, float]} =
+        Connection.query!(
+          conn,
+          "SELECT 1 AS num, 0.5 AS float UNION ALL SELECT NULL, NULL UNION ALL SELECT 3, 1.5",
+          [],
+          raw_columns: true
+        )
+
+      assert Adbc.Column.to_list(num) == [1, nil, 3]
+      assert Adbc.Column.to_list(float) == [0.5, nil, 1.5]
+      assert Adbc.Column.to_list(Adbc.Column.slice(num, 1, 2)) == [nil, 3]
+      assert %Adbc.Column{data: {:raw, _, <<0b10>>}} = Adbc.Column.slice(num, 1, 2)
+    end
+
+    test "can be bound as parameters", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      floats = Adbc.Column.raw(:f64, <<0.5::64-float-native, 1.5::64-float-native>>)
+
+      ints =
+        Adbc.Column.raw(:i64, <<1::64-native, 0::64, 3::64-native>>, validity: <<0b101>>)
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1, nil, 3]}]} =
+               Connection.query!(conn, "SELECT ? AS num", [ints])
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [0.5, 1.5]}]} =
+               Connection.query!(conn, "SELECT ? AS float", [floats])
+
+      %Adbc.Result{data: [num]} =
+        Connection.query!(conn, "SELECT ? AS num", [ints], raw_columns: true)
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [nil, 3]}]} =
+               Connection.query!(conn, "SELECT ? AS num", [Adbc.Column.slice(num, 1, 2)])
+    end
+
+    test "are validated when bound", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert {:error, %ArgumentError{message: message}} =
+               Connection.query(conn, "SELECT ?", [Adbc.Column.raw(:i32, <<1, 2, 3>>)])
+
+      assert message =~ "binary of 4-byte values"
+
+      column = Adbc.Column.raw(:i64, <<1::64-native>>, validity: <<>>)
+      assert {:error, %ArgumentError{message: message}} =
+               Connection.query(conn, "SELECT ?", [column])
+      assert message =~ "a bit for each of the 1 values"
+
+      column = Adbc.Column.raw(:string, <<"abc">>)
+      assert {:error, %ArgumentError{message: message}} =
+               Connection.query(conn, "SELECT ?", [column])
+      assert message =~ "not supported for columns of type"
     end
   end
 
-  describe "query with statement options" do
-    test "without parameters", %{db: db} do
+  test "concatenates many record batches", %{db: db} do
+    conn = start_supervised!({Connection, database: db})
+
+    query = """
+    WITH RECURSIVE nums(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM nums WHERE n < 5000)
+    SELECT n, CASE WHEN n % 3 = 0 THEN NULL ELSE 'v' || n END AS text FROM nums
+    """
+
+    assert %Adbc.Result{
+             data: [%Adbc.Column{name: "n", data: nums}, %Adbc.Column{name: "text", data: texts}]
+           } = Connection.query!(conn, query, [], "adbc.sqlite.query.batch_rows": 7)
+
+    assert nums == Enum.to_list(1..5000)
+    assert texts == Enum.map(1..5000, &if(rem(&1, 3) == 0, do: nil, else: "v#{&1}"))
+  end
+
+  describe "query with lazy columns" do
+    test "converts columns on demand", %{db: db} do
       conn = start_supervised!({Connection, database: db})
 
       assert %Adbc.Result{
                data: [
-                 %Adbc.Column{
-                   name: "num",
-                   type: :i64,
-                   nullable: true,
-                   metadata: nil,
-                   data: [123]
-                 },
-                 %Adbc.Column{name: "bool", type: :i64, nullable: true, metadata: nil, data: [1]}
+                 %Adbc.Column{name: "num", type: :i64, data: {:lazy, _, 0, 3}} = num,
+                 %Adbc.Column{name: "text", type: :string, data: {:lazy, _, 0, 3}} = text
                ]
-             } ==
-               Connection.query!(conn, "SELECT 123 as num, true as bool", [],
-                 "adbc.sqlite.query.batch_rows": 1
+             } =
+               Connection.query!(
+                 conn,
+                 "SELECT 1 AS num, 'a' AS text UNION ALL SELECT 2, NULL UNION ALL SELECT 3, 'c'",
+                 [],
+                 lazy_columns: true
                )
+
+      assert Adbc.Column.to_list(num) == [1, 2, 3]
+      assert Adbc.Column.to_list(text) == ["a", nil, "c"]
+      assert Adbc.Column.to_list(Adbc.Column.slice(num, 1, 5)) == [2, 3]
+      assert Adbc.Column.to_list(Adbc.Column.slice(text, 3, 1)) == []
     end
 
-    test "with parameters", %{db: db} do
+    test "can be given back as parameters", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      %Adbc.Result{data: [num]} =
+        Connection.query!(conn, "SELECT 1 AS num UNION ALL SELECT 2", [], lazy_columns: true)
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [3]}]} =
+               Connection.query!(conn, "SELECT ? + 1 AS num", [Adbc.Column.slice(num, 1, 1)])
+    end
+
+    test "are concatenated across batches", %{db: db} do
       conn = start_supervised!({Connection, database: db})
 
       assert %Adbc.Result{
                data: [
-                 %Adbc.Column{
-                   name: "num",
-                   type: :i64,
-                   nullable: true,
-                   metadata: nil,
-                   data: [579]
-                 }
+                 %Adbc.Column{data: {:lazy, _, 0, 3}} = num,
+                 %Adbc.Column{data: {:lazy, _, 0, 3}} = text
                ]
-             } ==
-               Connection.query!(conn, "SELECT 123 + ? as num", [456],
-                 "adbc.sqlite.query.batch_rows": 10
+             } =
+               Connection.query!(
+                 conn,
+                 "SELECT 1 AS num, 'a' AS text UNION ALL SELECT 2, NULL UNION ALL SELECT 3, 'c'",
+                 [],
+                 lazy_columns: true,
+                 "adbc.sqlite.query.batch_rows": 2
                )
+
+      assert Adbc.Column.to_list(num) == [1, 2, 3]
+      assert Adbc.Column.to_list(text) == ["a", nil, "c"]
+      assert Adbc.Column.to_list(Adbc.Column.slice(text, 1, 2)) == [nil, "c"]
     end
 
-    test "invalid statement option key", %{db: db} do
+    test "are counted in the memory stats while alive", %{db: db} do
       conn = start_supervised!({Connection, database: db})
 
-      assert {:error, %Adbc.Error{} = error} =
-               Connection.query(conn, "SELECT 123 as num", [], foo: 1)
+      %Adbc.Result{data: [num, text]} =
+        Connection.query!(conn, "SELECT 1 AS num, 'a' AS text", [], lazy_columns: true)
 
-      assert Exception.message(error) == "[SQLite] Unknown statement option foo=1"
+      assert %{
+               bind_bytes: bind_bytes,
+               retained_batches: batches,
+               retained_batch_bytes: batch_bytes,
+               retained_schemas: schemas,
+               pooled_bytes: pooled_bytes
+             } = Adbc.Nif.memory_stats()
+
+      assert is_integer(bind_bytes) and pooled_bytes >= 0
+      assert batches >= 1 and batch_bytes > 0 and schemas >= 2
+      assert Adbc.Column.to_list(num) == [1] and Adbc.Column.to_list(text) == ["a"]
     end
 
-    test "invalid statement option value", %{db: db} do
+    test "streams are released once garbage collected", %{db: db} do
       conn = start_supervised!({Connection, database: db})
+      %{live_streams: before} = Adbc.Nif.memory_stats()
 
-      assert {:error, %Adbc.Error{} = error} =
-               Connection.query(conn, "SELECT 123 as num, true as bool", [],
-                 "adbc.sqlite.query.batch_rows": 0
-               )
+      for _ <- 1..10 do
+        {:ok, _} = Connection.get_table_types(conn)
+        {:ok, _} = Connection.query(conn, "SELECT 1")
+      end
 
-      assert Exception.message(error) ==
-               "[SQLite] Invalid statement option value adbc.sqlite.query.batch_rows=0 (value is non-positive or out of range of int)"
+      :erlang.garbage_collect()
+      :erlang.garbage_collect(conn)
+
+      assert %{live_streams: live, live_stream_bytes: bytes} = Adbc.Nif.memory_stats()
+      assert live - before < 10 and bytes >= 0
     end
   end
 
-  describe "prepared queries" do
-    test "prepare", %{db: db} do
+  describe "query with output" do
+    test "returns rows as tuples", %{db: db} do
       conn = start_supervised!({Connection, database: db})
-      assert {:ok, ref} = Connection.prepare(conn, "SELECT 123 + ? as num")
-      assert is_reference(ref)
+
+      assert %Adbc.Result{data: [{1, "a"}, {2, nil}, {3, "c"}]} =
+               Connection.query!(
+                 conn,
+                 "SELECT 1 AS num, 'a' AS text UNION ALL SELECT 2, NULL UNION ALL SELECT 3, 'c'",
+                 [],
+                 output: :rows_tuples,
+                 "adbc.sqlite.query.batch_rows": 2
+               )
     end
-  end
 
-  describe "query_pointer" do
-    test "select", %{db: db} do
+    test "returns rows as maps", %{db: db} do
       conn = start_supervised!({Connection, database: db})
 
-      assert {:ok, :from_pointer} =
-               Connection.query_pointer(conn, "SELECT 123 as num", fn
-                 pointer, nil when is_integer(pointer) ->
-                   :from_pointer
-               end)
+      assert %Adbc.Result{
+               data: [
+                 %{"num" => 1, "text" => "a"},
+                 %{"num" => 2, "text" => nil},
+                 %{"num" => 3, "text" => "c"}
+               ]
+             } =
+               Connection.query!(
+                 conn,
+                 "SELECT 1 AS num, 'a' AS text UNION ALL SELECT 2, NULL UNION ALL SELECT 3, 'c'",
+                 [],
+                 output: :rows_maps
+               )
     end
 
-    test "prepared query", %{db: db} do
+    test "returns rows of numeric columns", %{db: db} do
       conn = start_supervised!({Connection, database: db})
+      query = "SELECT 1 AS num, 1.5 AS x UNION ALL SELECT NULL, 2.5 UNION ALL SELECT 3, NULL"
+      opts = ["adbc.sqlite.query.batch_rows": 2]
 
-      {:ok, ref} = Connection.prepare(conn, "SELECT 123 + ? as num")
+      assert %Adbc.Result{data: [{1, 1.5}, {nil, 2.5}, {3, nil}]} =
+               Connection.query!(conn, query, [], [output: :rows_tuples] ++ opts)
 
-      assert {:ok, :from_pointer} =
-               Connection.query_pointer(conn, ref, [456], fn
-                 pointer, nil when is_integer(pointer) ->
-                   :from_pointer
+      assert %Adbc.Result{data: [%{"num" => 1, "x" => 1.5}, %{"num" => nil}, _]} =
+               Connection.query!(conn, query, [], [output: :rows_maps] ++ opts)
+    end
+
+    test "returns rows as maps with columns out of order", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      query = "SELECT 1 AS z, 'b' AS m, 2.5 AS a"
+
+      assert %Adbc.Result{data: [%{"z" => 1, "m" => "b", "a" => 2.5}]} =
+               Connection.query!(conn, query, [], output: :rows_maps)
+
+      assert %Adbc.Result{data: [%{"z" => 1, "a" => 2.5}]} =
+               Connection.query!(conn, "SELECT 1 AS z, 2.5 AS a", [], output: :rows_maps)
+
+      assert {:error, %ArgumentError{message: "cannot return rows as maps" <> _}} =
+               Connection.query(conn, "SELECT 1 AS a, 2 AS a", [], output: :rows_maps)
+    end
+  end
+
+  describe "query_encoded" do
+    test "encodes results that decode to the same result", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      query =
+        "SELECT 1 AS num, 'a' AS text UNION ALL SELECT 2, NULL UNION ALL SELECT 3, 'c'"
+
+      assert {:ok, [schema | batches] = binaries} =
+               Connection.query_encoded(conn, query, [], "adbc.sqlite.query.batch_rows": 2)
+
+      assert is_binary(schema)
+      assert length(batches) == 2
+      assert Connection.decode_result(binaries) == Connection.query(conn, query)
+
+      assert {:ok, %Adbc.Result{data: [{1, "a"}, {2, nil}, {3, "c"}]}} =
+               Connection.decode_result(binaries, output: :rows_tuples)
+    end
+
+    test "returns an error for invalid binaries", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      assert {:ok, [schema, batch]} = Connection.query_encoded(conn, "SELECT 1 AS num")
+
+      assert {:error, %ArgumentError{message: "invalid encoded schema"}} =
+               Connection.decode_result(["not a schema", batch])
+
+      assert {:error, %ArgumentError{message: "invalid encoded record batch"}} =
+               Connection.decode_result([schema, binary_part(batch, 0, 10)])
+    end
+
+    test "decodes binaries encoded on a host of the other endianness" do
+      assert {:ok, %Adbc.Result{data: [num, text]}} =
+               Connection.decode_result(foreign_endian_stream())
+
+      assert %Adbc.Column{name: "num", type: :s64, metadata: %{"key" => "value"}} = num
+      assert num.data == [1, nil, -3]
+      assert %Adbc.Column{name: "text", type: :string, data: ["a", "bc", nil]} = text
+    end
+
+    # Encodes a result with a nullable s64 column "num" and a nullable
+    # string column "text" the way `Connection.query_encoded/4` does on a
+    # host of the other endianness
+    defp foreign_endian_stream do
+      <<native, _>> = <<1::16-native>>
+
+      int =
+        if native == 1,
+          do: fn value, size -> <<value::size(size)-big>> end,
+          else: fn value, size -> <<value::size(size)-little>> end
+
+      i64 = fn values -> for v <- values, into: <<>>, do: int.(v, 64) end
+      i32 = fn values -> for v <- values, into: <<>>, do: int.(v, 32) end
+
+      bytes = fn
+        nil -> i64.([-1])
+        bytes -> i64.([byte_size(bytes)]) <> bytes
+      end
+
+      metadata = i32.([1, 3]) <> "key" <> i32.([5]) <> "value"
+
+      # format, name, metadata, flags, children, dictionary
+      num_schema = [bytes.("l"), bytes.("num"), bytes.(metadata), i64.([2, 0]), 0]
+      text_schema = [bytes.("u"), bytes.("text"), bytes.(nil), i64.([2, 0]), 0]
+      schema = [bytes.("+s"), bytes.(""), bytes.(nil), i64.([0, 2]), num_schema, text_schema, 0]
+
+      # length, null_count, offset, buffers, children, dictionary
+      num = [i64.([3, 1, 0, 2]), bytes.(<<0b101>>), bytes.(i64.([1, 0, -3])), i64.([0]), 0]
+      text_buffers = [bytes.(<<0b011>>), bytes.(i32.([0, 1, 3, 3])), bytes.("abc")]
+      text = [i64.([3, 1, 0, 3]), text_buffers, i64.([0]), 0]
+      batch = [i64.([3, 0, 0, 1]), bytes.(nil), i64.([2]), num, text, 0]
+
+      [
+        IO.iodata_to_binary([i32.([0x53434241]), 1, 1 - native, schema]),
+        IO.iodata_to_binary([i32.([0x42434241]), batch])
+      ]
+    end
+  end
+
+  describe "query_matrix" do
+    @query "SELECT 1 AS a, 1.5 AS b UNION ALL SELECT 2, NULL UNION ALL SELECT 3, 3.5"
+
+    test "stacks numeric columns into a matrix binary", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert {:ok, %{data: data, shape: {3, 2}, type: {:f, 64}, names: ["a", "b"], mask: nil}} =
+               Connection.query_matrix(conn, @query, [], "adbc.sqlite.query.batch_rows": 2)
+
+      # nulls are quiet NaNs
+      assert <<1.0::float-64-native, 1.5::float-64-native, 2.0::float-64-native,
+               0x7FF8000000000000::64-native, 3.0::float-64-native, 3.5::float-64-native>> = data
+
+      assert {:ok, %{data: data, shape: {2, 3}, names: ["b", "a"]}} =
+               Connection.query_matrix(conn, @query, [],
+                 columns: ["b", "a"],
+                 type: {:f, 32},
+                 layout: :column_major
+               )
+
+      assert <<1.5::float-32-native, 0x7FC00000::32-native, 3.5::float-32-native,
+               1.0::float-32-native, 2.0::float-32-native, 3.0::float-32-native>> = data
+    end
+
+    test "masks nulls", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert {:ok, %{data: data, mask: <<0, 0, 0, 1, 0, 0>>}} =
+               Connection.query_matrix(conn, @query, [], nulls: :mask)
+
+      assert <<1.0::float-64-native, 1.5::float-64-native, 2.0::float-64-native,
+               0.0::float-64-native, 3.0::float-64-native, 3.5::float-64-native>> = data
+
+      assert {:ok, %{data: <<1::8, 2::8, 3::8>>, shape: {3, 1}}} =
+               Connection.query_matrix(conn, @query, [], columns: ["a"], type: {:u, 8})
+    end
+
+    test "returns errors for columns that cannot be stacked", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert {:error, %ArgumentError{message: "cannot write float column `b`" <> _}} =
+               Connection.query_matrix(conn, @query, [], type: {:s, 64})
+
+      assert {:error, %ArgumentError{message: "unknown column `c`"}} =
+               Connection.query_matrix(conn, @query, [], columns: ["c"])
+
+      assert {:error, %ArgumentError{message: "column `t` of format `u`" <> _}} =
+               Connection.query_matrix(conn, "SELECT 'x' AS t")
+
+      assert_raise ArgumentError, fn -> Connection.query_matrix(conn, @query, [], type: :f32) end
+    end
+  end
+
+  describe "dictionary-encoded columns" do
+    test "are decoded to values sharing the same term" do
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{name: "color", type: :string} = column]}} =
+               Connection.decode_result(encoded_dictionary_stream())
+
+      assert column.data == ["blue", "red", nil, "blue"]
+      assert [blue, _, _, blue2] = column.data
+      assert :erts_debug.same(blue, blue2)
+    end
+
+    test "are returned as indices and values with :dictionary_columns" do
+      assert {:ok, %Adbc.Result{data: [column]}} =
+               Connection.decode_result(encoded_dictionary_stream(), dictionary_columns: true)
+
+      assert %Adbc.Column{type: :string, data: {:dictionary, [1, 0, nil, 1], ["red", "blue"]}} =
+               column
+
+      assert Adbc.Column.to_list(column) == ["blue", "red", nil, "blue"]
+      assert Adbc.Column.to_list(Adbc.Column.slice(column, 1, 2)) == ["red", nil]
+    end
+
+    test "are concatenated across record batches with :dictionary_columns" do
+      [schema, batch] = encoded_dictionary_stream()
+
+      assert {:ok, %Adbc.Result{data: [column]}} =
+               Connection.decode_result([schema, batch, batch], dictionary_columns: true)
+
+      assert {:dictionary, [1, 0, nil, 1, 3, 2, nil, 3], _} = column.data
+      assert Adbc.Column.to_list(column) ==
+               ["blue", "red", nil, "blue", "blue", "red", nil, "blue"]
+    end
+
+    # Encodes a result with a single string column "color" whose values
+    # ["blue", "red", nil, "blue"] are dictionary-encoded, in the format of
+    # `Connection.query_encoded/4`
+    defp encoded_dictionary_stream do
+      <<endianness, _>> = <<1::16-native>>
+      i64 = fn values -> for v <- values, into: <<>>, do: <<v::64-native>> end
+      i32 = fn values -> for v <- values, into: <<>>, do: <<v::32-native>> end
+
+      bytes = fn
+        nil -> <<-1::64-native>>
+        bytes -> <<byte_size(bytes)::64-native, bytes::binary>>
+      end
+
+      # format, name, metadata, flags, children, dictionary
+      dictionary_schema = [bytes.("u"), bytes.(nil), bytes.(nil), i64.([2, 0]), 0]
+      column_schema = [bytes.("i"), bytes.("color"), bytes.(nil), i64.([2, 0]), 1]
+      schema = [bytes.("+s"), bytes.(""), bytes.(nil), i64.([0, 1])]
+      schema = [schema, column_schema, dictionary_schema, 0]
+
+      # length, null_count, offset, buffers, children, dictionary
+      dictionary = [i64.([2, 0, 0, 3]), bytes.(nil), bytes.(i32.([0, 3, 7])), bytes.("redblue")]
+      dictionary = [dictionary, i64.([0]), 0]
+      column = [i64.([4, 1, 0, 2]), bytes.(<<0b1011>>), bytes.(i32.([1, 0, 0, 1])), i64.([0]), 1]
+      batch = [i64.([4, 0, 0, 1]), bytes.(nil), i64.([1]), column, dictionary, 0]
+
+      [
+        IO.iodata_to_binary([<<0x53434241::32-native, 1, endianness>>, schema]),
+        IO.iodata_to_binary([<<0x42434241::32-native>>, batch])
+      ]
+    end
+  end
+
+  describe "decimal columns" do
+    test "are decoded to coefficients and exponents" do
+      assert {:ok, %Adbc.Result{data: [price, big]}} =
+               Connection.decode_result(encoded_decimal_stream())
+
+      assert %Adbc.Column{name: "price", type: {:decimal, 128, 38, 2}, nullable: true} = price
+      assert price.data == [{1234, -2}, nil, {-Integer.pow(2, 127), -2}]
+
+      assert %Adbc.Column{name: "big", type: {:decimal, 256, 76, 0}} = big
+      assert big.data == [{Integer.pow(2, 200), 0}, nil, {-1, 0}]
+    end
+
+    test "are built from integers, tuples and decimal structs" do
+      decimal = %{__struct__: Decimal, sign: -1, coef: 5, exp: -1}
+
+      assert %Adbc.Column{type: {:decimal, 128, 10, 2}, data: data} =
+               Adbc.Column.decimal([12, {1234, -2}, {5, 1}, decimal, nil], 10, 2)
+
+      assert data == [{1200, -2}, {1234, -2}, {5000, -2}, {-50, -2}, nil]
+
+      assert %Adbc.Column{type: {:decimal, 256, 40, 0}} = Adbc.Column.decimal([1], 40, 0)
+
+      assert_raise ArgumentError, ~r"without losing digits", fn ->
+        Adbc.Column.decimal([{1234, -3}], 10, 2)
+      end
+    end
+
+    test "are parsed from PostgreSQL numeric strings with :numeric_columns" do
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{type: :string}]}} =
+               Connection.decode_result(encoded_numeric_stream())
+
+      assert {:ok, %Adbc.Result{data: [amount]}} =
+               Connection.decode_result(encoded_numeric_stream(), numeric_columns: true)
+
+      assert %Adbc.Column{name: "amount", type: {:decimal, 128, 38, 3}, nullable: true} = amount
+      assert amount.data == [{12500, -3}, {-125, -3}, nil, "NaN", {100_000, -3}]
+    end
+
+    # Encodes a result with a string column "amount" of PostgreSQL numeric
+    # values ["12.5", "-0.125", nil, "NaN", "100"], in the format of
+    # `Connection.query_encoded/4`
+    defp encoded_numeric_stream do
+      <<endianness, _>> = <<1::16-native>>
+      i64 = fn values -> for v <- values, into: <<>>, do: <<v::64-native>> end
+      i32 = fn values -> for v <- values, into: <<>>, do: <<v::32-native>> end
+
+      bytes = fn
+        nil -> <<-1::64-native>>
+        bytes -> <<byte_size(bytes)::64-native, bytes::binary>>
+      end
+
+      key = "ADBC:postgresql:typname"
+      metadata = <<1::32-native, 23::32-native, key::binary, 7::32-native, "numeric">>
+
+      # format, name, metadata, flags, children, dictionary
+      amount_schema = [bytes.("u"), bytes.("amount"), bytes.(metadata), i64.([2, 0]), 0]
+      schema = [bytes.("+s"), bytes.(""), bytes.(nil), i64.([0, 1]), amount_schema, 0]
+
+      # length, null_count, offset, buffers, children, dictionary
+      offsets = i32.([0, 4, 10, 10, 13, 16])
+      buffers = [bytes.(<<0b11011>>), bytes.(offsets), bytes.("12.5-0.125NaN100")]
+      amount = [i64.([5, 1, 0, 3]), buffers, i64.([0]), 0]
+      batch = [i64.([5, 0, 0, 1]), bytes.(nil), i64.([1]), amount, 0]
+
+      [
+        IO.iodata_to_binary([<<0x53434241::32-native, 1, endianness>>, schema]),
+        IO.iodata_to_binary([<<0x42434241::32-native>>, batch])
+      ]
+    end
+
+    # Encodes a result with a nullable decimal128(38, 2) column "price" and a
+    # decimal256(76, 0) column "big", in the format of
+    # `Connection.query_encoded/4`
+    defp encoded_decimal_stream do
+      <<endianness, _>> = <<1::16-native>>
+      i64 = fn values -> for v <- values, into: <<>>, do: <<v::64-native>> end
+
+      bytes = fn
+        nil -> <<-1::64-native>>
+        bytes -> <<byte_size(bytes)::64-native, bytes::binary>>
+      end
+
+      # format, name, metadata, flags, children, dictionary
+      price_schema = [bytes.("d:38,2"), bytes.("price"), bytes.(nil), i64.([2, 0]), 0]
+      big_schema = [bytes.("d:76,0,256"), bytes.("big"), bytes.(nil), i64.([2, 0]), 0]
+      schema = [bytes.("+s"), bytes.(""), bytes.(nil), i64.([0, 2]), price_schema, big_schema, 0]
+
+      # length, null_count, offset, buffers, children, dictionary
+      price_values = <<1234::128-native, 0::128, -Integer.pow(2, 127)::128-native>>
+      price = [i64.([3, 1, 0, 2]), bytes.(<<0b101>>), bytes.(price_values), i64.([0]), 0]
+      big_values = <<Integer.pow(2, 200)::256-native, 0::256, -1::256-native>>
+      big = [i64.([3, 1, 0, 2]), bytes.(<<0b101>>), bytes.(big_values), i64.([0]), 0]
+      batch = [i64.([3, 0, 0, 1]), bytes.(nil), i64.([2]), price, big, 0]
+
+      [
+        IO.iodata_to_binary([<<0x53434241::32-native, 1, endianness>>, schema]),
+        IO.iodata_to_binary([<<0x42434241::32-native>>, batch])
+      ]
+    end
+  end
+
+  describe "view and run-end encoded columns" do
+    test "views are decoded from the view or from their data buffers" do
+      assert {:ok, %Adbc.Result{data: [string, binary]}} =
+               Connection.decode_result(encoded_view_stream())
+
+      assert %Adbc.Column{name: "s", type: :string, nullable: true} = string
+      assert string.data == ["short", nil, "twelve bytes", "a value longer than twelve"]
+
+      assert %Adbc.Column{name: "b", type: :binary} = binary
+      assert binary.data == [<<1, 2, 3>>, "binary value one", nil, "binary value two"]
+
+      assert {:ok, %Adbc.Result{data: [string, binary]}} =
+               Connection.decode_result(encoded_view_stream(), zero_copy_binaries: true)
+
+      assert string.data == ["short", nil, "twelve bytes", "a value longer than twelve"]
+      assert binary.data == [<<1, 2, 3>>, "binary value one", nil, "binary value two"]
+    end
+
+    test "run-end encoded arrays are decoded run by run from their offset" do
+      assert {:ok, %Adbc.Result{data: [column]}} =
+               Connection.decode_result(encoded_run_end_stream())
+
+      assert %Adbc.Column{name: "level", type: :i64} = column
+      assert column.data == [10, 20, 20, 20, nil, 40]
+    end
+
+    test "views out of the range of their data buffers are rejected" do
+      [schema, batch] = encoded_view_stream()
+      view = <<16::32-native, "bina", 1::32-native, 2::32-native>>
+      batch = :binary.replace(batch, view, <<16::32-native, "bina", 1::32-native, 3::32-native>>)
+
+      assert {:error, %ArgumentError{message: message}} = Connection.decode_result([schema, batch])
+      assert message =~ "view out of the range of its data buffer"
+
+      # the sizes of the data buffers must match them
+      sizes = <<16::64-native, 18::64-native>>
+      batch = :binary.replace(batch, sizes, <<16::64-native, 19::64-native>>)
+
+      assert {:error, %ArgumentError{message: "invalid encoded record batch"}} =
+               Connection.decode_result([schema, batch])
+    end
+
+    # Encodes a result with a string view column "s" of ["short", nil,
+    # "twelve bytes", "a value longer than twelve"] and a binary view column
+    # "b" of [<<1, 2, 3>>, "binary value one", nil, "binary value two"], whose
+    # longer values are in two data buffers, in the format of
+    # `Connection.query_encoded/4`
+    defp encoded_view_stream do
+      <<endianness, _>> = <<1::16-native>>
+      i64 = fn values -> for v <- values, into: <<>>, do: <<v::64-native>> end
+
+      bytes = fn
+        nil -> <<-1::64-native>>
+        bytes -> <<byte_size(bytes)::64-native, bytes::binary>>
+      end
+
+      inline = fn value ->
+        <<byte_size(value)::32-native, value::binary, 0::size(12 - byte_size(value))-unit(8)>>
+      end
+
+      view = fn value, buffer, offset ->
+        <<prefix::binary-4, _::binary>> = value
+        <<byte_size(value)::32-native, prefix::binary, buffer::32-native, offset::32-native>>
+      end
+
+      # format, name, metadata, flags, children, dictionary
+      string_schema = [bytes.("vu"), bytes.("s"), bytes.(nil), i64.([2, 0]), 0]
+      binary_schema = [bytes.("vz"), bytes.("b"), bytes.(nil), i64.([2, 0]), 0]
+      schema = [bytes.("+s"), bytes.(""), bytes.(nil), i64.([0, 2]), string_schema, binary_schema, 0]
+
+      # length, null_count, offset, buffers, children, dictionary
+      long = "a value longer than twelve"
+      views = [inline.("short"), inline.(""), inline.("twelve bytes"), view.(long, 0, 0)]
+      buffers = [bytes.(<<0b1101>>), bytes.(IO.iodata_to_binary(views)), bytes.(long)]
+      string = [i64.([4, 1, 0, 4]), buffers, bytes.(i64.([byte_size(long)])), i64.([0]), 0]
+
+      one = "binary value one"
+      two = "binary value two"
+      views = [inline.(<<1, 2, 3>>), view.(one, 0, 0), inline.(""), view.(two, 1, 2)]
+      buffers = [bytes.(<<0b1011>>), bytes.(IO.iodata_to_binary(views)), bytes.(one)]
+      buffers = [buffers, bytes.("__" <> two), bytes.(i64.([16, 18]))]
+      binary = [i64.([4, 1, 0, 5]), buffers, i64.([0]), 0]
+      batch = [i64.([4, 0, 0, 1]), bytes.(nil), i64.([2]), string, binary, 0]
+
+      [
+        IO.iodata_to_binary([<<0x53434241::32-native, 1, endianness>>, schema]),
+        IO.iodata_to_binary([<<0x42434241::32-native>>, batch])
+      ]
+    end
+
+    # Encodes a result with a run-end encoded column "level" of [10, 20, 20,
+    # 20, nil, 40], sliced from the runs [0, 10, 20, nil, 40] ending at [1, 2,
+    # 5, 6, 7] with an offset of 1, in the format of
+    # `Connection.query_encoded/4`
+    defp encoded_run_end_stream do
+      <<endianness, _>> = <<1::16-native>>
+      i64 = fn values -> for v <- values, into: <<>>, do: <<v::64-native>> end
+      i32 = fn values -> for v <- values, into: <<>>, do: <<v::32-native>> end
+
+      bytes = fn
+        nil -> <<-1::64-native>>
+        bytes -> <<byte_size(bytes)::64-native, bytes::binary>>
+      end
+
+      # format, name, metadata, flags, children, dictionary
+      run_ends_schema = [bytes.("i"), bytes.("run_ends"), bytes.(nil), i64.([0, 0]), 0]
+      values_schema = [bytes.("l"), bytes.("values"), bytes.(nil), i64.([2, 0]), 0]
+      level_schema = [bytes.("+r"), bytes.("level"), bytes.(nil), i64.([0, 2])]
+      level_schema = [level_schema, run_ends_schema, values_schema, 0]
+      schema = [bytes.("+s"), bytes.(""), bytes.(nil), i64.([0, 1]), level_schema, 0]
+
+      # length, null_count, offset, buffers, children, dictionary
+      run_ends = [i64.([5, 0, 0, 2]), bytes.(nil), bytes.(i32.([1, 2, 5, 6, 7])), i64.([0]), 0]
+      values = i64.([0, 10, 20, 0, 40])
+      values = [i64.([5, 1, 0, 2]), bytes.(<<0b10111>>), bytes.(values), i64.([0]), 0]
+      level = [i64.([6, 0, 1, 0]), i64.([2]), run_ends, values, 0]
+      batch = [i64.([6, 0, 0, 1]), bytes.(nil), i64.([1]), level, 0]
+
+      [
+        IO.iodata_to_binary([<<0x53434241::32-native, 1, endianness>>, schema]),
+        IO.iodata_to_binary([<<0x42434241::32-native>>, batch])
+      ]
+    end
+  end
+
+  describe "query with timeout" do
+    test "returns an error once the timeout elapses", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      query = """
+      WITH RECURSIVE nums(n) AS (SELECT 1 UNION ALL SELECT n + 1 FROM nums WHERE n < 5000000)
+      SELECT count(*) AS count FROM nums
+      """
+
+      assert {:error, %Adbc.Error{message: "query timed out", state: "HYT00"}} =
+               Connection.query(conn, query, [], timeout: 10)
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{data: [123]}]}} =
+               Connection.query(conn, "SELECT 123 as num")
+    end
+
+    test "returns results within the timeout", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{data: [123]}]}} =
+               Connection.query(conn, "SELECT 123 as num", [], timeout: 5000)
+    en
+    test "raises on an invalid timeout without crashing the connection", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert_raise ArgumentError, ~r/:timeout must be/, fn ->
+        Connection.query(conn, "SELECT 123 as num", [], timeout: "5")
+      end
+
+      assert_raise ArgumentError, ~r/:timeout must be/, fn ->
+        Connection.stream(conn, "SELECT 123 as num", [], timeout: -1) |> Enum.to_list()
+      end
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{data: [123]}]}} =
+               Connection.query(conn, "SELECT 123 as num")
+    end
+  end
+
+  describe "query!" do
+    test "select", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert %Adbc.Result{
+               data: [
+                 %Adbc.Column{
+                   name: "num",
+                   type: :i64,
+                   nullable: true,
+                   metadata: nil,
+                   data: [123]
+                 }
+               ]
+             } =
+               Connection.query!(conn, "SELECT 123 as num")
+
+      assert %Adbc.Result{
+               data: [
+                 %Adbc.Column{
+                   name: "num",
+                   type: :i64,
+                   nullable: true,
+                   metadata: nil,
+                   data: [123]
+                 },
+                 %Adbc.Column{name: "bool", type: :i64, nullable: true, metadata: nil, data: [1]}
+               ]
+             } =
+               Connection.query!(conn, "SELECT 123 as num, true as bool")
+    end
+
+    test "select with parameters", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert %Adbc.Result{
+               data: [
+                 %Adbc.Column{
+                   name: "num",
+                   type: :i64,
+                   nullable: true,
+                   metadata: nil,
+                   data: [579]
+                 }
+               ]
+             } =
+               Connection.query!(conn, "SELECT 123 + ? as num", [456])
+    end
+
+    test "fails on invalid query", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert_raise Adbc.Error,
+                   ~s([SQLite] Failed to prepare query: near "NOT": syntax error\nquery: NOT VALID SQL),
+                   fn -> Connection.query!(conn, "NOT VALID SQL") end
+    end
+  end
+
+  describe "query with statement options" do
+    test "without parameters", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert %Adbc.Result{
+               data: [
+                 %Adbc.Column{
+                   name: "num",
+                   type: :i64,
+                   nullable: true,
+                   metadata: nil,
+                   data: [123]
+                 },
+                 %Adbc.Column{name: "bool", type: :i64, nullable: true, metadata: nil, data: [1]}
+               ]
+             } ==
+               Connection.query!(conn, "SELECT 123 as num, true as bool", [],
+                 "adbc.sqlite.query.batch_rows": 1
+               )
+    end
+
+    test "with parameters", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert %Adbc.Result{
+               data: [
+                 %Adbc.Column{
+                   name: "num",
+                   type: :i64,
+                   nullable: true,
+                   metadata: nil,
+                   data: [579]
+                 }
+               ]
+             } ==
+               Connection.query!(conn, "SELECT 123 + ? as num", [456],
+                 "adbc.sqlite.query.batch_rows": 10
+               )
+    end
+
+    test "invalid statement option key", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert {:error, %Adbc.Error{} = error} =
+               Connection.query(conn, "SELECT 123 as num", [], foo: 1)
+
+      assert Exception.message(error) == "[SQLite] Unknown statement option foo=1"
+    end
+
+    test "invalid statement option value", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert {:error, %Adbc.Error{} = error} =
+               Connection.query(conn, "SELECT 123 as num, true as bool", [],
+                 "adbc.sqlite.query.batch_rows": 0
+               )
+
+      assert Exception.message(error) ==
+               "[SQLite] Invalid statement option value adbc.sqlite.query.batch_rows=0 (value is non-positive or out of range of int)"
+    end
+  end
+
+  describe "prepared queries" do
+    test "prepare", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      assert {:ok, ref} = Connection.prepare(conn, "SELECT 123 + ? as num")
+      assert is_reference(ref)
+    end
+  end
+
+  describe "execute_many" do
+    test "returns the rows affected by each row", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      Connection.query!(conn, "CREATE TABLE many (i INTEGER, s TEXT)")
+
+      assert {:ok, [1, 1, 1]} =
+               Connection.execute_many(conn, "INSERT INTO many VALUES (?, ?)", [
+                 [1, "a"],
+                 [2, nil],
+                 [3, "c"]
+               ])
+
+      assert {:ok, [2, 0]} =
+               Connection.execute_many(conn, "UPDATE many SET s = 'x' WHERE i >= ?", [[2], [5]])
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: ["a", "x", "x"]}]} =
+               Connection.query!(conn, "SELECT s FROM many ORDER BY i")
+    end
+
+    test "accepts prepared statements and stops at the first error", %{db: db} do
+      conn = start_supervised!({Connection, database: db, statement_cache: 1})
+      Connection.query!(conn, "CREATE TABLE many (i INTEGER PRIMARY KEY)")
+      {:ok, ref} = Connection.prepare(conn, "INSERT INTO many VALUES (?)")
+
+      assert {:ok, [1]} = Connection.execute_many(conn, ref, [[1]])
+      assert {:ok, []} = Connection.execute_many(conn, ref, [])
+
+      assert {:error, %Adbc.Error{}} =
+               Connection.execute_many(conn, "INSERT INTO many VALUES (?)", [[2], [1], [3]])
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1, 2]}]} =
+               Connection.query!(conn, "SELECT i FROM many ORDER BY i")
+
+      assert {:error, %ArgumentError{}} =
+               Connection.execute_many(conn, "INSERT INTO many VALUES (?)", [[%{}]])
+    end
+  end
+
+  describe "parameter round trips" do
+    test "binds columns with nulls", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      Connection.query!(conn, """
+      CREATE TABLE bound (
+        i1 INTEGER, i2 INTEGER, i3 INTEGER, i4 INTEGER, r1 REAL,
+        r2 REAL, t1 TEXT, t2 TEXT, b1 BLOB, n1 INTEGER
+      )
+      """)
+
+      params = [
+        Adbc.Column.i8([-128, nil, 127]),
+        Adbc.Column.u16([nil, 65535, 0]),
+        Adbc.Column.i32([-2_147_483_648, 2_147_483_647, nil]),
+        Adbc.Column.u64([9_223_372_036_854_775_807, nil, 1]),
+        Adbc.Column.f32([0.5, nil, -1.25]),
+        Adbc.Column.f64([nil, 2.5, 1.0e100]),
+        Adbc.Column.string(["a", nil, ""]),
+        Adbc.Column.large_string([nil, "bb", "ccc"]),
+        Adbc.Column.binary([<<0, 1>>, <<>>, nil]),
+        Adbc.Column.boolean([true, nil, false])
+      ]
+
+      Connection.query!(conn, "INSERT INTO bound VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)", params)
+
+      assert %{
+               "i1" => [-128, nil, 127],
+               "i2" => [nil, 65535, 0],
+               "i3" => [-2_147_483_648, 2_147_483_647, nil],
+               "i4" => [9_223_372_036_854_775_807, nil, 1],
+               "r1" => [0.5, nil, -1.25],
+               "r2" => [nil, 2.5, 1.0e100],
+               "t1" => ["a", nil, ""],
+               "t2" => [nil, "bb", "ccc"],
+               "b1" => [<<0, 1>>, <<>>, nil],
+               "n1" => [1, nil, 0]
+             } ==
+               Connection.query!(conn, "SELECT * FROM bound ORDER BY rowid")
+               |> Adbc.Result.to_map()
+    end
+
+    test "binds rows with nulls and mixed numbers", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      Connection.query!(conn, "CREATE TABLE bound (r REAL, t TEXT, b INTEGER, n INTEGER)")
+
+      rows = [
+        [nil, "a", true, nil],
+        [1, nil, nil, nil],
+        [2.5, "", false, nil]
+      ]
+
+      Connection.query!(conn, "INSERT INTO bound VALUES (?, ?, ?, ?)", rows)
+
+      assert %{
+               "r" => [nil, 1.0, 2.5],
+               "t" => ["a", nil, ""],
+               "b" => [1, nil, 0],
+               "n" => [nil, nil, nil]
+             } ==
+               Connection.query!(conn, "SELECT * FROM bound ORDER BY rowid")
+               |> Adbc.Result.to_map()
+    end
+  end
+
+  describe "batch" do
+    test "executes statements with and without params", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      Connection.query!(conn, "CREATE TABLE batched (i INTEGER, s TEXT)")
+
+      assert {:ok, [1, 1, 2]} =
+               Connection.batch(conn, [
+                 {"INSERT INTO batched VALUES (?, ?)", [1, "a"]},
+                 "INSERT INTO batched VALUES (2, 'b')",
+                 {"UPDATE batched SET s = ? WHERE i >= ?", ["x", 1]}
+               ])
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: ["x", "x"]}]} =
+               Connection.query!(conn, "SELECT s FROM batched ORDER BY i")
+
+      assert {:ok, []} = Connection.batch(conn, [])
+
+      assert_raise ArgumentError, ~r/expected a query or a {query, params} tuple/, fn ->
+        Connection.batch(conn, [:oops])
+      end
+    end
+
+    test "stops at the first error", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      Connection.query!(conn, "CREATE TABLE batched (i INTEGER PRIMARY KEY)")
+
+      assert {:error, %Adbc.Error{}} =
+               Connection.batch(conn, [
+                 {"INSERT INTO batched VALUES (?)", [1]},
+                 {"INSERT INTO batched VALUES (?)", [1]},
+                 {"INSERT INTO batched VALUES (?)", [2]}
+               ])
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1]}]} =
+               Connection.query!(conn, "SELECT i FROM batched ORDER BY i")
+    end
+  end
+
+  describe "transaction" do
+    test "commits all statements", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      Connection.query!(conn, "CREATE TABLE batched (i INTEGER PRIMARY KEY)")
+
+      assert {:ok, [1, 1]} =
+               Connection.transaction(conn, [
+                 {"INSERT INTO batched VALUES (?)", [1]},
+                 {"INSERT INTO batched VALUES (?)", [2]}
+               ])
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1, 2]}]} =
+               Connection.query!(conn, "SELECT i FROM batched ORDER BY i")
+    end
+
+    test "rolls back all statements on error", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      Connection.query!(conn, "CREATE TABLE batched (i INTEGER PRIMARY KEY)")
+
+      assert {:error, %Adbc.Error{}} =
+               Connection.transaction(conn, [
+                 {"INSERT INTO batched VALUES (?)", [1]},
+                 {"INSERT INTO batched VALUES (?)", [1]}
+               ])
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: []}]} =
+               Connection.query!(conn, "SELECT i FROM batched ORDER BY i")
+
+      assert {:ok, [1]} = Connection.transaction(conn, [{"INSERT INTO batched VALUES (?)", [3]}])
+    end
+  end
+
+  describe "stream" do
+    @three_rows "SELECT 1 AS num UNION ALL SELECT 2 UNION ALL SELECT 3"
+
+    test "yields a result per record batch", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      stream = Connection.stream(conn, @three_rows, [], "adbc.sqlite.query.batch_rows": 2)
+
+      assert [
+               %Adbc.Result{data: [%Adbc.Column{name: "num", data: [1, 2]}]},
+               %Adbc.Result{data: [%Adbc.Column{name: "num", data: [3]}]}
+             ] = Enum.to_list(stream)
+
+      assert [%Adbc.Result{data: [%{"num" => 1}, %{"num" => 2}, %{"num" => 3}]}] =
+               Enum.to_list(Connection.stream(conn, @three_rows, [], output: :rows_maps))
+    end
+
+    test "unlocks the connection once halted", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      stream = Connection.stream(conn, @three_rows, [], "adbc.sqlite.query.batch_rows": 1)
+
+      assert [%Adbc.Result{data: [%Adbc.Column{data: [1]}]}] = Enum.take(stream, 1)
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1]}]} =
+               Connection.query!(conn, "SELECT 1 AS num")
+    end
+
+    test "raises on errors", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert_raise Adbc.Error, fn ->
+        conn |> Connection.stream("SELECT * FROM missing") |> Enum.to_list()
+      end
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1]}]} =
+               Connection.query!(conn, "SELECT 1 AS num")
+    end
+
+    test "raises with :cursor_rows on databases without cursors", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert_raise Adbc.Error, fn ->
+        conn |> Connection.stream(@three_rows, [], cursor_rows: 2) |> Enum.to_list()
+      end
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1]}]} =
+               Connection.query!(conn, "SELECT 1 AS num")
+    end
+  end
+
+  describe "parallel batches" do
+    @five_rows "SELECT 1 AS num UNION ALL SELECT 2 UNION ALL SELECT 3 UNION ALL SELECT 4 " <>
+                 "UNION ALL SELECT 5"
+
+    test "returns the batches in order", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      opts = ["adbc.sqlite.query.batch_rows": 1, parallel_batches: 3]
+
+      assert %Adbc.Result{data: [%Adbc.Column{name: "num", data: [1, 2, 3, 4, 5]}]} =
+               Connection.query!(conn, @five_rows, [], opts)
+
+      assert [[{1}], [{2}], [{3}], [{4}], [{5}]] =
+               conn
+               |> Connection.stream(@five_rows, [], [output: :rows_tuples] ++ opts)
+               |> Enum.map(& &1.data)
+    end
+
+    test "respects result limits", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      opts = ["adbc.sqlite.query.batch_rows": 1, parallel_batches: 2, max_rows: 3]
+
+      assert {:error, %Adbc.Error{state: "54000"}} = Connection.query(conn, @five_rows, [], opts)
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1]}]} = Connection.query!(conn, "SELECT 1")
+    end
+  end
+
+  describe "query with shared" do
+    @rows "WITH RECURSIVE t(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM t WHERE i < 5) " <>
+            "SELECT i, 'row ' || i AS s FROM t"
+
+    test "returns a result readable from other processes", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      opts = [shared: true, "adbc.sqlite.query.batch_rows": 2]
+
+      assert %Adbc.Result{data: %Adbc.SharedResult{num_rows: 5, columns: ["i", "s"]} = shared} =
+               Connection.query!(conn, @rows, [], opts)
+
+      assert %{shared_results: shared_results} = Adbc.Nif.memory_stats()
+      assert shared_results >= 1
+
+      task =
+        Task.async(fn ->
+          Adbc.SharedResult.to_result!(shared, columns: ["s"], offset: 1, length: 3)
+        end)
+
+      assert %Adbc.Result{data: [%Adbc.Column{name: "s", data: ["row 2", "row 3", "row 4"]}]} =
+               Task.await(task)
+
+      assert %Adbc.Result{data: [{4, "row 4"}, {5, "row 5"}]} =
+               Adbc.SharedResult.to_result!(shared, offset: 3, output: :rows_tuples)
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1, 2, 3, 4, 5]}, _]} =
+               Adbc.SharedResult.to_result!(shared)
+
+      assert_raise ArgumentError, ~r"unknown column", fn ->
+        Adbc.SharedResult.to_result(shared, columns: ["unknown"])
+      end
+    end
+
+    test "selects rows and columns natively", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      opts = [shared: true, "adbc.sqlite.query.batch_rows": 2]
+      %Adbc.Result{data: shared} = Connection.query!(conn, @rows, [], opts)
+
+      assert %Adbc.SharedResult{num_rows: 5, columns: ["s", "i"]} =
+               projected = Adbc.SharedResult.select(shared, ["s", "i"])
+
+      assert %Adbc.Result{data: [{"row 1", 1} | _]} =
+               Adbc.SharedResult.to_result!(projected, output: :rows_tuples)
+
+      assert %Adbc.Result{data: [{2, _}, {3, _}, {4, _}]} =
+               shared
+               |> Adbc.SharedResult.slice(1, 3)
+               |> Adbc.SharedResult.to_result!(output: :rows_tuples)
+
+      assert %Adbc.Result{data: [{5, "row 5"}, {1, "row 1"}, {5, "row 5"}]} =
+               shared
+               |> Adbc.SharedResult.take([4, 0, 4])
+               |> Adbc.SharedResult.to_result!(output: :rows_tuples)
+
+      assert %Adbc.Result{data: [{1, _}, {4, _}]} =
+               shared
+               |> Adbc.SharedResult.filter([true, false, false, true, false])
+               |> Adbc.SharedResult.to_result!(output: :rows_tuples)
+
+      assert %Adbc.SharedResult{num_rows: 3} =
+               filtered = Adbc.SharedResult.filter(shared, {"i", :>=, 3})
+
+      assert %Adbc.Result{data: [%Adbc.Column{name: "s", data: ["row 3", "row 4", "row 5"]}]} =
+               filtered |> Adbc.SharedResult.select(["s"]) |> Adbc.SharedResult.to_result!()
+
+      assert %Adbc.SharedResult{num_rows: 1} =
+               Adbc.SharedResult.filter(shared, {"s", :==, "row 2"})
+
+      assert_raise ArgumentError, ~r"out of range", fn ->
+        Adbc.SharedResult.take(shared, [5])
+      end
+
+      assert_raise ArgumentError, ~r"fewer booleans", fn ->
+        Adbc.SharedResult.filter(shared, [true])
+      end
+    end
+  end
+
+  describe "query with spill" do
+    test "returns a result read back from a mapped file", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      tmp = Path.join(System.tmp_dir!(), "adbc-spill-test-#{System.unique_integer([:positive])}")
+      File.mkdir_p!(tmp)
+      on_exit(fn -> File.rm_rf!(tmp) end)
+
+      query =
+        "WITH RECURSIVE t(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM t WHERE i < 5) " <>
+          "SELECT i, 'row ' || i AS s, CASE WHEN i % 2 = 0 THEN NULL ELSE i * 1.5 END AS f FROM t"
+
+      opts = [spill: tmp, "adbc.sqlite.query.batch_rows": 2]
+
+      assert %Adbc.Result{data: %Adbc.SharedResult{num_rows: 5} = shared} =
+               Connection.query!(conn, query, [], opts)
+
+      # the file is unlinked once created
+      assert File.ls!(tmp) == []
+      assert %{spilled_results: spilled, spilled_bytes: bytes} = Adbc.Nif.memory_stats()
+      assert spilled >= 1 and bytes > 0
+
+      assert %Adbc.Result{data: [{2, "row 2", nil}, {3, "row 3", 4.5}]} =
+               Adbc.SharedResult.to_result!(shared, offset: 1, length: 2, output: :rows_tuples)
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1, 2, 3, 4, 5]}, _, _]} =
+               Task.await(Task.async(fn -> Adbc.SharedResult.to_result!(shared) end))
+
+      assert {:error, %ArgumentError{message: message}} =
+               Connection.query(conn, query, [], spill: Path.join(tmp, "missing"))
+
+      assert message =~ "cannot create spill file"
+    end
+  end
+
+  describe "query with cache" do
+    test "returns the cached result until cleared", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      Connection.query!(conn, "CREATE TABLE cached (i INTEGER)")
+      Connection.query!(conn, "INSERT INTO cached VALUES (1), (2)")
+      query = "SELECT i FROM cached WHERE i > ?"
+
+      assert %Adbc.Result{data: [{1}, {2}]} =
+               Connection.query!(conn, query, [0], cache: 60_000, output: :rows_tuples)
+
+      assert %{cached_results: cached} = Adbc.Nif.memory_stats()
+      assert cached >= 1
+
+      Connection.query!(conn, "INSERT INTO cached VALUES (3)")
+
+      assert %Adbc.Result{data: [{1}, {2}]} =
+               Connection.query!(conn, query, [0], cache: 60_000, output: :rows_tuples)
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1, 2]}]} =
+               Connection.query!(conn, query, [0], cache: 60_000)
+
+      assert %Adbc.Result{data: [{2}, {3}]} =
+               Connection.query!(conn, query, [1], cache: 60_000, output: :rows_tuples)
+
+      assert %Adbc.Result{data: [{1}, {2}, {3}]} =
+               Connection.query!(conn, query, [0], output: :rows_tuples)
+
+      assert :ok = Adbc.clear_result_cache()
+
+      assert %Adbc.Result{data: [{1}, {2}, {3}]} =
+               Connection.query!(conn, query, [0], cache: 60_000, output: :rows_tuples)
+    end
+
+    test "validates the cache option", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert_raise ArgumentError, ~r":cache must be nil or a positive integer", fn ->
+        Connection.query(conn, "SELECT 1", [], cache: 0)
+      end
+    end
+
+    test "caches the results of the other entry points", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert [%Adbc.Result{data: [%Adbc.Column{data: [1]}]}] =
+               Connection.stream(conn, "SELECT 1 AS i", [], cache: 1000) |> Enum.to_list()
+
+      assert {:ok, [_ | _]} = Connection.query_encoded(conn, "SELECT 1 AS i", [], cache: 1000)
+
+      assert_raise ArgumentError, ~r":cache must be nil or a positive integer", fn ->
+        Connection.stream(conn, "SELECT 1", [], cache: :forever)
+      end
+
+      assert {:ok, %Adbc.Result{}} = Connection.query(conn, "SELECT 1")
+    end
+  end
+
+  describe "parallel columns" do
+    @wide "WITH RECURSIVE t(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM t WHERE x < 30000) " <>
+            "SELECT x AS a, x * 2 AS b, 'row ' || x AS c FROM t"
+
+    test "returns the same columns", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      opts = ["adbc.sqlite.query.batch_rows": 30_000]
+      expected = Connection.query!(conn, @wide, [], opts)
+
+      assert Connection.query!(conn, @wide, [], [parallel_columns: true] ++ opts) == expected
+
+      opts = [parallel_columns: true, output: :rows_tuples] ++ opts
+
+      assert %Adbc.Result{data: [{1, 2, "row 1"} | _] = rows} =
+               Connection.query!(conn, @wide, [], opts)
+
+      assert length(rows) == 30_000
+    end
+  end
+
+  describe "result limits" do
+    test "abort queries returning too many rows", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      opts = ["adbc.sqlite.query.batch_rows": 1]
+
+      assert {:error, %Adbc.Error{state: "54000", message: message}} =
+               Connection.query(conn, @three_rows, [], [max_rows: 2] ++ opts)
+
+      assert message =~ ":max_rows"
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1, 2, 3]}]} =
+               Connection.query!(conn, @three_rows, [], [max_rows: 3] ++ opts)
+    end
+
+    test "abort queries returning too many bytes", %{db: db} do
+      conn = start_supervised!({Connection, database: db, max_result_bytes: 8})
+
+      assert {:error, %Adbc.Error{state: "54000", message: message}} =
+               Connection.query(conn, @three_rows)
+
+      assert message =~ ":max_result_bytes"
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1]}]} =
+               Connection.query!(conn, "SELECT 1 AS num", [], max_result_bytes: nil)
+    end
+
+    test "apply to cached results", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      opts = ["adbc.sqlite.query.batch_rows": 1, cache: 60_000]
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [1, 2, 3]}]} =
+               Connection.query!(conn, @three_rows, [], opts)
+
+      assert {:error, %Adbc.Error{state: "54000"}} =
+               Connection.query(conn, @three_rows, [], [max_rows: 2] ++ opts)
+    end
+
+    test "are validated", %{db: db} do
+      assert_raise ArgumentError, ~r/:max_rows/, fn ->
+        Connection.start_link(database: db, max_rows: -1)
+      end
+
+      conn = start_supervised!({Connection, database: db})
+
+      assert_raise ArgumentError, ~r/:max_result_bytes/, fn ->
+        Connection.query(conn, "SELECT 1", [], max_result_bytes: "8")
+      end
+
+      assert %Adbc.Result{} = Connection.query!(conn, "SELECT 1")
+    end
+  end
+
+  describe "statement cache" do
+    test "reuses the statement of a query", %{db: db} do
+      conn = start_supervised!({Connection, database: db, statement_cache: 2})
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [124]}]} =
+               Connection.query!(conn, "SELECT 123 + ? AS num", [1])
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [125, 126]}]} =
+               Connection.query!(conn, "SELECT 123 + ? AS num", [Adbc.Column.i64([2, 3])])
+
+      assert %{entries: entries} = :sys.get_state(conn).statements
+      assert [{"SELECT 123 + ? AS num", []}] = Map.keys(entries)
+    end
+
+    test "reuses the statement of a query with trusted parameters", %{db: db} do
+      conn = start_supervised!({Connection, database: db, statement_cache: 2})
+      params = [Adbc.Column.i64([1, 2])]
+
+      for _ <- 1..2 do
+        assert %Adbc.Result{data: [%Adbc.Column{data: [124, 125]}]} =
+                 Connection.query!(conn, "SELECT 123 + ? AS num", params, trusted_params: true)
+      end
+
+      assert %{entries: entries} = :sys.get_state(conn).statements
+      assert [{"SELECT 123 + ? AS num", []}] = Map.keys(entries)
+    end
+
+    test "evicts the least recently used statement", %{db: db} do
+      conn = start_supervised!({Connection, database: db, statement_cache: 2})
+
+      for query <- ["SELECT 1", "SELECT 2", "SELECT 1", "SELECT 3"] do
+        Connection.query!(conn, query)
+      end
+
+      assert %{entries: entries} = :sys.get_state(conn).statements
+      assert entries |> Map.keys() |> Enum.sort() == [{"SELECT 1", []}, {"SELECT 3", []}]
+    end
+
+    test "evicts statements that fail", %{db: db} do
+      conn = start_supervised!({Connection, database: db, statement_cache: 2})
+      Connection.query!(conn, "CREATE TABLE cached (i INTEGER)")
+      Connection.query!(conn, "SELECT * FROM cached")
+      Connection.query!(conn, "DROP TABLE cached")
+
+      assert {:error, %Adbc.Error{}} = Connection.query(conn, "SELECT * FROM cached")
+      assert %{entries: entries} = :sys.get_state(conn).statements
+      refute Map.has_key?(entries, {"SELECT * FROM cached", []})
+    end
+
+    test "is disabled by default", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      Connection.query!(conn, "SELECT 1")
+      assert :sys.get_state(conn).statements == nil
+    end
+  end
+
+  describe "priority" do
+    test "runs queued calls of higher priority first", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      parent = self()
+
+      blocker =
+        Task.async(fn ->
+          Connection.query_pointer(conn, "SELECT 1", fn _pointer, _num_rows ->
+            send(parent, :ready)
+            receive do: (:continue -> :ok)
+          end)
+        end)
+
+      assert_receive :ready
+
+      tasks =
+        for priority <- [:low, :normal, :high] do
+          task =
+            Task.async(fn ->
+              Connection.query!(conn, "SELECT 1 AS num", [], priority: priority)
+              send(parent, {:done, priority})
+            end)
+
+          wait_until_queued(conn, priority)
+          task
+        end
+
+      send(blocker.pid, :continue)
+      Task.await_many([blocker | tasks])
+
+      assert_received {:done, first}
+      assert_received {:done, second}
+      assert_received {:done, third}
+      assert [first, second, third] == [:high, :normal, :low]
+    end
+
+    test "errors when the queue of a priority is full", %{db: db} do
+      conn = start_supervised!({Connection, database: db, queue_limits: [low: 0]})
+
+      assert {:error, %Adbc.Error{} = error} =
+               Connection.query(conn, "SELECT 1", [], priority: :low)
+
+      assert Exception.message(error) =~ "the queue of :low priority calls"
+      assert %Adbc.Result{} = Connection.query!(conn, "SELECT 1", [], priority: :high)
+    end
+
+    test "is validated", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert_raise ArgumentError, ~r/:priority must be one of/, fn ->
+        Connection.query(conn, "SELECT 1", [], priority: :urgent)
+      end
+
+      assert_raise ArgumentError, ~r/:queue_limits/, fn ->
+        Connection.start_link(database: db, queue_limits: [urgent: 1])
+      end
+    end
+
+    defp wait_until_queued(conn, priority) do
+      if :queue.is_empty(:sys.get_state(conn).queues[priority]) do
+        Process.sleep(10)
+        wait_until_queued(conn, priority)
+      end
+    end
+  end
+
+  describe "query_pointer" do
+    test "select", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert {:ok, :from_pointer} =
+               Connection.query_pointer(conn, "SELECT 123 as num", fn
+                 pointer, nil when is_integer(pointer) ->
+                   :from_pointer
+               end)
+    end
+
+    test "prepared query", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      {:ok, ref} = Connection.prepare(conn, "SELECT 123 + ? as num")
+
+      assert {:ok, :from_pointer} =
+               Connection.query_pointer(conn, ref, [456], fn
+                 pointer, nil when is_integer(pointer) ->
+                   :from_pointer
+               end)
+    end
+  end
+
+  describe "stream handoff" do
+    test "unlocks the connection once the owner exits", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      owner =
+        spawn(fn ->
+          {:ok, _, _stream_ref, _} = GenServer.call(conn, {:stream, stream_command(), :normal})
+          receive do: (:exit -> :ok)
+        end)
+
+      wait_until_streaming(conn)
+      send(owner, :exit)
+      assert {:ok, %Adbc.Result{}} = Connection.query(conn, "SELECT 2")
+    end
+
+    test "unlocks the connection once the owner drops the stream", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+      parent = self()
+
+      owner =
+        spawn(fn ->
+          open_and_drop_stream(conn)
+          :erlang.garbage_collect()
+          send(parent, :dropped)
+          receive do: (:exit -> :ok)
+        end)
+
+      assert_receive :dropped
+      # the connection also held the reply in its heap
+      :erlang.garbage_collect(conn)
+
+      task = Task.async(fn -> Connection.query(conn, "SELECT 2") end)
+      assert {:ok, %Adbc.Result{}} = Task.await(task, 1000)
+      send(owner, :exit)
+    end
+
+    defp stream_command, do: {:query, "SELECT 1", [], []}
+
+    defp open_and_drop_stream(conn) do
+      {:ok, _, _stream_ref, _} = GenServer.call(conn, {:stream, stream_command(), :normal})
+      :ok
+    end
+
+    defp wait_until_streaming(conn) do
+      case :sys.get_state(conn).lock do
+        {:streaming, _} -> :ok
+        _ -> wait_until_streaming(conn)
+      end
+    end
+  end
+
+  describe "query_export" do
+    test "unlocks the connection before calling the function", %{db: db} do
+      conn = start_supervised!({Connection, database: db})
+
+      assert {:ok, {:from_pointer, %Adbc.Result{}}} =
+               Connection.query_export(conn, "SELECT 123 as num", fn
+                 pointer, nil when is_integer(pointer) ->
+                   {:from_pointer, Connection.query!(conn, "SELECT 456 as num")}
                end)
     end
   end
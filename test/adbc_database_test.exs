@@ -21,6 +21,26 @@ defmodule Adbc.DatabaseTest do
       assert Process.alive?(pid)
     end
 
+    test "accepts the entrypoint of the driver" do
+      assert {:ok, pid} = Database.start_link(driver: :sqlite, entrypoint: "AdbcDriverInit")
+      assert {:ok, conn} = Adbc.Connection.start_link(database: pid)
+      assert {:ok, _} = Adbc.Connection.query(conn, "SELECT 1")
+    end
+
+    test "errors with an unknown entrypoint" do
+      assert {:error, %Adbc.Error{}} =
+               Database.start_link(driver: :sqlite, entrypoint: "who_knows")
+    end
+
+    test "starts a preloaded driver" do
+      assert :ok = Database.preload(:sqlite)
+      assert {:ok, _} = Database.start_link(driver: :sqlite)
+    end
+
+    test "errors when preloading an unknown entrypoint" do
+      assert {:error, %ArgumentError{}} = Database.preload(:sqlite, entrypoint: "who_knows")
+    end
+
     test "errors with invalid driver" do
       assert {:error, %ArgumentError{} = error} = Database.start_link(driver: :who_knows)
       assert Exception.message(error) =~ "unknown driver :who_knows"
@@ -32,6 +52,17 @@ defmodule Adbc.DatabaseTest do
 
       assert Exception.message(error) == "[SQLite] Unknown database option who_knows=123"
     end
+
+    test "accepts scheduler" do
+      assert {:ok, _} = Database.start_link(driver: :sqlite, scheduler: :normal)
+      assert {:ok, _} = Database.start_link(driver: :sqlite, scheduler: :dirty_io)
+    end
+
+    test "errors with invalid scheduler" do
+      assert_raise ArgumentError, ~r/:scheduler must be one of/, fn ->
+        Database.start_link(driver: :sqlite, scheduler: :who_knows)
+      end
+    end
   end
 
   describe "get/set options" do
@@ -0,0 +1,106 @@
+defmodule Adbc.Pool.Test do
+  use ExUnit.Case
+  doctest Adbc.Pool
+
+  alias Adbc.Pool
+
+  setup do
+    db = start_supervised!({Adbc.Database, driver: :sqlite, uri: ":memory:"})
+    %{db: db}
+  end
+
+  describe "start_link" do
+    test "starts a process", %{db: db} do
+      assert {:ok, pid} = Pool.start_link(database: db, size: 2)
+      assert is_pid(pid)
+    end
+
+    test "opens connections in parallel", %{db: db} do
+      assert {:ok, pool} = Pool.start_link(database: db, size: 16)
+
+      results =
+        1..16
+        |> Task.async_stream(fn i -> Pool.query!(pool, "SELECT ? AS i", [i]) end)
+        |> Enum.map(fn {:ok, result} -> result end)
+
+      assert length(results) == 16
+    end
+
+    test "errors with invalid size", %{db: db} do
+      assert_raise ArgumentError, ":size must be a positive integer, got: 0", fn ->
+        Pool.start_link(database: db, size: 0)
+      end
+    end
+
+    test "errors with invalid option", %{db: db} do
+      Process.flag(:trap_exit, true)
+
+      assert {:error, %Adbc.Error{} = error} = Pool.start_link(database: db, who_knows: 123)
+      assert Exception.message(error) == "[SQLite] Unknown connection option who_knows=123"
+    end
+  end
+
+  describe "query" do
+    test "select", %{db: db} do
+      pool = start_supervised!({Pool, database: db, size: 2})
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{name: "num", data: [123]}]}} =
+               Pool.query(pool, "SELECT 123 as num")
+
+      assert %Adbc.Result{data: [%Adbc.Column{name: "num", data: [579]}]} =
+               Pool.query!(pool, "SELECT 123 + ? as num", [456])
+    end
+
+    test "fails on invalid query", %{db: db} do
+      pool = start_supervised!({Pool, database: db, size: 1})
+      assert {:error, %Adbc.Error{}} = Pool.query(pool, "NOT VALID SQL")
+      assert {:ok, %Adbc.Result{}} = Pool.query(pool, "SELECT 123 as num")
+    end
+
+    test "runs queries concurrently", %{db: db} do
+      pool = start_supervised!({Pool, database: db, size: 2})
+
+      results =
+        1..10
+        |> Enum.map(fn i -> Task.async(fn -> Pool.query!(pool, "SELECT #{i} as num") end) end)
+        |> Task.await_many()
+
+      assert Enum.map(results, fn %Adbc.Result{data: [%Adbc.Column{data: [i]}]} -> i end) ==
+               Enum.to_list(1..10)
+    end
+
+    test "replaces connections whose caller exited", %{db: db} do
+      pool = start_supervised!({Pool, database: db, size: 1})
+
+      {pid, ref} =
+        spawn_monitor(fn ->
+          GenServer.call(pool, {:checkout, :normal})
+          Process.sleep(:infinity)
+        end)
+
+      Process.sleep(50)
+      Process.exit(pid, :kill)
+      assert_receive {:DOWN, ^ref, _, _, _}
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{data: [123]}]}} =
+               Pool.query(pool, "SELECT 123 as num")
+    end
+
+    test "drops waiters which exited", %{db: db} do
+      pool = start_supervised!({Pool, database: db, size: 1})
+      {conn, _scheduler, checkout_ref} = GenServer.call(pool, {:checkout, :normal})
+
+      {pid, ref} = spawn_monitor(fn -> GenServer.call(pool, {:checkout, :normal}) end)
+      Process.sleep(50)
+      Process.exit(pid, :kill)
+      assert_receive {:DOWN, ^ref, _, _, _}
+
+      GenServer.cast(pool, {:checkin, checkout_ref})
+      assert %{available: [^conn], checked_out: checked_out} = :sys.get_state(pool)
+      assert checked_out == %{}
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{data: [123]}]}} =
+               Pool.query(pool, "SELECT 123 as num")
+    end
+  end
+end
@@ -0,0 +1,78 @@
+defmodule Adbc.Producer.Test do
+  use ExUnit.Case
+
+  alias Adbc.Connection
+  alias Adbc.Producer
+
+  setup do
+    db = start_supervised!({Adbc.Database, driver: :sqlite, uri: ":memory:"})
+    conn = start_supervised!({Connection, database: db})
+    Connection.query!(conn, "CREATE TABLE produced (id INTEGER)")
+    rows = Enum.map(1..10, &[&1])
+    {:ok, _} = Connection.execute_many(conn, "INSERT INTO produced VALUES (?)", rows)
+    %{conn: conn}
+  end
+
+  @query "SELECT id FROM produced ORDER BY id"
+
+  test "emits a result per batch", %{conn: conn} do
+    {:ok, producer} =
+      Producer.start_link(
+        connection: conn,
+        query: @query,
+        "adbc.sqlite.query.batch_rows": 3
+      )
+
+    results = Enum.to_list(GenStage.stream([{producer, max_demand: 2}]))
+    assert length(results) > 1
+
+    assert Enum.flat_map(results, fn %Adbc.Result{data: [%Adbc.Column{data: ids}]} -> ids end) ==
+             Enum.to_list(1..10)
+
+    refute Process.alive?(producer)
+    assert {:ok, _} = Connection.query(conn, "SELECT 1")
+  end
+
+  test "emits a row per event", %{conn: conn} do
+    {:ok, producer} =
+      Producer.start_link(
+        connection: conn,
+        query: @query,
+        params: [],
+        events: :rows,
+        output: :rows_tuples,
+        "adbc.sqlite.query.batch_rows": 4
+      )
+
+    rows = Enum.to_list(GenStage.stream([{producer, max_demand: 3}]))
+    assert rows == Enum.map(1..10, &{&1})
+  end
+
+  test "releases the connection when the consumer cancels", %{conn: conn} do
+    Process.flag(:trap_exit, true)
+
+    {:ok, producer} =
+      Producer.start_link(
+        connection: conn,
+        query: @query,
+        events: :rows,
+        "adbc.sqlite.query.batch_rows": 1
+      )
+
+    assert [%{"id" => 1}, %{"id" => 2}] =
+             Enum.take(GenStage.stream([{producer, max_demand: 1}]), 2)
+
+    assert_receive {:EXIT, ^producer, :normal}
+    assert {:ok, _} = Connection.query(conn, "SELECT 1")
+  end
+
+  test "validates its options", %{conn: conn} do
+    assert_raise ArgumentError, ":events must be :batches or :rows, got: :columns", fn ->
+      Producer.init(connection: conn, query: @query, events: :columns)
+    end
+
+    assert_raise ArgumentError, ~r/:output must be :rows_maps or :rows_tuples/, fn ->
+      Producer.init(connection: conn, query: @query, events: :rows, output: :columns)
+    end
+  end
+end
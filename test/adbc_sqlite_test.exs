@@ -268,4 +268,295 @@ defmodule Adbc.SQLite.Test do
     assert abs(r1 - 1.1) < 1.0e-6
     assert abs(r3 - 3.3) < 1.0e-6
   end
+
+  test "insert many rows with columns", %{db: _, conn: conn} do
+    assert {:ok, _} =
+             Connection.query(conn, "INSERT INTO test (i1, t1) VALUES(?, ?)", [
+               Adbc.Column.i64([1, 2, 3]),
+               Adbc.Column.string(["a", "b", nil], nullable: true)
+             ])
+
+    assert %{"i1" => [1, 2, 3], "t1" => ["a", "b", nil]} =
+             Connection.query!(conn, "SELECT i1, t1 FROM test ORDER BY i1")
+             |> Adbc.Result.to_map()
+  end
+
+  test "insert many rows as lists of parameters", %{db: _, conn: conn} do
+    assert {:ok, _} =
+             Connection.query(conn, "INSERT INTO test (i1, t1, r1) VALUES(?, ?, ?)", [
+               [1, "a", 1.5],
+               [2, nil, 2],
+               [3, "c", nil]
+             ])
+
+    assert %{"i1" => [1, 2, 3], "t1" => ["a", nil, "c"], "r1" => [1.5, 2.0, nil]} =
+             Connection.query!(conn, "SELECT i1, t1, r1 FROM test ORDER BY i1")
+             |> Adbc.Result.to_map()
+  end
+
+  test "insert many rows returns errors for mismatched rows", %{db: _, conn: conn} do
+    assert {:error, %ArgumentError{message: "all parameters must have the same number" <> _}} =
+             Connection.query(conn, "INSERT INTO test (i1, t1) VALUES(?, ?)", [
+               Adbc.Column.i64([1, 2, 3]),
+               Adbc.Column.string(["a"])
+             ])
+
+    assert {:error, %ArgumentError{message: "all rows of parameters must have" <> _}} =
+             Connection.query(conn, "INSERT INTO test (i1, t1) VALUES(?, ?)", [[1, "a"], [2]])
+
+    assert {:error, %ArgumentError{message: "parameter 1 has values of different types" <> _}} =
+             Connection.query(conn, "INSERT INTO test (i1, t1) VALUES(?, ?)", [
+               [1, "a"],
+               ["b", "c"]
+             ])
+  end
+
+  test "streams large binary values in chunks", %{db: _, conn: conn} do
+    Connection.query!(conn, "CREATE TABLE blobs (id INTEGER PRIMARY KEY, data BLOB)")
+
+    Connection.query!(conn, """
+    INSERT INTO blobs VALUES (1, randomblob(10000)), (2, randomblob(8192)), (3, NULL)
+    """)
+
+    %Adbc.Result{data: [{value}]} =
+      Connection.query!(conn, "SELECT data FROM blobs WHERE id = 1", [], output: :rows_tuples)
+
+    chunks =
+      conn
+      |> Connection.blob_stream("blobs", "data", "id = ?", [1], chunk_size: 4096)
+      |> Enum.to_list()
+
+    assert Enum.map(chunks, &byte_size/1) == [4096, 4096, 1808]
+    assert IO.iodata_to_binary(chunks) == value
+
+    stream = Connection.blob_stream(conn, "blobs", "data", "id = 2", [], chunk_size: 4096)
+    assert [_, _] = Enum.to_list(stream)
+
+    assert [] = Enum.to_list(Connection.blob_stream(conn, "blobs", "data", "id = 3"))
+    assert [] = Enum.to_list(Connection.blob_stream(conn, "blobs", "data", "id = 4"))
+
+    assert_raise ArgumentError, ~r/expected where to match a single row of blobs/, fn ->
+      Enum.to_list(Connection.blob_stream(conn, "blobs", "data", "id < 3"))
+    end
+  end
+
+  describe "parallel_scan" do
+    test "merges the rowid ranges scanned by each connection" do
+      path = Path.join(System.tmp_dir!(), "adbc_scan_#{System.unique_integer([:positive])}.db")
+      on_exit(fn -> File.rm(path) end)
+
+      db = start_supervised!({Adbc.Database, driver: :sqlite, uri: path})
+      conns = for i <- 1..3, do: start_supervised!({Connection, database: db}, id: {:conn, i})
+
+      assert {:error, %Adbc.Error{}} = Connection.parallel_scan(conns, "missing")
+
+      Connection.query!(hd(conns), "CREATE TABLE scanned (id INTEGER)")
+      assert {:ok, %Adbc.Result{}} = Connection.parallel_scan(conns, "scanned")
+
+      rows = Enum.map(1..10, &[&1])
+      assert {:ok, _} = Connection.execute_many(hd(conns), "INSERT INTO scanned VALUES (?)", rows)
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{name: "id", data: ids}]}} =
+               Connection.parallel_scan(conns, "scanned")
+
+      assert ids == Enum.to_list(1..10)
+
+      assert {:ok, %Adbc.Result{data: rows}} =
+               Connection.parallel_scan(conns, "scanned", ordered: false, output: :rows_tuples)
+
+      assert Enum.sort(rows) == Enum.map(1..10, &{&1})
+
+      # SQLite reports no statistics, so all the connections are used
+      assert {:error, %Adbc.Error{}} = Connection.get_statistics(hd(conns))
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{data: ids}]}} =
+               Connection.parallel_scan(conns, "scanned", min_range_rows: 1)
+
+      assert ids == Enum.to_list(1..10)
+    end
+  end
+
+  describe "ingest" do
+    test "ingests batches from a stream", %{db: _, conn: conn} do
+      batches =
+        Stream.map(1..3, fn i ->
+          [
+            Adbc.Column.i64([i, i + 10], name: "id"),
+            Adbc.Column.string(["a#{i}", nil], name: "name", nullable: true)
+          ]
+        end)
+
+      assert {:ok, 6} = Connection.ingest(conn, "ingested", batches)
+
+      assert %{"id" => [1, 2, 3, 11, 12, 13], "name" => ["a1", "a2", "a3", nil, nil, nil]} =
+               Connection.query!(conn, "SELECT * FROM ingested ORDER BY id")
+               |> Adbc.Result.to_map()
+
+      batches = [[Adbc.Column.i64([4], name: "id"), Adbc.Column.string(["b"], name: "name")]]
+      assert {:ok, 1} = Connection.ingest(conn, "ingested", batches, mode: :append)
+      assert {:error, %Adbc.Error{}} = Connection.ingest(conn, "ingested", batches)
+    end
+
+    test "converts batches ahead of the driver", %{db: _, conn: conn} do
+      batches = Stream.map(1..10, fn i -> [Adbc.Column.i64([i], name: "id")] end)
+
+      for {pending, mode} <- [{1, :create}, {4, :append}, {20, :append}] do
+        opts = [mode: mode, pending_batches: pending]
+        assert {:ok, 10} = Connection.ingest(conn, "ingested", batches, opts)
+      end
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [30]}]} =
+               Connection.query!(conn, "SELECT COUNT(*) FROM ingested")
+
+      refute_received {:adbc_ingest_next, _}
+    end
+
+    test "upserts batches through a staging table", %{db: _, conn: conn} do
+      Connection.query!(conn, "CREATE TABLE upserted (id INTEGER PRIMARY KEY, name TEXT)")
+      Connection.query!(conn, "INSERT INTO upserted VALUES (1, 'a'), (2, 'b')")
+
+      batches = [
+        [Adbc.Column.i64([2, 3], name: "id"), Adbc.Column.string(["x", "y"], name: "name")]
+      ]
+
+      opts = [mode: :upsert, conflict_keys: ["id"]]
+      assert {:ok, 2} = Connection.ingest(conn, "upserted", batches, opts)
+
+      assert %Adbc.Result{data: [{1, "a"}, {2, "x"}, {3, "y"}]} =
+               Connection.query!(conn, "SELECT * FROM upserted ORDER BY id", [],
+                 output: :rows_tuples
+               )
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: []}]} =
+               Connection.query!(
+                 conn,
+                 "SELECT name FROM sqlite_temp_master WHERE name LIKE 'adbc_upsert_%'"
+               )
+
+      assert_raise ArgumentError, ~r/conflict_keys/, fn ->
+        Connection.ingest(conn, "upserted", batches, mode: :upsert)
+      end
+    end
+
+    @tag :tmp_dir
+    test "copies snapshots into new in-memory databases", %{conn: conn, tmp_dir: tmp_dir} do
+      Connection.query!(conn, "CREATE TABLE reference (id INTEGER PRIMARY KEY, name TEXT)")
+      Connection.query!(conn, "CREATE INDEX reference_name ON reference (name)")
+      Connection.query!(conn, "INSERT INTO reference VALUES (1, 'a'), (2, 'b')")
+
+      path = Path.join(tmp_dir, "reference.db")
+      assert :ok = Connection.snapshot(conn, path)
+      assert {:error, %Adbc.Error{}} = Connection.snapshot(conn, path)
+
+      db =
+        start_supervised!({Adbc.Database, driver: :sqlite, uri: ":memory:", snapshot: path},
+          id: :snapshot
+        )
+
+      first = start_supervised!({Connection, database: db}, id: :first)
+      second = start_supervised!({Connection, database: db}, id: :second)
+      Connection.query!(first, "DELETE FROM reference WHERE id = 1")
+
+      query = "SELECT name FROM reference ORDER BY id"
+      assert %Adbc.Result{data: [%Adbc.Column{data: ["b"]}]} = Connection.query!(first, query)
+      assert %Adbc.Result{data: [%Adbc.Column{data: ["a", "b"]}]} = Connection.query!(second, query)
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: ["reference_name"]}]} =
+               Connection.query!(second, "SELECT name FROM sqlite_master WHERE type = 'index'")
+    end
+
+    test "sets pragmas for the duration of the ingest", %{db: _, conn: conn} do
+      assert %Adbc.Result{data: [{synchronous}]} =
+               Connection.query!(conn, "PRAGMA synchronous", [], output: :rows_tuples)
+
+      batches = [[Adbc.Column.i64([1, 2], name: "id")]]
+      opts = [pragmas: [synchronous: "OFF"]]
+      assert {:ok, 2} = Connection.ingest(conn, "ingested", batches, opts)
+
+      assert %Adbc.Result{data: [{^synchronous}]} =
+               Connection.query!(conn, "PRAGMA synchronous", [], output: :rows_tuples)
+    end
+
+    test "ingests memory-mapped Arrow IPC files", %{db: _, conn: conn} do
+      for {file, mode} <- [{"people.arrow", :create}, {"people.arrows", :append}] do
+        path = Path.join([__DIR__, "fixtures", file])
+        assert {:ok, stream_ref} = Adbc.open_arrow_file(path)
+        assert %{mapped_files: mapped} = Adbc.Nif.memory_stats()
+        assert mapped >= 1
+        assert {:ok, 3} = Connection.ingest(conn, "people", stream_ref, mode: mode)
+      end
+
+      query = "SELECT * FROM people ORDER BY id"
+      assert %Adbc.Result{data: rows} = Connection.query!(conn, query, [], output: :rows_tuples)
+
+      assert rows == [
+               {1, "alice", 1.5},
+               {1, "alice", 1.5},
+               {2, nil, nil},
+               {2, nil, nil},
+               {3, "carol", 3.25},
+               {3, "carol", 3.25}
+             ]
+
+      assert {:error, %ArgumentError{message: "cannot open " <> _}} =
+               Adbc.open_arrow_file(Path.join([__DIR__, "fixtures", "missing.arrow"]))
+
+      assert {:error, %ArgumentError{message: "truncated Arrow IPC message" <> _}} =
+               Adbc.open_arrow_file(__ENV__.file)
+    end
+
+    test "registers temporary tables to join against", %{db: _, conn: conn} do
+      Connection.query!(conn, "CREATE TABLE orders (user_id INTEGER, total REAL)")
+      Connection.query!(conn, "INSERT INTO orders VALUES (1, 10.0), (2, 5.0), (1, 2.5)")
+
+      columns = [
+        Adbc.Column.i64([1, 2], name: "id"),
+        Adbc.Column.string(["a", "b"], name: "name")
+      ]
+
+      assert {:ok, 2} = Connection.register_table(conn, "users", columns)
+
+      query =
+        "SELECT name, SUM(total) FROM orders JOIN users ON users.id = orders.user_id " <>
+          "GROUP BY name ORDER BY name"
+
+      assert %Adbc.Result{data: [{"a", 12.5}, {"b", 5.0}]} =
+               Connection.query!(conn, query, [], output: :rows_tuples)
+
+      assert %Adbc.Result{data: [{"temp"}]} =
+               Connection.query!(
+                 conn,
+                 "SELECT schema FROM pragma_table_list WHERE name = 'users'",
+                 [],
+                 output: :rows_tuples
+               )
+
+      # registering again replaces the table
+      assert {:ok, 1} =
+               Connection.register_table(conn, "users", [Adbc.Column.i64([2], name: "id")])
+
+      assert %Adbc.Result{data: [{2}]} =
+               Connection.query!(conn, "SELECT id FROM users", [], output: :rows_tuples)
+
+      path = Path.join([__DIR__, "fixtures", "people.arrow"])
+      assert {:ok, stream_ref} = Adbc.open_arrow_file(path)
+      assert {:ok, 3} = Connection.register_table(conn, "people", stream_ref)
+    end
+
+    test "returns errors for invalid batches", %{db: _, conn: conn} do
+      assert {:error, %ArgumentError{message: "expected at least one batch to ingest"}} =
+               Connection.ingest(conn, "ingested", [])
+
+      batches = [
+        [Adbc.Column.i64([1], name: "id")],
+        [Adbc.Column.string(["a"], name: "id")]
+      ]
+
+      assert {:error, %ArgumentError{message: "all batches must have the same schema"}} =
+               Connection.ingest(conn, "ingested", batches)
+
+      # the connection is unlocked afterwards
+      assert {:ok, _} = Connection.query(conn, "SELECT 1")
+    end
+  end
 end
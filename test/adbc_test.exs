@@ -17,6 +17,42 @@ defmodule AdbcTest do
     end
   end
 
+  describe "worker_pool_stats" do
+    test "counts the jobs of the worker pool" do
+      db = start_supervised!({Database, driver: :sqlite, uri: ":memory:"})
+      conn = start_supervised!({Connection, database: db})
+      %{blocking_submitted: before} = Adbc.worker_pool_stats()
+
+      assert {:ok, _} = Connection.query(conn, "SELECT 1", [], prefetch: 2)
+
+      assert %{threads: threads, queue_depths: depths, blocking_submitted: submitted} =
+               stats = Adbc.worker_pool_stats()
+
+      assert threads >= 1 and length(depths) == threads
+      assert submitted > before
+      assert stats.blocking_busy_threads <= stats.blocking_threads
+      assert stats.utilization >= 0.0 and stats.utilization <= 1.0
+    end
+  end
+
+  describe "call_stats" do
+    test "counts the calls of the hot paths" do
+      db = start_supervised!({Database, driver: :sqlite, uri: ":memory:"})
+      conn = start_supervised!({Connection, database: db})
+      %{execute_query: %{calls: before}} = Adbc.call_stats()
+
+      assert {:ok, _} = Connection.query(conn, "SELECT ?", [1])
+
+      assert %{execute_query: execute_query, stream_next: stream_next, bind: bind} =
+               Adbc.call_stats()
+
+      assert execute_query.calls > before
+      assert stream_next.calls > 0 and bind.calls > 0
+      assert [{1, _} | _] = execute_query.histogram
+      assert {:infinity, _} = List.last(execute_query.histogram)
+    end
+  end
+
   describe "postgresql smoke tests" do
     @describetag :postgresql
 
@@ -158,6 +194,73 @@ defmodule AdbcTest do
       assert Enum.count(generate_series) == 3_506_641
     end
 
+    test "binds lists as array parameters", %{conn: conn} do
+      Connection.query!(conn, "CREATE TEMPORARY TABLE arrays (id bigint, name text)")
+      insert = "INSERT INTO arrays SELECT i, 'row ' || i FROM generate_series(1, 10) i"
+      Connection.query!(conn, insert)
+
+      query = "SELECT count(*) AS n FROM arrays WHERE id = ANY($1::bigint[])"
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [3]}]} =
+               Connection.query!(conn, query, [{:array, [2, 4, 6]}])
+
+      Connection.query!(
+        conn,
+        "UPDATE arrays SET name = u.name FROM unnest($1::bigint[], $2::text[]) AS u(id, name) " <>
+          "WHERE arrays.id = u.id",
+        [{:array, [1, 2]}, {:array, [~s(a "quoted" one), nil]}]
+      )
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: [~s(a "quoted" one), nil]}]} =
+               Connection.query!(conn, "SELECT name FROM arrays WHERE id <= 2 ORDER BY id")
+    end
+
+    test "scans tables in parallel by ctid ranges", %{db: db, conn: conn} do
+      Connection.query!(conn, "DROP TABLE IF EXISTS adbc_ctid_scan")
+      create = "CREATE TABLE adbc_ctid_scan AS SELECT i FROM generate_series(1, 50000) i"
+      Connection.query!(conn, create)
+      conns = for _ <- 1..4, do: start_supervised!({Connection, database: db}, id: make_ref())
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{name: "i", data: data}]}} =
+               Connection.parallel_scan(conns, "adbc_ctid_scan", partition: :ctid)
+
+      assert Enum.sort(data) == Enum.to_list(1..50000)
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{data: [1]}]}} =
+               Connection.query(hd(conns), "SELECT 1")
+
+      Connection.query!(conn, "DROP TABLE adbc_ctid_scan")
+    end
+
+    test "gets the statistics of tables", %{conn: conn} do
+      Connection.query!(conn, "DROP TABLE IF EXISTS adbc_statistics")
+      Connection.query!(
+        conn,
+        "CREATE TABLE adbc_statistics AS SELECT i, i % 10 AS d FROM generate_series(1, 1000) i"
+      )
+      Connection.query!(conn, "ANALYZE adbc_statistics")
+
+      assert {:ok, statistics} = Connection.get_statistics(conn, table_name: "adbc_statistics")
+
+      rows = for %{column_name: nil, name: :row_count, value: rows} <- statistics, do: rows
+      assert Enum.map(rows, &trunc/1) == [1000]
+
+      assert [%{table_name: "adbc_statistics", approximate: true} | _] =
+               for(%{column_name: "d", name: :distinct_count} = s <- statistics, do: s)
+
+      assert {:ok, %Adbc.Result{}} = Connection.get_statistic_names(conn)
+
+      assert {:ok, %Adbc.Result{data: [%Adbc.Column{name: "i", data: data}]}} =
+               Connection.parallel_scan([conn], "adbc_statistics",
+                 partition: :ctid,
+                 columns: "i",
+                 min_range_rows: 100_000
+               )
+
+      assert Enum.sort(data) == Enum.to_list(1..1000)
+      Connection.query!(conn, "DROP TABLE adbc_statistics")
+    end
+
     test "select with temporal types", %{conn: conn} do
       query = """
       select
@@ -216,11 +319,171 @@ defmodule AdbcTest do
                ]
              } = Connection.query!(conn, query)
     end
+
+    test "select timestamps with a time zone as datetimes", %{conn: conn} do
+      query = """
+      select
+        '2023-03-01T10:23:45 PST'::timestamptz as datetime_tz,
+        '2023-03-01T10:23:45'::timestamp as datetime
+      """
+
+      assert %Adbc.Result{
+               data: [
+                 %Adbc.Column{
+                   name: "datetime_tz",
+                   type: {:timestamp, :microseconds, "UTC"},
+                   data: [~U[2023-03-01 18:23:45.000000Z]]
+                 },
+                 %Adbc.Column{name: "datetime", data: [~N[2023-03-01 10:23:45.000000]]}
+               ]
+             } = Connection.query!(conn, query, [], datetime_columns: true)
+    end
+
+    test "select with temporal types before the epoch", %{conn: conn} do
+      query = """
+      select
+        '1969-07-20T20:17:40.5'::timestamp as datetime,
+        '1901-12-13'::date as date
+      """
+
+      assert %Adbc.Result{
+               data: [
+                 %Adbc.Column{name: "datetime", data: [~N[1969-07-20 20:17:40.500000]]},
+                 %Adbc.Column{name: "date", data: [~D[1901-12-13]]}
+               ]
+             } = Connection.query!(conn, query)
+    end
   end
 
   describe "duckdb smoke tests" do
     test "starts a database" do
       assert {:ok, _} = Database.start_link(driver: :duckdb)
     end
+
+    test "decodes bit-packed booleans" do
+      db = start_supervised!({Database, driver: :duckdb})
+      conn = start_supervised!({Connection, database: db})
+      query = "SELECT i % 3 = 0 AS b FROM range(200) t(i)"
+
+      assert %Adbc.Result{data: [%Adbc.Column{type: :boolean, data: data}]} =
+               Connection.query!(conn, query)
+
+      assert data == Enum.map(0..199, &(rem(&1, 3) == 0))
+
+      query = "SELECT CASE WHEN i % 2 = 0 THEN i % 3 = 0 END AS b FROM range(200) t(i)"
+
+      assert %Adbc.Result{data: [%Adbc.Column{type: :boolean, data: data}]} =
+               Connection.query!(conn, query)
+
+      assert data == Enum.map(0..199, &if(rem(&1, 2) == 0, do: rem(&1, 3) == 0))
+    end
+
+    test "decodes unions" do
+      db = start_supervised!({Database, driver: :duckdb})
+      conn = start_supervised!({Connection, database: db})
+
+      query = """
+      SELECT CASE WHEN i % 3 = 0 THEN union_value(num := i)
+                  WHEN i % 3 = 1 THEN union_value(str := i::VARCHAR)
+                  ELSE NULL END::UNION(num INTEGER, str VARCHAR) AS u
+      FROM range(6) t(i)
+      """
+
+      assert %Adbc.Result{data: [%Adbc.Column{data: data}]} = Connection.query!(conn, query)
+
+      assert [
+               %{"num" => [0]},
+               %{"str" => ["1"]},
+               %{_ => [nil]},
+               %{"num" => [3]},
+               %{"str" => ["4"]},
+               %{_ => [nil]}
+             ] = data
+    end
+
+    test "round trips built columns across batches" do
+      db = start_supervised!({Database, driver: :duckdb})
+      conn = start_supervised!({Connection, database: db})
+
+      batch = fn id, values ->
+        [
+          Adbc.Column.i64(id, name: "id"),
+          Adbc.Column.u8(Enum.at(values, 0), name: "u8", nullable: true),
+          Adbc.Column.i16(Enum.at(values, 1), name: "i16", nullable: true),
+          Adbc.Column.f32(Enum.at(values, 2), name: "f32", nullable: true),
+          Adbc.Column.string(Enum.at(values, 3), name: "string", nullable: true),
+          Adbc.Column.binary(Enum.at(values, 4), name: "binary", nullable: true),
+          Adbc.Column.boolean(Enum.at(values, 5), name: "boolean", nullable: true),
+          Adbc.Column.date32(Enum.at(values, 6), name: "date32", nullable: true),
+          Adbc.Column.time(Enum.at(values, 7), :microseconds, name: "time", nullable: true)
+        ]
+      end
+
+      batches = [
+        batch.([1, 2], [
+          [255, nil],
+          [nil, -32768],
+          [1.5, nil],
+          [nil, "b"],
+          ["a", nil],
+          [nil, true],
+          [~D[2023-03-01], nil],
+          [nil, ~T[10:23:45.123456]]
+        ]),
+        batch.([3, 4, 5], [
+          [nil, nil, 0],
+          [1, nil, 32767],
+          [nil, -0.25, nil],
+          ["c", "", nil],
+          [nil, <<0, 255>>, <<>>],
+          [false, nil, nil],
+          [nil, nil, ~D[1970-01-01]],
+          [~T[00:00:00.000000], nil, nil]
+        ])
+      ]
+
+      assert {:ok, 5} = Connection.ingest(conn, "built", batches)
+
+      assert %Adbc.Result{data: columns} =
+               Connection.query!(conn, "SELECT * FROM built ORDER BY id")
+
+      expected = Enum.zip_with(batches, &Enum.concat(Enum.map(&1, fn column -> column.data end)))
+
+      assert Enum.map(columns, & &1.type) == [
+               :i64,
+               :u8,
+               :i16,
+               :f32,
+               :string,
+               :binary,
+               :boolean,
+               :date32,
+               {:time64, :microseconds}
+             ]
+
+      assert Enum.map(columns, &Adbc.Column.to_list/1) == expected
+    end
+
+    test "decodes fixed-size lists as binaries with vector columns" do
+      db = start_supervised!({Database, driver: :duckdb})
+      conn = start_supervised!({Connection, database: db})
+      query = "SELECT * FROM (VALUES ([1.5, 2.5]::FLOAT[2]), (NULL), ([3.5, 4.5]::FLOAT[2])) t(v)"
+
+      for zero_copy <- [false, true] do
+        assert %Adbc.Result{data: [%Adbc.Column{type: type, data: data}]} =
+                 Connection.query!(conn, query, [],
+                   vector_columns: true,
+                   zero_copy_binaries: zero_copy
+                 )
+
+        assert type == {:fixed_size_list, :f32, 2}
+
+        assert data == [
+                 <<1.5::float-32-native, 2.5::float-32-native>>,
+                 nil,
+                 <<3.5::float-32-native, 4.5::float-32-native>>
+               ]
+      end
+    end
   end
 end